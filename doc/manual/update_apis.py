@@ -12,6 +12,8 @@ apis = [
     ["src/ble/att_db_util.h", "BLE ATT Database", "attDb"],
     ["src/ble/att_server.h", "BLE ATT Server", "attServer"],
     ["src/ble/gatt_client.h", "BLE GATT Client", "gattClient"],
+    ["src/ble/le_connection_manager.h", "BLE Connection Manager", "leConnectionManager"],
+    ["src/ble/le_connection_parameter_manager.h", "BLE Connection Parameter Manager", "leConnectionParameterManager"],
     ["src/ble/le_device_db.h", "BLE Device Database", "leDeviceDb"],
     ["src/ble/sm.h", "BLE Security Manager", "sm"],
 
@@ -22,7 +24,9 @@ apis = [
     ["src/classic/hfp_hf.h","HFP Hands-Free","hfpHF"],
     ["src/classic/hfp_ag.h","HFP Audio Gateway","hfpAG"],
     ["src/classic/pan.h", "PAN", "pan"],
+    ["src/classic/pan_nap_bridge.h", "PAN NAP Bridge", "panNapBridge"],
     ["src/classic/rfcomm.h", "RFCOMM", "rfcomm"],
+    ["src/classic/gap_inquiry_manager.h", "GAP Inquiry Manager", "gapInquiryManager"],
     ["src/classic/sdp_client.h", "SDP Client", "sdpClient"],
     ["src/classic/sdp_client_rfcomm.h", "SDP RFCOMM Query", "sdpQueries"],
     ["src/classic/sdp_server.h", "SDP Server", "sdpSrv"],
@@ -32,6 +36,7 @@ apis = [
     ["src/btstack_chipset.h","BTstack Chipset","btMemory"],
     ["src/btstack_control.h","BTstack Hardware Control","btControl"],
     ["src/btstack_event.h","HCI Event Getter","btEvent"],
+    ["src/hci_cmd_encoder.h","HCI Command Encoder","hciCmdEncoder"],
     ["src/btstack_memory.h","BTstack Memory Management","btMemory"],
     ["src/btstack_linked_list.h","BTstack Linked List","btList"],
     ["src/btstack_run_loop.h", "Run Loop", "runLoop"],
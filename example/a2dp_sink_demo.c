@@ -494,6 +494,9 @@ static int media_processing_init(avdtp_media_codec_configuration_sbc_t configura
 static void media_processing_close(void){
     if (!media_initialized) return;
     media_initialized = 0;
+#ifdef DECODE_SBC
+    btstack_sbc_decoder_deinit(&state);
+#endif
 
 #ifdef STORE_SBC_TO_WAV_FILE                  
     wav_writer_close();
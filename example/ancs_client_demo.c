@@ -119,10 +119,17 @@ static void ancs_callback(uint8_t packet_type, uint16_t channel, uint8_t *packet
         case ANCS_SUBEVENT_CLIENT_DISCONNECTED:
             printf("ANCS Client: Disconnected\n");
             break;
-        case ANCS_SUBEVENT_CLIENT_NOTIFICATION:
-            attribute_name = ancs_client_attribute_name_for_id(ancs_subevent_client_notification_get_attribute_id(packet));
+        case ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK:
+            attribute_name = ancs_client_attribute_name_for_id(ancs_subevent_client_attribute_chunk_get_attribute_id(packet));
             if (!attribute_name) break;
-            printf("Notification: %s - %s\n", attribute_name, ancs_subevent_client_notification_get_text(packet));
+            // attribute values are delivered in chunks
+            if (ancs_subevent_client_attribute_chunk_get_offset(packet) == 0){
+                printf("Notification: %s - ", attribute_name);
+            }
+            printf("%.*s", ancs_subevent_client_attribute_chunk_get_value_length(packet), ancs_subevent_client_attribute_chunk_get_value(packet));
+            if (ancs_subevent_client_attribute_chunk_get_offset(packet) + ancs_subevent_client_attribute_chunk_get_value_length(packet) == ancs_subevent_client_attribute_chunk_get_attribute_length(packet)){
+                printf("\n");
+            }
             break;
         default:
             break;
@@ -68,6 +68,7 @@ static uint8_t       hsp_service_buffer[150];
 static const uint8_t rfcomm_channel_nr = 1;
 static const char    hsp_ag_service_name[] = "Audio Gateway Test";
 static uint16_t      sco_handle = 0;
+static hci_con_handle_t acl_handle = HCI_CON_HANDLE_INVALID;
 
 static char hs_cmd_buffer[100];
 
@@ -130,43 +131,43 @@ static void stdin_process(char c){
             break;
         case 'C':
             printf("Disconnect.\n");
-            hsp_ag_disconnect();
+            hsp_ag_disconnect(acl_handle);
             break;
         case 'a':
             printf("Establish audio connection\n");
-            hsp_ag_establish_audio_connection();
+            hsp_ag_establish_audio_connection(acl_handle);
             break;
         case 'A': 
             printf("Release audio connection\n");
-            hsp_ag_release_audio_connection();
+            hsp_ag_release_audio_connection(acl_handle);
             break;
         case 'm':
             printf("Setting microphone gain 8\n");
-            hsp_ag_set_microphone_gain(8);
+            hsp_ag_set_microphone_gain(acl_handle, 8);
             break;
         case 'M':
             printf("Setting microphone gain 15\n");
-            hsp_ag_set_microphone_gain(15);
+            hsp_ag_set_microphone_gain(acl_handle, 15);
             break;
         case 'o':
             printf("Setting speaker gain 0\n");
-            hsp_ag_set_speaker_gain(0);
+            hsp_ag_set_speaker_gain(acl_handle, 0);
             break;
         case 's':
             printf("Setting speaker gain 8\n");
-            hsp_ag_set_speaker_gain(8);
+            hsp_ag_set_speaker_gain(acl_handle, 8);
             break;
         case 'S':
             printf("Setting speaker gain 15\n");
-            hsp_ag_set_speaker_gain(15);
+            hsp_ag_set_speaker_gain(acl_handle, 15);
             break;
         case 'r':
             printf("Start ringing\n");
-            hsp_ag_start_ringing();
+            hsp_ag_start_ringing(acl_handle);
             break;
         case 't':
             printf("Stop ringing\n");
-            hsp_ag_stop_ringing();
+            hsp_ag_stop_ringing(acl_handle);
             break;
         default:
             show_usage();
@@ -202,10 +203,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * even
                                 printf("RFCOMM connection establishement failed with status %u\n", hsp_subevent_rfcomm_connection_complete_get_status(event));
                                 break;
                             } 
+                            acl_handle = hsp_subevent_rfcomm_connection_complete_get_acl_handle(event);
                             printf("RFCOMM connection established.\n");
 #ifndef HAVE_BTSTACK_STDIN
                             printf("Establish Audio connection to %s...\n", device_addr_string);
-                            hsp_ag_establish_audio_connection();
+                            hsp_ag_establish_audio_connection(acl_handle);
 #endif
                             break;
                         case HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE:
@@ -213,6 +215,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * even
                                 printf("RFCOMM disconnection failed with status %u.\n", hsp_subevent_rfcomm_disconnection_complete_get_status(event));
                             } else {
                                 printf("RFCOMM disconnected.\n");
+                                acl_handle = HCI_CON_HANDLE_INVALID;
                             }
                             break;
                         case HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE:
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "btstack_worker_posix.c"
+
+/*
+ *  btstack_worker_posix.c
+ *
+ *  Work is executed on a detached pthread. Completion is signalled via a pipe
+ *  that is registered as data source with the run loop.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "btstack_debug.h"
+#include "btstack_run_loop.h"
+#include "btstack_worker_posix.h"
+
+static btstack_data_source_t worker_data_source;
+static int worker_pipe[2];
+static int worker_initialized;
+static void (*worker_work)(void);
+static void (*worker_done)(void);
+
+static void * worker_thread(void * arg){
+    UNUSED(arg);
+    (*worker_work)();
+    // notify run loop
+    uint8_t done = 1;
+    if (write(worker_pipe[1], &done, 1) != 1){
+        log_error("worker: write to pipe failed");
+    }
+    return NULL;
+}
+
+static void worker_process(btstack_data_source_t *ds, btstack_data_source_callback_type_t callback_type){
+    UNUSED(callback_type);
+    uint8_t done;
+    if (read(ds->fd, &done, 1) != 1) return;
+    void (*callback)(void) = worker_done;
+    worker_work = NULL;
+    worker_done = NULL;
+    if (callback){
+        (*callback)();
+    }
+}
+
+static int worker_init(void){
+    if (worker_initialized) return 1;
+    if (pipe(worker_pipe) != 0) return 0;
+    btstack_run_loop_set_data_source_fd(&worker_data_source, worker_pipe[0]);
+    btstack_run_loop_set_data_source_handler(&worker_data_source, &worker_process);
+    btstack_run_loop_enable_data_source_callbacks(&worker_data_source, DATA_SOURCE_CALLBACK_READ);
+    btstack_run_loop_add_data_source(&worker_data_source);
+    worker_initialized = 1;
+    return 1;
+}
+
+void btstack_worker_posix_execute(void (*work)(void), void (*done)(void)){
+    if (worker_work){
+        log_error("worker: work already active");
+        return;
+    }
+    worker_work = work;
+    worker_done = done;
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    int started = 0;
+    if (worker_init()){
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        started = pthread_create(&thread, &attr, &worker_thread, NULL) == 0;
+        pthread_attr_destroy(&attr);
+    }
+    if (started) return;
+
+    // fallback: execute directly
+    log_error("worker: cannot start thread, execute on run loop thread");
+    worker_work = NULL;
+    worker_done = NULL;
+    (*work)();
+    (*done)();
+}
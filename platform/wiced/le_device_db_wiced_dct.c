@@ -205,6 +205,30 @@ void le_device_db_info(int device_index, int * addr_type, bd_addr_t addr, sm_key
     if (irk) memcpy(irk, entry.irk, 16);
 }
 
+int le_device_db_lookup_by_address(int addr_type, bd_addr_t addr){
+	le_device_nvm_t entry;
+	int i;
+	int device_index = 0;
+	for (i=0;i<NVM_NUM_LE_DEVICES;i++){
+		if (!le_device_db_entry_read(i, &entry)) continue;
+		if (entry.addr_type == addr_type && memcmp(entry.addr, addr, 6) == 0) return device_index;
+		device_index++;
+	}
+	return -1;
+}
+
+int le_device_db_lookup_by_irk(sm_key_t irk){
+	le_device_nvm_t entry;
+	int i;
+	int device_index = 0;
+	for (i=0;i<NVM_NUM_LE_DEVICES;i++){
+		if (!le_device_db_entry_read(i, &entry)) continue;
+		if (memcmp(entry.irk, irk, 16) == 0) return device_index;
+		device_index++;
+	}
+	return -1;
+}
+
 // free device
 void le_device_db_remove(int device_index){
 	int absolute_index = le_device_db_get_absolute_index_for_device_index(device_index);
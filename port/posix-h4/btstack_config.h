@@ -22,11 +22,14 @@
 #define ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS
 #define ENABLE_LE_DATA_CHANNELS
 #define ENABLE_LE_DATA_LENGTH_EXTENSION
+#define ENABLE_LE_EXTENDED_ADVERTISING
 #define ENABLE_ATT_DELAYED_READ_RESPONSE
+#define ENABLE_ATT_SERVER_WRITE_STREAM
 #define ENABLE_LOG_ERROR
 #define ENABLE_LOG_INFO 
 #define ENABLE_SCO_OVER_HCI
 #define ENABLE_SDP_DES_DUMP
+#define ENABLE_SDP_CLIENT_CACHE
 // #define ENABLE_EHCILL
 
 // BTstack configuration. buffers, sizes, ...
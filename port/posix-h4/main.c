@@ -51,6 +51,7 @@
 
 #include "btstack_config.h"
 
+#include "btstack_crypto.h"
 #include "btstack_debug.h"
 #include "btstack_event.h"
 #include "btstack_link_key_db_fs.h"
@@ -61,6 +62,7 @@
 #include "hci.h"
 #include "hci_dump.h"
 #include "btstack_stdin.h"
+#include "btstack_worker_posix.h"
 
 #include "btstack_chipset_bcm.h"
 #include "btstack_chipset_csr.h"
@@ -244,6 +246,9 @@ int main(int argc, const char * argv[]){
 	hci_init(transport, (void*) &config);
     hci_set_link_key_db(link_key_db);
 
+    // calculate LE Secure Connections DHKey on worker thread
+    btstack_crypto_ecc_p256_set_worker(&btstack_worker_posix_execute);
+
     // set BD_ADDR for CSR without Flash/unique address
     // bd_addr_t own_address = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
     // btstack_chipset_csr_set_bd_addr(own_address);
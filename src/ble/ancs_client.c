@@ -56,8 +56,39 @@
 #include "classic/sdp_util.h"
 #include "gap.h"
 
+#ifndef MAX_NR_ANCS_CLIENT_CONNECTIONS
+#define MAX_NR_ANCS_CLIENT_CONNECTIONS 1
+#endif
+
+// max number of attributes in Get Notification Attributes command
+#ifndef ANCS_CLIENT_MAX_NR_ATTRIBUTES
+#define ANCS_CLIENT_MAX_NR_ATTRIBUTES 8
+#endif
+
+// UIDs of received notifications waiting for Get Notification Attributes command
+#ifndef ANCS_CLIENT_NOTIFICATION_QUEUE_SIZE
+#define ANCS_CLIENT_NOTIFICATION_QUEUE_SIZE 8
+#endif
+
+// max size of attribute value in ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK, limited by HCI event size
+#ifndef ANCS_CLIENT_MAX_CHUNK_LEN
+#define ANCS_CLIENT_MAX_CHUNK_LEN 64
+#endif
+
+#if ANCS_CLIENT_MAX_CHUNK_LEN > 240
+#error "ANCS_CLIENT_MAX_CHUNK_LEN must not be larger than 240"
+#endif
+
+#define ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES 0
+#define ANCS_EVENT_ID_NOTIFICATION_REMOVED          2
+
+// command id + notification uid
+#define ANCS_RESPONSE_HEADER_LEN 5
+
 // ancs_client.h Start
 typedef enum ancs_chunk_parser_state {
+    W4_REQUEST,
+    W4_RESPONSE_HEADER,
     W4_ATTRIBUTE_ID,
     W4_ATTRIBUTE_LEN,
     W4_ATTRIBUTE_COMPLETE,
@@ -74,6 +105,38 @@ typedef enum {
     TC_W4_DISCONNECT
 } tc_state_t;
 
+typedef struct {
+    hci_con_handle_t con_handle;
+    tc_state_t state;
+
+    // discovery
+    uint8_t service_found;
+    uint8_t characteristics;
+    gatt_client_service_t service;
+    gatt_client_characteristic_t notification_source_characteristic;
+    gatt_client_characteristic_t control_point_characteristic;
+    gatt_client_characteristic_t data_source_characteristic;
+    gatt_client_notification_t notification_source_notification;
+    gatt_client_notification_t data_source_notification;
+
+    // notifications waiting for Get Notification Attributes command
+    uint32_t notification_queue[ANCS_CLIENT_NOTIFICATION_QUEUE_SIZE];
+    uint8_t  notification_queue_len;
+
+    // Get Notification Attributes command, needs to stay valid until write is complete
+    uint8_t  command[5 + 3 * ANCS_CLIENT_MAX_NR_ATTRIBUTES];
+
+    // Data Source parser
+    ancs_chunk_parser_state_t parser_state;
+    uint8_t  parser_buffer[ANCS_RESPONSE_HEADER_LEN];
+    uint8_t  parser_bytes_received;
+    uint8_t  attributes_remaining;
+    uint32_t notification_uid;
+    uint8_t  attribute_id;
+    uint16_t attribute_len;
+    uint16_t attribute_offset;
+} ancs_client_connection_t;
+
 static const char * ancs_attribute_names[] = { 
     "AppIdentifier",
     "IDTitle",
@@ -89,170 +152,261 @@ static const uint8_t ancs_notification_source_uuid[] = {0x9F,0xBF,0x12,0x0D,0x63
 static const uint8_t ancs_control_point_uuid[] =       {0x69,0xD1,0xD8,0xF3,0x45,0xE1,0x49,0xA8,0x98,0x21,0x9B,0xBD,0xFD,0xAA,0xD9,0xD9};
 static const uint8_t ancs_data_source_uuid[] =         {0x22,0xEA,0xC6,0xE9,0x24,0xD6,0x4B,0xB5,0xBE,0x44,0xB3,0x6A,0xCE,0x7C,0x7B,0xFB};
 
-static uint32_t ancs_notification_uid;
-static uint16_t gc_handle;
-static gatt_client_notification_t ancs_notification_source_notification;
-static gatt_client_notification_t ancs_data_source_notification;
-static int ancs_service_found;
-static gatt_client_service_t  ancs_service;
-static gatt_client_characteristic_t ancs_notification_source_characteristic;
-static gatt_client_characteristic_t ancs_control_point_characteristic;
-static gatt_client_characteristic_t ancs_data_source_characteristic;
-static int ancs_characteristcs;
-static tc_state_t tc_state = TC_IDLE;
-
-static ancs_chunk_parser_state_t chunk_parser_state;
-static uint8_t  ancs_notification_buffer[50];
-static uint16_t ancs_bytes_received;
-static uint16_t ancs_bytes_needed;
-static uint8_t  ancs_attribute_id;
-static uint16_t ancs_attribute_len;
+static const ancs_client_attribute_request_t ancs_default_attributes[] = {
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_APP_IDENTIFIER, 0},
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_TITLE,          0xffff},
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_SUBTITLE,       0xffff},
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_MESSAGE,        0xffff},
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_MESSAGE_SIZE,   0},
+    { ANCS_NOTIFICATION_ATTRIBUTE_ID_DATE,           0},
+};
+
+static const ancs_client_attribute_request_t * ancs_attributes = ancs_default_attributes;
+static uint8_t ancs_num_attributes = sizeof(ancs_default_attributes) / sizeof(ancs_client_attribute_request_t);
+
+static ancs_client_connection_t ancs_client_connections[MAX_NR_ANCS_CLIENT_CONNECTIONS];
 
 static btstack_packet_handler_t client_handler;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
+static void ancs_client_send_next_request(ancs_client_connection_t * connection);
+static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
 void ancs_client_register_callback(btstack_packet_handler_t handler){
     client_handler = handler; 
 }
 
-static void notify_client_text(int event_type){
-    if (!client_handler) return;
-    uint8_t event[7 + sizeof(ancs_notification_buffer) + 1];
-    event[0] = HCI_EVENT_ANCS_META;
-    event[1] = 5 + ancs_attribute_len;
-    event[2] = event_type;
-    little_endian_store_16(event, 3, gc_handle);
-    little_endian_store_16(event, 5, ancs_attribute_id);
-    memcpy(&event[7], ancs_notification_buffer, ancs_attribute_len);
-    // we're nice
-    event[7+ancs_attribute_len] = 0;
-    (*client_handler)(HCI_EVENT_PACKET, 0, event, event[1] + 2);
+uint8_t ancs_client_set_notification_attributes(const ancs_client_attribute_request_t * attributes, uint8_t num_attributes){
+    if (num_attributes == 0 || num_attributes > ANCS_CLIENT_MAX_NR_ATTRIBUTES) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    ancs_attributes     = attributes;
+    ancs_num_attributes = num_attributes;
+    return ERROR_CODE_SUCCESS;
+}
+
+const char * ancs_client_attribute_name_for_id(int id){
+    if (id >= ANCS_ATTRBUTE_NAMES_COUNT) return 0;
+    return ancs_attribute_names[id];
+}
+
+static ancs_client_connection_t * ancs_client_connection_for_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MAX_NR_ANCS_CLIENT_CONNECTIONS;i++){
+        if (ancs_client_connections[i].state == TC_IDLE) continue;
+        if (ancs_client_connections[i].con_handle != con_handle) continue;
+        return &ancs_client_connections[i];
+    }
+    return NULL;
+}
+
+static ancs_client_connection_t * ancs_client_connection_create(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MAX_NR_ANCS_CLIENT_CONNECTIONS;i++){
+        if (ancs_client_connections[i].state != TC_IDLE) continue;
+        ancs_client_connection_t * connection = &ancs_client_connections[i];
+        memset(connection, 0, sizeof(ancs_client_connection_t));
+        connection->con_handle = con_handle;
+        connection->parser_state = W4_REQUEST;
+        return connection;
+    }
+    return NULL;
 }
 
-static void notify_client_simple(int event_type){
+static void notify_client_simple(ancs_client_connection_t * connection, int event_type){
     if (!client_handler) return;
     uint8_t event[5];
     event[0] = HCI_EVENT_ANCS_META;
     event[1] = 3;
     event[2] = event_type;
-    little_endian_store_16(event, 3, gc_handle);
+    little_endian_store_16(event, 3, connection->con_handle);
     (*client_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
-static void ancs_chunk_parser_init(void){
-    chunk_parser_state = W4_ATTRIBUTE_ID;
-    ancs_bytes_received = 0;
-    ancs_bytes_needed = 6;
+static void notify_client_notification_complete(ancs_client_connection_t * connection){
+    if (!client_handler) return;
+    uint8_t event[9];
+    event[0] = HCI_EVENT_ANCS_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = ANCS_SUBEVENT_CLIENT_NOTIFICATION_COMPLETE;
+    little_endian_store_16(event, 3, connection->con_handle);
+    little_endian_store_32(event, 5, connection->notification_uid);
+    (*client_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
-const char * ancs_client_attribute_name_for_id(int id){
-    if (id >= ANCS_ATTRBUTE_NAMES_COUNT) return 0;
-    return ancs_attribute_names[id];
+static void notify_client_attribute_chunk(ancs_client_connection_t * connection, const uint8_t * data, uint8_t len){
+    if (!client_handler) return;
+    uint8_t event[15 + ANCS_CLIENT_MAX_CHUNK_LEN];
+    event[0] = HCI_EVENT_ANCS_META;
+    event[1] = 13 + len;
+    event[2] = ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK;
+    little_endian_store_16(event, 3, connection->con_handle);
+    little_endian_store_32(event, 5, connection->notification_uid);
+    event[9] = connection->attribute_id;
+    little_endian_store_16(event, 10, connection->attribute_len);
+    little_endian_store_16(event, 12, connection->attribute_offset);
+    event[14] = len;
+    memcpy(&event[15], data, len);
+    (*client_handler)(HCI_EVENT_PACKET, 0, event, 15 + len);
 }
 
-static void ancs_chunk_parser_handle_byte(uint8_t data){
-    ancs_notification_buffer[ancs_bytes_received++] = data;
-    if (ancs_bytes_received < ancs_bytes_needed) return;
-    switch (chunk_parser_state){
-        case W4_ATTRIBUTE_ID:
-            ancs_attribute_id   = ancs_notification_buffer[ancs_bytes_received-1];
-            ancs_bytes_received = 0;
-            ancs_bytes_needed   = 2;
-            chunk_parser_state  = W4_ATTRIBUTE_LEN;
-            break;
-        case W4_ATTRIBUTE_LEN:
-            ancs_attribute_len  = little_endian_read_16(ancs_notification_buffer, ancs_bytes_received-2);
-            ancs_bytes_received = 0;
-            ancs_bytes_needed   = ancs_attribute_len;
-            if (ancs_attribute_len == 0) {
-                ancs_bytes_needed   = 1;
-                chunk_parser_state  = W4_ATTRIBUTE_ID;
-                break;
-            }
-            chunk_parser_state  = W4_ATTRIBUTE_COMPLETE;
-            break;
-        case W4_ATTRIBUTE_COMPLETE:
-            ancs_notification_buffer[ancs_bytes_received] = 0;
-            notify_client_text(ANCS_SUBEVENT_CLIENT_NOTIFICATION);
-            ancs_bytes_received = 0;
-            ancs_bytes_needed   = 1;
-            chunk_parser_state  = W4_ATTRIBUTE_ID;
-            break;
+static void ancs_client_parser_attribute_complete(ancs_client_connection_t * connection){
+    connection->attributes_remaining--;
+    if (connection->attributes_remaining > 0){
+        connection->parser_state = W4_ATTRIBUTE_ID;
+        return;
     }
+    connection->parser_state = W4_REQUEST;
+    notify_client_notification_complete(connection);
 }
 
-static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-
-    UNUSED(packet_type); // ok: only hci events
-    UNUSED(channel);     // ok: there is no channel
-    UNUSED(size);        // ok: fixed format events read from HCI buffer
-
-    int connection_encrypted;
+// streaming parser for Get Notification Attributes response, attribute values are forwarded without copying
+static void ancs_client_parser_handle_data(ancs_client_connection_t * connection, const uint8_t * data, uint16_t size){
+    uint16_t pos = 0;
+    uint16_t chunk_len;
+    while (pos < size){
+        switch (connection->parser_state){
+            case W4_REQUEST:
+                log_info("ANCS Data Source: unexpected data");
+                return;
+            case W4_RESPONSE_HEADER:
+                connection->parser_buffer[connection->parser_bytes_received++] = data[pos++];
+                if (connection->parser_bytes_received < ANCS_RESPONSE_HEADER_LEN) break;
+                connection->parser_bytes_received = 0;
+                if (little_endian_read_32(connection->parser_buffer, 1) != connection->notification_uid){
+                    log_info("ANCS Data Source: response for unexpected UID");
+                    connection->parser_state = W4_REQUEST;
+                    return;
+                }
+                connection->parser_state = W4_ATTRIBUTE_ID;
+                break;
+            case W4_ATTRIBUTE_ID:
+                connection->attribute_id = data[pos++];
+                connection->parser_state = W4_ATTRIBUTE_LEN;
+                break;
+            case W4_ATTRIBUTE_LEN:
+                connection->parser_buffer[connection->parser_bytes_received++] = data[pos++];
+                if (connection->parser_bytes_received < 2) break;
+                connection->parser_bytes_received = 0;
+                connection->attribute_len    = little_endian_read_16(connection->parser_buffer, 0);
+                connection->attribute_offset = 0;
+                if (connection->attribute_len == 0){
+                    notify_client_attribute_chunk(connection, &data[pos], 0);
+                    ancs_client_parser_attribute_complete(connection);
+                    break;
+                }
+                connection->parser_state = W4_ATTRIBUTE_COMPLETE;
+                break;
+            case W4_ATTRIBUTE_COMPLETE:
+                chunk_len = btstack_min(size - pos, connection->attribute_len - connection->attribute_offset);
+                chunk_len = btstack_min(chunk_len, ANCS_CLIENT_MAX_CHUNK_LEN);
+                notify_client_attribute_chunk(connection, &data[pos], chunk_len);
+                pos += chunk_len;
+                connection->attribute_offset += chunk_len;
+                if (connection->attribute_offset < connection->attribute_len) break;
+                ancs_client_parser_attribute_complete(connection);
+                break;
+            default:
+                return;
+        }
+    }
+}
 
-    // handle connect / disconncet events first
-    switch (hci_event_packet_get_type(packet)) {
-        case HCI_EVENT_LE_META:
-            switch (packet[2]) {
-                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
-                    gc_handle = little_endian_read_16(packet, 4);
-                    log_info("Connection handle 0x%04x, request encryption", gc_handle);
+static void ancs_client_queue_notification(ancs_client_connection_t * connection, uint32_t notification_uid){
+    int i;
+    for (i=0;i<connection->notification_queue_len;i++){
+        if (connection->notification_queue[i] == notification_uid) return;
+    }
+    if (connection->notification_queue_len == ANCS_CLIENT_NOTIFICATION_QUEUE_SIZE){
+        log_info("ANCS notification queue full, drop UID %04x", (int) notification_uid);
+        return;
+    }
+    connection->notification_queue[connection->notification_queue_len++] = notification_uid;
+}
 
-                    // we need to be paired to enable notifications
-                    tc_state = TC_W4_ENCRYPTED_CONNECTION;
-                    sm_send_security_request(gc_handle);
-                    break;
-                default:
-                    break;
-            }
-            return;
+static void ancs_client_dequeue_notification(ancs_client_connection_t * connection, uint32_t notification_uid){
+    int i;
+    for (i=0;i<connection->notification_queue_len;i++){
+        if (connection->notification_queue[i] != notification_uid) continue;
+        connection->notification_queue_len--;
+        memmove(&connection->notification_queue[i], &connection->notification_queue[i+1], (connection->notification_queue_len - i) * sizeof(uint32_t));
+        return;
+    }
+}
 
-        case HCI_EVENT_ENCRYPTION_CHANGE: 
-            if (gc_handle != little_endian_read_16(packet, 3)) return;
-            connection_encrypted = packet[5];
-            log_info("Encryption state change: %u", connection_encrypted);
-            if (!connection_encrypted) return;
-            if (tc_state != TC_W4_ENCRYPTED_CONNECTION) return;
+static void ancs_client_send_next_request(ancs_client_connection_t * connection){
+    if (connection->state != TC_SUBSCRIBED) return;
+    if (connection->parser_state != W4_REQUEST) return;
+    if (connection->notification_queue_len == 0) return;
+
+    uint32_t notification_uid = connection->notification_queue[0];
+    uint16_t pos = 0;
+    int i;
+    connection->command[pos++] = ANCS_COMMAND_ID_GET_NOTIFICATION_ATTRIBUTES;
+    little_endian_store_32(connection->command, pos, notification_uid);
+    pos += 4;
+    for (i=0;i<ancs_num_attributes;i++){
+        connection->command[pos++] = ancs_attributes[i].attribute_id;
+        switch (ancs_attributes[i].attribute_id){
+            case ANCS_NOTIFICATION_ATTRIBUTE_ID_TITLE:
+            case ANCS_NOTIFICATION_ATTRIBUTE_ID_SUBTITLE:
+            case ANCS_NOTIFICATION_ATTRIBUTE_ID_MESSAGE:
+                little_endian_store_16(connection->command, pos, ancs_attributes[i].max_len);
+                pos += 2;
+                break;
+            default:
+                break;
+        }
+    }
 
-            // let's start
-            log_info("\nANCS Client - CONNECTED, discover ANCS service");
-            tc_state = TC_W4_SERVICE_RESULT;
-            gatt_client_discover_primary_services_by_uuid128(handle_hci_event, gc_handle, ancs_service_uuid);
-            return;
-            
-        case HCI_EVENT_DISCONNECTION_COMPLETE:
-            if (hci_event_disconnection_complete_get_connection_handle(packet) != gc_handle) break;
-            if (tc_state == TC_SUBSCRIBED){
-                notify_client_simple(ANCS_SUBEVENT_CLIENT_DISCONNECTED);
-            }
-            tc_state = TC_IDLE;
-            gc_handle = 0;
-            return;
+    uint8_t status = gatt_client_write_value_of_characteristic(handle_hci_event, connection->con_handle,
+        connection->control_point_characteristic.value_handle, pos, connection->command);
+    if (status) {
+        // retry on next GATT_EVENT_QUERY_COMPLETE
+        log_info("ANCS Get Notification Attributes: write failed, status %x", status);
+        return;
+    }
+    ancs_client_dequeue_notification(connection, notification_uid);
+    connection->notification_uid      = notification_uid;
+    connection->attributes_remaining  = ancs_num_attributes;
+    connection->parser_bytes_received = 0;
+    connection->parser_state          = W4_RESPONSE_HEADER;
+}
 
-        default:
-            break;
+static void ancs_client_handle_notification_source(ancs_client_connection_t * connection, const uint8_t * value, uint16_t value_length){
+    if (value_length < 8) return;
+    uint32_t notification_uid = little_endian_read_32(value, 4);
+    log_info("Notification received: EventID %02x, EventFlags %02x, CategoryID %02x, CategoryCount %u, UID %04x",
+        value[0], value[1], value[2], value[3], (int) notification_uid);
+    if (value[0] == ANCS_EVENT_ID_NOTIFICATION_REMOVED){
+        ancs_client_dequeue_notification(connection, notification_uid);
+        return;
     }
+    ancs_client_queue_notification(connection, notification_uid);
+    ancs_client_send_next_request(connection);
+}
+
+static void handle_gatt_client_event(ancs_client_connection_t * connection, uint8_t *packet){
 
     gatt_client_characteristic_t characteristic;
     uint8_t *           value;
     uint16_t            value_handle;
     uint16_t            value_length;
 
-    switch(tc_state){
+    switch(connection->state){
         case TC_W4_SERVICE_RESULT:
             switch(hci_event_packet_get_type(packet)){
                 case GATT_EVENT_SERVICE_QUERY_RESULT:
-                    gatt_event_service_query_result_get_service(packet, &ancs_service);
-                    ancs_service_found = 1;
+                    gatt_event_service_query_result_get_service(packet, &connection->service);
+                    connection->service_found = 1;
                     break;
                 case GATT_EVENT_QUERY_COMPLETE:
-                    if (!ancs_service_found){
+                    if (!connection->service_found){
                         log_info("ANCS Service not found");
-                        tc_state = TC_IDLE;
+                        connection->state = TC_W4_DISCONNECT;
                         break;
                     }
-                    tc_state = TC_W4_CHARACTERISTIC_RESULT;
+                    connection->state = TC_W4_CHARACTERISTIC_RESULT;
                     log_info("ANCS Client - Discover characteristics for ANCS SERVICE ");
-                    gatt_client_discover_characteristics_for_service(handle_hci_event, gc_handle, &ancs_service);
+                    gatt_client_discover_characteristics_for_service(handle_hci_event, connection->con_handle, &connection->service);
                     break;
                 default:
                     break;
@@ -265,28 +419,32 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
                     gatt_event_characteristic_query_result_get_characteristic(packet, &characteristic);
                     if (memcmp(characteristic.uuid128, ancs_notification_source_uuid, 16) == 0){
                         log_info("ANCS Notification Source found, attribute handle %u", characteristic.value_handle);
-                        ancs_notification_source_characteristic = characteristic;
-                        ancs_characteristcs++;
+                        connection->notification_source_characteristic = characteristic;
+                        connection->characteristics++;
                         break;                        
                     }
                     if (memcmp(characteristic.uuid128, ancs_control_point_uuid, 16) == 0){
                         log_info("ANCS Control Point found, attribute handle %u", characteristic.value_handle);
-                        ancs_control_point_characteristic = characteristic;
-                        ancs_characteristcs++;
+                        connection->control_point_characteristic = characteristic;
+                        connection->characteristics++;
                         break;                        
                     }
                     if (memcmp(characteristic.uuid128, ancs_data_source_uuid, 16) == 0){
                         log_info("ANCS Data Source found, attribute handle %u", characteristic.value_handle);
-                        ancs_data_source_characteristic = characteristic;
-                        ancs_characteristcs++;
+                        connection->data_source_characteristic = characteristic;
+                        connection->characteristics++;
                         break;                        
                     }
                     break;
                 case GATT_EVENT_QUERY_COMPLETE:
-                    log_info("ANCS Characteristcs count %u", ancs_characteristcs);
-                    tc_state = TC_W4_NOTIFICATION_SOURCE_SUBSCRIBED;
-                    gatt_client_listen_for_characteristic_value_updates(&ancs_notification_source_notification, &handle_hci_event, gc_handle, &ancs_notification_source_characteristic);
-                    gatt_client_write_client_characteristic_configuration(handle_hci_event, gc_handle, &ancs_notification_source_characteristic,
+                    log_info("ANCS Characteristcs count %u", connection->characteristics);
+                    if (connection->characteristics < 3){
+                        connection->state = TC_W4_DISCONNECT;
+                        break;
+                    }
+                    connection->state = TC_W4_NOTIFICATION_SOURCE_SUBSCRIBED;
+                    gatt_client_listen_for_characteristic_value_updates(&connection->notification_source_notification, &handle_hci_event, connection->con_handle, &connection->notification_source_characteristic);
+                    gatt_client_write_client_characteristic_configuration(handle_hci_event, connection->con_handle, &connection->notification_source_characteristic,
                         GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
                     break;
                 default:
@@ -297,11 +455,17 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             switch(hci_event_packet_get_type(packet)){
                 case GATT_EVENT_QUERY_COMPLETE:
                     log_info("ANCS Notification Source subscribed");
-                    tc_state = TC_W4_DATA_SOURCE_SUBSCRIBED;
-                    gatt_client_listen_for_characteristic_value_updates(&ancs_data_source_notification, &handle_hci_event, gc_handle, &ancs_data_source_characteristic);
-                    gatt_client_write_client_characteristic_configuration(handle_hci_event, gc_handle, &ancs_data_source_characteristic,
+                    connection->state = TC_W4_DATA_SOURCE_SUBSCRIBED;
+                    gatt_client_listen_for_characteristic_value_updates(&connection->data_source_notification, &handle_hci_event, connection->con_handle, &connection->data_source_characteristic);
+                    gatt_client_write_client_characteristic_configuration(handle_hci_event, connection->con_handle, &connection->data_source_characteristic,
                         GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION);
                     break;
+                case GATT_EVENT_NOTIFICATION:
+                    // Notification Source events for existing notifications may arrive before Data Source is subscribed
+                    value_handle = little_endian_read_16(packet, 4);
+                    if (value_handle != connection->notification_source_characteristic.value_handle) break;
+                    ancs_client_handle_notification_source(connection, &packet[8], little_endian_read_16(packet, 6));
+                    break;
                 default:
                     break;
             }
@@ -310,49 +474,129 @@ static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             switch(hci_event_packet_get_type(packet)){
                 case GATT_EVENT_QUERY_COMPLETE:
                     log_info("ANCS Data Source subscribed");
-                    tc_state = TC_SUBSCRIBED;
-                    notify_client_simple(ANCS_SUBEVENT_CLIENT_CONNECTED);
+                    connection->state = TC_SUBSCRIBED;
+                    notify_client_simple(connection, ANCS_SUBEVENT_CLIENT_CONNECTED);
+                    ancs_client_send_next_request(connection);
+                    break;
+                case GATT_EVENT_NOTIFICATION:
+                    value_handle = little_endian_read_16(packet, 4);
+                    if (value_handle != connection->notification_source_characteristic.value_handle) break;
+                    ancs_client_handle_notification_source(connection, &packet[8], little_endian_read_16(packet, 6));
                     break;
                 default:
                     break;
             }
             break;
         case TC_SUBSCRIBED:
-            if (hci_event_packet_get_type(packet) != GATT_EVENT_NOTIFICATION && hci_event_packet_get_type(packet) != GATT_EVENT_INDICATION ) break;
+            switch(hci_event_packet_get_type(packet)){
+                case GATT_EVENT_QUERY_COMPLETE:
+                    // Get Notification Attributes rejected, e.g. for unknown UID
+                    if (gatt_event_query_complete_get_status(packet) && connection->parser_state == W4_RESPONSE_HEADER && connection->parser_bytes_received == 0){
+                        log_info("ANCS Get Notification Attributes failed, status %x", gatt_event_query_complete_get_status(packet));
+                        connection->parser_state = W4_REQUEST;
+                    }
+                    ancs_client_send_next_request(connection);
+                    break;
+                case GATT_EVENT_NOTIFICATION:
+                case GATT_EVENT_INDICATION:
+                    value_handle = little_endian_read_16(packet, 4);
+                    value_length = little_endian_read_16(packet, 6);
+                    value = &packet[8];
+
+                    log_info("ANCS Notification, value handle %u", value_handle);
+
+                    if (value_handle == connection->data_source_characteristic.value_handle){
+                        ancs_client_parser_handle_data(connection, value, value_length);
+                        ancs_client_send_next_request(connection);
+                    } else if (value_handle == connection->notification_source_characteristic.value_handle){
+                        ancs_client_handle_notification_source(connection, value, value_length);
+                    } else {
+                        log_info("Unknown Source: ");
+                        log_info_hexdump(value , value_length);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }    
+}
 
-            value_handle = little_endian_read_16(packet, 4);
-            value_length = little_endian_read_16(packet, 6);
-            value = &packet[8];
+static void handle_hci_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
 
-            log_info("ANCS Notification, value handle %u", value_handle);
+    UNUSED(packet_type); // ok: only hci events
+    UNUSED(channel);     // ok: there is no channel
+    UNUSED(size);        // ok: fixed format events read from HCI buffer
 
-            if (value_handle == ancs_data_source_characteristic.value_handle){
-                int i;
-                for (i=0;i<value_length;i++) {
-                    ancs_chunk_parser_handle_byte(value[i]);
-                }
-            } else if (value_handle == ancs_notification_source_characteristic.value_handle){
-                ancs_notification_uid = little_endian_read_32(value, 4);
-                log_info("Notification received: EventID %02x, EventFlags %02x, CategoryID %02x, CategoryCount %u, UID %04x",
-                    value[0], value[1], value[2], value[3], (int) ancs_notification_uid);
-                static uint8_t get_notification_attributes[] = {0, 0,0,0,0,  0,  1,32,0,  2,32,0, 3,32,0, 4, 5};
-                little_endian_store_32(get_notification_attributes, 1, ancs_notification_uid);
-                ancs_notification_uid = 0;
-                ancs_chunk_parser_init();
-                gatt_client_write_value_of_characteristic(handle_hci_event, gc_handle, ancs_control_point_characteristic.value_handle, 
-                    sizeof(get_notification_attributes), get_notification_attributes);
-            } else {
-                log_info("Unknown Source: ");
-                log_info_hexdump(value , value_length);
+    ancs_client_connection_t * connection;
+    hci_con_handle_t con_handle;
+
+    switch (hci_event_packet_get_type(packet)) {
+        case HCI_EVENT_LE_META:
+            switch (packet[2]) {
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    if (hci_subevent_le_connection_complete_get_status(packet)) break;
+                    con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+                    connection = ancs_client_connection_create(con_handle);
+                    if (!connection){
+                        log_info("ANCS Client: no free context for connection 0x%04x", con_handle);
+                        break;
+                    }
+                    log_info("Connection handle 0x%04x, request encryption", con_handle);
+
+                    // we need to be paired to enable notifications
+                    connection->state = TC_W4_ENCRYPTED_CONNECTION;
+                    sm_send_security_request(con_handle);
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        case HCI_EVENT_ENCRYPTION_CHANGE: 
+            connection = ancs_client_connection_for_handle(hci_event_encryption_change_get_connection_handle(packet));
+            if (!connection) break;
+            log_info("Encryption state change: %u", hci_event_encryption_change_get_encryption_enabled(packet));
+            if (!hci_event_encryption_change_get_encryption_enabled(packet)) break;
+            if (connection->state != TC_W4_ENCRYPTED_CONNECTION) break;
+
+            // let's start
+            log_info("\nANCS Client - CONNECTED, discover ANCS service");
+            connection->state = TC_W4_SERVICE_RESULT;
+            gatt_client_discover_primary_services_by_uuid128(handle_hci_event, connection->con_handle, ancs_service_uuid);
+            break;
+            
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            connection = ancs_client_connection_for_handle(hci_event_disconnection_complete_get_connection_handle(packet));
+            if (!connection) break;
+            if (connection->state == TC_SUBSCRIBED){
+                notify_client_simple(connection, ANCS_SUBEVENT_CLIENT_DISCONNECTED);
             }
+            gatt_client_stop_listening_for_characteristic_value_updates(&connection->notification_source_notification);
+            gatt_client_stop_listening_for_characteristic_value_updates(&connection->data_source_notification);
+            connection->state = TC_IDLE;
+            break;
+
+        case GATT_EVENT_SERVICE_QUERY_RESULT:
+        case GATT_EVENT_CHARACTERISTIC_QUERY_RESULT:
+        case GATT_EVENT_QUERY_COMPLETE:
+        case GATT_EVENT_NOTIFICATION:
+        case GATT_EVENT_INDICATION:
+            // all GATT Client events start with connection handle
+            connection = ancs_client_connection_for_handle(little_endian_read_16(packet, 2));
+            if (!connection) break;
+            handle_gatt_client_event(connection, packet);
             break;
+
         default:
             break;
-    }    
-    // app_run();
+    }
 }
 
 void ancs_client_init(void){
+    memset(ancs_client_connections, 0, sizeof(ancs_client_connections));
     hci_event_callback_registration.callback = &handle_hci_event;
     hci_add_event_handler(&hci_event_callback_registration);
 }
@@ -34,7 +34,6 @@
  * contact@bluekitchen-gmbh.com
  *
  */
-
 #ifndef __ANCS_CLIENT_H
 #define __ANCS_CLIENT_H
 
@@ -44,11 +43,51 @@ extern "C" {
 
 #include <stdint.h>
 #include "btstack_defines.h"
+
+// Notification Attribute IDs
+typedef enum {
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_APP_IDENTIFIER = 0,
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_TITLE,
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_SUBTITLE,
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_MESSAGE,
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_MESSAGE_SIZE,
+    ANCS_NOTIFICATION_ATTRIBUTE_ID_DATE,
+} ancs_notification_attribute_id_t;
+
+// Attribute requested with Get Notification Attributes command
+// max_len is only sent for Title, Subtitle and Message
+typedef struct {
+    uint8_t  attribute_id;
+    uint16_t max_len;
+} ancs_client_attribute_request_t;
 	
 /* API_START */
 
+/**
+ * @brief Init ANCS Client. Up to MAX_NR_ANCS_CLIENT_CONNECTIONS iOS devices are handled in parallel
+ */
 void ancs_client_init(void);
+
+/**
+ * @brief Register callback for ANCS events
+ * @param callback
+ */
 void ancs_client_register_callback(btstack_packet_handler_t callback);
+
+/**
+ * @brief Set attributes requested for each notification. Default: all attributes with max_len 0xffff
+ * @note attribute values are reported in chunks via ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
+ * @param attributes array of attribute requests, needs to stay valid
+ * @param num_attributes up to ANCS_CLIENT_MAX_NR_ATTRIBUTES
+ * @return status ERROR_CODE_SUCCESS or ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS
+ */
+uint8_t ancs_client_set_notification_attributes(const ancs_client_attribute_request_t * attributes, uint8_t num_attributes);
+
+/**
+ * @brief Get name for attribute id
+ * @param id
+ * @return name or NULL
+ */
 const char * ancs_client_attribute_name_for_id(int id);
 
 /* API_END */
@@ -1078,6 +1078,16 @@ static void handle_write_command(att_connection_t * att_connection, uint8_t * re
     (*att_write_callback)(att_connection->con_handle, handle, ATT_TRANSACTION_MODE_NONE, 0, request_buffer + 3, request_len - 3);
 }
 
+int att_write_command_allowed(att_connection_t * att_connection, uint16_t handle){
+    att_iterator_t it;
+    int ok = att_find_handle(&it, handle);
+    if (!ok) return 0;
+    if ((it.flags & ATT_PROPERTY_DYNAMIC) == 0) return 0;
+    if ((it.flags & ATT_PROPERTY_WRITE_WITHOUT_RESPONSE) == 0) return 0;
+    if (att_validate_security(att_connection, ATT_WRITE, &it)) return 0;
+    return 1;
+}
+
 // MARK: helper for ATT_HANDLE_VALUE_NOTIFICATION and ATT_HANDLE_VALUE_INDICATION
 static uint16_t prepare_handle_value(att_connection_t * att_connection,
                                      uint16_t handle,
@@ -1326,6 +1336,30 @@ uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uui
     return 0;
 }
 
+// returns 0 if not found
+uint16_t gatt_server_get_value_handle_for_client_configuration_handle(uint16_t client_configuration_handle){
+    att_iterator_t it;
+    att_iterator_init(&it);
+    uint16_t value_handle = 0;
+    while (att_iterator_has_next(&it)){
+        att_iterator_fetch_next(&it);
+        if (it.handle == 0) break;
+        if (it.handle > client_configuration_handle) break;
+        if (att_iterator_match_uuid16(&it, GATT_PRIMARY_SERVICE_UUID)
+         || att_iterator_match_uuid16(&it, GATT_SECONDARY_SERVICE_UUID)){
+            value_handle = 0;
+            continue;
+        }
+        if (att_iterator_match_uuid16(&it, GATT_CHARACTERISTICS_UUID)){
+            // characteristic declaration: properties, value handle, uuid
+            value_handle = little_endian_read_16(it.value, 1);
+            continue;
+        }
+        if (it.handle == client_configuration_handle) return value_handle;
+    }
+    return 0;
+}
+
 
 // 1-item cache to optimize query during write_callback
 static void att_persistent_ccc_cache(att_iterator_t * it){
@@ -1337,6 +1371,13 @@ static void att_persistent_ccc_cache(att_iterator_t * it){
     }
 }
 
+int att_is_dynamic(uint16_t handle){
+    att_iterator_t it;
+    int ok = att_find_handle(&it, handle);
+    if (!ok) return 0;
+    return (it.flags & ATT_PROPERTY_DYNAMIC) != 0;
+}
+
 int att_is_persistent_ccc(uint16_t handle){
     if (handle != att_persistent_ccc_handle){
         att_iterator_t it;
@@ -105,6 +105,9 @@ typedef struct att_service_handler {
   att_write_callback_t write_callback;
 } att_service_handler_t;
 
+// service index for handles that don't belong to a service, see att_server_set_service_index_table
+#define ATT_SERVICE_INDEX_NONE 0xff
+
 // MARK: ATT Operations
 
 /*
@@ -245,6 +248,9 @@ uint16_t gatt_server_get_value_handle_for_characteristic_with_uuid128(uint16_t s
 // returns 0 if not found
 uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uuid128(uint16_t start_handle, uint16_t end_handle, const uint8_t * uuid128);
 
+// returns 0 if not found
+uint16_t gatt_server_get_value_handle_for_client_configuration_handle(uint16_t client_configuration_handle);
+
 // non-user functionality for att_server
 
 /*
@@ -254,6 +260,21 @@ uint16_t gatt_server_get_client_configuration_handle_for_characteristic_with_uui
  */
 int att_is_persistent_ccc(uint16_t handle);
 
+/*
+ * @brief Check if value of handle is provided by read callback
+ * @param handle
+ * @returns 1 if dynamic
+ */
+int att_is_dynamic(uint16_t handle);
+
+/*
+ * @brief Check if Write Command for handle is accepted: dynamic value with Write Without Response property and sufficient security
+ * @param att_connection used for security properties
+ * @param handle
+ * @returns 1 if accepted
+ */
+int att_write_command_allowed(att_connection_t * att_connection, uint16_t handle);
+
 
 #if defined __cplusplus
 }
@@ -73,10 +73,40 @@
 #define NVN_NUM_GATT_SERVER_CCC 20
 #endif
 
+// number of tracked Client Characteristic Configurations of all connections, see att_server_notify_subscribers
+// CCC writes are still accepted if all are in use, but these clients are not notified by att_server_notify_subscribers
+#ifndef MAX_NR_ATT_SERVER_SUBSCRIPTIONS
+#if defined(MAX_NR_HCI_CONNECTIONS) && (MAX_NR_HCI_CONNECTIONS > 0)
+#define MAX_NR_ATT_SERVER_SUBSCRIPTIONS (4 * MAX_NR_HCI_CONNECTIONS)
+#else
+#define MAX_NR_ATT_SERVER_SUBSCRIPTIONS 8
+#endif
+#endif
+
+// persistent CCC changes are stored in TLV after this delay or on disconnect
+#ifndef ATT_SERVER_PERSISTENT_CCC_FLUSH_MS
+#define ATT_SERVER_PERSISTENT_CCC_FLUSH_MS 1000
+#endif
+
+// size of sorted service handler table, additional handlers are found by linear search
+#ifndef MAX_NR_ATT_SERVICE_HANDLERS
+#define MAX_NR_ATT_SERVICE_HANDLERS 8
+#endif
+
+// deliver streamed Write Commands if no further Write Command was received within this time
+#ifndef ATT_SERVER_WRITE_STREAM_FLUSH_MS
+#define ATT_SERVER_WRITE_STREAM_FLUSH_MS 20
+#endif
+
 static void att_run_for_context(att_server_t * att_server);
 static att_write_callback_t att_server_write_callback_for_handle(uint16_t handle);
 static void att_server_persistent_ccc_restore(att_server_t * att_server);
 static void att_server_persistent_ccc_clear(att_server_t * att_server);
+static void att_server_persistent_ccc_flush(void);
+static void att_server_subscription_update(hci_con_handle_t con_handle, uint16_t client_configuration_handle, uint16_t value);
+static void att_server_subscriptions_remove_for_handle(hci_con_handle_t con_handle);
+static int  att_server_subscriptions_send_pending_notification(void);
+static uint16_t att_server_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size);
 
 //
 typedef struct {
@@ -86,6 +116,22 @@ typedef struct {
     uint8_t  device_index;
 } persistent_ccc_entry_t;
 
+// RAM copy of CCC tag in TLV
+typedef struct {
+    persistent_ccc_entry_t entry;
+    uint8_t valid;
+    uint8_t dirty;
+} persistent_ccc_index_entry_t;
+
+// Client Characteristic Configuration of a connection
+typedef struct {
+    hci_con_handle_t con_handle;
+    uint16_t client_configuration_handle;
+    uint16_t value_handle;
+    uint16_t client_configuration;
+    uint8_t  notification_pending;
+} att_server_subscription_t;
+
 // global
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 static btstack_packet_callback_registration_t sm_event_callback_registration;
@@ -94,9 +140,33 @@ static btstack_linked_list_t                  can_send_now_clients;
 static btstack_linked_list_t                  service_handlers;
 static uint8_t                                att_client_waiting_for_can_send;
 
+// service handlers sorted by start handle for binary search
+static att_service_handler_t *                service_handler_table[MAX_NR_ATT_SERVICE_HANDLERS];
+static uint8_t                                service_handler_table_count;
+static uint8_t                                service_handler_table_overflow;
+
+// optional static handle -> service index table, see att_server_set_service_index_table
+static const uint8_t *                        service_index_for_handle;
+static uint16_t                               service_index_num_handles;
+static att_service_handler_t **               service_handler_for_service_index;
+static uint8_t                                service_index_num_services;
+
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+static btstack_linked_list_t                  write_streams;
+#endif
+
 static att_read_callback_t                    att_server_client_read_callback;
 static att_write_callback_t                   att_server_client_write_callback;
 
+// persistent CCC values, loaded from TLV on first use
+static persistent_ccc_index_entry_t           persistent_ccc_index[NVN_NUM_GATT_SERVER_CCC];
+static uint8_t                                persistent_ccc_index_loaded;
+static uint32_t                               persistent_ccc_highest_seq_nr;
+static btstack_timer_source_t                 persistent_ccc_flush_timer;
+
+// CCC values of all connections
+static att_server_subscription_t              att_server_subscriptions[MAX_NR_ATT_SERVER_SUBSCRIPTIONS];
+
 // track CCC 1-entry cache
 // static att_server_t *    att_persistent_ccc_server;
 // static hci_con_handle_t  att_persistent_ccc_con_handle;
@@ -164,6 +234,132 @@ static void att_handle_value_indication_timeout(btstack_timer_source_t *ts){
     att_handle_value_indication_notify_client(ATT_HANDLE_VALUE_INDICATION_TIMEOUT, att_server->connection.con_handle, att_handle);
 }
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+static att_server_write_stream_t * att_server_write_stream_for_handle(uint16_t attribute_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &write_streams);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        att_server_write_stream_t * stream = (att_server_write_stream_t *) btstack_linked_list_iterator_next(&it);
+        if (stream->attribute_handle == attribute_handle) return stream;
+    }
+    return NULL;
+}
+
+static void att_server_write_stream_set_paused(att_server_t * att_server, int paused){
+    att_server->write_stream_paused = paused;
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
+    hci_set_acl_rx_paused(att_server->connection.con_handle, paused);
+#endif
+}
+
+static void att_server_write_stream_deliver(att_server_t * att_server){
+    btstack_run_loop_remove_timer(&att_server->write_stream_timer);
+    if (att_server->write_stream_len == 0) return;
+    if (att_server->write_stream_paused) return;
+    if (att_server->write_stream_delivering) return;
+
+    att_server_write_stream_t * stream = att_server_write_stream_for_handle(att_server->write_stream_attribute_handle);
+    if (!stream){
+        att_server->write_stream_len = 0;
+        return;
+    }
+
+    att_server->write_stream_delivering = 1;
+    uint16_t consumed = (*stream->callback)(att_server->connection.con_handle, stream->attribute_handle,
+        att_server->write_stream_buffer, att_server->write_stream_len);
+    att_server->write_stream_delivering = 0;
+
+    if (consumed >= att_server->write_stream_len){
+        att_server->write_stream_len = 0;
+        return;
+    }
+
+    // keep remaining data and pause until resumed
+    att_server->write_stream_len -= consumed;
+    memmove(att_server->write_stream_buffer, &att_server->write_stream_buffer[consumed], att_server->write_stream_len);
+    log_info("Write Stream 0x%04x paused, %u bytes buffered", stream->attribute_handle, att_server->write_stream_len);
+    att_server_write_stream_set_paused(att_server, 1);
+}
+
+static void att_server_write_stream_timeout(btstack_timer_source_t * ts){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) btstack_run_loop_get_timer_context(ts);
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return;
+    att_server_write_stream_deliver(att_server);
+}
+
+// @returns 1 if Write Command was handled by a write stream
+static int att_server_write_stream_handle_write_command(att_server_t * att_server, uint8_t * packet, uint16_t size){
+    if (size < 3) return 0;
+    uint16_t attribute_handle = little_endian_read_16(packet, 1);
+    if (!att_server_write_stream_for_handle(attribute_handle)){
+        // keep order with regular Write Commands
+        att_server_write_stream_deliver(att_server);
+        return 0;
+    }
+
+    // validate once per handle until security changes
+    if (att_server->write_stream_validated_handle != attribute_handle){
+        if (!att_write_command_allowed(&att_server->connection, attribute_handle)) return 1;
+        att_server->write_stream_validated_handle = attribute_handle;
+    }
+
+    // keep order between streams
+    if (att_server->write_stream_len && (att_server->write_stream_attribute_handle != attribute_handle)){
+        att_server_write_stream_deliver(att_server);
+    }
+
+    uint16_t value_len = size - 3;
+    if ((att_server->write_stream_len + value_len) > ATT_SERVER_WRITE_STREAM_BUFFER_SIZE){
+        att_server_write_stream_deliver(att_server);
+    }
+    if ((att_server->write_stream_len && (att_server->write_stream_attribute_handle != attribute_handle))
+    ||  ((att_server->write_stream_len + value_len) > ATT_SERVER_WRITE_STREAM_BUFFER_SIZE)){
+        log_error("Write Stream 0x%04x: buffer full, dropping %u bytes", attribute_handle, value_len);
+        return 1;
+    }
+
+    memcpy(&att_server->write_stream_buffer[att_server->write_stream_len], &packet[3], value_len);
+    att_server->write_stream_len += value_len;
+    att_server->write_stream_attribute_handle = attribute_handle;
+
+    if (att_server->write_stream_paused) return 1;
+
+    // deliver batch if next Write Command might not fit
+    if ((att_server->write_stream_len + att_server->connection.mtu - 3) > ATT_SERVER_WRITE_STREAM_BUFFER_SIZE){
+        att_server_write_stream_deliver(att_server);
+        return 1;
+    }
+
+    // otherwise, deliver after short idle time
+    btstack_run_loop_remove_timer(&att_server->write_stream_timer);
+    btstack_run_loop_set_timer_handler(&att_server->write_stream_timer, att_server_write_stream_timeout);
+    btstack_run_loop_set_timer_context(&att_server->write_stream_timer, (void *) (uintptr_t) att_server->connection.con_handle);
+    btstack_run_loop_set_timer(&att_server->write_stream_timer, ATT_SERVER_WRITE_STREAM_FLUSH_MS);
+    btstack_run_loop_add_timer(&att_server->write_stream_timer);
+    return 1;
+}
+
+static void att_server_write_stream_disconnect(att_server_t * att_server){
+    // deliver remaining data even if paused, not consumed data is dropped
+    att_server->write_stream_paused = 0;
+    att_server_write_stream_deliver(att_server);
+    att_server->write_stream_len = 0;
+    att_server->write_stream_paused = 0;
+}
+#endif
+
+// registrations might be reused by services after disconnect
+static void att_server_can_send_now_clients_remove_for_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &can_send_now_clients);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        btstack_context_callback_registration_t * client = (btstack_context_callback_registration_t*) btstack_linked_list_iterator_next(&it);
+        if ((hci_con_handle_t) (uintptr_t) client->context != con_handle) continue;
+        btstack_linked_list_iterator_remove(&it);
+    }
+}
+
 static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
 
     UNUSED(channel); // ok: there is no channel
@@ -200,6 +396,11 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                             // workaround: identity resolving can already be complete, at least store result
                             att_server->ir_le_device_db_index = sm_le_device_index(con_handle);
                             att_server->pairing_active = 0;
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+                            att_server->write_stream_len = 0;
+                            att_server->write_stream_paused = 0;
+                            att_server->write_stream_validated_handle = 0;
+#endif
                             break;
 
                         default:
@@ -215,6 +416,9 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     if (!att_server) break;
                     att_server->connection.encryption_key_size = gap_encryption_key_size(con_handle);
                     att_server->connection.authenticated = gap_authenticated(con_handle);
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+                    att_server->write_stream_validated_handle = 0;
+#endif
                     if (hci_event_packet_get_type(packet) == HCI_EVENT_ENCRYPTION_CHANGE){
                         // restore CCC values when encrypted
                         if (hci_event_encryption_change_get_encryption_enabled(packet)){
@@ -226,9 +430,15 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                 case HCI_EVENT_DISCONNECTION_COMPLETE:
                     // check handle
                     con_handle = hci_event_disconnection_complete_get_connection_handle(packet);
+                    att_server_can_send_now_clients_remove_for_handle(con_handle);
                     att_server = att_server_for_handle(con_handle);
                     if (!att_server) break;
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+                    att_server_write_stream_disconnect(att_server);
+#endif
                     att_clear_transaction_queue(&att_server->connection);
+                    att_server_subscriptions_remove_for_handle(con_handle);
+                    att_server_persistent_ccc_flush();
                     att_server->connection.con_handle = 0;
                     att_server->value_indication_handle = 0; // reset error state
                     att_server->pairing_active = 0;
@@ -305,6 +515,9 @@ static void att_event_packet_handler (uint8_t packet_type, uint16_t channel, uin
                     att_server = att_server_for_handle(con_handle);
                     if (!att_server) break;
                     att_server->connection.authorized = sm_event_authorization_result_get_authorization_result(packet);
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+                    att_server->write_stream_validated_handle = 0;
+#endif
                     att_dispatch_server_request_can_send_now_event(con_handle);
                 	break;
                 }
@@ -416,6 +629,11 @@ static void att_run_for_context(att_server_t * att_server){
             // wait until pairing is complete
             if (att_server->pairing_active) break;
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+            // wait until buffered Write Stream data was delivered
+            if (att_server->write_stream_paused) break;
+#endif
+
 #ifdef ENABLE_LE_SIGNED_WRITE
             if (att_server->request_buffer[0] == ATT_SIGNED_WRITE_COMMAND){
                 log_info("ATT Signed Write!");
@@ -487,10 +705,17 @@ static void att_server_handle_can_send_now(void){
         }
     }
 
+    if (att_server_subscriptions_send_pending_notification()) return;
+
     while (!btstack_linked_list_empty(&can_send_now_clients)){
         // handle first client
         btstack_context_callback_registration_t * client = (btstack_context_callback_registration_t*) can_send_now_clients;
         hci_con_handle_t con_handle = (uintptr_t) client->context;
+        // buffer used by pending notification
+        if (!att_dispatch_server_can_send_now(con_handle)){
+            att_dispatch_server_request_can_send_now_event(con_handle);
+            return;
+        }
         btstack_linked_list_remove(&can_send_now_clients, (btstack_linked_item_t *) client);
         client->callback(client->context);
 
@@ -548,10 +773,24 @@ static void att_packet_handler(uint8_t packet_type, uint16_t handle, uint8_t *pa
             // directly process command
             // note: signed write cannot be handled directly as authentication needs to be verified
             if (packet[0] == ATT_WRITE_COMMAND){
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+                if (att_server_write_stream_handle_write_command(att_server, packet, size)) return;
+                if (!att_server->write_stream_paused){
+                    att_handle_request(&att_server->connection, packet, size, 0);
+                    return;
+                }
+                // stream paused, process like a request after buffered data was delivered
+#else
                 att_handle_request(&att_server->connection, packet, size, 0);
                 return;
+#endif
             }
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+            // deliver streamed writes before other requests
+            att_server_write_stream_deliver(att_server);
+#endif
+
             // check size
             if (size > sizeof(att_server->request_buffer)) {
                 log_info("att_packet_handler: dropping att pdu 0x%02x as size %u > att_server->request_buffer %u", packet[0], size, (int) sizeof(att_server->request_buffer));
@@ -580,6 +819,69 @@ static uint32_t att_server_persistent_ccc_tag_for_index(uint8_t index){
     return 'B' << 24 | 'T' << 16 | 'C' << 8 | index;
 }
 
+static int att_server_persistent_ccc_index_load(void){
+    if (persistent_ccc_index_loaded) return 1;
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return 0;
+    // read all ccc tags once
+    int index;
+    persistent_ccc_highest_seq_nr = 0;
+    for (index=0;index<NVN_NUM_GATT_SERVER_CCC;index++){
+        persistent_ccc_index_entry_t * index_entry = &persistent_ccc_index[index];
+        uint32_t tag = att_server_persistent_ccc_tag_for_index(index);
+        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) &index_entry->entry, sizeof(persistent_ccc_entry_t));
+        index_entry->valid = len == sizeof(persistent_ccc_entry_t);
+        index_entry->dirty = 0;
+        if (!index_entry->valid) continue;
+        if (index_entry->entry.seq_nr > persistent_ccc_highest_seq_nr){
+            persistent_ccc_highest_seq_nr = index_entry->entry.seq_nr;
+        }
+    }
+    persistent_ccc_index_loaded = 1;
+    return 1;
+}
+
+static void att_server_persistent_ccc_flush(void){
+    btstack_run_loop_remove_timer(&persistent_ccc_flush_timer);
+    if (!persistent_ccc_index_loaded) return;
+    // get btstack_tlv
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    // store modified ccc tags
+    int index;
+    for (index=0;index<NVN_NUM_GATT_SERVER_CCC;index++){
+        persistent_ccc_index_entry_t * index_entry = &persistent_ccc_index[index];
+        if (!index_entry->dirty) continue;
+        index_entry->dirty = 0;
+        uint32_t tag = att_server_persistent_ccc_tag_for_index(index);
+        if (index_entry->valid){
+            log_info("CCC Index %u: Store", index);
+            tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &index_entry->entry, sizeof(persistent_ccc_entry_t));
+        } else {
+            log_info("CCC Index %u: Delete", index);
+            tlv_impl->delete_tag(tlv_context, tag);
+        }
+    }
+}
+
+static void att_server_persistent_ccc_flush_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    att_server_persistent_ccc_flush();
+}
+
+static void att_server_persistent_ccc_mark_dirty(persistent_ccc_index_entry_t * index_entry){
+    index_entry->dirty = 1;
+    btstack_run_loop_remove_timer(&persistent_ccc_flush_timer);
+    btstack_run_loop_set_timer_handler(&persistent_ccc_flush_timer, &att_server_persistent_ccc_flush_timer_handler);
+    btstack_run_loop_set_timer(&persistent_ccc_flush_timer, ATT_SERVER_PERSISTENT_CCC_FLUSH_MS);
+    btstack_run_loop_add_timer(&persistent_ccc_flush_timer);
+}
+
 static void att_server_persistent_ccc_write(hci_con_handle_t con_handle, uint16_t att_handle, uint16_t value){
     // lookup att_server instance
     att_server_t * att_server = att_server_for_handle(con_handle);
@@ -590,82 +892,59 @@ static void att_server_persistent_ccc_write(hci_con_handle_t con_handle, uint16_
     // check if bonded
     if (le_device_index < 0) return;
 
-    // get btstack_tlv
-    const btstack_tlv_t * tlv_impl = NULL;
-    void * tlv_context;
-    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
-    if (!tlv_impl) return;
+    if (!att_server_persistent_ccc_index_load()) return;
 
-    // update ccc tag
+    // update ccc entry
     int index;
-    uint32_t highest_seq_nr = 0;
-    uint32_t lowest_seq_nr = 0;
-    uint32_t tag_for_lowest_seq_nr = 0;
-    uint32_t tag_for_empty = 0;
-    persistent_ccc_entry_t entry;
+    persistent_ccc_index_entry_t * entry_for_empty = NULL;
+    persistent_ccc_index_entry_t * entry_for_lowest_seq_nr = NULL;
     for (index=0;index<NVN_NUM_GATT_SERVER_CCC;index++){
-        uint32_t tag = att_server_persistent_ccc_tag_for_index(index);
-        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) &entry, sizeof(persistent_ccc_entry_t));
+        persistent_ccc_index_entry_t * index_entry = &persistent_ccc_index[index];
 
-        // empty/invalid tag
-        if (len != sizeof(persistent_ccc_entry_t)){
-            tag_for_empty = tag;
+        // empty entry
+        if (!index_entry->valid){
+            entry_for_empty = index_entry;
             continue;
         }
-        // update highest seq nr
-        if (entry.seq_nr > highest_seq_nr){
-            highest_seq_nr = entry.seq_nr;
-        }
         // find entry with lowest seq nr
-        if ((tag_for_lowest_seq_nr == 0) || (entry.seq_nr < lowest_seq_nr)){
-            tag_for_lowest_seq_nr = tag;
-            lowest_seq_nr = entry.seq_nr;
+        if ((entry_for_lowest_seq_nr == NULL) || (index_entry->entry.seq_nr < entry_for_lowest_seq_nr->entry.seq_nr)){
+            entry_for_lowest_seq_nr = index_entry;
         }
 
-        if (entry.device_index != le_device_index) continue;
-        if (entry.att_handle   != att_handle)      continue;
+        if (index_entry->entry.device_index != le_device_index) continue;
+        if (index_entry->entry.att_handle   != att_handle)      continue;
 
         // found matching entry
         if (value){
             // update
-            if (entry.value == value) {
+            if (index_entry->entry.value == value) {
                 log_info("CCC Index %u: Up-to-date", index);
                 return;
             }
-            entry.value = value;
-            entry.seq_nr = highest_seq_nr + 1;
-            log_info("CCC Index %u: Store", index);
-            tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &entry, sizeof(persistent_ccc_entry_t));
+            index_entry->entry.value = value;
+            index_entry->entry.seq_nr = ++persistent_ccc_highest_seq_nr;
         } else {
             // delete
-            log_info("CCC Index %u: Delete", index);
-            tlv_impl->delete_tag(tlv_context, tag);
+            index_entry->valid = 0;
         }
+        att_server_persistent_ccc_mark_dirty(index_entry);
         return;
     }
 
-    log_info("tag_for_empy %"PRIx32", tag_for_lowest_seq_nr %"PRIx32, tag_for_empty, tag_for_lowest_seq_nr);
-
     if (value == 0){
         // done
         return;
     }
 
-    uint32_t tag_to_use = 0;
-    if (tag_for_empty){
-        tag_to_use = tag_for_empty;
-    } else if (tag_for_lowest_seq_nr){
-        tag_to_use = tag_for_lowest_seq_nr;
-    } else {
-        // should not happen
-        return;
-    }
-    // store ccc tag
-    entry.seq_nr       = highest_seq_nr + 1;
-    entry.device_index = le_device_index;
-    entry.att_handle   = att_handle;
-    entry.value        = value;
-    tlv_impl->store_tag(tlv_context, tag_to_use, (uint8_t *) &entry, sizeof(persistent_ccc_entry_t));
+    persistent_ccc_index_entry_t * index_entry = entry_for_empty ? entry_for_empty : entry_for_lowest_seq_nr;
+    if (!index_entry) return;
+    // store ccc entry
+    index_entry->valid = 1;
+    index_entry->entry.seq_nr       = ++persistent_ccc_highest_seq_nr;
+    index_entry->entry.device_index = le_device_index;
+    index_entry->entry.att_handle   = att_handle;
+    index_entry->entry.value        = value;
+    att_server_persistent_ccc_mark_dirty(index_entry);
 }
 
 static void att_server_persistent_ccc_clear(att_server_t * att_server){
@@ -674,23 +953,16 @@ static void att_server_persistent_ccc_clear(att_server_t * att_server){
     log_info("Clear CCC values of remote %s, le device id %d", bd_addr_to_str(att_server->peer_address), le_device_index);
     // check if bonded
     if (le_device_index < 0) return;
-    // get btstack_tlv
-    const btstack_tlv_t * tlv_impl = NULL;
-    void * tlv_context;
-    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
-    if (!tlv_impl) return;
-    // get all ccc tag
+    if (!att_server_persistent_ccc_index_load()) return;
+    // delete all entries of device
     int index;
-    persistent_ccc_entry_t entry;
     for (index=0;index<NVN_NUM_GATT_SERVER_CCC;index++){
-        uint32_t tag = att_server_persistent_ccc_tag_for_index(index);
-        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) &entry, sizeof(persistent_ccc_entry_t));
-        if (len != sizeof(persistent_ccc_entry_t)) continue;
-        if (entry.device_index != le_device_index) continue;
-        // delete entry
-        log_info("CCC Index %u: Delete", index);
-        tlv_impl->delete_tag(tlv_context, tag);
-    }  
+        persistent_ccc_index_entry_t * index_entry = &persistent_ccc_index[index];
+        if (!index_entry->valid) continue;
+        if (index_entry->entry.device_index != le_device_index) continue;
+        index_entry->valid = 0;
+        att_server_persistent_ccc_mark_dirty(index_entry);
+    }
 }
 
 static void att_server_persistent_ccc_restore(att_server_t * att_server){
@@ -699,26 +971,21 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
     log_info("Restore CCC values of remote %s, le device id %d", bd_addr_to_str(att_server->peer_address), le_device_index);
     // check if bonded
     if (le_device_index < 0) return;
-    // get btstack_tlv
-    const btstack_tlv_t * tlv_impl = NULL;
-    void * tlv_context;
-    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
-    if (!tlv_impl) return;
-    // get all ccc tag
+    if (!att_server_persistent_ccc_index_load()) return;
+    // get all entries of device
     int index;
-    persistent_ccc_entry_t entry;
     for (index=0;index<NVN_NUM_GATT_SERVER_CCC;index++){
-        uint32_t tag = att_server_persistent_ccc_tag_for_index(index);
-        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) &entry, sizeof(persistent_ccc_entry_t));
-        if (len != sizeof(persistent_ccc_entry_t)) continue;
-        if (entry.device_index != le_device_index) continue;
+        persistent_ccc_index_entry_t * index_entry = &persistent_ccc_index[index];
+        if (!index_entry->valid) continue;
+        if (index_entry->entry.device_index != le_device_index) continue;
         // simulate write callback
-        uint16_t attribute_handle = entry.att_handle;
+        uint16_t attribute_handle = index_entry->entry.att_handle;
         uint8_t  value[2];
-        little_endian_store_16(value, 0, entry.value);
+        little_endian_store_16(value, 0, index_entry->entry.value);
+        att_server_subscription_update(att_server->connection.con_handle, attribute_handle, index_entry->entry.value);
         att_write_callback_t callback = att_server_write_callback_for_handle(attribute_handle);
         if (!callback) continue;
-        log_info("CCC Index %u: Set Attribute handle 0x%04x to value 0x%04x", index, attribute_handle, entry.value );
+        log_info("CCC Index %u: Set Attribute handle 0x%04x to value 0x%04x", index, attribute_handle, index_entry->entry.value );
         (*callback)(att_server->connection.con_handle, attribute_handle, ATT_TRANSACTION_MODE_NONE, 0, value, sizeof(value));
     }
 }
@@ -726,18 +993,151 @@ static void att_server_persistent_ccc_restore(att_server_t * att_server){
 // persistent CCC writes
 // ---------------------
 
+// ---------------------
+// CCC values of all connections
+static att_server_subscription_t * att_server_subscription_for_handle(hci_con_handle_t con_handle, uint16_t client_configuration_handle){
+    int i;
+    for (i=0;i<MAX_NR_ATT_SERVER_SUBSCRIPTIONS;i++){
+        att_server_subscription_t * subscription = &att_server_subscriptions[i];
+        if (subscription->con_handle != con_handle) continue;
+        if (subscription->client_configuration_handle != client_configuration_handle) continue;
+        return subscription;
+    }
+    return NULL;
+}
+
+// CCC writes are accepted if no subscription is available, client is then not notified by att_server_notify_subscribers
+static void att_server_subscription_update(hci_con_handle_t con_handle, uint16_t client_configuration_handle, uint16_t value){
+    att_server_subscription_t * subscription = att_server_subscription_for_handle(con_handle, client_configuration_handle);
+    if (value == 0){
+        if (!subscription) return;
+        subscription->con_handle = HCI_CON_HANDLE_INVALID;
+        subscription->client_configuration_handle = 0;
+        subscription->notification_pending = 0;
+        return;
+    }
+    if (!subscription){
+        subscription = att_server_subscription_for_handle(HCI_CON_HANDLE_INVALID, 0);
+        if (!subscription){
+            log_error("no free subscription for CCC handle 0x%04x, see MAX_NR_ATT_SERVER_SUBSCRIPTIONS", client_configuration_handle);
+            return;
+        }
+        subscription->con_handle = con_handle;
+        subscription->client_configuration_handle = client_configuration_handle;
+        subscription->value_handle = gatt_server_get_value_handle_for_client_configuration_handle(client_configuration_handle);
+        subscription->notification_pending = 0;
+    }
+    subscription->client_configuration = value;
+}
+
+static void att_server_subscriptions_remove_for_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MAX_NR_ATT_SERVER_SUBSCRIPTIONS;i++){
+        att_server_subscription_t * subscription = &att_server_subscriptions[i];
+        if (subscription->con_handle != con_handle) continue;
+        subscription->con_handle = HCI_CON_HANDLE_INVALID;
+        subscription->client_configuration_handle = 0;
+        subscription->notification_pending = 0;
+    }
+}
+
+// send current value of an attribute that could not be notified in att_server_notify_subscribers
+// returns 1 if notification was sent
+static int att_server_subscriptions_send_pending_notification(void){
+    int i;
+    for (i=0;i<MAX_NR_ATT_SERVER_SUBSCRIPTIONS;i++){
+        att_server_subscription_t * subscription = &att_server_subscriptions[i];
+        if (!subscription->notification_pending) continue;
+        hci_con_handle_t con_handle = subscription->con_handle;
+        att_server_t * att_server = att_server_for_handle(con_handle);
+        if (!att_server){
+            subscription->notification_pending = 0;
+            continue;
+        }
+        if (!att_dispatch_server_can_send_now(con_handle)){
+            att_dispatch_server_request_can_send_now_event(con_handle);
+            continue;
+        }
+        subscription->notification_pending = 0;
+        l2cap_reserve_packet_buffer();
+        uint8_t * packet_buffer = l2cap_get_outgoing_buffer();
+        uint16_t value_len = att_server_read_callback(con_handle, subscription->value_handle, 0, &packet_buffer[3], att_server->connection.mtu - 3);
+        packet_buffer[0] = ATT_HANDLE_VALUE_NOTIFICATION;
+        little_endian_store_16(packet_buffer, 1, subscription->value_handle);
+        l2cap_send_prepared_connectionless(con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, 3 + value_len);
+        // continue with other pending notifications and can send now clients
+        att_dispatch_server_request_can_send_now_event(con_handle);
+        return 1;
+    }
+    return 0;
+}
+// CCC values of all connections
+// ---------------------
+
 // gatt service management
+static att_service_handler_t * att_service_handler_for_handle_in_table(uint16_t handle){
+    int low  = 0;
+    int high = service_handler_table_count - 1;
+    while (low <= high){
+        int mid = (low + high) / 2;
+        att_service_handler_t * handler = service_handler_table[mid];
+        if (handler->end_handle < handle){
+            low = mid + 1;
+        } else if (handler->start_handle > handle){
+            high = mid - 1;
+        } else {
+            return handler;
+        }
+    }
+    return NULL;
+}
+
 static att_service_handler_t * att_service_handler_for_handle(uint16_t handle){
+    // O(1) lookup via static table
+    if (handle < service_index_num_handles){
+        uint8_t service_index = service_index_for_handle[handle];
+        if (service_index >= service_index_num_services) return NULL;
+        return service_handler_for_service_index[service_index];
+    }
+    att_service_handler_t * handler = att_service_handler_for_handle_in_table(handle);
+    if (handler) return handler;
+    if (!service_handler_table_overflow) return NULL;
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &service_handlers);
     while (btstack_linked_list_iterator_has_next(&it)){
-        att_service_handler_t * handler = (att_service_handler_t*) btstack_linked_list_iterator_next(&it);
+        handler = (att_service_handler_t*) btstack_linked_list_iterator_next(&it);
         if (handler->start_handle > handle) continue;
         if (handler->end_handle   < handle) continue;
         return handler;
     }
     return NULL;
 }
+
+static void att_service_handler_table_add(att_service_handler_t * handler){
+    if (service_handler_table_count >= MAX_NR_ATT_SERVICE_HANDLERS){
+        log_info("service handler table full, using linear search for 0x%04x-0x%04x", handler->start_handle, handler->end_handle);
+        service_handler_table_overflow = 1;
+        return;
+    }
+    // insertion sort by start handle
+    int pos = service_handler_table_count;
+    while (pos > 0 && service_handler_table[pos-1]->start_handle > handler->start_handle){
+        service_handler_table[pos] = service_handler_table[pos-1];
+        pos--;
+    }
+    service_handler_table[pos] = handler;
+    service_handler_table_count++;
+}
+
+static void att_service_index_table_add(att_service_handler_t * handler){
+    uint16_t handle;
+    for (handle = handler->start_handle; handle <= handler->end_handle && handle < service_index_num_handles; handle++){
+        uint8_t service_index = service_index_for_handle[handle];
+        if (service_index >= service_index_num_services) continue;
+        service_handler_for_service_index[service_index] = handler;
+    }
+}
+
 static att_read_callback_t att_server_read_callback_for_handle(uint16_t handle){
     att_service_handler_t * handler = att_service_handler_for_handle(handle);
     if (handler) return handler->read_callback;
@@ -797,7 +1197,9 @@ static int att_server_write_callback(hci_con_handle_t con_handle, uint16_t attri
 
     // track CCC writes
     if (att_is_persistent_ccc(attribute_handle) && offset == 0 && buffer_size == 2){
-        att_server_persistent_ccc_write(con_handle, attribute_handle, little_endian_read_16(buffer, 0));
+        uint16_t client_configuration = little_endian_read_16(buffer, 0);
+        att_server_subscription_update(con_handle, attribute_handle, client_configuration);
+        att_server_persistent_ccc_write(con_handle, attribute_handle, client_configuration);
     }
 
     att_write_callback_t callback = att_server_write_callback_for_handle(attribute_handle);
@@ -816,6 +1218,24 @@ void att_server_register_service_handler(att_service_handler_t * handler){
         return;
     }
     btstack_linked_list_add(&service_handlers, (btstack_linked_item_t*) handler);
+    att_service_handler_table_add(handler);
+    att_service_index_table_add(handler);
+}
+
+void att_server_set_service_index_table(const uint8_t * service_index_table, uint16_t num_handles,
+    att_service_handler_t ** handler_for_service_index, uint8_t num_services){
+    service_index_for_handle          = service_index_table;
+    service_index_num_handles         = num_handles;
+    service_handler_for_service_index = handler_for_service_index;
+    service_index_num_services        = num_services;
+    memset(handler_for_service_index, 0, num_services * sizeof(att_service_handler_t *));
+    // add already registered handlers
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &service_handlers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        att_service_handler_t * handler = (att_service_handler_t*) btstack_linked_list_iterator_next(&it);
+        att_service_index_table_add(handler);
+    }
 }
 
 void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_write_callback_t write_callback){
@@ -824,6 +1244,14 @@ void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_
     att_server_client_read_callback  = read_callback;
     att_server_client_write_callback = write_callback;
 
+    int i;
+    for (i=0;i<MAX_NR_ATT_SERVER_SUBSCRIPTIONS;i++){
+        att_server_subscriptions[i].con_handle = HCI_CON_HANDLE_INVALID;
+        att_server_subscriptions[i].client_configuration_handle = 0;
+        att_server_subscriptions[i].notification_pending = 0;
+    }
+    persistent_ccc_index_loaded = 0;
+
     // register for HCI Events
     hci_event_callback_registration.callback = &att_event_packet_handler;
     hci_add_event_handler(&hci_event_callback_registration);
@@ -841,6 +1269,24 @@ void att_server_init(uint8_t const * db, att_read_callback_t read_callback, att_
 
 }
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+void att_server_register_write_stream(att_server_write_stream_t * stream, uint16_t attribute_handle, att_write_stream_callback_t callback){
+    stream->attribute_handle = attribute_handle;
+    stream->callback = callback;
+    btstack_linked_list_add(&write_streams, (btstack_linked_item_t *) stream);
+}
+
+void att_server_write_stream_resume(hci_con_handle_t con_handle){
+    att_server_t * att_server = att_server_for_handle(con_handle);
+    if (!att_server) return;
+    if (!att_server->write_stream_paused) return;
+    att_server_write_stream_set_paused(att_server, 0);
+    att_server_write_stream_deliver(att_server);
+    // process PDU received while paused
+    att_run_for_context(att_server);
+}
+#endif
+
 void att_server_register_packet_handler(btstack_packet_handler_t handler){
     att_client_packet_handler = handler;    
 }
@@ -882,6 +1328,34 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, ui
 	return l2cap_send_prepared_connectionless(att_server->connection.con_handle, L2CAP_CID_ATTRIBUTE_PROTOCOL, size);
 }
 
+uint16_t att_server_get_client_configuration(hci_con_handle_t con_handle, uint16_t client_configuration_handle){
+    att_server_subscription_t * subscription = att_server_subscription_for_handle(con_handle, client_configuration_handle);
+    if (!subscription) return 0;
+    return subscription->client_configuration;
+}
+
+int att_server_notify_subscribers(uint16_t attribute_handle, uint8_t *value, uint16_t value_len){
+    int status = 0;
+    int i;
+    for (i=0;i<MAX_NR_ATT_SERVER_SUBSCRIPTIONS;i++){
+        att_server_subscription_t * subscription = &att_server_subscriptions[i];
+        if (subscription->con_handle == HCI_CON_HANDLE_INVALID) continue;
+        if (subscription->value_handle != attribute_handle) continue;
+        if ((subscription->client_configuration & GATT_CLIENT_CHARACTERISTICS_CONFIGURATION_NOTIFICATION) == 0) continue;
+        // dynamic attribute: send current value when ACL buffers become available
+        if (!att_dispatch_server_can_send_now(subscription->con_handle) && att_is_dynamic(attribute_handle)){
+            subscription->notification_pending = 1;
+            att_dispatch_server_request_can_send_now_event(subscription->con_handle);
+            continue;
+        }
+        int err = att_server_notify(subscription->con_handle, attribute_handle, value, value_len);
+        if (err){
+            status = err;
+        }
+    }
+    return status;
+}
+
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t *value, uint16_t value_len){
     att_server_t * att_server = att_server_for_handle(con_handle);
     if (!att_server) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
@@ -45,6 +45,24 @@
 extern "C" {
 #endif
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+/*
+ * @brief Write Stream callback, called with the concatenated values of consecutive Write Commands
+ * @param con_handle
+ * @param attribute_handle
+ * @param data
+ * @param size
+ * @returns number of bytes consumed. If less than size, the stream is paused until att_server_write_stream_resume is called
+ */
+typedef uint16_t (*att_write_stream_callback_t)(hci_con_handle_t con_handle, uint16_t attribute_handle, const uint8_t * data, uint16_t size);
+
+typedef struct {
+    btstack_linked_item_t item;
+    uint16_t attribute_handle;
+    att_write_stream_callback_t callback;
+} att_server_write_stream_t;
+#endif
+
 /* API_START */
 /*
  * @brief setup ATT server
@@ -69,6 +87,17 @@ void att_server_register_packet_handler(btstack_packet_handler_t handler);
  */
 void att_server_register_service_handler(att_service_handler_t * handler);
 
+/**
+ * @brief provide static table that maps each attribute handle to the index of its service for O(1) lookup of service handlers
+ * @note table is created by compile_gatt.py with --service-index-table. Service handler ranges need to match service boundaries
+ * @param service_index_for_handle table with service index for each handle, ATT_SERVICE_INDEX_NONE for handles outside of services
+ * @param num_handles size of table
+ * @param handler_for_service_index storage for one handler per service, filled by ATT Server
+ * @param num_services size of storage
+ */
+void att_server_set_service_index_table(const uint8_t * service_index_for_handle, uint16_t num_handles,
+    att_service_handler_t ** handler_for_service_index, uint8_t num_services);
+
 /*
  * @brief tests if a notification or indication can be send right now
  * @param con_handle
@@ -87,6 +116,7 @@ void att_server_request_can_send_now_event(hci_con_handle_t con_handle);
 /** 
  * @brief Request callback when sending is possible
  * @note callback might happend during call to this function
+ * @note registration is removed on disconnect
  * @param callback_registration to point to callback function and context information
  * @param con_handle
  */
@@ -112,6 +142,26 @@ int att_server_notify(hci_con_handle_t con_handle, uint16_t attribute_handle, ui
  */
 int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle, uint8_t *value, uint16_t value_len);
 
+/*
+ * @brief get Client Characteristic Configuration written by client, CCC values of bonded clients are restored on reconnect
+ * @param con_handle
+ * @param client_configuration_handle
+ * @return value, 0 if not configured or not tracked, see MAX_NR_ATT_SERVER_SUBSCRIPTIONS
+ */
+uint16_t att_server_get_client_configuration(hci_con_handle_t con_handle, uint16_t client_configuration_handle);
+
+/*
+ * @brief notify all clients that enabled notifications for an attribute, see MAX_NR_ATT_SERVER_SUBSCRIPTIONS
+ * @note if ACL buffers are full, the current value of a dynamic attribute is read via its read callback and sent later,
+ *       for a static attribute, BTSTACK_ACL_BUFFERS_FULL is returned
+ * @note clients that enabled notifications while all MAX_NR_ATT_SERVER_SUBSCRIPTIONS were in use are not notified
+ * @param attribute_handle of characteristic value
+ * @param value
+ * @param value_len
+ * @return 0 if ok, error of last client that could not be notified otherwise
+ */
+int att_server_notify_subscribers(uint16_t attribute_handle, uint8_t *value, uint16_t value_len);
+
 #ifdef ENABLE_ATT_DELAYED_READ_RESPONSE
 /*
  * @brief read response ready - called after returning ATT_READ_RESPONSE_PENDING in an att_read_callback before
@@ -122,6 +172,30 @@ int att_server_indicate(hci_con_handle_t con_handle, uint16_t attribute_handle,
 int att_server_read_response_ready(hci_con_handle_t con_handle);
 #endif
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+/*
+ * @brief Register Write Stream for characteristic value. Write Commands for it are collected in a buffer per connection
+ *        of size ATT_SERVER_WRITE_STREAM_BUFFER_SIZE and delivered in batches instead of calling the write callback for each.
+ *        Buffered data is delivered if the next PDU might not fit, if no Write Command was received for
+ *        ATT_SERVER_WRITE_STREAM_FLUSH_MS, and before any other ATT PDU is processed.
+ * @note Attribute needs to be DYNAMIC with WRITE_WITHOUT_RESPONSE property. Write Requests are handled by the write callback
+ * @note If ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL is defined, the Controller stops receiving on the connection while the stream
+ *       is paused. Without it, pausing does not throttle the client: Write Commands that don't fit into the buffer are dropped
+ * @note While the stream is paused, one other PDU is kept and processed after the buffered data was delivered. Further PDUs are
+ *       dropped, and Write Commands to the stream received after it are delivered before it
+ * @param stream storage
+ * @param attribute_handle
+ * @param callback
+ */
+void att_server_register_write_stream(att_server_write_stream_t * stream, uint16_t attribute_handle, att_write_stream_callback_t callback);
+
+/*
+ * @brief Resume paused Write Stream and deliver buffered data
+ * @param con_handle
+ */
+void att_server_write_stream_resume(hci_con_handle_t con_handle);
+#endif
+
 /* API_END */
 
 #if defined __cplusplus
@@ -50,19 +50,15 @@
 
 #include "ble/gatt-service/battery_service_server.h"
 
-static btstack_context_callback_registration_t  battery_callback;
 static att_service_handler_t       battery_service;
 
 static uint8_t 	battery_value;
-static uint16_t battery_value_client_configuration;
-static hci_con_handle_t battery_value_client_configuration_connection;
 
 static uint16_t battery_value_handle_value;
 static uint16_t battery_value_handle_client_configuration;
 
 
 static uint16_t battery_service_read_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
-	UNUSED(con_handle);
 	UNUSED(offset);
 	UNUSED(buffer_size);
 
@@ -74,30 +70,13 @@ static uint16_t battery_service_read_callback(hci_con_handle_t con_handle, uint1
 	}
 	if (attribute_handle == battery_value_handle_client_configuration){
 		if (buffer){
-			little_endian_store_16(buffer, 0, battery_value_client_configuration);
+			little_endian_store_16(buffer, 0, att_server_get_client_configuration(con_handle, attribute_handle));
 		}
 		return 2;
 	}
 	return 0;
 }
 
-static int battery_service_write_callback(hci_con_handle_t con_handle, uint16_t attribute_handle, uint16_t transaction_mode, uint16_t offset, uint8_t *buffer, uint16_t buffer_size){
-	UNUSED(transaction_mode);
-	UNUSED(offset);
-	UNUSED(buffer_size);
-
-	if (attribute_handle == battery_value_handle_client_configuration){
-		battery_value_client_configuration = little_endian_read_16(buffer, 0);
-		battery_value_client_configuration_connection = con_handle;
-	}
-	return 0;
-}
-
-static void battery_service_can_send_now(void * context){
-	hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) context;
-	att_server_notify(con_handle, battery_value_handle_value, &battery_value, 1);
-}
-
 void battery_service_server_init(uint8_t value){
 
 	battery_value = value;
@@ -116,15 +95,12 @@ void battery_service_server_init(uint8_t value){
 	battery_service.start_handle   = start_handle;
 	battery_service.end_handle     = end_handle;
 	battery_service.read_callback  = &battery_service_read_callback;
-	battery_service.write_callback = &battery_service_write_callback;
+	battery_service.write_callback = NULL;
 	att_server_register_service_handler(&battery_service);
 }
 
 void battery_service_server_set_battery_value(uint8_t value){
 	battery_value = value;
-	if (battery_value_client_configuration){
-		battery_callback.callback = &battery_service_can_send_now;
-		battery_callback.context  = (void*) (uintptr_t) battery_value_client_configuration_connection;
-		att_server_register_can_send_now_callback(&battery_callback, battery_value_client_configuration_connection);
-	}
+	// CCC is tracked by ATT Server, value is read via battery_service_read_callback if ACL buffers are full
+	att_server_notify_subscribers(battery_value_handle_value, &battery_value, 1);
 }
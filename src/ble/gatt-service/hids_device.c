@@ -42,6 +42,10 @@
  * To use with your application, add '#import <hids.gatt>' to your .gatt file
  */
 
+#include "btstack_config.h"
+
+#include <string.h>
+
 #include "hids_device.h"
 
 #include "ble/att_db.h"
@@ -49,32 +53,85 @@
 #include "bluetooth_gatt.h"
 #include "btstack_util.h"
 #include "btstack_debug.h"
+#include "btstack_event.h"
+#include "hci.h"
+
+// number of host connections with separate protocol mode and client configuration
+#ifndef MAX_NR_HIDS_DEVICE_CONNECTIONS
+#define MAX_NR_HIDS_DEVICE_CONNECTIONS 1
+#endif
+
+// size of input report queue per connection, each report uses 2 additional bytes
+#ifndef HIDS_DEVICE_REPORT_QUEUE_SIZE
+#define HIDS_DEVICE_REPORT_QUEUE_SIZE 64
+#endif
+
+typedef enum {
+    HIDS_DEVICE_REPORT_INPUT,
+    HIDS_DEVICE_REPORT_BOOT_MOUSE_INPUT,
+    HIDS_DEVICE_REPORT_BOOT_KEYBOARD_INPUT,
+} hids_device_report_t;
+
+// state per host connection, CCC values are tracked by the ATT Server
+typedef struct {
+    hci_con_handle_t con_handle;
+    uint8_t          protocol_mode;
+
+    btstack_context_callback_registration_t can_send_now_callback;
+
+    // queued input reports: report type, report len, report
+    btstack_context_callback_registration_t report_queue_callback;
+    uint16_t         report_queue_len;
+    uint8_t          report_queue[HIDS_DEVICE_REPORT_QUEUE_SIZE];
+} hids_device_connection_t;
 
 static btstack_packet_handler_t packet_handler;
-static btstack_context_callback_registration_t  battery_callback;
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static hids_device_connection_t hids_device_connections[MAX_NR_HIDS_DEVICE_CONNECTIONS];
 
 static uint8_t         hid_country_code;
 static const uint8_t * hid_descriptor;
 static uint16_t        hid_descriptor_size;
 
 static uint16_t        hid_report_map_handle;
-static uint16_t        hid_protocol_mode;
 static uint16_t        hid_protocol_mode_value_handle;
 
 static uint16_t        hid_boot_mouse_input_value_handle;
 static uint16_t        hid_boot_mouse_input_client_configuration_handle;
-static uint16_t        hid_boot_mouse_input_client_configuration_value;
 
 static uint16_t        hid_boot_keyboard_input_value_handle;
 static uint16_t        hid_boot_keyboard_input_client_configuration_handle;
-static uint16_t        hid_boot_keyboard_input_client_configuration_value;
 
 static uint16_t        hid_report_input_value_handle;
 static uint16_t        hid_report_input_client_configuration_handle;
-static uint16_t        hid_report_input_client_configuration_value;
 
 static att_service_handler_t hid_service;
 
+static hids_device_connection_t * hids_device_connection_for_con_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MAX_NR_HIDS_DEVICE_CONNECTIONS;i++){
+        if (hids_device_connections[i].con_handle == con_handle) return &hids_device_connections[i];
+    }
+    return NULL;
+}
+
+static hids_device_connection_t * hids_device_connection_create(hci_con_handle_t con_handle){
+    hids_device_connection_t * connection = hids_device_connection_for_con_handle(con_handle);
+    if (connection) return connection;
+    connection = hids_device_connection_for_con_handle(HCI_CON_HANDLE_INVALID);
+    if (!connection) {
+        log_error("hids_device: no free connection for con handle 0x%04x", con_handle);
+        return NULL;
+    }
+    // can send now registrations have been removed by ATT Server on disconnect, don't clear them while linked
+    connection->con_handle    = con_handle;
+    connection->report_queue_len = 0;
+    // default: report protocol mode
+    connection->protocol_mode = 1;
+    return connection;
+}
+
 static void hids_device_emit_event_with_uint8(uint8_t event, hci_con_handle_t con_handle, uint8_t value){
     if (!packet_handler) return;
     uint8_t buffer[6];
@@ -98,15 +155,84 @@ static void hids_device_can_send_now(void * context){
     (*packet_handler)(HCI_EVENT_PACKET, 0, buffer, sizeof(buffer));
 }
 
+static uint16_t hids_device_value_handle_for_report(hids_device_report_t report){
+    switch (report){
+        case HIDS_DEVICE_REPORT_BOOT_MOUSE_INPUT:
+            return hid_boot_mouse_input_value_handle;
+        case HIDS_DEVICE_REPORT_BOOT_KEYBOARD_INPUT:
+            return hid_boot_keyboard_input_value_handle;
+        default:
+            return hid_report_input_value_handle;
+    }
+}
+
+static void hids_device_report_queue_send(void * context){
+    hci_con_handle_t con_handle = (hci_con_handle_t) (uintptr_t) context;
+    hids_device_connection_t * connection = hids_device_connection_for_con_handle(con_handle);
+    if (!connection) return;
+
+    // send as many queued reports as possible
+    uint16_t pos = 0;
+    while (pos < connection->report_queue_len){
+        if (!att_server_can_send_packet_now(con_handle)) break;
+        hids_device_report_t report = (hids_device_report_t) connection->report_queue[pos];
+        uint8_t report_len = connection->report_queue[pos+1];
+        att_server_notify(con_handle, hids_device_value_handle_for_report(report), &connection->report_queue[pos+2], report_len);
+        pos += 2 + report_len;
+    }
+
+    // keep remaining reports
+    connection->report_queue_len -= pos;
+    memmove(connection->report_queue, &connection->report_queue[pos], connection->report_queue_len);
+    if (connection->report_queue_len == 0) return;
+    connection->report_queue_callback.callback = &hids_device_report_queue_send;
+    att_server_register_can_send_now_callback(&connection->report_queue_callback, con_handle);
+}
+
+static int hids_device_report_queue_add(hci_con_handle_t con_handle, hids_device_report_t report, const uint8_t * data, uint16_t data_len){
+    if (gap_get_connection_type(con_handle) == GAP_CONNECTION_INVALID) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    hids_device_connection_t * connection = hids_device_connection_create(con_handle);
+    if (!connection) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    if (data_len > 0xff) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (connection->report_queue_len + 2 + data_len > HIDS_DEVICE_REPORT_QUEUE_SIZE) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    // first report triggers can send now request, following ones are sent in the same cycle
+    int request_can_send_now = connection->report_queue_len == 0;
+    connection->report_queue[connection->report_queue_len]   = (uint8_t) report;
+    connection->report_queue[connection->report_queue_len+1] = (uint8_t) data_len;
+    memcpy(&connection->report_queue[connection->report_queue_len+2], data, data_len);
+    connection->report_queue_len += 2 + data_len;
+
+    if (request_can_send_now){
+        connection->report_queue_callback.callback = &hids_device_report_queue_send;
+        att_server_register_can_send_now_callback(&connection->report_queue_callback, con_handle);
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+static void hids_device_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_DISCONNECTION_COMPLETE) return;
+    hids_device_connection_t * connection = hids_device_connection_for_con_handle(hci_event_disconnection_complete_get_connection_handle(packet));
+    if (!connection) return;
+    // ATT Server drops can send now registrations for this connection
+    connection->con_handle = HCI_CON_HANDLE_INVALID;
+    connection->report_queue_len = 0;
+}
+
 // ATT Client Read Callback for Dynamic Data
 // - if buffer == NULL, don't copy data, just return size of value
 // - if buffer != NULL, copy data and return number bytes copied
 static uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t att_handle, uint16_t offset, uint8_t * buffer, uint16_t buffer_size){
-    UNUSED(connection_handle);
+    // connections without state use default report protocol mode
+    hids_device_connection_t * connection = hids_device_connection_for_con_handle(connection_handle);
+    uint8_t  protocol_mode = connection ? connection->protocol_mode : 1;
 
     if (att_handle == hid_protocol_mode_value_handle){
         log_info("Read protocol mode");
-        return att_read_callback_handle_byte(hid_protocol_mode, offset, buffer, buffer_size);
+        return att_read_callback_handle_byte(protocol_mode, offset, buffer, buffer_size);
     }
     if (att_handle == hid_report_map_handle){
         log_info("Read report map");
@@ -115,17 +241,17 @@ static uint16_t att_read_callback(hci_con_handle_t connection_handle, uint16_t a
     // if (att_handle == hid_boot_mouse_input_value_handle){
     // }
     if (att_handle == hid_boot_mouse_input_client_configuration_handle){
-        return att_read_callback_handle_little_endian_16(hid_boot_keyboard_input_client_configuration_value, offset, buffer, buffer_size);
+        return att_read_callback_handle_little_endian_16(att_server_get_client_configuration(connection_handle, att_handle), offset, buffer, buffer_size);
     }
     // if (att_handle == hid_boot_keyboard_input_value_handle){
     // }
     if (att_handle == hid_boot_keyboard_input_client_configuration_handle){
-        return att_read_callback_handle_little_endian_16(hid_boot_keyboard_input_client_configuration_value, offset, buffer, buffer_size);
+        return att_read_callback_handle_little_endian_16(att_server_get_client_configuration(connection_handle, att_handle), offset, buffer, buffer_size);
     }
     // if (att_handle == hid_report_input_value_handle){
     // }
     if (att_handle == hid_report_input_client_configuration_handle){
-        return att_read_callback_handle_little_endian_16(hid_report_input_client_configuration_value, offset, buffer, buffer_size);
+        return att_read_callback_handle_little_endian_16(att_server_get_client_configuration(connection_handle, att_handle), offset, buffer, buffer_size);
     }
     return 0;
 }
@@ -135,29 +261,25 @@ static int att_write_callback(hci_con_handle_t con_handle, uint16_t att_handle,
     UNUSED(buffer_size);
     UNUSED(offset);
 
+    if (att_handle == 0) return 0;
+
+    hids_device_connection_t * connection = hids_device_connection_create(con_handle);
+    if (!connection) return ATT_ERROR_INSUFFICIENT_RESOURCES;
+
     if (att_handle == hid_boot_mouse_input_client_configuration_handle){
-        uint16_t new_value = little_endian_read_16(buffer, 0);
-        // if (new_value == hid_boot_mouse_input_client_configuration_value) return 0;
-        hid_boot_mouse_input_client_configuration_value = new_value;
-        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_BOOT_MOUSE_INPUT_REPORT_ENABLE, con_handle, hid_protocol_mode);
+        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_BOOT_MOUSE_INPUT_REPORT_ENABLE, con_handle, connection->protocol_mode);
     }
     if (att_handle == hid_boot_keyboard_input_client_configuration_handle){
-        uint16_t new_value = little_endian_read_16(buffer, 0);
-        // if (new_value == hid_boot_keyboard_input_client_configuration_value) return 0;
-        hid_boot_keyboard_input_client_configuration_value = new_value;
-        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_BOOT_KEYBOARD_INPUT_REPORT_ENABLE, con_handle, hid_protocol_mode);
+        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_BOOT_KEYBOARD_INPUT_REPORT_ENABLE, con_handle, connection->protocol_mode);
     }
     if (att_handle == hid_report_input_client_configuration_handle){
-        uint16_t new_value = little_endian_read_16(buffer, 0);
-        // if (new_value == hid_report_input_client_configuration_value) return 0;
-        hid_report_input_client_configuration_value = new_value;
-        log_info("Enable Report Input notifications: %x", new_value);
-        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_INPUT_REPORT_ENABLE, con_handle, hid_protocol_mode);
+        log_info("Enable Report Input notifications: %x", little_endian_read_16(buffer, 0));
+        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_INPUT_REPORT_ENABLE, con_handle, connection->protocol_mode);
     }
     if (att_handle == hid_protocol_mode_value_handle){
-        hid_protocol_mode = buffer[0];
-        log_info("Set protocol mode: %u", hid_protocol_mode);
-        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_PROTOCOL_MODE, con_handle, hid_protocol_mode);
+        connection->protocol_mode = buffer[0];
+        log_info("Set protocol mode: %u", connection->protocol_mode);
+        hids_device_emit_event_with_uint8(HIDS_SUBEVENT_PROTOCOL_MODE, con_handle, connection->protocol_mode);
     }
     return 0;
 }
@@ -171,8 +293,10 @@ void hids_device_init(uint8_t country_code, const uint8_t * descriptor, uint16_t
     hid_descriptor      = descriptor;
     hid_descriptor_size = descriptor_size;
 
-    // default
-    hid_protocol_mode   = 1;
+    int i;
+    for (i=0;i<MAX_NR_HIDS_DEVICE_CONNECTIONS;i++){
+        hids_device_connections[i].con_handle = HCI_CON_HANDLE_INVALID;
+    }
 
     // get service handle range
     uint16_t start_handle = 0;
@@ -202,6 +326,10 @@ void hids_device_init(uint8_t country_code, const uint8_t * descriptor, uint16_t
     hid_service.read_callback  = &att_read_callback;
     hid_service.write_callback = &att_write_callback;
     att_server_register_service_handler(&hid_service);
+
+    // release connection state on disconnect
+    hci_event_callback_registration.callback = &hids_device_packet_handler;
+    hci_add_event_handler(&hci_event_callback_registration);
 }
 
 /**
@@ -218,9 +346,10 @@ void hids_device_register_packet_handler(btstack_packet_handler_t callback){
  * @param hid_cid
  */
 void hids_device_request_can_send_now_event(hci_con_handle_t con_handle){
-    battery_callback.callback = &hids_device_can_send_now;
-    battery_callback.context  = (void*) (uintptr_t) con_handle;
-    att_server_register_can_send_now_callback(&battery_callback, con_handle);
+    hids_device_connection_t * connection = hids_device_connection_create(con_handle);
+    if (!connection) return;
+    connection->can_send_now_callback.callback = &hids_device_can_send_now;
+    att_server_register_can_send_now_callback(&connection->can_send_now_callback, con_handle);
 }
 
 /**
@@ -243,3 +372,24 @@ void hids_device_send_boot_mouse_input_report(hci_con_handle_t con_handle, const
 void hids_device_send_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
     att_server_notify(con_handle, hid_boot_keyboard_input_value_handle, (uint8_t*) report, report_len);
 }
+
+/**
+ * @brief Queue HID Report: Input
+ */
+int hids_device_queue_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_report_queue_add(con_handle, HIDS_DEVICE_REPORT_INPUT, report, report_len);
+}
+
+/**
+ * @brief Queue HID Boot Mouse Input Report
+ */
+int hids_device_queue_boot_mouse_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_report_queue_add(con_handle, HIDS_DEVICE_REPORT_BOOT_MOUSE_INPUT, report, report_len);
+}
+
+/**
+ * @brief Queue HID Boot Keyboard Input Report
+ */
+int hids_device_queue_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len){
+    return hids_device_report_queue_add(con_handle, HIDS_DEVICE_REPORT_BOOT_KEYBOARD_INPUT, report, report_len);
+}
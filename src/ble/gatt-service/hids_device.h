@@ -76,3 +76,23 @@ void hids_device_send_boot_mouse_input_report(hci_con_handle_t con_handle, const
  * @brief Send HID Boot Mouse Input Report
  */
 void hids_device_send_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Queue HID Report: Input. All reports queued for a connection are sent back-to-back
+ *        as soon as possible in a single can send now cycle, see HIDS_DEVICE_REPORT_QUEUE_SIZE
+ * @param con_handle
+ * @param report
+ * @param report_len
+ * @return 0 if ok, ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if queue is full
+ */
+int hids_device_queue_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Queue HID Boot Mouse Input Report, see hids_device_queue_input_report
+ */
+int hids_device_queue_boot_mouse_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
+
+/**
+ * @brief Queue HID Boot Keyboard Input Report, see hids_device_queue_input_report
+ */
+int hids_device_queue_boot_keyboard_input_report(hci_con_handle_t con_handle, const uint8_t * report, uint16_t report_len);
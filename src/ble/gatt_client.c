@@ -809,6 +809,172 @@ static void trigger_next_blob_query(gatt_client_t * peripheral, gatt_client_stat
 }
 
 
+// MARK: whole database discovery
+
+static void gatt_client_database_complete(gatt_client_t * peripheral, uint8_t status){
+    gatt_client_handle_transaction_complete(peripheral);
+    emit_gatt_complete_event(peripheral, status);
+}
+
+static uint16_t gatt_client_database_read_uuid(const uint8_t * data, uint16_t uuid_length, uint8_t * uuid128){
+    if (uuid_length == 2){
+        uint16_t uuid16 = little_endian_read_16(data, 0);
+        uuid_add_bluetooth_prefix(uuid128, uuid16);
+        return uuid16;
+    }
+    reverse_128(data, uuid128);
+    if (uuid_has_bluetooth_prefix(uuid128)){
+        return big_endian_read_32(uuid128, 0);
+    }
+    return 0;
+}
+
+// query descriptors of next characteristic with handles after its value handle
+static void gatt_client_database_next_descriptor_query(gatt_client_t * peripheral){
+    gatt_client_database_t * database = peripheral->database;
+    while (peripheral->database_index < database->num_characteristics){
+        gatt_client_characteristic_t * characteristic = &database->characteristics[peripheral->database_index].characteristic;
+        if (characteristic->value_handle < characteristic->end_handle){
+            peripheral->start_group_handle = characteristic->value_handle + 1;
+            peripheral->end_group_handle   = characteristic->end_handle;
+            peripheral->gatt_client_state  = P_W2_SEND_DATABASE_DESCRIPTOR_QUERY;
+            return;
+        }
+        peripheral->database_index++;
+    }
+    gatt_client_database_complete(peripheral, 0);
+}
+
+static void gatt_client_database_services_done(gatt_client_t * peripheral){
+    gatt_client_database_t * database = peripheral->database;
+    if (database->num_services == 0){
+        gatt_client_database_complete(peripheral, 0);
+        return;
+    }
+    // single sequence of Read By Type requests for characteristics of all services
+    peripheral->start_group_handle = database->services[0].service.start_group_handle;
+    peripheral->end_group_handle   = database->services[database->num_services - 1].service.end_group_handle;
+    peripheral->database_index     = 0;
+    peripheral->gatt_client_state  = P_W2_SEND_DATABASE_CHARACTERISTIC_QUERY;
+}
+
+static void gatt_client_database_characteristics_done(gatt_client_t * peripheral){
+    peripheral->database_index = 0;
+    gatt_client_database_next_descriptor_query(peripheral);
+}
+
+static void gatt_client_database_handle_services(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    gatt_client_database_t * database = peripheral->database;
+    uint8_t attr_length = packet[1];
+    if (attr_length < 6){
+        gatt_client_database_complete(peripheral, ATT_ERROR_INVALID_PDU);
+        return;
+    }
+    int i;
+    for (i = 2; i + attr_length <= size; i += attr_length){
+        if (database->num_services >= database->max_services){
+            gatt_client_database_complete(peripheral, ATT_ERROR_INSUFFICIENT_RESOURCES);
+            return;
+        }
+        gatt_client_database_service_t * entry = &database->services[database->num_services++];
+        entry->service.start_group_handle = little_endian_read_16(packet, i);
+        entry->service.end_group_handle   = little_endian_read_16(packet, i + 2);
+        entry->service.uuid16 = gatt_client_database_read_uuid(&packet[i + 4], attr_length - 4, entry->service.uuid128);
+        entry->first_characteristic = 0;
+        entry->num_characteristics  = 0;
+    }
+    uint16_t last_result_handle = get_last_result_handle_from_service_list(packet, size);
+    if (is_query_done(peripheral, last_result_handle)){
+        gatt_client_database_services_done(peripheral);
+        return;
+    }
+    peripheral->start_group_handle = last_result_handle + 1;
+    peripheral->gatt_client_state  = P_W2_SEND_DATABASE_SERVICE_QUERY;
+}
+
+static void gatt_client_database_handle_characteristics(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    gatt_client_database_t * database = peripheral->database;
+    uint8_t attr_length = packet[1];
+    if (attr_length < 7){
+        gatt_client_database_complete(peripheral, ATT_ERROR_INVALID_PDU);
+        return;
+    }
+    int i;
+    for (i = 2; i + attr_length <= size; i += attr_length){
+        uint16_t start_handle = little_endian_read_16(packet, i);
+        // services are sorted by handle, skip services that end before the declaration
+        while (peripheral->database_index < database->num_services &&
+               database->services[peripheral->database_index].service.end_group_handle < start_handle){
+            peripheral->database_index++;
+        }
+        if (peripheral->database_index >= database->num_services) break;
+        gatt_client_database_service_t * service = &database->services[peripheral->database_index];
+        // declaration between primary services, e.g. in secondary service
+        if (start_handle < service->service.start_group_handle) continue;
+
+        if (database->num_characteristics >= database->max_characteristics){
+            gatt_client_database_complete(peripheral, ATT_ERROR_INSUFFICIENT_RESOURCES);
+            return;
+        }
+        if (service->num_characteristics){
+            // previous characteristic of this service ends before this declaration
+            database->characteristics[database->num_characteristics - 1].characteristic.end_handle = start_handle - 1;
+        } else {
+            service->first_characteristic = database->num_characteristics;
+        }
+        service->num_characteristics++;
+
+        gatt_client_database_characteristic_t * entry = &database->characteristics[database->num_characteristics++];
+        entry->characteristic.start_handle = start_handle;
+        entry->characteristic.properties   = packet[i + 2];
+        entry->characteristic.value_handle = little_endian_read_16(packet, i + 3);
+        entry->characteristic.end_handle   = service->service.end_group_handle;
+        entry->characteristic.uuid16 = gatt_client_database_read_uuid(&packet[i + 5], attr_length - 5, entry->characteristic.uuid128);
+        entry->first_descriptor = 0;
+        entry->num_descriptors  = 0;
+    }
+    uint16_t last_result_handle = get_last_result_handle_from_characteristics_list(packet, size);
+    if (is_query_done(peripheral, last_result_handle)){
+        gatt_client_database_characteristics_done(peripheral);
+        return;
+    }
+    peripheral->start_group_handle = last_result_handle + 1;
+    peripheral->gatt_client_state  = P_W2_SEND_DATABASE_CHARACTERISTIC_QUERY;
+}
+
+static void gatt_client_database_handle_descriptors(gatt_client_t * peripheral, uint8_t * packet, uint16_t size){
+    gatt_client_database_t * database = peripheral->database;
+    gatt_client_database_characteristic_t * characteristic = &database->characteristics[peripheral->database_index];
+    uint8_t pair_size = 4;
+    if (packet[1] == 2){
+        pair_size = 18;
+    }
+    uint16_t last_result_handle = peripheral->end_group_handle;
+    int i;
+    for (i = 2; i + pair_size <= size; i += pair_size){
+        if (database->num_descriptors >= database->max_descriptors){
+            gatt_client_database_complete(peripheral, ATT_ERROR_INSUFFICIENT_RESOURCES);
+            return;
+        }
+        if (characteristic->num_descriptors == 0){
+            characteristic->first_descriptor = database->num_descriptors;
+        }
+        characteristic->num_descriptors++;
+
+        gatt_client_characteristic_descriptor_t * descriptor = &database->descriptors[database->num_descriptors++];
+        descriptor->handle = little_endian_read_16(packet, i);
+        descriptor->uuid16 = gatt_client_database_read_uuid(&packet[i + 2], pair_size - 2, descriptor->uuid128);
+        last_result_handle = descriptor->handle;
+    }
+    if (is_query_done(peripheral, last_result_handle)){
+        peripheral->database_index++;
+        gatt_client_database_next_descriptor_query(peripheral);
+        return;
+    }
+    peripheral->start_group_handle = last_result_handle + 1;
+    peripheral->gatt_client_state  = P_W2_SEND_DATABASE_DESCRIPTOR_QUERY;
+}
+
 static int is_value_valid(gatt_client_t *peripheral, uint8_t *packet, uint16_t size){
     uint16_t attribute_handle = little_endian_read_16(packet, 1);
     uint16_t value_offset = little_endian_read_16(packet, 3);
@@ -879,6 +1045,21 @@ static int gatt_client_run_for_peripheral( gatt_client_t * peripheral){
             send_gatt_characteristic_descriptor_request(peripheral);
             return 1;
 
+        case P_W2_SEND_DATABASE_SERVICE_QUERY:
+            peripheral->gatt_client_state = P_W4_DATABASE_SERVICE_QUERY_RESULT;
+            send_gatt_services_request(peripheral);
+            return 1;
+
+        case P_W2_SEND_DATABASE_CHARACTERISTIC_QUERY:
+            peripheral->gatt_client_state = P_W4_DATABASE_CHARACTERISTIC_QUERY_RESULT;
+            send_gatt_characteristic_request(peripheral);
+            return 1;
+
+        case P_W2_SEND_DATABASE_DESCRIPTOR_QUERY:
+            peripheral->gatt_client_state = P_W4_DATABASE_DESCRIPTOR_QUERY_RESULT;
+            send_gatt_characteristic_descriptor_request(peripheral);
+            return 1;
+
         case P_W2_SEND_INCLUDED_SERVICE_QUERY:
             peripheral->gatt_client_state = P_W4_INCLUDED_SERVICE_QUERY_RESULT;
             send_gatt_included_service_request(peripheral);
@@ -1130,6 +1311,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     trigger_next_service_query(peripheral, get_last_result_handle_from_service_list(packet, size));
                     // GATT_EVENT_QUERY_COMPLETE is emitted by trigger_next_xxx when done
                     break;
+                case P_W4_DATABASE_SERVICE_QUERY_RESULT:
+                    gatt_client_database_handle_services(peripheral, packet, size);
+                    break;
                 default:
                     break;
             }
@@ -1151,6 +1335,9 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                     trigger_next_characteristic_query(peripheral, get_last_result_handle_from_characteristics_list(packet, size));
                     // GATT_EVENT_QUERY_COMPLETE is emitted by trigger_next_xxx when done, or by ATT_ERROR
                     break;
+                case P_W4_DATABASE_CHARACTERISTIC_QUERY_RESULT:
+                    gatt_client_database_handle_characteristics(peripheral, packet, size);
+                    break;
                 case P_W4_INCLUDED_SERVICE_QUERY_RESULT:
                 {
                     uint16_t uuid16 = 0;
@@ -1242,6 +1429,10 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
         }
         case ATT_FIND_INFORMATION_REPLY:
         {
+            if (peripheral->gatt_client_state == P_W4_DATABASE_DESCRIPTOR_QUERY_RESULT){
+                gatt_client_database_handle_descriptors(peripheral, packet, size);
+                break;
+            }
             uint8_t pair_size = 4;
             if (packet[1] == 2){
                 pair_size = 18;
@@ -1384,6 +1575,16 @@ static void gatt_client_att_packet_handler(uint8_t packet_type, uint16_t handle,
                             gatt_client_handle_transaction_complete(peripheral);
                             emit_gatt_complete_event(peripheral, 0);
                             break;
+                        case P_W4_DATABASE_SERVICE_QUERY_RESULT:
+                            gatt_client_database_services_done(peripheral);
+                            break;
+                        case P_W4_DATABASE_CHARACTERISTIC_QUERY_RESULT:
+                            gatt_client_database_characteristics_done(peripheral);
+                            break;
+                        case P_W4_DATABASE_DESCRIPTOR_QUERY_RESULT:
+                            peripheral->database_index++;
+                            gatt_client_database_next_descriptor_query(peripheral);
+                            break;
                         case P_W4_READ_BY_TYPE_RESPONSE:
                             gatt_client_handle_transaction_complete(peripheral);
                             if (peripheral->start_group_handle == peripheral->query_start_handle){
@@ -1508,6 +1709,39 @@ uint8_t gatt_client_discover_characteristics_for_service(btstack_packet_handler_
     return 0;
 }
 
+void gatt_client_database_init(gatt_client_database_t * database,
+    gatt_client_database_service_t * services, uint16_t max_services,
+    gatt_client_database_characteristic_t * characteristics, uint16_t max_characteristics,
+    gatt_client_characteristic_descriptor_t * descriptors, uint16_t max_descriptors){
+    memset(database, 0, sizeof(gatt_client_database_t));
+    database->services = services;
+    database->max_services = max_services;
+    database->characteristics = characteristics;
+    database->max_characteristics = max_characteristics;
+    database->descriptors = descriptors;
+    database->max_descriptors = max_descriptors;
+}
+
+uint8_t gatt_client_discover_database(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_database_t * database){
+    gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
+
+    if (!peripheral) return BTSTACK_MEMORY_ALLOC_FAILED; 
+    if (!is_ready(peripheral)) return GATT_CLIENT_IN_WRONG_STATE;
+
+    database->num_services = 0;
+    database->num_characteristics = 0;
+    database->num_descriptors = 0;
+
+    peripheral->callback = callback;
+    peripheral->database = database;
+    peripheral->database_index = 0;
+    peripheral->start_group_handle = 0x0001;
+    peripheral->end_group_handle   = 0xffff;
+    peripheral->gatt_client_state = P_W2_SEND_DATABASE_SERVICE_QUERY;
+    gatt_client_run();
+    return 0;
+}
+
 uint8_t gatt_client_find_included_services_for_service(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_service_t *service){
     gatt_client_t * peripheral = provide_context_for_conn_handle_and_start_timer(con_handle);
     
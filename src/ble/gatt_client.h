@@ -59,6 +59,14 @@ typedef enum {
     
     P_W2_SEND_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY,
     P_W4_ALL_CHARACTERISTIC_DESCRIPTORS_QUERY_RESULT,
+
+    // whole database discovery
+    P_W2_SEND_DATABASE_SERVICE_QUERY,
+    P_W4_DATABASE_SERVICE_QUERY_RESULT,
+    P_W2_SEND_DATABASE_CHARACTERISTIC_QUERY,
+    P_W4_DATABASE_CHARACTERISTIC_QUERY_RESULT,
+    P_W2_SEND_DATABASE_DESCRIPTOR_QUERY,
+    P_W4_DATABASE_DESCRIPTOR_QUERY_RESULT,
     
     P_W2_SEND_INCLUDED_SERVICE_QUERY,
     P_W4_INCLUDED_SERVICE_QUERY_RESULT,
@@ -174,6 +182,10 @@ typedef struct gatt_client{
     
     uint8_t  filter_with_uuid;
     uint8_t  send_confirmation;
+
+    // whole database discovery: current service or characteristic
+    struct gatt_client_database * database;
+    uint16_t database_index;
    
     int      le_device_index;
     uint8_t  cmac[8];
@@ -212,6 +224,33 @@ typedef struct {
     uint8_t  uuid128[16];
 } gatt_client_characteristic_descriptor_t;
 
+typedef struct {
+    gatt_client_service_t service;
+    // characteristics of service: characteristics[first_characteristic .. first_characteristic + num_characteristics - 1]
+    uint16_t first_characteristic;
+    uint16_t num_characteristics;
+} gatt_client_database_service_t;
+
+typedef struct {
+    gatt_client_characteristic_t characteristic;
+    // descriptors of characteristic: descriptors[first_descriptor .. first_descriptor + num_descriptors - 1]
+    uint16_t first_descriptor;
+    uint16_t num_descriptors;
+} gatt_client_database_characteristic_t;
+
+// remote GATT database, filled by gatt_client_discover_database in handle order
+typedef struct gatt_client_database {
+    gatt_client_database_service_t * services;
+    uint16_t max_services;
+    uint16_t num_services;
+    gatt_client_database_characteristic_t * characteristics;
+    uint16_t max_characteristics;
+    uint16_t num_characteristics;
+    gatt_client_characteristic_descriptor_t * descriptors;
+    uint16_t max_descriptors;
+    uint16_t num_descriptors;
+} gatt_client_database_t;
+
 /** 
  * @brief Set up GATT client.
  */
@@ -248,6 +287,34 @@ uint8_t gatt_client_discover_primary_services(btstack_packet_handler_t callback,
 uint8_t gatt_client_discover_primary_services_by_uuid16(btstack_packet_handler_t callback, hci_con_handle_t con_handle, uint16_t uuid16);
 uint8_t gatt_client_discover_primary_services_by_uuid128(btstack_packet_handler_t callback, hci_con_handle_t con_handle, const uint8_t  * uuid);
 
+/**
+ * @brief Set up storage for discovery of remote GATT database
+ * @param database
+ * @param services storage
+ * @param max_services
+ * @param characteristics storage
+ * @param max_characteristics
+ * @param descriptors storage
+ * @param max_descriptors
+ */
+void gatt_client_database_init(gatt_client_database_t * database,
+    gatt_client_database_service_t * services, uint16_t max_services,
+    gatt_client_database_characteristic_t * characteristics, uint16_t max_characteristics,
+    gatt_client_characteristic_descriptor_t * descriptors, uint16_t max_descriptors);
+
+/**
+ * @brief Discovers all primary services, their characteristics and the characteristic descriptors in a single query and stores
+ *        them in the provided database. Characteristics of all services are discovered with a single sequence of Read By Type
+ *        requests, descriptors are only queried for characteristics with handles after the value handle.
+ *        No result events are emitted, the GATT_EVENT_QUERY_COMPLETE event marks the end of the query.
+ * @note  If the storage is too small, the query stops and GATT_EVENT_QUERY_COMPLETE reports ATT_ERROR_INSUFFICIENT_RESOURCES
+ * @param callback
+ * @param con_handle
+ * @param database initialized with gatt_client_database_init
+ * @return status
+ */
+uint8_t gatt_client_discover_database(btstack_packet_handler_t callback, hci_con_handle_t con_handle, gatt_client_database_t * database);
+
 /** 
  * @brief Finds included services within the specified service. For each found included service, an le_service_event_t with type set to GATT_EVENT_INCLUDED_SERVICE_QUERY_RESULT will be generated and passed to the registered callback. The gatt_complete_event_t with type set to GATT_EVENT_QUERY_COMPLETE, marks the end of discovery. Information about included service type (primary/secondary) can be retrieved either by sending an ATT find information request for the returned start group handle (returning the handle and the UUID for primary or secondary service) or by comparing the service to the list of all primary services. 
  */
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "le_connection_manager.c"
+
+/*
+ * le_connection_manager.c
+ *
+ * Peers that are not connected are put into the Controller whitelist and connected
+ * via Auto Connection Establishment. If there are more peers than whitelist entries,
+ * peers recently seen in advertisements are preferred by RSSI, followed by the peers
+ * that waited longest. All whitelist changes of one evaluation are done together, so
+ * that HCI only has to stop and restart the connection process once.
+ */
+
+#include <string.h>
+
+#include "ble/core.h"
+#include "ble/le_connection_manager.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "gap.h"
+#include "hci.h"
+
+static btstack_linked_list_t le_cm_peers;
+static btstack_timer_source_t le_cm_timer;
+static btstack_packet_callback_registration_t le_cm_hci_event_callback_registration;
+
+static uint32_t le_cm_backoff_min_ms = 100;
+static uint32_t le_cm_backoff_max_ms = 60000;
+
+static le_connection_manager_metrics_t le_cm_metrics;
+
+static le_connection_manager_peer_t * le_cm_peer_for_address(bd_addr_type_t address_type, const uint8_t * address){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_cm_peers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+        // compare last byte first
+        if (peer->address[5] != address[5]) continue;
+        if (peer->address_type != address_type) continue;
+        if (memcmp(peer->address, address, 6) != 0) continue;
+        return peer;
+    }
+    return NULL;
+}
+
+static le_connection_manager_peer_t * le_cm_peer_for_con_handle(hci_con_handle_t con_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &le_cm_peers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+        if (peer->state != LE_CONNECTION_MANAGER_PEER_CONNECTED) continue;
+        if (peer->con_handle != con_handle) continue;
+        return peer;
+    }
+    return NULL;
+}
+
+static int le_cm_peer_eligible(le_connection_manager_peer_t * peer, uint32_t now){
+    switch (peer->state){
+        case LE_CONNECTION_MANAGER_PEER_WHITELISTED:
+            return 1;
+        case LE_CONNECTION_MANAGER_PEER_IDLE:
+            return (int32_t)(now - peer->retry_ms) >= 0;
+        default:
+            return 0;
+    }
+}
+
+// returns 1 if peer a should be connected before peer b
+static int le_cm_peer_preferred(le_connection_manager_peer_t * a, le_connection_manager_peer_t * b, uint32_t now){
+    // peers keep their whitelist entry for a minimal time
+    int a_locked = (a->state == LE_CONNECTION_MANAGER_PEER_WHITELISTED) && ((now - a->whitelisted_ms) < LE_CONNECTION_MANAGER_MIN_WHITELIST_TIME_MS);
+    int b_locked = (b->state == LE_CONNECTION_MANAGER_PEER_WHITELISTED) && ((now - b->whitelisted_ms) < LE_CONNECTION_MANAGER_MIN_WHITELIST_TIME_MS);
+    if (a_locked != b_locked) return a_locked;
+    // recently seen peers by RSSI
+    int a_seen = a->last_seen_ms && ((now - a->last_seen_ms) < LE_CONNECTION_MANAGER_SEEN_TIMEOUT_MS);
+    int b_seen = b->last_seen_ms && ((now - b->last_seen_ms) < LE_CONNECTION_MANAGER_SEEN_TIMEOUT_MS);
+    if (a_seen != b_seen) return a_seen;
+    if (a_seen && (a->rssi != b->rssi)) return a->rssi > b->rssi;
+    // longest waiting
+    return (now - a->whitelisted_ms) > (now - b->whitelisted_ms);
+}
+
+static void le_cm_run(void){
+    uint32_t now = btstack_run_loop_get_time_ms();
+    btstack_linked_list_iterator_t it;
+
+    // select peers for whitelist
+    uint16_t whitelist_size = gap_auto_connection_get_whitelist_size();
+    uint16_t num_selected = 0;
+    btstack_linked_list_iterator_init(&it, &le_cm_peers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+        peer->selected = 0;
+    }
+    while (num_selected < whitelist_size){
+        le_connection_manager_peer_t * best = NULL;
+        btstack_linked_list_iterator_init(&it, &le_cm_peers);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+            if (peer->selected) continue;
+            if (!le_cm_peer_eligible(peer, now)) continue;
+            if (best && !le_cm_peer_preferred(peer, best, now)) continue;
+            best = peer;
+        }
+        if (!best) break;
+        best->selected = 1;
+        num_selected++;
+    }
+
+    // remove peers that have not been selected first
+    btstack_linked_list_iterator_init(&it, &le_cm_peers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+        if (peer->state != LE_CONNECTION_MANAGER_PEER_WHITELISTED) continue;
+        if (peer->selected) continue;
+        peer->state = LE_CONNECTION_MANAGER_PEER_IDLE;
+        gap_auto_connection_stop(peer->address_type, peer->address);
+    }
+
+    // add selected peers
+    btstack_linked_list_iterator_init(&it, &le_cm_peers);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_connection_manager_peer_t * peer = (le_connection_manager_peer_t *) btstack_linked_list_iterator_next(&it);
+        if (peer->state == LE_CONNECTION_MANAGER_PEER_WHITELISTED) continue;
+        if (!peer->selected) continue;
+        int status = gap_auto_connection_start(peer->address_type, peer->address);
+        if (status == ERROR_CODE_MEMORY_CAPACITY_EXCEEDED || status == BTSTACK_MEMORY_ALLOC_FAILED){
+            // entries pending removal are still in use, retry on next evaluation
+            break;
+        }
+        if (status) continue;
+        peer->state = LE_CONNECTION_MANAGER_PEER_WHITELISTED;
+        peer->whitelisted_ms = now;
+    }
+}
+
+static void le_cm_timer_handler(btstack_timer_source_t * ts){
+    if (hci_get_state() == HCI_STATE_WORKING){
+        le_cm_run();
+    }
+    btstack_run_loop_set_timer(ts, LE_CONNECTION_MANAGER_UPDATE_PERIOD_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void le_cm_handle_connection_complete(uint8_t * packet){
+    if (hci_subevent_le_connection_complete_get_status(packet)) return;
+    bd_addr_t address;
+    hci_subevent_le_connection_complete_get_peer_address(packet, address);
+    bd_addr_type_t address_type = (bd_addr_type_t) hci_subevent_le_connection_complete_get_peer_address_type(packet);
+    le_connection_manager_peer_t * peer = le_cm_peer_for_address(address_type, address);
+    if (!peer) return;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    if (peer->state == LE_CONNECTION_MANAGER_PEER_WHITELISTED){
+        // don't connect again
+        gap_auto_connection_stop(peer->address_type, peer->address);
+    }
+    peer->state = LE_CONNECTION_MANAGER_PEER_CONNECTED;
+    peer->con_handle = hci_subevent_le_connection_complete_get_connection_handle(packet);
+    peer->connected_ms = now;
+    peer->num_connections++;
+
+    // metrics
+    uint32_t latency = now - peer->disconnected_ms;
+    peer->last_connect_latency_ms = latency;
+    if (le_cm_metrics.num_connections == 0 || latency < le_cm_metrics.connect_latency_min_ms){
+        le_cm_metrics.connect_latency_min_ms = latency;
+    }
+    if (latency > le_cm_metrics.connect_latency_max_ms){
+        le_cm_metrics.connect_latency_max_ms = latency;
+    }
+    le_cm_metrics.connect_latency_total_ms += latency;
+    le_cm_metrics.num_connections++;
+    log_info("LE CM: connected to %s after %u ms", bd_addr_to_str(address), (int) latency);
+    le_cm_run();
+}
+
+static void le_cm_handle_disconnection_complete(hci_con_handle_t con_handle){
+    le_connection_manager_peer_t * peer = le_cm_peer_for_con_handle(con_handle);
+    if (!peer) return;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    le_cm_metrics.num_disconnections++;
+    // exponential backoff until connection is stable
+    if ((now - peer->connected_ms) >= LE_CONNECTION_MANAGER_STABLE_CONNECTION_MS){
+        peer->backoff_ms = le_cm_backoff_min_ms;
+    } else {
+        peer->backoff_ms = btstack_min(le_cm_backoff_max_ms, btstack_max(le_cm_backoff_min_ms, peer->backoff_ms * 2));
+    }
+    peer->state = LE_CONNECTION_MANAGER_PEER_IDLE;
+    peer->con_handle = HCI_CON_HANDLE_INVALID;
+    peer->disconnected_ms = now;
+    peer->retry_ms = now + peer->backoff_ms;
+    log_info("LE CM: %s disconnected, retry in %u ms", bd_addr_to_str(peer->address), (int) peer->backoff_ms);
+}
+
+static void le_cm_handle_advertisement(bd_addr_type_t address_type, const uint8_t * address, int8_t rssi){
+    le_connection_manager_peer_t * peer = le_cm_peer_for_address(address_type, address);
+    if (!peer) return;
+    peer->rssi = rssi;
+    peer->last_seen_ms = btstack_run_loop_get_time_ms();
+}
+
+static void le_cm_hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    bd_addr_t address;
+    switch (hci_event_packet_get_type(packet)){
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_WORKING) break;
+            le_cm_run();
+            break;
+        case GAP_EVENT_ADVERTISING_REPORT:
+            gap_event_advertising_report_get_address(packet, address);
+            le_cm_handle_advertisement((bd_addr_type_t) gap_event_advertising_report_get_address_type(packet), address,
+                (int8_t) gap_event_advertising_report_get_rssi(packet));
+            break;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        case GAP_EVENT_EXTENDED_ADVERTISING_REPORT:
+            gap_event_extended_advertising_report_get_address(packet, address);
+            le_cm_handle_advertisement((bd_addr_type_t) gap_event_extended_advertising_report_get_address_type(packet), address,
+                (int8_t) gap_event_extended_advertising_report_get_rssi(packet));
+            break;
+#endif
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            le_cm_handle_disconnection_complete(hci_event_disconnection_complete_get_connection_handle(packet));
+            break;
+        case HCI_EVENT_LE_META:
+            if (hci_event_le_meta_get_subevent_code(packet) != HCI_SUBEVENT_LE_CONNECTION_COMPLETE) break;
+            le_cm_handle_connection_complete(packet);
+            break;
+        default:
+            break;
+    }
+}
+
+void le_connection_manager_init(void){
+    le_cm_peers = NULL;
+    memset(&le_cm_metrics, 0, sizeof(le_cm_metrics));
+    le_cm_hci_event_callback_registration.callback = &le_cm_hci_event_handler;
+    hci_add_event_handler(&le_cm_hci_event_callback_registration);
+    btstack_run_loop_set_timer_handler(&le_cm_timer, le_cm_timer_handler);
+    btstack_run_loop_set_timer(&le_cm_timer, LE_CONNECTION_MANAGER_UPDATE_PERIOD_MS);
+    btstack_run_loop_add_timer(&le_cm_timer);
+}
+
+void le_connection_manager_set_backoff(uint32_t backoff_min_ms, uint32_t backoff_max_ms){
+    le_cm_backoff_min_ms = backoff_min_ms;
+    le_cm_backoff_max_ms = btstack_max(backoff_min_ms, backoff_max_ms);
+}
+
+uint8_t le_connection_manager_add_peer(le_connection_manager_peer_t * peer, bd_addr_type_t address_type, bd_addr_t address){
+    if (le_cm_peer_for_address(address_type, address)) return ERROR_CODE_COMMAND_DISALLOWED;
+    memset(peer, 0, sizeof(le_connection_manager_peer_t));
+    peer->address_type = address_type;
+    memcpy(peer->address, address, 6);
+    peer->state = LE_CONNECTION_MANAGER_PEER_IDLE;
+    peer->con_handle = HCI_CON_HANDLE_INVALID;
+    peer->backoff_ms = le_cm_backoff_min_ms;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    peer->disconnected_ms = now;
+    peer->retry_ms = now;
+    peer->whitelisted_ms = now;
+    btstack_linked_list_add_tail(&le_cm_peers, (btstack_linked_item_t *) peer);
+    if (hci_get_state() == HCI_STATE_WORKING){
+        le_cm_run();
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t le_connection_manager_remove_peer(bd_addr_type_t address_type, bd_addr_t address){
+    le_connection_manager_peer_t * peer = le_cm_peer_for_address(address_type, address);
+    if (!peer) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (peer->state == LE_CONNECTION_MANAGER_PEER_WHITELISTED){
+        gap_auto_connection_stop(peer->address_type, peer->address);
+    }
+    btstack_linked_list_remove(&le_cm_peers, (btstack_linked_item_t *) peer);
+    return ERROR_CODE_SUCCESS;
+}
+
+le_connection_manager_peer_t * le_connection_manager_get_peer(bd_addr_type_t address_type, bd_addr_t address){
+    return le_cm_peer_for_address(address_type, address);
+}
+
+void le_connection_manager_get_metrics(le_connection_manager_metrics_t * metrics){
+    *metrics = le_cm_metrics;
+}
+
+void le_connection_manager_reset_metrics(void){
+    memset(&le_cm_metrics, 0, sizeof(le_cm_metrics));
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * le_connection_manager.h
+ *
+ * Keeps a set of LE Peripherals connected using the Controller whitelist
+ */
+
+#ifndef __LE_CONNECTION_MANAGER_H
+#define __LE_CONNECTION_MANAGER_H
+
+#include <stdint.h>
+#include "bluetooth.h"
+#include "btstack_linked_list.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// peers are re-evaluated periodically
+#ifndef LE_CONNECTION_MANAGER_UPDATE_PERIOD_MS
+#define LE_CONNECTION_MANAGER_UPDATE_PERIOD_MS 1000
+#endif
+
+// peers seen in advertisements within this time are preferred, ordered by RSSI
+#ifndef LE_CONNECTION_MANAGER_SEEN_TIMEOUT_MS
+#define LE_CONNECTION_MANAGER_SEEN_TIMEOUT_MS 10000
+#endif
+
+// min time a peer stays in the whitelist before it can be replaced by another one
+#ifndef LE_CONNECTION_MANAGER_MIN_WHITELIST_TIME_MS
+#define LE_CONNECTION_MANAGER_MIN_WHITELIST_TIME_MS 5000
+#endif
+
+// connections that last at least this long reset the reconnect backoff
+#ifndef LE_CONNECTION_MANAGER_STABLE_CONNECTION_MS
+#define LE_CONNECTION_MANAGER_STABLE_CONNECTION_MS 10000
+#endif
+
+typedef enum {
+    LE_CONNECTION_MANAGER_PEER_IDLE = 0,
+    LE_CONNECTION_MANAGER_PEER_WHITELISTED,
+    LE_CONNECTION_MANAGER_PEER_CONNECTED,
+} le_connection_manager_peer_state_t;
+
+// peer, storage provided by application
+typedef struct {
+    btstack_linked_item_t item;
+    bd_addr_type_t   address_type;
+    bd_addr_t        address;
+    le_connection_manager_peer_state_t state;
+    hci_con_handle_t con_handle;
+    // last advertisement
+    int8_t           rssi;
+    uint32_t         last_seen_ms;
+    // reconnect
+    uint32_t         disconnected_ms;
+    uint32_t         whitelisted_ms;
+    uint32_t         connected_ms;
+    uint32_t         retry_ms;
+    uint32_t         backoff_ms;
+    uint8_t          selected;
+    // statistics
+    uint16_t         num_connections;
+    uint32_t         last_connect_latency_ms;
+} le_connection_manager_peer_t;
+
+typedef struct {
+    uint32_t num_connections;
+    uint32_t num_disconnections;
+    uint32_t connect_latency_min_ms;
+    uint32_t connect_latency_max_ms;
+    uint32_t connect_latency_total_ms;  // average = connect_latency_total_ms / num_connections
+} le_connection_manager_metrics_t;
+
+/* API_START */
+
+/**
+ * @brief Init LE Connection Manager
+ * @note Advertisements received while the application is scanning are used to prioritize peers by RSSI
+ */
+void le_connection_manager_init(void);
+
+/**
+ * @brief Set reconnect backoff. After a disconnect, the backoff doubles until a connection is stable
+ * @param backoff_min_ms, default: 100 ms
+ * @param backoff_max_ms, default: 60 s
+ */
+void le_connection_manager_set_backoff(uint32_t backoff_min_ms, uint32_t backoff_max_ms);
+
+/**
+ * @brief Add peer to target set. LE Connection Manager connects to it and reconnects after disconnect
+ * @param peer storage
+ * @param address_type
+ * @param address
+ * @returns 0 if ok
+ */
+uint8_t le_connection_manager_add_peer(le_connection_manager_peer_t * peer, bd_addr_type_t address_type, bd_addr_t address);
+
+/**
+ * @brief Remove peer from target set. An existing connection is not closed
+ * @param address_type
+ * @param address
+ * @returns 0 if ok
+ */
+uint8_t le_connection_manager_remove_peer(bd_addr_type_t address_type, bd_addr_t address);
+
+/**
+ * @brief Get peer for address
+ * @param address_type
+ * @param address
+ * @returns peer or NULL
+ */
+le_connection_manager_peer_t * le_connection_manager_get_peer(bd_addr_type_t address_type, bd_addr_t address);
+
+/**
+ * @brief Get connect latency metrics. Latency is measured from add or disconnect until connection complete
+ * @param metrics
+ */
+void le_connection_manager_get_metrics(le_connection_manager_metrics_t * metrics);
+
+/**
+ * @brief Reset connect latency metrics
+ */
+void le_connection_manager_reset_metrics(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __LE_CONNECTION_MANAGER_H
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "le_connection_parameter_manager.c"
+
+/*
+ * le_connection_parameter_manager.c
+ *
+ * Requests short connection intervals while a connection is busy and long intervals
+ * with slave latency when it becomes idle. Traffic is sampled periodically from the
+ * number of ACL packets sent and received as well as the number of packets queued
+ * in the Controller. Updates are rate limited per connection.
+ */
+
+#include <string.h>
+
+#include "ble/core.h"
+#include "ble/le_connection_parameter_manager.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_run_loop.h"
+#include "gap.h"
+#include "hci.h"
+
+static const le_connection_parameter_policy_t * le_cpm_policies[2];
+static btstack_timer_source_t le_cpm_timer;
+static int le_cpm_timer_active;
+static btstack_packet_callback_registration_t le_cpm_hci_event_callback_registration;
+
+static const le_connection_parameter_policy_t * le_cpm_policy_for_connection(hci_connection_t * connection){
+    if (connection->le_cpm_disabled) return NULL;
+    return le_cpm_policies[connection->role & 1];
+}
+
+static void le_cpm_apply(hci_connection_t * connection, const le_connection_parameter_policy_t * policy, uint8_t mode, uint32_t now){
+    uint16_t conn_interval_min;
+    uint16_t conn_interval_max;
+    uint16_t conn_latency;
+    uint16_t supervision_timeout;
+    if (mode == LE_CONNECTION_PARAMETER_MODE_BURST){
+        conn_interval_min   = policy->burst_conn_interval_min;
+        conn_interval_max   = policy->burst_conn_interval_max;
+        conn_latency        = policy->burst_conn_latency;
+        supervision_timeout = policy->burst_supervision_timeout;
+    } else {
+        conn_interval_min   = policy->idle_conn_interval_min;
+        conn_interval_max   = policy->idle_conn_interval_max;
+        conn_latency        = policy->idle_conn_latency;
+        supervision_timeout = policy->idle_supervision_timeout;
+    }
+    log_info("LE CPM: con handle 0x%04x mode %u, interval %u-%u, latency %u", connection->con_handle, mode, conn_interval_min, conn_interval_max, conn_latency);
+    connection->le_cpm_mode = mode;
+    connection->le_cpm_update_pending = 1;
+    connection->le_cpm_last_update_ms = now;
+    if (connection->role == HCI_ROLE_MASTER){
+        gap_update_connection_parameters(connection->con_handle, conn_interval_min, conn_interval_max, conn_latency, supervision_timeout);
+    } else {
+        gap_request_connection_parameter_update(connection->con_handle, conn_interval_min, conn_interval_max, conn_latency, supervision_timeout);
+    }
+}
+
+static void le_cpm_process_connection(hci_connection_t * connection, uint32_t now){
+    const le_connection_parameter_policy_t * policy = le_cpm_policy_for_connection(connection);
+    if (!policy) return;
+
+    // sample traffic
+    uint16_t num_packets = connection->le_num_acl_packets_tx + connection->le_num_acl_packets_rx;
+    uint16_t num_packets_in_period = num_packets - connection->le_cpm_last_num_packets;
+    connection->le_cpm_last_num_packets = num_packets;
+    int busy = num_packets_in_period >= policy->burst_threshold_packets;
+    if (policy->burst_threshold_queued_packets && connection->num_acl_packets_sent >= policy->burst_threshold_queued_packets){
+        busy = 1;
+    }
+    if (busy){
+        connection->le_cpm_last_burst_ms = now;
+    }
+
+    uint32_t time_since_update = now - connection->le_cpm_last_update_ms;
+
+    // request got lost or was rejected by remote, try again
+    if (connection->le_cpm_update_pending){
+        if (time_since_update < policy->min_update_interval_ms) return;
+        connection->le_cpm_update_pending = 0;
+        connection->le_cpm_mode = LE_CONNECTION_PARAMETER_MODE_NONE;
+    }
+
+    uint8_t mode = LE_CONNECTION_PARAMETER_MODE_IDLE;
+    if ((now - connection->le_cpm_last_burst_ms) < policy->idle_timeout_ms){
+        mode = LE_CONNECTION_PARAMETER_MODE_BURST;
+    }
+    if (mode == connection->le_cpm_mode) return;
+
+    // rate limit
+    if (connection->le_cpm_mode != LE_CONNECTION_PARAMETER_MODE_NONE && time_since_update < policy->min_update_interval_ms) return;
+
+    // don't interfere with ongoing parameter update
+    if (connection->le_con_parameter_update_state != CON_PARAMETER_UPDATE_NONE) return;
+
+    le_cpm_apply(connection, policy, mode, now);
+}
+
+static void le_cpm_timer_start(void){
+    if (le_cpm_timer_active) return;
+    le_cpm_timer_active = 1;
+    btstack_run_loop_set_timer(&le_cpm_timer, LE_CONNECTION_PARAMETER_MANAGER_SAMPLE_PERIOD_MS);
+    btstack_run_loop_add_timer(&le_cpm_timer);
+}
+
+static void le_cpm_timer_handler(btstack_timer_source_t * ts){
+    UNUSED(ts);
+    le_cpm_timer_active = 0;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    int num_le_connections = 0;
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        if (connection->address_type == BD_ADDR_TYPE_CLASSIC) continue;
+        if (connection->state != OPEN) continue;
+        num_le_connections++;
+        le_cpm_process_connection(connection, now);
+    }
+    // stop sampling without LE connections
+    if (num_le_connections == 0) return;
+    le_cpm_timer_start();
+}
+
+static void le_cpm_hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (hci_event_packet_get_type(packet) != HCI_EVENT_LE_META) return;
+    hci_connection_t * connection;
+    switch (hci_event_le_meta_get_subevent_code(packet)){
+        case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+            if (hci_subevent_le_connection_complete_get_status(packet)) break;
+            connection = hci_connection_for_handle(hci_subevent_le_connection_complete_get_connection_handle(packet));
+            if (!connection) break;
+            // treat connection setup as burst, e.g. for service discovery
+            connection->le_cpm_mode = LE_CONNECTION_PARAMETER_MODE_NONE;
+            connection->le_cpm_update_pending = 0;
+            connection->le_cpm_last_num_packets = connection->le_num_acl_packets_tx + connection->le_num_acl_packets_rx;
+            connection->le_cpm_last_burst_ms = btstack_run_loop_get_time_ms();
+            le_cpm_timer_start();
+            break;
+        case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+            connection = hci_connection_for_handle(hci_subevent_le_connection_update_complete_get_connection_handle(packet));
+            if (!connection) break;
+            connection->le_cpm_update_pending = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void le_connection_parameter_manager_init(void){
+    le_cpm_policies[0] = NULL;
+    le_cpm_policies[1] = NULL;
+    le_cpm_timer_active = 0;
+    btstack_run_loop_set_timer_handler(&le_cpm_timer, le_cpm_timer_handler);
+    le_cpm_hci_event_callback_registration.callback = &le_cpm_hci_event_handler;
+    hci_add_event_handler(&le_cpm_hci_event_callback_registration);
+}
+
+void le_connection_parameter_manager_set_policy(uint8_t role, const le_connection_parameter_policy_t * policy){
+    le_cpm_policies[role & 1] = policy;
+}
+
+void le_connection_parameter_manager_set_enabled(hci_con_handle_t con_handle, int enabled){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return;
+    connection->le_cpm_disabled = enabled ? 0 : 1;
+    if (!enabled) return;
+    // re-evaluate on next sample
+    connection->le_cpm_mode = LE_CONNECTION_PARAMETER_MODE_NONE;
+    connection->le_cpm_update_pending = 0;
+    le_cpm_timer_start();
+}
+
+void le_connection_parameter_manager_request_burst(hci_con_handle_t con_handle){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return;
+    const le_connection_parameter_policy_t * policy = le_cpm_policy_for_connection(connection);
+    if (!policy) return;
+    uint32_t now = btstack_run_loop_get_time_ms();
+    connection->le_cpm_last_burst_ms = now;
+    if (connection->le_cpm_mode == LE_CONNECTION_PARAMETER_MODE_BURST) return;
+    if (connection->le_cpm_update_pending) return;
+    if (connection->le_con_parameter_update_state != CON_PARAMETER_UPDATE_NONE) return;
+    // explicit requests are not rate limited
+    le_cpm_apply(connection, policy, LE_CONNECTION_PARAMETER_MODE_BURST, now);
+}
+
+uint8_t le_connection_parameter_manager_get_mode(hci_con_handle_t con_handle){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return LE_CONNECTION_PARAMETER_MODE_NONE;
+    return connection->le_cpm_mode;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * le_connection_parameter_manager.h
+ *
+ * Adapts connection interval, slave latency and supervision timeout of LE connections to the current traffic
+ */
+
+#ifndef __LE_CONNECTION_PARAMETER_MANAGER_H
+#define __LE_CONNECTION_PARAMETER_MANAGER_H
+
+#include <stdint.h>
+#include "bluetooth.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// connection parameter set currently requested for a connection
+#define LE_CONNECTION_PARAMETER_MODE_NONE  0
+#define LE_CONNECTION_PARAMETER_MODE_BURST 1
+#define LE_CONNECTION_PARAMETER_MODE_IDLE  2
+
+// traffic is sampled periodically
+#ifndef LE_CONNECTION_PARAMETER_MANAGER_SAMPLE_PERIOD_MS
+#define LE_CONNECTION_PARAMETER_MANAGER_SAMPLE_PERIOD_MS 250
+#endif
+
+typedef struct {
+    // parameters used during bursts, e.g. service discovery or bulk transfer
+    uint16_t burst_conn_interval_min;       // unit: 1.25 ms
+    uint16_t burst_conn_interval_max;       // unit: 1.25 ms
+    uint16_t burst_conn_latency;
+    uint16_t burst_supervision_timeout;     // unit: 10 ms
+    // parameters used while connection is idle
+    uint16_t idle_conn_interval_min;        // unit: 1.25 ms
+    uint16_t idle_conn_interval_max;        // unit: 1.25 ms
+    uint16_t idle_conn_latency;
+    uint16_t idle_supervision_timeout;      // unit: 10 ms
+    // ACL packets sent and received within one sample period that indicate a burst
+    uint16_t burst_threshold_packets;
+    // ACL packets queued in Controller that indicate a burst, 0 = ignore
+    uint8_t  burst_threshold_queued_packets;
+    // time after last burst before idle parameters are requested
+    uint32_t idle_timeout_ms;
+    // min time between two parameter updates for a connection
+    uint32_t min_update_interval_ms;
+} le_connection_parameter_policy_t;
+
+/* API_START */
+
+/**
+ * @brief Init LE Connection Parameter Manager
+ */
+void le_connection_parameter_manager_init(void);
+
+/**
+ * @brief Set policy for connections in given role. Connections use burst parameters after connect
+ * @param role HCI_ROLE_MASTER or HCI_ROLE_SLAVE
+ * @param policy or NULL to not manage connections in this role
+ * @note policy is not copied, pointer has to stay valid
+ */
+void le_connection_parameter_manager_set_policy(uint8_t role, const le_connection_parameter_policy_t * policy);
+
+/**
+ * @brief Enable or disable management of a single connection, e.g. while the application updates parameters itself
+ * @param con_handle
+ * @param enabled
+ */
+void le_connection_parameter_manager_set_enabled(hci_con_handle_t con_handle, int enabled);
+
+/**
+ * @brief Request burst parameters for a connection before traffic starts
+ * @param con_handle
+ */
+void le_connection_parameter_manager_request_burst(hci_con_handle_t con_handle);
+
+/**
+ * @brief Get parameter set currently requested for a connection
+ * @param con_handle
+ * @returns LE_CONNECTION_PARAMETER_MODE_*
+ */
+uint8_t le_connection_parameter_manager_get_mode(hci_con_handle_t con_handle);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __LE_CONNECTION_PARAMETER_MANAGER_H
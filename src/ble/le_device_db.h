@@ -104,6 +104,22 @@ int le_device_db_max_count(void);
 void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk);
 
 
+/**
+ * @brief find device by identity address
+ * @param addr_type
+ * @param addr
+ * @returns index if found, -1 otherwise
+ */
+int le_device_db_lookup_by_address(int addr_type, bd_addr_t addr);
+
+/**
+ * @brief find device by Identity Resolving Key (IRK)
+ * @param irk
+ * @returns index if found, -1 otherwise
+ */
+int le_device_db_lookup_by_irk(sm_key_t irk);
+
+
 /**
  * @brief set remote encryption info
  * @brief index
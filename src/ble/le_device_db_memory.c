@@ -140,6 +140,26 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 }
 
 
+int le_device_db_lookup_by_address(int addr_type, bd_addr_t addr){
+    int i;
+    for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
+        if (le_devices[i].addr_type != addr_type) continue;
+        if (memcmp(le_devices[i].addr, addr, 6) != 0) continue;
+        return i;
+    }
+    return -1;
+}
+
+int le_device_db_lookup_by_irk(sm_key_t irk){
+    int i;
+    for (i=0;i<MAX_NR_LE_DEVICE_DB_ENTRIES;i++){
+        if (le_devices[i].addr_type == INVALID_ENTRY_ADDR_TYPE) continue;
+        if (memcmp(le_devices[i].irk, irk, 16) != 0) continue;
+        return i;
+    }
+    return -1;
+}
+
 // get device information: addr type and address
 void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk){
     if (addr_type) *addr_type = le_devices[index].addr_type;
@@ -48,9 +48,11 @@
 
 // LE Device DB Implementation storing entries in btstack_tlv
 
-// Local cache is used to keep track of deleted entries in TLV
+// Local RAM index keeps identity information (address, IRK, seq nr) of all stored entries.
+// It allows to look up devices by identity address or IRK without fetching entries from TLV
 
 #define INVALID_ENTRY_ADDR_TYPE 0xff
+#define INVALID_INDEX           0xffff
 
 // Single stored entry
 typedef struct le_device_db_entry_t {
@@ -83,6 +85,16 @@ typedef struct le_device_db_entry_t {
 
 } le_device_db_entry_t;
 
+// RAM copy of identity information for each entry, chained into hash buckets by address and by IRK
+typedef struct {
+    uint32_t  seq_nr;
+    uint8_t   addr_type;        // INVALID_ENTRY_ADDR_TYPE if entry not present
+    bd_addr_t addr;
+    sm_key_t  irk;
+    uint16_t  next_for_addr;
+    uint16_t  next_for_irk;
+} le_device_db_index_entry_t;
+
 
 #ifndef NVM_NUM_DEVICE_DB_ENTRIES 
 #error "NVM_NUM_DEVICE_DB_ENTRIES not defined, please define in btstack_config.h"
@@ -92,9 +104,16 @@ typedef struct le_device_db_entry_t {
 #error "NVM_NUM_DEVICE_DB_ENTRIES must not be 0, please update in btstack_config.h"
 #endif
 
-// only stores if entry present
-static uint8_t  entry_map[NVM_NUM_DEVICE_DB_ENTRIES];
+#if NVM_NUM_DEVICE_DB_ENTRIES >= INVALID_INDEX
+#error "NVM_NUM_DEVICE_DB_ENTRIES must be smaller than 65535, please update in btstack_config.h"
+#endif
+
+// one bucket per entry
+static le_device_db_index_entry_t le_device_db_index[NVM_NUM_DEVICE_DB_ENTRIES];
+static uint16_t le_device_db_buckets_for_addr[NVM_NUM_DEVICE_DB_ENTRIES];
+static uint16_t le_device_db_buckets_for_irk[NVM_NUM_DEVICE_DB_ENTRIES];
 static uint32_t num_valid_entries;
+static uint32_t highest_seq_nr;
 
 static const btstack_tlv_t * le_device_db_tlv_btstack_tlv_impl;
 static       void *          le_device_db_tlv_btstack_tlv_context;
@@ -103,14 +122,84 @@ static const char tag_0 = 'B';
 static const char tag_1 = 'T';
 static const char tag_2 = 'D';
 
-static uint32_t le_device_db_tlv_tag_for_index(uint8_t index){
-    return (tag_0 << 24) | (tag_1 << 16) | (tag_2 << 8) | index;
+// entries above 255 use 'B','d' followed by 16-bit index, lower entries keep the original tag layout
+static const char tag_1_extended = 'd';
+
+static uint32_t le_device_db_tlv_tag_for_index(uint16_t index){
+    if (index < 0x100){
+        return (tag_0 << 24) | (tag_1 << 16) | (tag_2 << 8) | index;
+    }
+    return (tag_0 << 24) | (tag_1_extended << 16) | index;
+}
+
+static int le_device_db_tlv_index_valid(int index){
+    if (index < 0 || index >= NVM_NUM_DEVICE_DB_ENTRIES) return 0;
+    return le_device_db_index[index].addr_type != INVALID_ENTRY_ADDR_TYPE;
+}
+
+static uint16_t le_device_db_tlv_hash(const uint8_t * data, int len){
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    int i;
+    for (i=0;i<len;i++){
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash % NVM_NUM_DEVICE_DB_ENTRIES;
+}
+
+static void le_device_db_tlv_unlink(uint16_t * head, uint16_t index, int for_addr){
+    while (*head != INVALID_INDEX){
+        le_device_db_index_entry_t * it = &le_device_db_index[*head];
+        if (*head == index){
+            *head = for_addr ? it->next_for_addr : it->next_for_irk;
+            return;
+        }
+        head = for_addr ? &it->next_for_addr : &it->next_for_irk;
+    }
+}
+
+static void le_device_db_tlv_index_add(uint16_t index, uint8_t addr_type, const uint8_t * addr, const uint8_t * irk, uint32_t seq_nr){
+    le_device_db_index_entry_t * entry = &le_device_db_index[index];
+    entry->seq_nr    = seq_nr;
+    entry->addr_type = addr_type;
+    memcpy(entry->addr, addr, 6);
+    memcpy(entry->irk, irk, 16);
+    uint16_t bucket = le_device_db_tlv_hash(addr, 6);
+    entry->next_for_addr = le_device_db_buckets_for_addr[bucket];
+    le_device_db_buckets_for_addr[bucket] = index;
+    bucket = le_device_db_tlv_hash(irk, 16);
+    entry->next_for_irk = le_device_db_buckets_for_irk[bucket];
+    le_device_db_buckets_for_irk[bucket] = index;
+    if (seq_nr > highest_seq_nr){
+        highest_seq_nr = seq_nr;
+    }
+    num_valid_entries++;
+}
+
+static void le_device_db_tlv_index_remove(uint16_t index){
+    le_device_db_index_entry_t * entry = &le_device_db_index[index];
+    le_device_db_tlv_unlink(&le_device_db_buckets_for_addr[le_device_db_tlv_hash(entry->addr, 6)], index, 1);
+    le_device_db_tlv_unlink(&le_device_db_buckets_for_irk[le_device_db_tlv_hash(entry->irk, 16)], index, 0);
+    entry->addr_type = INVALID_ENTRY_ADDR_TYPE;
+    num_valid_entries--;
+}
+
+static void le_device_db_tlv_index_reset(void){
+    int i;
+    for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
+        le_device_db_index[i].addr_type = INVALID_ENTRY_ADDR_TYPE;
+        le_device_db_buckets_for_addr[i] = INVALID_INDEX;
+        le_device_db_buckets_for_irk[i]  = INVALID_INDEX;
+    }
+    num_valid_entries = 0;
+    highest_seq_nr = 0;
 }
 
 // @returns success
 // @param index = entry_pos
 static int le_device_db_tlv_fetch(int index, le_device_db_entry_t * entry){
-    if (index < 0 || index >= NVM_NUM_DEVICE_DB_ENTRIES){
+    if (!le_device_db_tlv_index_valid(index)){
 	    log_error("le_device_db_tlv_fetch called with invalid index %d", index);
 	    return 0;
 	}
@@ -144,15 +233,14 @@ static int le_device_db_tlv_delete(int index){
 
 static void le_device_db_tlv_scan(void){
     int i;
-    num_valid_entries = 0;
-    memset(entry_map, 0, sizeof(entry_map));
+    le_device_db_tlv_index_reset();
     for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
         // lookup entry
         le_device_db_entry_t entry;
-        if (!le_device_db_tlv_fetch(i, &entry)) continue;
-
-        entry_map[i] = 1;
-        num_valid_entries++;
+        uint32_t tag = le_device_db_tlv_tag_for_index(i);
+        int size = le_device_db_tlv_btstack_tlv_impl->get_tag(le_device_db_tlv_btstack_tlv_context, tag, (uint8_t*) &entry, sizeof(le_device_db_entry_t));
+        if (size != sizeof(le_device_db_entry_t)) continue;
+        le_device_db_tlv_index_add(i, entry.addr_type, entry.addr, entry.irk, entry.seq_nr);
     }
     log_info("num valid le device entries %u", num_valid_entries);
 }
@@ -176,66 +264,67 @@ int le_device_db_max_count(void){
 
 void le_device_db_remove(int index){
     // check if entry exists
-    if (entry_map[index] == 0) return; 
+    if (!le_device_db_tlv_index_valid(index)) return;
 
 	// delete entry in TLV
 	le_device_db_tlv_delete(index);
 
 	// mark as unused
-    entry_map[index] = 0;
+    le_device_db_tlv_index_remove(index);
+}
 
-    // keep track
-    num_valid_entries--;
+int le_device_db_lookup_by_address(int addr_type, bd_addr_t addr){
+    uint16_t index = le_device_db_buckets_for_addr[le_device_db_tlv_hash(addr, 6)];
+    while (index != INVALID_INDEX){
+        le_device_db_index_entry_t * entry = &le_device_db_index[index];
+        if (entry->addr_type == addr_type && memcmp(entry->addr, addr, 6) == 0) return index;
+        index = entry->next_for_addr;
+    }
+    return -1;
 }
 
-int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
+int le_device_db_lookup_by_irk(sm_key_t irk){
+    uint16_t index = le_device_db_buckets_for_irk[le_device_db_tlv_hash(irk, 16)];
+    while (index != INVALID_INDEX){
+        le_device_db_index_entry_t * entry = &le_device_db_index[index];
+        if (memcmp(entry->irk, irk, 16) == 0) return index;
+        index = entry->next_for_irk;
+    }
+    return -1;
+}
 
-    uint32_t highest_seq_nr = 0;
-    uint32_t lowest_seq_nr  = 0;
-    int index_for_lowest_seq_nr = -1;
-    int index_for_addr  = -1;
-    int index_for_empty = -1;
+int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 
-	// find unused entry in the used list
-    int i;
-    for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
-         if (entry_map[i]) {
-            le_device_db_entry_t entry;
-            le_device_db_tlv_fetch(i, &entry);
-            // found addr?
-            if ((memcmp(addr, entry.addr, 6) == 0) && addr_type == entry.addr_type){
-                index_for_addr = i;
-            }
-            // update highest seq nr
-            if (entry.seq_nr > highest_seq_nr){
-                highest_seq_nr = entry.seq_nr;
+    int index_to_use = le_device_db_lookup_by_address(addr_type, addr);
+
+    if (index_to_use < 0){
+        // find empty entry or entry with lowest seq nr
+        int index_for_lowest_seq_nr = -1;
+        uint32_t lowest_seq_nr = 0;
+        int i;
+        for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
+            le_device_db_index_entry_t * entry = &le_device_db_index[i];
+            if (entry->addr_type == INVALID_ENTRY_ADDR_TYPE){
+                index_to_use = i;
+                break;
             }
-            // find entry with lowest seq nr
-            if ((index_for_lowest_seq_nr == 0) || (entry.seq_nr < lowest_seq_nr)){
+            if ((index_for_lowest_seq_nr < 0) || (entry->seq_nr < lowest_seq_nr)){
                 index_for_lowest_seq_nr = i;
-                lowest_seq_nr = entry.seq_nr;
+                lowest_seq_nr = entry->seq_nr;
             }
-        } else {
-            index_for_empty = i;
         }
-    }
-
-    log_info("index_for_addr %x, index_for_empy %x, index_for_lowest_seq_nr %x", index_for_addr, index_for_empty, index_for_lowest_seq_nr);
-
-    uint32_t index_to_use = 0;
-    if (index_for_addr >= 0){
-        index_to_use = index_for_addr;
-    } else if (index_for_empty >= 0){
-        index_to_use = index_for_empty;
-    } else if (index_for_lowest_seq_nr >= 0){
-        index_to_use = index_for_lowest_seq_nr;
-    } else {
-        // should not happen
-        return -1;
+        if (index_to_use < 0){
+            index_to_use = index_for_lowest_seq_nr;
+        }
     }
 
     log_info("new entry for index %u", index_to_use);
 
+    // drop old identity from index
+    if (le_device_db_tlv_index_valid(index_to_use)){
+        le_device_db_tlv_index_remove(index_to_use);
+    }
+
     // store entry at index
 	le_device_db_entry_t entry;
     log_info("LE Device DB adding type %u - %s", addr_type, bd_addr_to_str(addr));
@@ -243,6 +332,7 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 
     memset(&entry, 0, sizeof(le_device_db_entry_t));
 
+    entry.seq_nr = highest_seq_nr + 1;
     entry.addr_type = addr_type;
     memcpy(entry.addr, addr, 6);
     memcpy(entry.irk, irk, 16);
@@ -253,13 +343,8 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
     // store
     le_device_db_tlv_store(index_to_use, &entry);
     
-    // set in entry_mape
-    entry_map[index_to_use] = 1;
-
-    // keep track - don't increase if old entry found
-    if (index_for_addr < 0){
-        num_valid_entries++;
-    }
+    // add to index
+    le_device_db_tlv_index_add(index_to_use, addr_type, addr, irk, entry.seq_nr);
 
     return index_to_use;
 }
@@ -268,14 +353,15 @@ int le_device_db_add(int addr_type, bd_addr_t addr, sm_key_t irk){
 // get device information: addr type and address
 void le_device_db_info(int index, int * addr_type, bd_addr_t addr, sm_key_t irk){
 
-	// fetch entry
-	le_device_db_entry_t entry;
-	int ok = le_device_db_tlv_fetch(index, &entry);
-	if (!ok) return;
-
-    if (addr_type) *addr_type = entry.addr_type;
-    if (addr) memcpy(addr, entry.addr, 6);
-    if (irk) memcpy(irk, entry.irk, 16);
+    // use RAM index
+    if (!le_device_db_tlv_index_valid(index)) {
+        if (addr_type) *addr_type = INVALID_ENTRY_ADDR_TYPE;
+        return;
+    }
+    le_device_db_index_entry_t * entry = &le_device_db_index[index];
+    if (addr_type) *addr_type = entry->addr_type;
+    if (addr) memcpy(addr, entry->addr, 6);
+    if (irk) memcpy(irk, entry->irk, 16);
 }
 
 void le_device_db_encryption_set(int index, uint16_t ediv, uint8_t rand[8], sm_key_t ltk, int key_size, int authenticated, int authorized){
@@ -433,7 +519,7 @@ void le_device_db_dump(void){
     uint32_t i;
 
     for (i=0;i<NVM_NUM_DEVICE_DB_ENTRIES;i++){
-        if (!entry_map[i]) continue;
+        if (!le_device_db_tlv_index_valid(i)) continue;
 		// fetch entry
 		le_device_db_entry_t entry;
 		le_device_db_tlv_fetch(i, &entry);
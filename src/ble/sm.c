@@ -112,15 +112,6 @@ typedef enum {
     CMAC_W4_MLAST
 } cmac_state_t;
 
-typedef enum {
-    JUST_WORKS,
-    PK_RESP_INPUT,       // Initiator displays PK, responder inputs PK
-    PK_INIT_INPUT,       // Responder displays PK, initiator inputs PK
-    PK_BOTH_INPUT,       // Only input on both, both input PK
-    NUMERIC_COMPARISON,  // Only numerical compparison (yes/no) on on both sides
-    OOB                  // OOB available on one (SC) or both sides (legacy)
-} stk_generation_method_t;
-
 typedef enum {
     SM_USER_RESPONSE_IDLE,
     SM_USER_RESPONSE_PENDING,
@@ -241,7 +232,7 @@ static void *    sm_address_resolution_context;
 static address_resolution_mode_t sm_address_resolution_mode;
 static btstack_linked_list_t sm_address_resolution_general_queue;
 
-// aes128 crypto engine.
+// aes128 crypto engine for key generation, random address update and address resolution
 static sm_aes128_state_t  sm_aes128_state;
 
 // crypto 
@@ -252,8 +243,7 @@ static btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
 static btstack_crypto_random_t   sm_crypto_random_oob_request;
 #endif
 
-// temp storage for random data
-static uint8_t sm_random_data[8];
+// temp storage for address resolution, random address update and key generation
 static uint8_t sm_aes128_key[16];
 static uint8_t sm_aes128_plaintext[16];
 static uint8_t sm_aes128_ciphertext[16];
@@ -277,87 +267,12 @@ static uint8_t ec_q[64];
 // -> master := initiator, slave := responder
 //
 
-// data needed for security setup
-typedef struct sm_setup_context {
-
-    btstack_timer_source_t sm_timeout;
-
-    // used in all phases
-    uint8_t   sm_pairing_failed_reason;
-
-    // user response, (Phase 1 and/or 2)
-    uint8_t   sm_user_response;
-    uint8_t   sm_keypress_notification; // bitmap: passkey started, digit entered, digit erased, passkey cleared, passkey complete, 3 bit count
-
-    // defines which keys will be send after connection is encrypted - calculated during Phase 1, used Phase 3
-    int       sm_key_distribution_send_set;
-    int       sm_key_distribution_received_set;
-
-    // Phase 2 (Pairing over SMP)
-    stk_generation_method_t sm_stk_generation_method;
-    sm_key_t  sm_tk;
-    uint8_t   sm_have_oob_data;
-    uint8_t   sm_use_secure_connections;
-
-    sm_key_t  sm_c1_t3_value;   // c1 calculation
-    sm_pairing_packet_t sm_m_preq; // pairing request - needed only for c1
-    sm_pairing_packet_t sm_s_pres; // pairing response - needed only for c1
-    sm_key_t  sm_local_random;
-    sm_key_t  sm_local_confirm;
-    sm_key_t  sm_peer_random;
-    sm_key_t  sm_peer_confirm;
-    uint8_t   sm_m_addr_type;   // address and type can be removed
-    uint8_t   sm_s_addr_type;   //  ''
-    bd_addr_t sm_m_address;     //  ''
-    bd_addr_t sm_s_address;     //  ''
-    sm_key_t  sm_ltk;
-
-    uint8_t   sm_state_vars;
-#ifdef ENABLE_LE_SECURE_CONNECTIONS
-    uint8_t   sm_peer_q[64];    // also stores random for EC key generation during init
-    sm_key_t  sm_peer_nonce;    // might be combined with sm_peer_random
-    sm_key_t  sm_local_nonce;   // might be combined with sm_local_random
-    sm_key_t  sm_dhkey;
-    sm_key_t  sm_peer_dhkey_check;
-    sm_key_t  sm_local_dhkey_check;
-    sm_key_t  sm_ra;
-    sm_key_t  sm_rb;
-    sm_key_t  sm_t;             // used for f5 and h6
-    sm_key_t  sm_mackey;
-    uint8_t   sm_passkey_bit;   // also stores number of generated random bytes for EC key generation
-#endif
-
-    // Phase 3
-
-    // key distribution, we generate
-    uint16_t  sm_local_y;
-    uint16_t  sm_local_div;
-    uint16_t  sm_local_ediv;
-    uint8_t   sm_local_rand[8];
-    sm_key_t  sm_local_ltk;
-    sm_key_t  sm_local_csrk;
-    sm_key_t  sm_local_irk;
-    // sm_local_address/addr_type not needed
-
-    // key distribution, received from peer
-    uint16_t  sm_peer_y;
-    uint16_t  sm_peer_div;
-    uint16_t  sm_peer_ediv;
-    uint8_t   sm_peer_rand[8];
-    sm_key_t  sm_peer_ltk;
-    sm_key_t  sm_peer_irk;
-    sm_key_t  sm_peer_csrk;
-    uint8_t   sm_peer_addr_type;
-    bd_addr_t sm_peer_address;
-
-} sm_setup_context_t;
-
-//
-static sm_setup_context_t the_setup;
-static sm_setup_context_t * setup = &the_setup;
+// built-in setup context, additional ones are allocated via btstack_memory (MAX_NR_SM_SETUP_CONTEXTS)
+static sm_setup_context_t sm_setup_context_builtin;
+static uint8_t            sm_setup_context_builtin_in_use;
 
-// active connection - the one for which the_setup is used for
-static uint16_t sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
+// setup context of the connection that is currently processed
+static sm_setup_context_t * setup;
 
 // @returns 1 if oob data is available
 // stores oob data in provided 16 byte buffer if not null
@@ -391,6 +306,7 @@ static void sm_cmac_message_start(const sm_key_t key, uint16_t message_len, cons
 #endif
 static void sm_done_for_handle(hci_con_handle_t con_handle);
 static sm_connection_t * sm_get_connection_for_handle(hci_con_handle_t con_handle);
+static int sm_setup_context_select(sm_connection_t * sm_conn);
 static inline int sm_calc_actual_encryption_key_size(int other);
 static int sm_validate_stk_generation_method(void);
 static void sm_handle_encryption_result_address_resolution(void *arg);
@@ -514,6 +430,7 @@ static void sm_truncate_key(sm_key_t key, int max_encryption_size){
 static void sm_timeout_handler(btstack_timer_source_t * timer){
     log_info("SM timeout");
     sm_connection_t * sm_conn = (sm_connection_t*) btstack_run_loop_get_timer_context(timer);
+    if (!sm_setup_context_select(sm_conn)) return;
     sm_conn->sm_engine_state = SM_GENERAL_TIMEOUT;
     sm_notify_client_status_reason(sm_conn, ERROR_CODE_CONNECTION_TIMEOUT, 0);
     sm_done_for_handle(sm_conn->sm_handle);
@@ -528,11 +445,7 @@ static void sm_timeout_start(sm_connection_t * sm_conn){
     btstack_run_loop_set_timer(&setup->sm_timeout, 30000); // 30 seconds sm timeout
     btstack_run_loop_add_timer(&setup->sm_timeout);
 }
-static void sm_timeout_stop(void){
-    btstack_run_loop_remove_timer(&setup->sm_timeout);
-}
 static void sm_timeout_reset(sm_connection_t * sm_conn){
-    sm_timeout_stop();
     sm_timeout_start(sm_conn);
 }
 
@@ -709,7 +622,13 @@ static void sm_notify_client_status(uint8_t type, hci_con_handle_t con_handle, u
 
 static void sm_notify_client_status_reason(sm_connection_t * sm_conn, uint8_t status, uint8_t reason){
     uint8_t event[13];
-    sm_setup_event_base(event, sizeof(event), SM_EVENT_PAIRING_COMPLETE, sm_conn->sm_handle, setup->sm_peer_addr_type, setup->sm_peer_address);
+    // report identity address if received during key distribution
+    sm_setup_context_t * context = sm_conn->sm_setup_context;
+    if (context){
+        sm_setup_event_base(event, sizeof(event), SM_EVENT_PAIRING_COMPLETE, sm_conn->sm_handle, context->sm_peer_addr_type, context->sm_peer_address);
+    } else {
+        sm_setup_event_base(event, sizeof(event), SM_EVENT_PAIRING_COMPLETE, sm_conn->sm_handle, sm_conn->sm_peer_addr_type, sm_conn->sm_peer_address);
+    }
     event[11] = status;
     event[12] = reason;
     sm_dispatch_event(HCI_EVENT_PACKET, 0, (uint8_t*) &event, sizeof(event));
@@ -957,12 +876,53 @@ static int sm_key_distribution_all_received(sm_connection_t * sm_conn){
     return recv_flags == setup->sm_key_distribution_received_set;
 }
 
+static sm_setup_context_t * sm_setup_context_alloc(void){
+    sm_setup_context_t * context;
+    if (!sm_setup_context_builtin_in_use){
+        sm_setup_context_builtin_in_use = 1;
+        context = &sm_setup_context_builtin;
+    } else {
+        context = btstack_memory_sm_setup_context_get();
+        if (!context) return NULL;
+    }
+    memset(context, 0, sizeof(sm_setup_context_t));
+    return context;
+}
+
+static void sm_setup_context_free(sm_setup_context_t * context){
+    if (context == &sm_setup_context_builtin){
+        sm_setup_context_builtin_in_use = 0;
+        return;
+    }
+    btstack_memory_sm_setup_context_free(context);
+}
+
+// continue with setup context of given connection, returns 0 if connection has none (anymore)
+static int sm_setup_context_select(sm_connection_t * sm_conn){
+    setup = sm_conn->sm_setup_context;
+    return setup != NULL;
+}
+
 static void sm_done_for_handle(hci_con_handle_t con_handle){
-    if (sm_active_connection_handle == con_handle){
-        sm_timeout_stop();
-        sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
-        log_info("sm: connection 0x%x released setup context", con_handle);
+    sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
+    if (!sm_conn) return;
+    sm_setup_context_t * context = sm_conn->sm_setup_context;
+    if (!context) return;
+    btstack_run_loop_remove_timer(&context->sm_timeout);
+    // crypto requests are part of the setup context and might still be queued
+    btstack_crypto_cancel(&context->sm_crypto_random_request.btstack_crypto);
+    btstack_crypto_cancel(&context->sm_crypto_aes128_request.btstack_crypto);
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    btstack_crypto_cancel(&context->sm_crypto_ecc_p256_request.btstack_crypto);
+    if (sm_cmac_connection == sm_conn){
+        btstack_crypto_cancel(&sm_cmac_request.btstack_crypto);
+        sm_cmac_connection = NULL;
+        sm_cmac_active = 0;
     }
+#endif
+    sm_conn->sm_setup_context = NULL;
+    sm_setup_context_free(context);
+    log_info("sm: connection 0x%x released setup context", con_handle);
 }
 
 static int sm_key_distribution_flags_for_auth_req(void){
@@ -1175,34 +1135,18 @@ static void sm_key_distribution_handle_all_received(sm_connection_t * sm_conn){
 
         // lookup device based on IRK
         if (setup->sm_key_distribution_received_set & SM_KEYDIST_FLAG_IDENTITY_INFORMATION){
-            int i;
-            for (i=0; i < le_device_db_max_count(); i++){
-                sm_key_t irk;
-                bd_addr_t address;
-                int address_type;
-                le_device_db_info(i, &address_type, address, irk);
-                if (memcmp(irk, setup->sm_peer_irk, 16) == 0){
-                    log_info("sm: device found for IRK, updating");
-                    le_db_index = i;
-                    break;
-                }
+            le_db_index = le_device_db_lookup_by_irk(setup->sm_peer_irk);
+            if (le_db_index >= 0){
+                log_info("sm: device found for IRK, updating");
             }
         }
 
         // if not found, lookup via public address if possible
         log_info("sm peer addr type %u, peer addres %s", setup->sm_peer_addr_type, bd_addr_to_str(setup->sm_peer_address));
         if (le_db_index < 0 && setup->sm_peer_addr_type == BD_ADDR_TYPE_LE_PUBLIC){
-            int i;
-            for (i=0; i < le_device_db_max_count(); i++){
-                bd_addr_t address;
-                int address_type;
-                le_device_db_info(i, &address_type, address, NULL);
-                log_info("device %u, sm peer addr type %u, peer addres %s", i, address_type, bd_addr_to_str(address));
-                if (address_type == BD_ADDR_TYPE_LE_PUBLIC && memcmp(address, setup->sm_peer_address, 6) == 0){
-                    log_info("sm: device found for public address, updating");
-                    le_db_index = i;
-                    break;
-                }
+            le_db_index = le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, setup->sm_peer_address);
+            if (le_db_index >= 0){
+                log_info("sm: device found for public address, updating");
             }
         }
 
@@ -1215,6 +1159,13 @@ static void sm_key_distribution_handle_all_received(sm_connection_t * sm_conn){
 
             sm_notify_client_index(SM_EVENT_IDENTITY_CREATED, sm_conn->sm_handle, setup->sm_peer_addr_type, setup->sm_peer_address, le_db_index);
 
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+            // let Controller resolve private addresses of bonded device
+            if (setup->sm_key_distribution_received_set & SM_KEYDIST_FLAG_IDENTITY_INFORMATION){
+                hci_le_resolving_list_add_device_db_entry(le_db_index);
+            }
+#endif
+
 #ifdef ENABLE_LE_SIGNED_WRITE
             // store local CSRK
             if (setup->sm_key_distribution_send_set & SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION){
@@ -1257,7 +1208,7 @@ static void sm_key_distribution_handle_all_received(sm_connection_t * sm_conn){
 }
 
 static void sm_pairing_error(sm_connection_t * sm_conn, uint8_t reason){
-    setup->sm_pairing_failed_reason = reason;
+    sm_conn->sm_pairing_failed_reason = reason;
     sm_conn->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
 }
 
@@ -1274,7 +1225,7 @@ static int sm_just_works_or_numeric_comparison(stk_generation_method_t method);
 static void sm_sc_start_calculating_local_confirm(sm_connection_t * sm_conn){
     if (sm_passkey_used(setup->sm_stk_generation_method)){
         // sm_conn->sm_engine_state = SM_SC_W2_GET_RANDOM_A;
-        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
+        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
     } else {
         sm_conn->sm_engine_state = SM_SC_W2_CMAC_FOR_CONFIRMATION;
     }
@@ -1287,7 +1238,7 @@ static void sm_sc_state_after_receiving_random(sm_connection_t * sm_conn){
             // generate Nb
             log_info("Generate Nb");
             // sm_conn->sm_engine_state = SM_SC_W2_GET_RANDOM_A;
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
         } else {
             sm_conn->sm_engine_state = SM_SC_SEND_PAIRING_RANDOM;
         }
@@ -1329,6 +1280,10 @@ static void sm_sc_cmac_done(uint8_t * hash){
 
     sm_connection_t * sm_conn = sm_cmac_connection;
     sm_cmac_connection = NULL;
+    if (!sm_setup_context_select(sm_conn)) {
+        sm_run();
+        return;
+    }
 #ifdef ENABLE_CLASSIC
     link_key_type_t link_key_type;
 #endif
@@ -1454,55 +1409,40 @@ static void f5_calculate_salt(sm_connection_t * sm_conn){
     sm_cmac_message_start(f5_salt, message_len, sm_cmac_sc_buffer, &sm_sc_cmac_done);
 }
 
-static inline void f5_mackkey(sm_connection_t * sm_conn, sm_key_t t, const sm_key_t n1, const sm_key_t n2, const sm_key56_t a1, const sm_key56_t a2){
+// f5(W, N1, N2, A1, A2) = AES-CMACT (Counter || keyID || N1 || N2|| A1|| A2 || Length = 256) -- Counter 0: MacKey, Counter 1: LTK
+// full message is set up for each call as sm_cmac_sc_buffer is shared between connections
+static void f5_engine(sm_connection_t * sm_conn, uint8_t counter){
     const uint16_t message_len = 53;
     sm_cmac_connection = sm_conn;
-
-    // f5(W, N1, N2, A1, A2) = AES-CMACT (Counter = 0 || keyID || N1 || N2|| A1|| A2 || Length = 256) -- this is the MacKey
-    sm_cmac_sc_buffer[0] = 0;
+    sm_cmac_sc_buffer[0] = counter;
     memcpy(sm_cmac_sc_buffer+01, f5_key_id, 4);
-    memcpy(sm_cmac_sc_buffer+05, n1, 16);
-    memcpy(sm_cmac_sc_buffer+21, n2, 16);
-    memcpy(sm_cmac_sc_buffer+37, a1, 7);
-    memcpy(sm_cmac_sc_buffer+44, a2, 7);
-    memcpy(sm_cmac_sc_buffer+51, f5_length, 2);
-    log_info("f5 key");
-    log_info_hexdump(t, 16);
-    log_info("f5 message for MacKey");
-    log_info_hexdump(sm_cmac_sc_buffer, message_len);
-    sm_cmac_message_start(t, message_len, sm_cmac_sc_buffer, &sm_sc_cmac_done);
-}
-
-static void f5_calculate_mackey(sm_connection_t * sm_conn){
-    sm_key56_t bd_addr_master, bd_addr_slave;
-    bd_addr_master[0] =  setup->sm_m_addr_type;
-    bd_addr_slave[0]  =  setup->sm_s_addr_type;
-    memcpy(&bd_addr_master[1], setup->sm_m_address, 6);
-    memcpy(&bd_addr_slave[1],  setup->sm_s_address, 6);
     if (IS_RESPONDER(sm_conn->sm_role)){
         // responder
-        f5_mackkey(sm_conn, setup->sm_t, setup->sm_peer_nonce, setup->sm_local_nonce, bd_addr_master, bd_addr_slave);
+        memcpy(sm_cmac_sc_buffer+05, setup->sm_peer_nonce, 16);
+        memcpy(sm_cmac_sc_buffer+21, setup->sm_local_nonce, 16);
     } else {
         // initiator
-        f5_mackkey(sm_conn, setup->sm_t, setup->sm_local_nonce, setup->sm_peer_nonce, bd_addr_master, bd_addr_slave);
+        memcpy(sm_cmac_sc_buffer+05, setup->sm_local_nonce, 16);
+        memcpy(sm_cmac_sc_buffer+21, setup->sm_peer_nonce, 16);
     }
-}
-
-// note: must be called right after f5_mackey, as sm_cmac_buffer[1..52] will be reused
-static inline void f5_ltk(sm_connection_t * sm_conn, sm_key_t t){
-    const uint16_t message_len = 53;
-    sm_cmac_connection = sm_conn;
-    sm_cmac_sc_buffer[0] = 1;
-    // 1..52 setup before
+    sm_cmac_sc_buffer[37] = setup->sm_m_addr_type;
+    memcpy(sm_cmac_sc_buffer+38, setup->sm_m_address, 6);
+    sm_cmac_sc_buffer[44] = setup->sm_s_addr_type;
+    memcpy(sm_cmac_sc_buffer+45, setup->sm_s_address, 6);
+    memcpy(sm_cmac_sc_buffer+51, f5_length, 2);
     log_info("f5 key");
-    log_info_hexdump(t, 16);
-    log_info("f5 message for LTK");
+    log_info_hexdump(setup->sm_t, 16);
+    log_info("f5 message for %s", counter ? "LTK" : "MacKey");
     log_info_hexdump(sm_cmac_sc_buffer, message_len);
-    sm_cmac_message_start(t, message_len, sm_cmac_sc_buffer, &sm_sc_cmac_done);
+    sm_cmac_message_start(setup->sm_t, message_len, sm_cmac_sc_buffer, &sm_sc_cmac_done);
+}
+
+static void f5_calculate_mackey(sm_connection_t * sm_conn){
+    f5_engine(sm_conn, 0);
 }
 
 static void f5_calculate_ltk(sm_connection_t * sm_conn){
-    f5_ltk(sm_conn, setup->sm_t);
+    f5_engine(sm_conn, 1);
 }
 
 static void f6_engine(sm_connection_t * sm_conn, const sm_key_t w, const sm_key_t n1, const sm_key_t n2, const sm_key_t r, const sm_key24_t io_cap, const sm_key56_t a1, const sm_key56_t a2){
@@ -1595,6 +1535,7 @@ static void sm_sc_prepare_dhkey_check(sm_connection_t * sm_conn){
 
 static void sm_sc_dhkey_calculated(void * arg){
     sm_connection_t * sm_conn = (sm_connection_t *) arg;
+    if (!sm_setup_context_select(sm_conn)) return;
     log_info("dhkey");
     log_info_hexdump(&setup->sm_dhkey[0], 32);
     setup->sm_state_vars |= SM_STATE_VAR_DHKEY_CALCULATED;
@@ -1723,834 +1664,860 @@ static void sm_start_calculating_ltk_from_ediv_and_rand(sm_connection_t * sm_con
     log_info("sm: received ltk request with key size %u, authenticated %u",
             sm_connection->sm_actual_encryption_key_size, sm_connection->sm_connection_authenticated);
     sm_connection->sm_engine_state = SM_RESPONDER_PH4_Y_GET_ENC;
-    sm_run();
 }
 #endif
 
-static void sm_run(void){
-
-    btstack_linked_list_iterator_t it;
-
-    // assert that stack has already bootet
-    if (hci_get_state() != HCI_STATE_WORKING) return;
-
-    // assert that we can send at least commands
-    if (!hci_can_send_command_packet_now()) return;
-
-    //
-    // non-connection related behaviour
-    //
+static void sm_send_pairing_failed(sm_connection_t * connection){
+    uint8_t buffer[2];
+    buffer[0] = SM_CODE_PAIRING_FAILED;
+    buffer[1] = connection->sm_pairing_failed_reason;
+    connection->sm_engine_state = connection->sm_role ? SM_RESPONDER_IDLE : SM_INITIATOR_CONNECTED;
+    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+    sm_notify_client_status_reason(connection, ERROR_CODE_AUTHENTICATION_FAILURE, connection->sm_pairing_failed_reason);
+    sm_done_for_handle(connection->sm_handle);
+}
 
-    // distributed key generation
-    switch (dkg_state){
-        case DKG_CALC_IRK:
-            // already busy?
-            if (sm_aes128_state == SM_AES128_IDLE) {
-                log_info("DKG_CALC_IRK started");
-                // IRK = d1(IR, 1, 0)
-                sm_d1_d_prime(1, 0, sm_aes128_plaintext);  // plaintext = d1 prime
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_ir, sm_aes128_plaintext, sm_persistent_irk, sm_handle_encryption_result_dkg_irk, NULL);
-                return;
-            }
-            break;
-        case DKG_CALC_DHK:
-            // already busy?
-            if (sm_aes128_state == SM_AES128_IDLE) {
-                log_info("DKG_CALC_DHK started");
-                // DHK = d1(IR, 3, 0)
-                sm_d1_d_prime(3, 0, sm_aes128_plaintext);  // plaintext = d1 prime
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_ir, sm_aes128_plaintext, sm_persistent_dhk, sm_handle_encryption_result_dkg_dhk, NULL);
-                return;
-            }
-            break;
+// states that start using a setup context
+static int sm_setup_context_required(sm_connection_t * sm_connection){
+    switch (sm_connection->sm_engine_state) {
+#ifdef ENABLE_LE_PERIPHERAL
+        case SM_RESPONDER_PH1_PAIRING_REQUEST_RECEIVED:
+        case SM_RESPONDER_PH0_RECEIVED_LTK_REQUEST:
+            return 1;
+#endif
+#ifdef ENABLE_LE_CENTRAL
+        case SM_INITIATOR_PH0_HAS_LTK:
+        case SM_INITIATOR_PH1_W2_SEND_PAIRING_REQUEST:
+            return 1;
+#endif
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+        case SM_SC_RECEIVED_LTK_REQUEST:
+            // just wait until IRK lookup is completed
+            return sm_connection->sm_irk_lookup_state == IRK_LOOKUP_SUCCEEDED;
+#endif
         default:
-            break;
+            return 0;
     }
+}
 
-    // random address updates
-    switch (rau_state){
-        case RAU_GET_ENC:
-            // already busy?
-            if (sm_aes128_state == SM_AES128_IDLE) {
-                sm_ah_r_prime(sm_random_address, sm_aes128_plaintext);
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_irk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_rau, NULL);
-                return;
-            }
-            break;
-        case RAU_SET_ADDRESS:
-            log_info("New random address: %s", bd_addr_to_str(sm_random_address));
-            rau_state = RAU_IDLE;
-            hci_send_cmd(&hci_le_set_random_address, sm_random_address);
-            return;
-        default:
-            break;
+// handle connection with setup context
+static void sm_run_for_connection(sm_connection_t * connection){
+
+    // assert that we could send a SM PDU - not needed for all of the following
+    if (!l2cap_can_send_fixed_channel_packet_now(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)) {
+        log_info("cannot send now, requesting can send now event");
+        l2cap_request_can_send_fix_channel_now_event(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
+        return;
     }
 
-    // CSRK Lookup
-    // -- if csrk lookup ready, find connection that require csrk lookup
-    if (sm_address_resolution_idle()){
-        hci_connections_get_iterator(&it);
-        while(btstack_linked_list_iterator_has_next(&it)){
-            hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
-            sm_connection_t  * sm_connection  = &hci_connection->sm_connection;
-            if (sm_connection->sm_irk_lookup_state == IRK_LOOKUP_W4_READY){
-                // and start lookup
-                sm_address_resolution_start_lookup(sm_connection->sm_peer_addr_type, sm_connection->sm_handle, sm_connection->sm_peer_address, ADDRESS_RESOLUTION_FOR_CONNECTION, sm_connection);
-                sm_connection->sm_irk_lookup_state = IRK_LOOKUP_STARTED;
+    // send keypress notifications
+    if (setup->sm_keypress_notification){
+        int i;
+        uint8_t flags       = setup->sm_keypress_notification & 0x1f;
+        uint8_t num_actions = setup->sm_keypress_notification >> 5;
+        uint8_t action = 0;
+        for (i=SM_KEYPRESS_PASSKEY_ENTRY_STARTED;i<=SM_KEYPRESS_PASSKEY_ENTRY_COMPLETED;i++){
+            if (flags & (1<<i)){
+                int clear_flag = 1;
+                switch (i){
+                    case SM_KEYPRESS_PASSKEY_ENTRY_STARTED:
+                    case SM_KEYPRESS_PASSKEY_CLEARED:
+                    case SM_KEYPRESS_PASSKEY_ENTRY_COMPLETED:
+                    default:
+                        break;
+                    case SM_KEYPRESS_PASSKEY_DIGIT_ENTERED:
+                    case SM_KEYPRESS_PASSKEY_DIGIT_ERASED:
+                        num_actions--;
+                        clear_flag = num_actions == 0;
+                        break;
+                }
+                if (clear_flag){
+                    flags &= ~(1<<i);
+                }
+                action = i;
                 break;
             }
         }
-    }
+        setup->sm_keypress_notification = (num_actions << 5) | flags;
 
-    // -- if csrk lookup ready, resolved addresses for received addresses
-    if (sm_address_resolution_idle()) {
-        if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
-            sm_lookup_entry_t * entry = (sm_lookup_entry_t *) sm_address_resolution_general_queue;
-            btstack_linked_list_remove(&sm_address_resolution_general_queue, (btstack_linked_item_t *) entry);
-            sm_address_resolution_start_lookup(entry->address_type, 0, entry->address, ADDRESS_RESOLUTION_GENERAL, NULL);
-            btstack_memory_sm_lookup_entry_free(entry);
-        }
-    }
+        // send keypress notification
+        uint8_t buffer[2];
+        buffer[0] = SM_CODE_KEYPRESS_NOTIFICATION;
+        buffer[1] = action;
+        l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
 
-    // -- Continue with CSRK device lookup by public or resolvable private address
-    if (!sm_address_resolution_idle()){
-        log_info("LE Device Lookup: device %u/%u", sm_address_resolution_test, le_device_db_max_count());
-        while (sm_address_resolution_test < le_device_db_max_count()){
-            int addr_type;
-            bd_addr_t addr;
-            sm_key_t irk;
-            le_device_db_info(sm_address_resolution_test, &addr_type, addr, irk);
-            log_info("device type %u, addr: %s", addr_type, bd_addr_to_str(addr));
+        // try
+        l2cap_request_can_send_fix_channel_now_event(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
+        return;
+    }
 
-            if (sm_address_resolution_addr_type == addr_type && memcmp(addr, sm_address_resolution_address, 6) == 0){
-                log_info("LE Device Lookup: found CSRK by { addr_type, address} ");
-                sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
-                break;
-            }
+    int key_distribution_flags;
+    UNUSED(key_distribution_flags);
 
-            if (sm_address_resolution_addr_type == 0){
-                sm_address_resolution_test++;
-                continue;
-            }
+    log_info("sm_run: state %u", connection->sm_engine_state);
+    if (!l2cap_can_send_fixed_channel_packet_now(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)) {
+        log_info("sm_run // cannot send");
+    }
+    switch (connection->sm_engine_state){
 
-            if (sm_aes128_state == SM_AES128_ACTIVE) break;
+        // general
+        case SM_GENERAL_SEND_PAIRING_FAILED:
+            sm_send_pairing_failed(connection);
+            break;
 
-            log_info("LE Device Lookup: calculate AH");
-            log_info_key("IRK", irk);
+        // responding state
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+        case SM_SC_W2_CMAC_FOR_CONFIRMATION:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CMAC_FOR_CONFIRMATION;
+            sm_sc_calculate_local_confirm(connection);
+            break;
+        case SM_SC_W2_CMAC_FOR_CHECK_CONFIRMATION:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CMAC_FOR_CHECK_CONFIRMATION;
+            sm_sc_calculate_remote_confirm(connection);
+            break;
+        case SM_SC_W2_CALCULATE_F6_FOR_DHKEY_CHECK:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_F6_FOR_DHKEY_CHECK;
+            sm_sc_calculate_f6_for_dhkey_check(connection);
+            break;
+        case SM_SC_W2_CALCULATE_F6_TO_VERIFY_DHKEY_CHECK:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_F6_TO_VERIFY_DHKEY_CHECK;
+            sm_sc_calculate_f6_to_verify_dhkey_check(connection);
+            break;
+        case SM_SC_W2_CALCULATE_F5_SALT:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_SALT;
+            f5_calculate_salt(connection);
+            break;
+        case SM_SC_W2_CALCULATE_F5_MACKEY:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_MACKEY;
+            f5_calculate_mackey(connection);
+            break;
+        case SM_SC_W2_CALCULATE_F5_LTK:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_LTK;
+            f5_calculate_ltk(connection);
+            break;
+        case SM_SC_W2_CALCULATE_G2:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_G2;
+            g2_calculate(connection);
+            break;
+        case SM_SC_W2_CALCULATE_H6_ILK:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_H6_ILK;
+            h6_calculate_ilk(connection);
+            break;
+        case SM_SC_W2_CALCULATE_H6_BR_EDR_LINK_KEY:
+            if (!sm_cmac_ready()) break;
+            connection->sm_engine_state = SM_SC_W4_CALCULATE_H6_BR_EDR_LINK_KEY;
+            h6_calculate_br_edr_link_key(connection);
+            break;
+#endif
 
-            memcpy(sm_aes128_key, irk, 16);
-            sm_ah_r_prime(sm_address_resolution_address, sm_aes128_plaintext);
-            sm_address_resolution_ah_calculation_active = 1;
-            sm_aes128_state = SM_AES128_ACTIVE;
-            btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_aes128_key, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_address_resolution, NULL);
+#ifdef ENABLE_LE_CENTRAL
+        // initiator side
+        case SM_INITIATOR_PH0_SEND_START_ENCRYPTION: {
+            sm_key_t peer_ltk_flipped;
+            reverse_128(setup->sm_peer_ltk, peer_ltk_flipped);
+            connection->sm_engine_state = SM_INITIATOR_PH0_W4_CONNECTION_ENCRYPTED;
+            log_info("sm: hci_le_start_encryption ediv 0x%04x", setup->sm_peer_ediv);
+            uint32_t rand_high = big_endian_read_32(setup->sm_peer_rand, 0);
+            uint32_t rand_low  = big_endian_read_32(setup->sm_peer_rand, 4);
+            hci_send_cmd(&hci_le_start_encryption, connection->sm_handle,rand_low, rand_high, setup->sm_peer_ediv, peer_ltk_flipped);
             return;
         }
 
-        if (sm_address_resolution_test >= le_device_db_max_count()){
-            log_info("LE Device Lookup: not found");
-            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
-        }
-    }
-
-#ifdef ENABLE_LE_SECURE_CONNECTIONS
-    switch (sm_sc_oob_state){
-        case SM_SC_OOB_W2_CALC_CONFIRM:
-            if (!sm_cmac_ready()) break;
-            sm_sc_oob_state = SM_SC_OOB_W4_CONFIRM;
-            f4_engine(NULL, ec_q, ec_q, sm_sc_oob_random, 0);
-            return;
-        default:
+        case SM_INITIATOR_PH1_SEND_PAIRING_REQUEST:
+            sm_pairing_packet_set_code(setup->sm_m_preq, SM_CODE_PAIRING_REQUEST);
+            connection->sm_engine_state = SM_INITIATOR_PH1_W4_PAIRING_RESPONSE;
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) &setup->sm_m_preq, sizeof(sm_pairing_packet_t));
+            sm_timeout_reset(connection);
             break;
-    }
 #endif
 
-    // handle basic actions that don't requires the full context
-    hci_connections_get_iterator(&it);
-    while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
-        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
-        sm_connection_t  * sm_connection = &hci_connection->sm_connection;
-        switch(sm_connection->sm_engine_state){
-            // responder side
-            case SM_RESPONDER_PH0_SEND_LTK_REQUESTED_NEGATIVE_REPLY:
-                sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
-                hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
-                return;
-
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
-            case SM_SC_RECEIVED_LTK_REQUEST:
-                switch (sm_connection->sm_irk_lookup_state){
-                    case IRK_LOOKUP_FAILED:
-                        log_info("LTK Request: ediv & random are empty, but no stored LTK (IRK Lookup Failed)");
-                        sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
-                        hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
-                        return;
-                    default:
-                        break;
-                }
-                break;
-#endif
-            default:
-                break;
-        }
-    }
 
-    //
-    // active connection handling
-    // -- use loop to handle next connection if lock on setup context is released
+        case SM_SC_SEND_PUBLIC_KEY_COMMAND: {
+            int trigger_user_response = 0;
 
-    while (1) {
+            uint8_t buffer[65];
+            buffer[0] = SM_CODE_PAIRING_PUBLIC_KEY;
+            //
+            reverse_256(&ec_q[0],  &buffer[1]);
+            reverse_256(&ec_q[32], &buffer[33]);
 
-        // Find connections that requires setup context and make active if no other is locked
-        hci_connections_get_iterator(&it);
-        while((sm_active_connection_handle == HCI_CON_HANDLE_INVALID) && btstack_linked_list_iterator_has_next(&it)){
-            hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
-            sm_connection_t  * sm_connection = &hci_connection->sm_connection;
-            // - if no connection locked and we're ready/waiting for setup context, fetch it and start
-            int done = 1;
-            int err;
-            UNUSED(err);
-            switch (sm_connection->sm_engine_state) {
-#ifdef ENABLE_LE_PERIPHERAL
-                case SM_RESPONDER_SEND_SECURITY_REQUEST:
-                    // send packet if possible,
-                    if (l2cap_can_send_fixed_channel_packet_now(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)){
-                        const uint8_t buffer[2] = { SM_CODE_SECURITY_REQUEST, SM_AUTHREQ_BONDING};
-                        sm_connection->sm_engine_state = SM_RESPONDER_PH1_W4_PAIRING_REQUEST;
-                        l2cap_send_connectionless(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            // stk generation method
+            // passkey entry: notify app to show passkey or to request passkey
+            switch (setup->sm_stk_generation_method){
+                case JUST_WORKS:
+                case NUMERIC_COMPARISON:
+                    if (IS_RESPONDER(connection->sm_role)){
+                        // responder
+                        sm_sc_start_calculating_local_confirm(connection);
                     } else {
-                        l2cap_request_can_send_fix_channel_now_event(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
+                        // initiator
+                        connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
                     }
-                    // don't lock sxetup context yet
-                    done = 0;
                     break;
-                case SM_RESPONDER_PH1_PAIRING_REQUEST_RECEIVED:
-                    sm_reset_setup();
-                    sm_init_setup(sm_connection);
-                    // recover pairing request
-                    memcpy(&setup->sm_m_preq, &sm_connection->sm_m_preq, sizeof(sm_pairing_packet_t));
-                    err = sm_stk_generation_init(sm_connection);
+                case PK_INIT_INPUT:
+                case PK_RESP_INPUT:
+                case PK_BOTH_INPUT:
+                    // use random TK for display
+                    memcpy(setup->sm_ra, setup->sm_tk, 16);
+                    memcpy(setup->sm_rb, setup->sm_tk, 16);
+                    setup->sm_passkey_bit = 0;
 
-#ifdef ENABLE_TESTING_SUPPORT
-                    if (0 < test_pairing_failure && test_pairing_failure < SM_REASON_DHKEY_CHECK_FAILED){
-                        log_info("testing_support: respond with pairing failure %u", test_pairing_failure);
-                        err = test_pairing_failure;
-                    }
-#endif
-                    if (err){
-                        setup->sm_pairing_failed_reason = err;
-                        sm_connection->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
-                        break;
-                    }
-                    sm_timeout_start(sm_connection);
-                    // generate random number first, if we need to show passkey
-                    if (setup->sm_stk_generation_method == PK_INIT_INPUT){
-                        btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph2_tk, sm_connection);
-                        break;
+                    if (IS_RESPONDER(connection->sm_role)){
+                        // responder
+                        connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
+                    } else {
+                        // initiator
+                        connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
                     }
-                    sm_connection->sm_engine_state = SM_RESPONDER_PH1_SEND_PAIRING_RESPONSE;
-                    break;
-                case SM_RESPONDER_PH0_RECEIVED_LTK_REQUEST:
-                    sm_reset_setup();
-                    sm_start_calculating_ltk_from_ediv_and_rand(sm_connection);
-                    break;
-#endif
-#ifdef ENABLE_LE_CENTRAL
-                case SM_INITIATOR_PH0_HAS_LTK:
-                    sm_reset_setup();
-                    sm_load_security_info(sm_connection);
-                    sm_connection->sm_engine_state = SM_INITIATOR_PH0_SEND_START_ENCRYPTION;
+                    trigger_user_response = 1;
                     break;
-                case SM_INITIATOR_PH1_W2_SEND_PAIRING_REQUEST:
-                    sm_reset_setup();
-                    sm_init_setup(sm_connection);
-                    sm_timeout_start(sm_connection);
-                    sm_connection->sm_engine_state = SM_INITIATOR_PH1_SEND_PAIRING_REQUEST;
-                    break;
-#endif
-
-#ifdef ENABLE_LE_SECURE_CONNECTIONS
-                case SM_SC_RECEIVED_LTK_REQUEST:
-                    switch (sm_connection->sm_irk_lookup_state){
-                        case IRK_LOOKUP_SUCCEEDED:
-                            // assuming Secure Connection, we have a stored LTK and the EDIV/RAND are null
-                            // start using context by loading security info
-                            sm_reset_setup();
-                            sm_load_security_info(sm_connection);
-                            if (setup->sm_peer_ediv == 0 && sm_is_null_random(setup->sm_peer_rand) && !sm_is_null_key(setup->sm_peer_ltk)){
-                                memcpy(setup->sm_ltk, setup->sm_peer_ltk, 16);
-                                sm_connection->sm_engine_state = SM_RESPONDER_PH4_SEND_LTK_REPLY;
-                                break;
-                            }
-                            log_info("LTK Request: ediv & random are empty, but no stored LTK (IRK Lookup Succeeded)");
-                            sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
-                            hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
-                            // don't lock setup context yet
-                            return;
-                        default:
-                            // just wait until IRK lookup is completed
-                            // don't lock setup context yet
-                            done = 0;
-                            break;
+                case OOB:
+                    if (IS_RESPONDER(connection->sm_role)){
+                        // responder
+                        connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
+                    } else {
+                        // initiator
+                        connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
                     }
                     break;
-#endif
-                default:
-                    done = 0;
-                    break;
-            }
-            if (done){
-                sm_active_connection_handle = sm_connection->sm_handle;
-                log_info("sm: connection 0x%04x locked setup context as %s, state %u", sm_active_connection_handle, sm_connection->sm_role ? "responder" : "initiator", sm_connection->sm_engine_state);
             }
-        }
-
-        //
-        // active connection handling
-        //
 
-        if (sm_active_connection_handle == HCI_CON_HANDLE_INVALID) return;
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            sm_timeout_reset(connection);
 
-        sm_connection_t * connection = sm_get_connection_for_handle(sm_active_connection_handle);
-        if (!connection) {
-            log_info("no connection for handle 0x%04x", sm_active_connection_handle);
-            return;
+            // trigger user response after sending pdu
+            if (trigger_user_response){
+                sm_trigger_user_response(connection);
+            }
+            break;
         }
-
-        // assert that we could send a SM PDU - not needed for all of the following
-        if (!l2cap_can_send_fixed_channel_packet_now(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)) {
-            log_info("cannot send now, requesting can send now event");
-            l2cap_request_can_send_fix_channel_now_event(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
-            return;
+        case SM_SC_SEND_CONFIRMATION: {
+            uint8_t buffer[17];
+            buffer[0] = SM_CODE_PAIRING_CONFIRM;
+            reverse_128(setup->sm_local_confirm, &buffer[1]);
+            if (IS_RESPONDER(connection->sm_role)){
+                connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
+            } else {
+                connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
+            }
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            sm_timeout_reset(connection);
+            break;
         }
-
-        // send keypress notifications
-        if (setup->sm_keypress_notification){
-            int i;
-            uint8_t flags       = setup->sm_keypress_notification & 0x1f;
-            uint8_t num_actions = setup->sm_keypress_notification >> 5;
-            uint8_t action = 0;
-            for (i=SM_KEYPRESS_PASSKEY_ENTRY_STARTED;i<=SM_KEYPRESS_PASSKEY_ENTRY_COMPLETED;i++){
-                if (flags & (1<<i)){
-                    int clear_flag = 1;
-                    switch (i){
-                        case SM_KEYPRESS_PASSKEY_ENTRY_STARTED:
-                        case SM_KEYPRESS_PASSKEY_CLEARED:
-                        case SM_KEYPRESS_PASSKEY_ENTRY_COMPLETED:
-                        default:
-                            break;
-                        case SM_KEYPRESS_PASSKEY_DIGIT_ENTERED:
-                        case SM_KEYPRESS_PASSKEY_DIGIT_ERASED:
-                            num_actions--;
-                            clear_flag = num_actions == 0;
-                            break;
-                    }
-                    if (clear_flag){
-                        flags &= ~(1<<i);
+        case SM_SC_SEND_PAIRING_RANDOM: {
+            uint8_t buffer[17];
+            buffer[0] = SM_CODE_PAIRING_RANDOM;
+            reverse_128(setup->sm_local_nonce, &buffer[1]);
+            log_info("stk method %u, num bits %u", setup->sm_stk_generation_method, setup->sm_passkey_bit);
+            if (sm_passkey_entry(setup->sm_stk_generation_method) && setup->sm_passkey_bit < 20){
+                log_info("SM_SC_SEND_PAIRING_RANDOM A");
+                if (IS_RESPONDER(connection->sm_role)){
+                    // responder
+                    connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
+                } else {
+                    // initiator
+                    connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
+                }
+            } else {
+                log_info("SM_SC_SEND_PAIRING_RANDOM B");
+                if (IS_RESPONDER(connection->sm_role)){
+                    // responder
+                    if (setup->sm_stk_generation_method == NUMERIC_COMPARISON){
+                        log_info("SM_SC_SEND_PAIRING_RANDOM B1");
+                        connection->sm_engine_state = SM_SC_W2_CALCULATE_G2;
+                    } else {
+                        log_info("SM_SC_SEND_PAIRING_RANDOM B2");
+                        sm_sc_prepare_dhkey_check(connection);
                     }
-                    action = i;
-                    break;
+                } else {
+                    // initiator
+                    connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
                 }
             }
-            setup->sm_keypress_notification = (num_actions << 5) | flags;
-
-            // send keypress notification
-            uint8_t buffer[2];
-            buffer[0] = SM_CODE_KEYPRESS_NOTIFICATION;
-            buffer[1] = action;
             l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-
-            // try
-            l2cap_request_can_send_fix_channel_now_event(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
-            return;
+            sm_timeout_reset(connection);
+            break;
         }
+        case SM_SC_SEND_DHKEY_CHECK_COMMAND: {
+            uint8_t buffer[17];
+            buffer[0] = SM_CODE_PAIRING_DHKEY_CHECK;
+            reverse_128(setup->sm_local_dhkey_check, &buffer[1]);
 
-        int key_distribution_flags;
-        UNUSED(key_distribution_flags);
+            if (IS_RESPONDER(connection->sm_role)){
+                connection->sm_engine_state = SM_SC_W4_LTK_REQUEST_SC;
+            } else {
+                connection->sm_engine_state = SM_SC_W4_DHKEY_CHECK_COMMAND;
+            }
 
-        log_info("sm_run: state %u", connection->sm_engine_state);
-        if (!l2cap_can_send_fixed_channel_packet_now(sm_active_connection_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)) {
-            log_info("sm_run // cannot send");
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            sm_timeout_reset(connection);
+            break;
         }
-        switch (connection->sm_engine_state){
-
-            // general
-            case SM_GENERAL_SEND_PAIRING_FAILED: {
-                uint8_t buffer[2];
-                buffer[0] = SM_CODE_PAIRING_FAILED;
-                buffer[1] = setup->sm_pairing_failed_reason;
-                connection->sm_engine_state = connection->sm_role ? SM_RESPONDER_IDLE : SM_INITIATOR_CONNECTED;
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                sm_notify_client_status_reason(connection, ERROR_CODE_AUTHENTICATION_FAILURE, setup->sm_pairing_failed_reason);
-                sm_done_for_handle(connection->sm_handle);
-                break;
-            }
 
-            // responding state
-#ifdef ENABLE_LE_SECURE_CONNECTIONS
-            case SM_SC_W2_CMAC_FOR_CONFIRMATION:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CMAC_FOR_CONFIRMATION;
-                sm_sc_calculate_local_confirm(connection);
-                break;
-            case SM_SC_W2_CMAC_FOR_CHECK_CONFIRMATION:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CMAC_FOR_CHECK_CONFIRMATION;
-                sm_sc_calculate_remote_confirm(connection);
-                break;
-            case SM_SC_W2_CALCULATE_F6_FOR_DHKEY_CHECK:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_F6_FOR_DHKEY_CHECK;
-                sm_sc_calculate_f6_for_dhkey_check(connection);
-                break;
-            case SM_SC_W2_CALCULATE_F6_TO_VERIFY_DHKEY_CHECK:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_F6_TO_VERIFY_DHKEY_CHECK;
-                sm_sc_calculate_f6_to_verify_dhkey_check(connection);
-                break;
-            case SM_SC_W2_CALCULATE_F5_SALT:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_SALT;
-                f5_calculate_salt(connection);
-                break;
-            case SM_SC_W2_CALCULATE_F5_MACKEY:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_MACKEY;
-                f5_calculate_mackey(connection);
-                break;
-            case SM_SC_W2_CALCULATE_F5_LTK:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_F5_LTK;
-                f5_calculate_ltk(connection);
-                break;
-            case SM_SC_W2_CALCULATE_G2:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_G2;
-                g2_calculate(connection);
-                break;
-            case SM_SC_W2_CALCULATE_H6_ILK:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_H6_ILK;
-                h6_calculate_ilk(connection);
-                break;
-            case SM_SC_W2_CALCULATE_H6_BR_EDR_LINK_KEY:
-                if (!sm_cmac_ready()) break;
-                connection->sm_engine_state = SM_SC_W4_CALCULATE_H6_BR_EDR_LINK_KEY;
-                h6_calculate_br_edr_link_key(connection);
-                break;
 #endif
 
-#ifdef ENABLE_LE_CENTRAL
-            // initiator side
-            case SM_INITIATOR_PH0_SEND_START_ENCRYPTION: {
-                sm_key_t peer_ltk_flipped;
-                reverse_128(setup->sm_peer_ltk, peer_ltk_flipped);
-                connection->sm_engine_state = SM_INITIATOR_PH0_W4_CONNECTION_ENCRYPTED;
-                log_info("sm: hci_le_start_encryption ediv 0x%04x", setup->sm_peer_ediv);
-                uint32_t rand_high = big_endian_read_32(setup->sm_peer_rand, 0);
-                uint32_t rand_low  = big_endian_read_32(setup->sm_peer_rand, 4);
-                hci_send_cmd(&hci_le_start_encryption, connection->sm_handle,rand_low, rand_high, setup->sm_peer_ediv, peer_ltk_flipped);
-                return;
+#ifdef ENABLE_LE_PERIPHERAL
+        case SM_RESPONDER_PH1_SEND_PAIRING_RESPONSE:
+            // echo initiator for now
+            sm_pairing_packet_set_code(setup->sm_s_pres,SM_CODE_PAIRING_RESPONSE);
+            key_distribution_flags = sm_key_distribution_flags_for_auth_req();
+
+            if (setup->sm_use_secure_connections){
+                connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
+                // skip LTK/EDIV for SC
+                log_info("sm: dropping encryption information flag");
+                key_distribution_flags &= ~SM_KEYDIST_ENC_KEY;
+            } else {
+                connection->sm_engine_state = SM_RESPONDER_PH1_W4_PAIRING_CONFIRM;
             }
 
-            case SM_INITIATOR_PH1_SEND_PAIRING_REQUEST:
-                sm_pairing_packet_set_code(setup->sm_m_preq, SM_CODE_PAIRING_REQUEST);
-                connection->sm_engine_state = SM_INITIATOR_PH1_W4_PAIRING_RESPONSE;
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) &setup->sm_m_preq, sizeof(sm_pairing_packet_t));
-                sm_timeout_reset(connection);
-                break;
+            sm_pairing_packet_set_initiator_key_distribution(setup->sm_s_pres, sm_pairing_packet_get_initiator_key_distribution(setup->sm_m_preq) & key_distribution_flags);
+            sm_pairing_packet_set_responder_key_distribution(setup->sm_s_pres, sm_pairing_packet_get_responder_key_distribution(setup->sm_m_preq) & key_distribution_flags);
+            // update key distribution after ENC was dropped
+            sm_setup_key_distribution(sm_pairing_packet_get_responder_key_distribution(setup->sm_s_pres));
+
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) &setup->sm_s_pres, sizeof(sm_pairing_packet_t));
+            sm_timeout_reset(connection);
+            // SC Numeric Comparison will trigger user response after public keys & nonces have been exchanged
+            if (!setup->sm_use_secure_connections || setup->sm_stk_generation_method == JUST_WORKS){
+                sm_trigger_user_response(connection);
+            }
+            return;
 #endif
 
-#ifdef ENABLE_LE_SECURE_CONNECTIONS
+        case SM_PH2_SEND_PAIRING_RANDOM: {
+            uint8_t buffer[17];
+            buffer[0] = SM_CODE_PAIRING_RANDOM;
+            reverse_128(setup->sm_local_random, &buffer[1]);
+            if (IS_RESPONDER(connection->sm_role)){
+                connection->sm_engine_state = SM_RESPONDER_PH2_W4_LTK_REQUEST;
+            } else {
+                connection->sm_engine_state = SM_INITIATOR_PH2_W4_PAIRING_RANDOM;
+            }
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            sm_timeout_reset(connection);
+            break;
+        }
 
-            case SM_SC_SEND_PUBLIC_KEY_COMMAND: {
-                int trigger_user_response = 0;
+        case SM_PH2_C1_GET_ENC_A:
+            // calculate confirm using aes128 engine - step 1
+            sm_c1_t1(setup->sm_local_random, (uint8_t*) &setup->sm_m_preq, (uint8_t*) &setup->sm_s_pres, setup->sm_m_addr_type, setup->sm_s_addr_type, setup->sm_aes128_plaintext);
+            connection->sm_engine_state = SM_PH2_C1_W4_ENC_A;
+            btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_aes128_plaintext, setup->sm_aes128_ciphertext, sm_handle_encryption_result_enc_a, connection);
+            break;
 
-                uint8_t buffer[65];
-                buffer[0] = SM_CODE_PAIRING_PUBLIC_KEY;
-                //
-                reverse_256(&ec_q[0],  &buffer[1]);
-                reverse_256(&ec_q[32], &buffer[33]);
+        case SM_PH2_C1_GET_ENC_C:
+            // calculate m_confirm using aes128 engine - step 1
+            sm_c1_t1(setup->sm_peer_random, (uint8_t*) &setup->sm_m_preq, (uint8_t*) &setup->sm_s_pres, setup->sm_m_addr_type, setup->sm_s_addr_type, setup->sm_aes128_plaintext);
+            connection->sm_engine_state = SM_PH2_C1_W4_ENC_C;
+            btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_aes128_plaintext, setup->sm_aes128_ciphertext, sm_handle_encryption_result_enc_c, connection);
+            break;
 
-                // stk generation method
-                // passkey entry: notify app to show passkey or to request passkey
-                switch (setup->sm_stk_generation_method){
-                    case JUST_WORKS:
-                    case NUMERIC_COMPARISON:
-                        if (IS_RESPONDER(connection->sm_role)){
-                            // responder
-                            sm_sc_start_calculating_local_confirm(connection);
-                        } else {
-                            // initiator
-                            connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
-                        }
-                        break;
-                    case PK_INIT_INPUT:
-                    case PK_RESP_INPUT:
-                    case PK_BOTH_INPUT:
-                        // use random TK for display
-                        memcpy(setup->sm_ra, setup->sm_tk, 16);
-                        memcpy(setup->sm_rb, setup->sm_tk, 16);
-                        setup->sm_passkey_bit = 0;
-
-                        if (IS_RESPONDER(connection->sm_role)){
-                            // responder
-                            connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
-                        } else {
-                            // initiator
-                            connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
-                        }
-                        trigger_user_response = 1;
-                        break;
-                    case OOB:
-                        if (IS_RESPONDER(connection->sm_role)){
-                            // responder
-                            connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
-                        } else {
-                            // initiator
-                            connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
-                        }
-                        break;
-                }
+        case SM_PH2_CALC_STK:
+            // calculate STK
+            if (IS_RESPONDER(connection->sm_role)){
+                sm_s1_r_prime(setup->sm_local_random, setup->sm_peer_random, setup->sm_aes128_plaintext);
+            } else {
+                sm_s1_r_prime(setup->sm_peer_random, setup->sm_local_random, setup->sm_aes128_plaintext);
+            }
+            connection->sm_engine_state = SM_PH2_W4_STK;
+            btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_stk, connection);
+            break;
 
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                sm_timeout_reset(connection);
+        case SM_PH3_Y_GET_ENC:
+            // PH3B2 - calculate Y from      - enc
+            // Y = dm(DHK, Rand)
+            sm_dm_r_prime(setup->sm_local_rand, setup->sm_aes128_plaintext);
+            connection->sm_engine_state = SM_PH3_Y_W4_ENC;
+            btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, sm_persistent_dhk, setup->sm_aes128_plaintext, setup->sm_aes128_ciphertext, sm_handle_encryption_result_enc_ph3_y, connection);
+            break;
 
-                // trigger user response after sending pdu
-                if (trigger_user_response){
-                    sm_trigger_user_response(connection);
-                }
-                break;
+        case SM_PH2_C1_SEND_PAIRING_CONFIRM: {
+            uint8_t buffer[17];
+            buffer[0] = SM_CODE_PAIRING_CONFIRM;
+            reverse_128(setup->sm_local_confirm, &buffer[1]);
+            if (IS_RESPONDER(connection->sm_role)){
+                connection->sm_engine_state = SM_RESPONDER_PH2_W4_PAIRING_RANDOM;
+            } else {
+                connection->sm_engine_state = SM_INITIATOR_PH2_W4_PAIRING_CONFIRM;
             }
-            case SM_SC_SEND_CONFIRMATION: {
+            l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+            sm_timeout_reset(connection);
+            return;
+        }
+#ifdef ENABLE_LE_PERIPHERAL
+        case SM_RESPONDER_PH2_SEND_LTK_REPLY: {
+            sm_key_t stk_flipped;
+            reverse_128(setup->sm_ltk, stk_flipped);
+            connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
+            hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, stk_flipped);
+            return;
+        }
+        case SM_RESPONDER_PH4_SEND_LTK_REPLY: {
+            sm_key_t ltk_flipped;
+            reverse_128(setup->sm_ltk, ltk_flipped);
+            connection->sm_engine_state = SM_RESPONDER_IDLE;
+            hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, ltk_flipped);
+            sm_done_for_handle(connection->sm_handle);
+            return;
+        }
+        case SM_RESPONDER_PH4_Y_GET_ENC:
+            log_info("LTK Request: recalculating with ediv 0x%04x", setup->sm_local_ediv);
+            // Y = dm(DHK, Rand)
+            sm_dm_r_prime(setup->sm_local_rand, setup->sm_aes128_plaintext);
+            connection->sm_engine_state = SM_RESPONDER_PH4_Y_W4_ENC;
+            btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, sm_persistent_dhk, setup->sm_aes128_plaintext, setup->sm_aes128_ciphertext, sm_handle_encryption_result_enc_ph4_y, connection);
+            return;
+#endif
+#ifdef ENABLE_LE_CENTRAL
+        case SM_INITIATOR_PH3_SEND_START_ENCRYPTION: {
+            sm_key_t stk_flipped;
+            reverse_128(setup->sm_ltk, stk_flipped);
+            connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
+            hci_send_cmd(&hci_le_start_encryption, connection->sm_handle, 0, 0, 0, stk_flipped);
+            return;
+        }
+#endif
+
+        case SM_PH3_DISTRIBUTE_KEYS:
+            if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_ENCRYPTION_INFORMATION){
+                setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_ENCRYPTION_INFORMATION;
                 uint8_t buffer[17];
-                buffer[0] = SM_CODE_PAIRING_CONFIRM;
-                reverse_128(setup->sm_local_confirm, &buffer[1]);
-                if (IS_RESPONDER(connection->sm_role)){
-                    connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
-                } else {
-                    connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
-                }
+                buffer[0] = SM_CODE_ENCRYPTION_INFORMATION;
+                reverse_128(setup->sm_ltk, &buffer[1]);
                 l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                 sm_timeout_reset(connection);
-                break;
+                return;
             }
-            case SM_SC_SEND_PAIRING_RANDOM: {
-                uint8_t buffer[17];
-                buffer[0] = SM_CODE_PAIRING_RANDOM;
-                reverse_128(setup->sm_local_nonce, &buffer[1]);
-                log_info("stk method %u, num bits %u", setup->sm_stk_generation_method, setup->sm_passkey_bit);
-                if (sm_passkey_entry(setup->sm_stk_generation_method) && setup->sm_passkey_bit < 20){
-                    log_info("SM_SC_SEND_PAIRING_RANDOM A");
-                    if (IS_RESPONDER(connection->sm_role)){
-                        // responder
-                        connection->sm_engine_state = SM_SC_W4_CONFIRMATION;
-                    } else {
-                        // initiator
-                        connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
-                    }
-                } else {
-                    log_info("SM_SC_SEND_PAIRING_RANDOM B");
-                    if (IS_RESPONDER(connection->sm_role)){
-                        // responder
-                        if (setup->sm_stk_generation_method == NUMERIC_COMPARISON){
-                            log_info("SM_SC_SEND_PAIRING_RANDOM B1");
-                            connection->sm_engine_state = SM_SC_W2_CALCULATE_G2;
-                        } else {
-                            log_info("SM_SC_SEND_PAIRING_RANDOM B2");
-                            sm_sc_prepare_dhkey_check(connection);
-                        }
-                    } else {
-                        // initiator
-                        connection->sm_engine_state = SM_SC_W4_PAIRING_RANDOM;
-                    }
-                }
+            if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_MASTER_IDENTIFICATION){
+                setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_MASTER_IDENTIFICATION;
+                uint8_t buffer[11];
+                buffer[0] = SM_CODE_MASTER_IDENTIFICATION;
+                little_endian_store_16(buffer, 1, setup->sm_local_ediv);
+                reverse_64(setup->sm_local_rand, &buffer[3]);
                 l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                 sm_timeout_reset(connection);
-                break;
+                return;
             }
-            case SM_SC_SEND_DHKEY_CHECK_COMMAND: {
+            if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_INFORMATION){
+                setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_INFORMATION;
                 uint8_t buffer[17];
-                buffer[0] = SM_CODE_PAIRING_DHKEY_CHECK;
-                reverse_128(setup->sm_local_dhkey_check, &buffer[1]);
-
-                if (IS_RESPONDER(connection->sm_role)){
-                    connection->sm_engine_state = SM_SC_W4_LTK_REQUEST_SC;
-                } else {
-                    connection->sm_engine_state = SM_SC_W4_DHKEY_CHECK_COMMAND;
+                buffer[0] = SM_CODE_IDENTITY_INFORMATION;
+                reverse_128(sm_persistent_irk, &buffer[1]);
+                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+                sm_timeout_reset(connection);
+                return;
+            }
+            if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION){
+                setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION;
+                bd_addr_t local_address;
+                uint8_t buffer[8];
+                buffer[0] = SM_CODE_IDENTITY_ADDRESS_INFORMATION;
+                switch (gap_random_address_get_mode()){
+                    case GAP_RANDOM_ADDRESS_TYPE_OFF:
+                    case GAP_RANDOM_ADDRESS_TYPE_STATIC:
+                        // public or static random
+                        gap_le_get_own_address(&buffer[1], local_address);
+                        break;
+                    case GAP_RANDOM_ADDRESS_NON_RESOLVABLE:
+                    case GAP_RANDOM_ADDRESS_RESOLVABLE:
+                        // fallback to public
+                        gap_local_bd_addr(local_address);
+                        buffer[1] = 0;
+                        break;
                 }
-
+                reverse_bd_addr(local_address, &buffer[2]);
                 l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                 sm_timeout_reset(connection);
-                break;
+                return;
             }
+            if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION){
+                setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION;
 
-#endif
-
-#ifdef ENABLE_LE_PERIPHERAL
-            case SM_RESPONDER_PH1_SEND_PAIRING_RESPONSE:
-                // echo initiator for now
-                sm_pairing_packet_set_code(setup->sm_s_pres,SM_CODE_PAIRING_RESPONSE);
-                key_distribution_flags = sm_key_distribution_flags_for_auth_req();
-
-                if (setup->sm_use_secure_connections){
-                    connection->sm_engine_state = SM_SC_W4_PUBLIC_KEY_COMMAND;
-                    // skip LTK/EDIV for SC
-                    log_info("sm: dropping encryption information flag");
-                    key_distribution_flags &= ~SM_KEYDIST_ENC_KEY;
-                } else {
-                    connection->sm_engine_state = SM_RESPONDER_PH1_W4_PAIRING_CONFIRM;
+                // hack to reproduce test runs
+                if (test_use_fixed_local_csrk){
+                    memset(setup->sm_local_csrk, 0xcc, 16);
                 }
 
-                sm_pairing_packet_set_initiator_key_distribution(setup->sm_s_pres, sm_pairing_packet_get_initiator_key_distribution(setup->sm_m_preq) & key_distribution_flags);
-                sm_pairing_packet_set_responder_key_distribution(setup->sm_s_pres, sm_pairing_packet_get_responder_key_distribution(setup->sm_m_preq) & key_distribution_flags);
-                // update key distribution after ENC was dropped
-                sm_setup_key_distribution(sm_pairing_packet_get_responder_key_distribution(setup->sm_s_pres));
-
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) &setup->sm_s_pres, sizeof(sm_pairing_packet_t));
+                uint8_t buffer[17];
+                buffer[0] = SM_CODE_SIGNING_INFORMATION;
+                reverse_128(setup->sm_local_csrk, &buffer[1]);
+                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
                 sm_timeout_reset(connection);
-                // SC Numeric Comparison will trigger user response after public keys & nonces have been exchanged
-                if (!setup->sm_use_secure_connections || setup->sm_stk_generation_method == JUST_WORKS){
-                    sm_trigger_user_response(connection);
-                }
                 return;
-#endif
+            }
 
-            case SM_PH2_SEND_PAIRING_RANDOM: {
-                uint8_t buffer[17];
-                buffer[0] = SM_CODE_PAIRING_RANDOM;
-                reverse_128(setup->sm_local_random, &buffer[1]);
-                if (IS_RESPONDER(connection->sm_role)){
-                    connection->sm_engine_state = SM_RESPONDER_PH2_W4_LTK_REQUEST;
+            // keys are sent
+            if (IS_RESPONDER(connection->sm_role)){
+                // slave -> receive master keys if any
+                if (sm_key_distribution_all_received(connection)){
+                    sm_key_distribution_handle_all_received(connection);
+                    connection->sm_engine_state = SM_RESPONDER_IDLE;
+                    sm_notify_client_status_reason(connection, ERROR_CODE_SUCCESS, 0);
+                    sm_done_for_handle(connection->sm_handle);
                 } else {
-                    connection->sm_engine_state = SM_INITIATOR_PH2_W4_PAIRING_RANDOM;
+                    connection->sm_engine_state = SM_PH3_RECEIVE_KEYS;
                 }
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                sm_timeout_reset(connection);
-                break;
+            } else {
+                // master -> all done
+                connection->sm_engine_state = SM_INITIATOR_CONNECTED;
+                sm_notify_client_status_reason(connection, ERROR_CODE_SUCCESS, 0);
+                sm_done_for_handle(connection->sm_handle);
             }
+            break;
 
-            case SM_PH2_C1_GET_ENC_A:
-                // already busy?
-                if (sm_aes128_state == SM_AES128_ACTIVE) break;
-                // calculate confirm using aes128 engine - step 1
-                sm_c1_t1(setup->sm_local_random, (uint8_t*) &setup->sm_m_preq, (uint8_t*) &setup->sm_s_pres, setup->sm_m_addr_type, setup->sm_s_addr_type, sm_aes128_plaintext);
-                connection->sm_engine_state = SM_PH2_C1_W4_ENC_A;
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_enc_a, connection);
-                break;
+        default:
+            break;
+    }
+}
 
-            case SM_PH2_C1_GET_ENC_C:
-                // already busy?
-                if (sm_aes128_state == SM_AES128_ACTIVE) break;
-                // calculate m_confirm using aes128 engine - step 1
-                sm_c1_t1(setup->sm_peer_random, (uint8_t*) &setup->sm_m_preq, (uint8_t*) &setup->sm_s_pres, setup->sm_m_addr_type, setup->sm_s_addr_type, sm_aes128_plaintext);
-                connection->sm_engine_state = SM_PH2_C1_W4_ENC_C;
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_enc_c, connection);
-                break;
+static void sm_run(void){
 
-            case SM_PH2_CALC_STK:
-                // already busy?
-                if (sm_aes128_state == SM_AES128_ACTIVE) break;
-                // calculate STK
-                if (IS_RESPONDER(connection->sm_role)){
-                    sm_s1_r_prime(setup->sm_local_random, setup->sm_peer_random, sm_aes128_plaintext);
-                } else {
-                    sm_s1_r_prime(setup->sm_peer_random, setup->sm_local_random, sm_aes128_plaintext);
-                }
-                connection->sm_engine_state = SM_PH2_W4_STK;
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_stk, connection);
-                break;
+    btstack_linked_list_iterator_t it;
 
-            case SM_PH3_Y_GET_ENC:
-                // already busy?
-                if (sm_aes128_state == SM_AES128_ACTIVE) break;
-                // PH3B2 - calculate Y from      - enc
-                // Y = dm(DHK, Rand)
-                sm_dm_r_prime(setup->sm_local_rand, sm_aes128_plaintext);
-                connection->sm_engine_state = SM_PH3_Y_W4_ENC;
-                sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_dhk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_enc_ph3_y, connection);
-                break;
+    // assert that stack has already bootet
+    if (hci_get_state() != HCI_STATE_WORKING) return;
 
-            case SM_PH2_C1_SEND_PAIRING_CONFIRM: {
-                uint8_t buffer[17];
-                buffer[0] = SM_CODE_PAIRING_CONFIRM;
-                reverse_128(setup->sm_local_confirm, &buffer[1]);
-                if (IS_RESPONDER(connection->sm_role)){
-                    connection->sm_engine_state = SM_RESPONDER_PH2_W4_PAIRING_RANDOM;
-                } else {
-                    connection->sm_engine_state = SM_INITIATOR_PH2_W4_PAIRING_CONFIRM;
-                }
-                l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                sm_timeout_reset(connection);
-                return;
-            }
-#ifdef ENABLE_LE_PERIPHERAL
-            case SM_RESPONDER_PH2_SEND_LTK_REPLY: {
-                sm_key_t stk_flipped;
-                reverse_128(setup->sm_ltk, stk_flipped);
-                connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
-                hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, stk_flipped);
+    // assert that we can send at least commands
+    if (!hci_can_send_command_packet_now()) return;
+
+    //
+    // non-connection related behaviour
+    //
+
+    // distributed key generation
+    switch (dkg_state){
+        case DKG_CALC_IRK:
+            // already busy?
+            if (sm_aes128_state == SM_AES128_IDLE) {
+                log_info("DKG_CALC_IRK started");
+                // IRK = d1(IR, 1, 0)
+                sm_d1_d_prime(1, 0, sm_aes128_plaintext);  // plaintext = d1 prime
+                sm_aes128_state = SM_AES128_ACTIVE;
+                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_ir, sm_aes128_plaintext, sm_persistent_irk, sm_handle_encryption_result_dkg_irk, NULL);
                 return;
             }
-            case SM_RESPONDER_PH4_SEND_LTK_REPLY: {
-                sm_key_t ltk_flipped;
-                reverse_128(setup->sm_ltk, ltk_flipped);
-                connection->sm_engine_state = SM_RESPONDER_IDLE;
-                hci_send_cmd(&hci_le_long_term_key_request_reply, connection->sm_handle, ltk_flipped);
-                sm_done_for_handle(connection->sm_handle);
+            break;
+        case DKG_CALC_DHK:
+            // already busy?
+            if (sm_aes128_state == SM_AES128_IDLE) {
+                log_info("DKG_CALC_DHK started");
+                // DHK = d1(IR, 3, 0)
+                sm_d1_d_prime(3, 0, sm_aes128_plaintext);  // plaintext = d1 prime
+                sm_aes128_state = SM_AES128_ACTIVE;
+                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_ir, sm_aes128_plaintext, sm_persistent_dhk, sm_handle_encryption_result_dkg_dhk, NULL);
                 return;
             }
-            case SM_RESPONDER_PH4_Y_GET_ENC:
-                // already busy?
-                if (sm_aes128_state == SM_AES128_ACTIVE) break;
-                log_info("LTK Request: recalculating with ediv 0x%04x", setup->sm_local_ediv);
-                // Y = dm(DHK, Rand)
-                sm_dm_r_prime(setup->sm_local_rand, sm_aes128_plaintext);
-                connection->sm_engine_state = SM_RESPONDER_PH4_Y_W4_ENC;
+            break;
+        default:
+            break;
+    }
+
+    // random address updates
+    switch (rau_state){
+        case RAU_GET_ENC:
+            // already busy?
+            if (sm_aes128_state == SM_AES128_IDLE) {
+                sm_ah_r_prime(sm_random_address, sm_aes128_plaintext);
                 sm_aes128_state = SM_AES128_ACTIVE;
-                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_dhk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_enc_ph4_y, connection);
-                return;
-#endif
-#ifdef ENABLE_LE_CENTRAL
-            case SM_INITIATOR_PH3_SEND_START_ENCRYPTION: {
-                sm_key_t stk_flipped;
-                reverse_128(setup->sm_ltk, stk_flipped);
-                connection->sm_engine_state = SM_PH2_W4_CONNECTION_ENCRYPTED;
-                hci_send_cmd(&hci_le_start_encryption, connection->sm_handle, 0, 0, 0, stk_flipped);
+                btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_irk, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_rau, NULL);
                 return;
             }
+            break;
+        case RAU_SET_ADDRESS:
+            log_info("New random address: %s", bd_addr_to_str(sm_random_address));
+            rau_state = RAU_IDLE;
+            hci_send_cmd(&hci_le_set_random_address, sm_random_address);
+            return;
+        default:
+            break;
+    }
+
+    // CSRK Lookup
+    // -- if csrk lookup ready, find connection that require csrk lookup
+    if (sm_address_resolution_idle()){
+        hci_connections_get_iterator(&it);
+        while(btstack_linked_list_iterator_has_next(&it)){
+            hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+            sm_connection_t  * sm_connection  = &hci_connection->sm_connection;
+            if (sm_connection->sm_irk_lookup_state == IRK_LOOKUP_W4_READY){
+                // and start lookup
+                sm_address_resolution_start_lookup(sm_connection->sm_peer_addr_type, sm_connection->sm_handle, sm_connection->sm_peer_address, ADDRESS_RESOLUTION_FOR_CONNECTION, sm_connection);
+                sm_connection->sm_irk_lookup_state = IRK_LOOKUP_STARTED;
+                break;
+            }
+        }
+    }
+
+    // -- if csrk lookup ready, resolved addresses for received addresses
+    if (sm_address_resolution_idle()) {
+        if (!btstack_linked_list_empty(&sm_address_resolution_general_queue)){
+            sm_lookup_entry_t * entry = (sm_lookup_entry_t *) sm_address_resolution_general_queue;
+            btstack_linked_list_remove(&sm_address_resolution_general_queue, (btstack_linked_item_t *) entry);
+            sm_address_resolution_start_lookup(entry->address_type, 0, entry->address, ADDRESS_RESOLUTION_GENERAL, NULL);
+            btstack_memory_sm_lookup_entry_free(entry);
+        }
+    }
+
+    // -- Continue with CSRK device lookup by public or resolvable private address
+    if (!sm_address_resolution_idle() && sm_address_resolution_test == 0){
+        // identity address can be looked up directly
+        int index = le_device_db_lookup_by_address(sm_address_resolution_addr_type, sm_address_resolution_address);
+        if (index >= 0){
+            log_info("LE Device Lookup: found CSRK by { addr_type, address} ");
+            sm_address_resolution_test = index;
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_SUCEEDED);
+        } else if (sm_address_resolution_addr_type == BD_ADDR_TYPE_LE_PUBLIC || (sm_address_resolution_address[0] & 0xc0) != 0x40){
+            // only resolvable private addresses can be resolved with an IRK
+            sm_address_resolution_test = le_device_db_max_count();
+        }
+    }
+    if (!sm_address_resolution_idle()){
+        log_info("LE Device Lookup: device %u/%u", sm_address_resolution_test, le_device_db_max_count());
+        while (sm_address_resolution_test < le_device_db_max_count()){
+            int addr_type;
+            bd_addr_t addr;
+            sm_key_t irk;
+            le_device_db_info(sm_address_resolution_test, &addr_type, addr, irk);
+
+            // skip unused entries
+            if (addr_type != BD_ADDR_TYPE_LE_PUBLIC && addr_type != BD_ADDR_TYPE_LE_RANDOM){
+                sm_address_resolution_test++;
+                continue;
+            }
+
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+            // skip entries on Controller's Resolving List, it already failed to resolve the address with their IRK
+            if (hci_le_resolving_list_contains_device_db_entry(sm_address_resolution_test)){
+                sm_address_resolution_test++;
+                continue;
+            }
 #endif
 
-            case SM_PH3_DISTRIBUTE_KEYS:
-                if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_ENCRYPTION_INFORMATION){
-                    setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_ENCRYPTION_INFORMATION;
-                    uint8_t buffer[17];
-                    buffer[0] = SM_CODE_ENCRYPTION_INFORMATION;
-                    reverse_128(setup->sm_ltk, &buffer[1]);
-                    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                    sm_timeout_reset(connection);
-                    return;
-                }
-                if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_MASTER_IDENTIFICATION){
-                    setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_MASTER_IDENTIFICATION;
-                    uint8_t buffer[11];
-                    buffer[0] = SM_CODE_MASTER_IDENTIFICATION;
-                    little_endian_store_16(buffer, 1, setup->sm_local_ediv);
-                    reverse_64(setup->sm_local_rand, &buffer[3]);
-                    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                    sm_timeout_reset(connection);
-                    return;
+            if (sm_aes128_state == SM_AES128_ACTIVE) break;
+
+            log_info("LE Device Lookup: calculate AH for device type %u, addr: %s", addr_type, bd_addr_to_str(addr));
+            log_info_key("IRK", irk);
+
+            memcpy(sm_aes128_key, irk, 16);
+            sm_ah_r_prime(sm_address_resolution_address, sm_aes128_plaintext);
+            sm_address_resolution_ah_calculation_active = 1;
+            sm_aes128_state = SM_AES128_ACTIVE;
+            btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_aes128_key, sm_aes128_plaintext, sm_aes128_ciphertext, sm_handle_encryption_result_address_resolution, NULL);
+            return;
+        }
+
+        if (sm_address_resolution_test >= le_device_db_max_count()){
+            log_info("LE Device Lookup: not found");
+            sm_address_resolution_handle_event(ADDRESS_RESOLUTION_FAILED);
+        }
+    }
+
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    switch (sm_sc_oob_state){
+        case SM_SC_OOB_W2_CALC_CONFIRM:
+            if (!sm_cmac_ready()) break;
+            sm_sc_oob_state = SM_SC_OOB_W4_CONFIRM;
+            f4_engine(NULL, ec_q, ec_q, sm_sc_oob_random, 0);
+            return;
+        default:
+            break;
+    }
+#endif
+
+    // handle basic actions that don't requires the full context
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        sm_connection_t  * sm_connection = &hci_connection->sm_connection;
+        switch(sm_connection->sm_engine_state){
+#ifdef ENABLE_LE_PERIPHERAL
+            case SM_RESPONDER_SEND_SECURITY_REQUEST:
+                // send packet if possible,
+                if (l2cap_can_send_fixed_channel_packet_now(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)){
+                    const uint8_t buffer[2] = { SM_CODE_SECURITY_REQUEST, SM_AUTHREQ_BONDING};
+                    sm_connection->sm_engine_state = SM_RESPONDER_PH1_W4_PAIRING_REQUEST;
+                    l2cap_send_connectionless(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
+                } else {
+                    l2cap_request_can_send_fix_channel_now_event(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
                 }
-                if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_INFORMATION){
-                    setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_INFORMATION;
-                    uint8_t buffer[17];
-                    buffer[0] = SM_CODE_IDENTITY_INFORMATION;
-                    reverse_128(sm_persistent_irk, &buffer[1]);
-                    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                    sm_timeout_reset(connection);
-                    return;
+                break;
+#endif
+            // responder side
+            case SM_RESPONDER_PH0_SEND_LTK_REQUESTED_NEGATIVE_REPLY:
+                sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
+                hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
+                return;
+
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+            case SM_SC_RECEIVED_LTK_REQUEST:
+                switch (sm_connection->sm_irk_lookup_state){
+                    case IRK_LOOKUP_FAILED:
+                        log_info("LTK Request: ediv & random are empty, but no stored LTK (IRK Lookup Failed)");
+                        sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
+                        hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
+                        return;
+                    default:
+                        break;
                 }
-                if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION){
-                    setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_IDENTITY_ADDRESS_INFORMATION;
-                    bd_addr_t local_address;
-                    uint8_t buffer[8];
-                    buffer[0] = SM_CODE_IDENTITY_ADDRESS_INFORMATION;
-                    switch (gap_random_address_get_mode()){
-                        case GAP_RANDOM_ADDRESS_TYPE_OFF:
-                        case GAP_RANDOM_ADDRESS_TYPE_STATIC:
-                            // public or static random
-                            gap_le_get_own_address(&buffer[1], local_address);
-                            break;
-                        case GAP_RANDOM_ADDRESS_NON_RESOLVABLE:
-                        case GAP_RANDOM_ADDRESS_RESOLVABLE:
-                            // fallback to public
-                            gap_local_bd_addr(local_address);
-                            buffer[1] = 0;
-                            break;
-                    }
-                    reverse_bd_addr(local_address, &buffer[2]);
-                    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                    sm_timeout_reset(connection);
-                    return;
+                break;
+#endif
+            case SM_GENERAL_SEND_PAIRING_FAILED:
+                // PDU received in wrong state before setup context was needed
+                if (sm_connection->sm_setup_context) break;
+                if (!l2cap_can_send_fixed_channel_packet_now(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL)){
+                    l2cap_request_can_send_fix_channel_now_event(sm_connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL);
+                    break;
                 }
-                if (setup->sm_key_distribution_send_set &   SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION){
-                    setup->sm_key_distribution_send_set &= ~SM_KEYDIST_FLAG_SIGNING_IDENTIFICATION;
+                sm_send_pairing_failed(sm_connection);
+                break;
+            default:
+                break;
+        }
+    }
 
-                    // hack to reproduce test runs
-                    if (test_use_fixed_local_csrk){
-                        memset(setup->sm_local_csrk, 0xcc, 16);
-                    }
+    // fetch setup context for connections that start pairing or encryption, if available
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        sm_connection_t  * sm_connection = &hci_connection->sm_connection;
+        if (sm_connection->sm_setup_context) continue;
+        if (!sm_setup_context_required(sm_connection)) continue;
+        sm_connection->sm_setup_context = sm_setup_context_alloc();
+        if (!sm_connection->sm_setup_context) {
+            // wait for other connection to release its setup context
+            log_info("sm: no setup context available for connection 0x%04x", sm_connection->sm_handle);
+            break;
+        }
+        setup = sm_connection->sm_setup_context;
+        log_info("sm: connection 0x%04x fetched setup context as %s, state %u", sm_connection->sm_handle, sm_connection->sm_role ? "responder" : "initiator", sm_connection->sm_engine_state);
+        int err;
+        UNUSED(err);
+        switch (sm_connection->sm_engine_state) {
+#ifdef ENABLE_LE_PERIPHERAL
+            case SM_RESPONDER_PH1_PAIRING_REQUEST_RECEIVED:
+                sm_reset_setup();
+                sm_init_setup(sm_connection);
+                // recover pairing request
+                memcpy(&setup->sm_m_preq, &sm_connection->sm_m_preq, sizeof(sm_pairing_packet_t));
+                err = sm_stk_generation_init(sm_connection);
 
-                    uint8_t buffer[17];
-                    buffer[0] = SM_CODE_SIGNING_INFORMATION;
-                    reverse_128(setup->sm_local_csrk, &buffer[1]);
-                    l2cap_send_connectionless(connection->sm_handle, L2CAP_CID_SECURITY_MANAGER_PROTOCOL, (uint8_t*) buffer, sizeof(buffer));
-                    sm_timeout_reset(connection);
-                    return;
+#ifdef ENABLE_TESTING_SUPPORT
+                if (0 < test_pairing_failure && test_pairing_failure < SM_REASON_DHKEY_CHECK_FAILED){
+                    log_info("testing_support: respond with pairing failure %u", test_pairing_failure);
+                    err = test_pairing_failure;
                 }
-
-                // keys are sent
-                if (IS_RESPONDER(connection->sm_role)){
-                    // slave -> receive master keys if any
-                    if (sm_key_distribution_all_received(connection)){
-                        sm_key_distribution_handle_all_received(connection);
-                        connection->sm_engine_state = SM_RESPONDER_IDLE;
-                        sm_notify_client_status_reason(connection, ERROR_CODE_SUCCESS, 0);
-                        sm_done_for_handle(connection->sm_handle);
-                    } else {
-                        connection->sm_engine_state = SM_PH3_RECEIVE_KEYS;
-                    }
-                } else {
-                    // master -> all done
-                    connection->sm_engine_state = SM_INITIATOR_CONNECTED;
-                    sm_notify_client_status_reason(connection, ERROR_CODE_SUCCESS, 0);
-                    sm_done_for_handle(connection->sm_handle);
+#endif
+                if (err){
+                    sm_connection->sm_pairing_failed_reason = err;
+                    sm_connection->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
+                    break;
                 }
+                sm_timeout_start(sm_connection);
+                // generate random number first, if we need to show passkey
+                if (setup->sm_stk_generation_method == PK_INIT_INPUT){
+                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph2_tk, sm_connection);
+                    break;
+                }
+                sm_connection->sm_engine_state = SM_RESPONDER_PH1_SEND_PAIRING_RESPONSE;
+                break;
+            case SM_RESPONDER_PH0_RECEIVED_LTK_REQUEST:
+                sm_reset_setup();
+                sm_start_calculating_ltk_from_ediv_and_rand(sm_connection);
+                break;
+#endif
+#ifdef ENABLE_LE_CENTRAL
+            case SM_INITIATOR_PH0_HAS_LTK:
+                sm_reset_setup();
+                sm_load_security_info(sm_connection);
+                sm_connection->sm_engine_state = SM_INITIATOR_PH0_SEND_START_ENCRYPTION;
                 break;
+            case SM_INITIATOR_PH1_W2_SEND_PAIRING_REQUEST:
+                sm_reset_setup();
+                sm_init_setup(sm_connection);
+                sm_timeout_start(sm_connection);
+                sm_connection->sm_engine_state = SM_INITIATOR_PH1_SEND_PAIRING_REQUEST;
+                break;
+#endif
 
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+            case SM_SC_RECEIVED_LTK_REQUEST:
+                switch (sm_connection->sm_irk_lookup_state){
+                    case IRK_LOOKUP_SUCCEEDED:
+                        // assuming Secure Connection, we have a stored LTK and the EDIV/RAND are null
+                        // start using context by loading security info
+                        sm_reset_setup();
+                        sm_load_security_info(sm_connection);
+                        if (setup->sm_peer_ediv == 0 && sm_is_null_random(setup->sm_peer_rand) && !sm_is_null_key(setup->sm_peer_ltk)){
+                            memcpy(setup->sm_ltk, setup->sm_peer_ltk, 16);
+                            sm_connection->sm_engine_state = SM_RESPONDER_PH4_SEND_LTK_REPLY;
+                            break;
+                        }
+                        log_info("LTK Request: ediv & random are empty, but no stored LTK (IRK Lookup Succeeded)");
+                        sm_connection->sm_engine_state = SM_RESPONDER_IDLE;
+                        hci_send_cmd(&hci_le_long_term_key_negative_reply, sm_connection->sm_handle);
+                        sm_done_for_handle(sm_connection->sm_handle);
+                        return;
+                    default:
+                        break;
+                }
+                break;
+#endif
             default:
                 break;
         }
+    }
 
-        // check again if active connection was released
-        if (sm_active_connection_handle != HCI_CON_HANDLE_INVALID) break;
+    // connection handling with setup context
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * hci_connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        sm_connection_t  * sm_connection = &hci_connection->sm_connection;
+        if (!sm_setup_context_select(sm_connection)) continue;
+        sm_run_for_connection(sm_connection);
+        // assert that we can still send commands
+        if (!hci_can_send_command_packet_now()) return;
     }
 }
 
-// sm_aes128_state stays active
 static void sm_handle_encryption_result_enc_a(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_c1_t3(sm_aes128_ciphertext, setup->sm_m_address, setup->sm_s_address, setup->sm_c1_t3_value);
-    btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, setup->sm_c1_t3_value, setup->sm_local_confirm, sm_handle_encryption_result_enc_b, connection);
+    if (!sm_setup_context_select(connection)) return;
+    sm_c1_t3(setup->sm_aes128_ciphertext, setup->sm_m_address, setup->sm_s_address, setup->sm_c1_t3_value);
+    btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_c1_t3_value, setup->sm_local_confirm, sm_handle_encryption_result_enc_b, connection);
 }
 
 static void sm_handle_encryption_result_enc_b(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_aes128_state = SM_AES128_IDLE;
+    if (!sm_setup_context_select(connection)) return;
     log_info_key("c1!", setup->sm_local_confirm);
     connection->sm_engine_state = SM_PH2_C1_SEND_PAIRING_CONFIRM;
     sm_run();
 }
 
-// sm_aes128_state stays active
 static void sm_handle_encryption_result_enc_c(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_c1_t3(sm_aes128_ciphertext, setup->sm_m_address, setup->sm_s_address, setup->sm_c1_t3_value);
-    btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, setup->sm_c1_t3_value, sm_aes128_ciphertext, sm_handle_encryption_result_enc_d, connection);
+    if (!sm_setup_context_select(connection)) return;
+    sm_c1_t3(setup->sm_aes128_ciphertext, setup->sm_m_address, setup->sm_s_address, setup->sm_c1_t3_value);
+    btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_c1_t3_value, setup->sm_aes128_ciphertext, sm_handle_encryption_result_enc_d, connection);
 }
 
 static void sm_handle_encryption_result_enc_d(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_aes128_state = SM_AES128_IDLE;
-    log_info_key("c1!", sm_aes128_ciphertext);
-    if (memcmp(setup->sm_peer_confirm, sm_aes128_ciphertext, 16) != 0){
-        setup->sm_pairing_failed_reason = SM_REASON_CONFIRM_VALUE_FAILED;
+    if (!sm_setup_context_select(connection)) return;
+    log_info_key("c1!", setup->sm_aes128_ciphertext);
+    if (memcmp(setup->sm_peer_confirm, setup->sm_aes128_ciphertext, 16) != 0){
+        connection->sm_pairing_failed_reason = SM_REASON_CONFIRM_VALUE_FAILED;
         connection->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
         sm_run();
         return;
@@ -2559,15 +2526,14 @@ static void sm_handle_encryption_result_enc_d(void * arg){
         connection->sm_engine_state = SM_PH2_SEND_PAIRING_RANDOM;
         sm_run();
     } else {
-        sm_s1_r_prime(setup->sm_peer_random, setup->sm_local_random, sm_aes128_plaintext);
-        sm_aes128_state = SM_AES128_ACTIVE;
-        btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, setup->sm_tk, sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_stk, connection);
+        sm_s1_r_prime(setup->sm_peer_random, setup->sm_local_random, setup->sm_aes128_plaintext);
+        btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, setup->sm_tk, setup->sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_stk, connection);
     }
 }
 
 static void sm_handle_encryption_result_enc_stk(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_aes128_state = SM_AES128_IDLE;
+    if (!sm_setup_context_select(connection)) return;
     sm_truncate_key(setup->sm_ltk, connection->sm_actual_encryption_key_size);
     log_info_key("stk", setup->sm_ltk);
     if (IS_RESPONDER(connection->sm_role)){
@@ -2578,25 +2544,25 @@ static void sm_handle_encryption_result_enc_stk(void *arg){
     sm_run();
 }
 
-// sm_aes128_state stays active
 static void sm_handle_encryption_result_enc_ph3_y(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    setup->sm_local_y = big_endian_read_16(sm_aes128_ciphertext, 14);
+    if (!sm_setup_context_select(connection)) return;
+    setup->sm_local_y = big_endian_read_16(setup->sm_aes128_ciphertext, 14);
     log_info_hex16("y", setup->sm_local_y);
     // PH3B3 - calculate EDIV
     setup->sm_local_ediv = setup->sm_local_y ^ setup->sm_local_div;
     log_info_hex16("ediv", setup->sm_local_ediv);
     // PH3B4 - calculate LTK         - enc
     // LTK = d1(ER, DIV, 0))
-    sm_d1_d_prime(setup->sm_local_div, 0, sm_aes128_plaintext);
-    btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_er, sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_ph3_ltk, connection);
+    sm_d1_d_prime(setup->sm_local_div, 0, setup->sm_aes128_plaintext);
+    btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, sm_persistent_er, setup->sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_ph3_ltk, connection);
 }
 
 #ifdef ENABLE_LE_PERIPHERAL
-// sm_aes128_state stays active
 static void sm_handle_encryption_result_enc_ph4_y(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    setup->sm_local_y = big_endian_read_16(sm_aes128_ciphertext, 14);
+    if (!sm_setup_context_select(connection)) return;
+    setup->sm_local_y = big_endian_read_16(setup->sm_aes128_ciphertext, 14);
     log_info_hex16("y", setup->sm_local_y);
 
     // PH3B3 - calculate DIV
@@ -2604,23 +2570,23 @@ static void sm_handle_encryption_result_enc_ph4_y(void *arg){
     log_info_hex16("ediv", setup->sm_local_ediv);
     // PH3B4 - calculate LTK         - enc
     // LTK = d1(ER, DIV, 0))
-    sm_d1_d_prime(setup->sm_local_div, 0, sm_aes128_plaintext);
-    btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_er, sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_ph4_ltk, connection);
+    sm_d1_d_prime(setup->sm_local_div, 0, setup->sm_aes128_plaintext);
+    btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, sm_persistent_er, setup->sm_aes128_plaintext, setup->sm_ltk, sm_handle_encryption_result_enc_ph4_ltk, connection);
 }
 #endif
 
-// sm_aes128_state stays active
 static void sm_handle_encryption_result_enc_ph3_ltk(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
+    if (!sm_setup_context_select(connection)) return;
     log_info_key("ltk", setup->sm_ltk);
     // calc CSRK next
-    sm_d1_d_prime(setup->sm_local_div, 1, sm_aes128_plaintext);
-    btstack_crypto_aes128_encrypt(&sm_crypto_aes128_request, sm_persistent_er, sm_aes128_plaintext, setup->sm_local_csrk, sm_handle_encryption_result_enc_csrk, connection);
+    sm_d1_d_prime(setup->sm_local_div, 1, setup->sm_aes128_plaintext);
+    btstack_crypto_aes128_encrypt(&setup->sm_crypto_aes128_request, sm_persistent_er, setup->sm_aes128_plaintext, setup->sm_local_csrk, sm_handle_encryption_result_enc_csrk, connection);
 }
 
 static void sm_handle_encryption_result_enc_csrk(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_aes128_state = SM_AES128_IDLE;
+    if (!sm_setup_context_select(connection)) return;
     log_info_key("csrk", setup->sm_local_csrk);
     if (setup->sm_key_distribution_send_set){
         connection->sm_engine_state = SM_PH3_DISTRIBUTE_KEYS;
@@ -2645,7 +2611,7 @@ static void sm_handle_encryption_result_enc_csrk(void *arg){
 #ifdef ENABLE_LE_PERIPHERAL
 static void sm_handle_encryption_result_enc_ph4_ltk(void *arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    sm_aes128_state = SM_AES128_IDLE;
+    if (!sm_setup_context_select(connection)) return;
     sm_truncate_key(setup->sm_ltk, connection->sm_actual_encryption_key_size);
     log_info_key("ltk", setup->sm_ltk);
     connection->sm_engine_state = SM_RESPONDER_PH4_SEND_LTK_REPLY;
@@ -2683,6 +2649,10 @@ static void sm_handle_encryption_result_dkg_dhk(void *arg){
     sm_aes128_state = SM_AES128_IDLE;
     log_info_key("dhk", sm_persistent_dhk);
     dkg_state = DKG_READY;
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+    // local IRK is known, load bonded devices into Controller's Resolving List
+    hci_le_resolving_list_set_local_irk(sm_persistent_irk);
+#endif
     // DKG calculation complete => SM Init Finished
     sm_run();
 }
@@ -2719,6 +2689,7 @@ static void sm_handle_random_result_rau(void * arg){
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
 static void sm_handle_random_result_sc_get_random(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
+    if (!sm_setup_context_select(connection)) return;
 
     // OOB
     if (setup->sm_stk_generation_method == OOB){
@@ -2739,17 +2710,19 @@ static void sm_handle_random_result_sc_get_random(void * arg){
 
 static void sm_handle_random_result_ph2_random(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
+    if (!sm_setup_context_select(connection)) return;
     connection->sm_engine_state = SM_PH2_C1_GET_ENC_A;
     sm_run();
 }
 
 static void sm_handle_random_result_ph2_tk(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
+    if (!sm_setup_context_select(connection)) return;
     sm_reset_tk();
     uint32_t tk;
     if (sm_fixed_passkey_in_display_role == 0xffffffff){
         // map random to 0-999999 without speding much cycles on a modulus operation
-        tk = little_endian_read_32(sm_random_data,0);
+        tk = little_endian_read_32(setup->sm_random_data,0);
         tk = tk & 0xfffff;  // 1048575
         if (tk >= 999999){
             tk = tk - 999999;
@@ -2769,7 +2742,7 @@ static void sm_handle_random_result_ph2_tk(void * arg){
             sm_trigger_user_response(connection);
             // response_idle == nothing <--> sm_trigger_user_response() did not require response
             if (setup->sm_user_response == SM_USER_RESPONSE_IDLE){
-                btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, connection);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, connection);
             }
         }
     }   
@@ -2778,8 +2751,9 @@ static void sm_handle_random_result_ph2_tk(void * arg){
 
 static void sm_handle_random_result_ph3_div(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
+    if (!sm_setup_context_select(connection)) return;
     // use 16 bit from random value as div
-    setup->sm_local_div = big_endian_read_16(sm_random_data, 0);
+    setup->sm_local_div = big_endian_read_16(setup->sm_random_data, 0);
     log_info_hex16("div", setup->sm_local_div);
     connection->sm_engine_state = SM_PH3_Y_GET_ENC;
     sm_run();
@@ -2787,12 +2761,13 @@ static void sm_handle_random_result_ph3_div(void * arg){
 
 static void sm_handle_random_result_ph3_random(void * arg){
     sm_connection_t * connection = (sm_connection_t*) arg;
-    reverse_64(sm_random_data, setup->sm_local_rand);
+    if (!sm_setup_context_select(connection)) return;
+    reverse_64(setup->sm_random_data, setup->sm_local_rand);
     // no db for encryption size hack: encryption size is stored in lowest nibble of setup->sm_local_rand
     setup->sm_local_rand[7] = (setup->sm_local_rand[7] & 0xf0) + (connection->sm_actual_encryption_key_size - 1);
     // no db for authenticated flag hack: store flag in bit 4 of LSB
     setup->sm_local_rand[7] = (setup->sm_local_rand[7] & 0xef) + (connection->sm_connection_authenticated << 4);
-    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 2, &sm_handle_random_result_ph3_div, connection);
+    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 2, &sm_handle_random_result_ph3_div, connection);
 }
 
 static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
@@ -2846,7 +2821,8 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
 
                             sm_conn->sm_handle = con_handle;
                             sm_conn->sm_role = packet[6];
-                            sm_conn->sm_peer_addr_type = packet[7];
+                            // peer address types 0x02/0x03: identity address resolved by Controller, found by address lookup
+                            sm_conn->sm_peer_addr_type = packet[7] & 1;
                             reverse_bd_addr(&packet[8], sm_conn->sm_peer_address);
 
                             log_info("New sm_conn, role %s", sm_conn->sm_role ? "slave" : "master");
@@ -2953,19 +2929,20 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                             sm_done_for_handle(sm_conn->sm_handle);
                             break;
                         case SM_PH2_W4_CONNECTION_ENCRYPTED:
+                            if (!sm_setup_context_select(sm_conn)) break;
                             if (IS_RESPONDER(sm_conn->sm_role)){
                                 // slave
                                 if (setup->sm_use_secure_connections){
                                     sm_conn->sm_engine_state = SM_PH3_DISTRIBUTE_KEYS;
                                 } else {
-                                    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
+                                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
                                 }
                             } else {
                                 // master
                                 if (sm_key_distribution_all_received(sm_conn)){
                                     // skip receiving keys as there are none
                                     sm_key_distribution_handle_all_received(sm_conn);
-                                    btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
+                                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
                                 } else {
                                     sm_conn->sm_engine_state = SM_PH3_RECEIVE_KEYS;
                                 }
@@ -2990,9 +2967,10 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                             sm_done_for_handle(sm_conn->sm_handle);
                             break;
                         case SM_PH2_W4_CONNECTION_ENCRYPTED:
+                            if (!sm_setup_context_select(sm_conn)) break;
                             if (IS_RESPONDER(sm_conn->sm_role)){
                                 // slave
-                                btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
+                                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
                             } else {
                                 // master
                                 sm_conn->sm_engine_state = SM_PH3_RECEIVE_KEYS;
@@ -3006,7 +2984,6 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
 
                 case HCI_EVENT_DISCONNECTION_COMPLETE:
                     con_handle = little_endian_read_16(packet, 3);
-                    sm_done_for_handle(con_handle);
                     sm_conn = sm_get_connection_for_handle(con_handle);
                     if (!sm_conn) break;
 
@@ -3014,6 +2991,9 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                     if (sm_conn->sm_role == 0
                         && sm_conn->sm_engine_state == SM_INITIATOR_PH0_W4_CONNECTION_ENCRYPTED
                         && packet[2] == ERROR_CODE_AUTHENTICATION_FAILURE){
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+                        hci_le_resolving_list_remove_device_db_entry(sm_conn->sm_le_db_index);
+#endif
                         le_device_db_remove(sm_conn->sm_le_db_index);
                     }
 
@@ -3022,6 +3002,9 @@ static void sm_event_packet_handler (uint8_t packet_type, uint16_t channel, uint
                         sm_notify_client_status_reason(sm_conn, ERROR_CODE_REMOTE_USER_TERMINATED_CONNECTION, 0);
                     }
 
+                    // release setup context
+                    sm_done_for_handle(con_handle);
+
                     sm_conn->sm_engine_state = SM_GENERAL_IDLE;
                     sm_conn->sm_handle = 0;
                     break;
@@ -3145,6 +3128,9 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
     sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
     if (!sm_conn) return;
 
+    // states that access setup are only reached with a setup context
+    setup = sm_conn->sm_setup_context;
+
     if (sm_pdu_code == SM_CODE_PAIRING_FAILED){
         sm_notify_client_status_reason(sm_conn, ERROR_CODE_AUTHENTICATION_FAILURE, packet[1]);
         sm_done_for_handle(con_handle);
@@ -3218,14 +3204,14 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
 #endif
 
             if (err){
-                setup->sm_pairing_failed_reason = err;
+                sm_conn->sm_pairing_failed_reason = err;
                 sm_conn->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
                 break;
             }
 
             // generate random number first, if we need to show passkey
             if (setup->sm_stk_generation_method == PK_RESP_INPUT){
-                btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph2_tk, sm_conn);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph2_tk, sm_conn);
                 break;
             }
 
@@ -3248,7 +3234,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             sm_trigger_user_response(sm_conn);
             // response_idle == nothing <--> sm_trigger_user_response() did not require response
             if (setup->sm_user_response == SM_USER_RESPONSE_IDLE){
-                btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
+                btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
             }
             break;
 
@@ -3319,7 +3305,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             }
 
             // start calculating dhkey
-            btstack_crypto_ecc_p256_calculate_dhkey(&sm_crypto_ecc_p256_request, setup->sm_peer_q, setup->sm_dhkey, sm_sc_dhkey_calculated, sm_conn);
+            btstack_crypto_ecc_p256_calculate_dhkey(&setup->sm_crypto_ecc_p256_request, setup->sm_peer_q, setup->sm_dhkey, sm_sc_dhkey_calculated, sm_conn);
 
 
             log_info("public key received, generation method %u", setup->sm_stk_generation_method);
@@ -3349,7 +3335,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
                     case OOB:
                         // generate Nx
                         log_info("Generate Na");
-                        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
+                        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
                         break;
                 }
             }
@@ -3383,7 +3369,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
                 // initiator
                 if (sm_just_works_or_numeric_comparison(setup->sm_stk_generation_method)){
                     // sm_conn->sm_engine_state = SM_SC_W2_GET_RANDOM_A;
-                    btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
+                    btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_nonce, 16, &sm_handle_random_result_sc_get_random, sm_conn);
                 } else {
                     sm_conn->sm_engine_state = SM_SC_SEND_PAIRING_RANDOM;
                 }
@@ -3493,7 +3479,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
 
             // handle user cancel pairing?
             if (setup->sm_user_response == SM_USER_RESPONSE_DECLINE){
-                setup->sm_pairing_failed_reason = SM_REASON_PASSKEY_ENTRY_FAILED;
+                sm_conn->sm_pairing_failed_reason = SM_REASON_PASSKEY_ENTRY_FAILED;
                 sm_conn->sm_engine_state = SM_GENERAL_SEND_PAIRING_FAILED;
                 break;
             }
@@ -3505,7 +3491,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
             }
 
             // calculate and send local_confirm
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
             break;
 
         case SM_RESPONDER_PH2_W4_PAIRING_RANDOM:
@@ -3570,7 +3556,7 @@ static void sm_pdu_handler(uint8_t packet_type, hci_con_handle_t con_handle, uin
                     if (setup->sm_use_secure_connections){
                         sm_conn->sm_engine_state = SM_PH3_DISTRIBUTE_KEYS;
                     } else {
-                        btstack_crypto_random_generate(&sm_crypto_random_request, sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
+                        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_random_data, 8, &sm_handle_random_result_ph3_random, sm_conn);
                     }
                 }
             }
@@ -3693,7 +3679,8 @@ void sm_init(void){
     sm_address_resolution_general_queue = NULL;
 
     gap_random_adress_update_period = 15 * 60 * 1000L;
-    sm_active_connection_handle = HCI_CON_HANDLE_INVALID;
+    sm_setup_context_builtin_in_use = 0;
+    setup = NULL;
 
     test_use_fixed_local_csrk = 0;
 
@@ -3807,6 +3794,7 @@ void sm_authorization_grant(hci_con_handle_t con_handle){
 void sm_bonding_decline(hci_con_handle_t con_handle){
     sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
     if (!sm_conn) return;     // wrong connection
+    if (!sm_setup_context_select(sm_conn)) return;    // not pairing
     setup->sm_user_response = SM_USER_RESPONSE_DECLINE;
     log_info("decline, state %u", sm_conn->sm_engine_state);
     switch(sm_conn->sm_engine_state){
@@ -3840,12 +3828,13 @@ void sm_bonding_decline(hci_con_handle_t con_handle){
 void sm_just_works_confirm(hci_con_handle_t con_handle){
     sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
     if (!sm_conn) return;     // wrong connection
+    if (!sm_setup_context_select(sm_conn)) return;    // not pairing
     setup->sm_user_response = SM_USER_RESPONSE_CONFIRM;
     if (sm_conn->sm_engine_state == SM_PH1_W4_USER_RESPONSE){
         if (setup->sm_use_secure_connections){
             sm_conn->sm_engine_state = SM_SC_SEND_PUBLIC_KEY_COMMAND;
         } else {
-            btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
+            btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
         }
     }
 
@@ -3866,11 +3855,12 @@ void sm_numeric_comparison_confirm(hci_con_handle_t con_handle){
 void sm_passkey_input(hci_con_handle_t con_handle, uint32_t passkey){
     sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
     if (!sm_conn) return;     // wrong connection
+    if (!sm_setup_context_select(sm_conn)) return;    // not pairing
     sm_reset_tk();
     big_endian_store_32(setup->sm_tk, 12, passkey);
     setup->sm_user_response = SM_USER_RESPONSE_PASSKEY;
     if (sm_conn->sm_engine_state == SM_PH1_W4_USER_RESPONSE){
-        btstack_crypto_random_generate(&sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
+        btstack_crypto_random_generate(&setup->sm_crypto_random_request, setup->sm_local_random, 16, &sm_handle_random_result_ph2_random, sm_conn);
     }
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
     memcpy(setup->sm_ra, setup->sm_tk, 16);
@@ -3885,6 +3875,7 @@ void sm_passkey_input(hci_con_handle_t con_handle, uint32_t passkey){
 void sm_keypress_notification(hci_con_handle_t con_handle, uint8_t action){
     sm_connection_t * sm_conn = sm_get_connection_for_handle(con_handle);
     if (!sm_conn) return;     // wrong connection
+    if (!sm_setup_context_select(sm_conn)) return;    // not pairing
     if (action > SM_KEYPRESS_PASSKEY_ENTRY_COMPLETED) return;
     uint8_t num_actions = setup->sm_keypress_notification >> 5;
     uint8_t flags = setup->sm_keypress_notification & 0x1f;
@@ -3966,6 +3957,11 @@ static uint8_t own_address_type(void){
     switch (gap_random_adress_type){
         case GAP_RANDOM_ADDRESS_TYPE_OFF:
             return BD_ADDR_TYPE_LE_PUBLIC;
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+        case GAP_RANDOM_ADDRESS_RESOLVABLE:
+            // Controller generates resolvable private address for devices on Resolving List, falls back to our random address
+            return BD_ADDR_TYPE_LE_PRIVAT_FALLBACK_RANDOM;
+#endif
         default:
             return BD_ADDR_TYPE_LE_RANDOM;
     }
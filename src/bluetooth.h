@@ -243,6 +243,9 @@ typedef enum {
 #define ERROR_CODE_CONNECTION_FAILED_TO_BE_ESTABLISHED     0x3E
 #define ERROR_CODE_MAC_CONNECTION_FAILED                   0x3F
 #define ERROR_CODE_COARSE_CLOCK_ADJUSTMENT_REJECTED_BUT_WILL_TRY_TO_ADJUST_USING_CLOCK_DRAGGING 0x40
+#define ERROR_CODE_TYPE0_SUBMAP_NOT_DEFINED                0x41
+#define ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER          0x42
+#define ERROR_CODE_LIMIT_REACHED                           0x43
 /* ENUM_END */
 
 /* ENUM_START: AVRCP_BROWSING_ERROR_CODE */
@@ -295,6 +298,48 @@ typedef enum {
 
 #define LE_ADVERTISING_DATA_SIZE    31
 
+// LE PHY as reported in HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+#define LE_PHY_1M                   1
+#define LE_PHY_2M                   2
+#define LE_PHY_CODED                3
+
+// LE PHY bitmask for LE Set (Default) PHY
+#define LE_PHY_MASK_1M              0x01
+#define LE_PHY_MASK_2M              0x02
+#define LE_PHY_MASK_CODED           0x04
+
+// LE Extended Advertising, max advertising data and max data per HCI command
+#define LE_EXTENDED_ADVERTISING_MAX_DATA_LEN        1650
+#define LE_EXTENDED_ADVERTISING_MAX_CHUNK_LEN       251
+
+// LE Extended Advertising Event Properties
+#define LE_ADVERTISING_EVENT_PROPERTIES_CONNECTABLE 0x0001
+#define LE_ADVERTISING_EVENT_PROPERTIES_SCANNABLE   0x0002
+#define LE_ADVERTISING_EVENT_PROPERTIES_DIRECTED    0x0004
+#define LE_ADVERTISING_EVENT_PROPERTIES_HIGH_DUTY   0x0008
+#define LE_ADVERTISING_EVENT_PROPERTIES_LEGACY      0x0010
+#define LE_ADVERTISING_EVENT_PROPERTIES_ANONYMOUS   0x0020
+#define LE_ADVERTISING_EVENT_PROPERTIES_TX_POWER    0x0040
+
+// LE Extended Advertising Data Operation
+#define LE_EXTENDED_ADVERTISING_OPERATION_INTERMEDIATE_FRAGMENT 0x00
+#define LE_EXTENDED_ADVERTISING_OPERATION_FIRST_FRAGMENT        0x01
+#define LE_EXTENDED_ADVERTISING_OPERATION_LAST_FRAGMENT         0x02
+#define LE_EXTENDED_ADVERTISING_OPERATION_COMPLETE_DATA         0x03
+
+// LE Extended Advertising Report Event Type: data status in bits 5-6
+#define LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_MASK         0x0060
+#define LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_COMPLETE     0x0000
+#define LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_INCOMPLETE   0x0020
+#define LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_TRUNCATED    0x0040
+
+// LE Data Length Extension, max time in us for 251 octets
+#define LE_DATA_LENGTH_MIN_OCTETS   27
+#define LE_DATA_LENGTH_MAX_OCTETS   251
+#define LE_DATA_LENGTH_MIN_TIME     328
+#define LE_DATA_LENGTH_MAX_TIME_1M  2120
+#define LE_DATA_LENGTH_MAX_TIME_CODED 17040
+
 /**
  * Default INQ Mode
  */
@@ -705,6 +750,44 @@ typedef enum {
 // array of advertisements, not handled by event accessor generator
 #define HCI_SUBEVENT_LE_DIRECT_ADVERTISING_REPORT          0x0B
 
+/**
+ * @format 11H11
+ * @param subevent_code
+ * @param status
+ * @param connection_handle
+ * @param tx_phy
+ * @param rx_phy
+ */
+#define HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE                0x0C
+
+// array of extended advertisements, not handled by event accessor generator
+#define HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT        0x0D
+
+/**
+ * @format 1
+ * @param subevent_code
+ */
+#define HCI_SUBEVENT_LE_SCAN_TIMEOUT                       0x11
+
+/**
+ * @format 111H1
+ * @param subevent_code
+ * @param status
+ * @param advertising_handle
+ * @param connection_handle
+ * @param num_completed_extended_advertising_events
+ */
+#define HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED         0x12
+
+/**
+ * @format 111B
+ * @param subevent_code
+ * @param advertising_handle
+ * @param scanner_address_type
+ * @param scanner_address
+ */
+#define HCI_SUBEVENT_LE_SCAN_REQUEST_RECEIVED              0x13
+
 /** 
  * L2CAP Layer
  */
@@ -110,6 +110,7 @@ static uint8_t btstack_crypto_initialized;
 static btstack_linked_list_t btstack_crypto_operations;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 static uint8_t btstack_crypto_wait_for_hci_result;
+static uint8_t btstack_crypto_ignore_hci_result;
 
 // state for AES-CMAC
 static btstack_crypto_cmac_state_t btstack_crypto_cmac_state;
@@ -133,6 +134,13 @@ static btstack_crypto_ecc_p256_key_generation_state_t btstack_crypto_ecc_p256_ke
 
 #ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
 static uint8_t btstack_crypto_ecc_p256_d[32];
+
+// DHKey calculation outside of run loop
+static void (*btstack_crypto_ecc_p256_worker)(void (*work)(void), void (*done)(void));
+static btstack_crypto_ecc_p256_t * btstack_crypto_ecc_p256_worker_request;
+static uint8_t btstack_crypto_ecc_p256_worker_active;
+static uint8_t btstack_crypto_ecc_p256_worker_public_key[64];
+static uint8_t btstack_crypto_ecc_p256_worker_dhkey[32];
 #endif
 
 #endif /* ENABLE_ECC_P256 */
@@ -432,16 +440,16 @@ static void btstack_crypto_ecc_p256_generate_key_software(void){
 }
 
 #ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
-static void btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ecc_p256_t * btstack_crypto_ec_p192){
-    memset(btstack_crypto_ec_p192->dhkey, 0, 32);
+static void btstack_crypto_ecc_p256_calculate_dhkey_software(const uint8_t * public_key, uint8_t * dhkey){
+    memset(dhkey, 0, 32);
 
 #ifdef USE_MICRO_ECC_P256
 #if uECC_SUPPORTS_secp256r1
     // standard version
-    uECC_shared_secret(btstack_crypto_ec_p192->public_key, btstack_crypto_ecc_p256_d, btstack_crypto_ec_p192->dhkey, uECC_secp256r1());
+    uECC_shared_secret(public_key, btstack_crypto_ecc_p256_d, dhkey, uECC_secp256r1());
 #else
     // static version
-    uECC_shared_secret(btstack_crypto_ec_p192->public_key, btstack_crypto_ecc_p256_d, btstack_crypto_ec_p192->dhkey);
+    uECC_shared_secret(public_key, btstack_crypto_ecc_p256_d, dhkey);
 #endif
 #endif
 
@@ -454,18 +462,36 @@ static void btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ecc_
     mbedtls_ecp_point_init(&Q);
     mbedtls_ecp_point_init(&DH);
     mbedtls_mpi_read_binary(&d, btstack_crypto_ecc_p256_d, 32);
-    mbedtls_mpi_read_binary(&Q.X, &btstack_crypto_ec_p192->public_key[0] , 32);
-    mbedtls_mpi_read_binary(&Q.Y, &btstack_crypto_ec_p192->public_key[32], 32);
+    mbedtls_mpi_read_binary(&Q.X, &public_key[0] , 32);
+    mbedtls_mpi_read_binary(&Q.Y, &public_key[32], 32);
     mbedtls_mpi_lset(&Q.Z, 1);
     mbedtls_ecp_mul(&mbedtls_ec_group, &DH, &d, &Q, NULL, NULL);
-    mbedtls_mpi_write_binary(&DH.X, btstack_crypto_ec_p192->dhkey, 32);
+    mbedtls_mpi_write_binary(&DH.X, dhkey, 32);
     mbedtls_ecp_point_free(&DH);
     mbedtls_mpi_free(&d);
     mbedtls_ecp_point_free(&Q);
 #endif
 
-    log_info("dhkey");
-    log_info_hexdump(btstack_crypto_ec_p192->dhkey, 32);
+}
+
+// called on worker, only uses buffers owned by btstack_crypto
+static void btstack_crypto_ecc_p256_worker_work(void){
+    btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ecc_p256_worker_public_key, btstack_crypto_ecc_p256_worker_dhkey);
+}
+
+// called on run loop thread
+static void btstack_crypto_ecc_p256_worker_done(void){
+    btstack_crypto_ecc_p256_t * btstack_crypto_ec_p192 = btstack_crypto_ecc_p256_worker_request;
+    btstack_crypto_ecc_p256_worker_active = 0;
+    btstack_crypto_ecc_p256_worker_request = NULL;
+    // request cancelled while worker was busy
+    if (btstack_crypto_ec_p192 != NULL){
+        memcpy(btstack_crypto_ec_p192->dhkey, btstack_crypto_ecc_p256_worker_dhkey, 32);
+        log_info("dhkey");
+        log_info_hexdump(btstack_crypto_ec_p192->dhkey, 32);
+        (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);
+    }
+    btstack_crypto_run();
 }
 #endif
 
@@ -561,6 +587,19 @@ static void btstack_crypto_run(void){
     if (!hci_can_send_command_packet_now()) return;
 
 	btstack_crypto_t * btstack_crypto = (btstack_crypto_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+
+#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+    // private key in use by worker, other operations can continue
+    if (btstack_crypto_ecc_p256_worker_active){
+        switch (btstack_crypto->operation){
+            case BTSTACK_CRYPTO_ECC_P256_GENERATE_KEY:
+            case BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY:
+                return;
+            default:
+                break;
+        }
+    }
+#endif
 	switch (btstack_crypto->operation){
 		case BTSTACK_CRYPTO_RANDOM:
 			btstack_crypto_wait_for_hci_result = 1;
@@ -649,7 +688,20 @@ static void btstack_crypto_run(void){
         case BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY:
             btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t *) btstack_crypto;
 #ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
-            btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ec_p192);
+            if (btstack_crypto_ecc_p256_worker){
+                // continue in btstack_crypto_ecc_p256_worker_done
+                btstack_linked_list_pop(&btstack_crypto_operations);
+                btstack_crypto_ecc_p256_worker_active = 1;
+                btstack_crypto_ecc_p256_worker_request = btstack_crypto_ec_p192;
+                memcpy(btstack_crypto_ecc_p256_worker_public_key, btstack_crypto_ec_p192->public_key, 64);
+                (*btstack_crypto_ecc_p256_worker)(&btstack_crypto_ecc_p256_worker_work, &btstack_crypto_ecc_p256_worker_done);
+                // start next operation
+                btstack_crypto_run();
+                break;
+            }
+            btstack_crypto_ecc_p256_calculate_dhkey_software(btstack_crypto_ec_p192->public_key, btstack_crypto_ec_p192->dhkey);
+            log_info("dhkey");
+            log_info_hexdump(btstack_crypto_ec_p192->dhkey, 32);
             // done
             btstack_linked_list_pop(&btstack_crypto_operations);
             (*btstack_crypto_ec_p192->btstack_crypto.context_callback.callback)(btstack_crypto_ec_p192->btstack_crypto.context_callback.context);                    
@@ -788,12 +840,20 @@ static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint
                 if (hci_get_state() != HCI_STATE_WORKING) return;
                 if (!btstack_crypto_wait_for_hci_result) return;
                 btstack_crypto_wait_for_hci_result = 0;
+                if (btstack_crypto_ignore_hci_result){
+                    btstack_crypto_ignore_hci_result = 0;
+                    break;
+                }
     	        btstack_crypto_handle_encryption_result(&packet[6]);
     	    }
     	    if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_rand)){
                 if (hci_get_state() != HCI_STATE_WORKING) return;
                 if (!btstack_crypto_wait_for_hci_result) return;
                 btstack_crypto_wait_for_hci_result = 0;
+                if (btstack_crypto_ignore_hci_result){
+                    btstack_crypto_ignore_hci_result = 0;
+                    break;
+                }
     	        btstack_crypto_handle_random_data(&packet[6], 8);
     	    }
             if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_read_local_supported_commands)){
@@ -814,10 +874,15 @@ static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint
 #ifndef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
         case HCI_EVENT_LE_META:
             btstack_crypto_ec_p192 = (btstack_crypto_ecc_p256_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
-            if (!btstack_crypto_ec_p192) break;
             switch (hci_event_le_meta_get_subevent_code(packet)){
                 case HCI_SUBEVENT_LE_READ_LOCAL_P256_PUBLIC_KEY_COMPLETE:
-                    if (btstack_crypto_ec_p192->btstack_crypto.operation != BTSTACK_CRYPTO_ECC_P256_GENERATE_KEY) break;
+                    if (btstack_crypto_ignore_hci_result){
+                        // request cancelled, but public key is kept for next request
+                        btstack_crypto_ignore_hci_result = 0;
+                    } else {
+                        if (!btstack_crypto_ec_p192) break;
+                        if (btstack_crypto_ec_p192->btstack_crypto.operation != BTSTACK_CRYPTO_ECC_P256_GENERATE_KEY) break;
+                    }
                     if (!btstack_crypto_wait_for_hci_result) return;
                     btstack_crypto_wait_for_hci_result = 0;
                     if (hci_subevent_le_read_local_p256_public_key_complete_get_status(packet)){
@@ -828,6 +893,12 @@ static void btstack_crypto_event_handler(uint8_t packet_type, uint16_t cid, uint
                     btstack_crypto_ecc_p256_key_generation_state = ECC_P256_KEY_GENERATION_DONE;
                     break;
                 case HCI_SUBEVENT_LE_GENERATE_DHKEY_COMPLETE:
+                    if (btstack_crypto_ignore_hci_result){
+                        btstack_crypto_ignore_hci_result = 0;
+                        btstack_crypto_wait_for_hci_result = 0;
+                        break;
+                    }
+                    if (!btstack_crypto_ec_p192) break;
                     if (btstack_crypto_ec_p192->btstack_crypto.operation != BTSTACK_CRYPTO_ECC_P256_CALCULATE_DHKEY) break;
                     if (!btstack_crypto_wait_for_hci_result) return;
                     btstack_crypto_wait_for_hci_result = 0;
@@ -861,6 +932,32 @@ void btstack_crypto_init(void){
     hci_add_event_handler(&hci_event_callback_registration);
 }
 
+void btstack_crypto_cancel(btstack_crypto_t * request){
+#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+    // DHKey calculated by worker, drop result in btstack_crypto_ecc_p256_worker_done
+    if ((btstack_crypto_t *) btstack_crypto_ecc_p256_worker_request == request){
+        btstack_crypto_ecc_p256_worker_request = NULL;
+        return;
+    }
+#endif
+    btstack_crypto_t * active = (btstack_crypto_t*) btstack_linked_list_get_first_item(&btstack_crypto_operations);
+    if (btstack_linked_list_remove(&btstack_crypto_operations, (btstack_linked_item_t *) request) != 0) return;
+    if (active != request) return;
+    // HCI Command for cancelled request still outstanding, ignore result
+    if (btstack_crypto_wait_for_hci_result){
+        btstack_crypto_ignore_hci_result = 1;
+    }
+    switch (request->operation){
+        case BTSTACK_CRYPTO_CMAC_GENERATOR:
+        case BTSTACK_CRYPTO_CMAC_MESSAGE:
+            btstack_crypto_cmac_state = CMAC_IDLE;
+            break;
+        default:
+            break;
+    }
+    btstack_crypto_run();
+}
+
 void btstack_crypto_random_generate(btstack_crypto_random_t * request, uint8_t * buffer, uint16_t size, void (* callback)(void * arg), void * callback_arg){
 	request->btstack_crypto.context_callback.callback  = callback;
 	request->btstack_crypto.context_callback.context   = callback_arg;
@@ -938,6 +1035,14 @@ void btstack_crypto_ecc_p256_calculate_dhkey(btstack_crypto_ecc_p256_t * request
     btstack_crypto_run();
 }
 
+void btstack_crypto_ecc_p256_set_worker(void (*execute)(void (*work)(void), void (*done)(void))){
+#ifdef USE_SOFTWARE_ECC_P256_IMPLEMENTATION
+    btstack_crypto_ecc_p256_worker = execute;
+#else
+    UNUSED(execute);
+#endif
+}
+
 int btstack_crypto_ecc_p256_validate_public_key(const uint8_t * public_key){
 
     // validate public key using micro-ecc
@@ -206,6 +206,20 @@ void btstack_crypto_ecc_p256_generate_key(btstack_crypto_ecc_p256_t * request, u
  */
 void btstack_crypto_ecc_p256_calculate_dhkey(btstack_crypto_ecc_p256_t * request, const uint8_t * public_key, uint8_t * dhkey, void (* callback)(void * arg), void * callback_arg);
 
+/**
+ * Cancel crypto operation, e.g. before freeing the request. Callback will not be called.
+ * @note outstanding results from HCI Controller or worker are dropped
+ * @param request
+ */
+void btstack_crypto_cancel(btstack_crypto_t * request);
+
+/**
+ * Execute software DHKey calculation outside of the run loop, e.g. on a worker thread, see btstack_worker_posix.h
+ * @note not used if LE Controller is used for ECC
+ * @param execute function that runs work and then calls done on the run loop thread
+ */
+void btstack_crypto_ecc_p256_set_worker(void (*execute)(void (*work)(void), void (*done)(void)));
+
 /*
  * Validate public key (not implemented for LE Controller ECC)
  * @param public_key (64 bytes)
@@ -997,6 +997,39 @@ typedef uint8_t sm_key_t[16];
  */
 #define GAP_EVENT_INQUIRY_COMPLETE                            0xE4
 
+/**
+ * @format 21B1111121BLV
+ * @param advertising_event_type
+ * @param address_type
+ * @param address
+ * @param primary_phy
+ * @param secondary_phy
+ * @param advertising_sid
+ * @param tx_power
+ * @param rssi
+ * @param periodic_advertising_interval
+ * @param direct_address_type
+ * @param direct_address
+ * @param data_length
+ * @param data
+ */
+#define GAP_EVENT_EXTENDED_ADVERTISING_REPORT                 0xE5
+
+/**
+ * @format B21
+ * @param bd_addr
+ * @param device_index
+ * @param name_state
+ */
+#define GAP_EVENT_INQUIRY_MANAGER_DEVICE                      0xE6
+
+/**
+ * @format 12
+ * @param status
+ * @param num_devices
+ */
+#define GAP_EVENT_INQUIRY_MANAGER_COMPLETE                    0xE7
+
 
 // Meta Events, see below for sub events
 #define HCI_EVENT_HSP_META                                 0xE8
@@ -1022,32 +1055,37 @@ typedef uint8_t sm_key_t[16];
 /** HSP Subevent */
 
 /**
- * @format 11
+ * @format 11HB
  * @param subevent_code
  * @param status 0 == OK
+ * @param acl_handle
+ * @param bd_addr
  */
 #define HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE             0x01
 
 /**
- * @format 11
+ * @format 11H
  * @param subevent_code
  * @param status 0 == OK
+ * @param acl_handle
  */
 #define HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE           0x02
 
 
 /**
- * @format 11H
+ * @format 11HH
  * @param subevent_code
  * @param status 0 == OK
  * @param handle
+ * @param acl_handle
  */
 #define HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE             0x03
 
 /**
- * @format 11
+ * @format 11H
  * @param subevent_code
  * @param status 0 == OK
+ * @param acl_handle
  */
 #define HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE          0x04
 
@@ -1058,22 +1096,25 @@ typedef uint8_t sm_key_t[16];
 #define HSP_SUBEVENT_RING                                  0x05
 
 /**
- * @format 11
+ * @format 11H
  * @param subevent_code
  * @param gain Valid range: [0,15]
+ * @param acl_handle
  */
 #define HSP_SUBEVENT_MICROPHONE_GAIN_CHANGED               0x06
 
 /**
- * @format 11
+ * @format 11H
  * @param subevent_code
  * @param gain Valid range: [0,15]
+ * @param acl_handle
  */
 #define HSP_SUBEVENT_SPEAKER_GAIN_CHANGED                  0x07
 
 /**
- * @format 1JV
+ * @format 1HJV
  * @param subevent_code
+ * @param acl_handle
  * @param value_length
  * @param value
  */
@@ -1286,20 +1327,32 @@ typedef uint8_t sm_key_t[16];
 #define ANCS_SUBEVENT_CLIENT_CONNECTED                              0xF0
 
 /**
- * @format 1H2T
+ * @format 1H
+ * @param subevent_code
+ * @param handle
+ */ 
+#define ANCS_SUBEVENT_CLIENT_DISCONNECTED                           0xF2
+
+/**
+ * @format 1H4122JV
  * @param subevent_code
  * @param handle
+ * @param notification_uid
  * @param attribute_id
- * @param text
+ * @param attribute_length
+ * @param offset
+ * @param value_length
+ * @param value
  */ 
-#define ANCS_SUBEVENT_CLIENT_NOTIFICATION                           0xF1
+#define ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK                        0xF3
 
 /**
- * @format 1H
+ * @format 1H4
  * @param subevent_code
  * @param handle
+ * @param notification_uid
  */ 
-#define ANCS_SUBEVENT_CLIENT_DISCONNECTED                           0xF2
+#define ANCS_SUBEVENT_CLIENT_NOTIFICATION_COMPLETE                  0xF4
 
 
 /** AVDTP Subevent */
@@ -2047,6 +2100,14 @@ typedef uint8_t sm_key_t[16];
 */
 #define HID_SUBEVENT_CAN_SEND_NOW                                          0x03
 
+/**
+ * @format 121
+ * @param subevent_code
+ * @param hid_cid
+ * @param protocol_mode
+*/
+#define HID_SUBEVENT_PROTOCOL_MODE                                         0x04
+
 // HIDS Meta Event Group
 
 /**
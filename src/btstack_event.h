@@ -3113,6 +3113,171 @@ static inline uint8_t gap_event_inquiry_complete_get_status(const uint8_t * even
     return event[2];
 }
 
+/**
+ * @brief Get field advertising_event_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return advertising_event_type
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_extended_advertising_report_get_advertising_event_type(const uint8_t * event){
+    return little_endian_read_16(event, 2);
+}
+/**
+ * @brief Get field address_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return address_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_address_type(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field address from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @param Pointer to storage for address
+ * @note: btstack_type B
+ */
+static inline void gap_event_extended_advertising_report_get_address(const uint8_t * event, bd_addr_t address){
+    reverse_bd_addr(&event[5], address);
+}
+/**
+ * @brief Get field primary_phy from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return primary_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_primary_phy(const uint8_t * event){
+    return event[11];
+}
+/**
+ * @brief Get field secondary_phy from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return secondary_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_secondary_phy(const uint8_t * event){
+    return event[12];
+}
+/**
+ * @brief Get field advertising_sid from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return advertising_sid
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_advertising_sid(const uint8_t * event){
+    return event[13];
+}
+/**
+ * @brief Get field tx_power from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return tx_power
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_tx_power(const uint8_t * event){
+    return event[14];
+}
+/**
+ * @brief Get field rssi from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return rssi
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_rssi(const uint8_t * event){
+    return event[15];
+}
+/**
+ * @brief Get field periodic_advertising_interval from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return periodic_advertising_interval
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_extended_advertising_report_get_periodic_advertising_interval(const uint8_t * event){
+    return little_endian_read_16(event, 16);
+}
+/**
+ * @brief Get field direct_address_type from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return direct_address_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_extended_advertising_report_get_direct_address_type(const uint8_t * event){
+    return event[18];
+}
+/**
+ * @brief Get field direct_address from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @param Pointer to storage for direct_address
+ * @note: btstack_type B
+ */
+static inline void gap_event_extended_advertising_report_get_direct_address(const uint8_t * event, bd_addr_t direct_address){
+    reverse_bd_addr(&event[19], direct_address);
+}
+/**
+ * @brief Get field data_length from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return data_length
+ * @note: btstack_type L
+ */
+static inline int gap_event_extended_advertising_report_get_data_length(const uint8_t * event){
+    return little_endian_read_16(event, 25);
+}
+/**
+ * @brief Get field data from event GAP_EVENT_EXTENDED_ADVERTISING_REPORT
+ * @param event packet
+ * @return data
+ * @note: btstack_type V
+ */
+static inline const uint8_t * gap_event_extended_advertising_report_get_data(const uint8_t * event){
+    return &event[27];
+}
+
+/**
+ * @brief Get field bd_addr from event GAP_EVENT_INQUIRY_MANAGER_DEVICE
+ * @param event packet
+ * @param Pointer to storage for bd_addr
+ * @note: btstack_type B
+ */
+static inline void gap_event_inquiry_manager_device_get_bd_addr(const uint8_t * event, bd_addr_t bd_addr){
+    reverse_bd_addr(&event[2], bd_addr);
+}
+/**
+ * @brief Get field device_index from event GAP_EVENT_INQUIRY_MANAGER_DEVICE
+ * @param event packet
+ * @return device_index
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_inquiry_manager_device_get_device_index(const uint8_t * event){
+    return little_endian_read_16(event, 8);
+}
+/**
+ * @brief Get field name_state from event GAP_EVENT_INQUIRY_MANAGER_DEVICE
+ * @param event packet
+ * @return name_state
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_inquiry_manager_device_get_name_state(const uint8_t * event){
+    return event[10];
+}
+
+/**
+ * @brief Get field status from event GAP_EVENT_INQUIRY_MANAGER_COMPLETE
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t gap_event_inquiry_manager_complete_get_status(const uint8_t * event){
+    return event[2];
+}
+/**
+ * @brief Get field num_devices from event GAP_EVENT_INQUIRY_MANAGER_COMPLETE
+ * @param event packet
+ * @return num_devices
+ * @note: btstack_type 2
+ */
+static inline uint16_t gap_event_inquiry_manager_complete_get_num_devices(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+
 /**
  * @brief Get field status from event HCI_SUBEVENT_LE_CONNECTION_COMPLETE
  * @param event packet
@@ -3536,6 +3701,109 @@ static inline uint8_t hci_subevent_le_enhanced_connection_complete_get_master_cl
     return event[32];
 }
 
+/**
+ * @brief Get field status from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_phy_update_complete_get_status(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field connection_handle from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param event packet
+ * @return connection_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_subevent_le_phy_update_complete_get_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
+/**
+ * @brief Get field tx_phy from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param event packet
+ * @return tx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_phy_update_complete_get_tx_phy(const uint8_t * event){
+    return event[6];
+}
+/**
+ * @brief Get field rx_phy from event HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param event packet
+ * @return rx_phy
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_phy_update_complete_get_rx_phy(const uint8_t * event){
+    return event[7];
+}
+
+
+/**
+ * @brief Get field status from event HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED
+ * @param event packet
+ * @return status
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_advertising_set_terminated_get_status(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field advertising_handle from event HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED
+ * @param event packet
+ * @return advertising_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_advertising_set_terminated_get_advertising_handle(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field connection_handle from event HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED
+ * @param event packet
+ * @return connection_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hci_subevent_le_advertising_set_terminated_get_connection_handle(const uint8_t * event){
+    return little_endian_read_16(event, 5);
+}
+/**
+ * @brief Get field num_completed_extended_advertising_events from event HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED
+ * @param event packet
+ * @return num_completed_extended_advertising_events
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_advertising_set_terminated_get_num_completed_extended_advertising_events(const uint8_t * event){
+    return event[7];
+}
+
+/**
+ * @brief Get field advertising_handle from event HCI_SUBEVENT_LE_SCAN_REQUEST_RECEIVED
+ * @param event packet
+ * @return advertising_handle
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_scan_request_received_get_advertising_handle(const uint8_t * event){
+    return event[3];
+}
+/**
+ * @brief Get field scanner_address_type from event HCI_SUBEVENT_LE_SCAN_REQUEST_RECEIVED
+ * @param event packet
+ * @return scanner_address_type
+ * @note: btstack_type 1
+ */
+static inline uint8_t hci_subevent_le_scan_request_received_get_scanner_address_type(const uint8_t * event){
+    return event[4];
+}
+/**
+ * @brief Get field scanner_address from event HCI_SUBEVENT_LE_SCAN_REQUEST_RECEIVED
+ * @param event packet
+ * @param Pointer to storage for scanner_address
+ * @note: btstack_type B
+ */
+static inline void hci_subevent_le_scan_request_received_get_scanner_address(const uint8_t * event, bd_addr_t scanner_address){
+    reverse_bd_addr(&event[5], scanner_address);
+}
+
 /**
  * @brief Get field status from event HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE
  * @param event packet
@@ -3545,6 +3813,24 @@ static inline uint8_t hci_subevent_le_enhanced_connection_complete_get_master_cl
 static inline uint8_t hsp_subevent_rfcomm_connection_complete_get_status(const uint8_t * event){
     return event[3];
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_rfcomm_connection_complete_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
+/**
+ * @brief Get field bd_addr from event HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE
+ * @param event packet
+ * @param Pointer to storage for bd_addr
+ * @note: btstack_type B
+ */
+static inline void hsp_subevent_rfcomm_connection_complete_get_bd_addr(const uint8_t * event, bd_addr_t bd_addr){
+    reverse_bd_addr(&event[6], bd_addr);
+}
 
 /**
  * @brief Get field status from event HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE
@@ -3555,6 +3841,15 @@ static inline uint8_t hsp_subevent_rfcomm_connection_complete_get_status(const u
 static inline uint8_t hsp_subevent_rfcomm_disconnection_complete_get_status(const uint8_t * event){
     return event[3];
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_rfcomm_disconnection_complete_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
 
 /**
  * @brief Get field status from event HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE
@@ -3574,6 +3869,15 @@ static inline uint8_t hsp_subevent_audio_connection_complete_get_status(const ui
 static inline hci_con_handle_t hsp_subevent_audio_connection_complete_get_handle(const uint8_t * event){
     return little_endian_read_16(event, 4);
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_audio_connection_complete_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 6);
+}
 
 /**
  * @brief Get field status from event HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE
@@ -3584,6 +3888,15 @@ static inline hci_con_handle_t hsp_subevent_audio_connection_complete_get_handle
 static inline uint8_t hsp_subevent_audio_disconnection_complete_get_status(const uint8_t * event){
     return event[3];
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_audio_disconnection_complete_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
 
 
 /**
@@ -3595,6 +3908,15 @@ static inline uint8_t hsp_subevent_audio_disconnection_complete_get_status(const
 static inline uint8_t hsp_subevent_microphone_gain_changed_get_gain(const uint8_t * event){
     return event[3];
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_MICROPHONE_GAIN_CHANGED
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_microphone_gain_changed_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
 
 /**
  * @brief Get field gain from event HSP_SUBEVENT_SPEAKER_GAIN_CHANGED
@@ -3605,7 +3927,25 @@ static inline uint8_t hsp_subevent_microphone_gain_changed_get_gain(const uint8_
 static inline uint8_t hsp_subevent_speaker_gain_changed_get_gain(const uint8_t * event){
     return event[3];
 }
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_SPEAKER_GAIN_CHANGED
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_speaker_gain_changed_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 4);
+}
 
+/**
+ * @brief Get field acl_handle from event HSP_SUBEVENT_HS_COMMAND
+ * @param event packet
+ * @return acl_handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t hsp_subevent_hs_command_get_acl_handle(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
 /**
  * @brief Get field value_length from event HSP_SUBEVENT_HS_COMMAND
  * @param event packet
@@ -3613,7 +3953,7 @@ static inline uint8_t hsp_subevent_speaker_gain_changed_get_gain(const uint8_t *
  * @note: btstack_type J
  */
 static inline int hsp_subevent_hs_command_get_value_length(const uint8_t * event){
-    return event[3];
+    return event[5];
 }
 /**
  * @brief Get field value from event HSP_SUBEVENT_HS_COMMAND
@@ -3622,7 +3962,7 @@ static inline int hsp_subevent_hs_command_get_value_length(const uint8_t * event
  * @note: btstack_type V
  */
 static inline const uint8_t * hsp_subevent_hs_command_get_value(const uint8_t * event){
-    return &event[4];
+    return &event[6];
 }
 
 /**
@@ -4007,44 +4347,101 @@ static inline hci_con_handle_t ancs_subevent_client_connected_get_handle(const u
 
 #ifdef ENABLE_BLE
 /**
- * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_NOTIFICATION
+ * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_DISCONNECTED
+ * @param event packet
+ * @return handle
+ * @note: btstack_type H
+ */
+static inline hci_con_handle_t ancs_subevent_client_disconnected_get_handle(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+#endif
+
+#ifdef ENABLE_BLE
+/**
+ * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
  * @param event packet
  * @return handle
  * @note: btstack_type H
  */
-static inline hci_con_handle_t ancs_subevent_client_notification_get_handle(const uint8_t * event){
+static inline hci_con_handle_t ancs_subevent_client_attribute_chunk_get_handle(const uint8_t * event){
     return little_endian_read_16(event, 3);
 }
 /**
- * @brief Get field attribute_id from event ANCS_SUBEVENT_CLIENT_NOTIFICATION
+ * @brief Get field notification_uid from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
+ * @param event packet
+ * @return notification_uid
+ * @note: btstack_type 4
+ */
+static inline uint32_t ancs_subevent_client_attribute_chunk_get_notification_uid(const uint8_t * event){
+    return little_endian_read_32(event, 5);
+}
+/**
+ * @brief Get field attribute_id from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
  * @param event packet
  * @return attribute_id
+ * @note: btstack_type 1
+ */
+static inline uint8_t ancs_subevent_client_attribute_chunk_get_attribute_id(const uint8_t * event){
+    return event[9];
+}
+/**
+ * @brief Get field attribute_length from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
+ * @param event packet
+ * @return attribute_length
  * @note: btstack_type 2
  */
-static inline uint16_t ancs_subevent_client_notification_get_attribute_id(const uint8_t * event){
-    return little_endian_read_16(event, 5);
+static inline uint16_t ancs_subevent_client_attribute_chunk_get_attribute_length(const uint8_t * event){
+    return little_endian_read_16(event, 10);
 }
 /**
- * @brief Get field text from event ANCS_SUBEVENT_CLIENT_NOTIFICATION
+ * @brief Get field offset from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
  * @param event packet
- * @return text
- * @note: btstack_type T
+ * @return offset
+ * @note: btstack_type 2
+ */
+static inline uint16_t ancs_subevent_client_attribute_chunk_get_offset(const uint8_t * event){
+    return little_endian_read_16(event, 12);
+}
+/**
+ * @brief Get field value_length from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
+ * @param event packet
+ * @return value_length
+ * @note: btstack_type J
  */
-static inline const char * ancs_subevent_client_notification_get_text(const uint8_t * event){
-    return (const char *) &event[7];
+static inline int ancs_subevent_client_attribute_chunk_get_value_length(const uint8_t * event){
+    return event[14];
+}
+/**
+ * @brief Get field value from event ANCS_SUBEVENT_CLIENT_ATTRIBUTE_CHUNK
+ * @param event packet
+ * @return value
+ * @note: btstack_type V
+ */
+static inline const uint8_t * ancs_subevent_client_attribute_chunk_get_value(const uint8_t * event){
+    return &event[15];
 }
 #endif
 
 #ifdef ENABLE_BLE
 /**
- * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_DISCONNECTED
+ * @brief Get field handle from event ANCS_SUBEVENT_CLIENT_NOTIFICATION_COMPLETE
  * @param event packet
  * @return handle
  * @note: btstack_type H
  */
-static inline hci_con_handle_t ancs_subevent_client_disconnected_get_handle(const uint8_t * event){
+static inline hci_con_handle_t ancs_subevent_client_notification_complete_get_handle(const uint8_t * event){
     return little_endian_read_16(event, 3);
 }
+/**
+ * @brief Get field notification_uid from event ANCS_SUBEVENT_CLIENT_NOTIFICATION_COMPLETE
+ * @param event packet
+ * @return notification_uid
+ * @note: btstack_type 4
+ */
+static inline uint32_t ancs_subevent_client_notification_complete_get_notification_uid(const uint8_t * event){
+    return little_endian_read_32(event, 5);
+}
 #endif
 
 /**
@@ -6516,6 +6913,25 @@ static inline uint16_t hid_subevent_can_send_now_get_hid_cid(const uint8_t * eve
     return little_endian_read_16(event, 3);
 }
 
+/**
+ * @brief Get field hid_cid from event HID_SUBEVENT_PROTOCOL_MODE
+ * @param event packet
+ * @return hid_cid
+ * @note: btstack_type 2
+ */
+static inline uint16_t hid_subevent_protocol_mode_get_hid_cid(const uint8_t * event){
+    return little_endian_read_16(event, 3);
+}
+/**
+ * @brief Get field protocol_mode from event HID_SUBEVENT_PROTOCOL_MODE
+ * @param event packet
+ * @return protocol_mode
+ * @note: btstack_type 1
+ */
+static inline uint8_t hid_subevent_protocol_mode_get_protocol_mode(const uint8_t * event){
+    return event[5];
+}
+
 /**
  * @brief Get field con_handle from event HIDS_SUBEVENT_CAN_SEND_NOW
  * @param event packet
@@ -47,6 +47,7 @@
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
@@ -71,22 +72,37 @@ hci_connection_t * btstack_memory_hci_connection_get(void){
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
     btstack_memory_pool_free(&hci_connection_pool, hci_connection);
 }
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&hci_connection_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t hci_connection_stats;
 hci_connection_t * btstack_memory_hci_connection_get(void){
+    btstack_memory_pool_stats_track_get(&hci_connection_stats, NULL);
     return NULL;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) hci_connection;
 };
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hci_connection_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t hci_connection_stats;
 hci_connection_t * btstack_memory_hci_connection_get(void){
-    return (hci_connection_t*) malloc(sizeof(hci_connection_t));
+    hci_connection_t * hci_connection = (hci_connection_t*) malloc(sizeof(hci_connection_t));
+    btstack_memory_pool_stats_track_get(&hci_connection_stats, hci_connection);
+    return hci_connection;
 }
 void btstack_memory_hci_connection_free(hci_connection_t *hci_connection){
+    btstack_memory_pool_stats_track_free(&hci_connection_stats, hci_connection);
     free(hci_connection);
 }
+void btstack_memory_hci_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hci_connection_stats;
+}
 #endif
 
 
@@ -110,22 +126,37 @@ l2cap_service_t * btstack_memory_l2cap_service_get(void){
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
     btstack_memory_pool_free(&l2cap_service_pool, l2cap_service);
 }
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&l2cap_service_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t l2cap_service_stats;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
+    btstack_memory_pool_stats_track_get(&l2cap_service_stats, NULL);
     return NULL;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
     // silence compiler warning about unused parameter in a portable way
     (void) l2cap_service;
 };
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_service_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t l2cap_service_stats;
 l2cap_service_t * btstack_memory_l2cap_service_get(void){
-    return (l2cap_service_t*) malloc(sizeof(l2cap_service_t));
+    l2cap_service_t * l2cap_service = (l2cap_service_t*) malloc(sizeof(l2cap_service_t));
+    btstack_memory_pool_stats_track_get(&l2cap_service_stats, l2cap_service);
+    return l2cap_service;
 }
 void btstack_memory_l2cap_service_free(l2cap_service_t *l2cap_service){
+    btstack_memory_pool_stats_track_free(&l2cap_service_stats, l2cap_service);
     free(l2cap_service);
 }
+void btstack_memory_l2cap_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_service_stats;
+}
 #endif
 
 
@@ -148,22 +179,37 @@ l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
     btstack_memory_pool_free(&l2cap_channel_pool, l2cap_channel);
 }
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&l2cap_channel_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t l2cap_channel_stats;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
+    btstack_memory_pool_stats_track_get(&l2cap_channel_stats, NULL);
     return NULL;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) l2cap_channel;
 };
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_channel_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t l2cap_channel_stats;
 l2cap_channel_t * btstack_memory_l2cap_channel_get(void){
-    return (l2cap_channel_t*) malloc(sizeof(l2cap_channel_t));
+    l2cap_channel_t * l2cap_channel = (l2cap_channel_t*) malloc(sizeof(l2cap_channel_t));
+    btstack_memory_pool_stats_track_get(&l2cap_channel_stats, l2cap_channel);
+    return l2cap_channel;
 }
 void btstack_memory_l2cap_channel_free(l2cap_channel_t *l2cap_channel){
+    btstack_memory_pool_stats_track_free(&l2cap_channel_stats, l2cap_channel);
     free(l2cap_channel);
 }
+void btstack_memory_l2cap_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = l2cap_channel_stats;
+}
 #endif
 
 
@@ -187,22 +233,37 @@ rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
     btstack_memory_pool_free(&rfcomm_multiplexer_pool, rfcomm_multiplexer);
 }
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_multiplexer_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t rfcomm_multiplexer_stats;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
+    btstack_memory_pool_stats_track_get(&rfcomm_multiplexer_stats, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_multiplexer;
 };
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_multiplexer_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_multiplexer_stats;
 rfcomm_multiplexer_t * btstack_memory_rfcomm_multiplexer_get(void){
-    return (rfcomm_multiplexer_t*) malloc(sizeof(rfcomm_multiplexer_t));
+    rfcomm_multiplexer_t * rfcomm_multiplexer = (rfcomm_multiplexer_t*) malloc(sizeof(rfcomm_multiplexer_t));
+    btstack_memory_pool_stats_track_get(&rfcomm_multiplexer_stats, rfcomm_multiplexer);
+    return rfcomm_multiplexer;
 }
 void btstack_memory_rfcomm_multiplexer_free(rfcomm_multiplexer_t *rfcomm_multiplexer){
+    btstack_memory_pool_stats_track_free(&rfcomm_multiplexer_stats, rfcomm_multiplexer);
     free(rfcomm_multiplexer);
 }
+void btstack_memory_rfcomm_multiplexer_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_multiplexer_stats;
+}
 #endif
 
 
@@ -225,22 +286,37 @@ rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
     btstack_memory_pool_free(&rfcomm_service_pool, rfcomm_service);
 }
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_service_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t rfcomm_service_stats;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
+    btstack_memory_pool_stats_track_get(&rfcomm_service_stats, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_service;
 };
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_service_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_service_stats;
 rfcomm_service_t * btstack_memory_rfcomm_service_get(void){
-    return (rfcomm_service_t*) malloc(sizeof(rfcomm_service_t));
+    rfcomm_service_t * rfcomm_service = (rfcomm_service_t*) malloc(sizeof(rfcomm_service_t));
+    btstack_memory_pool_stats_track_get(&rfcomm_service_stats, rfcomm_service);
+    return rfcomm_service;
 }
 void btstack_memory_rfcomm_service_free(rfcomm_service_t *rfcomm_service){
+    btstack_memory_pool_stats_track_free(&rfcomm_service_stats, rfcomm_service);
     free(rfcomm_service);
 }
+void btstack_memory_rfcomm_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_service_stats;
+}
 #endif
 
 
@@ -263,22 +339,37 @@ rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
     btstack_memory_pool_free(&rfcomm_channel_pool, rfcomm_channel);
 }
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&rfcomm_channel_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t rfcomm_channel_stats;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
+    btstack_memory_pool_stats_track_get(&rfcomm_channel_stats, NULL);
     return NULL;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) rfcomm_channel;
 };
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_channel_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t rfcomm_channel_stats;
 rfcomm_channel_t * btstack_memory_rfcomm_channel_get(void){
-    return (rfcomm_channel_t*) malloc(sizeof(rfcomm_channel_t));
+    rfcomm_channel_t * rfcomm_channel = (rfcomm_channel_t*) malloc(sizeof(rfcomm_channel_t));
+    btstack_memory_pool_stats_track_get(&rfcomm_channel_stats, rfcomm_channel);
+    return rfcomm_channel;
 }
 void btstack_memory_rfcomm_channel_free(rfcomm_channel_t *rfcomm_channel){
+    btstack_memory_pool_stats_track_free(&rfcomm_channel_stats, rfcomm_channel);
     free(rfcomm_channel);
 }
+void btstack_memory_rfcomm_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = rfcomm_channel_stats;
+}
 #endif
 
 
@@ -302,22 +393,37 @@ btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_e
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
     btstack_memory_pool_free(&btstack_link_key_db_memory_entry_pool, btstack_link_key_db_memory_entry);
 }
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&btstack_link_key_db_memory_entry_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t btstack_link_key_db_memory_entry_stats;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
+    btstack_memory_pool_stats_track_get(&btstack_link_key_db_memory_entry_stats, NULL);
     return NULL;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) btstack_link_key_db_memory_entry;
 };
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = btstack_link_key_db_memory_entry_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t btstack_link_key_db_memory_entry_stats;
 btstack_link_key_db_memory_entry_t * btstack_memory_btstack_link_key_db_memory_entry_get(void){
-    return (btstack_link_key_db_memory_entry_t*) malloc(sizeof(btstack_link_key_db_memory_entry_t));
+    btstack_link_key_db_memory_entry_t * btstack_link_key_db_memory_entry = (btstack_link_key_db_memory_entry_t*) malloc(sizeof(btstack_link_key_db_memory_entry_t));
+    btstack_memory_pool_stats_track_get(&btstack_link_key_db_memory_entry_stats, btstack_link_key_db_memory_entry);
+    return btstack_link_key_db_memory_entry;
 }
 void btstack_memory_btstack_link_key_db_memory_entry_free(btstack_link_key_db_memory_entry_t *btstack_link_key_db_memory_entry){
+    btstack_memory_pool_stats_track_free(&btstack_link_key_db_memory_entry_stats, btstack_link_key_db_memory_entry);
     free(btstack_link_key_db_memory_entry);
 }
+void btstack_memory_btstack_link_key_db_memory_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = btstack_link_key_db_memory_entry_stats;
+}
 #endif
 
 
@@ -341,22 +447,37 @@ bnep_service_t * btstack_memory_bnep_service_get(void){
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
     btstack_memory_pool_free(&bnep_service_pool, bnep_service);
 }
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&bnep_service_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t bnep_service_stats;
 bnep_service_t * btstack_memory_bnep_service_get(void){
+    btstack_memory_pool_stats_track_get(&bnep_service_stats, NULL);
     return NULL;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
     // silence compiler warning about unused parameter in a portable way
     (void) bnep_service;
 };
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_service_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t bnep_service_stats;
 bnep_service_t * btstack_memory_bnep_service_get(void){
-    return (bnep_service_t*) malloc(sizeof(bnep_service_t));
+    bnep_service_t * bnep_service = (bnep_service_t*) malloc(sizeof(bnep_service_t));
+    btstack_memory_pool_stats_track_get(&bnep_service_stats, bnep_service);
+    return bnep_service;
 }
 void btstack_memory_bnep_service_free(bnep_service_t *bnep_service){
+    btstack_memory_pool_stats_track_free(&bnep_service_stats, bnep_service);
     free(bnep_service);
 }
+void btstack_memory_bnep_service_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_service_stats;
+}
 #endif
 
 
@@ -379,22 +500,37 @@ bnep_channel_t * btstack_memory_bnep_channel_get(void){
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
     btstack_memory_pool_free(&bnep_channel_pool, bnep_channel);
 }
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&bnep_channel_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t bnep_channel_stats;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
+    btstack_memory_pool_stats_track_get(&bnep_channel_stats, NULL);
     return NULL;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
     // silence compiler warning about unused parameter in a portable way
     (void) bnep_channel;
 };
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_channel_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t bnep_channel_stats;
 bnep_channel_t * btstack_memory_bnep_channel_get(void){
-    return (bnep_channel_t*) malloc(sizeof(bnep_channel_t));
+    bnep_channel_t * bnep_channel = (bnep_channel_t*) malloc(sizeof(bnep_channel_t));
+    btstack_memory_pool_stats_track_get(&bnep_channel_stats, bnep_channel);
+    return bnep_channel;
 }
 void btstack_memory_bnep_channel_free(bnep_channel_t *bnep_channel){
+    btstack_memory_pool_stats_track_free(&bnep_channel_stats, bnep_channel);
     free(bnep_channel);
 }
+void btstack_memory_bnep_channel_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = bnep_channel_stats;
+}
 #endif
 
 
@@ -418,22 +554,37 @@ hfp_connection_t * btstack_memory_hfp_connection_get(void){
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
     btstack_memory_pool_free(&hfp_connection_pool, hfp_connection);
 }
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&hfp_connection_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t hfp_connection_stats;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
+    btstack_memory_pool_stats_track_get(&hfp_connection_stats, NULL);
     return NULL;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) hfp_connection;
 };
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hfp_connection_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t hfp_connection_stats;
 hfp_connection_t * btstack_memory_hfp_connection_get(void){
-    return (hfp_connection_t*) malloc(sizeof(hfp_connection_t));
+    hfp_connection_t * hfp_connection = (hfp_connection_t*) malloc(sizeof(hfp_connection_t));
+    btstack_memory_pool_stats_track_get(&hfp_connection_stats, hfp_connection);
+    return hfp_connection;
 }
 void btstack_memory_hfp_connection_free(hfp_connection_t *hfp_connection){
+    btstack_memory_pool_stats_track_free(&hfp_connection_stats, hfp_connection);
     free(hfp_connection);
 }
+void btstack_memory_hfp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = hfp_connection_stats;
+}
 #endif
 
 
@@ -457,22 +608,37 @@ service_record_item_t * btstack_memory_service_record_item_get(void){
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
     btstack_memory_pool_free(&service_record_item_pool, service_record_item);
 }
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&service_record_item_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t service_record_item_stats;
 service_record_item_t * btstack_memory_service_record_item_get(void){
+    btstack_memory_pool_stats_track_get(&service_record_item_stats, NULL);
     return NULL;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
     // silence compiler warning about unused parameter in a portable way
     (void) service_record_item;
 };
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = service_record_item_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t service_record_item_stats;
 service_record_item_t * btstack_memory_service_record_item_get(void){
-    return (service_record_item_t*) malloc(sizeof(service_record_item_t));
+    service_record_item_t * service_record_item = (service_record_item_t*) malloc(sizeof(service_record_item_t));
+    btstack_memory_pool_stats_track_get(&service_record_item_stats, service_record_item);
+    return service_record_item;
 }
 void btstack_memory_service_record_item_free(service_record_item_t *service_record_item){
+    btstack_memory_pool_stats_track_free(&service_record_item_stats, service_record_item);
     free(service_record_item);
 }
+void btstack_memory_service_record_item_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = service_record_item_stats;
+}
 #endif
 
 
@@ -496,22 +662,37 @@ avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
     btstack_memory_pool_free(&avdtp_stream_endpoint_pool, avdtp_stream_endpoint);
 }
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avdtp_stream_endpoint_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t avdtp_stream_endpoint_stats;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
+    btstack_memory_pool_stats_track_get(&avdtp_stream_endpoint_stats, NULL);
     return NULL;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
     // silence compiler warning about unused parameter in a portable way
     (void) avdtp_stream_endpoint;
 };
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_stream_endpoint_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avdtp_stream_endpoint_stats;
 avdtp_stream_endpoint_t * btstack_memory_avdtp_stream_endpoint_get(void){
-    return (avdtp_stream_endpoint_t*) malloc(sizeof(avdtp_stream_endpoint_t));
+    avdtp_stream_endpoint_t * avdtp_stream_endpoint = (avdtp_stream_endpoint_t*) malloc(sizeof(avdtp_stream_endpoint_t));
+    btstack_memory_pool_stats_track_get(&avdtp_stream_endpoint_stats, avdtp_stream_endpoint);
+    return avdtp_stream_endpoint;
 }
 void btstack_memory_avdtp_stream_endpoint_free(avdtp_stream_endpoint_t *avdtp_stream_endpoint){
+    btstack_memory_pool_stats_track_free(&avdtp_stream_endpoint_stats, avdtp_stream_endpoint);
     free(avdtp_stream_endpoint);
 }
+void btstack_memory_avdtp_stream_endpoint_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_stream_endpoint_stats;
+}
 #endif
 
 
@@ -535,22 +716,37 @@ avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
     btstack_memory_pool_free(&avdtp_connection_pool, avdtp_connection);
 }
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avdtp_connection_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t avdtp_connection_stats;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
+    btstack_memory_pool_stats_track_get(&avdtp_connection_stats, NULL);
     return NULL;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avdtp_connection;
 };
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_connection_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avdtp_connection_stats;
 avdtp_connection_t * btstack_memory_avdtp_connection_get(void){
-    return (avdtp_connection_t*) malloc(sizeof(avdtp_connection_t));
+    avdtp_connection_t * avdtp_connection = (avdtp_connection_t*) malloc(sizeof(avdtp_connection_t));
+    btstack_memory_pool_stats_track_get(&avdtp_connection_stats, avdtp_connection);
+    return avdtp_connection;
 }
 void btstack_memory_avdtp_connection_free(avdtp_connection_t *avdtp_connection){
+    btstack_memory_pool_stats_track_free(&avdtp_connection_stats, avdtp_connection);
     free(avdtp_connection);
 }
+void btstack_memory_avdtp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avdtp_connection_stats;
+}
 #endif
 
 
@@ -574,22 +770,37 @@ avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
     btstack_memory_pool_free(&avrcp_connection_pool, avrcp_connection);
 }
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avrcp_connection_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t avrcp_connection_stats;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
+    btstack_memory_pool_stats_track_get(&avrcp_connection_stats, NULL);
     return NULL;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avrcp_connection;
 };
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_connection_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avrcp_connection_stats;
 avrcp_connection_t * btstack_memory_avrcp_connection_get(void){
-    return (avrcp_connection_t*) malloc(sizeof(avrcp_connection_t));
+    avrcp_connection_t * avrcp_connection = (avrcp_connection_t*) malloc(sizeof(avrcp_connection_t));
+    btstack_memory_pool_stats_track_get(&avrcp_connection_stats, avrcp_connection);
+    return avrcp_connection;
 }
 void btstack_memory_avrcp_connection_free(avrcp_connection_t *avrcp_connection){
+    btstack_memory_pool_stats_track_free(&avrcp_connection_stats, avrcp_connection);
     free(avrcp_connection);
 }
+void btstack_memory_avrcp_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_connection_stats;
+}
 #endif
 
 
@@ -613,22 +824,37 @@ avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void)
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
     btstack_memory_pool_free(&avrcp_browsing_connection_pool, avrcp_browsing_connection);
 }
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&avrcp_browsing_connection_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t avrcp_browsing_connection_stats;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
+    btstack_memory_pool_stats_track_get(&avrcp_browsing_connection_stats, NULL);
     return NULL;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
     // silence compiler warning about unused parameter in a portable way
     (void) avrcp_browsing_connection;
 };
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_browsing_connection_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t avrcp_browsing_connection_stats;
 avrcp_browsing_connection_t * btstack_memory_avrcp_browsing_connection_get(void){
-    return (avrcp_browsing_connection_t*) malloc(sizeof(avrcp_browsing_connection_t));
+    avrcp_browsing_connection_t * avrcp_browsing_connection = (avrcp_browsing_connection_t*) malloc(sizeof(avrcp_browsing_connection_t));
+    btstack_memory_pool_stats_track_get(&avrcp_browsing_connection_stats, avrcp_browsing_connection);
+    return avrcp_browsing_connection;
 }
 void btstack_memory_avrcp_browsing_connection_free(avrcp_browsing_connection_t *avrcp_browsing_connection){
+    btstack_memory_pool_stats_track_free(&avrcp_browsing_connection_stats, avrcp_browsing_connection);
     free(avrcp_browsing_connection);
 }
+void btstack_memory_avrcp_browsing_connection_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = avrcp_browsing_connection_stats;
+}
 #endif
 
 
@@ -653,22 +879,37 @@ gatt_client_t * btstack_memory_gatt_client_get(void){
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
     btstack_memory_pool_free(&gatt_client_pool, gatt_client);
 }
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&gatt_client_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t gatt_client_stats;
 gatt_client_t * btstack_memory_gatt_client_get(void){
+    btstack_memory_pool_stats_track_get(&gatt_client_stats, NULL);
     return NULL;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
     // silence compiler warning about unused parameter in a portable way
     (void) gatt_client;
 };
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = gatt_client_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t gatt_client_stats;
 gatt_client_t * btstack_memory_gatt_client_get(void){
-    return (gatt_client_t*) malloc(sizeof(gatt_client_t));
+    gatt_client_t * gatt_client = (gatt_client_t*) malloc(sizeof(gatt_client_t));
+    btstack_memory_pool_stats_track_get(&gatt_client_stats, gatt_client);
+    return gatt_client;
 }
 void btstack_memory_gatt_client_free(gatt_client_t *gatt_client){
+    btstack_memory_pool_stats_track_free(&gatt_client_stats, gatt_client);
     free(gatt_client);
 }
+void btstack_memory_gatt_client_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = gatt_client_stats;
+}
 #endif
 
 
@@ -691,22 +932,37 @@ whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
     btstack_memory_pool_free(&whitelist_entry_pool, whitelist_entry);
 }
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&whitelist_entry_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t whitelist_entry_stats;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
+    btstack_memory_pool_stats_track_get(&whitelist_entry_stats, NULL);
     return NULL;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) whitelist_entry;
 };
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = whitelist_entry_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t whitelist_entry_stats;
 whitelist_entry_t * btstack_memory_whitelist_entry_get(void){
-    return (whitelist_entry_t*) malloc(sizeof(whitelist_entry_t));
+    whitelist_entry_t * whitelist_entry = (whitelist_entry_t*) malloc(sizeof(whitelist_entry_t));
+    btstack_memory_pool_stats_track_get(&whitelist_entry_stats, whitelist_entry);
+    return whitelist_entry;
 }
 void btstack_memory_whitelist_entry_free(whitelist_entry_t *whitelist_entry){
+    btstack_memory_pool_stats_track_free(&whitelist_entry_stats, whitelist_entry);
     free(whitelist_entry);
 }
+void btstack_memory_whitelist_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = whitelist_entry_stats;
+}
 #endif
 
 
@@ -729,22 +985,90 @@ sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
     btstack_memory_pool_free(&sm_lookup_entry_pool, sm_lookup_entry);
 }
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&sm_lookup_entry_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t sm_lookup_entry_stats;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
+    btstack_memory_pool_stats_track_get(&sm_lookup_entry_stats, NULL);
     return NULL;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
     // silence compiler warning about unused parameter in a portable way
     (void) sm_lookup_entry;
 };
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = sm_lookup_entry_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t sm_lookup_entry_stats;
 sm_lookup_entry_t * btstack_memory_sm_lookup_entry_get(void){
-    return (sm_lookup_entry_t*) malloc(sizeof(sm_lookup_entry_t));
+    sm_lookup_entry_t * sm_lookup_entry = (sm_lookup_entry_t*) malloc(sizeof(sm_lookup_entry_t));
+    btstack_memory_pool_stats_track_get(&sm_lookup_entry_stats, sm_lookup_entry);
+    return sm_lookup_entry;
 }
 void btstack_memory_sm_lookup_entry_free(sm_lookup_entry_t *sm_lookup_entry){
+    btstack_memory_pool_stats_track_free(&sm_lookup_entry_stats, sm_lookup_entry);
     free(sm_lookup_entry);
 }
+void btstack_memory_sm_lookup_entry_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = sm_lookup_entry_stats;
+}
+#endif
+
+
+// MARK: sm_setup_context_t
+#if !defined(HAVE_MALLOC) && !defined(MAX_NR_SM_SETUP_CONTEXTS)
+    #if defined(MAX_NO_SM_SETUP_CONTEXTS)
+        #error "Deprecated MAX_NO_SM_SETUP_CONTEXTS defined instead of MAX_NR_SM_SETUP_CONTEXTS. Please update your btstack_config.h to use MAX_NR_SM_SETUP_CONTEXTS."
+    #else
+        #define MAX_NR_SM_SETUP_CONTEXTS 0
+    #endif
+#endif
+
+#ifdef MAX_NR_SM_SETUP_CONTEXTS
+#if MAX_NR_SM_SETUP_CONTEXTS > 0
+static sm_setup_context_t sm_setup_context_storage[MAX_NR_SM_SETUP_CONTEXTS];
+static btstack_memory_pool_t sm_setup_context_pool;
+sm_setup_context_t * btstack_memory_sm_setup_context_get(void){
+    return (sm_setup_context_t *) btstack_memory_pool_get(&sm_setup_context_pool);
+}
+void btstack_memory_sm_setup_context_free(sm_setup_context_t *sm_setup_context){
+    btstack_memory_pool_free(&sm_setup_context_pool, sm_setup_context);
+}
+void btstack_memory_sm_setup_context_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&sm_setup_context_pool, stats);
+}
+#else
+static btstack_memory_pool_stats_t sm_setup_context_stats;
+sm_setup_context_t * btstack_memory_sm_setup_context_get(void){
+    btstack_memory_pool_stats_track_get(&sm_setup_context_stats, NULL);
+    return NULL;
+}
+void btstack_memory_sm_setup_context_free(sm_setup_context_t *sm_setup_context){
+    // silence compiler warning about unused parameter in a portable way
+    (void) sm_setup_context;
+};
+void btstack_memory_sm_setup_context_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = sm_setup_context_stats;
+}
+#endif
+#elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t sm_setup_context_stats;
+sm_setup_context_t * btstack_memory_sm_setup_context_get(void){
+    sm_setup_context_t * sm_setup_context = (sm_setup_context_t*) malloc(sizeof(sm_setup_context_t));
+    btstack_memory_pool_stats_track_get(&sm_setup_context_stats, sm_setup_context);
+    return sm_setup_context;
+}
+void btstack_memory_sm_setup_context_free(sm_setup_context_t *sm_setup_context){
+    btstack_memory_pool_stats_track_free(&sm_setup_context_stats, sm_setup_context);
+    free(sm_setup_context);
+}
+void btstack_memory_sm_setup_context_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = sm_setup_context_stats;
+}
 #endif
 
 
@@ -806,5 +1130,53 @@ void btstack_memory_init(void){
 #if MAX_NR_SM_LOOKUP_ENTRIES > 0
     btstack_memory_pool_create(&sm_lookup_entry_pool, sm_lookup_entry_storage, MAX_NR_SM_LOOKUP_ENTRIES, sizeof(sm_lookup_entry_t));
 #endif
+#if MAX_NR_SM_SETUP_CONTEXTS > 0
+    btstack_memory_pool_create(&sm_setup_context_pool, sm_setup_context_storage, MAX_NR_SM_SETUP_CONTEXTS, sizeof(sm_setup_context_t));
+#endif
+#endif
+}
+
+// stats
+void btstack_memory_log_stats(void){
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_hci_connection_get_stats(&stats);
+    log_info("hci_connection: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_l2cap_service_get_stats(&stats);
+    log_info("l2cap_service: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_l2cap_channel_get_stats(&stats);
+    log_info("l2cap_channel: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_rfcomm_multiplexer_get_stats(&stats);
+    log_info("rfcomm_multiplexer: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_rfcomm_service_get_stats(&stats);
+    log_info("rfcomm_service: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_rfcomm_channel_get_stats(&stats);
+    log_info("rfcomm_channel: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_btstack_link_key_db_memory_entry_get_stats(&stats);
+    log_info("btstack_link_key_db_memory_entry: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_bnep_service_get_stats(&stats);
+    log_info("bnep_service: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_bnep_channel_get_stats(&stats);
+    log_info("bnep_channel: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_hfp_connection_get_stats(&stats);
+    log_info("hfp_connection: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_service_record_item_get_stats(&stats);
+    log_info("service_record_item: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_avdtp_stream_endpoint_get_stats(&stats);
+    log_info("avdtp_stream_endpoint: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_avdtp_connection_get_stats(&stats);
+    log_info("avdtp_connection: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_avrcp_connection_get_stats(&stats);
+    log_info("avrcp_connection: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_avrcp_browsing_connection_get_stats(&stats);
+    log_info("avrcp_browsing_connection: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+#ifdef ENABLE_BLE
+    btstack_memory_gatt_client_get_stats(&stats);
+    log_info("gatt_client: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_whitelist_entry_get_stats(&stats);
+    log_info("whitelist_entry: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_sm_lookup_entry_get_stats(&stats);
+    log_info("sm_lookup_entry: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
+    btstack_memory_sm_setup_context_get_stats(&stats);
+    log_info("sm_setup_context: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);
 #endif
 }
@@ -43,12 +43,15 @@
  *  Fixed-size block allocation
  *
  *  Free blocks are kept in singly linked list
+ *  Double free detection requires full list scan and is only done with ENABLE_MEMORY_POOL_DEBUG
  *
  */
 
 #include "btstack_memory_pool.h"
 
 #include <stddef.h>
+#include <string.h>
+#include "btstack_config.h"
 #include "btstack_debug.h"
 
 typedef struct node {
@@ -56,44 +59,82 @@ typedef struct node {
 } node_t;
 
 void btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size){
-    node_t *free_blocks = (node_t*) pool;
     char   *mem_ptr = (char *) storage;
     int i;
     
+    memset(&pool->stats, 0, sizeof(btstack_memory_pool_stats_t));
+
     // create singly linked list of all available blocks
-    free_blocks->next = NULL;
+    pool->free_blocks = NULL;
     for (i = 0 ; i < count ; i++){
-        btstack_memory_pool_free(pool, mem_ptr);
+        node_t * node = (node_t *) mem_ptr;
+        node->next = (node_t *) pool->free_blocks;
+        pool->free_blocks = node;
         mem_ptr += block_size;
     }
 }
 
 void * btstack_memory_pool_get(btstack_memory_pool_t *pool){
-    node_t *free_blocks = (node_t*) pool;
+    node_t *node = (node_t *) pool->free_blocks;
     
-    if (!free_blocks->next) return NULL;
+    if (!node) {
+        pool->stats.num_failed++;
+        return NULL;
+    }
     
     // remove first
-    node_t *node      = free_blocks->next;
-    free_blocks->next = node->next;
+    pool->free_blocks = node->next;
+
+    pool->stats.num_used++;
+    if (pool->stats.num_used > pool->stats.max_used){
+        pool->stats.max_used = pool->stats.num_used;
+    }
     
     return (void*) node;
 }
 
 void btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block){
-    node_t *free_blocks = (node_t*) pool;
-    node_t *node        = (node_t*) block;
+    node_t *node = (node_t*) block;
 
+#ifdef ENABLE_MEMORY_POOL_DEBUG
     // raise error and abort if node already in list
     node_t * it;
-    for (it = free_blocks->next; it ; it = it->next){
+    for (it = (node_t *) pool->free_blocks; it ; it = it->next){
         if (it == node) {
             log_error("btstack_memory_pool_free: block %p freed twice for pool %p", block, pool);
             return;
         }
     }
+    if (pool->stats.num_used == 0){
+        log_error("btstack_memory_pool_free: block %p freed but pool %p has no blocks in use", block, pool);
+        return;
+    }
+#endif
 
     // add block as node to list
-    node->next          = free_blocks->next;
-    free_blocks->next   = node;
+    node->next        = (node_t *) pool->free_blocks;
+    pool->free_blocks = node;
+
+    pool->stats.num_used--;
+}
+
+void btstack_memory_pool_get_stats(btstack_memory_pool_t *pool, btstack_memory_pool_stats_t * stats){
+    *stats = pool->stats;
+}
+
+void btstack_memory_pool_stats_track_get(btstack_memory_pool_stats_t * stats, void * block){
+    if (!block) {
+        stats->num_failed++;
+        return;
+    }
+    stats->num_used++;
+    if (stats->num_used > stats->max_used){
+        stats->max_used = stats->num_used;
+    }
+}
+
+void btstack_memory_pool_stats_track_free(btstack_memory_pool_stats_t * stats, void * block){
+    if (!block) return;
+    if (!stats->num_used) return;
+    stats->num_used--;
 }
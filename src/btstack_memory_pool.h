@@ -43,7 +43,8 @@
  *  @Assumption block_size >= sizeof(void *)
  *  @Assumption size of storage >= count * block_size
  *
- *  @Note minimal implementation, no error checking/handling
+ *  @Note minimal implementation, no error checking/handling. Get and free are O(1).
+ *        With ENABLE_MEMORY_POOL_DEBUG, free checks for blocks freed twice, which is O(n)
  */
 
 #ifndef __btstack_memory_pool_H
@@ -53,7 +54,18 @@
 extern "C" {
 #endif
 
-typedef void * btstack_memory_pool_t;
+#include <stdint.h>
+
+typedef struct {
+    uint16_t num_used;      // blocks currently in use
+    uint16_t max_used;      // high-water mark of blocks in use
+    uint16_t num_failed;    // number of get requests that could not be served
+} btstack_memory_pool_stats_t;
+
+typedef struct {
+    void * free_blocks;
+    btstack_memory_pool_stats_t stats;
+} btstack_memory_pool_t;
 
 // initialize memory pool with with given storage, block size and count
 void   btstack_memory_pool_create(btstack_memory_pool_t *pool, void * storage, int count, int block_size);
@@ -64,6 +76,15 @@ void * btstack_memory_pool_get(btstack_memory_pool_t *pool);
 // return previously reserved block to memory pool
 void   btstack_memory_pool_free(btstack_memory_pool_t *pool, void * block);
 
+// get usage statistics of memory pool
+void   btstack_memory_pool_get_stats(btstack_memory_pool_t *pool, btstack_memory_pool_stats_t * stats);
+
+// update statistics for allocations not served by a memory pool, e.g. malloc, block == NULL counts as failure
+void   btstack_memory_pool_stats_track_get(btstack_memory_pool_stats_t * stats, void * block);
+
+// update statistics for freed block not managed by a memory pool
+void   btstack_memory_pool_stats_track_free(btstack_memory_pool_stats_t * stats, void * block);
+
 #if defined __cplusplus
 }
 #endif
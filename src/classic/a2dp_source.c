@@ -52,14 +52,41 @@
 #define AVDTP_MAX_SEP_NUM 10
 #define AVDTP_MEDIA_PAYLOAD_HEADER_SIZE 12
 
+// number of remote sinks that can be configured and streamed to simultaneously, each needs its own local stream endpoint
+#ifndef MAX_NR_A2DP_SOURCE_CONNECTIONS
+#define MAX_NR_A2DP_SOURCE_CONNECTIONS 1
+#endif
+
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+// size of media queue per connection in bytes
+#ifndef A2DP_SOURCE_MEDIA_QUEUE_SIZE
+#define A2DP_SOURCE_MEDIA_QUEUE_SIZE 2048
+#endif
+// queue entry: num_frames (1), payload len (2), payload
+#define A2DP_SOURCE_MEDIA_QUEUE_ENTRY_HEADER_SIZE 3
+#endif
+
+typedef struct {
+    // 0 = free
+    uint16_t a2dp_cid;
+    a2dp_state_t state;
+    avdtp_stream_endpoint_context_t sc;
+    avdtp_sep_t remote_seps[AVDTP_MAX_SEP_NUM];
+    int remote_seps_index;
+    // A2DP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW requested by application
+    uint8_t media_can_send_now_requested;
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+    uint32_t media_queue_num_dropped;
+    uint16_t media_queue_len;
+    uint8_t  media_queue[A2DP_SOURCE_MEDIA_QUEUE_SIZE];
+#endif
+} a2dp_source_connection_t;
+
 static const char * default_a2dp_source_service_name = "BTstack A2DP Source Service";
 static const char * default_a2dp_source_service_provider_name = "BTstack A2DP Source Service Provider";
 static avdtp_context_t a2dp_source_context;
 
-static a2dp_state_t app_state = A2DP_IDLE;
-static avdtp_stream_endpoint_context_t sc;
-static avdtp_sep_t remote_seps[AVDTP_MAX_SEP_NUM];
-static int remote_seps_index = 0;
+static a2dp_source_connection_t a2dp_source_connections[MAX_NR_A2DP_SOURCE_CONNECTIONS];
 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
 
@@ -200,6 +227,74 @@ static void a2dp_signaling_emit_control_command(btstack_packet_handler_t callbac
     (*callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
+static a2dp_source_connection_t * a2dp_source_connection_for_cid(uint16_t a2dp_cid){
+    if (a2dp_cid == 0) return NULL;
+    int i;
+    for (i=0;i<MAX_NR_A2DP_SOURCE_CONNECTIONS;i++){
+        if (a2dp_source_connections[i].a2dp_cid == a2dp_cid) return &a2dp_source_connections[i];
+    }
+    return NULL;
+}
+
+static a2dp_source_connection_t * a2dp_source_connection_for_stream_endpoint(avdtp_stream_endpoint_t * stream_endpoint){
+    int i;
+    for (i=0;i<MAX_NR_A2DP_SOURCE_CONNECTIONS;i++){
+        if (a2dp_source_connections[i].a2dp_cid == 0) continue;
+        if (a2dp_source_connections[i].sc.local_stream_endpoint == stream_endpoint) return &a2dp_source_connections[i];
+    }
+    return NULL;
+}
+
+static a2dp_source_connection_t * a2dp_source_connection_get_free(void){
+    int i;
+    for (i=0;i<MAX_NR_A2DP_SOURCE_CONNECTIONS;i++){
+        if (a2dp_source_connections[i].a2dp_cid == 0) return &a2dp_source_connections[i];
+    }
+    return NULL;
+}
+
+// find local SOURCE stream endpoint not used by another connection, e.g. for incoming connection
+static avdtp_stream_endpoint_t * a2dp_source_get_unused_stream_endpoint(void){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &a2dp_source_context.stream_endpoints);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        avdtp_stream_endpoint_t * stream_endpoint = (avdtp_stream_endpoint_t *) btstack_linked_list_iterator_next(&it);
+        if (stream_endpoint->sep.type != AVDTP_SOURCE) continue;
+        if (a2dp_source_connection_for_stream_endpoint(stream_endpoint)) continue;
+        return stream_endpoint;
+    }
+    return NULL;
+}
+
+static void a2dp_source_connection_init(a2dp_source_connection_t * connection, uint16_t a2dp_cid){
+    memset(connection, 0, sizeof(a2dp_source_connection_t));
+    connection->a2dp_cid = a2dp_cid;
+    connection->state = A2DP_IDLE;
+}
+
+static int a2dp_source_send_media_payload(avdtp_stream_endpoint_t * stream_endpoint, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
+
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+static void a2dp_source_media_queue_drop_oldest(a2dp_source_connection_t * connection){
+    uint16_t entry_len = A2DP_SOURCE_MEDIA_QUEUE_ENTRY_HEADER_SIZE + little_endian_read_16(connection->media_queue, 1);
+    connection->media_queue_len -= entry_len;
+    memmove(&connection->media_queue[0], &connection->media_queue[entry_len], connection->media_queue_len);
+}
+
+static void a2dp_source_media_queue_send(a2dp_source_connection_t * connection){
+    uint8_t  num_frames  = connection->media_queue[0];
+    uint16_t payload_len = little_endian_read_16(connection->media_queue, 1);
+    a2dp_source_send_media_payload(connection->sc.local_stream_endpoint, &connection->media_queue[A2DP_SOURCE_MEDIA_QUEUE_ENTRY_HEADER_SIZE], payload_len, num_frames, 0);
+    a2dp_source_media_queue_drop_oldest(connection);
+}
+#endif
+
+static void a2dp_source_request_can_send_now(a2dp_source_connection_t * connection){
+    avdtp_stream_endpoint_t * stream_endpoint = connection->sc.local_stream_endpoint;
+    stream_endpoint->send_stream = 1;
+    avdtp_request_can_send_now_initiator(stream_endpoint->connection, stream_endpoint->l2cap_media_cid);
+}
+
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     UNUSED(channel);
     UNUSED(size);
@@ -210,60 +305,84 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
     uint8_t remote_seid;
     uint16_t cid;
     bd_addr_t address;
+    a2dp_source_connection_t * connection;
     
     if (packet_type != HCI_EVENT_PACKET) return;
     if (hci_event_packet_get_type(packet) != HCI_EVENT_AVDTP_META) return;
-    
-    switch (packet[2]){
-        case AVDTP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED:{
-            avdtp_subevent_signaling_connection_established_get_bd_addr(packet, sc.remote_addr);
-            cid = avdtp_subevent_signaling_connection_established_get_avdtp_cid(packet);
-            status = avdtp_subevent_signaling_connection_established_get_status(packet);
-            
-            if (status != 0){
-                log_info("AVDTP_SUBEVENT_SIGNALING_CONNECTION failed status %d ---", status);
-                app_state = A2DP_IDLE;
-                a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, sc.remote_addr, status);
-                break;
+
+    // all AVDTP subevents start with the avdtp_cid
+    cid = little_endian_read_16(packet, 3);
+    connection = a2dp_source_connection_for_cid(cid);
+
+    if (packet[2] == AVDTP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED){
+        avdtp_subevent_signaling_connection_established_get_bd_addr(packet, address);
+        status = avdtp_subevent_signaling_connection_established_get_status(packet);
+        
+        if (status != 0){
+            log_info("AVDTP_SUBEVENT_SIGNALING_CONNECTION failed status %d ---", status);
+            if (connection){
+                connection->a2dp_cid = 0;
             }
-            log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION established avdtp_cid 0x%02x ---", a2dp_source_context.avdtp_cid);
-            sc.active_remote_sep = NULL;
-            sc.active_remote_sep_index = 0;
-            app_state = A2DP_W2_DISCOVER_SEPS;
-            remote_seps_index = 0;
-            memset(remote_seps, 0, sizeof(avdtp_sep_t) * AVDTP_MAX_SEP_NUM);
-            a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, sc.remote_addr, status);
-            avdtp_source_discover_stream_endpoints(cid);
-            break;
+            a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, status);
+            return;
+        }
+        if (!connection){
+            // incoming connection
+            connection = a2dp_source_connection_get_free();
+            if (!connection){
+                log_error("A2DP source: no free connection for avdtp_cid 0x%02x, increase MAX_NR_A2DP_SOURCE_CONNECTIONS", cid);
+                avdtp_disconnect(cid, &a2dp_source_context);
+                return;
+            }
+            a2dp_source_connection_init(connection, cid);
+            connection->sc.local_stream_endpoint = a2dp_source_get_unused_stream_endpoint();
         }
+        memcpy(connection->sc.remote_addr, address, 6);
+        log_info("A2DP_SUBEVENT_SIGNALING_CONNECTION established avdtp_cid 0x%02x ---", cid);
+        connection->sc.active_remote_sep = NULL;
+        connection->sc.active_remote_sep_index = 0;
+        connection->state = A2DP_W2_DISCOVER_SEPS;
+        connection->remote_seps_index = 0;
+        memset(connection->remote_seps, 0, sizeof(avdtp_sep_t) * AVDTP_MAX_SEP_NUM);
+        a2dp_signaling_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, status);
+        avdtp_source_discover_stream_endpoints(cid);
+        return;
+    }
+
+    if (!connection){
+        log_info("A2DP source: event 0x%02x for unknown avdtp_cid 0x%02x", packet[2], cid);
+        return;
+    }
+    avdtp_stream_endpoint_context_t * sc = &connection->sc;
 
+    switch (packet[2]){
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CAPABILITY:{
             log_info("A2DP received SBC capability.");
-            if (!sc.local_stream_endpoint) {
+            if (!sc->local_stream_endpoint) {
                 log_error("invalid local seid %d", avdtp_subevent_signaling_media_codec_sbc_capability_get_local_seid(packet));
                 return;
             }
             log_info("A2DP received SBC capability.");
             
-            uint8_t sampling_frequency = avdtp_choose_sbc_sampling_frequency(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet));
-            uint8_t channel_mode = avdtp_choose_sbc_channel_mode(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet));
-            uint8_t block_length = avdtp_choose_sbc_block_length(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_block_length_bitmap(packet));
-            uint8_t subbands = avdtp_choose_sbc_subbands(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_subbands_bitmap(packet));
+            uint8_t sampling_frequency = avdtp_choose_sbc_sampling_frequency(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_sampling_frequency_bitmap(packet));
+            uint8_t channel_mode = avdtp_choose_sbc_channel_mode(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_channel_mode_bitmap(packet));
+            uint8_t block_length = avdtp_choose_sbc_block_length(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_block_length_bitmap(packet));
+            uint8_t subbands = avdtp_choose_sbc_subbands(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_subbands_bitmap(packet));
             
-            uint8_t allocation_method = avdtp_choose_sbc_allocation_method(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap(packet));
-            uint8_t max_bitpool_value = avdtp_choose_sbc_max_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet));
-            uint8_t min_bitpool_value = avdtp_choose_sbc_min_bitpool_value(sc.local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value(packet));
+            uint8_t allocation_method = avdtp_choose_sbc_allocation_method(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_allocation_method_bitmap(packet));
+            uint8_t max_bitpool_value = avdtp_choose_sbc_max_bitpool_value(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_max_bitpool_value(packet));
+            uint8_t min_bitpool_value = avdtp_choose_sbc_min_bitpool_value(sc->local_stream_endpoint, avdtp_subevent_signaling_media_codec_sbc_capability_get_min_bitpool_value(packet));
 
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[0] = (sampling_frequency << 4) | channel_mode;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[1] = (block_length << 4) | (subbands << 2) | allocation_method;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[2] = min_bitpool_value;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_information[3] = max_bitpool_value;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[0] = (sampling_frequency << 4) | channel_mode;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[1] = (block_length << 4) | (subbands << 2) | allocation_method;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[2] = min_bitpool_value;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_information[3] = max_bitpool_value;
 
-            sc.local_stream_endpoint->remote_configuration_bitmap = store_bit16(sc.local_stream_endpoint->remote_configuration_bitmap, AVDTP_MEDIA_CODEC, 1);
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_type = AVDTP_AUDIO;
-            sc.local_stream_endpoint->remote_configuration.media_codec.media_codec_type = AVDTP_CODEC_SBC;
+            sc->local_stream_endpoint->remote_configuration_bitmap = store_bit16(sc->local_stream_endpoint->remote_configuration_bitmap, AVDTP_MEDIA_CODEC, 1);
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_type = AVDTP_AUDIO;
+            sc->local_stream_endpoint->remote_configuration.media_codec.media_codec_type = AVDTP_CODEC_SBC;
 
-            app_state = A2DP_W2_SET_CONFIGURATION;
+            connection->state = A2DP_W2_SET_CONFIGURATION;
             break;
         }
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_OTHER_CAPABILITY:
@@ -295,23 +414,33 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
 
         case AVDTP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION:{
-            // TODO check cid
-            sc.sampling_frequency = avdtp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency(packet);
-            sc.block_length = avdtp_subevent_signaling_media_codec_sbc_configuration_get_block_length(packet);
-            sc.subbands = avdtp_subevent_signaling_media_codec_sbc_configuration_get_subbands(packet);
-            sc.allocation_method = avdtp_subevent_signaling_media_codec_sbc_configuration_get_allocation_method(packet) - 1;
-            sc.max_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_max_bitpool_value(packet);
-            sc.channel_mode = avdtp_subevent_signaling_media_codec_sbc_configuration_get_channel_mode(packet);
+            sc->sampling_frequency = avdtp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency(packet);
+            sc->block_length = avdtp_subevent_signaling_media_codec_sbc_configuration_get_block_length(packet);
+            sc->subbands = avdtp_subevent_signaling_media_codec_sbc_configuration_get_subbands(packet);
+            sc->allocation_method = avdtp_subevent_signaling_media_codec_sbc_configuration_get_allocation_method(packet) - 1;
+            sc->max_bitpool_value = avdtp_subevent_signaling_media_codec_sbc_configuration_get_max_bitpool_value(packet);
+            sc->channel_mode = avdtp_subevent_signaling_media_codec_sbc_configuration_get_channel_mode(packet);
             // TODO: deal with reconfigure: avdtp_subevent_signaling_media_codec_sbc_configuration_get_reconfigure(packet);
-            log_info("A2DP received SBC Config: sample rate %u, max bitpool %u.", sc.sampling_frequency, sc.max_bitpool_value);
-            app_state = A2DP_W2_OPEN_STREAM_WITH_SEID;
+            log_info("A2DP received SBC Config: sample rate %u, max bitpool %u.", sc->sampling_frequency, sc->max_bitpool_value);
+            connection->state = A2DP_W2_OPEN_STREAM_WITH_SEID;
             a2dp_signaling_emit_media_codec_sbc(a2dp_source_context.a2dp_callback, packet, size);
             break;
         }  
        
         case AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW: 
-            cid = avdtp_subevent_streaming_can_send_media_packet_now_get_avdtp_cid(packet);
-            a2dp_streaming_emit_can_send_media_packet_now(a2dp_source_context.a2dp_callback, cid, 0);
+            local_seid = avdtp_subevent_streaming_can_send_media_packet_now_get_local_seid(packet);
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+            // queued media payloads have priority
+            if (connection->media_queue_len){
+                a2dp_source_media_queue_send(connection);
+                if (connection->media_queue_len || connection->media_can_send_now_requested){
+                    a2dp_source_request_can_send_now(connection);
+                }
+                break;
+            }
+#endif
+            connection->media_can_send_now_requested = 0;
+            a2dp_streaming_emit_can_send_media_packet_now(a2dp_source_context.a2dp_callback, cid, local_seid);
             break;
         
         case AVDTP_SUBEVENT_STREAMING_CONNECTION_ESTABLISHED:
@@ -326,7 +455,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
                 break;
             }
             log_info("AVDTP_SUBEVENT_STREAMING_CONNECTION_ESTABLISHED --- avdtp_cid 0x%02x, local seid %d, remote seid %d", cid, local_seid, remote_seid);
-            app_state = A2DP_STREAMING_OPENED;
+            connection->state = A2DP_STREAMING_OPENED;
             a2dp_streaming_emit_connection_established(a2dp_source_context.a2dp_callback, cid, address, local_seid, remote_seid, 0);
             break;
 
@@ -337,70 +466,71 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             sep.media_type = avdtp_subevent_signaling_sep_found_get_media_type(packet);
             sep.type = avdtp_subevent_signaling_sep_found_get_sep_type(packet);
             log_info("Found sep: seid %u, in_use %d, media type %d, sep type %d (1-SNK)", sep.seid, sep.in_use, sep.media_type, sep.type);
-            remote_seps[remote_seps_index++] = sep;
+            if (connection->remote_seps_index >= AVDTP_MAX_SEP_NUM) break;
+            connection->remote_seps[connection->remote_seps_index++] = sep;
             break;
         }
         case AVDTP_SUBEVENT_SIGNALING_SEP_DICOVERY_DONE:
-            app_state = A2DP_W2_GET_CAPABILITIES;
-            sc.active_remote_sep_index = 0;
+            connection->state = A2DP_W2_GET_CAPABILITIES;
+            sc->active_remote_sep_index = 0;
             break;
 
         case AVDTP_SUBEVENT_SIGNALING_ACCEPT:
-            // TODO check cid
             signal_identifier = avdtp_subevent_signaling_accept_get_signal_identifier(packet);
             cid = avdtp_subevent_signaling_accept_get_avdtp_cid(packet);
-            log_info("A2DP Accepted %d, state %d", signal_identifier, app_state);
+            log_info("A2DP Accepted %d, state %d", signal_identifier, connection->state);
             
-            switch (app_state){
+            switch (connection->state){
                 case A2DP_W2_GET_CAPABILITIES:
-                    if (sc.active_remote_sep_index < remote_seps_index){
-                        sc.active_remote_sep = &remote_seps[sc.active_remote_sep_index++];
-                        avdtp_source_get_capabilities(cid, sc.active_remote_sep->seid);
+                    if (sc->active_remote_sep_index < connection->remote_seps_index){
+                        sc->active_remote_sep = &connection->remote_seps[sc->active_remote_sep_index++];
+                        avdtp_source_get_capabilities(cid, sc->active_remote_sep->seid);
                     }
                     break;
                 case A2DP_W2_SET_CONFIGURATION:{
-                    if (!sc.local_stream_endpoint) return;
+                    if (!sc->local_stream_endpoint) return;
                     log_info("A2DP initiate set configuration locally and wait for response ... ");
-                    app_state = A2DP_IDLE;
-                    avdtp_source_set_configuration(cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid, sc.local_stream_endpoint->remote_configuration_bitmap, sc.local_stream_endpoint->remote_configuration);
+                    connection->state = A2DP_IDLE;
+                    avdtp_source_set_configuration(cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid, sc->local_stream_endpoint->remote_configuration_bitmap, sc->local_stream_endpoint->remote_configuration);
                     break;
                 }
                 case A2DP_W2_OPEN_STREAM_WITH_SEID:{
                     log_info("A2DP open stream ");
-                    app_state = A2DP_W4_OPEN_STREAM_WITH_SEID;
-                    avdtp_source_open_stream(cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), sc.active_remote_sep->seid);
+                    connection->state = A2DP_W4_OPEN_STREAM_WITH_SEID;
+                    avdtp_source_open_stream(cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), sc->active_remote_sep->seid);
                     break;
                 }
                 case A2DP_STREAMING_OPENED:
                     if (!a2dp_source_context.a2dp_callback) return;
                     switch (signal_identifier){
                         case  AVDTP_SI_START:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_STARTED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_STARTED);
                             break;
                         case AVDTP_SI_SUSPEND:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_SUSPENDED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_SUSPENDED);
                             break;
                         case AVDTP_SI_ABORT:
                         case AVDTP_SI_CLOSE:
-                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc.local_stream_endpoint), A2DP_SUBEVENT_STREAM_STOPPED);
+                            a2dp_signaling_emit_control_command(a2dp_source_context.a2dp_callback, cid, avdtp_stream_endpoint_seid(sc->local_stream_endpoint), A2DP_SUBEVENT_STREAM_STOPPED);
                             break;
                         default:
                             break;
                     }
                     break;
                 default:
-                    app_state = A2DP_IDLE;
+                    connection->state = A2DP_IDLE;
                     break;
             }
             
             break;
         case AVDTP_SUBEVENT_SIGNALING_REJECT:
         case AVDTP_SUBEVENT_SIGNALING_GENERAL_REJECT:
-            app_state = A2DP_IDLE;
+            connection->state = A2DP_IDLE;
             a2dp_signaling_emit_reject_cmd(a2dp_source_context.a2dp_callback, packet, size);
             break;
         case AVDTP_SUBEVENT_SIGNALING_CONNECTION_RELEASED:{
-            app_state = A2DP_IDLE;
+            // free connection
+            connection->a2dp_cid = 0;
             uint8_t event[6];
             int pos = 0;
             event[pos++] = HCI_EVENT_A2DP_META;
@@ -413,7 +543,11 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         }
         case AVDTP_SUBEVENT_STREAMING_CONNECTION_RELEASED:{
-            app_state = A2DP_IDLE;
+            connection->state = A2DP_IDLE;
+            connection->media_can_send_now_requested = 0;
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+            connection->media_queue_len = 0;
+#endif
             uint8_t event[6];
             int pos = 0;
             event[pos++] = HCI_EVENT_A2DP_META;
@@ -426,7 +560,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         }
         default:
-            app_state = A2DP_IDLE;
+            connection->state = A2DP_IDLE;
             log_info("not implemented");
             break; 
     }
@@ -441,6 +575,7 @@ void a2dp_source_register_packet_handler(btstack_packet_handler_t callback){
 }
 
 void a2dp_source_init(void){
+    memset(a2dp_source_connections, 0, sizeof(a2dp_source_connections));
     avdtp_source_init(&a2dp_source_context);
 }
 
@@ -456,18 +591,37 @@ avdtp_stream_endpoint_t * a2dp_source_create_stream_endpoint(avdtp_media_type_t
         codec_capabilities, codec_capabilities_len);
     local_stream_endpoint->remote_configuration.media_codec.media_codec_information     = media_codec_info;
     local_stream_endpoint->remote_configuration.media_codec.media_codec_information_len = media_codec_info_len;
-    sc.local_stream_endpoint = local_stream_endpoint;                     
     return local_stream_endpoint;
 }
 
 uint8_t a2dp_source_establish_stream(bd_addr_t remote_addr, uint8_t loc_seid, uint16_t * a2dp_cid){
-    sc.local_stream_endpoint = avdtp_stream_endpoint_for_seid(loc_seid, &a2dp_source_context);
-    if (!sc.local_stream_endpoint){
+    avdtp_stream_endpoint_t * local_stream_endpoint = avdtp_stream_endpoint_for_seid(loc_seid, &a2dp_source_context);
+    if (!local_stream_endpoint){
         log_error(" no local_stream_endpoint for seid %d", loc_seid);
         return AVDTP_SEID_DOES_NOT_EXIST;
     }
-    memcpy(sc.remote_addr, remote_addr, 6);
-    return avdtp_source_connect(remote_addr, a2dp_cid);
+    // stream endpoint can only be used by a single connection
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_stream_endpoint(local_stream_endpoint);
+    if (connection && bd_addr_cmp(connection->sc.remote_addr, remote_addr) != 0){
+        log_error("local_stream_endpoint for seid %d already used by avdtp_cid 0x%02x", loc_seid, connection->a2dp_cid);
+        return AVDTP_STREAM_ENDPOINT_IN_WRONG_STATE;
+    }
+    if (!connection && !a2dp_source_connection_get_free()){
+        return BTSTACK_MEMORY_ALLOC_FAILED;
+    }
+    uint16_t cid;
+    uint8_t status = avdtp_source_connect(remote_addr, &cid);
+    if (status != ERROR_CODE_SUCCESS) return status;
+    // connection might have been set up by events emitted during connect
+    connection = a2dp_source_connection_for_cid(cid);
+    if (!connection){
+        connection = a2dp_source_connection_get_free();
+        a2dp_source_connection_init(connection, cid);
+    }
+    connection->sc.local_stream_endpoint = local_stream_endpoint;
+    memcpy(connection->sc.remote_addr, remote_addr, 6);
+    *a2dp_cid = cid;
+    return ERROR_CODE_SUCCESS;
 }
 
 uint8_t a2dp_source_disconnect(uint16_t a2dp_cid){
@@ -512,36 +666,35 @@ static void a2dp_source_setup_media_header(uint8_t * media_packet, int size, int
     *offset = pos;
 }
 
-void a2dp_source_stream_endpoint_request_can_send_now(uint16_t a2dp_cid, uint8_t local_seid){
-    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, &a2dp_source_context);
-    if (!stream_endpoint) {
-        log_error("A2DP source: no stream_endpoint with seid %d", local_seid);
-        return;
-    }
-    if (a2dp_source_context.avdtp_cid != a2dp_cid){
-        log_error("A2DP source: a2dp cid 0x%02x not known, expected 0x%02x", a2dp_cid, a2dp_source_context.avdtp_cid);
-        return;
-    }
-    stream_endpoint->send_stream = 1;
-    avdtp_request_can_send_now_initiator(stream_endpoint->connection, stream_endpoint->l2cap_media_cid);
-}
-
-int a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid){
-    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, &a2dp_source_context);
-    if (!stream_endpoint) {
-        log_error("A2DP source: no stream_endpoint with seid %d", local_seid);
-        return 0;
+static a2dp_source_connection_t * a2dp_source_connection_for_cid_and_seid(uint16_t a2dp_cid, uint8_t local_seid){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_cid(a2dp_cid);
+    if (!connection){
+        log_error("A2DP source: a2dp cid 0x%02x not known", a2dp_cid);
+        return NULL;
     }
-    if (a2dp_source_context.avdtp_cid != a2dp_cid){
-        log_error("A2DP source: a2dp cid 0x%02x not known, expected 0x%02x", a2dp_cid, a2dp_source_context.avdtp_cid);
-        return 0;
+    avdtp_stream_endpoint_t * stream_endpoint = connection->sc.local_stream_endpoint;
+    if (!stream_endpoint || avdtp_stream_endpoint_seid(stream_endpoint) != local_seid) {
+        log_error("A2DP source: no stream_endpoint with seid %d for a2dp cid 0x%02x", local_seid, a2dp_cid);
+        return NULL;
     }
-
     if (stream_endpoint->l2cap_media_cid == 0){
         log_error("A2DP source: no media connection for seid %d", local_seid);
-        return 0;
+        return NULL;
     }  
-    return l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid) - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE;
+    return connection;
+}
+
+void a2dp_source_stream_endpoint_request_can_send_now(uint16_t a2dp_cid, uint8_t local_seid){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_cid_and_seid(a2dp_cid, local_seid);
+    if (!connection) return;
+    connection->media_can_send_now_requested = 1;
+    a2dp_source_request_can_send_now(connection);
+}
+
+int a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_cid_and_seid(a2dp_cid, local_seid);
+    if (!connection) return 0;
+    return l2cap_get_remote_mtu_for_local_cid(connection->sc.local_stream_endpoint->l2cap_media_cid) - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE;
 }
 
 static void a2dp_source_copy_media_payload(uint8_t * media_packet, int size, int * offset, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames){
@@ -557,31 +710,64 @@ static void a2dp_source_copy_media_payload(uint8_t * media_packet, int size, int
     *offset = pos;
 }
 
-int a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
-    avdtp_stream_endpoint_t * stream_endpoint = avdtp_stream_endpoint_for_seid(local_seid, &a2dp_source_context);
-    if (!stream_endpoint) {
-        log_error("A2DP source: no stream_endpoint with seid %d", local_seid);
-        return 0;
-    }
-    if (a2dp_source_context.avdtp_cid != a2dp_cid){
-        log_error("A2DP source: a2dp cid 0x%02x not known, expected 0x%02x", a2dp_cid, a2dp_source_context.avdtp_cid);
-        return 0;
-    }
-
-    if (stream_endpoint->l2cap_media_cid == 0){
-        log_error("A2DP source: no media connection for seid %d", local_seid);
-        return 0;
-    } 
-
+static int a2dp_source_send_media_payload(avdtp_stream_endpoint_t * stream_endpoint, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
     int size = l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid);
     int offset = 0;
 
     l2cap_reserve_packet_buffer();
     uint8_t * media_packet = l2cap_get_outgoing_buffer();
-    //int size = l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid);
     a2dp_source_setup_media_header(media_packet, size, &offset, marker, stream_endpoint->sequence_number);
     a2dp_source_copy_media_payload(media_packet, size, &offset, storage, num_bytes_to_copy, num_frames);
     stream_endpoint->sequence_number++;
     l2cap_send_prepared(stream_endpoint->l2cap_media_cid, offset);
     return size;
 }
+
+int a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_cid_and_seid(a2dp_cid, local_seid);
+    if (!connection) return 0;
+    return a2dp_source_send_media_payload(connection->sc.local_stream_endpoint, storage, num_bytes_to_copy, num_frames, marker);
+}
+
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+int a2dp_source_queue_media_payload(uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames){
+    uint16_t entry_len = A2DP_SOURCE_MEDIA_QUEUE_ENTRY_HEADER_SIZE + num_bytes_to_copy;
+    if (entry_len > A2DP_SOURCE_MEDIA_QUEUE_SIZE){
+        log_error("A2DP source: media payload of %u bytes exceeds A2DP_SOURCE_MEDIA_QUEUE_SIZE", num_bytes_to_copy);
+        return 0;
+    }
+    int num_queued = 0;
+    int i;
+    for (i=0;i<MAX_NR_A2DP_SOURCE_CONNECTIONS;i++){
+        a2dp_source_connection_t * connection = &a2dp_source_connections[i];
+        if (connection->a2dp_cid == 0) continue;
+        if (connection->state != A2DP_STREAMING_OPENED) continue;
+        avdtp_stream_endpoint_t * stream_endpoint = connection->sc.local_stream_endpoint;
+        if (!stream_endpoint) continue;
+        if (stream_endpoint->state != AVDTP_STREAM_ENDPOINT_STREAMING) continue;
+        if (num_bytes_to_copy + 1 > l2cap_get_remote_mtu_for_local_cid(stream_endpoint->l2cap_media_cid) - AVDTP_MEDIA_PAYLOAD_HEADER_SIZE){
+            log_error("A2DP source: media payload of %u bytes too large for a2dp cid 0x%02x", num_bytes_to_copy, connection->a2dp_cid);
+            continue;
+        }
+        // slow sink: drop oldest payloads
+        while (connection->media_queue_len + entry_len > A2DP_SOURCE_MEDIA_QUEUE_SIZE){
+            a2dp_source_media_queue_drop_oldest(connection);
+            connection->media_queue_num_dropped++;
+        }
+        uint8_t * entry = &connection->media_queue[connection->media_queue_len];
+        entry[0] = num_frames;
+        little_endian_store_16(entry, 1, num_bytes_to_copy);
+        memcpy(&entry[A2DP_SOURCE_MEDIA_QUEUE_ENTRY_HEADER_SIZE], storage, num_bytes_to_copy);
+        connection->media_queue_len += entry_len;
+        a2dp_source_request_can_send_now(connection);
+        num_queued++;
+    }
+    return num_queued;
+}
+
+uint32_t a2dp_source_get_num_dropped_media_payloads(uint16_t a2dp_cid){
+    a2dp_source_connection_t * connection = a2dp_source_connection_for_cid(a2dp_cid);
+    if (!connection) return 0;
+    return connection->media_queue_num_dropped;
+}
+#endif
@@ -71,6 +71,7 @@ void a2dp_source_init(void);
 
 /**
  * @brief Create a stream endpoint of type SOURCE, and register media codec by specifying its capabilities and the default configuration.
+ * @note To stream to several sinks simultaneously, create one stream endpoint with its own codec configuration storage per sink, see MAX_NR_A2DP_SOURCE_CONNECTIONS
  * @param media_type    			See avdtp_media_type_t values in avdtp.h (audio, video or multimedia).
  * @param media_codec_type 			See avdtp_media_codec_type_t values in avdtp.h 
  * @param codec_capabilities        Media codec capabilities as defined in A2DP spec, section 4 - Audio Codec Interoperability Requirements.
@@ -155,6 +156,26 @@ int 	a2dp_max_media_payload_size(uint16_t a2dp_cid, uint8_t local_seid);
  */
 int  	a2dp_source_stream_send_media_payload(uint16_t a2dp_cid, uint8_t local_seid, uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames, uint8_t marker);
 
+#ifdef ENABLE_A2DP_SOURCE_MEDIA_QUEUE
+/**
+ * @brief Queue media payload for all started streams, e.g. to send the output of a single SBC encoder to several sinks.
+ *        Each stream sends from its own queue of size A2DP_SOURCE_MEDIA_QUEUE_SIZE when its media channel can send.
+ *        If the queue of a slow sink is full, its oldest payloads are dropped without affecting the other sinks.
+ * @param storage
+ * @param num_bytes_to_copy
+ * @param num_frames
+ * @return number of streams the payload was queued for
+ */
+int     a2dp_source_queue_media_payload(uint8_t * storage, int num_bytes_to_copy, uint8_t num_frames);
+
+/**
+ * @brief Get number of queued media payloads dropped for a stream.
+ * @param a2dp_cid 			A2DP channel identifyer.
+ * @return num_dropped
+ */
+uint32_t a2dp_source_get_num_dropped_media_payloads(uint16_t a2dp_cid);
+#endif
+
 /* API_END */
 
 #if defined __cplusplus
@@ -59,6 +59,12 @@ extern "C" {
 #define AVRCP_ATTRIBUTE_HEADER_LEN  8
 #define AVRCP_MAX_FOLDER_NAME_SIZE      20
 
+// max size of vendor dependent response parameters, sent in fragments via Request Continuing Response
+// note: buffer is part of every avrcp_connection_t, i.e. RAM usage is AVRCP_TARGET_RESPONSE_BUFFER_SIZE per AVRCP connection
+#ifndef AVRCP_TARGET_RESPONSE_BUFFER_SIZE
+#define AVRCP_TARGET_RESPONSE_BUFFER_SIZE 1024
+#endif
+
 typedef enum {
     AVRCP_STATUS_INVALID_COMMAND = 0,           // sent if TG received a PDU that it did not understand.
     AVRCP_STATUS_INVALID_PARAMETER,             // Sent if the TG received a PDU with a parameter ID that it did not understand, or, if there is only one parameter ID in the PDU.
@@ -448,12 +454,14 @@ typedef struct {
     uint8_t battery_status_changed;
     uint8_t volume_percentage;
     uint8_t volume_percentage_changed;
-    uint8_t now_playing_info_response;
-    uint8_t now_playing_info_attr_bitmap;
     uint8_t abort_continue_response;
     
-    // used for fragmentation
-    avrcp_media_attribute_id_t next_attr_id;
+    // vendor dependent response, fragmented if it does not fit into a single AV/C frame
+    uint8_t  response_buffer[AVRCP_TARGET_RESPONSE_BUFFER_SIZE];
+    uint16_t response_buffer_len;
+    uint16_t response_buffer_offset;
+    avrcp_pdu_id_t response_pdu_id;
+    uint8_t  send_response_fragment;
     
     avrcp_parser_state_t parser_state;
     uint8_t  parser_attribute_header[AVRCP_ATTRIBUTE_HEADER_LEN];
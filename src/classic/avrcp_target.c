@@ -47,6 +47,10 @@
 #include "classic/avrcp.h"
 
 #define AVRCP_ATTR_HEADER_LEN  8
+#define AVCTP_HEADER_LEN       3
+#define AVRCP_MAX_AV_C_FRAME_SIZE 512
+// AVCTP header, ctype, subunit, opcode, company id (3), pdu id, packet type, param length (2)
+#define AVRCP_VENDOR_DEPENDENT_RESPONSE_HEADER_LEN 13
 
 static const uint8_t AVRCP_NOTIFICATION_TRACK_SELECTED[] = {0,0,0,0,0,0,0,0};
 static const uint8_t AVRCP_NOTIFICATION_TRACK_NOT_SELECTED[] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
@@ -83,32 +87,30 @@ static void avrcp_target_emit_respond_vendor_dependent_query(btstack_packet_hand
     (*callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
-static uint16_t avrcp_target_pack_single_element_attribute_number(uint8_t * packet, uint16_t pos, avrcp_media_attribute_id_t attr_id, uint32_t value){
-    if ((attr_id < 1) || (attr_id > AVRCP_MEDIA_ATTR_COUNT)) return 0;
-    uint16_t attr_value_length = sprintf((char *)(packet+pos+8), "%0" PRIu32, value);
-    big_endian_store_32(packet, pos, attr_id); 
+static int avrcp_target_pack_single_element_attribute(avrcp_connection_t * connection, avrcp_media_attribute_id_t attr_id, const uint8_t * attr_value, uint16_t attr_value_len){
+    uint16_t pos = connection->response_buffer_len;
+    if ((pos + AVRCP_ATTR_HEADER_LEN) > AVRCP_TARGET_RESPONSE_BUFFER_SIZE) return 0;
+    uint16_t max_value_len = AVRCP_TARGET_RESPONSE_BUFFER_SIZE - pos - AVRCP_ATTR_HEADER_LEN;
+    if (attr_value_len > max_value_len){
+        log_info("AVRCP target: attribute %u truncated to %u bytes", (int) attr_id, max_value_len);
+        attr_value_len = max_value_len;
+    }
+    big_endian_store_32(connection->response_buffer, pos, attr_id); 
     pos += 4;
-    big_endian_store_16(packet, pos, RFC2978_CHARSET_MIB_UTF8);
+    big_endian_store_16(connection->response_buffer, pos, RFC2978_CHARSET_MIB_UTF8);
     pos += 2;
-    big_endian_store_16(packet, pos, attr_value_length);
+    big_endian_store_16(connection->response_buffer, pos, attr_value_len);
     pos += 2;
-    return 8 + attr_value_length;
+    memcpy(connection->response_buffer + pos, attr_value, attr_value_len);
+    pos += attr_value_len;
+    connection->response_buffer_len = pos;
+    return 1;
 }
 
-static uint16_t avrcp_target_pack_single_element_attribute_string(uint8_t * packet, uint16_t pos, rfc2978_charset_mib_enumid_t mib_enumid, avrcp_media_attribute_id_t attr_id, uint8_t * attr_value, uint16_t attr_value_to_copy, uint16_t attr_value_size, uint8_t header){
-    if (attr_value_size == 0) return 0;
-    if ((attr_id < 1) || (attr_id > AVRCP_MEDIA_ATTR_COUNT)) return 0;
-    if (header){
-        big_endian_store_32(packet, pos, attr_id); 
-        pos += 4;
-        big_endian_store_16(packet, pos, mib_enumid);
-        pos += 2;
-        big_endian_store_16(packet, pos, attr_value_size);
-        pos += 2;
-    }
-    memcpy(packet+pos, attr_value, attr_value_to_copy);
-    pos += attr_value_size;
-    return header * 8 + attr_value_size;
+static int avrcp_target_pack_single_element_attribute_number(avrcp_connection_t * connection, avrcp_media_attribute_id_t attr_id, uint32_t value){
+    char number[11];
+    int number_len = snprintf(number, sizeof(number), "%" PRIu32, value);
+    return avrcp_target_pack_single_element_attribute(connection, attr_id, (const uint8_t *) number, number_len);
 }
 
 static int avrcp_target_abort_continue_response(uint16_t cid, avrcp_connection_t * connection){
@@ -146,12 +148,31 @@ static int avrcp_target_abort_continue_response(uint16_t cid, avrcp_connection_t
     return l2cap_send_prepared(cid, pos); 
 }
 
-static int avrcp_target_send_now_playing_info(uint16_t cid, avrcp_connection_t * connection){
+// send next fragment of the vendor dependent response stored in response buffer
+static int avrcp_target_send_response_fragment(uint16_t cid, avrcp_connection_t * connection){
     uint16_t pos = 0; 
     l2cap_reserve_packet_buffer();
     uint8_t * packet = l2cap_get_outgoing_buffer();
-    uint16_t  size   = l2cap_get_remote_mtu_for_local_cid(connection->l2cap_signaling_cid);
-   
+
+    // use remote MTU, but a single AV/C frame must not exceed 512 bytes
+    uint16_t max_packet_len = btstack_min(l2cap_get_remote_mtu_for_local_cid(cid), AVCTP_HEADER_LEN + AVRCP_MAX_AV_C_FRAME_SIZE);
+    uint16_t max_fragment_len = max_packet_len - AVRCP_VENDOR_DEPENDENT_RESPONSE_HEADER_LEN;
+    uint16_t bytes_to_send = connection->response_buffer_len - connection->response_buffer_offset;
+
+    avrcp_packet_type_t packet_type;
+    if (bytes_to_send <= max_fragment_len){
+        packet_type = (connection->response_buffer_offset == 0) ? AVRCP_SINGLE_PACKET : AVRCP_END_PACKET;
+    } else {
+        packet_type = (connection->response_buffer_offset == 0) ? AVRCP_START_PACKET : AVRCP_CONTINUE_PACKET;
+        bytes_to_send = max_fragment_len;
+    }
+
+    connection->command_opcode  = AVRCP_CMD_OPCODE_VENDOR_DEPENDENT;
+    connection->command_type    = AVRCP_CTYPE_RESPONSE_IMPLEMENTED_STABLE;
+    connection->subunit_type    = AVRCP_SUBUNIT_TYPE_PANEL; 
+    connection->subunit_id      = AVRCP_SUBUNIT_ID;
+    connection->packet_type     = packet_type;
+
     packet[pos++] = (connection->transaction_label << 4) | (AVRCP_SINGLE_PACKET << 2) | (AVRCP_RESPONSE_FRAME << 1) | 0;
     // Profile IDentifier (PID)
     packet[pos++] = BLUETOOTH_SERVICE_CLASS_AV_REMOTE_CONTROL >> 8;
@@ -168,117 +189,22 @@ static int avrcp_target_send_now_playing_info(uint16_t cid, avrcp_connection_t *
     big_endian_store_24(packet, pos, BT_SIG_COMPANY_ID);
     pos += 3;
 
-    packet[pos++] = AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES;
-    
-    // reserve byte for packet type
-    uint8_t pos_packet_type = pos;
-    pos++;
-   
-    uint16_t playing_info_buffer_len_position = pos;
+    packet[pos++] = connection->response_pdu_id;
+    packet[pos++] = packet_type;
+    big_endian_store_16(packet, pos, bytes_to_send);
     pos += 2;
-    // printf("connection->next_attr_id %d \n", connection->next_attr_id);
-    if (connection->next_attr_id == AVRCP_MEDIA_ATTR_NONE){
-        packet[pos_packet_type] = AVRCP_SINGLE_PACKET;
-        connection->packet_type = AVRCP_SINGLE_PACKET;
-        packet[pos++] = count_set_bits_uint32(connection->now_playing_info_attr_bitmap);
-        connection->next_attr_id++;
-    }
-    // printf("updated connection->next_attr_id %d, connection->attribute_value_offset %d \n", connection->next_attr_id, connection->attribute_value_offset);
-    
-    uint8_t fragmented = 0;
-    int num_free_bytes = size - pos - 2;
-    uint8_t MAX_NUMBER_ATTR_LEN = 10;
-
-    while (!fragmented && num_free_bytes > 0 && connection->next_attr_id <= AVRCP_MEDIA_ATTR_SONG_LENGTH_MS){
-        avrcp_media_attribute_id_t attr_id = connection->next_attr_id;
-        int attr_index = attr_id - 1;
-
-        if (connection->now_playing_info_attr_bitmap & (1 << attr_id)){
-            int num_written_bytes = 0;
-            int num_bytes_to_write = 0;
-            switch (attr_id){
-                case AVRCP_MEDIA_ATTR_ALL:
-                case AVRCP_MEDIA_ATTR_NONE:
-                    break;
-                case AVRCP_MEDIA_ATTR_TRACK:
-                    num_bytes_to_write = AVRCP_ATTR_HEADER_LEN + MAX_NUMBER_ATTR_LEN;
-                    if (num_free_bytes >= num_bytes_to_write){
-                        num_written_bytes = avrcp_target_pack_single_element_attribute_number(packet, pos, attr_id, connection->track_nr);
-                        break;
-                    }
-                    fragmented = 1;
-                    connection->attribute_value_offset = 0;
-                    break;
-                case AVRCP_MEDIA_ATTR_TOTAL_NUM_ITEMS:
-                    num_bytes_to_write = AVRCP_ATTR_HEADER_LEN + MAX_NUMBER_ATTR_LEN;
-                    if (num_free_bytes >= num_bytes_to_write){
-                        num_written_bytes = avrcp_target_pack_single_element_attribute_number(packet, pos, attr_id, connection->total_tracks);
-                        break;
-                    }
-                    fragmented = 1;
-                    connection->attribute_value_offset = 0;
-                    break;
-                case AVRCP_MEDIA_ATTR_SONG_LENGTH_MS:
-                    num_bytes_to_write = AVRCP_ATTR_HEADER_LEN + MAX_NUMBER_ATTR_LEN;
-                    if (num_free_bytes >= num_bytes_to_write){
-                        num_written_bytes = avrcp_target_pack_single_element_attribute_number(packet, pos, attr_id, connection->song_length_ms);
-                        break;
-                    }
-                    fragmented = 1;
-                    connection->attribute_value_offset = 0;
-                    break;
-                default:{
-                    uint8_t   header = (connection->attribute_value_offset == 0);
-                    uint8_t * attr_value =     (uint8_t *) (connection->now_playing_info[attr_index].value + connection->attribute_value_offset);
-                    uint16_t  attr_value_len = connection->now_playing_info[attr_index].len - connection->attribute_value_offset;
-                    
-                    num_bytes_to_write = attr_value_len + header * AVRCP_ATTR_HEADER_LEN;
-                    if (num_bytes_to_write <= num_free_bytes){
-                        connection->attribute_value_offset = 0;
-                        num_written_bytes = num_bytes_to_write;
-                        avrcp_target_pack_single_element_attribute_string(packet, pos, RFC2978_CHARSET_MIB_UTF8, attr_id, attr_value, attr_value_len, connection->now_playing_info[attr_index].len, header);
-                        break;
-                    } 
-                    fragmented = 1;
-                    num_written_bytes = num_free_bytes;
-                    attr_value_len = num_free_bytes - header * AVRCP_ATTR_HEADER_LEN;
-                    avrcp_target_pack_single_element_attribute_string(packet, pos, RFC2978_CHARSET_MIB_UTF8, attr_id, attr_value, attr_value_len, connection->now_playing_info[attr_index].len, header);
-                    connection->attribute_value_offset += attr_value_len;
-                    break;
-                }
-            }
-            pos += num_written_bytes;
-            num_free_bytes -= num_written_bytes; 
-        } 
-        if (!fragmented){
-            connection->next_attr_id++;
-        }
-    }
+    memcpy(packet + pos, connection->response_buffer + connection->response_buffer_offset, bytes_to_send);
+    pos += bytes_to_send;
 
-    if (fragmented){
-        switch (connection->packet_type){
-            case AVRCP_SINGLE_PACKET:
-                connection->packet_type = AVRCP_START_PACKET;
-                break;
-            default:
-                connection->packet_type = AVRCP_CONTINUE_PACKET;
-                break;
-        }
-    } else {
-        if (connection->next_attr_id >= AVRCP_MEDIA_ATTR_SONG_LENGTH_MS){ // DONE
-            if (connection->packet_type != AVRCP_SINGLE_PACKET){
-                connection->packet_type = AVRCP_END_PACKET;
-            }
-        }
+    connection->response_buffer_offset += bytes_to_send;
+    if (connection->response_buffer_offset == connection->response_buffer_len){
+        connection->response_buffer_len = 0;
+        connection->response_buffer_offset = 0;
     }
-    packet[pos_packet_type] = connection->packet_type;
-    // store attr value length
-    big_endian_store_16(packet, playing_info_buffer_len_position, pos - playing_info_buffer_len_position - 2);
-    return l2cap_send_prepared(cid, size); 
+    connection->wait_to_send = 0;
+    return l2cap_send_prepared(cid, pos); 
 }
 
-
-
 static int avrcp_target_send_response(uint16_t cid, avrcp_connection_t * connection){
     int pos = 0; 
     l2cap_reserve_packet_buffer();
@@ -287,7 +213,8 @@ static int avrcp_target_send_response(uint16_t cid, avrcp_connection_t * connect
     // transport header
     // Transaction label | Packet_type | C/R | IPID (1 == invalid profile identifier)
 
-    // TODO: check for fragmentation
+    // only fixed-size responses that fit into a single frame are sent here,
+    // larger vendor dependent responses are queued in response_buffer and sent by avrcp_target_send_response_fragment
     connection->packet_type = AVRCP_SINGLE_PACKET;
 
     packet[pos++] = (connection->transaction_label << 4) | (connection->packet_type << 2) | (AVRCP_RESPONSE_FRAME << 1) | 0;
@@ -551,32 +478,32 @@ static inline uint8_t avrcp_prepare_vendor_dependent_response(uint16_t avrcp_cid
     }
 
     if ((*out_connection)->state != AVCTP_CONNECTION_OPENED) return ERROR_CODE_COMMAND_DISALLOWED;
-    (*out_connection)->command_opcode  = AVRCP_CMD_OPCODE_VENDOR_DEPENDENT;
-    (*out_connection)->command_type    = AVRCP_CTYPE_RESPONSE_IMPLEMENTED_STABLE;
-    (*out_connection)->subunit_type    = AVRCP_SUBUNIT_TYPE_PANEL; 
-    (*out_connection)->subunit_id      = AVRCP_SUBUNIT_ID;
-
-    (*out_connection)->cmd_operands[(*out_connection)->cmd_operands_length++] = pdu_id;
-    // reserved
-    (*out_connection)->cmd_operands[(*out_connection)->cmd_operands_length++] = 0;
-    // param length
-    big_endian_store_16((*out_connection)->cmd_operands, (*out_connection)->cmd_operands_length, param_length);
-    (*out_connection)->cmd_operands_length += 2;
+    if ((*out_connection)->send_response_fragment) return ERROR_CODE_COMMAND_DISALLOWED;
+    if (param_length > AVRCP_TARGET_RESPONSE_BUFFER_SIZE) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+
+    // parameters are collected in response buffer and sent in fragments if needed
+    (*out_connection)->response_pdu_id        = pdu_id;
+    (*out_connection)->response_buffer_len    = 0;
+    (*out_connection)->response_buffer_offset = 0;
     return ERROR_CODE_SUCCESS;
 }
 
+static void avrcp_target_send_vendor_dependent_response(avrcp_connection_t * connection){
+    connection->send_response_fragment = 1;
+    avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
+}
+
 static uint8_t avrcp_target_capability(uint16_t avrcp_cid, avrcp_capability_id_t capability_id, uint8_t capabilities_num, uint8_t * capabilities, uint8_t size){
     avrcp_connection_t * connection = NULL;
     uint8_t status = avrcp_prepare_vendor_dependent_response(avrcp_cid, &connection, AVRCP_PDU_ID_GET_CAPABILITIES, 2+size);
     if (status != ERROR_CODE_SUCCESS) return status;
 
-    connection->cmd_operands[connection->cmd_operands_length++] = capability_id;
-    connection->cmd_operands[connection->cmd_operands_length++] = capabilities_num;
-    memcpy(connection->cmd_operands+connection->cmd_operands_length, capabilities, size);
-    connection->cmd_operands_length += size;
+    connection->response_buffer[connection->response_buffer_len++] = capability_id;
+    connection->response_buffer[connection->response_buffer_len++] = capabilities_num;
+    memcpy(connection->response_buffer+connection->response_buffer_len, capabilities, size);
+    connection->response_buffer_len += size;
     
-    connection->state = AVCTP_W2_SEND_RESPONSE;
-    avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
+    avrcp_target_send_vendor_dependent_response(connection);
     return ERROR_CODE_SUCCESS;
 }
 
@@ -593,27 +520,46 @@ uint8_t avrcp_target_play_status(uint16_t avrcp_cid, uint32_t song_length_ms, ui
     uint8_t status = avrcp_prepare_vendor_dependent_response(avrcp_cid, &connection, AVRCP_PDU_ID_GET_PLAY_STATUS, 11);
     if (status != ERROR_CODE_SUCCESS) return status;
 
-    big_endian_store_32(connection->cmd_operands, connection->cmd_operands_length, song_length_ms);
-    connection->cmd_operands_length += 4;
-    big_endian_store_32(connection->cmd_operands, connection->cmd_operands_length, song_position_ms);
-    connection->cmd_operands_length += 4;
-    connection->cmd_operands[connection->cmd_operands_length++] = play_status;
+    big_endian_store_32(connection->response_buffer, connection->response_buffer_len, song_length_ms);
+    connection->response_buffer_len += 4;
+    big_endian_store_32(connection->response_buffer, connection->response_buffer_len, song_position_ms);
+    connection->response_buffer_len += 4;
+    connection->response_buffer[connection->response_buffer_len++] = play_status;
     
-    connection->state = AVCTP_W2_SEND_RESPONSE;
-    avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
+    avrcp_target_send_vendor_dependent_response(connection);
     return ERROR_CODE_SUCCESS;
 }
 
-static uint8_t avrcp_target_now_playing_info(avrcp_connection_t * connection){
-    if (connection->state != AVCTP_CONNECTION_OPENED) return ERROR_CODE_COMMAND_DISALLOWED;
-    connection->now_playing_info_response = 1;
-    connection->command_opcode  = AVRCP_CMD_OPCODE_VENDOR_DEPENDENT;
-    connection->command_type    = AVRCP_CTYPE_RESPONSE_IMPLEMENTED_STABLE;
-    connection->subunit_type    = AVRCP_SUBUNIT_TYPE_PANEL; 
-    connection->subunit_id      = AVRCP_SUBUNIT_ID;
+static uint8_t avrcp_target_now_playing_info(uint16_t avrcp_cid, uint32_t attr_bitmap){
+    avrcp_connection_t * connection = NULL;
+    uint8_t status = avrcp_prepare_vendor_dependent_response(avrcp_cid, &connection, AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES, 1);
+    if (status != ERROR_CODE_SUCCESS) return status;
 
-    connection->state = AVCTP_W2_SEND_RESPONSE;
-    avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
+    // number of attributes, updated below
+    connection->response_buffer[connection->response_buffer_len++] = 0;
+    uint8_t num_attributes = 0;
+    int attr_id;
+    for (attr_id = AVRCP_MEDIA_ATTR_TITLE; attr_id <= AVRCP_MEDIA_ATTR_SONG_LENGTH_MS; attr_id++){
+        if ((attr_bitmap & (1 << attr_id)) == 0) continue;
+        switch (attr_id){
+            case AVRCP_MEDIA_ATTR_TRACK:
+                num_attributes += avrcp_target_pack_single_element_attribute_number(connection, attr_id, (uint32_t) connection->track_nr);
+                break;
+            case AVRCP_MEDIA_ATTR_TOTAL_NUM_ITEMS:
+                num_attributes += avrcp_target_pack_single_element_attribute_number(connection, attr_id, (uint32_t) connection->total_tracks);
+                break;
+            case AVRCP_MEDIA_ATTR_SONG_LENGTH_MS:
+                num_attributes += avrcp_target_pack_single_element_attribute_number(connection, attr_id, connection->song_length_ms);
+                break;
+            default:
+                if (connection->now_playing_info[attr_id - 1].len == 0) break;
+                num_attributes += avrcp_target_pack_single_element_attribute(connection, attr_id, connection->now_playing_info[attr_id - 1].value, connection->now_playing_info[attr_id - 1].len);
+                break;
+        }
+    }
+    connection->response_buffer[0] = num_attributes;
+
+    avrcp_target_send_vendor_dependent_response(connection);
     return ERROR_CODE_SUCCESS;
 }
 
@@ -902,19 +848,28 @@ static void avrcp_handle_l2cap_data_packet_for_signaling_connection(avrcp_connec
                     avrcp_target_emit_respond_vendor_dependent_query(avrcp_target_context.avrcp_callback, connection->avrcp_cid, AVRCP_SUBEVENT_PLAY_STATUS_QUERY);
                     break;
                 case AVRCP_PDU_ID_REQUEST_ABORT_CONTINUING_RESPONSE:
-                    connection->cmd_operands[0] = pdu[4];
+                    // drop remaining fragments
+                    connection->response_buffer_len = 0;
+                    connection->response_buffer_offset = 0;
+                    connection->send_response_fragment = 0;
                     connection->abort_continue_response = 1;
                     avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
                     break;
                 case AVRCP_PDU_ID_REQUEST_CONTINUING_RESPONSE:
-                    if (pdu[4] != AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES){
-                        avrcp_target_response_reject(connection, subunit_type, subunit_id, opcode, pdu_id, AVRCP_STATUS_INVALID_COMMAND);
+                    // only valid while fragments of the response to the given pdu are pending
+                    if ((connection->response_buffer_offset == 0) || (pdu[4] != connection->response_pdu_id)){
+                        avrcp_target_response_reject(connection, subunit_type, subunit_id, opcode, pdu_id, AVRCP_STATUS_INVALID_PARAMETER);
                         return;
                     }
-                    connection->now_playing_info_response = 1;
-                    avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
+                    avrcp_target_send_vendor_dependent_response(connection);
                     break;
                 case AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES:{
+                    // identifier, attribute count and attribute ids have to be part of the received PDU
+                    uint16_t pdu_size = (size > (pdu - packet)) ? (size - (pdu - packet)) : 0;
+                    if ((pos + 9) > pdu_size){
+                        avrcp_target_response_reject(connection, subunit_type, subunit_id, opcode, pdu_id, AVRCP_STATUS_INVALID_PARAMETER);
+                        return;
+                    }
                     uint8_t play_identifier[8];
                     memset(play_identifier, 0, 8);
                     if (memcmp(pdu+pos, play_identifier, 8) != 0) {
@@ -923,21 +878,26 @@ static void avrcp_handle_l2cap_data_packet_for_signaling_connection(avrcp_connec
                     }
                     pos += 8;
                     uint8_t attribute_count = pdu[pos++];
-                    // printf("AVRCP_PDU_ID_GET_ELEMENT_ATTRIBUTES attribute count %d\n", attribute_count);
-                    connection->next_attr_id = AVRCP_MEDIA_ATTR_NONE;
+                    if ((pos + (4 * attribute_count)) > pdu_size){
+                        avrcp_target_response_reject(connection, subunit_type, subunit_id, opcode, pdu_id, AVRCP_STATUS_INVALID_PARAMETER);
+                        return;
+                    }
+                    uint32_t attr_bitmap;
                     if (!attribute_count){
-                        connection->now_playing_info_attr_bitmap = 0xFE;
+                        attr_bitmap = 0xFE;
                     } else {
                         int i;
-                        connection->now_playing_info_attr_bitmap = 0;
+                        attr_bitmap = 0;
                         for (i=0; i < attribute_count; i++){
-                            uint16_t attr_id = big_endian_read_16(pdu, pos);
-                            pos += 2;
-                            connection->now_playing_info_attr_bitmap |= (1 << attr_id);
+                            // attribute ids are 4 bytes long
+                            uint32_t attr_id = big_endian_read_32(pdu, pos);
+                            pos += 4;
+                            if ((attr_id < AVRCP_MEDIA_ATTR_TITLE) || (attr_id > AVRCP_MEDIA_ATTR_SONG_LENGTH_MS)) continue;
+                            attr_bitmap |= (1 << attr_id);
                         }
                     }
-                    log_info("now_playing_info_attr_bitmap 0x%02x", connection->now_playing_info_attr_bitmap);
-                    avrcp_target_now_playing_info(connection);
+                    log_info("now_playing_info_attr_bitmap 0x%02x", (int) attr_bitmap);
+                    avrcp_target_now_playing_info(connection->avrcp_cid, attr_bitmap);
                     break;
                 }
                 case AVRCP_PDU_ID_REGISTER_NOTIFICATION:{
@@ -1135,14 +1095,15 @@ static void avrcp_target_packet_handler(uint8_t packet_type, uint16_t channel, u
                     
                     if (connection->abort_continue_response){
                         connection->abort_continue_response = 0;
-                        connection->now_playing_info_response = 0;
                         avrcp_target_abort_continue_response(connection->l2cap_signaling_cid, connection);
+                        avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
                         break;
                     }
 
-                    if (connection->now_playing_info_response){
-                        connection->now_playing_info_response = 0;
-                        avrcp_target_send_now_playing_info(connection->l2cap_signaling_cid, connection);
+                    if (connection->send_response_fragment){
+                        connection->send_response_fragment = 0;
+                        avrcp_target_send_response_fragment(connection->l2cap_signaling_cid, connection);
+                        avrcp_request_can_send_now(connection, connection->l2cap_signaling_cid);
                         break;
                     }
                     
@@ -1211,11 +1172,6 @@ static void avrcp_target_packet_handler(uint8_t packet_type, uint16_t channel, u
                     switch (connection->state){
                         case AVCTP_W2_SEND_RESPONSE:
                             connection->state = AVCTP_CONNECTION_OPENED;
-                            // if (connection->now_playing_info_response){
-                            //     connection->now_playing_info_response = 0;
-                            //     avrcp_target_send_now_playing_info(connection->l2cap_signaling_cid, connection);
-                            //     break;
-                            // } 
                             avrcp_target_send_response(connection->l2cap_signaling_cid, connection);
                             break;
                         default:
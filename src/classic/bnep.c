@@ -394,19 +394,122 @@ void bnep_request_can_send_now_event(uint16_t bnep_cid)
 }
 
 
+/* Filter ranges are sorted and merged when set, and a 32 bucket bitmap allows to reject most
+   packets without looking at the ranges. Remaining packets are checked by binary search. */
+
+/* Bucket for network protocol type: upper 5 bits */
+static inline int bnep_net_filter_bucket(uint16_t network_protocol_type)
+{
+    return network_protocol_type >> 11;
+}
+
+/* Bucket for multicast address: upper 5 bits of first octet */
+static inline int bnep_multicast_filter_bucket(const uint8_t *addr)
+{
+    return addr[0] >> 3;
+}
+
+static uint32_t bnep_filter_buckets_for_range(int bucket_start, int bucket_end)
+{
+    uint32_t buckets = 0;
+    int i;
+    for (i = bucket_start; i <= bucket_end; i++) {
+        buckets |= 1u << i;
+    }
+    return buckets;
+}
+
+static void bnep_net_filter_finalize(bnep_channel_t *channel)
+{
+    int i, j;
+    int count = 0;
+
+    /* Insertion sort by range start */
+    for (i = 1; i < channel->net_filter_count; i++) {
+        bnep_net_filter_t filter = channel->net_filter[i];
+        for (j = i; (j > 0) && (channel->net_filter[j-1].range_start > filter.range_start); j--) {
+            channel->net_filter[j] = channel->net_filter[j-1];
+        }
+        channel->net_filter[j] = filter;
+    }
+
+    /* Merge overlapping or adjacent ranges */
+    for (i = 0; i < channel->net_filter_count; i++) {
+        if ((count > 0) && ((uint32_t) channel->net_filter[i].range_start <= (uint32_t) channel->net_filter[count-1].range_end + 1)) {
+            if (channel->net_filter[i].range_end > channel->net_filter[count-1].range_end) {
+                channel->net_filter[count-1].range_end = channel->net_filter[i].range_end;
+            }
+            continue;
+        }
+        channel->net_filter[count++] = channel->net_filter[i];
+    }
+    channel->net_filter_count = count;
+
+    channel->net_filter_buckets = 0;
+    for (i = 0; i < count; i++) {
+        channel->net_filter_buckets |= bnep_filter_buckets_for_range(bnep_net_filter_bucket(channel->net_filter[i].range_start),
+                                                                     bnep_net_filter_bucket(channel->net_filter[i].range_end));
+    }
+}
+
+static void bnep_multicast_filter_finalize(bnep_channel_t *channel)
+{
+    int i, j;
+    int count = 0;
+
+    /* Insertion sort by start address */
+    for (i = 1; i < channel->multicast_filter_count; i++) {
+        bnep_multi_filter_t filter = channel->multicast_filter[i];
+        for (j = i; (j > 0) && (memcmp(channel->multicast_filter[j-1].addr_start, filter.addr_start, ETHER_ADDR_LEN) > 0); j--) {
+            channel->multicast_filter[j] = channel->multicast_filter[j-1];
+        }
+        channel->multicast_filter[j] = filter;
+    }
+
+    /* Merge overlapping ranges */
+    for (i = 0; i < channel->multicast_filter_count; i++) {
+        if ((count > 0) && (memcmp(channel->multicast_filter[i].addr_start, channel->multicast_filter[count-1].addr_end, ETHER_ADDR_LEN) <= 0)) {
+            if (memcmp(channel->multicast_filter[i].addr_end, channel->multicast_filter[count-1].addr_end, ETHER_ADDR_LEN) > 0) {
+                bd_addr_copy(channel->multicast_filter[count-1].addr_end, channel->multicast_filter[i].addr_end);
+            }
+            continue;
+        }
+        channel->multicast_filter[count++] = channel->multicast_filter[i];
+    }
+    channel->multicast_filter_count = count;
+
+    channel->multicast_filter_buckets = 0;
+    for (i = 0; i < count; i++) {
+        channel->multicast_filter_buckets |= bnep_filter_buckets_for_range(bnep_multicast_filter_bucket(channel->multicast_filter[i].addr_start),
+                                                                           bnep_multicast_filter_bucket(channel->multicast_filter[i].addr_end));
+    }
+}
+
 static int bnep_filter_protocol(bnep_channel_t *channel, uint16_t network_protocol_type)
 {
-	int i;
+    int left, right;
     
     if (channel->net_filter_count == 0) {
         /* No filter set */
         return 1;
     }
 
-    for (i = 0; i < channel->net_filter_count; i ++) {
-        if ((network_protocol_type >= channel->net_filter[i].range_start) &&
-            (network_protocol_type <= channel->net_filter[i].range_end)) {
-            return 1;
+    if ((channel->net_filter_buckets & (1u << bnep_net_filter_bucket(network_protocol_type))) == 0) {
+        return 0;
+    }
+
+    /* Find last range starting at or before the protocol type */
+    left  = 0;
+    right = channel->net_filter_count - 1;
+    while (left <= right) {
+        int middle = (left + right) / 2;
+        if (channel->net_filter[middle].range_start <= network_protocol_type) {
+            if (network_protocol_type <= channel->net_filter[middle].range_end) {
+                return 1;
+            }
+            left = middle + 1;
+        } else {
+            right = middle - 1;
         }
     }
 
@@ -415,7 +518,7 @@ static int bnep_filter_protocol(bnep_channel_t *channel, uint16_t network_protoc
 
 static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
 {
-	int i;
+    int left, right;
 
     /* Check if the multicast flag is set int the destination address */
 	if ((addr_dest[0] & 0x01) == 0x00) {
@@ -428,12 +531,24 @@ static int bnep_filter_multicast(bnep_channel_t *channel, bd_addr_t addr_dest)
         return 1;
     }
 
-	for (i = 0; i < channel->multicast_filter_count; i ++) {
-		if ((memcmp(addr_dest, channel->multicast_filter[i].addr_start, sizeof(bd_addr_t)) >= 0) &&
-		    (memcmp(addr_dest, channel->multicast_filter[i].addr_end, sizeof(bd_addr_t)) <= 0)) {
-			return 1;
+    if ((channel->multicast_filter_buckets & (1u << bnep_multicast_filter_bucket(addr_dest))) == 0) {
+        return 0;
+    }
+
+    /* Find last range starting at or before the destination address */
+    left  = 0;
+    right = channel->multicast_filter_count - 1;
+    while (left <= right) {
+        int middle = (left + right) / 2;
+        if (memcmp(channel->multicast_filter[middle].addr_start, addr_dest, sizeof(bd_addr_t)) <= 0) {
+            if (memcmp(addr_dest, channel->multicast_filter[middle].addr_end, sizeof(bd_addr_t)) <= 0) {
+                return 1;
+            }
+            left = middle + 1;
+        } else {
+            right = middle - 1;
         }
-	}
+    }
 
 	return 0;
 }
@@ -946,6 +1061,7 @@ static int bnep_handle_filter_net_type_set(bnep_channel_t *channel, uint8_t *pac
                 channel->net_filter_count ++;
             }
         }
+        bnep_net_filter_finalize(channel);
     }
 
     /* Set flag to send out the set net filter response on next statemachine cycle */
@@ -1033,6 +1149,7 @@ static int bnep_handle_multi_addr_set(bnep_channel_t *channel, uint8_t *packet,
                 channel->multicast_filter_count ++;
             }
         }
+        bnep_multicast_filter_finalize(channel);
     }
     /* Set flag to send out the set multi addr response on next statemachine cycle */
     bnep_channel_state_add(channel, BNEP_CHANNEL_STATE_VAR_SND_FILTER_MULTI_ADDR_RESPONSE);
@@ -123,12 +123,14 @@ typedef struct {
 
     bnep_net_filter_t  net_filter[MAX_BNEP_NETFILTER];              // network protocol filter, define fixed size for now
     uint16_t           net_filter_count;
+    uint32_t           net_filter_buckets;                          // hashed ranges: bit set for each bucket touched by a filter range
 
     bnep_net_filter_t *net_filter_out;                              // outgoint network protocol filter, must be statically allocated in the application
     uint16_t           net_filter_out_count;
     
     bnep_multi_filter_t  multicast_filter[MAX_BNEP_MULTICAST_FILTER]; // multicast address filter, define fixed size for now
     uint16_t             multicast_filter_count;
+    uint32_t             multicast_filter_buckets;                    // hashed ranges: bit set for each bucket touched by a filter range
     
     bnep_multi_filter_t *multicast_filter_out;                        // outgoing multicast address filter, must be statically allocated in the application
     uint16_t             multicast_filter_out_count;
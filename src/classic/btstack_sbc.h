@@ -80,6 +80,7 @@ typedef struct {
 /* BTstack SBC decoder */
 /**
  * @brief Init SBC decoder
+ * @note If all MAX_NR_SBC_DECODERS decoder instances are in use, an error is logged and received data is dropped
  * @param state
  * @param mode
  * @param callback for decoded PCM data in host endianess
@@ -88,6 +89,13 @@ typedef struct {
 
 void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_mode_t mode, void (*callback)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context), void * context);
 
+/**
+ * @brief Release decoder instance, e.g. after stream was closed
+ * @note Each initialized state uses one of MAX_NR_SBC_DECODERS decoder instances with its own PLC state
+ * @param state
+ */
+void btstack_sbc_decoder_deinit(btstack_sbc_decoder_state_t * state);
+
 /**
  * @brief Process received SBC data
  * @param state
@@ -97,6 +105,19 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
  */
 void btstack_sbc_decoder_process_data(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size);
 
+/**
+ * @brief Decode all complete SBC frames in received data, e.g. A2DP media packet, into PCM buffer instead of calling the PCM callback per frame
+ * @note Frames that don't fit into pcm_buffer are dropped. Incomplete frames are kept and decoded with next call
+ * @param state
+ * @param packet_status_flag see btstack_sbc_decoder_process_data
+ * @param buffer
+ * @param size
+ * @param pcm_buffer for decoded samples in host endianess, interleaved if stereo
+ * @param pcm_buffer_size in samples (int16_t)
+ * @return number of audio frames stored, each audio frame contains btstack_sbc_decoder_num_channels samples
+ */
+int btstack_sbc_decoder_process_data_to_buffer(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size, int16_t * pcm_buffer, int pcm_buffer_size);
+
 /**
  * @brief Get number of samples per SBC frame
  */
@@ -64,7 +64,13 @@
 
 #define DECODER_DATA_SIZE (SBC_MAX_CHANNELS*SBC_MAX_BLOCKS*SBC_MAX_BANDS * 4 + SBC_CODEC_MIN_FILTER_BUFFERS*SBC_MAX_BANDS*SBC_MAX_CHANNELS * 2)
 
+// number of concurrent decoder instances, e.g. one per A2DP Sink stream or HFP connection
+#ifndef MAX_NR_SBC_DECODERS
+#define MAX_NR_SBC_DECODERS 1
+#endif
+
 typedef struct {
+    btstack_sbc_decoder_state_t * owner;
     OI_UINT32 bytes_in_frame_buffer;
     OI_CODEC_SBC_DECODER_CONTEXT decoder_context;
     
@@ -77,10 +83,19 @@ typedef struct {
     int search_new_sync_word;
     int sync_word_found;
     int first_good_frame_found; 
+
+    // caller provided PCM buffer for btstack_sbc_decoder_process_data_to_buffer
+    int16_t * pcm_output;
+    int pcm_output_size;
+    int pcm_output_len;
+
+    // testing only
+    int plc_enabled;
+    int corrupt_frame_period;
+    int corrupt_frame_count;
 } bludroid_decoder_state_t;
 
-static btstack_sbc_decoder_state_t * sbc_decoder_state_singleton = NULL;
-static bludroid_decoder_state_t bd_decoder_state;
+static bludroid_decoder_state_t bd_decoder_states[MAX_NR_SBC_DECODERS];
 
 // Testing only - START
 static int plc_enabled = 1;
@@ -89,10 +104,18 @@ static int corrupt_frame_period = -1;
 
 void btstack_sbc_decoder_test_disable_plc(void){
     plc_enabled = 0;
+    int i;
+    for (i=0;i<MAX_NR_SBC_DECODERS;i++){
+        bd_decoder_states[i].plc_enabled = 0;
+    }
 }
 
 void btstack_sbc_decoder_test_simulate_corrupt_frames(int period){
     corrupt_frame_period = period;
+    int i;
+    for (i=0;i<MAX_NR_SBC_DECODERS;i++){
+        bd_decoder_states[i].corrupt_frame_period = period;
+    }
 }
 
 static int find_sequence_of_zeros(const OI_BYTE *frame_data, OI_UINT32 frame_bytes, int seq_length){
@@ -137,16 +160,19 @@ static int find_h2_syncword(const OI_BYTE *frame_data, OI_UINT32 frame_bytes){
 
 int btstack_sbc_decoder_num_samples_per_frame(btstack_sbc_decoder_state_t * state){
     bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t *) state->decoder_state;
+    if (!decoder_state) return 0;
     return decoder_state->decoder_context.common.frameInfo.nrof_blocks * decoder_state->decoder_context.common.frameInfo.nrof_subbands;
 }
 
 int btstack_sbc_decoder_num_channels(btstack_sbc_decoder_state_t * state){
     bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t *) state->decoder_state;
+    if (!decoder_state) return 0;
     return decoder_state->decoder_context.common.frameInfo.nrof_channels;
 }
 
 int btstack_sbc_decoder_sample_rate(btstack_sbc_decoder_state_t * state){
     bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t *) state->decoder_state;
+    if (!decoder_state) return 0;
     return decoder_state->decoder_context.common.frameInfo.frequency;
 }
 
@@ -156,18 +182,35 @@ void OI_AssertFail(const char* file, int line, const char* reason){
 }
 #endif
 
+static bludroid_decoder_state_t * btstack_sbc_decoder_get_instance(btstack_sbc_decoder_state_t * state){
+    int i;
+    // re-use instance on re-init
+    for (i=0;i<MAX_NR_SBC_DECODERS;i++){
+        if (bd_decoder_states[i].owner == state) return &bd_decoder_states[i];
+    }
+    for (i=0;i<MAX_NR_SBC_DECODERS;i++){
+        if (bd_decoder_states[i].owner == NULL) return &bd_decoder_states[i];
+    }
+    return NULL;
+}
+
 void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_mode_t mode, void (*callback)(int16_t * data, int num_samples, int num_channels, int sample_rate, void * context), void * context){
-    if (sbc_decoder_state_singleton && sbc_decoder_state_singleton != state ){
-        log_error("SBC decoder: different sbc decoder state is allready registered");
-    } 
+    bludroid_decoder_state_t * decoder_state = btstack_sbc_decoder_get_instance(state);
+    if (!decoder_state){
+        // don't take over instance of other stream, data is dropped
+        log_error("SBC decoder: no free decoder instance, see MAX_NR_SBC_DECODERS");
+        memset(state, 0, sizeof(btstack_sbc_decoder_state_t));
+        return;
+    }
+
     OI_STATUS status = OI_STATUS_SUCCESS;
     switch (mode){
         case SBC_MODE_STANDARD:
             // note: we always request stereo output, even for mono input
-            status = OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE);
+            status = OI_CODEC_SBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data), 2, 2, FALSE);
             break;
         case SBC_MODE_mSBC:
-            status = OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data));
+            status = OI_CODEC_mSBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data));
             break;
         default:
             break;
@@ -177,26 +220,57 @@ void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t * state, btstack_sbc_m
         log_error("SBC decoder: error during reset %d\n", status);
     }
     
-    sbc_decoder_state_singleton = state;
-    
-    bd_decoder_state.bytes_in_frame_buffer = 0;
-    bd_decoder_state.pcm_bytes = sizeof(bd_decoder_state.pcm_data);
-    bd_decoder_state.h2_sequence_nr = -1;
-    bd_decoder_state.sync_word_found = 0;
-    bd_decoder_state.search_new_sync_word = 0;
+    decoder_state->owner = state;
+    decoder_state->bytes_in_frame_buffer = 0;
+    decoder_state->pcm_bytes = sizeof(decoder_state->pcm_data);
+    decoder_state->h2_sequence_nr = -1;
+    decoder_state->sync_word_found = 0;
+    decoder_state->search_new_sync_word = 0;
     if (mode == SBC_MODE_mSBC){
-        bd_decoder_state.search_new_sync_word = 1;
+        decoder_state->search_new_sync_word = 1;
     }
-    bd_decoder_state.first_good_frame_found = 0;
+    decoder_state->first_good_frame_found = 0;
+    decoder_state->pcm_output = NULL;
+    decoder_state->plc_enabled = plc_enabled;
+    decoder_state->corrupt_frame_period = corrupt_frame_period;
+    decoder_state->corrupt_frame_count = 0;
 
     memset(state, 0, sizeof(btstack_sbc_decoder_state_t));
     state->handle_pcm_data = callback;
     state->mode = mode;
     state->context = context;
-    state->decoder_state = &bd_decoder_state;
+    state->decoder_state = decoder_state;
     btstack_sbc_plc_init(&state->plc_state);
 }
 
+void btstack_sbc_decoder_deinit(btstack_sbc_decoder_state_t * state){
+    bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t *) state->decoder_state;
+    if (decoder_state && decoder_state->owner == state){
+        decoder_state->owner = NULL;
+    }
+    state->decoder_state = NULL;
+}
+
+static void btstack_sbc_decoder_deliver_pcm_data(btstack_sbc_decoder_state_t * state, int16_t * data){
+    bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t *) state->decoder_state;
+    int num_samples  = btstack_sbc_decoder_num_samples_per_frame(state);
+    int num_channels = btstack_sbc_decoder_num_channels(state);
+
+    if (decoder_state->pcm_output == NULL){
+        state->handle_pcm_data(data, num_samples, num_channels, btstack_sbc_decoder_sample_rate(state), state->context);
+        return;
+    }
+
+    // batch mode: append to caller provided buffer
+    int num_values = num_samples * num_channels;
+    if (decoder_state->pcm_output_len + num_values > decoder_state->pcm_output_size){
+        log_error("SBC decoder: PCM buffer too small, dropping frame");
+        return;
+    }
+    memcpy(&decoder_state->pcm_output[decoder_state->pcm_output_len], data, num_values * sizeof(int16_t));
+    decoder_state->pcm_output_len += num_values;
+}
+
 static void append_received_sbc_data(bludroid_decoder_state_t * state, uint8_t * buffer, int size){
     int numFreeBytes = sizeof(state->frame_buffer) - state->bytes_in_frame_buffer;
 
@@ -214,6 +288,24 @@ static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * s
     int input_bytes_to_process = size;
     int keep_decoding = 1; 
 
+    // decode complete frames directly from input as long as no partial frame is buffered
+    while (decoder_state->bytes_in_frame_buffer == 0 && input_bytes_to_process > 0 && decoder_state->corrupt_frame_period <= 0){
+        const OI_BYTE *frame_data = buffer;
+        OI_UINT32 frame_data_len = input_bytes_to_process;
+        OI_STATUS status = OI_CODEC_SBC_DecodeFrame(&(decoder_state->decoder_context), 
+                                                    &frame_data, 
+                                                    &frame_data_len,
+                                                    decoder_state->pcm_plc_data, 
+                                                    &(decoder_state->pcm_bytes));
+        // let buffered decoding below deal with partial frames and errors
+        if (status != OI_STATUS_SUCCESS && status != OI_CODEC_SBC_PARTIAL_DECODE) break;
+        btstack_sbc_decoder_deliver_pcm_data(state, decoder_state->pcm_plc_data);
+        state->good_frames_nr++;
+        int bytes_processed = input_bytes_to_process - frame_data_len;
+        buffer += bytes_processed;
+        input_bytes_to_process -= bytes_processed;
+    }
+
     while (keep_decoding) {
         // Fill decoder_state->frame_buffer as much as possible.
         int bytes_free_in_frame_buffer = SBC_MAX_FRAME_LEN - decoder_state->bytes_in_frame_buffer;
@@ -235,13 +327,12 @@ static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * s
                                                     &(decoder_state->pcm_bytes));
         uint16_t bytes_processed = bytes_in_frame_buffer_before_decoding - frame_data_len;
     
-        static int frame_count = 0;
-        if (corrupt_frame_period > 0){
-            frame_count++;
+        if (decoder_state->corrupt_frame_period > 0){
+            decoder_state->corrupt_frame_count++;
 
-            if (frame_count % corrupt_frame_period == 0){
+            if (decoder_state->corrupt_frame_count % decoder_state->corrupt_frame_period == 0){
                 *(uint8_t*)&frame_data[5] = 0;
-                frame_count = 0;
+                decoder_state->corrupt_frame_count = 0;
             }
         }
 
@@ -249,10 +340,7 @@ static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * s
         switch(status){
             case OI_STATUS_SUCCESS:
             case OI_CODEC_SBC_PARTIAL_DECODE:
-                state->handle_pcm_data(decoder_state->pcm_plc_data, 
-                                       btstack_sbc_decoder_num_samples_per_frame(state), 
-                                       btstack_sbc_decoder_num_channels(state), 
-                                       btstack_sbc_decoder_sample_rate(state), state->context);
+                btstack_sbc_decoder_deliver_pcm_data(state, decoder_state->pcm_plc_data);
                 state->good_frames_nr++;
                 break;
                 
@@ -295,7 +383,7 @@ static void btstack_sbc_decoder_process_sbc_data(btstack_sbc_decoder_state_t * s
                 // The codec apparently does not recover from this.
                 // Re-initialize the codec.
                 log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_SBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
+                if (OI_CODEC_SBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data), 2, 2, FALSE) != OI_STATUS_SUCCESS){
                     log_info("SBC decode: resetting codec failed");
                     
                 }
@@ -349,13 +437,12 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
         uint16_t bytes_processed = 0;
         const OI_BYTE *frame_data = decoder_state->frame_buffer;
 
-        static int frame_count = 0;
-        if (corrupt_frame_period > 0){
-           frame_count++;
+        if (decoder_state->corrupt_frame_period > 0){
+            decoder_state->corrupt_frame_count++;
 
-            if (frame_count % corrupt_frame_period == 0){
+            if (decoder_state->corrupt_frame_count % decoder_state->corrupt_frame_period == 0){
                 *(uint8_t*)&frame_data[5] = 0;
-                frame_count = 0;
+                decoder_state->corrupt_frame_count = 0;
             }
         }
 
@@ -397,10 +484,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 decoder_state->sync_word_found = 0;
             
                 btstack_sbc_plc_good_frame(&state->plc_state, decoder_state->pcm_plc_data, decoder_state->pcm_data);
-                state->handle_pcm_data(decoder_state->pcm_data, 
-                                    btstack_sbc_decoder_num_samples_per_frame(state), 
-                                    btstack_sbc_decoder_num_channels(state), 
-                                    btstack_sbc_decoder_sample_rate(state), state->context);
+                btstack_sbc_decoder_deliver_pcm_data(state, decoder_state->pcm_data);
                 state->good_frames_nr++;
                 continue;
             case OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA:
@@ -437,7 +521,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 }
                 if (decoder_state->h2_sequence_nr == 3) printf("\n");
 #endif
-                if (!plc_enabled) break;
+                if (!decoder_state->plc_enabled) break;
                 
                 frame_data = btstack_sbc_plc_zero_signal_frame();
                 status = OI_CODEC_SBC_DecodeFrame(&(decoder_state->decoder_context), 
@@ -450,10 +534,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                     log_error("SBC decoder: error %d\n", status);
                 } 
                 btstack_sbc_plc_bad_frame(&state->plc_state, decoder_state->pcm_plc_data, decoder_state->pcm_data);
-                state->handle_pcm_data(decoder_state->pcm_data, 
-                                    btstack_sbc_decoder_num_samples_per_frame(state), 
-                                    btstack_sbc_decoder_num_channels(state), 
-                                    btstack_sbc_decoder_sample_rate(state), state->context);
+                btstack_sbc_decoder_deliver_pcm_data(state, decoder_state->pcm_data);
 
                 
                 break;
@@ -462,7 +543,7 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
                 // The codec apparently does not recover from this.
                 // Re-initialize the codec.
                 log_info("SBC decode: invalid parameters: resetting codec");
-                if (OI_CODEC_mSBC_DecoderReset(&(bd_decoder_state.decoder_context), bd_decoder_state.decoder_data, sizeof(bd_decoder_state.decoder_data)) != OI_STATUS_SUCCESS){
+                if (OI_CODEC_mSBC_DecoderReset(&(decoder_state->decoder_context), decoder_state->decoder_data, sizeof(decoder_state->decoder_data)) != OI_STATUS_SUCCESS){
                     log_info("SBC decode: resetting codec failed");
                     
                 }
@@ -477,9 +558,26 @@ static void btstack_sbc_decoder_process_msbc_data(btstack_sbc_decoder_state_t *
 }
 
 void btstack_sbc_decoder_process_data(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size){
+    // not initialized or no decoder instance available
+    if (!state->decoder_state) return;
     if (state->mode == SBC_MODE_mSBC){
         btstack_sbc_decoder_process_msbc_data(state, packet_status_flag, buffer, size);
     } else {
         btstack_sbc_decoder_process_sbc_data(state, buffer, size);
     }
 }
+
+int btstack_sbc_decoder_process_data_to_buffer(btstack_sbc_decoder_state_t * state, int packet_status_flag, uint8_t * buffer, int size, int16_t * pcm_buffer, int pcm_buffer_size){
+    bludroid_decoder_state_t * decoder_state = (bludroid_decoder_state_t*)state->decoder_state;
+    if (!decoder_state) return 0;
+    decoder_state->pcm_output = pcm_buffer;
+    decoder_state->pcm_output_size = pcm_buffer_size;
+    decoder_state->pcm_output_len = 0;
+
+    btstack_sbc_decoder_process_data(state, packet_status_flag, buffer, size);
+
+    decoder_state->pcm_output = NULL;
+    int num_channels = btstack_sbc_decoder_num_channels(state);
+    if (num_channels == 0) return 0;
+    return decoder_state->pcm_output_len / num_channels;
+}
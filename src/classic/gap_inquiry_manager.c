@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "gap_inquiry_manager.c"
+
+/*
+ * gap_inquiry_manager.c
+ *
+ * Inquiry results are merged per device: the latest RSSI, Class of Device, and clock offset
+ * are kept, name and 16-bit Service Class UUIDs are taken from EIR if available.
+ * Names are then looked up in a name cache stored in TLV. Remote name requests are only
+ * sent after the inquiry for devices without a name, strongest RSSI first. Each request
+ * uses the page scan repetition mode and clock offset from the inquiry result to speed up
+ * paging and the next request is sent as soon as the previous one completed.
+ */
+
+#include <string.h>
+
+#include "classic/gap_inquiry_manager.h"
+
+#include "ad_parser.h"
+#include "bluetooth_data_types.h"
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_tlv.h"
+#include "btstack_util.h"
+#include "gap.h"
+#include "hci.h"
+
+typedef enum {
+    GAP_INQUIRY_MANAGER_IDLE,
+    GAP_INQUIRY_MANAGER_INQUIRY,
+    GAP_INQUIRY_MANAGER_REMOTE_NAMES,
+} gap_inquiry_manager_state_t;
+
+typedef struct {
+    uint32_t  seq_nr;    // used for "least recently stored" eviction strategy, 0 = unused
+    bd_addr_t address;
+    uint8_t   name_len;
+    char      name[GAP_INQUIRY_MANAGER_MAX_NAME_LEN];
+} gap_inquiry_manager_name_cache_item_t;
+
+static gap_inquiry_manager_device_t * gap_im_devices;
+static uint16_t gap_im_max_devices;
+static uint16_t gap_im_num_devices;
+static gap_inquiry_manager_state_t gap_im_state;
+static int      gap_im_remote_name_active;
+static btstack_packet_handler_t gap_im_packet_handler;
+static btstack_packet_callback_registration_t gap_im_hci_event_callback_registration;
+
+static gap_inquiry_manager_name_cache_item_t gap_im_name_cache[NVM_NUM_GAP_NAME_CACHE_ENTRIES];
+static uint32_t gap_im_name_cache_highest_seq_nr;
+static int      gap_im_name_cache_loaded;
+
+static const char gap_im_name_cache_tag_0 = 'G';
+static const char gap_im_name_cache_tag_1 = 'N';
+static const char gap_im_name_cache_tag_2 = 'C';
+
+// MARK: Name Cache
+
+static uint32_t gap_im_name_cache_tag_for_index(int index){
+    return (gap_im_name_cache_tag_0 << 24) | (gap_im_name_cache_tag_1 << 16) | (gap_im_name_cache_tag_2 << 8) | index;
+}
+
+// read all entries from TLV once, all lookups are served from RAM afterwards
+static void gap_im_name_cache_load(void){
+    if (gap_im_name_cache_loaded) return;
+    gap_im_name_cache_loaded = 1;
+
+    memset(gap_im_name_cache, 0, sizeof(gap_im_name_cache));
+    gap_im_name_cache_highest_seq_nr = 0;
+
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+
+    int index;
+    for (index=0;index<NVM_NUM_GAP_NAME_CACHE_ENTRIES;index++){
+        gap_inquiry_manager_name_cache_item_t * item = &gap_im_name_cache[index];
+        uint32_t tag = gap_im_name_cache_tag_for_index(index);
+        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) item, sizeof(gap_inquiry_manager_name_cache_item_t));
+        if (len != sizeof(gap_inquiry_manager_name_cache_item_t) || item->name_len > GAP_INQUIRY_MANAGER_MAX_NAME_LEN){
+            item->seq_nr = 0;
+            continue;
+        }
+        if (item->seq_nr > gap_im_name_cache_highest_seq_nr){
+            gap_im_name_cache_highest_seq_nr = item->seq_nr;
+        }
+    }
+}
+
+static void gap_im_name_cache_persist(int index){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    uint32_t tag = gap_im_name_cache_tag_for_index(index);
+    if (gap_im_name_cache[index].seq_nr == 0){
+        tlv_impl->delete_tag(tlv_context, tag);
+    } else {
+        tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &gap_im_name_cache[index], sizeof(gap_inquiry_manager_name_cache_item_t));
+    }
+}
+
+static int gap_im_name_cache_index_for_address(const uint8_t * address){
+    int index;
+    for (index=0;index<NVM_NUM_GAP_NAME_CACHE_ENTRIES;index++){
+        gap_inquiry_manager_name_cache_item_t * item = &gap_im_name_cache[index];
+        if (item->seq_nr == 0) continue;
+        if (memcmp(item->address, address, 6) != 0) continue;
+        return index;
+    }
+    return -1;
+}
+
+uint8_t gap_inquiry_manager_name_cache_get(bd_addr_t address, char * name){
+    gap_im_name_cache_load();
+    int index = gap_im_name_cache_index_for_address(address);
+    if (index < 0) return 0;
+    gap_inquiry_manager_name_cache_item_t * item = &gap_im_name_cache[index];
+    memcpy(name, item->name, item->name_len);
+    name[item->name_len] = 0;
+    return item->name_len;
+}
+
+void gap_inquiry_manager_name_cache_store(bd_addr_t address, const char * name, uint8_t name_len){
+    gap_im_name_cache_load();
+    name_len = btstack_min(name_len, GAP_INQUIRY_MANAGER_MAX_NAME_LEN);
+
+    // update existing entry, use empty one, or evict least recently stored one
+    int index = gap_im_name_cache_index_for_address(address);
+    if (index < 0){
+        int i;
+        uint32_t lowest_seq_nr = 0;
+        for (i=0;i<NVM_NUM_GAP_NAME_CACHE_ENTRIES;i++){
+            uint32_t seq_nr = gap_im_name_cache[i].seq_nr;
+            if (index < 0 || seq_nr < lowest_seq_nr){
+                index = i;
+                lowest_seq_nr = seq_nr;
+            }
+            if (seq_nr == 0) break;
+        }
+    } else if (gap_im_name_cache[index].name_len == name_len && memcmp(gap_im_name_cache[index].name, name, name_len) == 0){
+        // unchanged
+        return;
+    }
+
+    log_info("GAP Name Cache: store %s at index %u", bd_addr_to_str(address), index);
+    gap_inquiry_manager_name_cache_item_t * item = &gap_im_name_cache[index];
+    memset(item, 0, sizeof(gap_inquiry_manager_name_cache_item_t));
+    item->seq_nr = ++gap_im_name_cache_highest_seq_nr;
+    memcpy(item->address, address, 6);
+    item->name_len = name_len;
+    memcpy(item->name, name, name_len);
+    gap_im_name_cache_persist(index);
+}
+
+void gap_inquiry_manager_name_cache_invalidate(bd_addr_t address){
+    gap_im_name_cache_load();
+    int index = gap_im_name_cache_index_for_address(address);
+    if (index < 0) return;
+    gap_im_name_cache[index].seq_nr = 0;
+    gap_im_name_cache_persist(index);
+}
+
+// MARK: Devices
+
+static void gap_im_emit_device(uint16_t index){
+    if (!gap_im_packet_handler) return;
+    gap_inquiry_manager_device_t * device = &gap_im_devices[index];
+    uint8_t event[11];
+    event[0] = GAP_EVENT_INQUIRY_MANAGER_DEVICE;
+    event[1] = sizeof(event) - 2;
+    reverse_bd_addr(device->address, &event[2]);
+    little_endian_store_16(event, 8, index);
+    event[10] = device->name_state;
+    (*gap_im_packet_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void gap_im_emit_complete(uint8_t status){
+    if (!gap_im_packet_handler) return;
+    uint8_t event[5];
+    event[0] = GAP_EVENT_INQUIRY_MANAGER_COMPLETE;
+    event[1] = sizeof(event) - 2;
+    event[2] = status;
+    little_endian_store_16(event, 3, gap_im_num_devices);
+    (*gap_im_packet_handler)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static int gap_im_index_for_address(const uint8_t * address){
+    int i;
+    for (i=0;i<gap_im_num_devices;i++){
+        // compare last byte first
+        if (gap_im_devices[i].address[5] != address[5]) continue;
+        if (memcmp(gap_im_devices[i].address, address, 6) != 0) continue;
+        return i;
+    }
+    return -1;
+}
+
+static void gap_im_set_name(gap_inquiry_manager_device_t * device, const uint8_t * name, int name_len, gap_inquiry_manager_name_state_t name_state){
+    name_len = btstack_min(name_len, GAP_INQUIRY_MANAGER_MAX_NAME_LEN);
+    memcpy(device->name, name, name_len);
+    device->name[name_len] = 0;
+    device->name_len  = name_len;
+    device->name_state = name_state;
+}
+
+static void gap_im_parse_eir(gap_inquiry_manager_device_t * device, const uint8_t * eir_data, uint8_t eir_len, int * name_found){
+    ad_context_t context;
+    const uint8_t * name = NULL;
+    uint8_t name_len = 0;
+    int name_complete = 0;
+    for (ad_iterator_init(&context, eir_len, eir_data) ; ad_iterator_has_more(&context) ; ad_iterator_next(&context)){
+        uint8_t data_type    = ad_iterator_get_data_type(&context);
+        uint8_t data_size    = ad_iterator_get_data_len(&context);
+        const uint8_t * data = ad_iterator_get_data(&context);
+        int i;
+        switch (data_type){
+            case BLUETOOTH_DATA_TYPE_SHORTENED_LOCAL_NAME:
+                // Prefer Complete Local Name over Shortend Local Name
+                if (name) break;
+                name = data;
+                name_len = data_size;
+                break;
+            case BLUETOOTH_DATA_TYPE_COMPLETE_LOCAL_NAME:
+                name = data;
+                name_len = data_size;
+                name_complete = 1;
+                break;
+            case BLUETOOTH_DATA_TYPE_INCOMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
+            case BLUETOOTH_DATA_TYPE_COMPLETE_LIST_OF_16_BIT_SERVICE_CLASS_UUIDS:
+                device->num_uuid16 = 0;
+                for (i=0; (i+2) <= data_size && device->num_uuid16 < GAP_INQUIRY_MANAGER_MAX_UUID16; i+=2){
+                    device->uuid16[device->num_uuid16++] = little_endian_read_16(data, i);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (!name) return;
+    gap_im_set_name(device, name, name_len, GAP_INQUIRY_MANAGER_NAME_FROM_EIR);
+    *name_found = 1;
+    // shortened names are not cached, a remote name request would provide the complete one
+    if (name_complete){
+        gap_inquiry_manager_name_cache_store(device->address, device->name, device->name_len);
+    }
+}
+
+static void gap_im_handle_inquiry_result(uint8_t * packet){
+    int event_type = hci_event_packet_get_type(packet);
+    int num_reserved_fields = event_type == HCI_EVENT_INQUIRY_RESULT ? 2 : 1;    // 2 for old event, 1 otherwise
+    int num_responses       = hci_event_inquiry_result_get_num_responses(packet);
+    int i;
+    for (i=0; i<num_responses;i++){
+        bd_addr_t address;
+        reverse_bd_addr(&packet[3 + i*6], address);
+
+        // merge with previous results
+        int index = gap_im_index_for_address(address);
+        int new_device = index < 0;
+        if (new_device){
+            if (gap_im_num_devices >= gap_im_max_devices) continue;
+            index = gap_im_num_devices++;
+            memset(&gap_im_devices[index], 0, sizeof(gap_inquiry_manager_device_t));
+            memcpy(gap_im_devices[index].address, address, 6);
+            gap_im_devices[index].name_state = GAP_INQUIRY_MANAGER_NAME_PENDING;
+        }
+        gap_inquiry_manager_device_t * device = &gap_im_devices[index];
+        int name_known = device->name_state != GAP_INQUIRY_MANAGER_NAME_PENDING;
+
+        device->page_scan_repetition_mode = packet[3 + num_responses*(6)                           + i*1];
+        device->class_of_device = little_endian_read_24(packet, 3 + num_responses*(6+1+num_reserved_fields)   + i*3);
+        device->clock_offset    = little_endian_read_16(packet, 3 + num_responses*(6+1+num_reserved_fields+3) + i*2);
+        if (event_type != HCI_EVENT_INQUIRY_RESULT){
+            device->rssi_available = 1;
+            device->rssi = (int8_t) packet[3 + num_responses*(6+1+num_reserved_fields+3+2) + i*1];
+        }
+
+        int name_found = 0;
+        if (event_type == HCI_EVENT_EXTENDED_INQUIRY_RESPONSE && device->name_state != GAP_INQUIRY_MANAGER_NAME_FROM_EIR){
+            // for EIR packets, there is only one response in it, EIR data is 240 bytes
+            gap_im_parse_eir(device, &packet[3 + (6+1+num_reserved_fields+3+2+1)], 240, &name_found);
+        }
+
+        if (new_device && !name_found){
+            char name[GAP_INQUIRY_MANAGER_MAX_NAME_LEN + 1];
+            uint8_t name_len = gap_inquiry_manager_name_cache_get(address, name);
+            if (name_len){
+                gap_im_set_name(device, (const uint8_t *) name, name_len, GAP_INQUIRY_MANAGER_NAME_FROM_CACHE);
+            }
+        }
+
+        // report new devices and devices whose name became known
+        if (new_device || (name_found && !name_known)){
+            gap_im_emit_device(index);
+        }
+    }
+}
+
+// returns index of device with pending name and strongest RSSI, or -1
+static int gap_im_next_remote_name_request(void){
+    int i;
+    int index = -1;
+    for (i=0;i<gap_im_num_devices;i++){
+        gap_inquiry_manager_device_t * device = &gap_im_devices[i];
+        if (device->name_state != GAP_INQUIRY_MANAGER_NAME_PENDING) continue;
+        if (index < 0 || (device->rssi_available && device->rssi > gap_im_devices[index].rssi)){
+            index = i;
+        }
+    }
+    return index;
+}
+
+static void gap_im_run(void){
+    if (gap_im_state != GAP_INQUIRY_MANAGER_REMOTE_NAMES) return;
+    if (gap_im_remote_name_active) return;
+
+    int index = gap_im_next_remote_name_request();
+    if (index < 0){
+        gap_im_state = GAP_INQUIRY_MANAGER_IDLE;
+        gap_im_emit_complete(ERROR_CODE_SUCCESS);
+        return;
+    }
+
+    gap_inquiry_manager_device_t * device = &gap_im_devices[index];
+    // fails if another remote name request is active, retried on its completion
+    if (gap_remote_name_request(device->address, device->page_scan_repetition_mode, device->clock_offset | 0x8000) != 0) return;
+    log_info("GAP Inquiry Manager: remote name request for %s", bd_addr_to_str(device->address));
+    device->name_state = GAP_INQUIRY_MANAGER_NAME_REQUESTED;
+    gap_im_remote_name_active = 1;
+}
+
+static void gap_im_handle_remote_name_request_complete(uint8_t * packet){
+    bd_addr_t address;
+    hci_event_remote_name_request_complete_get_bd_addr(packet, address);
+    int index = gap_im_index_for_address(address);
+    if (index < 0) return;
+    gap_inquiry_manager_device_t * device = &gap_im_devices[index];
+    if (device->name_state != GAP_INQUIRY_MANAGER_NAME_REQUESTED) return;
+    gap_im_remote_name_active = 0;
+
+    uint8_t status = hci_event_remote_name_request_complete_get_status(packet);
+    if (status != ERROR_CODE_SUCCESS){
+        log_info("GAP Inquiry Manager: remote name request for %s failed, status 0x%02x", bd_addr_to_str(address), status);
+        device->name_state = GAP_INQUIRY_MANAGER_NAME_FAILED;
+    } else {
+        const uint8_t * name = (const uint8_t *) hci_event_remote_name_request_complete_get_remote_name(packet);
+        int name_len = 0;
+        while (name_len < DEVICE_NAME_LEN && name[name_len]) name_len++;
+        gap_im_set_name(device, name, name_len, GAP_INQUIRY_MANAGER_NAME_FROM_REMOTE_NAME_REQUEST);
+        gap_inquiry_manager_name_cache_store(device->address, device->name, device->name_len);
+    }
+    gap_im_emit_device(index);
+}
+
+static void gap_im_packet_handler_hci(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    UNUSED(channel);
+    UNUSED(size);
+
+    if (packet_type != HCI_EVENT_PACKET) return;
+    if (gap_im_state == GAP_INQUIRY_MANAGER_IDLE) return;
+
+    switch (hci_event_packet_get_type(packet)){
+        case HCI_EVENT_INQUIRY_RESULT:
+        case HCI_EVENT_INQUIRY_RESULT_WITH_RSSI:
+        case HCI_EVENT_EXTENDED_INQUIRY_RESPONSE:
+            if (gap_im_state != GAP_INQUIRY_MANAGER_INQUIRY) break;
+            gap_im_handle_inquiry_result(packet);
+            break;
+        case GAP_EVENT_INQUIRY_COMPLETE:
+            if (gap_im_state != GAP_INQUIRY_MANAGER_INQUIRY) break;
+            gap_im_state = GAP_INQUIRY_MANAGER_REMOTE_NAMES;
+            break;
+        case HCI_EVENT_REMOTE_NAME_REQUEST_COMPLETE:
+            gap_im_handle_remote_name_request_complete(packet);
+            break;
+        case BTSTACK_EVENT_STATE:
+            if (btstack_event_state_get_state(packet) != HCI_STATE_OFF) return;
+            gap_im_state = GAP_INQUIRY_MANAGER_IDLE;
+            gap_im_remote_name_active = 0;
+            return;
+        default:
+            return;
+    }
+    gap_im_run();
+}
+
+void gap_inquiry_manager_init(gap_inquiry_manager_device_t * devices, uint16_t max_devices){
+    gap_im_devices = devices;
+    gap_im_max_devices = max_devices;
+    gap_im_num_devices = 0;
+    gap_im_state = GAP_INQUIRY_MANAGER_IDLE;
+    gap_im_remote_name_active = 0;
+
+    gap_im_hci_event_callback_registration.callback = &gap_im_packet_handler_hci;
+    hci_add_event_handler(&gap_im_hci_event_callback_registration);
+}
+
+void gap_inquiry_manager_register_packet_handler(btstack_packet_handler_t handler){
+    gap_im_packet_handler = handler;
+}
+
+uint8_t gap_inquiry_manager_start(uint8_t duration_in_1280ms_units){
+    if (gap_im_state != GAP_INQUIRY_MANAGER_IDLE) return ERROR_CODE_COMMAND_DISALLOWED;
+    uint8_t status = gap_inquiry_start(duration_in_1280ms_units);
+    if (status != ERROR_CODE_SUCCESS) return status;
+    gap_im_num_devices = 0;
+    gap_im_state = GAP_INQUIRY_MANAGER_INQUIRY;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_inquiry_manager_stop(void){
+    int i;
+    switch (gap_im_state){
+        case GAP_INQUIRY_MANAGER_INQUIRY:
+            gap_inquiry_stop();
+            break;
+        case GAP_INQUIRY_MANAGER_REMOTE_NAMES:
+            break;
+        default:
+            return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    // skip pending remote name requests, an active one completes
+    for (i=0;i<gap_im_num_devices;i++){
+        if (gap_im_devices[i].name_state != GAP_INQUIRY_MANAGER_NAME_PENDING) continue;
+        gap_im_devices[i].name_state = GAP_INQUIRY_MANAGER_NAME_FAILED;
+    }
+    gap_im_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint16_t gap_inquiry_manager_get_num_devices(void){
+    return gap_im_num_devices;
+}
+
+gap_inquiry_manager_device_t * gap_inquiry_manager_get_device(uint16_t index){
+    if (index >= gap_im_num_devices) return NULL;
+    return &gap_im_devices[index];
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * gap_inquiry_manager.h
+ *
+ * Collects Classic Inquiry results per device and resolves missing names
+ */
+
+#ifndef __GAP_INQUIRY_MANAGER_H
+#define __GAP_INQUIRY_MANAGER_H
+
+#include <stdint.h>
+#include "bluetooth.h"
+#include "btstack_defines.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max name length stored per device and in the name cache, longer names are truncated
+#ifndef GAP_INQUIRY_MANAGER_MAX_NAME_LEN
+#define GAP_INQUIRY_MANAGER_MAX_NAME_LEN 32
+#endif
+
+// max number of 16-bit Service Class UUIDs from EIR stored per device
+#ifndef GAP_INQUIRY_MANAGER_MAX_UUID16
+#define GAP_INQUIRY_MANAGER_MAX_UUID16 8
+#endif
+
+// number of remote names stored in TLV
+#ifndef NVM_NUM_GAP_NAME_CACHE_ENTRIES
+#define NVM_NUM_GAP_NAME_CACHE_ENTRIES 8
+#endif
+
+typedef enum {
+    GAP_INQUIRY_MANAGER_NAME_PENDING = 0,       // remote name request will be sent after inquiry
+    GAP_INQUIRY_MANAGER_NAME_REQUESTED,
+    GAP_INQUIRY_MANAGER_NAME_FROM_EIR,
+    GAP_INQUIRY_MANAGER_NAME_FROM_CACHE,
+    GAP_INQUIRY_MANAGER_NAME_FROM_REMOTE_NAME_REQUEST,
+    GAP_INQUIRY_MANAGER_NAME_FAILED,
+} gap_inquiry_manager_name_state_t;
+
+// device, storage provided by application
+typedef struct {
+    bd_addr_t address;
+    uint32_t  class_of_device;
+    uint8_t   page_scan_repetition_mode;
+    uint16_t  clock_offset;
+    uint8_t   rssi_available;
+    int8_t    rssi;
+    gap_inquiry_manager_name_state_t name_state;
+    uint8_t   name_len;
+    char      name[GAP_INQUIRY_MANAGER_MAX_NAME_LEN + 1];
+    // 16-bit Service Class UUIDs from EIR
+    uint8_t   num_uuid16;
+    uint16_t  uuid16[GAP_INQUIRY_MANAGER_MAX_UUID16];
+} gap_inquiry_manager_device_t;
+
+/* API_START */
+
+/**
+ * @brief Init GAP Inquiry Manager
+ * @param devices storage for discovered devices
+ * @param max_devices
+ */
+void gap_inquiry_manager_init(gap_inquiry_manager_device_t * devices, uint16_t max_devices);
+
+/**
+ * @brief Register packet handler for events:
+ *        - GAP_EVENT_INQUIRY_MANAGER_DEVICE: device found or its name became known
+ *        - GAP_EVENT_INQUIRY_MANAGER_COMPLETE: inquiry and all remote name requests done
+ * @param handler
+ */
+void gap_inquiry_manager_register_packet_handler(btstack_packet_handler_t handler);
+
+/**
+ * @brief Start inquiry. Results of a previous inquiry are discarded.
+ * @note Inquiry mode should be set to INQUIRY_MODE_RSSI_AND_EIR via hci_set_inquiry_mode to get names and UUIDs from EIR
+ * @param duration_in_1280ms_units
+ * @returns 0 if ok
+ */
+uint8_t gap_inquiry_manager_start(uint8_t duration_in_1280ms_units);
+
+/**
+ * @brief Stop inquiry and skip pending remote name requests
+ * @returns 0 if ok
+ */
+uint8_t gap_inquiry_manager_stop(void);
+
+/**
+ * @brief Get number of devices found in current inquiry
+ * @returns num devices
+ */
+uint16_t gap_inquiry_manager_get_num_devices(void);
+
+/**
+ * @brief Get device by index
+ * @param index
+ * @returns device or NULL
+ */
+gap_inquiry_manager_device_t * gap_inquiry_manager_get_device(uint16_t index);
+
+/**
+ * @brief Get remote name from name cache
+ * @param address
+ * @param name buffer of size GAP_INQUIRY_MANAGER_MAX_NAME_LEN + 1, zero terminated
+ * @returns name len, 0 if not found
+ */
+uint8_t gap_inquiry_manager_name_cache_get(bd_addr_t address, char * name);
+
+/**
+ * @brief Store remote name in name cache, e.g. after a remote name request by the application
+ * @param address
+ * @param name
+ * @param name_len
+ */
+void gap_inquiry_manager_name_cache_store(bd_addr_t address, const char * name, uint8_t name_len);
+
+/**
+ * @brief Remove remote name from name cache
+ * @param address
+ */
+void gap_inquiry_manager_name_cache_invalidate(bd_addr_t address);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __GAP_INQUIRY_MANAGER_H
@@ -52,6 +52,7 @@
 #include "btstack_memory.h"
 #include "btstack_run_loop.h"
 #include "classic/core.h"
+#include "classic/sdp_client.h"
 #include "classic/sdp_client_rfcomm.h"
 #include "classic/sdp_server.h"
 #include "classic/sdp_util.h"
@@ -471,14 +472,42 @@ void hfp_create_sdp_record(uint8_t * service, uint32_t service_record_handle, ui
     de_add_data(service,  DE_STRING, strlen(name), (uint8_t *) name);
 }
 
-static hfp_connection_t * connection_doing_sdp_query = NULL;
+static hfp_connection_t * get_hfp_connection_context_for_sdp_query_id(uint16_t query_id){
+    btstack_linked_list_iterator_t it;    
+    btstack_linked_list_iterator_init(&it, hfp_get_connections());
+    while (btstack_linked_list_iterator_has_next(&it)){
+        hfp_connection_t * hfp_connection = (hfp_connection_t *)btstack_linked_list_iterator_next(&it);
+        if (hfp_connection->state != HFP_W4_SDP_QUERY_COMPLETE) continue;
+        if (hfp_connection->sdp_query_id == query_id){
+            return hfp_connection;
+        }
+    }
+    return NULL;
+}
+
+static void hfp_create_rfcomm_channel(hfp_connection_t * hfp_connection){
+    btstack_packet_handler_t packet_handler;
+    switch (hfp_connection->local_role){
+        case HFP_ROLE_AG:
+            packet_handler = hfp_ag_rfcomm_packet_handler;
+            break;
+        case HFP_ROLE_HF:
+            packet_handler = hfp_hf_rfcomm_packet_handler;
+            break;
+        default:
+            log_error("Role %x", hfp_connection->local_role);
+            return;
+    }
+    hfp_connection->state = HFP_W4_RFCOMM_CONNECTED;
+    rfcomm_create_channel(packet_handler, hfp_connection->remote_addr, hfp_connection->rfcomm_channel_nr, NULL); 
+}
 
 static void handle_query_rfcomm_event(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
     UNUSED(packet_type);    // ok: handling own sdp events
-    UNUSED(channel);        // ok: no channel
     UNUSED(size);           // ok: handling own sdp events
 
-    hfp_connection_t * hfp_connection = connection_doing_sdp_query;
+    // channel = SDP query id
+    hfp_connection_t * hfp_connection = get_hfp_connection_context_for_sdp_query_id(channel);
     if (!hfp_connection) {
         log_error("handle_query_rfcomm_event, no connection");
         return;
@@ -489,23 +518,10 @@ static void handle_query_rfcomm_event(uint8_t packet_type, uint16_t channel, uin
             hfp_connection->rfcomm_channel_nr = sdp_event_query_rfcomm_service_get_rfcomm_channel(packet);
             break;
         case SDP_EVENT_QUERY_COMPLETE:
-            connection_doing_sdp_query = NULL;
+            hfp_connection->sdp_query_id = 0;
             if (hfp_connection->rfcomm_channel_nr > 0){
-                hfp_connection->state = HFP_W4_RFCOMM_CONNECTED;
                 log_info("HFP: SDP_EVENT_QUERY_COMPLETE context %p, addr %s, state %d", hfp_connection, bd_addr_to_str( hfp_connection->remote_addr),  hfp_connection->state);
-                btstack_packet_handler_t packet_handler;
-                switch (hfp_connection->local_role){
-                    case HFP_ROLE_AG:
-                        packet_handler = hfp_ag_rfcomm_packet_handler;
-                        break;
-                    case HFP_ROLE_HF:
-                        packet_handler = hfp_hf_rfcomm_packet_handler;
-                        break;
-                    default:
-                        log_error("Role %x", hfp_connection->local_role);
-                        return;
-                }
-                rfcomm_create_channel(packet_handler, hfp_connection->remote_addr, hfp_connection->rfcomm_channel_nr, NULL); 
+                hfp_create_rfcomm_channel(hfp_connection);
                 break;
             }
             hfp_connection->state = HFP_IDLE;
@@ -729,6 +745,10 @@ void hfp_handle_rfcomm_event(uint8_t packet_type, uint16_t channel, uint8_t *pac
             if (!hfp_connection || hfp_connection->state != HFP_W4_RFCOMM_CONNECTED) return;
 
             if (status) {
+#ifdef ENABLE_SDP_CLIENT_CACHE
+                // RFCOMM channel might have been taken from SDP Client Cache, query again next time
+                sdp_client_cache_invalidate(event_addr);
+#endif
                 hfp_emit_slc_connection_event(hfp_connection, status, rfcomm_event_channel_opened_get_con_handle(packet), event_addr);
                 remove_hfp_connection_context(hfp_connection);
             } else {
@@ -1423,13 +1443,27 @@ void hfp_establish_service_level_connection(bd_addr_t bd_addr, uint16_t service_
         case HFP_W4_RFCOMM_DISCONNECTED:
             hfp_connection->state = HFP_W4_RFCOMM_DISCONNECTED_AND_RESTART;
             return;
-        case HFP_IDLE:
+        case HFP_IDLE: {
             memcpy(hfp_connection->remote_addr, bd_addr, 6);
-            hfp_connection->state = HFP_W4_SDP_QUERY_COMPLETE;
-            connection_doing_sdp_query = hfp_connection;
             hfp_connection->service_uuid = service_uuid;
-            sdp_client_query_rfcomm_channel_and_name_for_uuid(&handle_query_rfcomm_event, hfp_connection->remote_addr, service_uuid);
+#ifdef ENABLE_SDP_CLIENT_CACHE
+            // skip SDP query for known devices
+            sdp_client_cache_entry_t cache_entry;
+            if (sdp_client_cache_get(bd_addr, service_uuid, &cache_entry) && cache_entry.rfcomm_channel_nr){
+                log_info("HFP: use cached RFCOMM channel %u", cache_entry.rfcomm_channel_nr);
+                hfp_connection->rfcomm_channel_nr = cache_entry.rfcomm_channel_nr;
+                hfp_create_rfcomm_channel(hfp_connection);
+                break;
+            }
+#endif
+            hfp_connection->state = HFP_W4_SDP_QUERY_COMPLETE;
+            uint8_t status = sdp_client_query_rfcomm_channel_and_name_for_uuid_with_query_id(&handle_query_rfcomm_event, hfp_connection->remote_addr, service_uuid, &hfp_connection->sdp_query_id);
+            if (status){
+                hfp_connection->state = HFP_IDLE;
+                hfp_emit_slc_connection_event(hfp_connection, status, HCI_CON_HANDLE_INVALID, hfp_connection->remote_addr);
+            }
             break;
+        }
         default:
             break;
     }
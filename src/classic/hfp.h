@@ -497,6 +497,9 @@ typedef struct hfp_connection {
     // needed for reestablishing connection - service uuid of the remote
     uint16_t service_uuid;
 
+    // SDP query for RFCOMM channel
+    uint16_t sdp_query_id;
+
     // used during service level connection establishment
     hfp_command_t command;
     hfp_parser_state_t parser_state;
@@ -46,6 +46,17 @@
 #include "l2cap.h"
 #include "btstack_event.h"
 #include "btstack_debug.h"
+#include "btstack_config.h"
+
+// number of hosts connected at the same time
+#ifndef MAX_NR_HID_DEVICE_CONNECTIONS
+#define MAX_NR_HID_DEVICE_CONNECTIONS 1
+#endif
+
+// size of input report queue per host in bytes
+#ifndef HID_DEVICE_REPORT_QUEUE_SIZE
+#define HID_DEVICE_REPORT_QUEUE_SIZE 64
+#endif
 
 // hid device state
 typedef struct hid_device {
@@ -55,10 +66,16 @@ typedef struct hid_device {
     uint16_t  control_cid;
     uint16_t  interrupt_cid;
     uint8_t   incoming;
+    hid_protocol_mode_t protocol_mode;
+    // HID_SUBEVENT_CAN_SEND_NOW requested
+    uint8_t   can_send_now_requested;
+    // queued interrupt messages: len (2), message
+    uint16_t  report_queue_len;
+    uint8_t   report_queue[HID_DEVICE_REPORT_QUEUE_SIZE];
 } hid_device_t;
 
-static hid_device_t _hid_device;
-static hid_device_t * hid_device = &_hid_device;
+static hid_device_t hid_devices[MAX_NR_HID_DEVICE_CONNECTIONS];
+static uint16_t hid_device_cid_counter;
 
 static btstack_packet_handler_t hid_callback;
 
@@ -209,7 +226,7 @@ static inline void hid_device_emit_connected_event(hid_device_t * context, uint8
     little_endian_store_16(event,pos,context->cid);
     pos+=2;
     event[pos++] = status;
-    memcpy(&event[pos], context->bd_addr, 6);
+    reverse_bd_addr(context->bd_addr, &event[pos]);
     pos += 6;
     little_endian_store_16(event,pos,context->con_handle);
     pos += 2;
@@ -246,25 +263,136 @@ static inline void hid_device_emit_can_send_now_event(hid_device_t * context){
 }
 
 
-static int hid_connected(void){
+static inline void hid_device_emit_protocol_mode_event(hid_device_t * context){
+    uint8_t event[6];
+    int pos = 0;
+    event[pos++] = HCI_EVENT_HID_META;
+    pos++;  // skip len
+    event[pos++] = HID_SUBEVENT_PROTOCOL_MODE;
+    little_endian_store_16(event,pos,context->cid);
+    pos+=2;
+    event[pos++] = context->protocol_mode;
+    event[1] = pos - 2;
+    if (pos != sizeof(event)) log_error("hid_device_emit_protocol_mode_event size %u", pos);
+    hid_callback(HCI_EVENT_PACKET, context->cid, &event[0], pos);
+}
+
+static uint16_t hid_device_get_next_cid(void){
+    hid_device_cid_counter++;
+    if (hid_device_cid_counter == 0){
+        hid_device_cid_counter = 1;
+    }
+    return hid_device_cid_counter;
+}
+
+static hid_device_t * hid_device_get_instance_for_cid(uint16_t hid_cid){
+    if (hid_cid == 0) return NULL;
+    int i;
+    for (i=0;i<MAX_NR_HID_DEVICE_CONNECTIONS;i++){
+        if (hid_devices[i].cid == hid_cid) return &hid_devices[i];
+    }
+    return NULL;
+}
+
+static hid_device_t * hid_device_get_instance_for_con_handle(hci_con_handle_t con_handle){
+    int i;
+    for (i=0;i<MAX_NR_HID_DEVICE_CONNECTIONS;i++){
+        if (hid_devices[i].cid && hid_devices[i].con_handle == con_handle) return &hid_devices[i];
+    }
+    return NULL;
+}
+
+static hid_device_t * hid_device_get_instance_for_l2cap_cid(uint16_t l2cap_cid){
+    int i;
+    for (i=0;i<MAX_NR_HID_DEVICE_CONNECTIONS;i++){
+        if (hid_devices[i].cid == 0) continue;
+        if (hid_devices[i].control_cid == l2cap_cid || hid_devices[i].interrupt_cid == l2cap_cid) return &hid_devices[i];
+    }
+    return NULL;
+}
+
+static hid_device_t * hid_device_create_instance(hci_con_handle_t con_handle, bd_addr_t bd_addr){
+    int i;
+    for (i=0;i<MAX_NR_HID_DEVICE_CONNECTIONS;i++){
+        hid_device_t * hid_device = &hid_devices[i];
+        if (hid_device->cid) continue;
+        memset(hid_device, 0, sizeof(hid_device_t));
+        hid_device->cid = hid_device_get_next_cid();
+        hid_device->con_handle = con_handle;
+        memcpy(hid_device->bd_addr, bd_addr, 6);
+        hid_device->protocol_mode = HID_PROTOCOL_MODE_REPORT;
+        return hid_device;
+    }
+    return NULL;
+}
+
+static int hid_connected(hid_device_t * hid_device){
     return hid_device->control_cid && hid_device->interrupt_cid;
 }
 
+static void hid_device_handle_control_message(hid_device_t * hid_device, const uint8_t * packet, uint16_t size){
+    if (size < 1) return;
+    uint8_t response[2];
+    hid_message_type_t message_type = (hid_message_type_t) (packet[0] >> 4);
+    switch (message_type){
+        case HID_MESSAGE_TYPE_GET_PROTOCOL:
+            response[0] = HID_MESSAGE_TYPE_DATA << 4;
+            response[1] = hid_device->protocol_mode;
+            l2cap_send(hid_device->control_cid, response, 2);
+            break;
+        case HID_MESSAGE_TYPE_SET_PROTOCOL:
+            hid_device->protocol_mode = (hid_protocol_mode_t) (packet[0] & 0x01);
+            response[0] = (HID_MESSAGE_TYPE_HANDSHAKE << 4) | HID_HANDSHAKE_PARAM_TYPE_SUCCESSFUL;
+            l2cap_send(hid_device->control_cid, response, 1);
+            hid_device_emit_protocol_mode_event(hid_device);
+            break;
+        default:
+            log_info("HID Control message type %u not handled", message_type);
+            break;
+    }
+}
+
+// send queued interrupt messages while possible
+static void hid_device_report_queue_send(hid_device_t * hid_device){
+    uint16_t pos = 0;
+    while (pos < hid_device->report_queue_len && l2cap_can_send_packet_now(hid_device->interrupt_cid)){
+        uint16_t message_len = little_endian_read_16(hid_device->report_queue, pos);
+        l2cap_send(hid_device->interrupt_cid, &hid_device->report_queue[pos + 2], message_len);
+        pos += 2 + message_len;
+    }
+    hid_device->report_queue_len -= pos;
+    memmove(&hid_device->report_queue[0], &hid_device->report_queue[pos], hid_device->report_queue_len);
+}
+
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * packet, uint16_t packet_size){
-    UNUSED(channel);
-    UNUSED(packet_size);
     int connected_before;
+    uint16_t local_cid;
+    bd_addr_t address;
+    hci_con_handle_t con_handle;
+    hid_device_t * hid_device;
     switch (packet_type){
+        case L2CAP_DATA_PACKET:
+            hid_device = hid_device_get_instance_for_l2cap_cid(channel);
+            if (!hid_device) return;
+            if (channel != hid_device->control_cid) return;
+            hid_device_handle_control_message(hid_device, packet, packet_size);
+            break;
         case HCI_EVENT_PACKET:
             switch (packet[0]){
                 case L2CAP_EVENT_INCOMING_CONNECTION:
                     switch (l2cap_event_incoming_connection_get_psm(packet)){
                         case PSM_HID_CONTROL:
                         case PSM_HID_INTERRUPT:
-                            if (hid_device->con_handle == 0 || l2cap_event_incoming_connection_get_handle(packet) == hid_device->con_handle){
-                                hid_device->con_handle = l2cap_event_incoming_connection_get_handle(packet);
+                            con_handle = l2cap_event_incoming_connection_get_handle(packet);
+                            hid_device = hid_device_get_instance_for_con_handle(con_handle);
+                            if (!hid_device){
+                                l2cap_event_incoming_connection_get_address(packet, address);
+                                hid_device = hid_device_create_instance(con_handle, address);
+                            }
+                            if (hid_device){
                                 l2cap_accept_connection(channel);
                             } else {
+                                log_info("HID no free instance, increase MAX_NR_HID_DEVICE_CONNECTIONS");
                                 l2cap_decline_connection(channel);
                             }
                             break;
@@ -274,8 +402,16 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                     }
                     break;
                 case L2CAP_EVENT_CHANNEL_OPENED:
-                    if (l2cap_event_channel_opened_get_status(packet)) return;
-                    connected_before = hid_connected();
+                    hid_device = hid_device_get_instance_for_con_handle(l2cap_event_channel_opened_get_handle(packet));
+                    if (!hid_device) return;
+                    if (l2cap_event_channel_opened_get_status(packet)){
+                        // free instance if no other channel is open
+                        if (!hid_device->control_cid && !hid_device->interrupt_cid){
+                            hid_device->cid = 0;
+                        }
+                        return;
+                    }
+                    connected_before = hid_connected(hid_device);
                     switch (l2cap_event_channel_opened_get_psm(packet)){
                         case PSM_HID_CONTROL:
                             hid_device->control_cid = l2cap_event_channel_opened_get_local_cid(packet);
@@ -288,31 +424,47 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
                         default:
                             break;
                     }
-                    if (!connected_before && hid_connected()){
+                    if (!connected_before && hid_connected(hid_device)){
                         hid_device->incoming = 1;
                         log_info("HID Connected");
                         hid_device_emit_connected_event(hid_device, 0);
                     }
                     break;
                 case L2CAP_EVENT_CHANNEL_CLOSED:
-                    connected_before = hid_connected();
-                    if (l2cap_event_channel_closed_get_local_cid(packet) == hid_device->control_cid){
+                    local_cid = l2cap_event_channel_closed_get_local_cid(packet);
+                    hid_device = hid_device_get_instance_for_l2cap_cid(local_cid);
+                    if (!hid_device) return;
+                    connected_before = hid_connected(hid_device);
+                    if (local_cid == hid_device->control_cid){
                         log_info("HID Control closed");
                         hid_device->control_cid = 0;
                     }
-                    if (l2cap_event_channel_closed_get_local_cid(packet) == hid_device->interrupt_cid){
+                    if (local_cid == hid_device->interrupt_cid){
                         log_info("HID Interrupt closed");
                         hid_device->interrupt_cid = 0;
                     }
-                    if (connected_before && !hid_connected()){
-                        hid_device->con_handle = 0;
+                    if (connected_before && !hid_connected(hid_device)){
                         log_info("HID Disconnected");
                         hid_device_emit_connection_closed_event(hid_device);
                     }
+                    if (!hid_device->control_cid && !hid_device->interrupt_cid){
+                        hid_device->cid = 0;
+                    }
                     break;
                 case L2CAP_EVENT_CAN_SEND_NOW:
-                    log_info("HID Can send now, emit event");
-                    hid_device_emit_can_send_now_event(hid_device);
+                    hid_device = hid_device_get_instance_for_l2cap_cid(l2cap_event_can_send_now_get_local_cid(packet));
+                    if (!hid_device) return;
+                    if (hid_device->interrupt_cid){
+                        hid_device_report_queue_send(hid_device);
+                    }
+                    if (hid_device->report_queue_len == 0 && hid_device->can_send_now_requested){
+                        log_info("HID Can send now, emit event");
+                        hid_device->can_send_now_requested = 0;
+                        hid_device_emit_can_send_now_event(hid_device);
+                    }
+                    if (hid_device->report_queue_len || hid_device->can_send_now_requested){
+                        l2cap_request_can_send_now_event(hid_device->interrupt_cid ? hid_device->interrupt_cid : hid_device->control_cid);
+                    }
                     break;
                 default:
                     break;
@@ -327,8 +479,7 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * pack
  * @brief Set up HID Device 
  */
 void hid_device_init(void){
-    memset(hid_device, 0, sizeof(hid_device_t));
-    hid_device->cid = 1;
+    memset(hid_devices, 0, sizeof(hid_devices));
     l2cap_register_service(packet_handler, PSM_HID_INTERRUPT, 100, LEVEL_2);
     l2cap_register_service(packet_handler, PSM_HID_CONTROL,   100, LEVEL_2);                                      
 }
@@ -346,8 +497,10 @@ void hid_device_register_packet_handler(btstack_packet_handler_t callback){
  * @param hid_cid
  */
 void hid_device_request_can_send_now_event(uint16_t hid_cid){
-    UNUSED(hid_cid);
+    hid_device_t * hid_device = hid_device_get_instance_for_cid(hid_cid);
+    if (!hid_device) return;
     if (!hid_device->control_cid) return;
+    hid_device->can_send_now_requested = 1;
     l2cap_request_can_send_now_event(hid_device->control_cid);
 }
 
@@ -356,7 +509,8 @@ void hid_device_request_can_send_now_event(uint16_t hid_cid){
  * @param hid_cid
  */
 void hid_device_send_interrupt_message(uint16_t hid_cid, const uint8_t * message, uint16_t message_len){
-    UNUSED(hid_cid);
+    hid_device_t * hid_device = hid_device_get_instance_for_cid(hid_cid);
+    if (!hid_device) return;
     if (!hid_device->interrupt_cid) return;
     l2cap_send(hid_device->interrupt_cid, (uint8_t*) message, message_len);
 }
@@ -366,8 +520,33 @@ void hid_device_send_interrupt_message(uint16_t hid_cid, const uint8_t * message
  * @param hid_cid
  */
 void hid_device_send_contro_message(uint16_t hid_cid, const uint8_t * message, uint16_t message_len){
-    UNUSED(hid_cid);
+    hid_device_t * hid_device = hid_device_get_instance_for_cid(hid_cid);
+    if (!hid_device) return;
     if (!hid_device->control_cid) return;
     l2cap_send(hid_device->control_cid, (uint8_t*) message, message_len);
 }
 
+/**
+ * @brief Queue HID message for interrupt channel
+ * @param hid_cid
+ */
+uint8_t hid_device_queue_interrupt_message(uint16_t hid_cid, const uint8_t * message, uint16_t message_len){
+    hid_device_t * hid_device = hid_device_get_instance_for_cid(hid_cid);
+    if (!hid_device || !hid_device->interrupt_cid) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if (hid_device->report_queue_len + 2 + message_len > HID_DEVICE_REPORT_QUEUE_SIZE) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    little_endian_store_16(hid_device->report_queue, hid_device->report_queue_len, message_len);
+    memcpy(&hid_device->report_queue[hid_device->report_queue_len + 2], message, message_len);
+    hid_device->report_queue_len += 2 + message_len;
+    l2cap_request_can_send_now_event(hid_device->interrupt_cid);
+    return ERROR_CODE_SUCCESS;
+}
+
+/**
+ * @brief Get protocol mode set by host
+ * @param hid_cid
+ */
+hid_protocol_mode_t hid_device_get_protocol_mode(uint16_t hid_cid){
+    hid_device_t * hid_device = hid_device_get_instance_for_cid(hid_cid);
+    if (!hid_device) return HID_PROTOCOL_MODE_REPORT;
+    return hid_device->protocol_mode;
+}
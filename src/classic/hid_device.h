@@ -37,6 +37,37 @@
 
 #include <stdint.h>
 #include "btstack_defines.h"
+
+typedef enum {
+    HID_MESSAGE_TYPE_HANDSHAKE = 0,
+    HID_MESSAGE_TYPE_HID_CONTROL,
+    HID_MESSAGE_TYPE_RESERVED_2,
+    HID_MESSAGE_TYPE_RESERVED_3,
+    HID_MESSAGE_TYPE_GET_REPORT,
+    HID_MESSAGE_TYPE_SET_REPORT,
+    HID_MESSAGE_TYPE_GET_PROTOCOL,
+    HID_MESSAGE_TYPE_SET_PROTOCOL,
+    HID_MESSAGE_TYPE_GET_IDLE_DEPRECATED,
+    HID_MESSAGE_TYPE_SET_IDLE_DEPRECATED,
+    HID_MESSAGE_TYPE_DATA,
+    HID_MESSAGE_TYPE_DATC_DEPRECATED
+} hid_message_type_t;
+
+typedef enum {
+    HID_HANDSHAKE_PARAM_TYPE_SUCCESSFUL = 0,
+    HID_HANDSHAKE_PARAM_TYPE_NOT_READY,
+    HID_HANDSHAKE_PARAM_TYPE_ERR_INVALID_REPORT_ID,
+    HID_HANDSHAKE_PARAM_TYPE_ERR_UNSUPPORTED_REQUEST,
+    HID_HANDSHAKE_PARAM_TYPE_ERR_INVALID_PARAMETER,
+    HID_HANDSHAKE_PARAM_TYPE_ERR_UNKNOWN = 0x0E,
+    HID_HANDSHAKE_PARAM_TYPE_ERR_FATAL
+} hid_handshake_param_type_t;
+
+typedef enum {
+    HID_PROTOCOL_MODE_BOOT = 0,
+    HID_PROTOCOL_MODE_REPORT
+} hid_protocol_mode_t;
+
 /**
  * @brief Create HID Device SDP service record. 
  * @param service Empty buffer in which a new service record will be stored.
@@ -94,4 +125,19 @@ void hid_device_send_interrupt_message(uint16_t hid_cid, const uint8_t * message
  */
 void hid_device_send_contro_message(uint16_t hid_cid, const uint8_t * message, uint16_t message_len);
 
+/**
+ * @brief Queue HID message for interrupt channel. Queued messages of a host are sent in a single can send now cycle
+ * @note Queue size per host is HID_DEVICE_REPORT_QUEUE_SIZE, see MAX_NR_HID_DEVICE_CONNECTIONS for number of hosts
+ * @param hid_cid
+ * @param message
+ * @param message_len
+ * @return status ERROR_CODE_SUCCESS, ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER or ERROR_CODE_MEMORY_CAPACITY_EXCEEDED if queue is full
+ */
+uint8_t hid_device_queue_interrupt_message(uint16_t hid_cid, const uint8_t * message, uint16_t message_len);
 
+/**
+ * @brief Get protocol mode set by host via SET_PROTOCOL, changes are reported with HID_SUBEVENT_PROTOCOL_MODE
+ * @param hid_cid
+ * @return protocol_mode
+ */
+hid_protocol_mode_t hid_device_get_protocol_mode(uint16_t hid_cid);
@@ -78,29 +78,15 @@
 
 static const char default_hsp_ag_service_name[] = "Audio Gateway";
 
-static bd_addr_t remote;
-static bd_addr_t sco_event_addr;
-static uint8_t channel_nr = 0;
-
-static uint16_t mtu;
-static uint16_t rfcomm_cid = 0;
-static uint16_t sco_handle = 0;
-static uint16_t rfcomm_handle = 0;
-static btstack_timer_source_t hs_timeout;
-
-static int ag_microphone_gain = -1;
-static int ag_speaker_gain = -1;
-static uint8_t ag_ring = 0;
-static uint8_t ag_send_ok = 0;
-static uint8_t ag_send_error = 0;
-static uint8_t ag_num_button_press_received = 0;
-static uint8_t ag_support_custom_commands = 0;
-static uint8_t ag_establish_sco = 0;
-static uint8_t hsp_disconnect_rfcomm = 0;
-static uint8_t hsp_establish_audio_connection = 0;
-static uint8_t hsp_release_audio_connection = 0;
+// number of headsets connected at the same time
+#ifndef MAX_NR_HSP_AG_CONNECTIONS
+#define MAX_NR_HSP_AG_CONNECTIONS 1
+#endif
 
-static btstack_packet_callback_registration_t hci_event_callback_registration;
+// number of SCO links the Controller supports at the same time
+#ifndef MAX_NR_HSP_AG_SCO_CONNECTIONS
+#define MAX_NR_HSP_AG_SCO_CONNECTIONS 1
+#endif
 
 typedef enum {
     HSP_IDLE,
@@ -125,8 +111,42 @@ typedef enum {
     HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN
 } hsp_state_t;
 
-static hsp_state_t hsp_state = HSP_IDLE;
+typedef struct {
+    hsp_state_t state;
+    bd_addr_t remote;
+    uint8_t channel_nr;
+
+    uint16_t mtu;
+    uint16_t rfcomm_cid;
+    hci_con_handle_t sco_handle;
+    hci_con_handle_t rfcomm_handle;
+    btstack_timer_source_t hs_timeout;
+
+    int ag_microphone_gain;
+    int ag_speaker_gain;
+    uint8_t ag_ring;
+    uint8_t ag_send_ok;
+    uint8_t ag_send_error;
+    uint8_t ag_num_button_press_received;
+    uint8_t ag_establish_sco;
+    uint8_t hsp_disconnect_rfcomm;
+    uint8_t hsp_establish_audio_connection;
+    uint8_t hsp_release_audio_connection;
+} hsp_ag_connection_t;
+
+static hsp_ag_connection_t hsp_ag_connections[MAX_NR_HSP_AG_CONNECTIONS];
+
+// SCO scheduler: only a single synchronous connection setup at a time
+static hsp_ag_connection_t * hsp_ag_sco_setup_connection;
+// SDP client: only a single RFCOMM channel query at a time
+static hsp_ag_connection_t * hsp_ag_sdp_query_connection;
+// incoming SCO connection request from HSP Headset without free SCO link
+static uint8_t   hsp_ag_sco_reject_pending;
+static bd_addr_t hsp_ag_sco_reject_addr;
+
+static uint8_t ag_support_custom_commands = 0;
 
+static btstack_packet_callback_registration_t hci_event_callback_registration;
 
 static btstack_packet_handler_t hsp_ag_callback;
 
@@ -148,27 +168,150 @@ void hsp_ag_register_packet_handler(btstack_packet_handler_t callback){
     hsp_ag_callback = callback;
 }
 
-static void emit_event(uint8_t event_subtype, uint8_t value){
+static void emit_event(hsp_ag_connection_t * connection, uint8_t event_subtype, uint8_t value){
     if (!hsp_ag_callback) return;
-    uint8_t event[4];
+    uint8_t event[6];
     event[0] = HCI_EVENT_HSP_META;
     event[1] = sizeof(event) - 2;
     event[2] = event_subtype;
     event[3] = value; // status 0 == OK
+    little_endian_store_16(event, 4, connection->rfcomm_handle);
     (*hsp_ag_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
-static void emit_event_audio_connected(uint8_t status, uint16_t handle){
+static void emit_event_rfcomm_connected(hsp_ag_connection_t * connection, uint8_t status){
     if (!hsp_ag_callback) return;
-    uint8_t event[6];
+    uint8_t event[12];
+    event[0] = HCI_EVENT_HSP_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE;
+    event[3] = status;
+    little_endian_store_16(event, 4, connection->rfcomm_handle);
+    reverse_bd_addr(connection->remote, &event[6]);
+    (*hsp_ag_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void emit_event_audio_connected(hsp_ag_connection_t * connection, uint8_t status, uint16_t handle){
+    if (!hsp_ag_callback) return;
+    uint8_t event[8];
     event[0] = HCI_EVENT_HSP_META;
     event[1] = sizeof(event) - 2;
     event[2] = HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE;
     event[3] = status;
     little_endian_store_16(event, 4, handle);
+    little_endian_store_16(event, 6, connection->rfcomm_handle);
     (*hsp_ag_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
+static hsp_ag_connection_t * hsp_ag_connection_for_acl_handle(hci_con_handle_t acl_handle){
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].state == HSP_IDLE) continue;
+        if (hsp_ag_connections[i].rfcomm_handle == acl_handle) return &hsp_ag_connections[i];
+    }
+    return NULL;
+}
+
+static hsp_ag_connection_t * hsp_ag_connection_for_sco_handle(hci_con_handle_t sco_handle){
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].state == HSP_IDLE) continue;
+        if (hsp_ag_connections[i].sco_handle == sco_handle) return &hsp_ag_connections[i];
+    }
+    return NULL;
+}
+
+static hsp_ag_connection_t * hsp_ag_connection_for_rfcomm_cid(uint16_t rfcomm_cid){
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].state == HSP_IDLE) continue;
+        if (hsp_ag_connections[i].rfcomm_cid == rfcomm_cid) return &hsp_ag_connections[i];
+    }
+    return NULL;
+}
+
+static hsp_ag_connection_t * hsp_ag_connection_for_bd_addr(bd_addr_t bd_addr){
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].state == HSP_IDLE) continue;
+        if (bd_addr_cmp(hsp_ag_connections[i].remote, bd_addr) == 0) return &hsp_ag_connections[i];
+    }
+    return NULL;
+}
+
+static void hsp_ag_reset_state(hsp_ag_connection_t * connection){
+    btstack_run_loop_remove_timer(&connection->hs_timeout);
+    if (hsp_ag_sco_setup_connection == connection){
+        hsp_ag_sco_setup_connection = NULL;
+    }
+    if (hsp_ag_sdp_query_connection == connection){
+        hsp_ag_sdp_query_connection = NULL;
+    }
+    memset(connection, 0, sizeof(hsp_ag_connection_t));
+    connection->state = HSP_IDLE;
+    connection->ag_microphone_gain = -1;
+    connection->ag_speaker_gain = -1;
+}
+
+static hsp_ag_connection_t * hsp_ag_connection_create(bd_addr_t bd_addr){
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        hsp_ag_connection_t * connection = &hsp_ag_connections[i];
+        if (connection->state != HSP_IDLE) continue;
+        hsp_ag_reset_state(connection);
+        memcpy(connection->remote, bd_addr, 6);
+        return connection;
+    }
+    return NULL;
+}
+
+// SCO scheduler
+
+static int hsp_ag_sco_num_connections(void){
+    int num_sco_connections = 0;
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].sco_handle) num_sco_connections++;
+    }
+    return num_sco_connections;
+}
+
+// SCO link can be set up or accepted if Controller has free SCO link and no other setup is in progress
+static int hsp_ag_sco_can_setup(void){
+    if (hsp_ag_sco_setup_connection) return 0;
+    return hsp_ag_sco_num_connections() < MAX_NR_HSP_AG_SCO_CONNECTIONS;
+}
+
+// send HCI Setup or Accept Synchronous Connection for connection with eSCO parameters depending on remote and other links
+static void hsp_ag_sco_setup(hsp_ag_connection_t * connection, int accept){
+    uint16_t max_latency;
+    uint8_t  retransmission_effort;
+    uint16_t packet_types;
+    
+    if (hci_remote_esco_supported(connection->rfcomm_handle)){
+        // eSCO: S4 - max latency == transmission interval = 0x000c == 12 ms, EV3 only
+        max_latency = 0x000c;
+        retransmission_effort = 0x02;
+        packet_types = 0x388;
+    } else {
+        max_latency = 0xffff;
+        retransmission_effort = 0xff;
+        // HV3 only leaves slots for other SCO links
+        packet_types = hsp_ag_sco_num_connections() ? 0x0004 : 0x003f;
+    }
+    
+    uint16_t sco_voice_setting = hci_get_sco_voice_setting();
+    hsp_ag_sco_setup_connection = connection;
+    if (accept){
+        log_info("HSP: sending hci_accept_connection_request, sco_voice_setting %02x", sco_voice_setting);
+        hci_send_cmd(&hci_accept_synchronous_connection, connection->remote, 8000, 8000, max_latency, 
+                        sco_voice_setting, retransmission_effort, packet_types);
+    } else {
+        hci_send_cmd(&hci_setup_synchronous_connection, connection->rfcomm_handle, 8000, 8000, max_latency,
+                        sco_voice_setting, retransmission_effort, packet_types);
+    }
+}
+
 void hsp_ag_create_sdp_record(uint8_t * service, uint32_t service_record_handle, int rfcomm_channel_nr, const char * name){
     uint8_t* attribute;
     de_create_sequence(service);
@@ -249,31 +392,11 @@ void hsp_ag_enable_custom_commands(int enable){
     ag_support_custom_commands = enable;
 }
 
-int hsp_ag_send_result(char * result){
+int hsp_ag_send_result(hci_con_handle_t acl_handle, char * result){
     if (!ag_support_custom_commands) return 1;
-    return hsp_ag_send_str_over_rfcomm(rfcomm_cid, result);
-}
-
-static void hsp_ag_reset_state(void){
-    hsp_state = HSP_IDLE;
-    
-    rfcomm_cid = 0;
-    rfcomm_handle = 0;
-    sco_handle = 0;
-
-    ag_send_ok = 0;
-    ag_send_error = 0;
-    ag_ring = 0;
-
-    ag_num_button_press_received = 0;
-    ag_support_custom_commands = 0;
-
-    ag_microphone_gain = -1;
-    ag_speaker_gain = -1;
-
-    hsp_disconnect_rfcomm = 0;
-    hsp_establish_audio_connection = 0;
-    hsp_release_audio_connection = 0;
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return 1;
+    return hsp_ag_send_str_over_rfcomm(connection->rfcomm_cid, result);
 }
 
 void hsp_ag_init(uint8_t rfcomm_channel_nr){
@@ -283,39 +406,51 @@ void hsp_ag_init(uint8_t rfcomm_channel_nr){
 
     rfcomm_register_service(packet_handler, rfcomm_channel_nr, 0xffff);  // reserved channel, mtu limited by l2cap
 
-    hsp_ag_reset_state();
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        hsp_ag_reset_state(&hsp_ag_connections[i]);
+    }
+    ag_support_custom_commands = 0;
 }
 
 void hsp_ag_connect(bd_addr_t bd_addr){
-    if (hsp_state != HSP_IDLE) return;
-    hsp_state = HSP_SDP_QUERY_RFCOMM_CHANNEL;
-    memcpy(remote, bd_addr, 6);
+    if (hsp_ag_connection_for_bd_addr(bd_addr)) return;
+    hsp_ag_connection_t * connection = hsp_ag_connection_create(bd_addr);
+    if (!connection){
+        log_error("HSP AG: no free connection, increase MAX_NR_HSP_AG_CONNECTIONS");
+        return;
+    }
+    connection->state = HSP_SDP_QUERY_RFCOMM_CHANNEL;
     hsp_run();
 }
 
-void hsp_ag_disconnect(void){
-    hsp_ag_release_audio_connection();
-    if (hsp_state < HSP_W4_RFCOMM_CONNECTED){
-        hsp_state = HSP_IDLE;
+void hsp_ag_disconnect(hci_con_handle_t acl_handle){
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    hsp_ag_release_audio_connection(acl_handle);
+    if (connection->state < HSP_W4_RFCOMM_CONNECTED){
+        hsp_ag_reset_state(connection);
         return;
     }
 
-    if (hsp_state == HSP_W4_RFCOMM_CONNECTED){
-        hsp_state = HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN;
+    if (connection->state == HSP_W4_RFCOMM_CONNECTED){
+        connection->state = HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN;
         return;
     }
-    hsp_disconnect_rfcomm = 1;
+    connection->hsp_disconnect_rfcomm = 1;
     hsp_run();
 }
 
-void hsp_ag_establish_audio_connection(void){
-    switch (hsp_state){
+void hsp_ag_establish_audio_connection(hci_con_handle_t acl_handle){
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    switch (connection->state){
         case HSP_RFCOMM_CONNECTION_ESTABLISHED:
-            hsp_establish_audio_connection = 1;
-            hsp_state = HSP_W4_SCO_CONNECTED;
+            connection->hsp_establish_audio_connection = 1;
+            connection->state = HSP_W4_SCO_CONNECTED;
             break;
         case HSP_W4_RFCOMM_CONNECTED:
-            hsp_state = HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN;
+            connection->state = HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN;
             break;
         default:
             break;
@@ -323,180 +458,181 @@ void hsp_ag_establish_audio_connection(void){
     hsp_run();
 }
 
-void hsp_ag_release_audio_connection(void){
-    if (hsp_state >= HSP_W2_DISCONNECT_SCO) return;
-    if (hsp_state < HSP_AUDIO_CONNECTION_ESTABLISHED) return;
+void hsp_ag_release_audio_connection(hci_con_handle_t acl_handle){
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    if (connection->state >= HSP_W2_DISCONNECT_SCO) return;
+    if (connection->state < HSP_AUDIO_CONNECTION_ESTABLISHED) return;
 
-    hsp_release_audio_connection = 1;
+    connection->hsp_release_audio_connection = 1;
     hsp_run();
 }
 
 
-void hsp_ag_set_microphone_gain(uint8_t gain){
+void hsp_ag_set_microphone_gain(hci_con_handle_t acl_handle, uint8_t gain){
     if (gain >15) {
         log_error("Gain must be in interval [0..15], it is given %d", gain);
         return; 
     }
-    ag_microphone_gain = gain;
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    connection->ag_microphone_gain = gain;
     hsp_run();
 }
 
 // AG +VGS=5  [0..15] ; HS AT+VGM=6 | AG OK
-void hsp_ag_set_speaker_gain(uint8_t gain){
+void hsp_ag_set_speaker_gain(hci_con_handle_t acl_handle, uint8_t gain){
     if (gain >15) {
         log_error("Gain must be in interval [0..15], it is given %d", gain);
         return; 
     }
-    ag_speaker_gain = gain;
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    connection->ag_speaker_gain = gain;
     hsp_run();
 }  
 
 static void hsp_ringing_timeout_handler(btstack_timer_source_t * timer){
-    ag_ring = 1;
+    hsp_ag_connection_t * connection = (hsp_ag_connection_t *) btstack_run_loop_get_timer_context(timer);
+    connection->ag_ring = 1;
     btstack_run_loop_set_timer(timer, 2000); // 2 seconds timeout
     btstack_run_loop_add_timer(timer);
     hsp_run();
 }
 
-static void hsp_ringing_timer_start(void){
-    btstack_run_loop_remove_timer(&hs_timeout);
-    btstack_run_loop_set_timer_handler(&hs_timeout, hsp_ringing_timeout_handler);
-    btstack_run_loop_set_timer(&hs_timeout, 2000); // 2 seconds timeout
-    btstack_run_loop_add_timer(&hs_timeout);
+static void hsp_ringing_timer_start(hsp_ag_connection_t * connection){
+    btstack_run_loop_remove_timer(&connection->hs_timeout);
+    btstack_run_loop_set_timer_handler(&connection->hs_timeout, hsp_ringing_timeout_handler);
+    btstack_run_loop_set_timer_context(&connection->hs_timeout, connection);
+    btstack_run_loop_set_timer(&connection->hs_timeout, 2000); // 2 seconds timeout
+    btstack_run_loop_add_timer(&connection->hs_timeout);
 }
 
-static void hsp_ringing_timer_stop(void){
-    btstack_run_loop_remove_timer(&hs_timeout);
+static void hsp_ringing_timer_stop(hsp_ag_connection_t * connection){
+    btstack_run_loop_remove_timer(&connection->hs_timeout);
 } 
 
-void hsp_ag_start_ringing(void){
-    ag_ring = 1;
-    if (hsp_state == HSP_W2_CONNECT_SCO) {
-        hsp_state = HSP_W4_RING_ANSWER;
+void hsp_ag_start_ringing(hci_con_handle_t acl_handle){
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    connection->ag_ring = 1;
+    if (connection->state == HSP_W2_CONNECT_SCO) {
+        connection->state = HSP_W4_RING_ANSWER;
     }
-    hsp_ringing_timer_start();
+    hsp_ringing_timer_start(connection);
 }
 
-void hsp_ag_stop_ringing(void){
-    ag_ring = 0;
-    if (hsp_state == HSP_W4_RING_ANSWER){
-        hsp_state = HSP_W2_CONNECT_SCO;
+void hsp_ag_stop_ringing(hci_con_handle_t acl_handle){
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_acl_handle(acl_handle);
+    if (!connection) return;
+    connection->ag_ring = 0;
+    if (connection->state == HSP_W4_RING_ANSWER){
+        connection->state = HSP_W2_CONNECT_SCO;
     }
-    hsp_ringing_timer_stop();
+    hsp_ringing_timer_stop(connection);
 }
 
-static void hsp_run(void){
-    if (ag_establish_sco && hci_can_send_command_packet_now()){
-        ag_establish_sco = 0;
-        
+static void hsp_run_for_connection(hsp_ag_connection_t * connection){
+    uint16_t rfcomm_cid = connection->rfcomm_cid;
+
+    if (connection->ag_establish_sco){
+        if (!hci_can_send_command_packet_now()) return;
+        if (!hsp_ag_sco_can_setup()) return;
+        connection->ag_establish_sco = 0;
         log_info("HSP: sending hci_accept_connection_request.");
-        // remote supported feature eSCO is set if link type is eSCO
-        // eSCO: S4 - max latency == transmission interval = 0x000c == 12 ms, 
-        uint16_t max_latency;
-        uint8_t  retransmission_effort;
-        uint16_t packet_types;
-        
-        if (hci_remote_esco_supported(rfcomm_handle)){
-            max_latency = 0x000c;
-            retransmission_effort = 0x02;
-            packet_types = 0x388;
-        } else {
-            max_latency = 0xffff;
-            retransmission_effort = 0xff;
-            packet_types = 0x003f;
-        }
-        
-        uint16_t sco_voice_setting = hci_get_sco_voice_setting();
-        
-        log_info("HFP: sending hci_accept_connection_request, sco_voice_setting %02x", sco_voice_setting);
-        hci_send_cmd(&hci_accept_synchronous_connection, remote, 8000, 8000, max_latency, 
-                        sco_voice_setting, retransmission_effort, packet_types);
+        hsp_ag_sco_setup(connection, 1);
         return;
     }
 
-    if (ag_send_ok){
+    if (connection->ag_send_ok){
         if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
             rfcomm_request_can_send_now_event(rfcomm_cid);
             return;
         }
-        ag_send_ok = 0;  
+        connection->ag_send_ok = 0;  
         hsp_ag_send_str_over_rfcomm(rfcomm_cid, HSP_AG_OK);
         return;
     }
 
-    if (ag_send_error){
+    if (connection->ag_send_error){
         if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
             rfcomm_request_can_send_now_event(rfcomm_cid);
             return;
         }
-        ag_send_error = 0;
+        connection->ag_send_error = 0;
         hsp_ag_send_str_over_rfcomm(rfcomm_cid, HSP_AG_ERROR);
         return;
     }
 
-    if (ag_ring){
+    if (connection->ag_ring){
         if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
             rfcomm_request_can_send_now_event(rfcomm_cid);
             return;
         }
-        ag_ring = 0;
+        connection->ag_ring = 0;
         hsp_ag_send_str_over_rfcomm(rfcomm_cid, HSP_AG_RING);
         return;
     }
 
-    if (hsp_establish_audio_connection){
+    if (connection->hsp_establish_audio_connection){
         if (!hci_can_send_command_packet_now()) return;
-        hsp_establish_audio_connection = 0;
-        hci_send_cmd(&hci_setup_synchronous_connection, rfcomm_handle, 8000, 8000, 0xFFFF, hci_get_sco_voice_setting(), 0xFF, 0x003F);
+        if (!hsp_ag_sco_can_setup()) return;
+        connection->hsp_establish_audio_connection = 0;
+        hsp_ag_sco_setup(connection, 0);
         return;
     }
 
-    if (hsp_release_audio_connection){
-        hsp_release_audio_connection = 0;
-        gap_disconnect(sco_handle);
+    if (connection->hsp_release_audio_connection){
+        if (!hci_can_send_command_packet_now()) return;
+        connection->hsp_release_audio_connection = 0;
+        gap_disconnect(connection->sco_handle);
         return;
     }
     
-    if (hsp_disconnect_rfcomm){
-        hsp_disconnect_rfcomm = 0;
-        hsp_establish_audio_connection = 0;
+    if (connection->hsp_disconnect_rfcomm){
+        connection->hsp_disconnect_rfcomm = 0;
+        connection->hsp_establish_audio_connection = 0;
         rfcomm_disconnect(rfcomm_cid);
         return;
     }
 
-    switch (hsp_state){
+    switch (connection->state){
         case HSP_SDP_QUERY_RFCOMM_CHANNEL:
-            hsp_state = HSP_W4_SDP_EVENT_QUERY_COMPLETE;
-            log_info("Start SDP query %s, 0x%02x", bd_addr_to_str(remote), BLUETOOTH_SERVICE_CLASS_HEADSET);
-            sdp_client_query_rfcomm_channel_and_name_for_uuid(&handle_query_rfcomm_event, remote, BLUETOOTH_SERVICE_CLASS_HEADSET);
+            if (hsp_ag_sdp_query_connection) break;
+            connection->state = HSP_W4_SDP_EVENT_QUERY_COMPLETE;
+            hsp_ag_sdp_query_connection = connection;
+            log_info("Start SDP query %s, 0x%02x", bd_addr_to_str(connection->remote), BLUETOOTH_SERVICE_CLASS_HEADSET);
+            sdp_client_query_rfcomm_channel_and_name_for_uuid(&handle_query_rfcomm_event, connection->remote, BLUETOOTH_SERVICE_CLASS_HEADSET);
             break;
 
         case HSP_W4_RING_ANSWER:
-            if (!ag_num_button_press_received) break;    
+            if (!connection->ag_num_button_press_received) break;    
 
             if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
                 rfcomm_request_can_send_now_event(rfcomm_cid);
                 return;
             }
 
-            ag_send_ok = 0;
-            ag_num_button_press_received = 0;
-            hsp_state = HSP_W2_CONNECT_SCO;
+            connection->ag_send_ok = 0;
+            connection->ag_num_button_press_received = 0;
+            connection->state = HSP_W2_CONNECT_SCO;
 
             hsp_ag_send_str_over_rfcomm(rfcomm_cid, HSP_AG_OK);
             break;
         
         case HSP_W2_CONNECT_SCO:
             if (!hci_can_send_command_packet_now()) return;
-            hsp_state = HSP_W4_SCO_CONNECTED;
-            hci_send_cmd(&hci_setup_synchronous_connection, rfcomm_handle, 8000, 8000, 0xFFFF, hci_get_sco_voice_setting(), 0xFF, 0x003F);
+            if (!hsp_ag_sco_can_setup()) return;
+            connection->state = HSP_W4_SCO_CONNECTED;
+            hsp_ag_sco_setup(connection, 0);
             break;
         
         case HSP_W2_DISCONNECT_SCO:
-            ag_num_button_press_received = 0;
+            if (!hci_can_send_command_packet_now()) return;
+            connection->ag_num_button_press_received = 0;
         
-            hsp_state = HSP_W4_SCO_DISCONNECTED;
-            gap_disconnect(sco_handle);
+            connection->state = HSP_W4_SCO_DISCONNECTED;
+            gap_disconnect(connection->sco_handle);
             break;
         
         case HSP_W2_DISCONNECT_RFCOMM:
@@ -506,26 +642,26 @@ static void hsp_run(void){
         case HSP_AUDIO_CONNECTION_ESTABLISHED:
         case HSP_RFCOMM_CONNECTION_ESTABLISHED:
             
-            if (ag_microphone_gain >= 0){
+            if (connection->ag_microphone_gain >= 0){
                 if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
                     rfcomm_request_can_send_now_event(rfcomm_cid);
                     return;
                 }
-                int gain = ag_microphone_gain;
-                ag_microphone_gain = -1;
+                int gain = connection->ag_microphone_gain;
+                connection->ag_microphone_gain = -1;
                 char buffer[10];
                 sprintf(buffer, "%s=%d\r\n", HSP_MICROPHONE_GAIN, gain);
                 hsp_ag_send_str_over_rfcomm(rfcomm_cid, buffer);
                 break;
             }
 
-            if (ag_speaker_gain >= 0){
+            if (connection->ag_speaker_gain >= 0){
                 if (!rfcomm_can_send_packet_now(rfcomm_cid)) {
                     rfcomm_request_can_send_now_event(rfcomm_cid);
                     return;
                 }
-                int gain = ag_speaker_gain;
-                ag_speaker_gain = -1;
+                int gain = connection->ag_speaker_gain;
+                connection->ag_speaker_gain = -1;
                 char buffer[10];
                 sprintf(buffer, "%s=%d\r\n", HSP_SPEAKER_GAIN, gain);
                 hsp_ag_send_str_over_rfcomm(rfcomm_cid, buffer);
@@ -537,51 +673,124 @@ static void hsp_run(void){
     }
 }
 
+static void hsp_run(void){
+    if (hsp_ag_sco_reject_pending){
+        if (!hci_can_send_command_packet_now()) return;
+        hsp_ag_sco_reject_pending = 0;
+        hci_send_cmd(&hci_reject_connection_request, hsp_ag_sco_reject_addr, ERROR_CODE_CONNECTION_REJECTED_DUE_TO_LIMITED_RESOURCES);
+    }
+    int i;
+    for (i=0;i<MAX_NR_HSP_AG_CONNECTIONS;i++){
+        if (hsp_ag_connections[i].state == HSP_IDLE) continue;
+        hsp_run_for_connection(&hsp_ag_connections[i]);
+    }
+}
 
-static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
-    UNUSED(channel);    // ok: no channel for HCI_EVENT_PACKET and only single active RFCOMM channel
+static void hsp_ag_handle_rfcomm_data(hsp_ag_connection_t * connection, uint8_t *packet, uint16_t size){
+    while (size > 0 && (packet[0] == '\n' || packet[0] == '\r')){
+        size--;
+        packet++;
+    }
 
-    if (packet_type == RFCOMM_DATA_PACKET){
-        while (size > 0 && (packet[0] == '\n' || packet[0] == '\r')){
-            size--;
-            packet++;
-        }
+    if (strncmp((char *)packet, HSP_HS_BUTTON_PRESS, strlen(HSP_HS_BUTTON_PRESS)) == 0){
+        log_info("Received button press %s", HSP_HS_BUTTON_PRESS);
+        connection->ag_send_ok = 1;
+        switch (connection->state){
+            case HSP_AUDIO_CONNECTION_ESTABLISHED:
+                connection->hsp_release_audio_connection = 1;
+                break;
+            case HSP_RFCOMM_CONNECTION_ESTABLISHED:
+                connection->hsp_establish_audio_connection = 1;
+                break;
+            default:
+                break;
+        } 
+    } else if (strncmp((char *)packet, HSP_HS_MICROPHONE_GAIN, strlen(HSP_HS_MICROPHONE_GAIN)) == 0){
+        uint8_t gain = (uint8_t)btstack_atoi((char*)&packet[strlen(HSP_HS_MICROPHONE_GAIN)]);
+        connection->ag_send_ok = 1;
+        emit_event(connection, HSP_SUBEVENT_MICROPHONE_GAIN_CHANGED, gain);
+    
+    } else if (strncmp((char *)packet, HSP_HS_SPEAKER_GAIN, strlen(HSP_HS_SPEAKER_GAIN)) == 0){
+        uint8_t gain = (uint8_t)btstack_atoi((char*)&packet[strlen(HSP_HS_SPEAKER_GAIN)]);
+        connection->ag_send_ok = 1;
+        emit_event(connection, HSP_SUBEVENT_SPEAKER_GAIN_CHANGED, gain);
+
+    } else if (strncmp((char *)packet, "AT+", 3) == 0){
+        connection->ag_send_error = 1;
+        if (!hsp_ag_callback) return;
+        // re-use incoming buffer to avoid reserving large buffers - ugly but efficient
+        uint8_t * event = packet - 6;
+        event[0] = HCI_EVENT_HSP_META;
+        event[1] = size + 4;
+        event[2] = HSP_SUBEVENT_HS_COMMAND;
+        little_endian_store_16(event, 3, connection->rfcomm_handle);
+        event[5] = size;
+        (*hsp_ag_callback)(HCI_EVENT_PACKET, 0, event, size+6);
+    }
+}
 
-        if (strncmp((char *)packet, HSP_HS_BUTTON_PRESS, strlen(HSP_HS_BUTTON_PRESS)) == 0){
-            log_info("Received button press %s", HSP_HS_BUTTON_PRESS);
-            ag_send_ok = 1;
-            switch (hsp_state){
-                case HSP_AUDIO_CONNECTION_ESTABLISHED:
-                    hsp_release_audio_connection = 1;
-                    break;
-                case HSP_RFCOMM_CONNECTION_ESTABLISHED:
-                    hsp_establish_audio_connection = 1;
-                    break;
-                default:
-                    break;
-            } 
-        } else if (strncmp((char *)packet, HSP_HS_MICROPHONE_GAIN, strlen(HSP_HS_MICROPHONE_GAIN)) == 0){
-            uint8_t gain = (uint8_t)btstack_atoi((char*)&packet[strlen(HSP_HS_MICROPHONE_GAIN)]);
-            ag_send_ok = 1;
-            emit_event(HSP_SUBEVENT_MICROPHONE_GAIN_CHANGED, gain);
-        
-        } else if (strncmp((char *)packet, HSP_HS_SPEAKER_GAIN, strlen(HSP_HS_SPEAKER_GAIN)) == 0){
-            uint8_t gain = (uint8_t)btstack_atoi((char*)&packet[strlen(HSP_HS_SPEAKER_GAIN)]);
-            ag_send_ok = 1;
-            emit_event(HSP_SUBEVENT_SPEAKER_GAIN_CHANGED, gain);
-
-        } else if (strncmp((char *)packet, "AT+", 3) == 0){
-            ag_send_error = 1;
-            if (!hsp_ag_callback) return;
-            // re-use incoming buffer to avoid reserving large buffers - ugly but efficient
-            uint8_t * event = packet - 4;
-            event[0] = HCI_EVENT_HSP_META;
-            event[1] = size + 2;
-            event[2] = HSP_SUBEVENT_HS_COMMAND;
-            event[3] = size;
-            (*hsp_ag_callback)(HCI_EVENT_PACKET, 0, event, size+4);
+static void hsp_ag_handle_sco_connection_complete(uint8_t *packet){
+    bd_addr_t event_addr;
+    hci_event_synchronous_connection_complete_get_bd_addr(packet, event_addr);
+    hsp_ag_connection_t * connection = hsp_ag_connection_for_bd_addr(event_addr);
+    if (!connection) return;
+    if (hsp_ag_sco_setup_connection == connection){
+        hsp_ag_sco_setup_connection = NULL;
+    }
+
+    uint8_t status = hci_event_synchronous_connection_complete_get_status(packet);
+    if (status != 0){
+        log_error("(e)SCO Connection failed, status %u", status);
+        if (connection->state == HSP_W4_SCO_CONNECTED){
+            connection->state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
         }
+        emit_event_audio_connected(connection, status, connection->sco_handle);
+        return;
+    }
+    
+    connection->sco_handle = hci_event_synchronous_connection_complete_get_handle(packet);
+    uint8_t  link_type = hci_event_synchronous_connection_complete_get_link_type(packet);
+    uint8_t  transmission_interval = hci_event_synchronous_connection_complete_get_transmission_interval(packet);  // measured in slots
+    uint8_t  retransmission_interval = hci_event_synchronous_connection_complete_get_retransmission_interval(packet);// measured in slots
+    uint16_t rx_packet_length = hci_event_synchronous_connection_complete_get_rx_packet_length(packet); // measured in bytes
+    uint16_t tx_packet_length = hci_event_synchronous_connection_complete_get_tx_packet_length(packet); // measured in bytes
+    uint8_t  air_mode = hci_event_synchronous_connection_complete_get_air_mode(packet);
+
+    switch (link_type){
+        case 0x00:
+            log_info("SCO Connection established.");
+            if (transmission_interval != 0) log_error("SCO Connection: transmission_interval not zero: %d.", transmission_interval);
+            if (retransmission_interval != 0) log_error("SCO Connection: retransmission_interval not zero: %d.", retransmission_interval);
+            if (rx_packet_length != 0) log_error("SCO Connection: rx_packet_length not zero: %d.", rx_packet_length);
+            if (tx_packet_length != 0) log_error("SCO Connection: tx_packet_length not zero: %d.", tx_packet_length);
+            break;
+        case 0x02:
+            log_info("eSCO Connection established.");
+            break;
+        default:
+            log_error("(e)SCO reserved link_type 0x%2x", link_type);
+            break;
+    }
+    log_info("sco_handle 0x%2x, address %s, transmission_interval %u slots, retransmission_interval %u slots, " 
+         " rx_packet_length %u bytes, tx_packet_length %u bytes, air_mode 0x%2x (0x02 == CVSD)", connection->sco_handle,
+         bd_addr_to_str(event_addr), transmission_interval, retransmission_interval, rx_packet_length, tx_packet_length, air_mode);
+
+    if (connection->state == HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN){
+        connection->state = HSP_W2_DISCONNECT_SCO;
+        return;
+    }
+
+    connection->state = HSP_AUDIO_CONNECTION_ESTABLISHED;
+    emit_event_audio_connected(connection, status, connection->sco_handle);
+}
+
+static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    hsp_ag_connection_t * connection;
 
+    if (packet_type == RFCOMM_DATA_PACKET){
+        connection = hsp_ag_connection_for_rfcomm_cid(channel);
+        if (!connection) return;
+        hsp_ag_handle_rfcomm_data(connection, packet, size);
         hsp_run();
         return;
     }
@@ -590,111 +799,106 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
     uint8_t event = hci_event_packet_get_type(packet);
     bd_addr_t event_addr;
     uint16_t handle;
+    uint16_t rfcomm_cid;
 
     switch (event) {
         case HCI_EVENT_CONNECTION_REQUEST:
-            hci_event_connection_request_get_bd_addr(packet, sco_event_addr);
-            ag_establish_sco = 1;
-            break;
-        case HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE:{
-            uint8_t status = hci_event_synchronous_connection_complete_get_status(packet);
-            if (status != 0){
-                log_error("(e)SCO Connection failed, status %u", status);
-                emit_event_audio_connected(status, sco_handle);
+            if (hci_event_connection_request_get_link_type(packet) == 1) break;  // ACL
+            hci_event_connection_request_get_bd_addr(packet, event_addr);
+            connection = hsp_ag_connection_for_bd_addr(event_addr);
+            // request from other device might be handled by another SCO user, e.g. HFP
+            if (!connection) break;
+            if (hsp_ag_sco_num_connections() < MAX_NR_HSP_AG_SCO_CONNECTIONS){
+                connection->ag_establish_sco = 1;
                 break;
             }
-            
-            hci_event_synchronous_connection_complete_get_bd_addr(packet, event_addr);
-            sco_handle = hci_event_synchronous_connection_complete_get_handle(packet);
-            uint8_t  link_type = hci_event_synchronous_connection_complete_get_link_type(packet);
-            uint8_t  transmission_interval = hci_event_synchronous_connection_complete_get_transmission_interval(packet);  // measured in slots
-            uint8_t  retransmission_interval = hci_event_synchronous_connection_complete_get_retransmission_interval(packet);// measured in slots
-            uint16_t rx_packet_length = hci_event_synchronous_connection_complete_get_rx_packet_length(packet); // measured in bytes
-            uint16_t tx_packet_length = hci_event_synchronous_connection_complete_get_tx_packet_length(packet); // measured in bytes
-            uint8_t  air_mode = hci_event_synchronous_connection_complete_get_air_mode(packet);
-
-            switch (link_type){
-                case 0x00:
-                    log_info("SCO Connection established.");
-                    if (transmission_interval != 0) log_error("SCO Connection: transmission_interval not zero: %d.", transmission_interval);
-                    if (retransmission_interval != 0) log_error("SCO Connection: retransmission_interval not zero: %d.", retransmission_interval);
-                    if (rx_packet_length != 0) log_error("SCO Connection: rx_packet_length not zero: %d.", rx_packet_length);
-                    if (tx_packet_length != 0) log_error("SCO Connection: tx_packet_length not zero: %d.", tx_packet_length);
-                    break;
-                case 0x02:
-                    log_info("eSCO Connection established.");
-                    break;
-                default:
-                    log_error("(e)SCO reserved link_type 0x%2x", link_type);
-                    break;
-            }
-            log_info("sco_handle 0x%2x, address %s, transmission_interval %u slots, retransmission_interval %u slots, " 
-                 " rx_packet_length %u bytes, tx_packet_length %u bytes, air_mode 0x%2x (0x02 == CVSD)", sco_handle,
-                 bd_addr_to_str(event_addr), transmission_interval, retransmission_interval, rx_packet_length, tx_packet_length, air_mode);
+            log_info("HSP: reject SCO connection from %s", bd_addr_to_str(event_addr));
+            memcpy(hsp_ag_sco_reject_addr, event_addr, 6);
+            hsp_ag_sco_reject_pending = 1;
+            break;
 
-            if (hsp_state == HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN){
-                hsp_state = HSP_W2_DISCONNECT_SCO;
-                break;
+        case HCI_EVENT_COMMAND_STATUS:
+            if (!hsp_ag_sco_setup_connection) break;
+            if (!HCI_EVENT_IS_COMMAND_STATUS(packet, hci_setup_synchronous_connection) &&
+                !HCI_EVENT_IS_COMMAND_STATUS(packet, hci_accept_synchronous_connection)) break;
+            if (hci_event_command_status_get_status(packet) == ERROR_CODE_SUCCESS) break;
+            connection = hsp_ag_sco_setup_connection;
+            hsp_ag_sco_setup_connection = NULL;
+            if (connection->state == HSP_W4_SCO_CONNECTED){
+                connection->state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
             }
+            emit_event_audio_connected(connection, hci_event_command_status_get_status(packet), 0);
+            break;
 
-            hsp_state = HSP_AUDIO_CONNECTION_ESTABLISHED;
-            emit_event_audio_connected(status, sco_handle);
+        case HCI_EVENT_SYNCHRONOUS_CONNECTION_COMPLETE:
+            hsp_ag_handle_sco_connection_complete(packet);
             break;                
-        }
 
         case RFCOMM_EVENT_INCOMING_CONNECTION:
             // data: event (8), len(8), address(48), channel (8), rfcomm_cid (16)
-            if (hsp_state != HSP_IDLE) return;
-
             rfcomm_event_incoming_connection_get_bd_addr(packet, event_addr);  
-            rfcomm_cid = rfcomm_event_incoming_connection_get_server_channel(packet);
+            rfcomm_cid = rfcomm_event_incoming_connection_get_rfcomm_cid(packet);
             log_info("RFCOMM channel %u requested for %s", packet[8], bd_addr_to_str(event_addr));
-            hsp_state = HSP_W4_RFCOMM_CONNECTED;
+            connection = NULL;
+            if (!hsp_ag_connection_for_bd_addr(event_addr)){
+                connection = hsp_ag_connection_create(event_addr);
+            }
+            if (!connection){
+                rfcomm_decline_connection(rfcomm_cid);
+                break;
+            }
+            connection->rfcomm_cid = rfcomm_cid;
+            connection->state = HSP_W4_RFCOMM_CONNECTED;
             rfcomm_accept_connection(rfcomm_cid);
             break;
 
         case RFCOMM_EVENT_CHANNEL_OPENED:
             log_info("RFCOMM_EVENT_CHANNEL_OPENED packet_handler type %u, packet[0] %x", packet_type, packet[0]);
             // data: event(8), len(8), status (8), address (48), handle(16), server channel(8), rfcomm_cid(16), max frame size(16)
+            rfcomm_event_channel_opened_get_bd_addr(packet, event_addr);
+            connection = hsp_ag_connection_for_bd_addr(event_addr);
+            if (!connection) break;
             if (rfcomm_event_channel_opened_get_status(packet)) {
-                log_info("RFCOMM channel open failed, status %u§", rfcomm_event_channel_opened_get_status(packet));
-                hsp_ag_reset_state();
-                hsp_state = HSP_IDLE;
-            } else {
-                // data: event(8) , len(8), status (8), address (48), handle (16), server channel(8), rfcomm_cid(16), max frame size(16)
-                rfcomm_handle = rfcomm_event_channel_opened_get_con_handle(packet);
-                rfcomm_cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
-                mtu = rfcomm_event_channel_opened_get_max_frame_size(packet);
-                log_info("RFCOMM channel open succeeded. New RFCOMM Channel ID %u, max frame size %u, state %d", rfcomm_cid, mtu, hsp_state);
-                hsp_state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
+                log_info("RFCOMM channel open failed, status %u", rfcomm_event_channel_opened_get_status(packet));
+                emit_event_rfcomm_connected(connection, packet[2]);
+                hsp_ag_reset_state(connection);
+                break;
+            }
+            // data: event(8) , len(8), status (8), address (48), handle (16), server channel(8), rfcomm_cid(16), max frame size(16)
+            connection->rfcomm_handle = rfcomm_event_channel_opened_get_con_handle(packet);
+            connection->rfcomm_cid = rfcomm_event_channel_opened_get_rfcomm_cid(packet);
+            connection->mtu = rfcomm_event_channel_opened_get_max_frame_size(packet);
+            log_info("RFCOMM channel open succeeded. New RFCOMM Channel ID %u, max frame size %u, state %d", connection->rfcomm_cid, connection->mtu, connection->state);
+            if (connection->state == HSP_W4_CONNECTION_ESTABLISHED_TO_SHUTDOWN){
+                connection->hsp_disconnect_rfcomm = 1;
             }
-            emit_event(HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE, packet[2]);
+            connection->state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
+            emit_event_rfcomm_connected(connection, 0);
             break;
         
         case RFCOMM_EVENT_CHANNEL_CLOSED:
-            rfcomm_handle = 0;
-            hsp_state = HSP_IDLE;
-            hsp_ag_reset_state();
-            emit_event(HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE,0);
+            connection = hsp_ag_connection_for_rfcomm_cid(rfcomm_event_channel_closed_get_rfcomm_cid(packet));
+            if (!connection) break;
+            emit_event(connection, HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE,0);
+            hsp_ag_reset_state(connection);
             break;
 
         case RFCOMM_EVENT_CAN_SEND_NOW:
-            hsp_run();
             break;
 
         case HCI_EVENT_DISCONNECTION_COMPLETE:
-            handle = little_endian_read_16(packet,3);
-            if (handle == sco_handle){
-                sco_handle = 0;
-                hsp_state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
-                emit_event(HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE,0);
+            handle = hci_event_disconnection_complete_get_connection_handle(packet);
+            connection = hsp_ag_connection_for_sco_handle(handle);
+            if (connection){
+                connection->sco_handle = 0;
+                connection->state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
+                emit_event(connection, HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE,0);
                 break;
             } 
-            if (handle == rfcomm_handle) {
-                rfcomm_handle = 0;
-                hsp_state = HSP_IDLE;
-                hsp_ag_reset_state();
-                emit_event(HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE,0);
+            connection = hsp_ag_connection_for_acl_handle(handle);
+            if (connection) {
+                emit_event(connection, HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE,0);
+                hsp_ag_reset_state(connection);
             }
             break;
 
@@ -710,29 +914,33 @@ static void handle_query_rfcomm_event(uint8_t packet_type, uint16_t channel, uin
     UNUSED(channel);        // ok: no channel
     UNUSED(size);           // ok: handling own sdp events
 
+    hsp_ag_connection_t * connection = hsp_ag_sdp_query_connection;
+    if (!connection) return;
+
     switch (packet[0]){
         case SDP_EVENT_QUERY_RFCOMM_SERVICE:
-            channel_nr = sdp_event_query_rfcomm_service_get_rfcomm_channel(packet);
-            log_info("** Service name: '%s', RFCOMM port %u", sdp_event_query_rfcomm_service_get_name(packet), channel_nr);
+            connection->channel_nr = sdp_event_query_rfcomm_service_get_rfcomm_channel(packet);
+            log_info("** Service name: '%s', RFCOMM port %u", sdp_event_query_rfcomm_service_get_name(packet), connection->channel_nr);
             break;
         case SDP_EVENT_QUERY_COMPLETE:
-            if (channel_nr > 0){
-                hsp_state = HSP_W4_RFCOMM_CONNECTED;
+            hsp_ag_sdp_query_connection = NULL;
+            if (connection->channel_nr > 0){
+                connection->state = HSP_W4_RFCOMM_CONNECTED;
                 log_info("RFCOMM create channel. state %d", HSP_W4_RFCOMM_CONNECTED);
-                rfcomm_create_channel(packet_handler, remote, channel_nr, NULL); 
+                rfcomm_create_channel(packet_handler, connection->remote, connection->channel_nr, NULL); 
                 break;
             }
-            hsp_ag_reset_state();
             log_info("Service not found, status %u.\n", sdp_event_query_complete_get_status(packet));
             if (sdp_event_query_complete_get_status(packet)){
-                emit_event(HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE, sdp_event_query_complete_get_status(packet));
+                emit_event_rfcomm_connected(connection, sdp_event_query_complete_get_status(packet));
             } else {
-                emit_event(HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE, SDP_SERVICE_NOT_FOUND);
+                emit_event_rfcomm_connected(connection, SDP_SERVICE_NOT_FOUND);
             }
+            hsp_ag_reset_state(connection);
+            // start pending queries
+            hsp_run();
             break;
         default:
             break;
     }
 }
-
-
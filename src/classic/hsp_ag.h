@@ -81,6 +81,8 @@ void hsp_ag_create_sdp_record(uint8_t * service, uint32_t service_record_handle,
  * - HSP_SUBEVENT_SPEAKER_GAIN_CHANGED         
  * - HSP_SUBEVENT_HS_COMMAND      
  *
+ * All events listed above contain the acl_handle of the Headset connection used for further commands.
+ * HSP_SUBEVENT_RING and HSP_SUBEVENT_AG_INDICATION are only emitted by HSP HS and don't contain it.
  * @param callback 
  */
 void hsp_ag_register_packet_handler(btstack_packet_handler_t callback);
@@ -92,6 +94,7 @@ void hsp_ag_register_packet_handler(btstack_packet_handler_t callback);
  * and establish an RFCOMM connection if such service is found. Reception of the  
  * HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE with status 0
  * indicates if the connection is successfully established. 
+ * Up to MAX_NR_HSP_AG_CONNECTIONS Headsets can be connected at the same time.
  *
  * @param bd_addr
  */
@@ -102,9 +105,9 @@ void hsp_ag_connect(bd_addr_t bd_addr);
  *
  * Reception of the HSP_SUBEVENT_RFCOMM_DISCONNECTION_COMPLETE with status 0
  * indicates if the connection is successfully released. 
- * @param bd_addr
+ * @param acl_handle
  */
-void hsp_ag_disconnect(void);
+void hsp_ag_disconnect(hci_con_handle_t acl_handle);
 
 
 /**
@@ -112,40 +115,46 @@ void hsp_ag_disconnect(void);
  * 
  * Reception of the HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE with status 0
  * indicates if the audio connection is successfully established. 
- * @param bd_addr
+ * Up to MAX_NR_HSP_AG_SCO_CONNECTIONS audio connections are established at the same time,
+ * further requests are delayed until an audio connection is released.
+ * @param acl_handle
  */
-void hsp_ag_establish_audio_connection(void);
+void hsp_ag_establish_audio_connection(hci_con_handle_t acl_handle);
 
 /**
  * @brief Release audio connection.
  *
  * Reception of the HSP_SUBEVENT_AUDIO_DISCONNECTION_COMPLETE with status 0
  * indicates if the connection is successfully released. 
- * @param bd_addr
+ * @param acl_handle
  */
-void hsp_ag_release_audio_connection(void);
+void hsp_ag_release_audio_connection(hci_con_handle_t acl_handle);
 
 /**
  * @brief Set microphone gain. 
+ * @param acl_handle
  * @param gain Valid range: [0,15]
  */
-void hsp_ag_set_microphone_gain(uint8_t gain);
+void hsp_ag_set_microphone_gain(hci_con_handle_t acl_handle, uint8_t gain);
 
 /**
  * @brief Set speaker gain. 
+ * @param acl_handle
  * @param gain Valid range: [0,15]
  */
-void hsp_ag_set_speaker_gain(uint8_t gain);
+void hsp_ag_set_speaker_gain(hci_con_handle_t acl_handle, uint8_t gain);
 
 /**
  * @brief Start ringing because of incoming call.
+ * @param acl_handle
  */
-void hsp_ag_start_ringing(void);
+void hsp_ag_start_ringing(hci_con_handle_t acl_handle);
 
 /**
  * @brief Stop ringing (e.g. call was terminated).
+ * @param acl_handle
  */
-void hsp_ag_stop_ringing(void);
+void hsp_ag_stop_ringing(hci_con_handle_t acl_handle);
 
 /**
  * @brief Enable custom AT commands.
@@ -161,9 +170,10 @@ void hsp_ag_enable_custom_commands(int enable);
  *
  * On HSP_SUBEVENT_AG_INDICATION, the client needs to respond
  * with this function with the result to the custom command.
+ * @param acl_handle
  * @param result 
  */
-int hsp_ag_send_result(char * result);
+int hsp_ag_send_result(hci_con_handle_t acl_handle, char * result);
 
 /* API_END */
 
@@ -145,11 +145,24 @@ void hsp_hs_register_packet_handler(btstack_packet_handler_t callback){
 
 static void emit_event(uint8_t event_subtype, uint8_t value){
     if (!hsp_hs_callback) return;
-    uint8_t event[4];
+    uint8_t event[6];
     event[0] = HCI_EVENT_HSP_META;
     event[1] = sizeof(event) - 2;
     event[2] = event_subtype;
     event[3] = value; // status 0 == OK
+    little_endian_store_16(event, 4, rfcomm_handle);
+    (*hsp_hs_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void emit_event_rfcomm_connected(uint8_t status, bd_addr_t addr){
+    if (!hsp_hs_callback) return;
+    uint8_t event[12];
+    event[0] = HCI_EVENT_HSP_META;
+    event[1] = sizeof(event) - 2;
+    event[2] = HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE;
+    event[3] = status;
+    little_endian_store_16(event, 4, rfcomm_handle);
+    reverse_bd_addr(addr, &event[6]);
     (*hsp_hs_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
@@ -164,12 +177,13 @@ static void emit_ring_event(void){
 
 static void emit_event_audio_connected(uint8_t status, uint16_t handle){
     if (!hsp_hs_callback) return;
-    uint8_t event[6];
+    uint8_t event[8];
     event[0] = HCI_EVENT_HSP_META;
     event[1] = sizeof(event) - 2;
     event[2] = HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE;
     event[3] = status;
     little_endian_store_16(event, 4, handle);
+    little_endian_store_16(event, 6, rfcomm_handle);
     (*hsp_hs_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
 }
 
@@ -618,7 +632,8 @@ static void packet_handler (uint8_t packet_type, uint16_t channel, uint8_t *pack
                 log_info("RFCOMM channel open succeeded. New RFCOMM Channel ID %u, max frame size %u, handle %02x", rfcomm_cid, mtu, rfcomm_handle);
                 hsp_state = HSP_RFCOMM_CONNECTION_ESTABLISHED;
             }
-            emit_event(HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE, packet[2]);
+            rfcomm_event_channel_opened_get_bd_addr(packet, event_addr);
+            emit_event_rfcomm_connected(packet[2], event_addr);
             break;
 
         case RFCOMM_EVENT_CAN_SEND_NOW:
@@ -673,9 +688,9 @@ static void handle_query_rfcomm_event(uint8_t packet_type, uint16_t channel, uin
             hsp_hs_reset_state();
             log_info("Service not found, status %u.", sdp_event_query_complete_get_status(packet));
             if (sdp_event_query_complete_get_status(packet)){
-                emit_event(HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE, sdp_event_query_complete_get_status(packet));
+                emit_event_rfcomm_connected(sdp_event_query_complete_get_status(packet), remote);
             } else {
-                emit_event(HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE, SDP_SERVICE_NOT_FOUND);
+                emit_event_rfcomm_connected(SDP_SERVICE_NOT_FOUND, remote);
             }
             break;
     }
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+#define __BTSTACK_FILE__ "pan_nap_bridge.c"
+
+/*
+ * pan_nap_bridge.c
+ *
+ * Source MAC addresses of frames received on a BNEP channel are stored in a hash table with
+ * linear probing. Unicast frames are forwarded only to the BNEP channel that owns the destination
+ * address, or to the network interface if the address is unknown. Only broadcast and multicast
+ * frames are flooded. Frames received over BNEP are copied into a shared buffer that is sent on
+ * all target channels, frames from the network interface are sent without copy. Each channel
+ * sends its pending frames in order on BNEP_EVENT_CAN_SEND_NOW.
+ */
+
+#include <string.h>
+
+#include "classic/pan_nap_bridge.h"
+
+#include "btstack_debug.h"
+#include "btstack_event.h"
+#include "btstack_util.h"
+#include "classic/bnep.h"
+
+#if MAX_NR_PAN_NAP_BRIDGE_CHANNELS > 16
+#error "MAX_NR_PAN_NAP_BRIDGE_CHANNELS must not be larger than 16"
+#endif
+
+#if (PAN_NAP_BRIDGE_MAC_TABLE_SIZE & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1)) != 0
+#error "PAN_NAP_BRIDGE_MAC_TABLE_SIZE must be a power of two"
+#endif
+
+#define ETHERNET_HEADER_LEN 14
+
+// frame from network interface is stored after the frame buffers
+#define PAN_NAP_BRIDGE_NETWORK_FRAME PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS
+
+typedef struct {
+    uint16_t bnep_cid;          // 0 = unused
+    uint8_t  can_send_now_requested;
+} pan_nap_bridge_channel_t;
+
+typedef struct {
+    bd_addr_t address;
+    uint16_t  bnep_cid;         // 0 = unused
+} pan_nap_bridge_mac_entry_t;
+
+typedef struct {
+    uint32_t  seq_nr;           // frames are sent in order of seq_nr
+    uint16_t  channels_pending; // bit per channel that did not send this frame yet, 0 = unused
+    uint16_t  len;
+    const uint8_t * data;
+} pan_nap_bridge_frame_t;
+
+static pan_nap_bridge_channel_t   pan_nap_bridge_channels[MAX_NR_PAN_NAP_BRIDGE_CHANNELS];
+static pan_nap_bridge_mac_entry_t pan_nap_bridge_mac_table[PAN_NAP_BRIDGE_MAC_TABLE_SIZE];
+static pan_nap_bridge_frame_t     pan_nap_bridge_frames[PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS + 1];
+static uint8_t                    pan_nap_bridge_frame_buffers[PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS][PAN_NAP_BRIDGE_MAX_FRAME_SIZE];
+static uint32_t pan_nap_bridge_seq_nr;
+static uint32_t pan_nap_bridge_num_dropped_frames;
+
+static void (*pan_nap_bridge_network_process_packet)(const uint8_t * packet, uint16_t size);
+static void (*pan_nap_bridge_network_packet_sent)(void);
+
+// MAC address table
+
+static int pan_nap_bridge_mac_hash(const uint8_t * address){
+    uint32_t hash = 0;
+    int i;
+    for (i = 0; i < ETHER_ADDR_LEN; i++){
+        hash = (hash * 31) + address[i];
+    }
+    return hash & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+}
+
+static uint16_t pan_nap_bridge_mac_lookup(const uint8_t * address){
+    int index = pan_nap_bridge_mac_hash(address);
+    int i;
+    for (i = 0; i < PAN_NAP_BRIDGE_MAC_TABLE_SIZE; i++){
+        pan_nap_bridge_mac_entry_t * entry = &pan_nap_bridge_mac_table[index];
+        if (entry->bnep_cid == 0) return 0;
+        if (memcmp(entry->address, address, ETHER_ADDR_LEN) == 0) return entry->bnep_cid;
+        index = (index + 1) & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+    }
+    return 0;
+}
+
+static void pan_nap_bridge_mac_learn(const uint8_t * address, uint16_t bnep_cid){
+    int home = pan_nap_bridge_mac_hash(address);
+    int index = home;
+    int i;
+    for (i = 0; i < PAN_NAP_BRIDGE_MAC_TABLE_SIZE; i++){
+        pan_nap_bridge_mac_entry_t * entry = &pan_nap_bridge_mac_table[index];
+        if ((entry->bnep_cid == 0) || (memcmp(entry->address, address, ETHER_ADDR_LEN) == 0)){
+            bd_addr_copy(entry->address, address);
+            entry->bnep_cid = bnep_cid;
+            return;
+        }
+        index = (index + 1) & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+    }
+    // table full, replace entry in home slot
+    log_info("PAN NAP Bridge: MAC table full, replace %s", bd_addr_to_str(pan_nap_bridge_mac_table[home].address));
+    bd_addr_copy(pan_nap_bridge_mac_table[home].address, address);
+    pan_nap_bridge_mac_table[home].bnep_cid = bnep_cid;
+}
+
+static void pan_nap_bridge_mac_delete(int index){
+    // backward-shift deletion: move following entries of the probe sequence into the hole
+    // unless their home slot lies cyclically within (hole, current]
+    int hole = index;
+    int i;
+    for (i = 1; i < PAN_NAP_BRIDGE_MAC_TABLE_SIZE; i++){
+        int current = (index + i) & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+        pan_nap_bridge_mac_entry_t * entry = &pan_nap_bridge_mac_table[current];
+        if (entry->bnep_cid == 0) break;
+        int home = pan_nap_bridge_mac_hash(entry->address);
+        int distance_home = (current - home) & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+        int distance_hole = (current - hole)  & (PAN_NAP_BRIDGE_MAC_TABLE_SIZE - 1);
+        if (distance_home < distance_hole) continue;
+        pan_nap_bridge_mac_table[hole] = *entry;
+        hole = current;
+    }
+    pan_nap_bridge_mac_table[hole].bnep_cid = 0;
+}
+
+static void pan_nap_bridge_mac_remove_channel(uint16_t bnep_cid){
+    int index = 0;
+    while (index < PAN_NAP_BRIDGE_MAC_TABLE_SIZE){
+        if (pan_nap_bridge_mac_table[index].bnep_cid == bnep_cid){
+            // entry shifted into this slot needs to be checked, too
+            pan_nap_bridge_mac_delete(index);
+            continue;
+        }
+        index++;
+    }
+}
+
+// channels
+
+static int pan_nap_bridge_channel_index_for_cid(uint16_t bnep_cid){
+    int i;
+    for (i = 0; i < MAX_NR_PAN_NAP_BRIDGE_CHANNELS; i++){
+        if (pan_nap_bridge_channels[i].bnep_cid == bnep_cid) return i;
+    }
+    return -1;
+}
+
+static uint16_t pan_nap_bridge_all_channels(void){
+    uint16_t channels = 0;
+    int i;
+    for (i = 0; i < MAX_NR_PAN_NAP_BRIDGE_CHANNELS; i++){
+        if (pan_nap_bridge_channels[i].bnep_cid == 0) continue;
+        channels |= 1 << i;
+    }
+    return channels;
+}
+
+static void pan_nap_bridge_frame_done(int frame_index){
+    pan_nap_bridge_frames[frame_index].channels_pending = 0;
+    if (frame_index != PAN_NAP_BRIDGE_NETWORK_FRAME) return;
+    if (pan_nap_bridge_network_packet_sent){
+        (*pan_nap_bridge_network_packet_sent)();
+    }
+}
+
+static void pan_nap_bridge_request_can_send_now(int channel_index){
+    pan_nap_bridge_channel_t * channel = &pan_nap_bridge_channels[channel_index];
+    if (channel->can_send_now_requested) return;
+    channel->can_send_now_requested = 1;
+    bnep_request_can_send_now_event(channel->bnep_cid);
+}
+
+static void pan_nap_bridge_queue_frame(int frame_index, uint16_t channels){
+    pan_nap_bridge_frame_t * frame = &pan_nap_bridge_frames[frame_index];
+    frame->seq_nr = pan_nap_bridge_seq_nr++;
+    frame->channels_pending = channels;
+    int i;
+    for (i = 0; i < MAX_NR_PAN_NAP_BRIDGE_CHANNELS; i++){
+        if ((channels & (1 << i)) == 0) continue;
+        pan_nap_bridge_request_can_send_now(i);
+    }
+}
+
+static int pan_nap_bridge_next_frame_for_channel(int channel_index){
+    int next = -1;
+    int i;
+    for (i = 0; i <= PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS; i++){
+        pan_nap_bridge_frame_t * frame = &pan_nap_bridge_frames[i];
+        if ((frame->channels_pending & (1 << channel_index)) == 0) continue;
+        if ((next < 0) || ((int32_t)(frame->seq_nr - pan_nap_bridge_frames[next].seq_nr) < 0)){
+            next = i;
+        }
+    }
+    return next;
+}
+
+static void pan_nap_bridge_handle_can_send_now(uint16_t bnep_cid){
+    int channel_index = pan_nap_bridge_channel_index_for_cid(bnep_cid);
+    if (channel_index < 0) return;
+    pan_nap_bridge_channels[channel_index].can_send_now_requested = 0;
+
+    int frame_index = pan_nap_bridge_next_frame_for_channel(channel_index);
+    if (frame_index < 0) return;
+
+    pan_nap_bridge_frame_t * frame = &pan_nap_bridge_frames[frame_index];
+    bnep_send(bnep_cid, (uint8_t *) frame->data, frame->len);
+    frame->channels_pending &= ~(1 << channel_index);
+    if (frame->channels_pending == 0){
+        pan_nap_bridge_frame_done(frame_index);
+    }
+
+    if (pan_nap_bridge_next_frame_for_channel(channel_index) >= 0){
+        pan_nap_bridge_request_can_send_now(channel_index);
+    }
+}
+
+static void pan_nap_bridge_add_channel(uint16_t bnep_cid){
+    int channel_index = pan_nap_bridge_channel_index_for_cid(0);
+    if (channel_index < 0){
+        log_error("PAN NAP Bridge: no free channel for bnep cid 0x%02x", bnep_cid);
+        return;
+    }
+    pan_nap_bridge_channels[channel_index].bnep_cid = bnep_cid;
+    pan_nap_bridge_channels[channel_index].can_send_now_requested = 0;
+}
+
+static void pan_nap_bridge_remove_channel(uint16_t bnep_cid){
+    int channel_index = pan_nap_bridge_channel_index_for_cid(bnep_cid);
+    if (channel_index < 0) return;
+    pan_nap_bridge_channels[channel_index].bnep_cid = 0;
+
+    // drop pending frames for this channel
+    int i;
+    for (i = 0; i <= PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS; i++){
+        pan_nap_bridge_frame_t * frame = &pan_nap_bridge_frames[i];
+        if ((frame->channels_pending & (1 << channel_index)) == 0) continue;
+        frame->channels_pending &= ~(1 << channel_index);
+        if (frame->channels_pending == 0){
+            pan_nap_bridge_frame_done(i);
+        }
+    }
+
+    pan_nap_bridge_mac_remove_channel(bnep_cid);
+}
+
+// forwarding
+
+static void pan_nap_bridge_handle_bnep_packet(uint16_t bnep_cid, const uint8_t * packet, uint16_t size){
+    if (size < ETHERNET_HEADER_LEN) return;
+    int channel_index = pan_nap_bridge_channel_index_for_cid(bnep_cid);
+    if (channel_index < 0) return;
+
+    const uint8_t * addr_dest   = &packet[0];
+    const uint8_t * addr_source = &packet[ETHER_ADDR_LEN];
+
+    // learn unicast source address
+    if ((addr_source[0] & 0x01) == 0){
+        pan_nap_bridge_mac_learn(addr_source, bnep_cid);
+    }
+
+    uint16_t channels;
+    if (addr_dest[0] & 0x01){
+        // broadcast and multicast: all other channels and network interface
+        channels = pan_nap_bridge_all_channels() & ~(1 << channel_index);
+        (*pan_nap_bridge_network_process_packet)(packet, size);
+    } else {
+        uint16_t dest_cid = pan_nap_bridge_mac_lookup(addr_dest);
+        if (dest_cid == 0){
+            // unknown unicast, e.g. NAP itself or remote network
+            (*pan_nap_bridge_network_process_packet)(packet, size);
+            return;
+        }
+        if (dest_cid == bnep_cid) return;
+        int dest_index = pan_nap_bridge_channel_index_for_cid(dest_cid);
+        if (dest_index < 0) return;
+        channels = 1 << dest_index;
+    }
+    if (channels == 0) return;
+
+    if (size > PAN_NAP_BRIDGE_MAX_FRAME_SIZE){
+        log_error("PAN NAP Bridge: frame too large %u", size);
+        pan_nap_bridge_num_dropped_frames++;
+        return;
+    }
+
+    // get free frame buffer
+    int frame_index;
+    for (frame_index = 0; frame_index < PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS; frame_index++){
+        if (pan_nap_bridge_frames[frame_index].channels_pending == 0) break;
+    }
+    if (frame_index == PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS){
+        log_info("PAN NAP Bridge: no frame buffer, drop frame");
+        pan_nap_bridge_num_dropped_frames++;
+        return;
+    }
+    memcpy(pan_nap_bridge_frame_buffers[frame_index], packet, size);
+    pan_nap_bridge_frames[frame_index].data = pan_nap_bridge_frame_buffers[frame_index];
+    pan_nap_bridge_frames[frame_index].len  = size;
+    pan_nap_bridge_queue_frame(frame_index, channels);
+}
+
+void pan_nap_bridge_network_send_packet(const uint8_t * packet, uint16_t size){
+    uint16_t channels = 0;
+    if (size >= ETHERNET_HEADER_LEN){
+        if (packet[0] & 0x01){
+            channels = pan_nap_bridge_all_channels();
+        } else {
+            uint16_t dest_cid = pan_nap_bridge_mac_lookup(packet);
+            int channel_index = dest_cid ? pan_nap_bridge_channel_index_for_cid(dest_cid) : -1;
+            if (channel_index >= 0){
+                channels = 1 << channel_index;
+            }
+        }
+    }
+
+    pan_nap_bridge_frames[PAN_NAP_BRIDGE_NETWORK_FRAME].data = packet;
+    pan_nap_bridge_frames[PAN_NAP_BRIDGE_NETWORK_FRAME].len  = size;
+    if (channels == 0){
+        // unknown unicast destination
+        pan_nap_bridge_frame_done(PAN_NAP_BRIDGE_NETWORK_FRAME);
+        return;
+    }
+    pan_nap_bridge_queue_frame(PAN_NAP_BRIDGE_NETWORK_FRAME, channels);
+}
+
+void pan_nap_bridge_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    switch (packet_type){
+        case HCI_EVENT_PACKET:
+            switch (hci_event_packet_get_type(packet)){
+                case BNEP_EVENT_CHANNEL_OPENED:
+                    if (bnep_event_channel_opened_get_status(packet)) break;
+                    pan_nap_bridge_add_channel(bnep_event_channel_opened_get_bnep_cid(packet));
+                    break;
+                case BNEP_EVENT_CHANNEL_CLOSED:
+                    pan_nap_bridge_remove_channel(bnep_event_channel_closed_get_bnep_cid(packet));
+                    break;
+                case BNEP_EVENT_CAN_SEND_NOW:
+                    pan_nap_bridge_handle_can_send_now(bnep_event_can_send_now_get_bnep_cid(packet));
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case BNEP_DATA_PACKET:
+            pan_nap_bridge_handle_bnep_packet(channel, packet, size);
+            break;
+        default:
+            break;
+    }
+}
+
+void pan_nap_bridge_init(void (*network_process_packet)(const uint8_t * packet, uint16_t size), void (*network_packet_sent)(void)){
+    pan_nap_bridge_network_process_packet = network_process_packet;
+    pan_nap_bridge_network_packet_sent    = network_packet_sent;
+    memset(pan_nap_bridge_channels,  0, sizeof(pan_nap_bridge_channels));
+    memset(pan_nap_bridge_mac_table, 0, sizeof(pan_nap_bridge_mac_table));
+    memset(pan_nap_bridge_frames,    0, sizeof(pan_nap_bridge_frames));
+    pan_nap_bridge_seq_nr = 0;
+    pan_nap_bridge_num_dropped_frames = 0;
+}
+
+uint32_t pan_nap_bridge_get_num_dropped_frames(void){
+    return pan_nap_bridge_num_dropped_frames;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at 
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+/*
+ * pan_nap_bridge.h
+ *
+ * Ethernet bridge between BNEP channels of a PAN Network Access Point (NAP) and the local network interface
+ */
+
+#ifndef __PAN_NAP_BRIDGE_H
+#define __PAN_NAP_BRIDGE_H
+
+#include <stdint.h>
+#include "btstack_defines.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+// max number of BNEP channels (PANU clients) attached to the bridge
+#ifndef MAX_NR_PAN_NAP_BRIDGE_CHANNELS
+#define MAX_NR_PAN_NAP_BRIDGE_CHANNELS 7
+#endif
+
+// number of learned MAC addresses, power of two
+#ifndef PAN_NAP_BRIDGE_MAC_TABLE_SIZE
+#define PAN_NAP_BRIDGE_MAC_TABLE_SIZE 32
+#endif
+
+// number of buffers for Ethernet frames forwarded between BNEP channels
+#ifndef PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS
+#define PAN_NAP_BRIDGE_NUM_FRAME_BUFFERS 4
+#endif
+
+// max size of Ethernet frame forwarded between BNEP channels
+#ifndef PAN_NAP_BRIDGE_MAX_FRAME_SIZE
+#define PAN_NAP_BRIDGE_MAX_FRAME_SIZE 1514
+#endif
+
+/* API_START */
+
+/**
+ * @brief Init PAN NAP Bridge
+ * @note Source addresses of frames received on a BNEP channel are learned. Unicast frames are only
+ *       forwarded to the BNEP channel of the destination, or to the network interface if unknown.
+ *       Broadcast and multicast frames are forwarded to all other BNEP channels and the network interface.
+ * @param network_process_packet deliver frame to network interface, e.g. btstack_network_process_packet
+ * @param network_packet_sent notify network interface that frame from pan_nap_bridge_network_send_packet was sent, e.g. btstack_network_packet_sent
+ */
+void pan_nap_bridge_init(void (*network_process_packet)(const uint8_t * packet, uint16_t size), void (*network_packet_sent)(void));
+
+/**
+ * @brief Forward frame from network interface, e.g. as send_packet_callback for btstack_network_init
+ * @note packet has to stay valid until network_packet_sent is called
+ * @param packet
+ * @param size
+ */
+void pan_nap_bridge_network_send_packet(const uint8_t * packet, uint16_t size);
+
+/**
+ * @brief Handle BNEP events and data packets, call from packet handler registered with bnep_register_service
+ * @note BNEP_EVENT_CHANNEL_OPENED adds channel to bridge, BNEP_EVENT_CHANNEL_CLOSED removes it and its learned addresses
+ * @param packet_type
+ * @param channel
+ * @param packet
+ * @param size
+ */
+void pan_nap_bridge_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+/**
+ * @brief Get number of frames dropped as no frame buffer was available
+ * @returns num dropped frames
+ */
+uint32_t pan_nap_bridge_get_num_dropped_frames(void);
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __PAN_NAP_BRIDGE_H
@@ -41,6 +41,8 @@
  *  sdp_client.c
  */
 
+#include <string.h>
+
 #include "bluetooth_sdp.h"
 #include "btstack_config.h"
 #include "btstack_debug.h"
@@ -52,6 +54,18 @@
 #include "hci_cmd.h"
 #include "l2cap.h"
 
+#ifdef ENABLE_SDP_CLIENT_CACHE
+#include "btstack_tlv.h"
+#endif
+
+// NVM_NUM_SDP_CLIENT_CACHE_ENTRIES defines number of cached SDP results
+#ifndef NVM_NUM_SDP_CLIENT_CACHE_ENTRIES
+#define NVM_NUM_SDP_CLIENT_CACHE_ENTRIES 4
+#endif
+
+// Service search patterns up to this size are copied into the query context, e.g. a DES with a single UUID128
+#define SDP_CLIENT_SERVICE_SEARCH_PATTERN_STORAGE_SIZE 21
+
 // Types SDP Parser - Data Element stream helper
 typedef enum { 
     GET_LIST_LENGTH = 1,
@@ -67,8 +81,42 @@ typedef enum {
     INIT, W4_CONNECT, W2_SEND, W4_RESPONSE, QUERY_COMPLETE
 } sdp_client_state_t;
 
+typedef struct {
+    // State DES Parser
+    de_state_t de_header_state;
+
+    // State SDP Parser
+    sdp_parser_state_t parser_state;
+    uint16_t attribute_id;
+    uint16_t attribute_bytes_received;
+    uint16_t attribute_bytes_delivered;
+    uint16_t list_offset;
+    uint16_t list_size;
+    uint16_t record_offset;
+    uint16_t record_size;
+    uint16_t attribute_value_size;
+    int      record_counter;
+    btstack_packet_handler_t callback;
+
+    // State SDP Client
+    sdp_client_state_t state;
+    uint16_t query_id;
+    uint16_t mtu;
+    uint16_t cid;
+    const uint8_t * service_search_pattern;
+    const uint8_t * attribute_id_list;
+    uint8_t  service_search_pattern_storage[SDP_CLIENT_SERVICE_SEARCH_PATTERN_STORAGE_SIZE];
+    uint16_t transaction_id;
+    uint8_t  continuation_state[16];
+    uint8_t  continuation_state_len;
+    SDP_PDU_ID_t pdu_id;
+#ifdef ENABLE_SDP_EXTRA_QUERIES
+    uint32_t service_record_handle;
+    uint32_t record_handle;
+#endif
+} sdp_client_t;
 
-// Prototypes SDP Parser
+// Prototypes SDP Parser - called by test/sdp_client, operate on the first query context
 void sdp_parser_init(btstack_packet_handler_t callback);
 void sdp_parser_handle_chunk(uint8_t * data, uint16_t size);
 void sdp_parser_handle_done(uint8_t status);
@@ -79,45 +127,32 @@ void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint
 // Prototypes SDP Client
 void sdp_client_reset(void);
 void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
-static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data);
+static uint16_t sdp_client_setup_service_search_attribute_request(sdp_client_t * client, uint8_t * data);
 #ifdef ENABLE_SDP_EXTRA_QUERIES
-static uint16_t sdp_client_setup_service_search_request(uint8_t * data);
-static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data);
-static void     sdp_client_parse_service_search_response(uint8_t* packet, uint16_t size);
-static void     sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_t size);
+static uint16_t sdp_client_setup_service_search_request(sdp_client_t * client, uint8_t * data);
+static uint16_t sdp_client_setup_service_attribute_request(sdp_client_t * client, uint8_t * data);
+static void     sdp_client_parse_service_search_response(sdp_client_t * client, uint8_t* packet, uint16_t size);
+static void     sdp_client_parse_service_attribute_response(sdp_client_t * client, uint8_t* packet, uint16_t size);
 #endif
 
 static uint8_t des_attributeIDList[] = { 0x35, 0x05, 0x0A, 0x00, 0x01, 0xff, 0xff};  // Attribute: 0x0001 - 0x0100
 
-// State DES Parser
-static de_state_t de_header_state;
-
-// State SDP Parser
-static sdp_parser_state_t  state = GET_LIST_LENGTH;
-static uint16_t attribute_id = 0;
-static uint16_t attribute_bytes_received = 0;
-static uint16_t attribute_bytes_delivered = 0;
-static uint16_t list_offset = 0;
-static uint16_t list_size;
-static uint16_t record_offset = 0;
-static uint16_t record_size;
-static uint16_t attribute_value_size;
-static int record_counter = 0;
-static btstack_packet_handler_t sdp_parser_callback;
-
-// State SDP Client
-static uint16_t  mtu;
-static uint16_t  sdp_cid = 0x40;
-static const uint8_t * service_search_pattern;
-static const uint8_t * attribute_id_list;
-static uint16_t  transactionID = 0;
-static uint8_t   continuationState[16];
-static uint8_t   continuationStateLen;
-static sdp_client_state_t sdp_client_state = INIT;
-static SDP_PDU_ID_t PDU_ID = SDP_Invalid;
-#ifdef ENABLE_SDP_EXTRA_QUERIES
-static uint32_t serviceRecordHandle;
-static uint32_t record_handle;
+// Query contexts, query_id = index + 1
+static sdp_client_t sdp_clients[MAX_NR_SDP_CLIENT_QUERIES];
+
+#ifdef ENABLE_SDP_CLIENT_CACHE
+typedef struct {
+    uint32_t seq_nr;    // used for "least recently stored" eviction strategy, 0 = unused
+    sdp_client_cache_entry_t entry;
+} sdp_client_cache_item_t;
+
+static sdp_client_cache_item_t sdp_client_cache_items[NVM_NUM_SDP_CLIENT_CACHE_ENTRIES];
+static uint32_t sdp_client_cache_highest_seq_nr;
+static int      sdp_client_cache_loaded;
+
+static const char sdp_client_cache_tag_0 = 'S';
+static const char sdp_client_cache_tag_1 = 'D';
+static const char sdp_client_cache_tag_2 = 'C';
 #endif
 
 // DES Parser
@@ -157,101 +192,101 @@ int de_state_size(uint8_t eventByte, de_state_t *de_state){
 }
 
 // SDP Parser
-static void sdp_parser_emit_value_byte(uint8_t event_byte){
+static void sdp_client_parser_emit_value_byte(sdp_client_t * client, uint8_t event_byte){
     uint8_t event[11];
     event[0] = SDP_EVENT_QUERY_ATTRIBUTE_VALUE;
     event[1] = 9;
-    little_endian_store_16(event, 2, record_counter);
-    little_endian_store_16(event, 4, attribute_id);
-    little_endian_store_16(event, 6, attribute_value_size);
-    little_endian_store_16(event, 8, attribute_bytes_delivered);
+    little_endian_store_16(event, 2, client->record_counter);
+    little_endian_store_16(event, 4, client->attribute_id);
+    little_endian_store_16(event, 6, client->attribute_value_size);
+    little_endian_store_16(event, 8, client->attribute_bytes_delivered);
     event[10] = event_byte;
-    (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+    (*client->callback)(HCI_EVENT_PACKET, client->query_id, event, sizeof(event)); 
 }
 
-static void sdp_parser_process_byte(uint8_t eventByte){
+static void sdp_client_parser_process_byte(sdp_client_t * client, uint8_t eventByte){
     // count all bytes
-    list_offset++;
-    record_offset++;
+    client->list_offset++;
+    client->record_offset++;
 
     // log_info(" parse BYTE_RECEIVED %02x", eventByte);
-    switch(state){
+    switch(client->parser_state){
         case GET_LIST_LENGTH:
-            if (!de_state_size(eventByte, &de_header_state)) break;
-            list_offset = de_header_state.de_offset;
-            list_size = de_header_state.de_size;
+            if (!de_state_size(eventByte, &client->de_header_state)) break;
+            client->list_offset = client->de_header_state.de_offset;
+            client->list_size = client->de_header_state.de_size;
             // log_info("parser: List offset %u, list size %u", list_offset, list_size);
             
-            record_counter = 0;
-            state = GET_RECORD_LENGTH;
+            client->record_counter = 0;
+            client->parser_state = GET_RECORD_LENGTH;
             break;
 
         case GET_RECORD_LENGTH:
             // check size
-            if (!de_state_size(eventByte, &de_header_state)) break;
+            if (!de_state_size(eventByte, &client->de_header_state)) break;
             // log_info("parser: Record payload is %d bytes.", de_header_state.de_size);
-            record_offset = de_header_state.de_offset;
-            record_size = de_header_state.de_size;
-            state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
+            client->record_offset = client->de_header_state.de_offset;
+            client->record_size = client->de_header_state.de_size;
+            client->parser_state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
             break;
 
         case GET_ATTRIBUTE_ID_HEADER_LENGTH:
-            if (!de_state_size(eventByte, &de_header_state)) break;
-            attribute_id = 0;
-            log_debug("ID data is stored in %d bytes.", (int) de_header_state.de_size);
-            state = GET_ATTRIBUTE_ID;
+            if (!de_state_size(eventByte, &client->de_header_state)) break;
+            client->attribute_id = 0;
+            log_debug("ID data is stored in %d bytes.", (int) client->de_header_state.de_size);
+            client->parser_state = GET_ATTRIBUTE_ID;
             break;
         
         case GET_ATTRIBUTE_ID:
-            attribute_id = (attribute_id << 8) | eventByte;
-            de_header_state.de_size--;
-            if (de_header_state.de_size > 0) break;
-            log_debug("parser: Attribute ID: %04x.", attribute_id);
-
-            state = GET_ATTRIBUTE_VALUE_LENGTH;
-            attribute_bytes_received  = 0;
-            attribute_bytes_delivered = 0;
-            attribute_value_size      = 0;
-            de_state_init(&de_header_state);
+            client->attribute_id = (client->attribute_id << 8) | eventByte;
+            client->de_header_state.de_size--;
+            if (client->de_header_state.de_size > 0) break;
+            log_debug("parser: Attribute ID: %04x.", client->attribute_id);
+
+            client->parser_state = GET_ATTRIBUTE_VALUE_LENGTH;
+            client->attribute_bytes_received  = 0;
+            client->attribute_bytes_delivered = 0;
+            client->attribute_value_size      = 0;
+            de_state_init(&client->de_header_state);
             break;
         
         case GET_ATTRIBUTE_VALUE_LENGTH:
-            attribute_bytes_received++;
-            sdp_parser_emit_value_byte(eventByte);
-            attribute_bytes_delivered++;
-            if (!de_state_size(eventByte, &de_header_state)) break;
+            client->attribute_bytes_received++;
+            sdp_client_parser_emit_value_byte(client, eventByte);
+            client->attribute_bytes_delivered++;
+            if (!de_state_size(eventByte, &client->de_header_state)) break;
 
-            attribute_value_size = de_header_state.de_size + attribute_bytes_received;
+            client->attribute_value_size = client->de_header_state.de_size + client->attribute_bytes_received;
 
-            state = GET_ATTRIBUTE_VALUE;
+            client->parser_state = GET_ATTRIBUTE_VALUE;
             break;
         
         case GET_ATTRIBUTE_VALUE: 
-            attribute_bytes_received++;
-            sdp_parser_emit_value_byte(eventByte);
-            attribute_bytes_delivered++;
+            client->attribute_bytes_received++;
+            sdp_client_parser_emit_value_byte(client, eventByte);
+            client->attribute_bytes_delivered++;
             // log_debug("paser: attribute_bytes_received %u, attribute_value_size %u", attribute_bytes_received, attribute_value_size);
 
-            if (attribute_bytes_received < attribute_value_size) break;
+            if (client->attribute_bytes_received < client->attribute_value_size) break;
             // log_debug("parser: Record offset %u, record size %u", record_offset, record_size);
-            if (record_offset != record_size){
-                state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
+            if (client->record_offset != client->record_size){
+                client->parser_state = GET_ATTRIBUTE_ID_HEADER_LENGTH;
                 // log_debug("Get next attribute");
                 break;
             } 
-            record_offset = 0;
+            client->record_offset = 0;
             // log_debug("parser: List offset %u, list size %u", list_offset, list_size);
             
-            if (list_size > 0 && list_offset != list_size){
-                record_counter++;
-                state = GET_RECORD_LENGTH;
+            if (client->list_size > 0 && client->list_offset != client->list_size){
+                client->record_counter++;
+                client->parser_state = GET_RECORD_LENGTH;
                 log_debug("parser: END_OF_RECORD");
                 break;
             }
-            list_offset = 0;
-            de_state_init(&de_header_state);
-            state = GET_LIST_LENGTH;
-            record_counter = 0;
+            client->list_offset = 0;
+            de_state_init(&client->de_header_state);
+            client->parser_state = GET_LIST_LENGTH;
+            client->record_counter = 0;
             log_debug("parser: END_OF_RECORD & DONE");
             break;
         default:
@@ -259,103 +294,175 @@ static void sdp_parser_process_byte(uint8_t eventByte){
     }
 }
 
-void sdp_parser_init(btstack_packet_handler_t callback){
+static void sdp_client_parser_init(sdp_client_t * client, btstack_packet_handler_t callback){
     // init
-    sdp_parser_callback = callback;
-    de_state_init(&de_header_state);
-    state = GET_LIST_LENGTH;
-    list_offset = 0;
-    record_offset = 0;
-    record_counter = 0;
+    client->callback = callback;
+    de_state_init(&client->de_header_state);
+    client->parser_state = GET_LIST_LENGTH;
+    client->list_offset = 0;
+    client->record_offset = 0;
+    client->record_counter = 0;
 }
 
-void sdp_parser_handle_chunk(uint8_t * data, uint16_t size){
+static void sdp_client_parser_handle_chunk(sdp_client_t * client, uint8_t * data, uint16_t size){
     int i;
     for (i=0;i<size;i++){
-        sdp_parser_process_byte(data[i]);
+        sdp_client_parser_process_byte(client, data[i]);
     }
 }
 
 #ifdef ENABLE_SDP_EXTRA_QUERIES
-void sdp_parser_init_service_attribute_search(void){
+static void sdp_client_parser_init_service_attribute_search(sdp_client_t * client){
     // init
-    de_state_init(&de_header_state);
-    state = GET_RECORD_LENGTH;
-    list_offset = 0;
-    record_offset = 0;
-    record_counter = 0;
+    de_state_init(&client->de_header_state);
+    client->parser_state = GET_RECORD_LENGTH;
+    client->list_offset = 0;
+    client->record_offset = 0;
+    client->record_counter = 0;
 }
 
-void sdp_parser_init_service_search(void){
-    record_offset = 0;
+static void sdp_client_parser_init_service_search(sdp_client_t * client){
+    client->record_offset = 0;
 }
 
-void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
+static void sdp_client_parser_handle_service_search(sdp_client_t * client, uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
     int i;
     for (i=0;i<record_handle_count;i++){
-        record_handle = big_endian_read_32(data, i*4);
-        record_counter++;
+        client->record_handle = big_endian_read_32(data, i*4);
+        client->record_counter++;
         uint8_t event[10];
         event[0] = SDP_EVENT_QUERY_SERVICE_RECORD_HANDLE;
         event[1] = 8;
         little_endian_store_16(event, 2, total_count);
-        little_endian_store_16(event, 4, record_counter);
-        little_endian_store_32(event, 6, record_handle);
-        (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+        little_endian_store_16(event, 4, client->record_counter);
+        little_endian_store_32(event, 6, client->record_handle);
+        (*client->callback)(HCI_EVENT_PACKET, client->query_id, event, sizeof(event)); 
     }        
 }
 #endif
 
-void sdp_parser_handle_done(uint8_t status){
+static void sdp_client_parser_handle_done(sdp_client_t * client, uint8_t status){
     uint8_t event[3];
     event[0] = SDP_EVENT_QUERY_COMPLETE;
     event[1] = 1;
     event[2] = status;
-    (*sdp_parser_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event)); 
+    (*client->callback)(HCI_EVENT_PACKET, client->query_id, event, sizeof(event)); 
+}
+
+void sdp_parser_init(btstack_packet_handler_t callback){
+    sdp_client_parser_init(&sdp_clients[0], callback);
+}
+
+void sdp_parser_handle_chunk(uint8_t * data, uint16_t size){
+    sdp_client_parser_handle_chunk(&sdp_clients[0], data, size);
+}
+
+void sdp_parser_handle_done(uint8_t status){
+    sdp_client_parser_handle_done(&sdp_clients[0], status);
+}
+
+#ifdef ENABLE_SDP_EXTRA_QUERIES
+void sdp_parser_init_service_attribute_search(void){
+    sdp_client_parser_init_service_attribute_search(&sdp_clients[0]);
+}
+
+void sdp_parser_init_service_search(void){
+    sdp_client_parser_init_service_search(&sdp_clients[0]);
 }
 
+void sdp_parser_handle_service_search(uint8_t * data, uint16_t total_count, uint16_t record_handle_count){
+    sdp_client_parser_handle_service_search(&sdp_clients[0], data, total_count, record_handle_count);
+}
+#endif
+
 // SDP Client
 
+static sdp_client_t * sdp_client_for_cid(uint16_t cid){
+    int i;
+    for (i=0;i<MAX_NR_SDP_CLIENT_QUERIES;i++){
+        sdp_client_t * client = &sdp_clients[i];
+        if (client->state == INIT) continue;
+        if (client->cid != cid) continue;
+        return client;
+    }
+    return NULL;
+}
+
+static sdp_client_t * sdp_client_get_free_context(void){
+    int i;
+    for (i=0;i<MAX_NR_SDP_CLIENT_QUERIES;i++){
+        if (sdp_clients[i].state != INIT) continue;
+        sdp_clients[i].query_id = i + 1;
+        return &sdp_clients[i];
+    }
+    return NULL;
+}
+
+static void sdp_client_set_service_search_pattern(sdp_client_t * client, const uint8_t * des_service_search_pattern){
+    // copy short patterns, as sdp_service_search_pattern_for_uuid16/128 return a shared buffer
+    int len = de_get_len(des_service_search_pattern);
+    if (len > (int) sizeof(client->service_search_pattern_storage)){
+        client->service_search_pattern = des_service_search_pattern;
+        return;
+    }
+    memcpy(client->service_search_pattern_storage, des_service_search_pattern, len);
+    client->service_search_pattern = client->service_search_pattern_storage;
+}
+
+static uint8_t sdp_client_start_query(sdp_client_t * client, bd_addr_t remote, uint16_t * out_query_id){
+    client->continuation_state_len = 0;
+    client->state = W4_CONNECT;
+    uint8_t status = l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PROTOCOL_SDP, l2cap_max_mtu(), &client->cid);
+    if (status){
+        client->state = INIT;
+        return status;
+    }
+    if (out_query_id){
+        *out_query_id = client->query_id;
+    }
+    return ERROR_CODE_SUCCESS;
+}
+
 // TODO: inline if not needed (des(des))
 
-static void sdp_client_parse_attribute_lists(uint8_t* packet, uint16_t length){
-    sdp_parser_handle_chunk(packet, length);
+static void sdp_client_parse_attribute_lists(sdp_client_t * client, uint8_t* packet, uint16_t length){
+    sdp_client_parser_handle_chunk(client, packet, length);
 }
 
 
-static void sdp_client_send_request(uint16_t channel){
+static void sdp_client_send_request(sdp_client_t * client){
 
-    if (sdp_client_state != W2_SEND) return;
+    if (client->state != W2_SEND) return;
 
     l2cap_reserve_packet_buffer();
     uint8_t * data = l2cap_get_outgoing_buffer();
     uint16_t request_len = 0;
 
-    switch (PDU_ID){
+    switch (client->pdu_id){
 #ifdef ENABLE_SDP_EXTRA_QUERIES
         case SDP_ServiceSearchResponse:
-            request_len = sdp_client_setup_service_search_request(data);
+            request_len = sdp_client_setup_service_search_request(client, data);
             break;
         case SDP_ServiceAttributeResponse:
-            request_len = sdp_client_setup_service_attribute_request(data);
+            request_len = sdp_client_setup_service_attribute_request(client, data);
             break;
 #endif
         case SDP_ServiceSearchAttributeResponse:
-            request_len = sdp_client_setup_service_search_attribute_request(data);
+            request_len = sdp_client_setup_service_search_attribute_request(client, data);
             break;
         default:
-            log_error("SDP Client sdp_client_send_request :: PDU ID invalid. %u", PDU_ID);
+            log_error("SDP Client sdp_client_send_request :: PDU ID invalid. %u", client->pdu_id);
             return;
     }
 
     // prevent re-entrance
-    sdp_client_state = W4_RESPONSE;
-    PDU_ID = SDP_Invalid;
-    l2cap_send_prepared(channel, request_len);
+    client->state = W4_RESPONSE;
+    client->pdu_id = SDP_Invalid;
+    l2cap_send_prepared(client->cid, request_len);
 }
 
 
-static void sdp_client_parse_service_search_attribute_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_search_attribute_response(sdp_client_t * client, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if (offset + 2 + 2 > size) return;  // parameterLength + attributeListByteCount
@@ -366,75 +473,82 @@ static void sdp_client_parse_service_search_attribute_response(uint8_t* packet,
     // AttributeListByteCount <= mtu
     uint16_t attributeListByteCount = big_endian_read_16(packet,offset);
     offset+=2;
-    if (attributeListByteCount > mtu){
+    if (attributeListByteCount > client->mtu){
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in found attribute list is larger then the MaximumAttributeByteCount.");
         return;
     }
 
     // AttributeLists
     if (offset + attributeListByteCount > size) return;
-    sdp_client_parse_attribute_lists(packet+offset, attributeListByteCount);
+    sdp_client_parse_attribute_lists(client, packet+offset, attributeListByteCount);
     offset+=attributeListByteCount;
 
     // continuation state len
     if (offset + 1 > size) return;
-    continuationStateLen = packet[offset];
+    client->continuation_state_len = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (client->continuation_state_len > 16){
+        client->continuation_state_len = 0;
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
 
     // continuation state
-    if (offset + continuationStateLen > size) return;
-    memcpy(continuationState, packet+offset, continuationStateLen);
+    if (offset + client->continuation_state_len > size) return;
+    memcpy(client->continuation_state, packet+offset, client->continuation_state_len);
     // offset+=continuationStateLen;
 }
 
-void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+static void sdp_client_handle_l2cap_data(sdp_client_t * client, uint8_t *packet, uint16_t size){
+    if (size < 3) return;
+    uint16_t responseTransactionID = big_endian_read_16(packet,1);
+    if (responseTransactionID != client->transaction_id){
+        log_error("Mismatching transaction ID, expected %u, found %u.", client->transaction_id, responseTransactionID);
+        return;
+    } 
     
-    // uint16_t handle;
-    if (packet_type == L2CAP_DATA_PACKET){
-        if (size < 3) return;
-        uint16_t responseTransactionID = big_endian_read_16(packet,1);
-        if (responseTransactionID != transactionID){
-            log_error("Mismatching transaction ID, expected %u, found %u.", transactionID, responseTransactionID);
+    client->pdu_id = (SDP_PDU_ID_t)packet[0];
+    switch (client->pdu_id){
+        case SDP_ErrorResponse:
+            log_error("Received error response with code %u, disconnecting", packet[2]);
+            l2cap_disconnect(client->cid, 0);
             return;
-        } 
-        
-        PDU_ID = (SDP_PDU_ID_t)packet[0];
-        switch (PDU_ID){
-            case SDP_ErrorResponse:
-                log_error("Received error response with code %u, disconnecting", packet[2]);
-                l2cap_disconnect(sdp_cid, 0);
-                return;
 #ifdef ENABLE_SDP_EXTRA_QUERIES
-            case SDP_ServiceSearchResponse:
-                sdp_client_parse_service_search_response(packet, size);
-                break;
-            case SDP_ServiceAttributeResponse:
-                sdp_client_parse_service_attribute_response(packet, size);
-                break;
+        case SDP_ServiceSearchResponse:
+            sdp_client_parse_service_search_response(client, packet, size);
+            break;
+        case SDP_ServiceAttributeResponse:
+            sdp_client_parse_service_attribute_response(client, packet, size);
+            break;
 #endif
-            case SDP_ServiceSearchAttributeResponse:
-                sdp_client_parse_service_search_attribute_response(packet, size);
-                break;
-            default:
-                log_error("PDU ID %u unexpected/invalid", PDU_ID);
-                return;
-        }
-
-        // continuation set or DONE?
-        if (continuationStateLen == 0){
-            log_debug("SDP Client Query DONE! ");
-            sdp_client_state = QUERY_COMPLETE;
-            l2cap_disconnect(sdp_cid, 0);
+        case SDP_ServiceSearchAttributeResponse:
+            sdp_client_parse_service_search_attribute_response(client, packet, size);
+            break;
+        default:
+            log_error("PDU ID %u unexpected/invalid", client->pdu_id);
             return;
-        }
-        // prepare next request and send
-        sdp_client_state = W2_SEND;
-        l2cap_request_can_send_now_event(sdp_cid);
+    }
+
+    // continuation set or DONE?
+    if (client->continuation_state_len == 0){
+        log_debug("SDP Client Query DONE! ");
+        client->state = QUERY_COMPLETE;
+        l2cap_disconnect(client->cid, 0);
+        return;
+    }
+    // prepare next request and send
+    client->state = W2_SEND;
+    l2cap_request_can_send_now_event(client->cid);
+}
+
+void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size){
+    
+    sdp_client_t * client;
+
+    if (packet_type == L2CAP_DATA_PACKET){
+        client = sdp_client_for_cid(channel);
+        if (!client) return;
+        sdp_client_handle_l2cap_data(client, packet, size);
         return;
     }
     
@@ -442,37 +556,36 @@ void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
     
     switch(hci_event_packet_get_type(packet)){
         case L2CAP_EVENT_CHANNEL_OPENED:
-            if (sdp_client_state != W4_CONNECT) break;
+            client = sdp_client_for_cid(l2cap_event_channel_opened_get_local_cid(packet));
+            if (!client) break;
+            if (client->state != W4_CONNECT) break;
             // data: event (8), len(8), status (8), address(48), handle (16), psm (16), local_cid(16), remote_cid (16), local_mtu(16), remote_mtu(16) 
             if (packet[2]) {
                 log_info("SDP Client Connection failed, status 0x%02x.", packet[2]);
-                sdp_client_state = INIT;
-                sdp_parser_handle_done(packet[2]);
+                client->state = INIT;
+                sdp_client_parser_handle_done(client, packet[2]);
                 break;
             }
-            sdp_cid = channel;
-            mtu = little_endian_read_16(packet, 17);
+            client->mtu = little_endian_read_16(packet, 17);
             // handle = little_endian_read_16(packet, 9);
-            log_debug("SDP Client Connected, cid %x, mtu %u.", sdp_cid, mtu);
+            log_debug("SDP Client Connected, cid %x, mtu %u.", client->cid, client->mtu);
 
-            sdp_client_state = W2_SEND;
-            l2cap_request_can_send_now_event(sdp_cid);
+            client->state = W2_SEND;
+            l2cap_request_can_send_now_event(client->cid);
             break;
 
         case L2CAP_EVENT_CAN_SEND_NOW:
-            if(l2cap_event_can_send_now_get_local_cid(packet) == sdp_cid){
-                sdp_client_send_request(sdp_cid);
-            }
+            client = sdp_client_for_cid(l2cap_event_can_send_now_get_local_cid(packet));
+            if (!client) break;
+            sdp_client_send_request(client);
             break;
         case L2CAP_EVENT_CHANNEL_CLOSED: {
-            if (sdp_cid != little_endian_read_16(packet, 2)) {
-                // log_info("Received L2CAP_EVENT_CHANNEL_CLOSED for cid %x, current cid %x\n",  little_endian_read_16(packet, 2),sdp_cid);
-                break;
-            }
+            client = sdp_client_for_cid(l2cap_event_channel_closed_get_local_cid(packet));
+            if (!client) break;
             log_info("SDP Client disconnected.");
-            uint8_t status = sdp_client_state == QUERY_COMPLETE ? 0 : SDP_QUERY_INCOMPLETE;
-            sdp_client_state = INIT;
-            sdp_parser_handle_done(status);
+            uint8_t status = client->state == QUERY_COMPLETE ? 0 : SDP_QUERY_INCOMPLETE;
+            client->state = INIT;
+            sdp_client_parser_handle_done(client, status);
             break;
         }
         default:
@@ -481,14 +594,14 @@ void sdp_client_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *p
 }
 
 
-static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_search_attribute_request(sdp_client_t * client, uint8_t * data){
 
     uint16_t offset = 0;
-    transactionID++;
+    client->transaction_id++;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceSearchAttributeRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, client->transaction_id);
     offset += 2;
 
     // param legnth
@@ -496,24 +609,24 @@ static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data
 
     // parameters: 
     //     Service_search_pattern - DES (min 1 UUID, max 12)
-    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
-    memcpy(data + offset, service_search_pattern, service_search_pattern_len);
+    uint16_t service_search_pattern_len = de_get_len(client->service_search_pattern);
+    memcpy(data + offset, client->service_search_pattern, service_search_pattern_len);
     offset += service_search_pattern_len;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, client->mtu);
     offset += 2;
 
     //     AttibuteIDList  
-    uint16_t attribute_id_list_len = de_get_len(attribute_id_list);
-    memcpy(data + offset, attribute_id_list, attribute_id_list_len);
+    uint16_t attribute_id_list_len = de_get_len(client->attribute_id_list);
+    memcpy(data + offset, client->attribute_id_list, attribute_id_list_len);
     offset += attribute_id_list_len;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = client->continuation_state_len;
     //                       - N-bytes previous response from server
-    memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    memcpy(data + offset, client->continuation_state, client->continuation_state_len);
+    offset += client->continuation_state_len;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -523,16 +636,16 @@ static uint16_t sdp_client_setup_service_search_attribute_request(uint8_t * data
 
 #ifdef ENABLE_SDP_EXTRA_QUERIES
 void sdp_client_parse_service_record_handle_list(uint8_t* packet, uint16_t total_count, uint16_t current_count){
-    sdp_parser_handle_service_search(packet, total_count, current_count);
+    sdp_client_parser_handle_service_search(&sdp_clients[0], packet, total_count, current_count);
 }
 
-static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_search_request(sdp_client_t * client, uint8_t * data){
     uint16_t offset = 0;
-    transactionID++;
+    client->transaction_id++;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceSearchRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, client->transaction_id);
     offset += 2;
 
     // param legnth
@@ -540,19 +653,19 @@ static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
 
     // parameters: 
     //     Service_search_pattern - DES (min 1 UUID, max 12)
-    uint16_t service_search_pattern_len = de_get_len(service_search_pattern);
-    memcpy(data + offset, service_search_pattern, service_search_pattern_len);
+    uint16_t service_search_pattern_len = de_get_len(client->service_search_pattern);
+    memcpy(data + offset, client->service_search_pattern, service_search_pattern_len);
     offset += service_search_pattern_len;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, client->mtu);
     offset += 2;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = client->continuation_state_len;
     //                       - N-bytes previous response from server
-    memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    memcpy(data + offset, client->continuation_state, client->continuation_state_len);
+    offset += client->continuation_state_len;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -561,14 +674,14 @@ static uint16_t sdp_client_setup_service_search_request(uint8_t * data){
 }
 
 
-static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
+static uint16_t sdp_client_setup_service_attribute_request(sdp_client_t * client, uint8_t * data){
 
     uint16_t offset = 0;
-    transactionID++;
+    client->transaction_id++;
     // uint8_t SDP_PDU_ID_t.SDP_ServiceSearchRequest;
     data[offset++] = SDP_ServiceAttributeRequest;
     // uint16_t transactionID
-    big_endian_store_16(data, offset, transactionID);
+    big_endian_store_16(data, offset, client->transaction_id);
     offset += 2;
 
     // param legnth
@@ -576,23 +689,23 @@ static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
 
     // parameters: 
     //     ServiceRecordHandle
-    big_endian_store_32(data, offset, serviceRecordHandle);
+    big_endian_store_32(data, offset, client->service_record_handle);
     offset += 4;
 
     //     MaximumAttributeByteCount - uint16_t  0x0007 - 0xffff -> mtu
-    big_endian_store_16(data, offset, mtu);
+    big_endian_store_16(data, offset, client->mtu);
     offset += 2;
 
     //     AttibuteIDList  
-    uint16_t attribute_id_list_len = de_get_len(attribute_id_list);
-    memcpy(data + offset, attribute_id_list, attribute_id_list_len);
+    uint16_t attribute_id_list_len = de_get_len(client->attribute_id_list);
+    memcpy(data + offset, client->attribute_id_list, attribute_id_list_len);
     offset += attribute_id_list_len;
 
     //     ContinuationState - uint8_t number of cont. bytes N<=16 
-    data[offset++] = continuationStateLen;
+    data[offset++] = client->continuation_state_len;
     //                       - N-bytes previous response from server
-    memcpy(data + offset, continuationState, continuationStateLen);
-    offset += continuationStateLen;
+    memcpy(data + offset, client->continuation_state, client->continuation_state_len);
+    offset += client->continuation_state_len;
 
     // uint16_t paramLength 
     big_endian_store_16(data, 3, offset - 5);
@@ -600,7 +713,7 @@ static uint16_t sdp_client_setup_service_attribute_request(uint8_t * data){
     return offset;
 }
 
-static void sdp_client_parse_service_search_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_search_response(sdp_client_t * client, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if (offset + 2 + 2 + 2 > size) return;  // parameterLength, totalServiceRecordCount, currentServiceRecordCount
@@ -620,23 +733,23 @@ static void sdp_client_parse_service_search_response(uint8_t* packet, uint16_t s
     }
     
     if (offset + currentServiceRecordCount * 4 > size) return;
-    sdp_client_parse_service_record_handle_list(packet+offset, totalServiceRecordCount, currentServiceRecordCount);
+    sdp_client_parser_handle_service_search(client, packet+offset, totalServiceRecordCount, currentServiceRecordCount);
     offset+= currentServiceRecordCount * 4;
 
     if (offset + 1 > size) return;
-    continuationStateLen = packet[offset];
+    client->continuation_state_len = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (client->continuation_state_len > 16){
+        client->continuation_state_len = 0;
         log_error("Error parsing ServiceSearchResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
-    if (offset + continuationStateLen > size) return;
-    memcpy(continuationState, packet+offset, continuationStateLen);
+    if (offset + client->continuation_state_len > size) return;
+    memcpy(client->continuation_state, packet+offset, client->continuation_state_len);
     // offset+=continuationStateLen;
 }
 
-static void sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_t size){
+static void sdp_client_parse_service_attribute_response(sdp_client_t * client, uint8_t* packet, uint16_t size){
 
     uint16_t offset = 3;
     if (offset + 2 + 2 > size) return;  // parameterLength, attributeListByteCount
@@ -647,53 +760,185 @@ static void sdp_client_parse_service_attribute_response(uint8_t* packet, uint16_
     // AttributeListByteCount <= mtu
     uint16_t attributeListByteCount = big_endian_read_16(packet,offset);
     offset+=2;
-    if (attributeListByteCount > mtu){
+    if (attributeListByteCount > client->mtu){
         log_error("Error parsing ServiceSearchAttributeResponse: Number of bytes in found attribute list is larger then the MaximumAttributeByteCount.");
         return;
     }
 
     // AttributeLists
     if (offset+attributeListByteCount > size) return;
-    sdp_client_parse_attribute_lists(packet+offset, attributeListByteCount);
+    sdp_client_parse_attribute_lists(client, packet+offset, attributeListByteCount);
     offset+=attributeListByteCount;
 
     // continuationStateLen
     if (offset + 1 > size) return;
-    continuationStateLen = packet[offset];
+    client->continuation_state_len = packet[offset];
     offset++;
-    if (continuationStateLen > 16){
-        continuationStateLen = 0;
+    if (client->continuation_state_len > 16){
+        client->continuation_state_len = 0;
         log_error("Error parsing ServiceAttributeResponse: Number of bytes in continuation state exceedes 16.");
         return;
     }
-    if (offset + continuationStateLen > size) return;
-    memcpy(continuationState, packet+offset, continuationStateLen);
+    if (offset + client->continuation_state_len > size) return;
+    memcpy(client->continuation_state, packet+offset, client->continuation_state_len);
     // offset+=continuationStateLen;
 }
 #endif
 
+#ifdef ENABLE_SDP_CLIENT_CACHE
+
+static uint32_t sdp_client_cache_tag_for_index(int index){
+    return (sdp_client_cache_tag_0 << 24) | (sdp_client_cache_tag_1 << 16) | (sdp_client_cache_tag_2 << 8) | index;
+}
+
+// read all entries from TLV once, all lookups are served from RAM afterwards
+static void sdp_client_cache_load(void){
+    if (sdp_client_cache_loaded) return;
+
+    // retry on next access if TLV is not registered yet
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    sdp_client_cache_loaded = 1;
+
+    memset(sdp_client_cache_items, 0, sizeof(sdp_client_cache_items));
+    sdp_client_cache_highest_seq_nr = 0;
+
+    int index;
+    for (index=0;index<NVM_NUM_SDP_CLIENT_CACHE_ENTRIES;index++){
+        sdp_client_cache_item_t * item = &sdp_client_cache_items[index];
+        uint32_t tag = sdp_client_cache_tag_for_index(index);
+        int len = tlv_impl->get_tag(tlv_context, tag, (uint8_t *) item, sizeof(sdp_client_cache_item_t));
+        if (len != sizeof(sdp_client_cache_item_t)){
+            item->seq_nr = 0;
+            continue;
+        }
+        if (item->seq_nr > sdp_client_cache_highest_seq_nr){
+            sdp_client_cache_highest_seq_nr = item->seq_nr;
+        }
+    }
+}
+
+static void sdp_client_cache_persist(int index){
+    const btstack_tlv_t * tlv_impl = NULL;
+    void * tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) return;
+    uint32_t tag = sdp_client_cache_tag_for_index(index);
+    if (sdp_client_cache_items[index].seq_nr == 0){
+        tlv_impl->delete_tag(tlv_context, tag);
+    } else {
+        tlv_impl->store_tag(tlv_context, tag, (const uint8_t *) &sdp_client_cache_items[index], sizeof(sdp_client_cache_item_t));
+    }
+}
+
+static int sdp_client_cache_index_for_service(bd_addr_t addr, uint16_t service_uuid){
+    int index;
+    for (index=0;index<NVM_NUM_SDP_CLIENT_CACHE_ENTRIES;index++){
+        sdp_client_cache_item_t * item = &sdp_client_cache_items[index];
+        if (item->seq_nr == 0) continue;
+        if (item->entry.service_uuid != service_uuid) continue;
+        if (bd_addr_cmp(item->entry.addr, addr)) continue;
+        return index;
+    }
+    return -1;
+}
+
+int sdp_client_cache_get(bd_addr_t addr, uint16_t service_uuid, sdp_client_cache_entry_t * entry){
+    sdp_client_cache_load();
+    int index = sdp_client_cache_index_for_service(addr, service_uuid);
+    if (index < 0) return 0;
+    *entry = sdp_client_cache_items[index].entry;
+    return 1;
+}
+
+// compare fields, struct padding is not initialized by callers
+static int sdp_client_cache_entry_equal(const sdp_client_cache_entry_t * a, const sdp_client_cache_entry_t * b){
+    if (bd_addr_cmp(a->addr, b->addr)) return 0;
+    if (a->service_uuid       != b->service_uuid)       return 0;
+    if (a->l2cap_psm          != b->l2cap_psm)          return 0;
+    if (a->supported_features != b->supported_features) return 0;
+    if (a->rfcomm_channel_nr  != b->rfcomm_channel_nr)  return 0;
+    return 1;
+}
+
+void sdp_client_cache_store(const sdp_client_cache_entry_t * entry){
+    sdp_client_cache_load();
+
+    // update existing entry, use empty one, or evict least recently stored one
+    int index = sdp_client_cache_index_for_service((uint8_t *) entry->addr, entry->service_uuid);
+    if (index < 0){
+        int i;
+        uint32_t lowest_seq_nr = 0;
+        for (i=0;i<NVM_NUM_SDP_CLIENT_CACHE_ENTRIES;i++){
+            uint32_t seq_nr = sdp_client_cache_items[i].seq_nr;
+            if (index < 0 || seq_nr < lowest_seq_nr){
+                index = i;
+                lowest_seq_nr = seq_nr;
+            }
+            if (seq_nr == 0) break;
+        }
+    } else if (sdp_client_cache_entry_equal(&sdp_client_cache_items[index].entry, entry)){
+        // unchanged
+        return;
+    }
+
+    log_info("SDP Client Cache: store %s, uuid 0x%04x at index %u", bd_addr_to_str((uint8_t *) entry->addr), entry->service_uuid, index);
+    sdp_client_cache_items[index].seq_nr = ++sdp_client_cache_highest_seq_nr;
+    sdp_client_cache_items[index].entry  = *entry;
+    sdp_client_cache_persist(index);
+}
+
+void sdp_client_cache_invalidate(bd_addr_t addr){
+    sdp_client_cache_load();
+    int index;
+    for (index=0;index<NVM_NUM_SDP_CLIENT_CACHE_ENTRIES;index++){
+        sdp_client_cache_item_t * item = &sdp_client_cache_items[index];
+        if (item->seq_nr == 0) continue;
+        if (bd_addr_cmp(item->entry.addr, addr)) continue;
+        log_info("SDP Client Cache: invalidate %s, uuid 0x%04x", bd_addr_to_str(addr), item->entry.service_uuid);
+        item->seq_nr = 0;
+        sdp_client_cache_persist(index);
+    }
+}
+#endif
+
 // for testing only
 void sdp_client_reset(void){
-    sdp_client_state = INIT;
+    int i;
+    for (i=0;i<MAX_NR_SDP_CLIENT_QUERIES;i++){
+        sdp_clients[i].state = INIT;
+    }
+#ifdef ENABLE_SDP_CLIENT_CACHE
+    sdp_client_cache_loaded = 0;
+#endif
 }
 
 // Public API
 
 int sdp_client_ready(void){
-    return sdp_client_state == INIT;
+    int i;
+    for (i=0;i<MAX_NR_SDP_CLIENT_QUERIES;i++){
+        if (sdp_clients[i].state == INIT) return 1;
+    }
+    return 0;
 }
 
-uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list){
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
+uint8_t sdp_client_query_with_query_id(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list, uint16_t * out_query_id){
+    sdp_client_t * client = sdp_client_get_free_context();
+    if (!client) return SDP_QUERY_BUSY;
+
+    sdp_client_parser_init(client, callback);
+    sdp_client_set_service_search_pattern(client, des_service_search_pattern);
+    client->attribute_id_list = des_attribute_id_list;
+    client->pdu_id = SDP_ServiceSearchAttributeResponse;
 
-    sdp_parser_init(callback);
-    service_search_pattern = des_service_search_pattern;
-    attribute_id_list = des_attribute_id_list;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceSearchAttributeResponse;
+    return sdp_client_start_query(client, remote, out_query_id);
+}
 
-    sdp_client_state = W4_CONNECT;
-    return l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PROTOCOL_SDP, l2cap_max_mtu(), NULL);
+uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list){
+    return sdp_client_query_with_query_id(callback, remote, des_service_search_pattern, des_attribute_id_list, NULL);
 }
 
 uint8_t sdp_client_query_uuid16(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid){
@@ -708,31 +953,25 @@ uint8_t sdp_client_query_uuid128(btstack_packet_handler_t callback, bd_addr_t re
 
 #ifdef ENABLE_SDP_EXTRA_QUERIES
 uint8_t sdp_client_service_attribute_search(btstack_packet_handler_t callback, bd_addr_t remote, uint32_t search_service_record_handle, const uint8_t * des_attribute_id_list){
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
+    sdp_client_t * client = sdp_client_get_free_context();
+    if (!client) return SDP_QUERY_BUSY;
 
-    sdp_parser_init(callback);
-    serviceRecordHandle = search_service_record_handle;
-    attribute_id_list = des_attribute_id_list;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceAttributeResponse;
+    sdp_client_parser_init(client, callback);
+    client->service_record_handle = search_service_record_handle;
+    client->attribute_id_list = des_attribute_id_list;
+    client->pdu_id = SDP_ServiceAttributeResponse;
 
-    sdp_client_state = W4_CONNECT;
-    l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PROTOCOL_SDP, l2cap_max_mtu(), NULL);
-    return 0;
+    return sdp_client_start_query(client, remote, NULL);
 }
 
 uint8_t sdp_client_service_search(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern){
+    sdp_client_t * client = sdp_client_get_free_context();
+    if (!client) return SDP_QUERY_BUSY;
 
-    if (!sdp_client_ready()) return SDP_QUERY_BUSY;
-
-    sdp_parser_init(callback);
-    service_search_pattern = des_service_search_pattern;
-    continuationStateLen = 0;
-    PDU_ID = SDP_ServiceSearchResponse;
+    sdp_client_parser_init(client, callback);
+    sdp_client_set_service_search_pattern(client, des_service_search_pattern);
+    client->pdu_id = SDP_ServiceSearchResponse;
 
-    sdp_client_state = W4_CONNECT;
-    l2cap_create_channel(sdp_client_packet_handler, remote, BLUETOOTH_PROTOCOL_SDP, l2cap_max_mtu(), NULL);
-    return 0;
+    return sdp_client_start_query(client, remote, NULL);
 }
 #endif
-
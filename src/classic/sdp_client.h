@@ -50,6 +50,11 @@
 extern "C" {
 #endif
 
+// MAX_NR_SDP_CLIENT_QUERIES defines number of SDP queries that can be active at the same time
+#ifndef MAX_NR_SDP_CLIENT_QUERIES
+#define MAX_NR_SDP_CLIENT_QUERIES 1
+#endif
+
 /* API_START */
 
 typedef struct de_state {
@@ -62,9 +67,17 @@ typedef struct de_state {
 void de_state_init(de_state_t * state);
 int  de_state_size(uint8_t eventByte, de_state_t *de_state);
 
+typedef struct {
+    bd_addr_t addr;
+    uint16_t  service_uuid;
+    uint16_t  l2cap_psm;
+    uint16_t  supported_features;
+    uint8_t   rfcomm_channel_nr;
+} sdp_client_cache_entry_t;
+
 /** 
  * @brief Checks if the SDP Client is ready
- * @return 1 when no query is active
+ * @return 1 when another query can be started, up to MAX_NR_SDP_CLIENT_QUERIES queries can be active at the same time
  */
 int sdp_client_ready(void);
 
@@ -78,6 +91,17 @@ int sdp_client_ready(void);
  */
 uint8_t sdp_client_query(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list);
 
+/** 
+ * @brief Queries the SDP service of the remote device like sdp_client_query and provides the query id.
+ * All events of this query are delivered with the query id as channel parameter, which allows to run queries in parallel.
+ * @param callback for attributes values and done event
+ * @param remote address
+ * @param des_service_search_pattern 
+ * @param des_attribute_id_list
+ * @param out_query_id
+ */
+uint8_t sdp_client_query_with_query_id(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern, const uint8_t * des_attribute_id_list, uint16_t * out_query_id);
+
 /*
  * @brief Searches SDP records on a remote device for all services with a given UUID.
  * @note calls sdp_client_query with service search pattern based on uuid16
@@ -112,6 +136,30 @@ uint8_t sdp_client_service_attribute_search(btstack_packet_handler_t callback, b
  */
 uint8_t sdp_client_service_search(btstack_packet_handler_t callback, bd_addr_t remote, const uint8_t * des_service_search_pattern);
 
+/**
+ * @brief Get cached SDP result for remote device and service
+ * @note only provided if ENABLE_SDP_CLIENT_CACHE is defined
+ * @param addr
+ * @param service_uuid
+ * @param entry
+ * @return 1 if found
+ */
+int sdp_client_cache_get(bd_addr_t addr, uint16_t service_uuid, sdp_client_cache_entry_t * entry);
+
+/**
+ * @brief Store SDP result for remote device and service. Entries are persisted via btstack_tlv if available.
+ * @note only provided if ENABLE_SDP_CLIENT_CACHE is defined
+ * @param entry
+ */
+void sdp_client_cache_store(const sdp_client_cache_entry_t * entry);
+
+/**
+ * @brief Remove all cached SDP results for remote device, e.g. if connecting with a cached value failed
+ * @note only provided if ENABLE_SDP_CLIENT_CACHE is defined
+ * @param addr
+ */
+void sdp_client_cache_invalidate(bd_addr_t addr);
+
 #ifdef ENABLE_SDP_EXTRA_QUERIES
 void sdp_client_parse_service_record_handle_list(uint8_t* packet, uint16_t total_count, uint16_t current_count);
 #endif
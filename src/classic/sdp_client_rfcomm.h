@@ -58,6 +58,13 @@ extern "C" {
  */
 uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid);
 
+/** 
+ * @brief Searches SDP records on a remote device for RFCOMM services with a given 16-bit UUID and provides the query id.
+ * All events of this query are delivered with the query id as channel parameter.
+ * @note if ENABLE_SDP_CLIENT_CACHE is defined, found RFCOMM channels are stored in the SDP Client Cache
+ */
+uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid_with_query_id(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid, uint16_t * out_query_id);
+
 /** 
  * @brief Searches SDP records on a remote device for RFCOMM services with a given 128-bit UUID.
  * @note calls sdp_service_search_pattern_for_uuid128 that uses global buffer
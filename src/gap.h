@@ -43,6 +43,7 @@ extern "C" {
 #endif
 
 #include "btstack_defines.h"
+#include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "classic/btstack_link_key_db.h"
 
@@ -113,6 +114,53 @@ typedef enum {
 } authorization_state_t;
 
 
+// LE Extended Advertising parameters, see LE Set Extended Advertising Parameters command
+typedef struct {
+    uint16_t  advertising_event_properties;
+    uint32_t  primary_advertising_interval_min;   // unit: 0.625 ms
+    uint32_t  primary_advertising_interval_max;   // unit: 0.625 ms
+    uint8_t   primary_advertising_channel_map;
+    uint8_t   own_address_type;
+    uint8_t   peer_address_type;
+    bd_addr_t peer_address;
+    uint8_t   advertising_filter_policy;
+    int8_t    advertising_tx_power;               // 127 = no preference
+    uint8_t   primary_advertising_phy;            // LE_PHY_1M or LE_PHY_CODED
+    uint8_t   secondary_advertising_max_skip;
+    uint8_t   secondary_advertising_phy;          // LE_PHY_1M, LE_PHY_2M or LE_PHY_CODED
+    uint8_t   advertising_sid;
+    uint8_t   scan_request_notification_enable;
+} le_extended_advertising_parameters_t;
+
+// LE Periodic Advertising parameters, see LE Set Periodic Advertising Parameters command
+typedef struct {
+    uint16_t periodic_advertising_interval_min;   // unit: 1.25 ms
+    uint16_t periodic_advertising_interval_max;   // unit: 1.25 ms
+    uint16_t periodic_advertising_properties;
+} le_periodic_advertising_parameters_t;
+
+// LE Advertising Set, storage provided by application
+typedef struct {
+    btstack_linked_item_t item;
+    uint8_t  advertising_handle;
+    uint8_t  state;     // LE_ADVERTISEMENT_STATE_*
+    uint16_t tasks;     // LE_ADVERTISEMENT_TASKS_*
+    le_extended_advertising_parameters_t extended_params;
+    le_periodic_advertising_parameters_t periodic_params;
+    // data is not copied
+    const uint8_t * adv_data;
+    uint16_t        adv_data_len;
+    uint16_t        adv_data_pos;
+    const uint8_t * scan_data;
+    uint16_t        scan_data_len;
+    uint16_t        scan_data_pos;
+    const uint8_t * periodic_data;
+    uint16_t        periodic_data_len;
+    uint16_t        periodic_data_pos;
+    uint16_t        enable_timeout;
+    uint8_t         enable_max_events;
+} le_advertising_set_t;
+
 /* API_START */
 
 // Classic + LE
@@ -215,6 +263,8 @@ void gap_set_scan_parameters(uint8_t scan_type, uint16_t scan_interval, uint16_t
 
 /**
  * @brief Start LE Scan 
+ * @note With ENABLE_LE_EXTENDED_ADVERTISING and a Bluetooth 5.0 Controller, Extended Scanning is used. Legacy advertisements
+ *       are reported as GAP_EVENT_ADVERTISING_REPORT, extended advertisements as GAP_EVENT_EXTENDED_ADVERTISING_REPORT
  */
 void gap_start_scan(void);
 
@@ -288,6 +338,98 @@ void gap_advertisements_enable(int enabled);
  */
 void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t * scan_response_data);
 
+/**
+ * @brief Setup LE Extended Advertising Set. Requires ENABLE_LE_EXTENDED_ADVERTISING and Bluetooth 5.0 Controller
+ * @param storage for advertising set
+ * @param advertising_parameters
+ * @param out_advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_setup(le_advertising_set_t * storage, const le_extended_advertising_parameters_t * advertising_parameters, uint8_t * out_advertising_handle);
+
+/**
+ * @brief Set LE Extended Advertising Parameters
+ * @param advertising_handle
+ * @param advertising_parameters
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_params(uint8_t advertising_handle, const le_extended_advertising_parameters_t * advertising_parameters);
+
+/**
+ * @brief Set LE Extended Advertising Data
+ * @param advertising_handle
+ * @param advertising_data_length up to 1650 octets, split into multiple HCI Commands
+ * @param advertising_data
+ * @note data is not copied, pointer has to stay valid
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_adv_data(uint8_t advertising_handle, uint16_t advertising_data_length, const uint8_t * advertising_data);
+
+/**
+ * @brief Set LE Extended Scan Response Data
+ * @param advertising_handle
+ * @param scan_response_data_length up to 1650 octets, split into multiple HCI Commands
+ * @param scan_response_data
+ * @note data is not copied, pointer has to stay valid
+ * @return status
+ */
+uint8_t gap_extended_advertising_set_scan_response_data(uint8_t advertising_handle, uint16_t scan_response_data_length, const uint8_t * scan_response_data);
+
+/**
+ * @brief Start LE Extended Advertising. HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED is emitted when advertising ends
+ * @param advertising_handle
+ * @param timeout in 10ms, or 0 = no timeout
+ * @param num_extended_advertising_events max number of events, or 0 = no limit
+ * @return status
+ */
+uint8_t gap_extended_advertising_start(uint8_t advertising_handle, uint16_t timeout, uint8_t num_extended_advertising_events);
+
+/**
+ * @brief Stop LE Extended Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_stop(uint8_t advertising_handle);
+
+/**
+ * @brief Stop and remove LE Extended Advertising Set. Storage can be reused after LE Remove Advertising Set command was sent
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_extended_advertising_remove(uint8_t advertising_handle);
+
+/**
+ * @brief Set LE Periodic Advertising Parameters for advertising set
+ * @param advertising_handle
+ * @param advertising_parameters
+ * @return status
+ */
+uint8_t gap_periodic_advertising_set_params(uint8_t advertising_handle, const le_periodic_advertising_parameters_t * advertising_parameters);
+
+/**
+ * @brief Set LE Periodic Advertising Data
+ * @param advertising_handle
+ * @param periodic_data_length up to 1650 octets, split into multiple HCI Commands
+ * @param periodic_data
+ * @note data is not copied, pointer has to stay valid
+ * @return status
+ */
+uint8_t gap_periodic_advertising_set_data(uint8_t advertising_handle, uint16_t periodic_data_length, const uint8_t * periodic_data);
+
+/**
+ * @brief Start LE Periodic Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_periodic_advertising_start(uint8_t advertising_handle);
+
+/**
+ * @brief Stop LE Periodic Advertising
+ * @param advertising_handle
+ * @return status
+ */
+uint8_t gap_periodic_advertising_stop(uint8_t advertising_handle);
+
 /**
  * @brief Set connection parameters for outgoing connections
  * @param conn_scan_interval (unit: 0.625 msec), default: 60 ms
@@ -327,6 +469,58 @@ int gap_request_connection_parameter_update(hci_con_handle_t con_handle, uint16_
 int gap_update_connection_parameters(hci_con_handle_t con_handle, uint16_t conn_interval_min,
 	uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout);
 
+/**
+ * @brief Request PHY change for a given LE connection. Result reported in HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE
+ * @param con_handle
+ * @param all_phys bit 0: no preference for tx, bit 1: no preference for rx
+ * @param tx_phys bitmask of LE_PHY_MASK_1M, LE_PHY_MASK_2M, LE_PHY_MASK_CODED
+ * @param rx_phys bitmask of LE_PHY_MASK_1M, LE_PHY_MASK_2M, LE_PHY_MASK_CODED
+ * @param phy_options for Coded PHY: 0 = no preference, 1 = S=2, 2 = S=8
+ * @returns 0 if ok
+ */
+uint8_t gap_le_set_phy(hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys, uint16_t phy_options);
+
+/**
+ * @brief Request max tx octets and time for a given LE connection. Result reported in HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE
+ * @param con_handle
+ * @param tx_octets 27..251
+ * @param tx_time 328..17040 (unit: us)
+ * @returns 0 if ok
+ */
+uint8_t gap_le_set_data_length(hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time);
+
+/**
+ * @brief Request 2M PHY and max data length for a given LE connection
+ * @param con_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_le_request_high_throughput(hci_con_handle_t con_handle);
+
+/**
+ * @brief Request Coded PHY (S=8) and max data length for a given LE connection
+ * @param con_handle
+ * @returns 0 if ok
+ */
+uint8_t gap_le_request_long_range(hci_con_handle_t con_handle);
+
+/**
+ * @brief Get current PHY of a given LE connection
+ * @param con_handle
+ * @param tx_phy LE_PHY_1M, LE_PHY_2M or LE_PHY_CODED
+ * @param rx_phy LE_PHY_1M, LE_PHY_2M or LE_PHY_CODED
+ * @returns 0 if ok
+ */
+uint8_t gap_le_get_phy(hci_con_handle_t con_handle, uint8_t * tx_phy, uint8_t * rx_phy);
+
+/**
+ * @brief Get current max tx and rx payload octets of a given LE connection
+ * @param con_handle
+ * @param max_tx_octets
+ * @param max_rx_octets
+ * @returns 0 if ok
+ */
+uint8_t gap_le_get_data_length(hci_con_handle_t con_handle, uint16_t * max_tx_octets, uint16_t * max_rx_octets);
+
 /**
  * @brief Set accepted connection parameter range
  * @param range
@@ -388,6 +582,13 @@ int gap_auto_connection_stop(bd_addr_type_t address_typ, bd_addr_t address);
  */
 void gap_auto_connection_stop_all(void);
 
+/**
+ * @brief Auto Connection Establishment - Get size of the Controller's whitelist
+ * @note  entries pending removal still count until they have been removed from the Controller
+ * @return number of entries, 0 if not known yet
+ */
+uint16_t gap_auto_connection_get_whitelist_size(void);
+
 /**
  *
  * @brief Get encryption key size.
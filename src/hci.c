@@ -75,8 +75,12 @@
 #include "gap.h"
 #include "hci.h"
 #include "hci_cmd.h"
+#include "hci_cmd_encoder.h"
 #include "hci_dump.h"
 #include "ad_parser.h"
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+#include "ble/le_device_db.h"
+#endif
 
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
 #ifndef HCI_HOST_ACL_PACKET_NUM
@@ -160,6 +164,9 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size);
 static void hci_remove_from_whitelist(bd_addr_type_t address_type, bd_addr_t address);
 static hci_connection_t * gap_get_outgoing_connection(void);
 #endif
+#ifdef ENABLE_LE_PERIPHERAL
+static void gap_advertisments_changed(void);
+#endif
 #endif
 
 // the STACK is here
@@ -202,6 +209,13 @@ static hci_connection_t * create_connection_for_bd_addr_and_type(bd_addr_t addr,
     conn->num_acl_packets_sent = 0;
     conn->num_sco_packets_sent = 0;
     conn->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
+#ifdef ENABLE_BLE
+    conn->le_phy_todo = 0;
+    conn->le_tx_phy = LE_PHY_1M;
+    conn->le_rx_phy = LE_PHY_1M;
+    conn->le_max_tx_octets = LE_DATA_LENGTH_MIN_OCTETS;
+    conn->le_max_rx_octets = LE_DATA_LENGTH_MIN_OCTETS;
+#endif
     btstack_linked_list_add(&hci_stack->connections, (btstack_linked_item_t *) conn);
     return conn;
 }
@@ -613,6 +627,12 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
     uint16_t max_acl_data_packet_length = hci_stack->acl_data_packet_length;
     if (hci_is_le_connection(connection) && hci_stack->le_data_packets_length > 0){
         max_acl_data_packet_length = hci_stack->le_data_packets_length;
+#ifdef ENABLE_BLE
+        // match fragments to negotiated LL payload size to avoid splitting into full and short LL PDUs
+        if (connection->le_max_tx_octets < max_acl_data_packet_length){
+            max_acl_data_packet_length = connection->le_max_tx_octets;
+        }
+#endif
     }
 
     // testing: reduce buffer to minimum
@@ -649,6 +669,9 @@ static int hci_send_acl_packet_fragments(hci_connection_t *connection){
 
         // count packet
         connection->num_acl_packets_sent++;
+#ifdef ENABLE_BLE
+        connection->le_num_acl_packets_tx++;
+#endif
         log_debug("hci_send_acl_packet_fragments loop before send (more fragments %d)", more_fragments);
 
         // update state for next fragment (if any) as "transport done" might be sent during send_packet already
@@ -809,6 +832,10 @@ static void acl_handler(uint8_t *packet, int size){
     conn->num_packets_completed++;
 #endif
 
+#ifdef ENABLE_BLE
+    conn->le_num_acl_packets_rx++;
+#endif
+
     // handle different packet types
     switch (acl_flags & 0x03) {
             
@@ -1015,7 +1042,8 @@ static int hci_le_supported(void){
  * @brief Get addr type and address used for LE in Advertisements, Scan Responses, 
  */
 void gap_le_get_own_address(uint8_t * addr_type, bd_addr_t addr){
-    *addr_type = hci_stack->le_own_addr_type;
+    // own address types 0x02/0x03 fall back to public/random address
+    *addr_type = hci_stack->le_own_addr_type & 1;
     if (hci_stack->le_own_addr_type){
         memcpy(addr, hci_stack->le_random_address, 6);
     } else {
@@ -1023,6 +1051,35 @@ void gap_le_get_own_address(uint8_t * addr_type, bd_addr_t addr){
     }
 }
 
+#if defined(ENABLE_LE_CENTRAL) || defined(ENABLE_LE_PERIPHERAL)
+// own address type for HCI Commands, Controller generates resolvable private addresses only with address resolution enabled
+static uint8_t hci_le_own_address_type(void){
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+    if (hci_stack->le_resolving_list_state == LE_RESOLVING_LIST_DONE) return hci_stack->le_own_addr_type;
+#endif
+    return hci_stack->le_own_addr_type & 1;
+}
+#endif
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+static int hci_le_extended_advertising_supported(void){
+    // LE Set Extended Advertising Parameters, LE Set Extended Scan Parameters, LE Extended Create Connection
+    return (hci_stack->local_supported_commands[1] & 0x07) == 0x07;
+}
+#endif
+
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+static le_advertising_set_t * hci_advertising_set_for_handle(uint8_t advertising_handle){
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * item = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (item->advertising_handle == advertising_handle) return item;
+    }
+    return NULL;
+}
+#endif
+
 #ifdef ENABLE_LE_CENTRAL
 void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
 
@@ -1050,6 +1107,99 @@ void le_handle_advertisement_report(uint8_t *packet, uint16_t size){
         hci_emit_event(event, pos, 1);
     }
 }
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+static uint8_t le_legacy_advertising_event_type(uint16_t extended_event_type){
+    switch (extended_event_type & 0x1f){
+        case 0x13:
+            return 0;   // ADV_IND
+        case 0x15:
+            return 1;   // ADV_DIRECT_IND
+        case 0x12:
+            return 2;   // ADV_SCAN_IND
+        case 0x10:
+            return 3;   // ADV_NONCONN_IND
+        default:
+            return 4;   // SCAN_RSP
+    }
+}
+
+static void le_handle_extended_report_fragment(uint8_t * report, uint8_t data_length, uint16_t data_status){
+    uint8_t * header = &hci_stack->le_extended_report_buffer[2];
+    uint16_t  len    = btstack_min(data_length, LE_EXTENDED_ADVERTISING_MAX_DATA_LEN - hci_stack->le_extended_report_data_len);
+    memcpy(&hci_stack->le_extended_report_buffer[27 + hci_stack->le_extended_report_data_len], &report[24], len);
+    hci_stack->le_extended_report_data_len += len;
+    if (data_status == LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_INCOMPLETE) return;
+    // done, report with final data status
+    uint16_t event_type = (little_endian_read_16(header, 0) & ~LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_MASK) | data_status;
+    little_endian_store_16(header, 0, event_type);
+    little_endian_store_16(header, 23, hci_stack->le_extended_report_data_len);
+    hci_stack->le_extended_report_buffer[0] = GAP_EVENT_EXTENDED_ADVERTISING_REPORT;
+    hci_stack->le_extended_report_buffer[1] = btstack_min(25 + hci_stack->le_extended_report_data_len, 255);
+    hci_stack->le_extended_report_active = 0;
+    hci_emit_event(hci_stack->le_extended_report_buffer, 27 + hci_stack->le_extended_report_data_len, 1);
+}
+
+// @note converts complete reports in place, packet is not valid afterwards
+static void le_handle_extended_advertisement_report(uint8_t *packet, uint16_t size){
+    int num_reports = packet[3];
+    int offset = 4;
+    int i;
+    for (i=0; i<num_reports && offset < size; i++){
+        uint8_t * report = &packet[offset];
+        // event type (2), address type, address (6), primary phy, secondary phy, sid, tx power, rssi,
+        // periodic advertising interval (2), direct address type, direct address (6), data length, data
+        uint8_t data_length = report[23];
+        if (offset + 24 + data_length > size) return;
+        offset += 24 + data_length;
+
+        uint16_t event_type = little_endian_read_16(report, 0);
+        if (event_type & LE_ADVERTISING_EVENT_PROPERTIES_LEGACY){
+            // legacy PDU, report as GAP_EVENT_ADVERTISING_REPORT
+            if (data_length > LE_ADVERTISING_DATA_SIZE) continue;
+            uint8_t event[12 + LE_ADVERTISING_DATA_SIZE];
+            int pos = 0;
+            event[pos++] = GAP_EVENT_ADVERTISING_REPORT;
+            event[pos++] = 10 + data_length;
+            event[pos++] = le_legacy_advertising_event_type(event_type);
+            memcpy(&event[pos], &report[2], 1+6);   // address type + address
+            pos += 7;
+            event[pos++] = report[13];              // rssi
+            event[pos++] = data_length;
+            memcpy(&event[pos], &report[24], data_length);
+            pos += data_length;
+            hci_emit_event(event, pos, 1);
+            continue;
+        }
+
+        uint16_t data_status = event_type & LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_MASK;
+
+        // continuation of pending report: same address type, address and advertising sid
+        uint8_t * header = &hci_stack->le_extended_report_buffer[2];
+        if (hci_stack->le_extended_report_active && memcmp(&header[2], &report[2], 7) == 0 && header[11] == report[11]){
+            le_handle_extended_report_fragment(report, data_length, data_status);
+            continue;
+        }
+
+        // first fragment, start reassembly. A pending report from another advertiser is dropped
+        if (data_status == LE_EXTENDED_ADVERTISING_REPORT_DATA_STATUS_INCOMPLETE){
+            memcpy(header, report, 23);
+            hci_stack->le_extended_report_data_len = 0;
+            hci_stack->le_extended_report_active = 1;
+            le_handle_extended_report_fragment(report, data_length, data_status);
+            continue;
+        }
+
+        // complete report: move fixed fields by one octet for 16-bit data length and add event header in front
+        memmove(report - 1, report, 23);
+        little_endian_store_16(report, 22, data_length);
+        uint8_t * event = report - 3;
+        event[0] = GAP_EVENT_EXTENDED_ADVERTISING_REPORT;
+        event[1] = 25 + data_length;
+        hci_emit_event(event, 27 + data_length, 1);
+    }
+}
+#endif
 #endif
 #endif
 
@@ -1159,6 +1309,264 @@ static void hci_replace_bd_addr_placeholder(uint8_t * data, uint16_t size){
 }
 #endif
 
+#ifdef ENABLE_LE_CENTRAL
+static void hci_send_le_create_connection(uint8_t initiator_filter_policy, uint8_t peer_address_type, uint8_t * peer_address){
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    if (hci_le_extended_advertising_supported()){
+        hci_send_cmd(&hci_le_extended_create_connection,
+             initiator_filter_policy,
+             hci_le_own_address_type(),              // our addr type
+             peer_address_type,                        // peer address type
+             peer_address,                             // peer bd addr
+             LE_PHY_MASK_1M,                           // initiating phys
+             hci_stack->le_connection_scan_interval,   // conn scan interval
+             hci_stack->le_connection_scan_window,     // conn scan windows
+             hci_stack->le_connection_interval_min,    // conn interval min
+             hci_stack->le_connection_interval_max,    // conn interval max
+             hci_stack->le_connection_latency,         // conn latency
+             hci_stack->le_supervision_timeout,        // supervision timeout
+             hci_stack->le_minimum_ce_length,          // min ce length
+             hci_stack->le_maximum_ce_length           // max ce length
+             );
+        return;
+    }
+#endif
+    hci_send_cmd(&hci_le_create_connection,
+         hci_stack->le_connection_scan_interval,    // conn scan interval
+         hci_stack->le_connection_scan_window,      // conn scan windows
+         initiator_filter_policy,                   // use whitelist?
+         peer_address_type,                         // peer address type
+         peer_address,                              // peer bd addr
+         hci_le_own_address_type(),               // our addr type:
+         hci_stack->le_connection_interval_min,     // conn interval min
+         hci_stack->le_connection_interval_max,     // conn interval max
+         hci_stack->le_connection_latency,          // conn latency
+         hci_stack->le_supervision_timeout,         // supervision timeout
+         hci_stack->le_minimum_ce_length,           // min ce length
+         hci_stack->le_maximum_ce_length            // max ce length
+         );
+}
+#endif
+
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+// map legacy advertising type to advertising event properties of LE Set Extended Advertising Parameters
+static uint16_t hci_le_legacy_advertising_event_properties(uint8_t advertising_type){
+    switch (advertising_type){
+        case 1:  // ADV_DIRECT_IND (high duty cycle)
+            return LE_ADVERTISING_EVENT_PROPERTIES_LEGACY | LE_ADVERTISING_EVENT_PROPERTIES_HIGH_DUTY | LE_ADVERTISING_EVENT_PROPERTIES_DIRECTED | LE_ADVERTISING_EVENT_PROPERTIES_CONNECTABLE;
+        case 2:  // ADV_SCAN_IND
+            return LE_ADVERTISING_EVENT_PROPERTIES_LEGACY | LE_ADVERTISING_EVENT_PROPERTIES_SCANNABLE;
+        case 3:  // ADV_NONCONN_IND
+            return LE_ADVERTISING_EVENT_PROPERTIES_LEGACY;
+        case 4:  // ADV_DIRECT_IND (low duty cycle)
+            return LE_ADVERTISING_EVENT_PROPERTIES_LEGACY | LE_ADVERTISING_EVENT_PROPERTIES_DIRECTED | LE_ADVERTISING_EVENT_PROPERTIES_CONNECTABLE;
+        default: // ADV_IND
+            return LE_ADVERTISING_EVENT_PROPERTIES_LEGACY | LE_ADVERTISING_EVENT_PROPERTIES_SCANNABLE | LE_ADVERTISING_EVENT_PROPERTIES_CONNECTABLE;
+    }
+}
+
+// legacy advertising is mapped onto advertising set 0
+static void hci_le_send_legacy_advertising_set_parameters(void){
+    uint16_t interval_min = hci_stack->le_advertisements_interval_min ? hci_stack->le_advertisements_interval_min : 0x0800;
+    uint16_t interval_max = hci_stack->le_advertisements_interval_max ? hci_stack->le_advertisements_interval_max : 0x0800;
+    uint8_t  channel_map  = hci_stack->le_advertisements_channel_map  ? hci_stack->le_advertisements_channel_map  : 0x07;
+    hci_stack->le_advertisements_legacy_set_configured = 1;
+    if (hci_stack->le_own_addr_type != BD_ADDR_TYPE_LE_PUBLIC){
+        hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+    }
+    hci_send_cmd(&hci_le_set_extended_advertising_parameters, 0,
+        hci_le_legacy_advertising_event_properties(hci_stack->le_advertisements_type),
+        interval_min, interval_max, channel_map,
+        hci_le_own_address_type(),
+        hci_stack->le_advertisements_direct_address_type,
+        hci_stack->le_advertisements_direct_address,
+        hci_stack->le_advertisements_filter_policy,
+        127,            // tx power: no preference
+        LE_PHY_1M,      // primary phy
+        0,              // secondary max skip
+        LE_PHY_1M,      // secondary phy
+        0,              // advertising sid
+        0);             // scan request notification
+}
+
+// send next fragment of advertising, scan response, or periodic advertising data, returns 1 if all data has been sent
+static int hci_le_send_extended_data_fragment(const hci_cmd_t * cmd, uint8_t advertising_handle, const uint8_t * data, uint16_t data_len, uint16_t * data_pos){
+    static const uint8_t empty_data[1] = { 0 };
+    uint16_t remaining = data_len - *data_pos;
+    uint8_t  fragment_len;
+    uint8_t  operation;
+    if (remaining <= LE_EXTENDED_ADVERTISING_MAX_CHUNK_LEN){
+        fragment_len = (uint8_t) remaining;
+        operation = (*data_pos == 0) ? LE_EXTENDED_ADVERTISING_OPERATION_COMPLETE_DATA : LE_EXTENDED_ADVERTISING_OPERATION_LAST_FRAGMENT;
+    } else {
+        fragment_len = LE_EXTENDED_ADVERTISING_MAX_CHUNK_LEN;
+        operation = (*data_pos == 0) ? LE_EXTENDED_ADVERTISING_OPERATION_FIRST_FRAGMENT : LE_EXTENDED_ADVERTISING_OPERATION_INTERMEDIATE_FRAGMENT;
+    }
+    const uint8_t * fragment = data_len ? &data[*data_pos] : empty_data;
+    *data_pos += fragment_len;
+    if (cmd == &hci_le_set_periodic_advertising_data){
+        hci_send_cmd(cmd, advertising_handle, operation, fragment_len, fragment);
+    } else {
+        // fragment preference: controller should not fragment data
+        hci_send_cmd(cmd, advertising_handle, operation, 1, fragment_len, fragment);
+    }
+    if (*data_pos < data_len) return 0;
+    *data_pos = 0;
+    return 1;
+}
+
+// returns 1 if command was sent
+static int hci_run_le_extended_advertising(void){
+
+    // legacy advertising on advertising set 0
+    uint16_t todo = hci_stack->le_advertisements_todo;
+    if (todo){
+        log_info("hci_run: gap_le: adv todo: %x", todo);
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_DISABLE){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_DISABLE;
+        hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, 0, 0, 0);
+        return 1;
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_SET_PARAMS){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+        hci_le_send_legacy_advertising_set_parameters();
+        return 1;
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+        hci_send_cmd(&hci_le_set_advertising_set_random_address, 0, hci_stack->le_random_address);
+        return 1;
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_SET_ADV_DATA){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+        uint8_t adv_data_clean[31];
+        memset(adv_data_clean, 0, sizeof(adv_data_clean));
+        memcpy(adv_data_clean, hci_stack->le_advertisements_data, hci_stack->le_advertisements_data_len);
+        hci_replace_bd_addr_placeholder(adv_data_clean, hci_stack->le_advertisements_data_len);
+        hci_send_cmd(&hci_le_set_extended_advertising_data, 0, LE_EXTENDED_ADVERTISING_OPERATION_COMPLETE_DATA, 1, hci_stack->le_advertisements_data_len, adv_data_clean);
+        return 1;
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA){
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+        uint8_t scan_data_clean[31];
+        memset(scan_data_clean, 0, sizeof(scan_data_clean));
+        memcpy(scan_data_clean, hci_stack->le_scan_response_data, hci_stack->le_scan_response_data_len);
+        hci_replace_bd_addr_placeholder(scan_data_clean, hci_stack->le_scan_response_data_len);
+        hci_send_cmd(&hci_le_set_extended_scan_response_data, 0, LE_EXTENDED_ADVERTISING_OPERATION_COMPLETE_DATA, 1, hci_stack->le_scan_response_data_len, scan_data_clean);
+        return 1;
+    }
+    if (todo & LE_ADVERTISEMENT_TASKS_ENABLE){
+        // advertising set 0 needs to be configured before it can be enabled
+        if (!hci_stack->le_advertisements_legacy_set_configured){
+            hci_le_send_legacy_advertising_set_parameters();
+            return 1;
+        }
+        hci_stack->le_advertisements_todo &= ~LE_ADVERTISEMENT_TASKS_ENABLE;
+        hci_send_cmd(&hci_le_set_extended_advertising_enable, 1, 1, 0, 0, 0);
+        return 1;
+    }
+
+    // extended advertising sets
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        uint8_t advertising_handle = advertising_set->advertising_handle;
+        uint16_t tasks = advertising_set->tasks;
+        if (!tasks) continue;
+        if (tasks & LE_ADVERTISEMENT_TASKS_DISABLE){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_DISABLE;
+            advertising_set->state &= ~LE_ADVERTISEMENT_STATE_ACTIVE;
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, advertising_handle, 0, 0);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE;
+            advertising_set->state &= ~LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE;
+            hci_send_cmd(&hci_le_set_periodic_advertising_enable, 0, advertising_handle);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_REMOVE_SET){
+            btstack_linked_list_iterator_remove(&it);
+            hci_send_cmd(&hci_le_remove_advertising_set, advertising_handle);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_PARAMS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+            const le_extended_advertising_parameters_t * params = &advertising_set->extended_params;
+            hci_send_cmd(&hci_le_set_extended_advertising_parameters,
+                advertising_handle,
+                params->advertising_event_properties,
+                params->primary_advertising_interval_min,
+                params->primary_advertising_interval_max,
+                params->primary_advertising_channel_map,
+                params->own_address_type,
+                params->peer_address_type,
+                params->peer_address,
+                params->advertising_filter_policy,
+                params->advertising_tx_power,
+                params->primary_advertising_phy,
+                params->secondary_advertising_max_skip,
+                params->secondary_advertising_phy,
+                params->advertising_sid,
+                params->scan_request_notification_enable);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+            hci_send_cmd(&hci_le_set_advertising_set_random_address, advertising_handle, hci_stack->le_random_address);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_ADV_DATA){
+            if (hci_le_send_extended_data_fragment(&hci_le_set_extended_advertising_data, advertising_handle,
+                    advertising_set->adv_data, advertising_set->adv_data_len, &advertising_set->adv_data_pos)){
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+            }
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA){
+            if (hci_le_send_extended_data_fragment(&hci_le_set_extended_scan_response_data, advertising_handle,
+                    advertising_set->scan_data, advertising_set->scan_data_len, &advertising_set->scan_data_pos)){
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+            }
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS;
+            const le_periodic_advertising_parameters_t * params = &advertising_set->periodic_params;
+            hci_send_cmd(&hci_le_set_periodic_advertising_parameters,
+                advertising_handle,
+                params->periodic_advertising_interval_min,
+                params->periodic_advertising_interval_max,
+                params->periodic_advertising_properties);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA){
+            if (hci_le_send_extended_data_fragment(&hci_le_set_periodic_advertising_data, advertising_handle,
+                    advertising_set->periodic_data, advertising_set->periodic_data_len, &advertising_set->periodic_data_pos)){
+                advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA;
+            }
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_ENABLE){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_ENABLE;
+            advertising_set->state |= LE_ADVERTISEMENT_STATE_ACTIVE;
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 1, 1, advertising_handle,
+                advertising_set->enable_timeout, advertising_set->enable_max_events);
+            return 1;
+        }
+        if (tasks & LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE){
+            advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE;
+            advertising_set->state |= LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE;
+            hci_send_cmd(&hci_le_set_periodic_advertising_enable, 1, advertising_handle);
+            return 1;
+        }
+    }
+    return 0;
+}
+#endif
+
 // assumption: hci_can_send_command_packet_now() == true
 static void hci_initializing_run(void){
     log_debug("hci_initializing_run: substate %u, can send %u", hci_stack->substate, hci_can_send_command_packet_now());
@@ -1426,10 +1834,22 @@ static void hci_initializing_run(void){
             hci_stack->substate = HCI_INIT_W4_LE_READ_BUFFER_SIZE;
             hci_send_cmd(&hci_le_read_buffer_size);
             break;
-        case HCI_INIT_LE_SET_EVENT_MASK:
+        case HCI_INIT_LE_SET_EVENT_MASK: {
             hci_stack->substate = HCI_INIT_W4_LE_SET_EVENT_MASK;
-            hci_send_cmd(&hci_le_set_event_mask, 0x1FF, 0x0);
+            uint32_t le_event_mask = 0x1FF;
+            // enable LE PHY Update Complete if LE Set PHY is supported
+            if (hci_stack->local_supported_commands[0] & 0x40){
+                le_event_mask |= 0x800;
+            }
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            // enable LE Extended Advertising Report, LE Scan Timeout, LE Advertising Set Terminated
+            if (hci_le_extended_advertising_supported()){
+                le_event_mask |= 0x31000;
+            }
+#endif
+            hci_send_cmd(&hci_le_set_event_mask, le_event_mask, 0x0);
             break;
+        }
         case HCI_INIT_WRITE_LE_HOST_SUPPORTED:
             // LE Supported Host = 1, Simultaneous Host = 0
             hci_stack->substate = HCI_INIT_W4_WRITE_LE_HOST_SUPPORTED;
@@ -1456,7 +1876,14 @@ static void hci_initializing_run(void){
         case HCI_INIT_LE_SET_SCAN_PARAMETERS:
             // LE Scan Parameters: active scanning, 300 ms interval, 30 ms window, own address type, accept all advs
             hci_stack->substate = HCI_INIT_W4_LE_SET_SCAN_PARAMETERS;
-            hci_send_cmd(&hci_le_set_scan_parameters, 1, 0x1e0, 0x30, hci_stack->le_own_addr_type, 0);
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            // legacy and extended commands must not be mixed
+            if (hci_le_extended_advertising_supported()){
+                hci_send_cmd(&hci_le_set_extended_scan_parameters, hci_le_own_address_type(), 0, LE_PHY_MASK_1M, 1, 0x1e0, 0x30);
+                break;
+            }
+#endif
+            hci_send_cmd(&hci_le_set_scan_parameters, 1, 0x1e0, 0x30, hci_le_own_address_type(), 0);
             break;
 #endif
         default:
@@ -1856,6 +2283,39 @@ static void event_handler(uint8_t *packet, int size){
                 hci_stack->le_whitelist_capacity = packet[6];
                 log_info("hci_le_read_white_list_size: size %u", hci_stack->le_whitelist_capacity);
             }   
+#endif
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+            if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_read_resolving_list_size)){
+                if (packet[5] || packet[6] == 0){
+                    // resolving list not usable, addresses are resolved by host
+                    hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_IDLE;
+                } else {
+                    hci_stack->le_resolving_list_size = packet[6];
+                }
+                log_info("hci_le_read_resolving_list_size: status 0x%02x, size %u", packet[5], packet[6]);
+            }
+            if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_add_device_to_resolving_list) && packet[5]){
+                // device is resolved by host
+                uint16_t index = hci_stack->le_resolving_list_pending_index;
+                log_error("hci_le_add_device_to_resolving_list: status 0x%02x for index %u", packet[5], index);
+                hci_stack->le_resolving_list_on_controller[index >> 3] &= ~(1 << (index & 7));
+                hci_stack->le_resolving_list_num_entries--;
+                if (packet[5] == ERROR_CODE_MEMORY_CAPACITY_EXCEEDED){
+                    // treat resolving list as full
+                    hci_stack->le_resolving_list_size = hci_stack->le_resolving_list_num_entries;
+                }
+            }
+            if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_le_set_address_resolution_enable) && packet[5]){
+                log_error("hci_le_set_address_resolution_enable %u: status 0x%02x", hci_stack->le_resolving_list_address_resolution_enable, packet[5]);
+                if (packet[5] == ERROR_CODE_COMMAND_DISALLOWED){
+                    // retry after advertising, scanning, and initiating have been stopped
+                    hci_stack->le_resolving_list_state = hci_stack->le_resolving_list_address_resolution_enable ?
+                        LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION : LE_RESOLVING_LIST_SEND_DISABLE_ADDRESS_RESOLUTION;
+                } else {
+                    // address resolution not usable, addresses are resolved by host
+                    hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_IDLE;
+                }
+            }
 #endif
             if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_read_bd_addr)) {
                 reverse_bd_addr(&packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE + 1],
@@ -1908,8 +2368,16 @@ static void event_handler(uint8_t *packet, int size){
                     (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+10] & 0x10) >> 2 |  // bit 2 = Octet 10, bit 4
                     (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+18] & 0x08)      |  // bit 3 = Octet 18, bit 3
                     (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+34] & 0x01) << 4 |  // bit 4 = Octet 34, bit 0
-                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+35] & 0x08) << 2;   // bit 5 = Octet 35, bit 3
-                    log_info("Local supported commands summary 0x%02x", hci_stack->local_supported_commands[0]); 
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+35] & 0x08) << 2 |  // bit 5 = Octet 35, bit 3
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+35] & 0x40)      |  // bit 6 = Octet 35, bit 6
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+33] & 0x40) << 1;   // bit 7 = Octet 33, bit 6
+                hci_stack->local_supported_commands[1] =
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+36] & 0x04) >> 2 |  // bit 0 = Octet 36, bit 2
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+37] & 0x20) >> 4 |  // bit 1 = Octet 37, bit 5
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+37] & 0x80) >> 5 |  // bit 2 = Octet 37, bit 7
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+37] & 0x04) << 1 |  // bit 3 = Octet 37, bit 2
+                    (packet[OFFSET_OF_DATA_IN_COMMAND_COMPLETE+1+35] & 0x02) << 3;   // bit 4 = Octet 35, bit 1
+                    log_info("Local supported commands summary 0x%02x 0x%02x", hci_stack->local_supported_commands[0], hci_stack->local_supported_commands[1]); 
             }
 #ifdef ENABLE_CLASSIC
             if (HCI_EVENT_IS_COMMAND_COMPLETE(packet, hci_write_synchronous_flow_control_enable)){
@@ -2275,11 +2743,19 @@ static void event_handler(uint8_t *packet, int size){
                     if (!hci_stack->le_scanning_enabled) break;
                     le_handle_advertisement_report(packet, size);
                     break;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+                case HCI_SUBEVENT_LE_EXTENDED_ADVERTISING_REPORT:
+                    if (!hci_stack->le_scanning_enabled) break;
+                    // reports are converted in place, don't forward HCI event
+                    le_handle_extended_advertisement_report(packet, size);
+                    return;
+#endif
 #endif
                 case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
                     // Connection management
                     reverse_bd_addr(&packet[8], addr);
-                    addr_type = (bd_addr_type_t)packet[7];
+                    // peer address types 0x02/0x03: identity address resolved by Controller
+                    addr_type = (bd_addr_type_t)(packet[7] & 1);
                     log_info("LE Connection_complete (status=%u) type %u, %s", packet[3], addr_type, bd_addr_to_str(addr));
                     conn = hci_connection_for_bd_addr_and_type(addr, addr_type);
 
@@ -2379,6 +2855,36 @@ static void event_handler(uint8_t *packet, int size){
                         }
                     }
                     break;
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+                case HCI_SUBEVENT_LE_ADVERTISING_SET_TERMINATED: {
+                    uint8_t advertising_handle = hci_subevent_le_advertising_set_terminated_get_advertising_handle(packet);
+                    if (advertising_handle == 0){
+                        hci_stack->le_advertisements_active = 0;
+                        break;
+                    }
+                    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+                    if (!advertising_set) break;
+                    advertising_set->state &= ~LE_ADVERTISEMENT_STATE_ACTIVE;
+                    break;
+                }
+#endif
+                case HCI_SUBEVENT_LE_DATA_LENGTH_CHANGE:
+                    handle = hci_subevent_le_data_length_change_get_connection_handle(packet);
+                    conn = hci_connection_for_handle(handle);
+                    if (!conn) break;
+                    conn->le_max_tx_octets = hci_subevent_le_data_length_change_get_max_tx_octets(packet);
+                    conn->le_max_rx_octets = hci_subevent_le_data_length_change_get_max_rx_octets(packet);
+                    log_info("LE Data Length 0x%04x: tx %u, rx %u", handle, conn->le_max_tx_octets, conn->le_max_rx_octets);
+                    break;
+                case HCI_SUBEVENT_LE_PHY_UPDATE_COMPLETE:
+                    if (hci_subevent_le_phy_update_complete_get_status(packet)) break;
+                    handle = hci_subevent_le_phy_update_complete_get_connection_handle(packet);
+                    conn = hci_connection_for_handle(handle);
+                    if (!conn) break;
+                    conn->le_tx_phy = hci_subevent_le_phy_update_complete_get_tx_phy(packet);
+                    conn->le_rx_phy = hci_subevent_le_phy_update_complete_get_rx_phy(packet);
+                    log_info("LE PHY 0x%04x: tx %u, rx %u", handle, conn->le_tx_phy, conn->le_rx_phy);
+                    break;
                 default:
                     break;
             }
@@ -2516,12 +3022,41 @@ static void hci_state_reset(void){
     memset(hci_stack->le_random_address, 0, 6);
     hci_stack->le_random_address_set = 0;
 #endif
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+    // resolving list is loaded again when SM provides local IRK
+    hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_IDLE;
+    hci_stack->le_resolving_list_num_entries = 0;
+    memset(hci_stack->le_resolving_list_on_controller, 0, sizeof(hci_stack->le_resolving_list_on_controller));
+#endif
 #ifdef ENABLE_LE_CENTRAL
     hci_stack->le_scanning_active  = 0;
     hci_stack->le_scan_type = 0xff; 
     hci_stack->le_connecting_state = LE_CONNECTING_IDLE;
     hci_stack->le_whitelist = 0;
     hci_stack->le_whitelist_capacity = 0;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    hci_stack->le_extended_report_active = 0;
+#endif
+#endif
+#if defined(ENABLE_LE_PERIPHERAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+    // advertising sets need to be configured again after power on
+    hci_stack->le_advertisements_legacy_set_configured = 0;
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_REMOVE_SET){
+            btstack_linked_list_iterator_remove(&it);
+            continue;
+        }
+        advertising_set->state = 0;
+        advertising_set->tasks = LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+        if (advertising_set->adv_data_len)      advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+        if (advertising_set->scan_data_len)     advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+        advertising_set->adv_data_pos = 0;
+        advertising_set->scan_data_pos = 0;
+        advertising_set->periodic_data_pos = 0;
+    }
 #endif
 }
 
@@ -2967,7 +3502,18 @@ void gap_local_bd_addr(bd_addr_t address_buffer){
 }
 
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
-static void hci_host_num_completed_packets(void){
+// @returns 1 if HCI Host Number of Completed Packets was sent
+static int hci_host_num_completed_packets(void){
+
+    hci_stack->host_completed_packets = 0;
+
+    // nothing to report if all connections with completed packets are paused
+    btstack_linked_item_t * it;
+    for (it = (btstack_linked_item_t *) hci_stack->connections; it ; it = it->next){
+        hci_connection_t * connection = (hci_connection_t *) it;
+        if (connection->num_packets_completed && !connection->acl_rx_paused) break;
+    }
+    if (!it) return 0;
 
     // create packet manually as arrays are not supported and num_commands should not get reduced
     hci_reserve_packet_buffer();
@@ -2981,10 +3527,9 @@ static void hci_host_num_completed_packets(void){
     size++;  // skip num handles
 
     // add { handle, packets } entries
-    btstack_linked_item_t * it;
     for (it = (btstack_linked_item_t *) hci_stack->connections; it ; it = it->next){
         hci_connection_t * connection = (hci_connection_t *) it;
-        if (connection->num_packets_completed){
+        if (connection->num_packets_completed && !connection->acl_rx_paused){
             little_endian_store_16(packet, size, connection->con_handle);
             size += 2;
             little_endian_store_16(packet, size, connection->num_packets_completed);
@@ -2998,8 +3543,6 @@ static void hci_host_num_completed_packets(void){
     packet[2] = size - 3;
     packet[3] = num_handles;
 
-    hci_stack->host_completed_packets = 0;
-
     hci_dump_packet(HCI_COMMAND_DATA_PACKET, 0, packet, size);
     hci_stack->hci_transport->send_packet(HCI_COMMAND_DATA_PACKET, packet, size);
 
@@ -3007,6 +3550,234 @@ static void hci_host_num_completed_packets(void){
     if (hci_transport_synchronous()){
         hci_stack->hci_packet_buffer_reserved = 0;
     }
+    return 1;
+}
+
+void hci_set_acl_rx_paused(hci_con_handle_t con_handle, int paused){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return;
+    connection->acl_rx_paused = paused ? 1 : 0;
+    if (paused) return;
+    // report packets completed while paused
+    if (connection->num_packets_completed == 0) return;
+    hci_stack->host_completed_packets = 1;
+    hci_run();
+}
+#endif
+
+#ifdef ENABLE_BLE
+// HCI Command buffer for typed encoders from hci_cmd_encoder.h, pre: hci_can_send_command_packet_now()
+static uint8_t * hci_reserve_cmd_packet_buffer(void){
+    hci_reserve_packet_buffer();
+    return hci_stack->hci_packet_buffer;
+}
+
+// send HCI Command created in buffer from hci_reserve_cmd_packet_buffer
+static int hci_send_prepared_cmd_packet(uint16_t size){
+    uint8_t * packet = hci_stack->hci_packet_buffer;
+    hci_stack->last_cmd_opcode = little_endian_read_16(packet, 0);
+    return hci_send_cmd_packet(packet, size);
+}
+#endif
+
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+static int hci_le_resolving_list_entry_set(const uint8_t * bitmap, uint16_t index){
+    return (bitmap[index >> 3] >> (index & 7)) & 1;
+}
+
+// Address Resolution Enable is disallowed while advertising, scanning, or initiating
+// returns 1 if command was sent to stop one of them, they are resumed by hci_run after the update
+static int hci_le_resolving_list_pause_activities(void){
+#ifdef ENABLE_LE_CENTRAL
+    if (hci_stack->le_connecting_state == LE_CONNECTING_WHITELIST){
+        hci_send_cmd(&hci_le_create_connection_cancel);
+        return 1;
+    }
+    if (hci_stack->le_scanning_active){
+        hci_stack->le_scanning_active = 0;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        if (hci_le_extended_advertising_supported()){
+            hci_send_cmd(&hci_le_set_extended_scan_enable, 0, 0, 0, 0);
+            return 1;
+        }
+#endif
+        hci_send_cmd(&hci_le_set_scan_enable, 0, 0);
+        return 1;
+    }
+#endif
+#ifdef ENABLE_LE_PERIPHERAL
+    if (hci_stack->le_advertisements_active){
+        if (hci_stack->le_advertisements_enabled){
+            hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_ENABLE;
+        }
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        if (hci_le_extended_advertising_supported()){
+            hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, 0, 0, 0);
+            return 1;
+        }
+#endif
+        hci_send_cmd(&hci_le_set_advertise_enable, 0);
+        return 1;
+    }
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    btstack_linked_list_iterator_t it;
+    btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+    while (btstack_linked_list_iterator_has_next(&it)){
+        le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+        if ((advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE) == 0) continue;
+        advertising_set->state &= ~LE_ADVERTISEMENT_STATE_ACTIVE;
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_ENABLE;
+        hci_send_cmd(&hci_le_set_extended_advertising_enable, 0, 1, advertising_set->advertising_handle, 0, 0);
+        return 1;
+    }
+#endif
+#endif
+    return 0;
+}
+
+static int hci_run_le_resolving_list(void){
+    int max_index;
+    int index;
+    int addr_type;
+    bd_addr_t addr;
+    sm_key_t peer_irk;
+    sm_key_t zero_irk;
+    uint8_t peer_irk_flipped[16];
+    uint8_t local_irk_flipped[16];
+
+    switch (hci_stack->le_resolving_list_state){
+        case LE_RESOLVING_LIST_SEND_READ_SIZE:
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_SEND_DISABLE_ADDRESS_RESOLUTION;
+            hci_send_cmd(&hci_le_read_resolving_list_size);
+            return 1;
+        case LE_RESOLVING_LIST_SEND_DISABLE_ADDRESS_RESOLUTION:
+#ifdef ENABLE_LE_CENTRAL
+            // wait for pending direct connection
+            if (hci_stack->le_connecting_state == LE_CONNECTING_DIRECT) return 0;
+#endif
+            // resolving list cannot be modified while address resolution is enabled and advertising, scanning or initiating
+            if (hci_le_resolving_list_pause_activities()) return 1;
+            hci_stack->le_resolving_list_state = hci_stack->le_resolving_list_reload ? LE_RESOLVING_LIST_SEND_CLEAR : LE_RESOLVING_LIST_UPDATE_ENTRIES;
+            hci_stack->le_resolving_list_address_resolution_enable = 0;
+            hci_send_cmd(&hci_le_set_address_resolution_enable, 0);
+            return 1;
+        case LE_RESOLVING_LIST_SEND_CLEAR:
+            // add all entries again
+            for (index = 0; index < (int) sizeof(hci_stack->le_resolving_list_on_controller); index++){
+                hci_stack->le_resolving_list_add_entries[index] |= hci_stack->le_resolving_list_on_controller[index];
+            }
+            memset(hci_stack->le_resolving_list_on_controller, 0, sizeof(hci_stack->le_resolving_list_on_controller));
+            hci_stack->le_resolving_list_num_entries = 0;
+            hci_stack->le_resolving_list_reload = 0;
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_UPDATE_ENTRIES;
+            hci_send_cmd(&hci_le_clear_resolving_list);
+            return 1;
+        case LE_RESOLVING_LIST_UPDATE_ENTRIES:
+            max_index = btstack_min(le_device_db_max_count(), MAX_NUM_RESOLVING_LIST_ENTRIES);
+            memset(zero_irk, 0, 16);
+            for (index = 0; index < max_index; index++){
+                if (!hci_le_resolving_list_entry_set(hci_stack->le_resolving_list_add_entries, index)) continue;
+                hci_stack->le_resolving_list_add_entries[index >> 3] &= ~(1 << (index & 7));
+                le_device_db_info(index, &addr_type, addr, peer_irk);
+                if (addr_type != BD_ADDR_TYPE_LE_PUBLIC && addr_type != BD_ADDR_TYPE_LE_RANDOM) continue;
+                if (memcmp(peer_irk, zero_irk, 16) == 0) continue;
+                if (hci_stack->le_resolving_list_num_entries >= hci_stack->le_resolving_list_size){
+                    log_info("Resolving List full, device db index %u resolved by host", index);
+                    continue;
+                }
+                hci_stack->le_resolving_list_on_controller[index >> 3] |= 1 << (index & 7);
+                hci_stack->le_resolving_list_num_entries++;
+                hci_stack->le_resolving_list_pending_index = index;
+                reverse_128(peer_irk, peer_irk_flipped);
+                reverse_128(hci_stack->le_resolving_list_local_irk, local_irk_flipped);
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_add_device_to_resolving_list(hci_reserve_cmd_packet_buffer(),
+                    addr_type, addr, peer_irk_flipped, local_irk_flipped));
+                return 1;
+            }
+            // entries beyond MAX_NUM_RESOLVING_LIST_ENTRIES are resolved by host
+            memset(hci_stack->le_resolving_list_add_entries, 0, sizeof(hci_stack->le_resolving_list_add_entries));
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION;
+            return hci_run_le_resolving_list();
+        case LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION:
+#ifdef ENABLE_LE_CENTRAL
+            if (hci_stack->le_connecting_state == LE_CONNECTING_DIRECT) return 0;
+#endif
+            if (hci_le_resolving_list_pause_activities()) return 1;
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_DONE;
+            hci_stack->le_resolving_list_address_resolution_enable = 1;
+            hci_send_cmd(&hci_le_set_address_resolution_enable, 1);
+#ifdef ENABLE_LE_PERIPHERAL
+            // use resolvable private addresses generated by Controller for advertising
+            if (hci_stack->le_own_addr_type > BD_ADDR_TYPE_LE_RANDOM){
+                hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+                gap_advertisments_changed();
+            }
+#endif
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void hci_le_resolving_list_update(void){
+    switch (hci_stack->le_resolving_list_state){
+        case LE_RESOLVING_LIST_DONE:
+            hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_SEND_DISABLE_ADDRESS_RESOLUTION;
+            break;
+        case LE_RESOLVING_LIST_UPDATE_ENTRIES:
+        case LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION:
+            // address resolution already disabled
+            hci_stack->le_resolving_list_state = hci_stack->le_resolving_list_reload ? LE_RESOLVING_LIST_SEND_CLEAR : LE_RESOLVING_LIST_UPDATE_ENTRIES;
+            break;
+        default:
+            // pending or not started
+            break;
+    }
+    hci_run();
+}
+
+void hci_le_resolving_list_set_local_irk(const sm_key_t irk){
+    memcpy(hci_stack->le_resolving_list_local_irk, irk, 16);
+    // LE Set Address Resolution Enable supported
+    if ((hci_stack->local_supported_commands[1] & 0x10) == 0){
+        log_info("Resolving List not supported by Controller");
+        return;
+    }
+    // load all entries
+    memset(hci_stack->le_resolving_list_add_entries, 0xff, sizeof(hci_stack->le_resolving_list_add_entries));
+    hci_stack->le_resolving_list_reload = 1;
+    if (hci_stack->le_resolving_list_state == LE_RESOLVING_LIST_IDLE){
+        hci_stack->le_resolving_list_state = LE_RESOLVING_LIST_SEND_READ_SIZE;
+        hci_run();
+        return;
+    }
+    hci_le_resolving_list_update();
+}
+
+void hci_le_resolving_list_add_device_db_entry(uint16_t le_device_db_index){
+    if (le_device_db_index >= MAX_NUM_RESOLVING_LIST_ENTRIES) return;
+    hci_stack->le_resolving_list_add_entries[le_device_db_index >> 3] |= 1 << (le_device_db_index & 7);
+    if (hci_le_resolving_list_entry_set(hci_stack->le_resolving_list_on_controller, le_device_db_index)){
+        // IRK might have changed
+        hci_stack->le_resolving_list_reload = 1;
+    }
+    hci_le_resolving_list_update();
+}
+
+void hci_le_resolving_list_remove_device_db_entry(uint16_t le_device_db_index){
+    if (le_device_db_index >= MAX_NUM_RESOLVING_LIST_ENTRIES) return;
+    hci_stack->le_resolving_list_add_entries[le_device_db_index >> 3] &= ~(1 << (le_device_db_index & 7));
+    if (!hci_le_resolving_list_entry_set(hci_stack->le_resolving_list_on_controller, le_device_db_index)) return;
+    // identity address is not available after removal from LE Device DB, load remaining entries again
+    hci_stack->le_resolving_list_on_controller[le_device_db_index >> 3] &= ~(1 << (le_device_db_index & 7));
+    hci_stack->le_resolving_list_reload = 1;
+    hci_le_resolving_list_update();
+}
+
+int hci_le_resolving_list_contains_device_db_entry(uint16_t le_device_db_index){
+    if (hci_stack->le_resolving_list_state != LE_RESOLVING_LIST_DONE) return 0;
+    if (le_device_db_index >= MAX_NUM_RESOLVING_LIST_ENTRIES) return 0;
+    return hci_le_resolving_list_entry_set(hci_stack->le_resolving_list_on_controller, le_device_db_index);
 }
 #endif
 
@@ -3036,8 +3807,7 @@ static void hci_run(void){
     // send host num completed packets next as they don't require num_cmd_packets > 0
     if (!hci_can_send_comand_packet_transport()) return;
     if (hci_stack->host_completed_packets){
-        hci_host_num_completed_packets();        
-        return;
+        if (hci_host_num_completed_packets()) return;
     }
 #endif
 
@@ -3108,6 +3878,10 @@ static void hci_run(void){
     }
 #endif
 
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+    if (hci_stack->state == HCI_STATE_WORKING && hci_run_le_resolving_list()) return;
+#endif
+
 #ifdef ENABLE_BLE
     // advertisements, active scanning, and creating connections requires randaom address to be set if using private address
     if ((hci_stack->state == HCI_STATE_WORKING)
@@ -3117,6 +3891,12 @@ static void hci_run(void){
         // handle le scan
         if ((hci_stack->le_scanning_enabled != hci_stack->le_scanning_active)){
             hci_stack->le_scanning_active = hci_stack->le_scanning_enabled;
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            if (hci_le_extended_advertising_supported()){
+                hci_send_cmd(&hci_le_set_extended_scan_enable, hci_stack->le_scanning_enabled, 0, 0, 0);
+                return;
+            }
+#endif
             hci_send_cmd(&hci_le_set_scan_enable, hci_stack->le_scanning_enabled, 0);
             return;
         }
@@ -3124,11 +3904,25 @@ static void hci_run(void){
             // defaults: active scanning, accept all advertisement packets
             int scan_type = hci_stack->le_scan_type;
             hci_stack->le_scan_type = 0xff;
-            hci_send_cmd(&hci_le_set_scan_parameters, scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window, hci_stack->le_own_addr_type, 0);
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            if (hci_le_extended_advertising_supported()){
+                hci_send_cmd(&hci_le_set_extended_scan_parameters, hci_le_own_address_type(), 0, LE_PHY_MASK_1M,
+                    scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window);
+                return;
+            }
+#endif
+            hci_send_cmd(&hci_le_set_scan_parameters, scan_type, hci_stack->le_scan_interval, hci_stack->le_scan_window, hci_le_own_address_type(), 0);
             return;
         }
 #endif
 #ifdef ENABLE_LE_PERIPHERAL
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        // legacy advertising commands must not be mixed with extended ones
+        if (hci_le_extended_advertising_supported()){
+            if (hci_run_le_extended_advertising()) return;
+            hci_stack->le_advertisements_todo = 0;
+        }
+#endif
         // le advertisement control
         if (hci_stack->le_advertisements_todo){
             log_info("hci_run: gap_le: adv todo: %x", hci_stack->le_advertisements_todo );
@@ -3144,7 +3938,7 @@ static void hci_run(void){
                  hci_stack->le_advertisements_interval_min,
                  hci_stack->le_advertisements_interval_max,
                  hci_stack->le_advertisements_type,
-                 hci_stack->le_own_addr_type,
+                 hci_le_own_address_type(),
                  hci_stack->le_advertisements_direct_address_type,
                  hci_stack->le_advertisements_direct_address,
                  hci_stack->le_advertisements_channel_map,
@@ -3206,7 +4000,7 @@ static void hci_run(void){
                 whitelist_entry_t * entry = (whitelist_entry_t*) btstack_linked_list_iterator_next(&lit);
                 if (entry->state & LE_WHITELIST_ADD_TO_CONTROLLER){
                     entry->state = LE_WHITELIST_ON_CONTROLLER;
-                    hci_send_cmd(&hci_le_add_device_to_white_list, entry->address_type, entry->address);
+                    hci_send_prepared_cmd_packet(hci_cmd_create_le_add_device_to_white_list(hci_reserve_cmd_packet_buffer(), entry->address_type, entry->address));
                     return;
 
                 }
@@ -3216,7 +4010,7 @@ static void hci_run(void){
                     memcpy(address, entry->address, 6);
                     btstack_linked_list_remove(&hci_stack->le_whitelist, (btstack_linked_item_t *) entry);
                     btstack_memory_whitelist_entry_free(entry);
-                    hci_send_cmd(&hci_le_remove_device_from_white_list, address_type, address);
+                    hci_send_prepared_cmd_packet(hci_cmd_create_le_remove_device_from_white_list(hci_reserve_cmd_packet_buffer(), address_type, address));
                     return;
                 }
             }
@@ -3227,20 +4021,7 @@ static void hci_run(void){
             !btstack_linked_list_empty(&hci_stack->le_whitelist)){
             bd_addr_t null_addr;
             memset(null_addr, 0, 6);
-            hci_send_cmd(&hci_le_create_connection,
-                hci_stack->le_connection_scan_interval,    // scan interval: 60 ms
-                hci_stack->le_connection_scan_window,    // scan interval: 30 ms
-                 1,         // use whitelist
-                 0,         // peer address type
-                 null_addr, // peer bd addr
-                 hci_stack->le_own_addr_type, // our addr type:
-                 hci_stack->le_connection_interval_min,    // conn interval min
-                 hci_stack->le_connection_interval_max,    // conn interval max
-                 hci_stack->le_connection_latency,         // conn latency
-                 hci_stack->le_supervision_timeout,        // conn latency
-                 hci_stack->le_minimum_ce_length,          // min ce length
-                 hci_stack->le_maximum_ce_length           // max ce length
-                );
+            hci_send_le_create_connection(1, 0, null_addr);
             return;
         }
 #endif
@@ -3264,20 +4045,7 @@ static void hci_run(void){
 #ifdef ENABLE_BLE
 #ifdef ENABLE_LE_CENTRAL
                         log_info("sending hci_le_create_connection");
-                        hci_send_cmd(&hci_le_create_connection,
-                             hci_stack->le_connection_scan_interval,    // conn scan interval
-                             hci_stack->le_connection_scan_window,      // conn scan windows
-                             0,         // don't use whitelist
-                             connection->address_type, // peer address type
-                             connection->address,      // peer bd addr
-                             hci_stack->le_own_addr_type, // our addr type:
-                             hci_stack->le_connection_interval_min,    // conn interval min
-                             hci_stack->le_connection_interval_max,    // conn interval max
-                             hci_stack->le_connection_latency,         // conn latency
-                             hci_stack->le_supervision_timeout,        // conn latency
-                             hci_stack->le_minimum_ce_length,          // min ce length
-                             hci_stack->le_maximum_ce_length          // max ce length
-                             );
+                        hci_send_le_create_connection(0, connection->address_type, connection->address);
                         connection->state = SENT_CREATE_CONNECTION;
 #endif
 #endif
@@ -3405,23 +4173,39 @@ static void hci_run(void){
             // response to L2CAP CON PARAMETER UPDATE REQUEST
             case CON_PARAMETER_UPDATE_CHANGE_HCI_CON_PARAMETERS:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE; 
-                hci_send_cmd(&hci_le_connection_update, connection->con_handle, connection->le_conn_interval_min,
-                    connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                    0x0000, 0xffff);
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_connection_update(hci_reserve_cmd_packet_buffer(), connection->con_handle,
+                    connection->le_conn_interval_min, connection->le_conn_interval_max, connection->le_conn_latency,
+                    connection->le_supervision_timeout, 0x0000, 0xffff));
                 break;
             case CON_PARAMETER_UPDATE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE;
-                hci_send_cmd(&hci_le_remote_connection_parameter_request_reply, connection->con_handle, connection->le_conn_interval_min,
-                    connection->le_conn_interval_max, connection->le_conn_latency, connection->le_supervision_timeout,
-                    0x0000, 0xffff);
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_remote_connection_parameter_request_reply(hci_reserve_cmd_packet_buffer(),
+                    connection->con_handle, connection->le_conn_interval_min, connection->le_conn_interval_max, connection->le_conn_latency,
+                    connection->le_supervision_timeout, 0x0000, 0xffff));
                 break;
             case CON_PARAMETER_UPDATE_NEGATIVE_REPLY:
                 connection->le_con_parameter_update_state = CON_PARAMETER_UPDATE_NONE; 
-                hci_send_cmd(&hci_le_remote_connection_parameter_request_negative_reply, ERROR_CODE_UNSUPPORTED_LMP_PARAMETER_VALUE_UNSUPPORTED_LL_PARAMETER_VALUE);
+                hci_send_prepared_cmd_packet(hci_cmd_create_le_remote_connection_parameter_request_negative_reply(hci_reserve_cmd_packet_buffer(),
+                    connection->con_handle, ERROR_CODE_UNSUPPORTED_LMP_PARAMETER_VALUE_UNSUPPORTED_LL_PARAMETER_VALUE));
                 break;
             default:
                 break;
         }
+
+        if (!hci_can_send_command_packet_now()) return;
+
+        if (connection->le_phy_todo & LE_PHY_TASKS_SET_DATA_LENGTH){
+            connection->le_phy_todo &= ~LE_PHY_TASKS_SET_DATA_LENGTH;
+            hci_send_cmd(&hci_le_set_data_length, connection->con_handle, connection->le_data_length_tx_octets, connection->le_data_length_tx_time);
+            return;
+        }
+
+        if (connection->le_phy_todo & LE_PHY_TASKS_SET_PHY){
+            connection->le_phy_todo &= ~LE_PHY_TASKS_SET_PHY;
+            hci_send_cmd(&hci_le_set_phy, connection->con_handle, connection->le_phy_all_phys, connection->le_phy_tx_phys,
+                connection->le_phy_rx_phys, connection->le_phy_options);
+            return;
+        }
 #endif
     }
     
@@ -3642,15 +4426,43 @@ int hci_send_cmd_packet(uint8_t *packet, int size){
     if (IS_COMMAND(packet, hci_le_set_random_address)){
         hci_stack->le_random_address_set = 1;
         reverse_bd_addr(&packet[3], hci_stack->le_random_address);
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        // advertising sets have their own random address
+        if (hci_stack->le_advertisements_legacy_set_configured && hci_stack->le_own_addr_type != BD_ADDR_TYPE_LE_PUBLIC){
+            hci_stack->le_advertisements_todo |= LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+        }
+        btstack_linked_list_iterator_t it;
+        btstack_linked_list_iterator_init(&it, &hci_stack->le_advertising_sets);
+        while (btstack_linked_list_iterator_has_next(&it)){
+            le_advertising_set_t * advertising_set = (le_advertising_set_t *) btstack_linked_list_iterator_next(&it);
+            if (advertising_set->extended_params.own_address_type == BD_ADDR_TYPE_LE_PUBLIC) continue;
+            advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+        }
+#endif
     }
     if (IS_COMMAND(packet, hci_le_set_advertise_enable)){
         hci_stack->le_advertisements_active = packet[3];
     }
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    if (IS_COMMAND(packet, hci_le_set_extended_advertising_enable) && packet[5] == 0){
+        // advertising set 0 is used for legacy advertising
+        hci_stack->le_advertisements_active = packet[3];
+    }
+#endif
 #endif
 #ifdef ENABLE_LE_CENTRAL
-    if (IS_COMMAND(packet, hci_le_create_connection)){
+    if (IS_COMMAND(packet, hci_le_create_connection)
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    ||  IS_COMMAND(packet, hci_le_extended_create_connection)
+#endif
+    ){
         // white list used?
         uint8_t initiator_filter_policy = packet[7];
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+        if (IS_COMMAND(packet, hci_le_extended_create_connection)){
+            initiator_filter_policy = packet[3];
+        }
+#endif
         switch (initiator_filter_policy){
             case 0:
                 // whitelist not used
@@ -4301,6 +5113,58 @@ int gap_request_connection_parameter_update(hci_con_handle_t con_handle, uint16_
     return 0;
 }
 
+uint8_t gap_le_set_phy(hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys, uint16_t phy_options){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if ((hci_stack->local_supported_commands[0] & 0x40) == 0) return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    connection->le_phy_all_phys = all_phys;
+    connection->le_phy_tx_phys  = tx_phys;
+    connection->le_phy_rx_phys  = rx_phys;
+    connection->le_phy_options  = phy_options;
+    connection->le_phy_todo |= LE_PHY_TASKS_SET_PHY;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_le_set_data_length(hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    if ((hci_stack->local_supported_commands[0] & 0x80) == 0) return ERROR_CODE_UNSUPPORTED_FEATURE_OR_PARAMETER_VALUE;
+    connection->le_data_length_tx_octets = btstack_max(LE_DATA_LENGTH_MIN_OCTETS, btstack_min(tx_octets, LE_DATA_LENGTH_MAX_OCTETS));
+    connection->le_data_length_tx_time   = btstack_max(LE_DATA_LENGTH_MIN_TIME, btstack_min(tx_time, LE_DATA_LENGTH_MAX_TIME_CODED));
+    connection->le_phy_todo |= LE_PHY_TASKS_SET_DATA_LENGTH;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_le_request_high_throughput(hci_con_handle_t con_handle){
+    uint8_t status = gap_le_set_data_length(con_handle, LE_DATA_LENGTH_MAX_OCTETS, LE_DATA_LENGTH_MAX_TIME_1M);
+    if (status == ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER) return status;
+    return gap_le_set_phy(con_handle, 0, LE_PHY_MASK_2M, LE_PHY_MASK_2M, 0);
+}
+
+uint8_t gap_le_request_long_range(hci_con_handle_t con_handle){
+    uint8_t status = gap_le_set_data_length(con_handle, LE_DATA_LENGTH_MAX_OCTETS, LE_DATA_LENGTH_MAX_TIME_CODED);
+    if (status == ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER) return status;
+    return gap_le_set_phy(con_handle, 0, LE_PHY_MASK_CODED, LE_PHY_MASK_CODED, 2);
+}
+
+uint8_t gap_le_get_phy(hci_con_handle_t con_handle, uint8_t * tx_phy, uint8_t * rx_phy){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    *tx_phy = connection->le_tx_phy;
+    *rx_phy = connection->le_rx_phy;
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_le_get_data_length(hci_con_handle_t con_handle, uint16_t * max_tx_octets, uint16_t * max_rx_octets){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return ERROR_CODE_UNKNOWN_CONNECTION_IDENTIFIER;
+    *max_tx_octets = connection->le_max_tx_octets;
+    *max_rx_octets = connection->le_max_rx_octets;
+    return ERROR_CODE_SUCCESS;
+}
+
 #ifdef ENABLE_LE_PERIPHERAL
 
 static void gap_advertisments_changed(void){
@@ -4337,6 +5201,175 @@ void gap_scan_response_set_data(uint8_t scan_response_data_length, uint8_t * sca
     gap_advertisments_changed();
 }
 
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+// advertising data of an active set can only be changed in a single HCI Command
+static void gap_extended_advertising_restart_if_active(le_advertising_set_t * advertising_set, uint16_t data_len){
+    if ((advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE) == 0) return;
+    if (data_len <= LE_EXTENDED_ADVERTISING_MAX_CHUNK_LEN) return;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_DISABLE | LE_ADVERTISEMENT_TASKS_ENABLE;
+}
+
+uint8_t gap_extended_advertising_setup(le_advertising_set_t * storage, const le_extended_advertising_parameters_t * advertising_parameters, uint8_t * out_advertising_handle){
+    // find lowest unused advertising handle, 0 is used for legacy advertising
+    uint8_t advertising_handle;
+    for (advertising_handle = 1; advertising_handle <= 0xef; advertising_handle++){
+        if (hci_advertising_set_for_handle(advertising_handle) == NULL) break;
+    }
+    if (advertising_handle > 0xef) return ERROR_CODE_MEMORY_CAPACITY_EXCEEDED;
+    memset(storage, 0, sizeof(le_advertising_set_t));
+    storage->advertising_handle = advertising_handle;
+    storage->extended_params = *advertising_parameters;
+    storage->tasks = LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+    if (advertising_parameters->own_address_type != BD_ADDR_TYPE_LE_PUBLIC){
+        storage->tasks |= LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+    }
+    btstack_linked_list_add_tail(&hci_stack->le_advertising_sets, (btstack_linked_item_t *) storage);
+    *out_advertising_handle = advertising_handle;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_params(uint8_t advertising_handle, const le_extended_advertising_parameters_t * advertising_parameters){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->extended_params = *advertising_parameters;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PARAMS;
+    if (advertising_parameters->own_address_type != BD_ADDR_TYPE_LE_PUBLIC){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS;
+    }
+    // parameters cannot be changed while advertising is enabled
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_DISABLE | LE_ADVERTISEMENT_TASKS_ENABLE;
+    }
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_adv_data(uint8_t advertising_handle, uint16_t advertising_data_length, const uint8_t * advertising_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (advertising_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_ADV_DATA){
+        // fragmented update in progress
+        if (advertising_set->adv_data_pos) return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    advertising_set->adv_data = advertising_data;
+    advertising_set->adv_data_len = advertising_data_length;
+    advertising_set->adv_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_ADV_DATA;
+    gap_extended_advertising_restart_if_active(advertising_set, advertising_data_length);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_set_scan_response_data(uint8_t advertising_handle, uint16_t scan_response_data_length, const uint8_t * scan_response_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (scan_response_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA){
+        // fragmented update in progress
+        if (advertising_set->scan_data_pos) return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    advertising_set->scan_data = scan_response_data;
+    advertising_set->scan_data_len = scan_response_data_length;
+    advertising_set->scan_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA;
+    gap_extended_advertising_restart_if_active(advertising_set, scan_response_data_length);
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_start(uint8_t advertising_handle, uint16_t timeout, uint8_t num_extended_advertising_events){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->enable_timeout = timeout;
+    advertising_set->enable_max_events = num_extended_advertising_events;
+    advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_DISABLE;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_ENABLE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_stop(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_ENABLE;
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_DISABLE;
+    }
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_extended_advertising_remove(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    uint16_t tasks = LE_ADVERTISEMENT_TASKS_REMOVE_SET;
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_ACTIVE){
+        tasks |= LE_ADVERTISEMENT_TASKS_DISABLE;
+    }
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE){
+        tasks |= LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE;
+    }
+    advertising_set->tasks = tasks;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_set_params(uint8_t advertising_handle, const le_periodic_advertising_parameters_t * advertising_parameters){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->periodic_params = *advertising_parameters;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS;
+    // parameters cannot be changed while periodic advertising is enabled
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE | LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE;
+    }
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_set_data(uint8_t advertising_handle, uint16_t periodic_data_length, const uint8_t * periodic_data){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    if (periodic_data_length > LE_EXTENDED_ADVERTISING_MAX_DATA_LEN) return ERROR_CODE_INVALID_HCI_COMMAND_PARAMETERS;
+    if (advertising_set->tasks & LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA){
+        // fragmented update in progress
+        if (advertising_set->periodic_data_pos) return ERROR_CODE_COMMAND_DISALLOWED;
+    }
+    advertising_set->periodic_data = periodic_data;
+    advertising_set->periodic_data_len = periodic_data_length;
+    advertising_set->periodic_data_pos = 0;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA;
+    // fragmented data can only be set while periodic advertising is disabled
+    if ((advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE) && (periodic_data_length > LE_EXTENDED_ADVERTISING_MAX_CHUNK_LEN)){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE | LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE;
+    }
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_start(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE;
+    advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE;
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+
+uint8_t gap_periodic_advertising_stop(uint8_t advertising_handle){
+    le_advertising_set_t * advertising_set = hci_advertising_set_for_handle(advertising_handle);
+    if (advertising_set == NULL) return ERROR_CODE_UNKNOWN_ADVERTISING_IDENTIFIER;
+    advertising_set->tasks &= ~LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE;
+    if (advertising_set->state & LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE){
+        advertising_set->tasks |= LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE;
+    }
+    hci_run();
+    return ERROR_CODE_SUCCESS;
+}
+#endif
+
 /**
  * @brief Set Advertisement Parameters
  * @param adv_int_min
@@ -4458,6 +5491,10 @@ int gap_auto_connection_start(bd_addr_type_t address_type, bd_addr_t address){
     return 0;
 }
 
+uint16_t gap_auto_connection_get_whitelist_size(void){
+    return hci_stack->le_whitelist_capacity;
+}
+
 static void hci_remove_from_whitelist(bd_addr_type_t address_type, bd_addr_t address){
     btstack_linked_list_iterator_t it;
     btstack_linked_list_iterator_init(&it, &hci_stack->le_whitelist);
@@ -4542,8 +5579,9 @@ int gap_inquiry_start(uint8_t duration_in_1280ms_units){
  * @returns 0 if ok
  */
 int gap_inquiry_stop(void){
-    if (hci_stack->inquiry_state >= GAP_INQUIRY_DURATION_MIN || hci_stack->inquiry_state <= GAP_INQUIRY_DURATION_MAX) {
+    if (hci_stack->inquiry_state >= GAP_INQUIRY_DURATION_MIN && hci_stack->inquiry_state <= GAP_INQUIRY_DURATION_MAX) {
         // emit inquiry complete event, before it even started
+        hci_stack->inquiry_state = GAP_INQUIRY_STATE_IDLE;
         uint8_t event[] = { GAP_EVENT_INQUIRY_COMPLETE, 1, 0};
         hci_emit_event(event, sizeof(event), 1);
         return 0;
@@ -49,6 +49,7 @@
 
 #include "btstack_chipset.h"
 #include "btstack_control.h"
+#include "btstack_crypto.h"
 #include "btstack_linked_list.h"
 #include "btstack_util.h"
 #include "classic/btstack_link_key_db.h"
@@ -73,7 +74,10 @@ extern "C" {
 // Max HCI Command LE payload size:
 // 64 from LE Generate DHKey command
 // 32 from LE Encrypt command
-#if defined(ENABLE_LE_SECURE_CONNECTIONS) && !defined(ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS)
+// 255 from LE Set Extended Advertising Data command
+#if defined(ENABLE_LE_EXTENDED_ADVERTISING)
+#define HCI_CMD_PAYLOAD_SIZE_LE 255
+#elif defined(ENABLE_LE_SECURE_CONNECTIONS) && !defined(ENABLE_MICRO_ECC_FOR_LE_SECURE_CONNECTIONS)
 #define HCI_CMD_PAYLOAD_SIZE_LE 64
 #else
 #define HCI_CMD_PAYLOAD_SIZE_LE 32
@@ -224,6 +228,23 @@ typedef enum {
     LE_CONNECTING_WHITELIST,
 } le_connecting_state_t;
 
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+typedef enum {
+    LE_RESOLVING_LIST_IDLE,
+    LE_RESOLVING_LIST_SEND_READ_SIZE,
+    LE_RESOLVING_LIST_SEND_DISABLE_ADDRESS_RESOLUTION,
+    LE_RESOLVING_LIST_SEND_CLEAR,
+    LE_RESOLVING_LIST_UPDATE_ENTRIES,
+    LE_RESOLVING_LIST_SEND_ENABLE_ADDRESS_RESOLUTION,
+    LE_RESOLVING_LIST_DONE,
+} le_resolving_list_state_t;
+
+// number of LE Device DB entries that can be mirrored into the Controller's Resolving List
+#ifndef MAX_NUM_RESOLVING_LIST_ENTRIES
+#define MAX_NUM_RESOLVING_LIST_ENTRIES 64
+#endif
+#endif
+
 #ifdef ENABLE_BLE
 
 //
@@ -359,6 +380,97 @@ typedef enum {
 
 typedef uint8_t sm_pairing_packet_t[7];
 
+typedef enum {
+    JUST_WORKS,
+    PK_RESP_INPUT,       // Initiator displays PK, responder inputs PK
+    PK_INIT_INPUT,       // Responder displays PK, initiator inputs PK
+    PK_BOTH_INPUT,       // Only input on both, both input PK
+    NUMERIC_COMPARISON,  // Only numerical compparison (yes/no) on on both sides
+    OOB                  // OOB available on one (SC) or both sides (legacy)
+} stk_generation_method_t;
+
+// data needed for security setup, allocated per connection during pairing and encryption setup
+typedef struct sm_setup_context {
+
+    btstack_timer_source_t sm_timeout;
+
+    // user response, (Phase 1 and/or 2)
+    uint8_t   sm_user_response;
+    uint8_t   sm_keypress_notification; // bitmap: passkey started, digit entered, digit erased, passkey cleared, passkey complete, 3 bit count
+
+    // defines which keys will be send after connection is encrypted - calculated during Phase 1, used Phase 3
+    int       sm_key_distribution_send_set;
+    int       sm_key_distribution_received_set;
+
+    // Phase 2 (Pairing over SMP)
+    stk_generation_method_t sm_stk_generation_method;
+    sm_key_t  sm_tk;
+    uint8_t   sm_have_oob_data;
+    uint8_t   sm_use_secure_connections;
+
+    sm_key_t  sm_c1_t3_value;   // c1 calculation
+    sm_pairing_packet_t sm_m_preq; // pairing request - needed only for c1
+    sm_pairing_packet_t sm_s_pres; // pairing response - needed only for c1
+    sm_key_t  sm_local_random;
+    sm_key_t  sm_local_confirm;
+    sm_key_t  sm_peer_random;
+    sm_key_t  sm_peer_confirm;
+    uint8_t   sm_m_addr_type;   // address and type can be removed
+    uint8_t   sm_s_addr_type;   //  ''
+    bd_addr_t sm_m_address;     //  ''
+    bd_addr_t sm_s_address;     //  ''
+    sm_key_t  sm_ltk;
+
+    uint8_t   sm_state_vars;
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    uint8_t   sm_peer_q[64];    // also stores random for EC key generation during init
+    sm_key_t  sm_peer_nonce;    // might be combined with sm_peer_random
+    sm_key_t  sm_local_nonce;   // might be combined with sm_local_random
+    sm_key_t  sm_dhkey;
+    sm_key_t  sm_peer_dhkey_check;
+    sm_key_t  sm_local_dhkey_check;
+    sm_key_t  sm_ra;
+    sm_key_t  sm_rb;
+    sm_key_t  sm_t;             // used for f5 and h6
+    sm_key_t  sm_mackey;
+    uint8_t   sm_passkey_bit;   // also stores number of generated random bytes for EC key generation
+#endif
+
+    // Phase 3
+
+    // key distribution, we generate
+    uint16_t  sm_local_y;
+    uint16_t  sm_local_div;
+    uint16_t  sm_local_ediv;
+    uint8_t   sm_local_rand[8];
+    sm_key_t  sm_local_ltk;
+    sm_key_t  sm_local_csrk;
+    sm_key_t  sm_local_irk;
+    // sm_local_address/addr_type not needed
+
+    // key distribution, received from peer
+    uint16_t  sm_peer_y;
+    uint16_t  sm_peer_div;
+    uint16_t  sm_peer_ediv;
+    uint8_t   sm_peer_rand[8];
+    sm_key_t  sm_peer_ltk;
+    sm_key_t  sm_peer_irk;
+    sm_key_t  sm_peer_csrk;
+    uint8_t   sm_peer_addr_type;
+    bd_addr_t sm_peer_address;
+
+    // crypto requests and their temp storage, queued by btstack_crypto
+    btstack_crypto_random_t   sm_crypto_random_request;
+    btstack_crypto_aes128_t   sm_crypto_aes128_request;
+#ifdef ENABLE_LE_SECURE_CONNECTIONS
+    btstack_crypto_ecc_p256_t sm_crypto_ecc_p256_request;
+#endif
+    uint8_t   sm_random_data[8];
+    sm_key_t  sm_aes128_plaintext;
+    sm_key_t  sm_aes128_ciphertext;
+
+} sm_setup_context_t;
+
 // connection info available as long as connection exists
 typedef struct sm_connection {
     hci_con_handle_t         sm_handle;
@@ -377,6 +489,8 @@ typedef struct sm_connection {
     uint16_t                 sm_local_ediv;
     uint8_t                  sm_local_rand[8];
     int                      sm_le_db_index;
+    uint8_t                  sm_pairing_failed_reason;
+    sm_setup_context_t *     sm_setup_context;  // only while pairing or encryption is set up
 } sm_connection_t;
 
 //
@@ -388,6 +502,11 @@ typedef struct sm_connection {
 #define ATT_REQUEST_BUFFER_SIZE HCI_ACL_PAYLOAD_SIZE
 #endif
 
+// buffer for streamed Write Commands per connection, see att_server_register_write_stream
+#ifndef ATT_SERVER_WRITE_STREAM_BUFFER_SIZE
+#define ATT_SERVER_WRITE_STREAM_BUFFER_SIZE 1024
+#endif
+
 typedef enum {
     ATT_SERVER_IDLE,
     ATT_SERVER_REQUEST_RECEIVED,
@@ -414,10 +533,46 @@ typedef struct {
     uint16_t                request_size;
     uint8_t                 request_buffer[ATT_REQUEST_BUFFER_SIZE];
 
+#ifdef ENABLE_ATT_SERVER_WRITE_STREAM
+    // concatenated values of Write Commands to write_stream_attribute_handle
+    uint16_t                write_stream_attribute_handle;
+    uint16_t                write_stream_validated_handle;
+    uint16_t                write_stream_len;
+    uint8_t                 write_stream_paused;
+    uint8_t                 write_stream_delivering;
+    btstack_timer_source_t  write_stream_timer;
+    uint8_t                 write_stream_buffer[ATT_SERVER_WRITE_STREAM_BUFFER_SIZE];
+#endif
+
 } att_server_t;
 
 #endif
 
+//
+// L2CAP
+//
+
+// number of L2CAP rejects, echo, and information responses queued per connection
+#ifndef L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE
+#define L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE 4
+#endif
+
+typedef struct l2cap_signaling_response {
+    uint8_t  sig_id;
+    uint8_t  code;
+    uint16_t cid;  // source cid for CONNECTION REQUEST
+    uint16_t data; // infoType for INFORMATION REQUEST, result for CONNECTION REQUEST and COMMAND UNKNOWN
+} l2cap_signaling_response_t;
+
+// ring buffer of pending signaling responses
+typedef struct {
+    l2cap_signaling_response_t responses[L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE];
+    uint8_t  head;
+    uint8_t  count;
+    // responses dropped as queue was full
+    uint16_t num_dropped;
+} l2cap_signaling_response_queue_t;
+
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
 typedef enum {
     L2CAP_INFORMATION_STATE_IDLE = 0,
@@ -483,6 +638,8 @@ typedef struct {
 
 #ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
     uint8_t num_packets_completed;
+    // withhold completed packets to stop Controller from delivering more ACL data
+    uint8_t acl_rx_paused;
 #endif
 
     // LE Connection parameter update
@@ -494,6 +651,32 @@ typedef struct {
     uint16_t le_supervision_timeout;
 
 #ifdef ENABLE_BLE
+    // LE PHY and Data Length - LE_PHY_TASKS_*
+    uint8_t  le_phy_todo;
+    uint8_t  le_phy_all_phys;
+    uint8_t  le_phy_tx_phys;
+    uint8_t  le_phy_rx_phys;
+    uint16_t le_phy_options;
+    uint16_t le_data_length_tx_octets;
+    uint16_t le_data_length_tx_time;
+    // current values
+    uint8_t  le_tx_phy;
+    uint8_t  le_rx_phy;
+    uint16_t le_max_tx_octets;
+    uint16_t le_max_rx_octets;
+
+    // number of ACL packets sent and received, used by LE Connection Parameter Manager
+    uint16_t le_num_acl_packets_tx;
+    uint16_t le_num_acl_packets_rx;
+
+    // LE Connection Parameter Manager
+    uint8_t  le_cpm_mode;
+    uint8_t  le_cpm_disabled;
+    uint8_t  le_cpm_update_pending;
+    uint16_t le_cpm_last_num_packets;
+    uint32_t le_cpm_last_update_ms;
+    uint32_t le_cpm_last_burst_ms;
+
     // LE Security Manager
     sm_connection_t sm_connection;
 
@@ -501,6 +684,9 @@ typedef struct {
     att_server_t    att_server;
 #endif
 
+    // L2CAP Signaling
+    l2cap_signaling_response_queue_t l2cap_signaling_responses;
+
 #ifdef ENABLE_L2CAP_ENHANCED_RETRANSMISSION_MODE
     l2cap_state_t l2cap_state;
 #endif
@@ -623,6 +809,23 @@ enum {
     LE_ADVERTISEMENT_TASKS_SET_SCAN_DATA = 1 << 2,
     LE_ADVERTISEMENT_TASKS_SET_PARAMS    = 1 << 3,
     LE_ADVERTISEMENT_TASKS_ENABLE        = 1 << 4,
+    // LE Extended Advertising Sets only
+    LE_ADVERTISEMENT_TASKS_SET_RANDOM_ADDRESS   = 1 << 5,
+    LE_ADVERTISEMENT_TASKS_SET_PERIODIC_PARAMS  = 1 << 6,
+    LE_ADVERTISEMENT_TASKS_SET_PERIODIC_DATA    = 1 << 7,
+    LE_ADVERTISEMENT_TASKS_PERIODIC_DISABLE     = 1 << 8,
+    LE_ADVERTISEMENT_TASKS_PERIODIC_ENABLE      = 1 << 9,
+    LE_ADVERTISEMENT_TASKS_REMOVE_SET           = 1 << 10,
+};
+
+enum {
+    LE_ADVERTISEMENT_STATE_ACTIVE          = 1 << 0,
+    LE_ADVERTISEMENT_STATE_PERIODIC_ACTIVE = 1 << 1,
+};
+
+enum {
+    LE_PHY_TASKS_SET_PHY         = 1 << 0,
+    LE_PHY_TASKS_SET_DATA_LENGTH = 1 << 1,
 };
 
 enum {
@@ -703,13 +906,20 @@ typedef struct {
     uint8_t local_supported_features[8];
 
     /* local supported commands summary - complete info is 64 bytes */
-    /* 0 - Read Buffer Size */
-    /* 1 - Write Le Host Supported */
-    /* 2 - Write Synchronous Flow Control Enable (Octet 10/bit 4) */
-    /* 3 - Write Default Erroneous Data Reporting (Octet 18/bit 3) */
-    /* 4 - LE Write Suggested Default Data Length (Octet 34/bit 0) */
-    /* 5 - LE Read Maximum Data Length (Octet 35/bit 3) */
-    uint8_t local_supported_commands[1];
+    /* [0] bit 0 - Read Buffer Size */
+    /* [0] bit 1 - Write Le Host Supported */
+    /* [0] bit 2 - Write Synchronous Flow Control Enable (Octet 10/bit 4) */
+    /* [0] bit 3 - Write Default Erroneous Data Reporting (Octet 18/bit 3) */
+    /* [0] bit 4 - LE Write Suggested Default Data Length (Octet 34/bit 0) */
+    /* [0] bit 5 - LE Read Maximum Data Length (Octet 35/bit 3) */
+    /* [0] bit 6 - LE Set PHY (Octet 35/bit 6) */
+    /* [0] bit 7 - LE Set Data Length (Octet 33/bit 6) */
+    /* [1] bit 0 - LE Set Extended Advertising Parameters (Octet 36/bit 2) */
+    /* [1] bit 1 - LE Set Extended Scan Parameters (Octet 37/bit 5) */
+    /* [1] bit 2 - LE Extended Create Connection (Octet 37/bit 7) */
+    /* [1] bit 3 - LE Set Periodic Advertising Parameters (Octet 37/bit 2) */
+    /* [1] bit 4 - LE Set Address Resolution Enable (Octet 35/bit 1) */
+    uint8_t local_supported_commands[2];
 
     /* bluetooth device information from hci read local version information */
     // uint16_t hci_version;
@@ -819,6 +1029,32 @@ typedef struct {
     bd_addr_t le_advertisements_direct_address;
 
     uint8_t le_max_number_peripheral_connections;
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+    // LE Extended Advertising Sets, legacy advertising uses advertising handle 0
+    btstack_linked_list_t le_advertising_sets;
+    uint8_t le_advertisements_legacy_set_configured;
+#endif
+#endif
+
+#if defined(ENABLE_LE_CENTRAL) && defined(ENABLE_LE_EXTENDED_ADVERTISING)
+    // reassembly of fragmented LE Extended Advertising Report, includes GAP_EVENT_EXTENDED_ADVERTISING_REPORT header
+    uint8_t  le_extended_report_buffer[2 + 25 + LE_EXTENDED_ADVERTISING_MAX_DATA_LEN];
+    uint16_t le_extended_report_data_len;
+    uint8_t  le_extended_report_active;
+#endif
+
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+    // LE Resolving List Management, mirrors LE Device DB entries with IRK, bit per LE Device DB index
+    le_resolving_list_state_t le_resolving_list_state;
+    uint8_t  le_resolving_list_size;
+    uint8_t  le_resolving_list_num_entries;
+    uint8_t  le_resolving_list_reload;
+    uint16_t le_resolving_list_pending_index;
+    uint8_t  le_resolving_list_address_resolution_enable;
+    sm_key_t le_resolving_list_local_irk;
+    uint8_t  le_resolving_list_add_entries[(MAX_NUM_RESOLVING_LIST_ENTRIES + 7) / 8];
+    uint8_t  le_resolving_list_on_controller[(MAX_NUM_RESOLVING_LIST_ENTRIES + 7) / 8];
 #endif
 
 #ifdef ENABLE_LE_DATA_LENGTH_EXTENSION
@@ -1105,6 +1341,14 @@ void hci_disconnect_all(void);
  */
 int hci_number_free_acl_slots_for_handle(hci_con_handle_t con_handle);
 
+#ifdef ENABLE_HCI_CONTROLLER_TO_HOST_FLOW_CONTROL
+/**
+ * Pause reception of ACL packets for connection by not reporting them as completed to the Controller.
+ * Paused connections keep Controller buffers that are shared with other connections. Used by ATT Server
+ */
+void hci_set_acl_rx_paused(hci_con_handle_t con_handle, int paused);
+#endif
+
 /**
  * @brief Set Advertisement Parameters
  * @param adv_int_min
@@ -1126,6 +1370,35 @@ void hci_le_advertisements_set_params(uint16_t adv_int_min, uint16_t adv_int_max
  */
 void hci_le_set_own_address_type(uint8_t own_address_type);
 
+#ifdef ENABLE_LE_PRIVACY_ADDRESS_RESOLUTION
+/**
+ * @brief Set local IRK and load all LE Device DB entries with IRK into Controller's Resolving List
+ * @param irk
+ * @note internal use by SM
+ */
+void hci_le_resolving_list_set_local_irk(const sm_key_t irk);
+
+/**
+ * @brief Add LE Device DB entry to Controller's Resolving List, e.g. after bonding
+ * @param le_device_db_index
+ * @note internal use by SM
+ */
+void hci_le_resolving_list_add_device_db_entry(uint16_t le_device_db_index);
+
+/**
+ * @brief Remove LE Device DB entry from Controller's Resolving List, needs to be called before le_device_db_remove
+ * @param le_device_db_index
+ */
+void hci_le_resolving_list_remove_device_db_entry(uint16_t le_device_db_index);
+
+/**
+ * @brief Check if Controller resolves private addresses of LE Device DB entry
+ * @param le_device_db_index
+ * @return 1 if entry is on Resolving List and address resolution is enabled
+ */
+int hci_le_resolving_list_contains_device_db_entry(uint16_t le_device_db_index);
+#endif
+
 /**
  * @brief Get Manufactured
  * @return manufacturer id
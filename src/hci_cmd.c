@@ -69,6 +69,7 @@
  *   A: 31 bytes advertising data
  *   S: Service Record (Data Element Sequence)
  *   Q: 32 byte data block, e.g. for X and Y coordinates of P-256 public key
+ *   J: 8 bit length followed by data block of given length, e.g. LE Extended Advertising Data
  */
 uint16_t hci_cmd_create_from_template(uint8_t *hci_cmd_buffer, const hci_cmd_t *cmd, va_list argptr){
     
@@ -160,6 +161,16 @@ uint16_t hci_cmd_create_from_template(uint8_t *hci_cmd_buffer, const hci_cmd_t *
                 break;
             }
 #endif
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+            case 'J': { // 8 bit len + data block
+                uint8_t len = va_arg(argptr, int);
+                ptr = va_arg(argptr, uint8_t *);
+                hci_cmd_buffer[pos++] = len;
+                memcpy(&hci_cmd_buffer[pos], ptr, len);
+                pos += len;
+                break;
+            }
+#endif
 #ifdef ENABLE_LE_SECURE_CONNECTIONS
             case 'Q':
                 ptr = va_arg(argptr, uint8_t *);
@@ -1173,6 +1184,56 @@ OPCODE(OGF_LE_CONTROLLER, 0x26), "QQ"
 // LE Generate DHKey Complete is generated on completion
 };
 
+/**
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ * @param peer_irk
+ * @param local_irk
+ */
+const hci_cmd_t hci_le_add_device_to_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x27), "1BPP"
+// return: status
+};
+
+/**
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ */
+const hci_cmd_t hci_le_remove_device_from_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x28), "1B"
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_clear_resolving_list = {
+OPCODE(OGF_LE_CONTROLLER, 0x29), ""
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_resolving_list_size = {
+OPCODE(OGF_LE_CONTROLLER, 0x2A), ""
+// return: status, resolving list size
+};
+
+/**
+ * @param address_resolution_enable
+ */
+const hci_cmd_t hci_le_set_address_resolution_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x2D), "1"
+// return: status
+};
+
+/**
+ * @param rpa_timeout in seconds
+ */
+const hci_cmd_t hci_le_set_resolvable_private_address_timeout = {
+OPCODE(OGF_LE_CONTROLLER, 0x2E), "2"
+// return: status
+};
+
 /**
  */
 const hci_cmd_t hci_le_read_maximum_data_length = {
@@ -1180,6 +1241,214 @@ OPCODE(OGF_LE_CONTROLLER, 0x2F), ""
 // return: status, supported max tx octets, supported max tx time, supported max rx octets, supported max rx time
 };
 
+/**
+ * @param con_handle
+ */
+const hci_cmd_t hci_le_read_phy = {
+OPCODE(OGF_LE_CONTROLLER, 0x30), "H"
+// return: status, connection handler, tx phy, rx phy
+};
+
+/**
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ */
+const hci_cmd_t hci_le_set_default_phy = {
+OPCODE(OGF_LE_CONTROLLER, 0x31), "111"
+// return: status
+};
+
+/**
+ * @param con_handle
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ * @param phy_options
+ */
+const hci_cmd_t hci_le_set_phy = {
+OPCODE(OGF_LE_CONTROLLER, 0x32), "H1112"
+// LE PHY Update Complete is generated on completion
+};
+
+#ifdef ENABLE_LE_EXTENDED_ADVERTISING
+
+/**
+ * @param advertising_handle
+ * @param random_address
+ */
+const hci_cmd_t hci_le_set_advertising_set_random_address = {
+OPCODE(OGF_LE_CONTROLLER, 0x35), "1B"
+// return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param advertising_event_properties
+ * @param primary_advertising_interval_min
+ * @param primary_advertising_interval_max
+ * @param primary_advertising_channel_map
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param advertising_filter_policy
+ * @param advertising_tx_power
+ * @param primary_advertising_phy
+ * @param secondary_advertising_max_skip
+ * @param secondary_advertising_phy
+ * @param advertising_sid
+ * @param scan_request_notification_enable
+ */
+const hci_cmd_t hci_le_set_extended_advertising_parameters = {
+OPCODE(OGF_LE_CONTROLLER, 0x36), "1233111B1111111"
+// return: status, selected tx power
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param fragment_preference
+ * @param advertising_data_length
+ * @param advertising_data
+ */
+const hci_cmd_t hci_le_set_extended_advertising_data = {
+OPCODE(OGF_LE_CONTROLLER, 0x37), "111J"
+// return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param fragment_preference
+ * @param scan_response_data_length
+ * @param scan_response_data
+ */
+const hci_cmd_t hci_le_set_extended_scan_response_data = {
+OPCODE(OGF_LE_CONTROLLER, 0x38), "111J"
+// return: status
+};
+
+/**
+ * @note only a single advertising set can be enabled/disabled per command
+ * @param enable
+ * @param number_of_sets (1)
+ * @param advertising_handle
+ * @param duration
+ * @param max_extended_advertising_events
+ */
+const hci_cmd_t hci_le_set_extended_advertising_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x39), "11121"
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_maximum_advertising_data_length = {
+OPCODE(OGF_LE_CONTROLLER, 0x3A), ""
+// return: status, max advertising data length
+};
+
+/**
+ */
+const hci_cmd_t hci_le_read_number_of_supported_advertising_sets = {
+OPCODE(OGF_LE_CONTROLLER, 0x3B), ""
+// return: status, number of supported advertising sets
+};
+
+/**
+ * @param advertising_handle
+ */
+const hci_cmd_t hci_le_remove_advertising_set = {
+OPCODE(OGF_LE_CONTROLLER, 0x3C), "1"
+// return: status
+};
+
+/**
+ */
+const hci_cmd_t hci_le_clear_advertising_sets = {
+OPCODE(OGF_LE_CONTROLLER, 0x3D), ""
+// return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param periodic_advertising_interval_min
+ * @param periodic_advertising_interval_max
+ * @param periodic_advertising_properties
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_parameters = {
+OPCODE(OGF_LE_CONTROLLER, 0x3E), "1222"
+// return: status
+};
+
+/**
+ * @param advertising_handle
+ * @param operation
+ * @param advertising_data_length
+ * @param advertising_data
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_data = {
+OPCODE(OGF_LE_CONTROLLER, 0x3F), "11J"
+// return: status
+};
+
+/**
+ * @param enable
+ * @param advertising_handle
+ */
+const hci_cmd_t hci_le_set_periodic_advertising_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x40), "11"
+// return: status
+};
+
+/**
+ * @note only a single PHY can be configured per command
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @param scanning_phys
+ * @param scan_type
+ * @param scan_interval
+ * @param scan_window
+ */
+const hci_cmd_t hci_le_set_extended_scan_parameters = {
+OPCODE(OGF_LE_CONTROLLER, 0x41), "111122"
+// return: status
+};
+
+/**
+ * @param enable
+ * @param filter_duplicates
+ * @param duration
+ * @param period
+ */
+const hci_cmd_t hci_le_set_extended_scan_enable = {
+OPCODE(OGF_LE_CONTROLLER, 0x42), "1122"
+// return: status
+};
+
+/**
+ * @note only a single PHY can be configured per command
+ * @param initiator_filter_policy
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param initiating_phys
+ * @param scan_interval
+ * @param scan_window
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param min_ce_length
+ * @param max_ce_length
+ */
+const hci_cmd_t hci_le_extended_create_connection = {
+OPCODE(OGF_LE_CONTROLLER, 0x43), "111B122222222"
+// LE Connection Complete or LE Enhanced Connection Complete is generated on completion
+};
+
+#endif
+
 #endif
 
 // Broadcom / Cypress specific HCI commands
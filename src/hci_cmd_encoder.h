@@ -0,0 +1,2439 @@
+/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+
+
+/*
+ *  hci_cmd_encoder.h
+ *
+ *  @brief Typed encoders for HCI Commands, same output as hci_cmd_create_from_template
+ *  @note  Don't edit - generated by tool/btstack_hci_cmd_encoder_generator.py
+ *
+ */
+
+#ifndef __HCI_CMD_ENCODER_H
+#define __HCI_CMD_ENCODER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include "bluetooth.h"
+#include "btstack_util.h"
+#include <stdint.h>
+#include <string.h>
+
+/* API_START */
+
+/**
+ * @brief Create hci_inquiry command in buffer
+ * @param buffer for HCI Command of at least 8 bytes
+ * @param lap
+ * @param inquiry_length
+ * @param num_responses
+ * @return size of HCI Command
+ * @note: btstack_type 311
+ */
+static inline uint16_t hci_cmd_create_inquiry(uint8_t * buffer, uint32_t lap, uint8_t inquiry_length, uint8_t num_responses){
+    little_endian_store_16(buffer, 0, 0x01 | (OGF_LINK_CONTROL << 10));
+    buffer[3] = lap;
+    buffer[3 + 1] = lap >> 8;
+    buffer[3 + 2] = lap >> 16;
+    buffer[6] = inquiry_length;
+    buffer[7] = num_responses;
+    buffer[2] = 5;
+    return 8;
+}
+
+/**
+ * @brief Create hci_inquiry_cancel command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_inquiry_cancel(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x02 | (OGF_LINK_CONTROL << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_create_connection command in buffer
+ * @param buffer for HCI Command of at least 16 bytes
+ * @param bd_addr
+ * @param packet_type
+ * @param page_scan_repetition_mode
+ * @param reserved
+ * @param clock_offset
+ * @param allow_role_switch
+ * @return size of HCI Command
+ * @note: btstack_type B21121
+ */
+static inline uint16_t hci_cmd_create_create_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint16_t packet_type, uint8_t page_scan_repetition_mode, uint8_t reserved, uint16_t clock_offset, uint8_t allow_role_switch){
+    little_endian_store_16(buffer, 0, 0x05 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    little_endian_store_16(buffer, 9, packet_type);
+    buffer[11] = page_scan_repetition_mode;
+    buffer[12] = reserved;
+    little_endian_store_16(buffer, 13, clock_offset);
+    buffer[15] = allow_role_switch;
+    buffer[2] = 13;
+    return 16;
+}
+
+/**
+ * @brief Create hci_disconnect command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param handle
+ * @param reason
+ * @return size of HCI Command
+ * @note: btstack_type H1
+ */
+static inline uint16_t hci_cmd_create_disconnect(uint8_t * buffer, hci_con_handle_t handle, uint8_t reason){
+    little_endian_store_16(buffer, 0, 0x06 | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[5] = reason;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_create_connection_cancel command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_create_connection_cancel(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x08 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_accept_connection_request command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param bd_addr
+ * @param role
+ * @return size of HCI Command
+ * @note: btstack_type B1
+ */
+static inline uint16_t hci_cmd_create_accept_connection_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t role){
+    little_endian_store_16(buffer, 0, 0x09 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = role;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_reject_connection_request command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param bd_addr
+ * @param reason
+ * @return size of HCI Command
+ * @note: btstack_type B1
+ */
+static inline uint16_t hci_cmd_create_reject_connection_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t reason){
+    little_endian_store_16(buffer, 0, 0x0a | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = reason;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_link_key_request_reply command in buffer
+ * @param buffer for HCI Command of at least 25 bytes
+ * @param bd_addr
+ * @param link_key
+ * @return size of HCI Command
+ * @note: btstack_type BP
+ */
+static inline uint16_t hci_cmd_create_link_key_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, const uint8_t * link_key){
+    little_endian_store_16(buffer, 0, 0x0b | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    memcpy(&buffer[9], link_key, 16);
+    buffer[2] = 22;
+    return 25;
+}
+
+/**
+ * @brief Create hci_link_key_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_link_key_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x0c | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_pin_code_request_reply command in buffer
+ * @param buffer for HCI Command of at least 26 bytes
+ * @param bd_addr
+ * @param pin_length
+ * @param pin
+ * @return size of HCI Command
+ * @note: btstack_type B1P
+ */
+static inline uint16_t hci_cmd_create_pin_code_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t pin_length, const uint8_t * pin){
+    little_endian_store_16(buffer, 0, 0x0d | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = pin_length;
+    memcpy(&buffer[10], pin, 16);
+    buffer[2] = 23;
+    return 26;
+}
+
+/**
+ * @brief Create hci_pin_code_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_pin_code_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x0e | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_change_connection_packet_type command in buffer
+ * @param buffer for HCI Command of at least 7 bytes
+ * @param handle
+ * @param packet_type
+ * @return size of HCI Command
+ * @note: btstack_type H2
+ */
+static inline uint16_t hci_cmd_create_change_connection_packet_type(uint8_t * buffer, hci_con_handle_t handle, uint16_t packet_type){
+    little_endian_store_16(buffer, 0, 0x0f | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_16(buffer, 5, packet_type);
+    buffer[2] = 4;
+    return 7;
+}
+
+/**
+ * @brief Create hci_authentication_requested command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_authentication_requested(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x11 | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_set_connection_encryption command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param handle
+ * @param encryption_enable
+ * @return size of HCI Command
+ * @note: btstack_type H1
+ */
+static inline uint16_t hci_cmd_create_set_connection_encryption(uint8_t * buffer, hci_con_handle_t handle, uint8_t encryption_enable){
+    little_endian_store_16(buffer, 0, 0x13 | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[5] = encryption_enable;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_change_connection_link_key command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_change_connection_link_key(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x15 | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_remote_name_request command in buffer
+ * @param buffer for HCI Command of at least 13 bytes
+ * @param bd_addr
+ * @param page_scan_repetition_mode
+ * @param reserved
+ * @param clock_offset
+ * @return size of HCI Command
+ * @note: btstack_type B112
+ */
+static inline uint16_t hci_cmd_create_remote_name_request(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t page_scan_repetition_mode, uint8_t reserved, uint16_t clock_offset){
+    little_endian_store_16(buffer, 0, 0x19 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = page_scan_repetition_mode;
+    buffer[10] = reserved;
+    little_endian_store_16(buffer, 11, clock_offset);
+    buffer[2] = 10;
+    return 13;
+}
+
+/**
+ * @brief Create hci_remote_name_request_cancel command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_remote_name_request_cancel(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x1A | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_read_remote_supported_features_command command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_read_remote_supported_features_command(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x1B | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_setup_synchronous_connection command in buffer
+ * @param buffer for HCI Command of at least 20 bytes
+ * @param handle
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param max_latency
+ * @param voice_settings
+ * @param retransmission_effort
+ * @param packet_type
+ * @return size of HCI Command
+ * @note: btstack_type H442212
+ */
+static inline uint16_t hci_cmd_create_setup_synchronous_connection(uint8_t * buffer, hci_con_handle_t handle, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint16_t max_latency, uint16_t voice_settings, uint8_t retransmission_effort, uint16_t packet_type){
+    little_endian_store_16(buffer, 0, 0x0028 | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_32(buffer, 5, transmit_bandwidth);
+    little_endian_store_32(buffer, 9, receive_bandwidth);
+    little_endian_store_16(buffer, 13, max_latency);
+    little_endian_store_16(buffer, 15, voice_settings);
+    buffer[17] = retransmission_effort;
+    little_endian_store_16(buffer, 18, packet_type);
+    buffer[2] = 17;
+    return 20;
+}
+
+/**
+ * @brief Create hci_accept_synchronous_connection command in buffer
+ * @param buffer for HCI Command of at least 24 bytes
+ * @param bd_addr
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param max_latency
+ * @param voice_settings
+ * @param retransmission_effort
+ * @param packet_type
+ * @return size of HCI Command
+ * @note: btstack_type B442212
+ */
+static inline uint16_t hci_cmd_create_accept_synchronous_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint16_t max_latency, uint16_t voice_settings, uint8_t retransmission_effort, uint16_t packet_type){
+    little_endian_store_16(buffer, 0, 0x0029 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    little_endian_store_32(buffer, 9, transmit_bandwidth);
+    little_endian_store_32(buffer, 13, receive_bandwidth);
+    little_endian_store_16(buffer, 17, max_latency);
+    little_endian_store_16(buffer, 19, voice_settings);
+    buffer[21] = retransmission_effort;
+    little_endian_store_16(buffer, 22, packet_type);
+    buffer[2] = 21;
+    return 24;
+}
+
+/**
+ * @brief Create hci_io_capability_request_reply command in buffer
+ * @param buffer for HCI Command of at least 12 bytes
+ * @param bd_addr
+ * @param io_capability
+ * @param oob_data_present
+ * @param authentication_requirements
+ * @return size of HCI Command
+ * @note: btstack_type B111
+ */
+static inline uint16_t hci_cmd_create_io_capability_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t io_capability, uint8_t oob_data_present, uint8_t authentication_requirements){
+    little_endian_store_16(buffer, 0, 0x2b | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = io_capability;
+    buffer[10] = oob_data_present;
+    buffer[11] = authentication_requirements;
+    buffer[2] = 9;
+    return 12;
+}
+
+/**
+ * @brief Create hci_user_confirmation_request_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_user_confirmation_request_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x2c | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_user_confirmation_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_user_confirmation_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x2d | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_user_passkey_request_reply command in buffer
+ * @param buffer for HCI Command of at least 13 bytes
+ * @param bd_addr
+ * @param numeric_value
+ * @return size of HCI Command
+ * @note: btstack_type B4
+ */
+static inline uint16_t hci_cmd_create_user_passkey_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t numeric_value){
+    little_endian_store_16(buffer, 0, 0x2e | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    little_endian_store_32(buffer, 9, numeric_value);
+    buffer[2] = 10;
+    return 13;
+}
+
+/**
+ * @brief Create hci_user_passkey_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_user_passkey_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x2f | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_remote_oob_data_request_reply command in buffer
+ * @param buffer for HCI Command of at least 41 bytes
+ * @param bd_addr
+ * @param c
+ * @param r
+ * @return size of HCI Command
+ * @note: btstack_type BPP
+ */
+static inline uint16_t hci_cmd_create_remote_oob_data_request_reply(uint8_t * buffer, const bd_addr_t bd_addr, const uint8_t * c, const uint8_t * r){
+    little_endian_store_16(buffer, 0, 0x30 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    memcpy(&buffer[9], c, 16);
+    memcpy(&buffer[25], r, 16);
+    buffer[2] = 38;
+    return 41;
+}
+
+/**
+ * @brief Create hci_remote_oob_data_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_remote_oob_data_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x33 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_io_capability_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param bd_addr
+ * @param reason
+ * @return size of HCI Command
+ * @note: btstack_type B1
+ */
+static inline uint16_t hci_cmd_create_io_capability_request_negative_reply(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t reason){
+    little_endian_store_16(buffer, 0, 0x34 | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = reason;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_enhanced_setup_synchronous_connection command in buffer
+ * @param buffer for HCI Command of at least 62 bytes
+ * @param handle
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param transmit_coding_format_type
+ * @param transmit_coding_format_company
+ * @param transmit_coding_format_codec
+ * @param receive_coding_format_type
+ * @param receive_coding_format_company
+ * @param receive_coding_format_codec
+ * @param transmit_coding_frame_size
+ * @param receive_coding_frame_size
+ * @param input_bandwidth
+ * @param output_bandwidth
+ * @param input_coding_format_type
+ * @param input_coding_format_company
+ * @param input_coding_format_codec
+ * @param output_coding_format_type
+ * @param output_coding_format_company
+ * @param output_coding_format_codec
+ * @param input_coded_data_size
+ * @param outupt_coded_data_size
+ * @param input_pcm_data_format
+ * @param output_pcm_data_format
+ * @param input_pcm_sample_payload_msb_position
+ * @param output_pcm_sample_payload_msb_position
+ * @param input_data_path
+ * @param output_data_path
+ * @param input_transport_unit_size
+ * @param output_transport_unit_size
+ * @param max_latency
+ * @param packet_type
+ * @param retransmission_effort
+ * @return size of HCI Command
+ * @note: btstack_type H4412212222441221222211111111221
+ */
+static inline uint16_t hci_cmd_create_enhanced_setup_synchronous_connection(uint8_t * buffer, hci_con_handle_t handle, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint8_t transmit_coding_format_type, uint16_t transmit_coding_format_company, uint16_t transmit_coding_format_codec, uint8_t receive_coding_format_type, uint16_t receive_coding_format_company, uint16_t receive_coding_format_codec, uint16_t transmit_coding_frame_size, uint16_t receive_coding_frame_size, uint32_t input_bandwidth, uint32_t output_bandwidth, uint8_t input_coding_format_type, uint16_t input_coding_format_company, uint16_t input_coding_format_codec, uint8_t output_coding_format_type, uint16_t output_coding_format_company, uint16_t output_coding_format_codec, uint16_t input_coded_data_size, uint16_t outupt_coded_data_size, uint8_t input_pcm_data_format, uint8_t output_pcm_data_format, uint8_t input_pcm_sample_payload_msb_position, uint8_t output_pcm_sample_payload_msb_position, uint8_t input_data_path, uint8_t output_data_path, uint8_t input_transport_unit_size, uint8_t output_transport_unit_size, uint16_t max_latency, uint16_t packet_type, uint8_t retransmission_effort){
+    little_endian_store_16(buffer, 0, 0x3d | (OGF_LINK_CONTROL << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_32(buffer, 5, transmit_bandwidth);
+    little_endian_store_32(buffer, 9, receive_bandwidth);
+    buffer[13] = transmit_coding_format_type;
+    little_endian_store_16(buffer, 14, transmit_coding_format_company);
+    little_endian_store_16(buffer, 16, transmit_coding_format_codec);
+    buffer[18] = receive_coding_format_type;
+    little_endian_store_16(buffer, 19, receive_coding_format_company);
+    little_endian_store_16(buffer, 21, receive_coding_format_codec);
+    little_endian_store_16(buffer, 23, transmit_coding_frame_size);
+    little_endian_store_16(buffer, 25, receive_coding_frame_size);
+    little_endian_store_32(buffer, 27, input_bandwidth);
+    little_endian_store_32(buffer, 31, output_bandwidth);
+    buffer[35] = input_coding_format_type;
+    little_endian_store_16(buffer, 36, input_coding_format_company);
+    little_endian_store_16(buffer, 38, input_coding_format_codec);
+    buffer[40] = output_coding_format_type;
+    little_endian_store_16(buffer, 41, output_coding_format_company);
+    little_endian_store_16(buffer, 43, output_coding_format_codec);
+    little_endian_store_16(buffer, 45, input_coded_data_size);
+    little_endian_store_16(buffer, 47, outupt_coded_data_size);
+    buffer[49] = input_pcm_data_format;
+    buffer[50] = output_pcm_data_format;
+    buffer[51] = input_pcm_sample_payload_msb_position;
+    buffer[52] = output_pcm_sample_payload_msb_position;
+    buffer[53] = input_data_path;
+    buffer[54] = output_data_path;
+    buffer[55] = input_transport_unit_size;
+    buffer[56] = output_transport_unit_size;
+    little_endian_store_16(buffer, 57, max_latency);
+    little_endian_store_16(buffer, 59, packet_type);
+    buffer[61] = retransmission_effort;
+    buffer[2] = 59;
+    return 62;
+}
+
+/**
+ * @brief Create hci_enhanced_accept_synchronous_connection command in buffer
+ * @param buffer for HCI Command of at least 66 bytes
+ * @param bd_addr
+ * @param transmit_bandwidth
+ * @param receive_bandwidth
+ * @param transmit_coding_format_type
+ * @param transmit_coding_format_company
+ * @param transmit_coding_format_codec
+ * @param receive_coding_format_type
+ * @param receive_coding_format_company
+ * @param receive_coding_format_codec
+ * @param transmit_coding_frame_size
+ * @param receive_coding_frame_size
+ * @param input_bandwidth
+ * @param output_bandwidth
+ * @param input_coding_format_type
+ * @param input_coding_format_company
+ * @param input_coding_format_codec
+ * @param output_coding_format_type
+ * @param output_coding_format_company
+ * @param output_coding_format_codec
+ * @param input_coded_data_size
+ * @param outupt_coded_data_size
+ * @param input_pcm_data_format
+ * @param output_pcm_data_format
+ * @param input_pcm_sample_payload_msb_position
+ * @param output_pcm_sample_payload_msb_position
+ * @param input_data_path
+ * @param output_data_path
+ * @param input_transport_unit_size
+ * @param output_transport_unit_size
+ * @param max_latency
+ * @param packet_type
+ * @param retransmission_effort
+ * @return size of HCI Command
+ * @note: btstack_type B4412212222441221222211111111221
+ */
+static inline uint16_t hci_cmd_create_enhanced_accept_synchronous_connection(uint8_t * buffer, const bd_addr_t bd_addr, uint32_t transmit_bandwidth, uint32_t receive_bandwidth, uint8_t transmit_coding_format_type, uint16_t transmit_coding_format_company, uint16_t transmit_coding_format_codec, uint8_t receive_coding_format_type, uint16_t receive_coding_format_company, uint16_t receive_coding_format_codec, uint16_t transmit_coding_frame_size, uint16_t receive_coding_frame_size, uint32_t input_bandwidth, uint32_t output_bandwidth, uint8_t input_coding_format_type, uint16_t input_coding_format_company, uint16_t input_coding_format_codec, uint8_t output_coding_format_type, uint16_t output_coding_format_company, uint16_t output_coding_format_codec, uint16_t input_coded_data_size, uint16_t outupt_coded_data_size, uint8_t input_pcm_data_format, uint8_t output_pcm_data_format, uint8_t input_pcm_sample_payload_msb_position, uint8_t output_pcm_sample_payload_msb_position, uint8_t input_data_path, uint8_t output_data_path, uint8_t input_transport_unit_size, uint8_t output_transport_unit_size, uint16_t max_latency, uint16_t packet_type, uint8_t retransmission_effort){
+    little_endian_store_16(buffer, 0, 0x3e | (OGF_LINK_CONTROL << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    little_endian_store_32(buffer, 9, transmit_bandwidth);
+    little_endian_store_32(buffer, 13, receive_bandwidth);
+    buffer[17] = transmit_coding_format_type;
+    little_endian_store_16(buffer, 18, transmit_coding_format_company);
+    little_endian_store_16(buffer, 20, transmit_coding_format_codec);
+    buffer[22] = receive_coding_format_type;
+    little_endian_store_16(buffer, 23, receive_coding_format_company);
+    little_endian_store_16(buffer, 25, receive_coding_format_codec);
+    little_endian_store_16(buffer, 27, transmit_coding_frame_size);
+    little_endian_store_16(buffer, 29, receive_coding_frame_size);
+    little_endian_store_32(buffer, 31, input_bandwidth);
+    little_endian_store_32(buffer, 35, output_bandwidth);
+    buffer[39] = input_coding_format_type;
+    little_endian_store_16(buffer, 40, input_coding_format_company);
+    little_endian_store_16(buffer, 42, input_coding_format_codec);
+    buffer[44] = output_coding_format_type;
+    little_endian_store_16(buffer, 45, output_coding_format_company);
+    little_endian_store_16(buffer, 47, output_coding_format_codec);
+    little_endian_store_16(buffer, 49, input_coded_data_size);
+    little_endian_store_16(buffer, 51, outupt_coded_data_size);
+    buffer[53] = input_pcm_data_format;
+    buffer[54] = output_pcm_data_format;
+    buffer[55] = input_pcm_sample_payload_msb_position;
+    buffer[56] = output_pcm_sample_payload_msb_position;
+    buffer[57] = input_data_path;
+    buffer[58] = output_data_path;
+    buffer[59] = input_transport_unit_size;
+    buffer[60] = output_transport_unit_size;
+    little_endian_store_16(buffer, 61, max_latency);
+    little_endian_store_16(buffer, 63, packet_type);
+    buffer[65] = retransmission_effort;
+    buffer[2] = 63;
+    return 66;
+}
+
+/**
+ * @brief Create hci_sniff_mode command in buffer
+ * @param buffer for HCI Command of at least 13 bytes
+ * @param handle
+ * @param sniff_max_interval
+ * @param sniff_min_interval
+ * @param sniff_attempt
+ * @param sniff_timeout
+ * @return size of HCI Command
+ * @note: btstack_type H2222
+ */
+static inline uint16_t hci_cmd_create_sniff_mode(uint8_t * buffer, hci_con_handle_t handle, uint16_t sniff_max_interval, uint16_t sniff_min_interval, uint16_t sniff_attempt, uint16_t sniff_timeout){
+    little_endian_store_16(buffer, 0, 0x03 | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_16(buffer, 5, sniff_max_interval);
+    little_endian_store_16(buffer, 7, sniff_min_interval);
+    little_endian_store_16(buffer, 9, sniff_attempt);
+    little_endian_store_16(buffer, 11, sniff_timeout);
+    buffer[2] = 10;
+    return 13;
+}
+
+/**
+ * @brief Create hci_qos_setup command in buffer
+ * @param buffer for HCI Command of at least 23 bytes
+ * @param handle
+ * @param flags
+ * @param service_type
+ * @param token_rate
+ * @param peak_bandwith
+ * @param latency
+ * @param delay_variation
+ * @return size of HCI Command
+ * @note: btstack_type H114444
+ */
+static inline uint16_t hci_cmd_create_qos_setup(uint8_t * buffer, hci_con_handle_t handle, uint8_t flags, uint8_t service_type, uint32_t token_rate, uint32_t peak_bandwith, uint32_t latency, uint32_t delay_variation){
+    little_endian_store_16(buffer, 0, 0x07 | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[5] = flags;
+    buffer[6] = service_type;
+    little_endian_store_32(buffer, 7, token_rate);
+    little_endian_store_32(buffer, 11, peak_bandwith);
+    little_endian_store_32(buffer, 15, latency);
+    little_endian_store_32(buffer, 19, delay_variation);
+    buffer[2] = 20;
+    return 23;
+}
+
+/**
+ * @brief Create hci_role_discovery command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_role_discovery(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x09 | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_switch_role_command command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param bd_addr
+ * @param role
+ * @return size of HCI Command
+ * @note: btstack_type B1
+ */
+static inline uint16_t hci_cmd_create_switch_role_command(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t role){
+    little_endian_store_16(buffer, 0, 0x0b | (OGF_LINK_POLICY << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = role;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_read_link_policy_settings command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_read_link_policy_settings(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x0c | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_write_link_policy_settings command in buffer
+ * @param buffer for HCI Command of at least 7 bytes
+ * @param handle
+ * @param settings
+ * @return size of HCI Command
+ * @note: btstack_type H2
+ */
+static inline uint16_t hci_cmd_create_write_link_policy_settings(uint8_t * buffer, hci_con_handle_t handle, uint16_t settings){
+    little_endian_store_16(buffer, 0, 0x0d | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_16(buffer, 5, settings);
+    buffer[2] = 4;
+    return 7;
+}
+
+/**
+ * @brief Create hci_write_default_link_policy_setup command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param policy
+ * @return size of HCI Command
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_cmd_create_write_default_link_policy_setup(uint8_t * buffer, uint16_t policy){
+    little_endian_store_16(buffer, 0, 0x0F | (OGF_LINK_POLICY << 10));
+    little_endian_store_16(buffer, 3, policy);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_set_event_mask command in buffer
+ * @param buffer for HCI Command of at least 11 bytes
+ * @param event_mask_lover_octets
+ * @param event_mask_higher_octets
+ * @return size of HCI Command
+ * @note: btstack_type 44
+ */
+static inline uint16_t hci_cmd_create_set_event_mask(uint8_t * buffer, uint32_t event_mask_lover_octets, uint32_t event_mask_higher_octets){
+    little_endian_store_16(buffer, 0, 0x01 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_32(buffer, 3, event_mask_lover_octets);
+    little_endian_store_32(buffer, 7, event_mask_higher_octets);
+    buffer[2] = 8;
+    return 11;
+}
+
+/**
+ * @brief Create hci_reset command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_reset(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x03 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_flush command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_flush(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x09 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_delete_stored_link_key command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param bd_addr
+ * @param delete_all_flags
+ * @return size of HCI Command
+ * @note: btstack_type B1
+ */
+static inline uint16_t hci_cmd_create_delete_stored_link_key(uint8_t * buffer, const bd_addr_t bd_addr, uint8_t delete_all_flags){
+    little_endian_store_16(buffer, 0, 0x12 | (OGF_CONTROLLER_BASEBAND << 10));
+    reverse_bd_addr(bd_addr, &buffer[3]);
+    buffer[9] = delete_all_flags;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_write_local_name command in buffer
+ * @param buffer for HCI Command of at least 251 bytes
+ * @param local_name
+ * @return size of HCI Command
+ * @note: btstack_type N
+ */
+static inline uint16_t hci_cmd_create_write_local_name(uint8_t * buffer, const char * local_name){
+    little_endian_store_16(buffer, 0, 0x13 | (OGF_CONTROLLER_BASEBAND << 10));
+    {
+        uint16_t local_name_len = strlen(local_name);
+        if (local_name_len > 248) {
+            local_name_len = 248;
+        }
+        memcpy(&buffer[3], local_name, local_name_len);
+        memset(&buffer[3 + local_name_len], 0, 248 - local_name_len);
+    }
+    buffer[2] = 248;
+    return 251;
+}
+
+/**
+ * @brief Create hci_read_local_name command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_name(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x14 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_page_timeout command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param page_timeout
+ * @return size of HCI Command
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_cmd_create_write_page_timeout(uint8_t * buffer, uint16_t page_timeout){
+    little_endian_store_16(buffer, 0, 0x18 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_16(buffer, 3, page_timeout);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_write_scan_enable command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param scan_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_scan_enable(uint8_t * buffer, uint8_t scan_enable){
+    little_endian_store_16(buffer, 0, 0x1A | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = scan_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_write_authentication_enable command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param authentication_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_authentication_enable(uint8_t * buffer, uint8_t authentication_enable){
+    little_endian_store_16(buffer, 0, 0x20 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = authentication_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_write_class_of_device command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param class_of_device
+ * @return size of HCI Command
+ * @note: btstack_type 3
+ */
+static inline uint16_t hci_cmd_create_write_class_of_device(uint8_t * buffer, uint32_t class_of_device){
+    little_endian_store_16(buffer, 0, 0x24 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = class_of_device;
+    buffer[3 + 1] = class_of_device >> 8;
+    buffer[3 + 2] = class_of_device >> 16;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_read_num_broadcast_retransmissions command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_num_broadcast_retransmissions(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x29 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_num_broadcast_retransmissions command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param num_broadcast_retransmissions
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_num_broadcast_retransmissions(uint8_t * buffer, uint8_t num_broadcast_retransmissions){
+    little_endian_store_16(buffer, 0, 0x2a | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = num_broadcast_retransmissions;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_write_synchronous_flow_control_enable command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param synchronous_flow_control_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_synchronous_flow_control_enable(uint8_t * buffer, uint8_t synchronous_flow_control_enable){
+    little_endian_store_16(buffer, 0, 0x2f | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = synchronous_flow_control_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_set_controller_to_host_flow_control command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param flow_control_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_set_controller_to_host_flow_control(uint8_t * buffer, uint8_t flow_control_enable){
+    little_endian_store_16(buffer, 0, 0x31 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = flow_control_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_host_buffer_size command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param host_acl_data_packet_length
+ * @param host_synchronous_data_packet_length
+ * @param host_total_num_acl_data_packets
+ * @param host_total_num_synchronous_data_packets
+ * @return size of HCI Command
+ * @note: btstack_type 2122
+ */
+static inline uint16_t hci_cmd_create_host_buffer_size(uint8_t * buffer, uint16_t host_acl_data_packet_length, uint8_t host_synchronous_data_packet_length, uint16_t host_total_num_acl_data_packets, uint16_t host_total_num_synchronous_data_packets){
+    little_endian_store_16(buffer, 0, 0x33 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_16(buffer, 3, host_acl_data_packet_length);
+    buffer[5] = host_synchronous_data_packet_length;
+    little_endian_store_16(buffer, 6, host_total_num_acl_data_packets);
+    little_endian_store_16(buffer, 8, host_total_num_synchronous_data_packets);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_host_number_of_completed_packets command in buffer
+ * @param buffer for HCI Command of at least 8 bytes
+ * @param number_of_handles
+ * @param connection_handle
+ * @param host_num_of_completed_packets
+ * @return size of HCI Command
+ * @note: btstack_type 1H2
+ */
+static inline uint16_t hci_cmd_create_host_number_of_completed_packets(uint8_t * buffer, uint8_t number_of_handles, hci_con_handle_t connection_handle, uint16_t host_num_of_completed_packets){
+    little_endian_store_16(buffer, 0, 0x35 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = number_of_handles;
+    little_endian_store_16(buffer, 4, connection_handle);
+    little_endian_store_16(buffer, 6, host_num_of_completed_packets);
+    buffer[2] = 5;
+    return 8;
+}
+
+/**
+ * @brief Create hci_read_link_supervision_timeout command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_read_link_supervision_timeout(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x36 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_write_link_supervision_timeout command in buffer
+ * @param buffer for HCI Command of at least 7 bytes
+ * @param handle
+ * @param timeout
+ * @return size of HCI Command
+ * @note: btstack_type H2
+ */
+static inline uint16_t hci_cmd_create_write_link_supervision_timeout(uint8_t * buffer, hci_con_handle_t handle, uint16_t timeout){
+    little_endian_store_16(buffer, 0, 0x37 | (OGF_CONTROLLER_BASEBAND << 10));
+    little_endian_store_16(buffer, 3, handle);
+    little_endian_store_16(buffer, 5, timeout);
+    buffer[2] = 4;
+    return 7;
+}
+
+/**
+ * @brief Create hci_write_inquiry_mode command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param inquiry_mode
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_inquiry_mode(uint8_t * buffer, uint8_t inquiry_mode){
+    little_endian_store_16(buffer, 0, 0x45 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = inquiry_mode;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_write_extended_inquiry_response command in buffer
+ * @param buffer for HCI Command of at least 244 bytes
+ * @param fec_required
+ * @param exstended_inquiry_response
+ * @return size of HCI Command
+ * @note: btstack_type 1E
+ */
+static inline uint16_t hci_cmd_create_write_extended_inquiry_response(uint8_t * buffer, uint8_t fec_required, const uint8_t * exstended_inquiry_response){
+    little_endian_store_16(buffer, 0, 0x52 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = fec_required;
+    memcpy(&buffer[4], exstended_inquiry_response, 240);
+    buffer[2] = 241;
+    return 244;
+}
+
+/**
+ * @brief Create hci_write_simple_pairing_mode command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param mode
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_simple_pairing_mode(uint8_t * buffer, uint8_t mode){
+    little_endian_store_16(buffer, 0, 0x56 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = mode;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_read_local_oob_data command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_oob_data(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x57 | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_default_erroneous_data_reporting command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param mode
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_default_erroneous_data_reporting(uint8_t * buffer, uint8_t mode){
+    little_endian_store_16(buffer, 0, 0x5B | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = mode;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_read_le_host_supported command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_le_host_supported(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x6c | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_le_host_supported command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param le_supported_host
+ * @param simultaneous_le_host
+ * @return size of HCI Command
+ * @note: btstack_type 11
+ */
+static inline uint16_t hci_cmd_create_write_le_host_supported(uint8_t * buffer, uint8_t le_supported_host, uint8_t simultaneous_le_host){
+    little_endian_store_16(buffer, 0, 0x6d | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[3] = le_supported_host;
+    buffer[4] = simultaneous_le_host;
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_read_local_extended_ob_data command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_extended_ob_data(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x7d | (OGF_CONTROLLER_BASEBAND << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_loopback_mode command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_loopback_mode(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x01 | (OGF_TESTING << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_loopback_mode command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param loopback_mode
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_loopback_mode(uint8_t * buffer, uint8_t loopback_mode){
+    little_endian_store_16(buffer, 0, 0x02 | (OGF_TESTING << 10));
+    buffer[3] = loopback_mode;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_enable_device_under_test_mode command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_enable_device_under_test_mode(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x03 | (OGF_TESTING << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_write_simple_pairing_debug_mode command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param simple_pairing_debug_mode
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_write_simple_pairing_debug_mode(uint8_t * buffer, uint8_t simple_pairing_debug_mode){
+    little_endian_store_16(buffer, 0, 0x04 | (OGF_TESTING << 10));
+    buffer[3] = simple_pairing_debug_mode;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_write_secure_connections_test_mode command in buffer
+ * @param buffer for HCI Command of at least 7 bytes
+ * @param handle
+ * @param dm1_acl_u_mode
+ * @param esco_loopback_mode
+ * @return size of HCI Command
+ * @note: btstack_type H11
+ */
+static inline uint16_t hci_cmd_create_write_secure_connections_test_mode(uint8_t * buffer, hci_con_handle_t handle, uint8_t dm1_acl_u_mode, uint8_t esco_loopback_mode){
+    little_endian_store_16(buffer, 0, 0x0a | (OGF_TESTING << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[5] = dm1_acl_u_mode;
+    buffer[6] = esco_loopback_mode;
+    buffer[2] = 4;
+    return 7;
+}
+
+/**
+ * @brief Create hci_read_local_version_information command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_version_information(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x01 | (OGF_INFORMATIONAL_PARAMETERS << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_local_supported_commands command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_supported_commands(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x02 | (OGF_INFORMATIONAL_PARAMETERS << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_local_supported_features command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_local_supported_features(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x03 | (OGF_INFORMATIONAL_PARAMETERS << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_buffer_size command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_buffer_size(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x05 | (OGF_INFORMATIONAL_PARAMETERS << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_bd_addr command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_read_bd_addr(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x09 | (OGF_INFORMATIONAL_PARAMETERS << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_read_rssi command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_read_rssi(uint8_t * buffer, hci_con_handle_t handle){
+    little_endian_store_16(buffer, 0, 0x05 | (OGF_STATUS_PARAMETERS << 10));
+    little_endian_store_16(buffer, 3, handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_set_event_mask command in buffer
+ * @param buffer for HCI Command of at least 11 bytes
+ * @param event_mask_lower_octets
+ * @param event_mask_higher_octets
+ * @return size of HCI Command
+ * @note: btstack_type 44
+ */
+static inline uint16_t hci_cmd_create_le_set_event_mask(uint8_t * buffer, uint32_t event_mask_lower_octets, uint32_t event_mask_higher_octets){
+    little_endian_store_16(buffer, 0, 0x01 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_32(buffer, 3, event_mask_lower_octets);
+    little_endian_store_32(buffer, 7, event_mask_higher_octets);
+    buffer[2] = 8;
+    return 11;
+}
+
+/**
+ * @brief Create hci_le_read_buffer_size command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_buffer_size(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x02 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_read_supported_features command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_supported_features(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x03 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_set_random_address command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param random_bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type B
+ */
+static inline uint16_t hci_cmd_create_le_set_random_address(uint8_t * buffer, const bd_addr_t random_bd_addr){
+    little_endian_store_16(buffer, 0, 0x05 | (OGF_LE_CONTROLLER << 10));
+    reverse_bd_addr(random_bd_addr, &buffer[3]);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_le_set_advertising_parameters command in buffer
+ * @param buffer for HCI Command of at least 18 bytes
+ * @param advertising_interval_min
+ * @param advertising_interval_max
+ * @param advertising_type
+ * @param own_address_type
+ * @param direct_address_type
+ * @param direct_address
+ * @param advertising_channel_map
+ * @param advertising_filter_policy
+ * @return size of HCI Command
+ * @note: btstack_type 22111B11
+ */
+static inline uint16_t hci_cmd_create_le_set_advertising_parameters(uint8_t * buffer, uint16_t advertising_interval_min, uint16_t advertising_interval_max, uint8_t advertising_type, uint8_t own_address_type, uint8_t direct_address_type, const bd_addr_t direct_address, uint8_t advertising_channel_map, uint8_t advertising_filter_policy){
+    little_endian_store_16(buffer, 0, 0x06 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, advertising_interval_min);
+    little_endian_store_16(buffer, 5, advertising_interval_max);
+    buffer[7] = advertising_type;
+    buffer[8] = own_address_type;
+    buffer[9] = direct_address_type;
+    reverse_bd_addr(direct_address, &buffer[10]);
+    buffer[16] = advertising_channel_map;
+    buffer[17] = advertising_filter_policy;
+    buffer[2] = 15;
+    return 18;
+}
+
+/**
+ * @brief Create hci_le_read_advertising_channel_tx_power command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_advertising_channel_tx_power(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x07 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_set_advertising_data command in buffer
+ * @param buffer for HCI Command of at least 35 bytes
+ * @param advertising_data_length
+ * @param advertising_data
+ * @return size of HCI Command
+ * @note: btstack_type 1A
+ */
+static inline uint16_t hci_cmd_create_le_set_advertising_data(uint8_t * buffer, uint8_t advertising_data_length, const uint8_t * advertising_data){
+    little_endian_store_16(buffer, 0, 0x08 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertising_data_length;
+    memcpy(&buffer[4], advertising_data, 31);
+    buffer[2] = 32;
+    return 35;
+}
+
+/**
+ * @brief Create hci_le_set_scan_response_data command in buffer
+ * @param buffer for HCI Command of at least 35 bytes
+ * @param scan_response_data_length
+ * @param scan_response_data
+ * @return size of HCI Command
+ * @note: btstack_type 1A
+ */
+static inline uint16_t hci_cmd_create_le_set_scan_response_data(uint8_t * buffer, uint8_t scan_response_data_length, const uint8_t * scan_response_data){
+    little_endian_store_16(buffer, 0, 0x09 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = scan_response_data_length;
+    memcpy(&buffer[4], scan_response_data, 31);
+    buffer[2] = 32;
+    return 35;
+}
+
+/**
+ * @brief Create hci_le_set_advertise_enable command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param advertise_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_le_set_advertise_enable(uint8_t * buffer, uint8_t advertise_enable){
+    little_endian_store_16(buffer, 0, 0x0a | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertise_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_le_set_scan_parameters command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param le_scan_type
+ * @param le_scan_interval
+ * @param le_scan_window
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @return size of HCI Command
+ * @note: btstack_type 12211
+ */
+static inline uint16_t hci_cmd_create_le_set_scan_parameters(uint8_t * buffer, uint8_t le_scan_type, uint16_t le_scan_interval, uint16_t le_scan_window, uint8_t own_address_type, uint8_t scanning_filter_policy){
+    little_endian_store_16(buffer, 0, 0x0b | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = le_scan_type;
+    little_endian_store_16(buffer, 4, le_scan_interval);
+    little_endian_store_16(buffer, 6, le_scan_window);
+    buffer[8] = own_address_type;
+    buffer[9] = scanning_filter_policy;
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_set_scan_enable command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param le_scan_enable
+ * @param filter_duplices
+ * @return size of HCI Command
+ * @note: btstack_type 11
+ */
+static inline uint16_t hci_cmd_create_le_set_scan_enable(uint8_t * buffer, uint8_t le_scan_enable, uint8_t filter_duplices){
+    little_endian_store_16(buffer, 0, 0x0c | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = le_scan_enable;
+    buffer[4] = filter_duplices;
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_create_connection command in buffer
+ * @param buffer for HCI Command of at least 28 bytes
+ * @param le_scan_interval
+ * @param le_scan_window
+ * @param initiator_filter_policy
+ * @param peer_address_type
+ * @param peer_address
+ * @param own_address_type
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of HCI Command
+ * @note: btstack_type 2211B1222222
+ */
+static inline uint16_t hci_cmd_create_le_create_connection(uint8_t * buffer, uint16_t le_scan_interval, uint16_t le_scan_window, uint8_t initiator_filter_policy, uint8_t peer_address_type, const bd_addr_t peer_address, uint8_t own_address_type, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    little_endian_store_16(buffer, 0, 0x0d | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, le_scan_interval);
+    little_endian_store_16(buffer, 5, le_scan_window);
+    buffer[7] = initiator_filter_policy;
+    buffer[8] = peer_address_type;
+    reverse_bd_addr(peer_address, &buffer[9]);
+    buffer[15] = own_address_type;
+    little_endian_store_16(buffer, 16, conn_interval_min);
+    little_endian_store_16(buffer, 18, conn_interval_max);
+    little_endian_store_16(buffer, 20, conn_latency);
+    little_endian_store_16(buffer, 22, supervision_timeout);
+    little_endian_store_16(buffer, 24, minimum_ce_length);
+    little_endian_store_16(buffer, 26, maximum_ce_length);
+    buffer[2] = 25;
+    return 28;
+}
+
+/**
+ * @brief Create hci_le_create_connection_cancel command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_create_connection_cancel(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x0e | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_read_white_list_size command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_white_list_size(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x0f | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_clear_white_list command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_clear_white_list(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x10 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_add_device_to_white_list command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param address_type
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type 1B
+ */
+static inline uint16_t hci_cmd_create_le_add_device_to_white_list(uint8_t * buffer, uint8_t address_type, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x11 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = address_type;
+    reverse_bd_addr(bd_addr, &buffer[4]);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_remove_device_from_white_list command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param address_type
+ * @param bd_addr
+ * @return size of HCI Command
+ * @note: btstack_type 1B
+ */
+static inline uint16_t hci_cmd_create_le_remove_device_from_white_list(uint8_t * buffer, uint8_t address_type, const bd_addr_t bd_addr){
+    little_endian_store_16(buffer, 0, 0x12 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = address_type;
+    reverse_bd_addr(bd_addr, &buffer[4]);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_connection_update command in buffer
+ * @param buffer for HCI Command of at least 17 bytes
+ * @param conn_handle
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of HCI Command
+ * @note: btstack_type H222222
+ */
+static inline uint16_t hci_cmd_create_le_connection_update(uint8_t * buffer, hci_con_handle_t conn_handle, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    little_endian_store_16(buffer, 0, 0x13 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    little_endian_store_16(buffer, 5, conn_interval_min);
+    little_endian_store_16(buffer, 7, conn_interval_max);
+    little_endian_store_16(buffer, 9, conn_latency);
+    little_endian_store_16(buffer, 11, supervision_timeout);
+    little_endian_store_16(buffer, 13, minimum_ce_length);
+    little_endian_store_16(buffer, 15, maximum_ce_length);
+    buffer[2] = 14;
+    return 17;
+}
+
+/**
+ * @brief Create hci_le_set_host_channel_classification command in buffer
+ * @param buffer for HCI Command of at least 8 bytes
+ * @param channel_map_lower_32bits
+ * @param channel_map_higher_5bits
+ * @return size of HCI Command
+ * @note: btstack_type 41
+ */
+static inline uint16_t hci_cmd_create_le_set_host_channel_classification(uint8_t * buffer, uint32_t channel_map_lower_32bits, uint8_t channel_map_higher_5bits){
+    little_endian_store_16(buffer, 0, 0x14 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_32(buffer, 3, channel_map_lower_32bits);
+    buffer[7] = channel_map_higher_5bits;
+    buffer[2] = 5;
+    return 8;
+}
+
+/**
+ * @brief Create hci_le_read_channel_map command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param conn_handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_le_read_channel_map(uint8_t * buffer, hci_con_handle_t conn_handle){
+    little_endian_store_16(buffer, 0, 0x15 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_read_remote_used_features command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param conn_handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_le_read_remote_used_features(uint8_t * buffer, hci_con_handle_t conn_handle){
+    little_endian_store_16(buffer, 0, 0x16 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_encrypt command in buffer
+ * @param buffer for HCI Command of at least 35 bytes
+ * @param key
+ * @param plain_text
+ * @return size of HCI Command
+ * @note: btstack_type PP
+ */
+static inline uint16_t hci_cmd_create_le_encrypt(uint8_t * buffer, const uint8_t * key, const uint8_t * plain_text){
+    little_endian_store_16(buffer, 0, 0x17 | (OGF_LE_CONTROLLER << 10));
+    memcpy(&buffer[3], key, 16);
+    memcpy(&buffer[19], plain_text, 16);
+    buffer[2] = 32;
+    return 35;
+}
+
+/**
+ * @brief Create hci_le_rand command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_rand(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x18 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_start_encryption command in buffer
+ * @param buffer for HCI Command of at least 31 bytes
+ * @param conn_handle
+ * @param random_number_lower_32bits
+ * @param random_number_higher_32bits
+ * @param encryption_diversifier
+ * @param long_term_key
+ * @return size of HCI Command
+ * @note: btstack_type H442P
+ */
+static inline uint16_t hci_cmd_create_le_start_encryption(uint8_t * buffer, hci_con_handle_t conn_handle, uint32_t random_number_lower_32bits, uint32_t random_number_higher_32bits, uint16_t encryption_diversifier, const uint8_t * long_term_key){
+    little_endian_store_16(buffer, 0, 0x19 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    little_endian_store_32(buffer, 5, random_number_lower_32bits);
+    little_endian_store_32(buffer, 9, random_number_higher_32bits);
+    little_endian_store_16(buffer, 13, encryption_diversifier);
+    memcpy(&buffer[15], long_term_key, 16);
+    buffer[2] = 28;
+    return 31;
+}
+
+/**
+ * @brief Create hci_le_long_term_key_request_reply command in buffer
+ * @param buffer for HCI Command of at least 21 bytes
+ * @param connection_handle
+ * @param long_term_key
+ * @return size of HCI Command
+ * @note: btstack_type HP
+ */
+static inline uint16_t hci_cmd_create_le_long_term_key_request_reply(uint8_t * buffer, hci_con_handle_t connection_handle, const uint8_t * long_term_key){
+    little_endian_store_16(buffer, 0, 0x1a | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, connection_handle);
+    memcpy(&buffer[5], long_term_key, 16);
+    buffer[2] = 18;
+    return 21;
+}
+
+/**
+ * @brief Create hci_le_long_term_key_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param conn_handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_le_long_term_key_negative_reply(uint8_t * buffer, hci_con_handle_t conn_handle){
+    little_endian_store_16(buffer, 0, 0x1b | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_read_supported_states command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param conn_handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_le_read_supported_states(uint8_t * buffer, hci_con_handle_t conn_handle){
+    little_endian_store_16(buffer, 0, 0x1c | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_receiver_test command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param rx_frequency
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_le_receiver_test(uint8_t * buffer, uint8_t rx_frequency){
+    little_endian_store_16(buffer, 0, 0x1d | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = rx_frequency;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_le_transmitter_test command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param tx_frequency
+ * @param test_payload_lengh
+ * @param packet_payload
+ * @return size of HCI Command
+ * @note: btstack_type 111
+ */
+static inline uint16_t hci_cmd_create_le_transmitter_test(uint8_t * buffer, uint8_t tx_frequency, uint8_t test_payload_lengh, uint8_t packet_payload){
+    little_endian_store_16(buffer, 0, 0x1e | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = tx_frequency;
+    buffer[4] = test_payload_lengh;
+    buffer[5] = packet_payload;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_le_test_end command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param end_test_cmd
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_le_test_end(uint8_t * buffer, uint8_t end_test_cmd){
+    little_endian_store_16(buffer, 0, 0x1f | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = end_test_cmd;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_le_remote_connection_parameter_request_reply command in buffer
+ * @param buffer for HCI Command of at least 17 bytes
+ * @param conn_handle
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param minimum_ce_length
+ * @param maximum_ce_length
+ * @return size of HCI Command
+ * @note: btstack_type H222222
+ */
+static inline uint16_t hci_cmd_create_le_remote_connection_parameter_request_reply(uint8_t * buffer, hci_con_handle_t conn_handle, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t minimum_ce_length, uint16_t maximum_ce_length){
+    little_endian_store_16(buffer, 0, 0x20 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, conn_handle);
+    little_endian_store_16(buffer, 5, conn_interval_min);
+    little_endian_store_16(buffer, 7, conn_interval_max);
+    little_endian_store_16(buffer, 9, conn_latency);
+    little_endian_store_16(buffer, 11, supervision_timeout);
+    little_endian_store_16(buffer, 13, minimum_ce_length);
+    little_endian_store_16(buffer, 15, maximum_ce_length);
+    buffer[2] = 14;
+    return 17;
+}
+
+/**
+ * @brief Create hci_le_remote_connection_parameter_request_negative_reply command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param con_handle
+ * @param reason
+ * @return size of HCI Command
+ * @note: btstack_type H1
+ */
+static inline uint16_t hci_cmd_create_le_remote_connection_parameter_request_negative_reply(uint8_t * buffer, hci_con_handle_t con_handle, uint8_t reason){
+    little_endian_store_16(buffer, 0, 0x21 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, con_handle);
+    buffer[5] = reason;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_le_set_data_length command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param con_handle
+ * @param tx_octets
+ * @param tx_time
+ * @return size of HCI Command
+ * @note: btstack_type H22
+ */
+static inline uint16_t hci_cmd_create_le_set_data_length(uint8_t * buffer, hci_con_handle_t con_handle, uint16_t tx_octets, uint16_t tx_time){
+    little_endian_store_16(buffer, 0, 0x22 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, con_handle);
+    little_endian_store_16(buffer, 5, tx_octets);
+    little_endian_store_16(buffer, 7, tx_time);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_le_read_suggested_default_data_length command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_suggested_default_data_length(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x23 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_write_suggested_default_data_length command in buffer
+ * @param buffer for HCI Command of at least 7 bytes
+ * @param suggested_max_tx_octets
+ * @param suggested_max_tx_time
+ * @return size of HCI Command
+ * @note: btstack_type 22
+ */
+static inline uint16_t hci_cmd_create_le_write_suggested_default_data_length(uint8_t * buffer, uint16_t suggested_max_tx_octets, uint16_t suggested_max_tx_time){
+    little_endian_store_16(buffer, 0, 0x24 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, suggested_max_tx_octets);
+    little_endian_store_16(buffer, 5, suggested_max_tx_time);
+    buffer[2] = 4;
+    return 7;
+}
+
+/**
+ * @brief Create hci_le_read_local_p256_public_key command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_local_p256_public_key(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x25 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_generate_dhkey command in buffer
+ * @param buffer for HCI Command of at least 67 bytes
+ * @param public_param
+ * @param private_param
+ * @return size of HCI Command
+ * @note: btstack_type QQ
+ */
+static inline uint16_t hci_cmd_create_le_generate_dhkey(uint8_t * buffer, const uint8_t * public_param, const uint8_t * private_param){
+    little_endian_store_16(buffer, 0, 0x26 | (OGF_LE_CONTROLLER << 10));
+    reverse_bytes(public_param, &buffer[3], 32);
+    reverse_bytes(private_param, &buffer[35], 32);
+    buffer[2] = 64;
+    return 67;
+}
+
+/**
+ * @brief Create hci_le_add_device_to_resolving_list command in buffer
+ * @param buffer for HCI Command of at least 42 bytes
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ * @param peer_irk
+ * @param local_irk
+ * @return size of HCI Command
+ * @note: btstack_type 1BPP
+ */
+static inline uint16_t hci_cmd_create_le_add_device_to_resolving_list(uint8_t * buffer, uint8_t peer_identity_address_type, const bd_addr_t peer_identity_address, const uint8_t * peer_irk, const uint8_t * local_irk){
+    little_endian_store_16(buffer, 0, 0x27 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = peer_identity_address_type;
+    reverse_bd_addr(peer_identity_address, &buffer[4]);
+    memcpy(&buffer[10], peer_irk, 16);
+    memcpy(&buffer[26], local_irk, 16);
+    buffer[2] = 39;
+    return 42;
+}
+
+/**
+ * @brief Create hci_le_remove_device_from_resolving_list command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param peer_identity_address_type
+ * @param peer_identity_address
+ * @return size of HCI Command
+ * @note: btstack_type 1B
+ */
+static inline uint16_t hci_cmd_create_le_remove_device_from_resolving_list(uint8_t * buffer, uint8_t peer_identity_address_type, const bd_addr_t peer_identity_address){
+    little_endian_store_16(buffer, 0, 0x28 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = peer_identity_address_type;
+    reverse_bd_addr(peer_identity_address, &buffer[4]);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_clear_resolving_list command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_clear_resolving_list(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x29 | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_read_resolving_list_size command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_resolving_list_size(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x2A | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_set_address_resolution_enable command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param address_resolution_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_le_set_address_resolution_enable(uint8_t * buffer, uint8_t address_resolution_enable){
+    little_endian_store_16(buffer, 0, 0x2D | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = address_resolution_enable;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_le_set_resolvable_private_address_timeout command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param rpa_timeout
+ * @return size of HCI Command
+ * @note: btstack_type 2
+ */
+static inline uint16_t hci_cmd_create_le_set_resolvable_private_address_timeout(uint8_t * buffer, uint16_t rpa_timeout){
+    little_endian_store_16(buffer, 0, 0x2E | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, rpa_timeout);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_read_maximum_data_length command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_maximum_data_length(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x2F | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_read_phy command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param con_handle
+ * @return size of HCI Command
+ * @note: btstack_type H
+ */
+static inline uint16_t hci_cmd_create_le_read_phy(uint8_t * buffer, hci_con_handle_t con_handle){
+    little_endian_store_16(buffer, 0, 0x30 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, con_handle);
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_set_default_phy command in buffer
+ * @param buffer for HCI Command of at least 6 bytes
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ * @return size of HCI Command
+ * @note: btstack_type 111
+ */
+static inline uint16_t hci_cmd_create_le_set_default_phy(uint8_t * buffer, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys){
+    little_endian_store_16(buffer, 0, 0x31 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = all_phys;
+    buffer[4] = tx_phys;
+    buffer[5] = rx_phys;
+    buffer[2] = 3;
+    return 6;
+}
+
+/**
+ * @brief Create hci_le_set_phy command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param con_handle
+ * @param all_phys
+ * @param tx_phys
+ * @param rx_phys
+ * @param phy_options
+ * @return size of HCI Command
+ * @note: btstack_type H1112
+ */
+static inline uint16_t hci_cmd_create_le_set_phy(uint8_t * buffer, hci_con_handle_t con_handle, uint8_t all_phys, uint8_t tx_phys, uint8_t rx_phys, uint16_t phy_options){
+    little_endian_store_16(buffer, 0, 0x32 | (OGF_LE_CONTROLLER << 10));
+    little_endian_store_16(buffer, 3, con_handle);
+    buffer[5] = all_phys;
+    buffer[6] = tx_phys;
+    buffer[7] = rx_phys;
+    little_endian_store_16(buffer, 8, phy_options);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_set_advertising_set_random_address command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param advertising_handle
+ * @param random_address
+ * @return size of HCI Command
+ * @note: btstack_type 1B
+ */
+static inline uint16_t hci_cmd_create_le_set_advertising_set_random_address(uint8_t * buffer, uint8_t advertising_handle, const bd_addr_t random_address){
+    little_endian_store_16(buffer, 0, 0x35 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertising_handle;
+    reverse_bd_addr(random_address, &buffer[4]);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_set_extended_advertising_parameters command in buffer
+ * @param buffer for HCI Command of at least 28 bytes
+ * @param advertising_handle
+ * @param advertising_event_properties
+ * @param primary_advertising_interval_min
+ * @param primary_advertising_interval_max
+ * @param primary_advertising_channel_map
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param advertising_filter_policy
+ * @param advertising_tx_power
+ * @param primary_advertising_phy
+ * @param secondary_advertising_max_skip
+ * @param secondary_advertising_phy
+ * @param advertising_sid
+ * @param scan_request_notification_enable
+ * @return size of HCI Command
+ * @note: btstack_type 1233111B1111111
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_advertising_parameters(uint8_t * buffer, uint8_t advertising_handle, uint16_t advertising_event_properties, uint32_t primary_advertising_interval_min, uint32_t primary_advertising_interval_max, uint8_t primary_advertising_channel_map, uint8_t own_address_type, uint8_t peer_address_type, const bd_addr_t peer_address, uint8_t advertising_filter_policy, uint8_t advertising_tx_power, uint8_t primary_advertising_phy, uint8_t secondary_advertising_max_skip, uint8_t secondary_advertising_phy, uint8_t advertising_sid, uint8_t scan_request_notification_enable){
+    little_endian_store_16(buffer, 0, 0x36 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertising_handle;
+    little_endian_store_16(buffer, 4, advertising_event_properties);
+    buffer[6] = primary_advertising_interval_min;
+    buffer[6 + 1] = primary_advertising_interval_min >> 8;
+    buffer[6 + 2] = primary_advertising_interval_min >> 16;
+    buffer[9] = primary_advertising_interval_max;
+    buffer[9 + 1] = primary_advertising_interval_max >> 8;
+    buffer[9 + 2] = primary_advertising_interval_max >> 16;
+    buffer[12] = primary_advertising_channel_map;
+    buffer[13] = own_address_type;
+    buffer[14] = peer_address_type;
+    reverse_bd_addr(peer_address, &buffer[15]);
+    buffer[21] = advertising_filter_policy;
+    buffer[22] = advertising_tx_power;
+    buffer[23] = primary_advertising_phy;
+    buffer[24] = secondary_advertising_max_skip;
+    buffer[25] = secondary_advertising_phy;
+    buffer[26] = advertising_sid;
+    buffer[27] = scan_request_notification_enable;
+    buffer[2] = 25;
+    return 28;
+}
+
+/**
+ * @brief Create hci_le_set_extended_advertising_data command in buffer
+ * @param buffer for HCI Command of at least 262 bytes
+ * @param arg1
+ * @param arg2
+ * @param arg3
+ * @param arg4_len
+ * @param arg4
+ * @return size of HCI Command
+ * @note: btstack_type 111J
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_advertising_data(uint8_t * buffer, uint8_t arg1, uint8_t arg2, uint8_t arg3, uint8_t arg4_len, const uint8_t * arg4){
+    little_endian_store_16(buffer, 0, 0x37 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = arg1;
+    buffer[4] = arg2;
+    buffer[5] = arg3;
+    uint16_t pos = 6;
+    buffer[pos++] = arg4_len;
+    memcpy(&buffer[pos], arg4, arg4_len);
+    pos += arg4_len;
+    buffer[2] = pos - 3;
+    return pos;
+}
+
+/**
+ * @brief Create hci_le_set_extended_scan_response_data command in buffer
+ * @param buffer for HCI Command of at least 262 bytes
+ * @param arg1
+ * @param arg2
+ * @param arg3
+ * @param arg4_len
+ * @param arg4
+ * @return size of HCI Command
+ * @note: btstack_type 111J
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_scan_response_data(uint8_t * buffer, uint8_t arg1, uint8_t arg2, uint8_t arg3, uint8_t arg4_len, const uint8_t * arg4){
+    little_endian_store_16(buffer, 0, 0x38 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = arg1;
+    buffer[4] = arg2;
+    buffer[5] = arg3;
+    uint16_t pos = 6;
+    buffer[pos++] = arg4_len;
+    memcpy(&buffer[pos], arg4, arg4_len);
+    pos += arg4_len;
+    buffer[2] = pos - 3;
+    return pos;
+}
+
+/**
+ * @brief Create hci_le_set_extended_advertising_enable command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param enable
+ * @param number_of_sets
+ * @param advertising_handle
+ * @param duration
+ * @param max_extended_advertising_events
+ * @return size of HCI Command
+ * @note: btstack_type 11121
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_advertising_enable(uint8_t * buffer, uint8_t enable, uint8_t number_of_sets, uint8_t advertising_handle, uint16_t duration, uint8_t max_extended_advertising_events){
+    little_endian_store_16(buffer, 0, 0x39 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = enable;
+    buffer[4] = number_of_sets;
+    buffer[5] = advertising_handle;
+    little_endian_store_16(buffer, 6, duration);
+    buffer[8] = max_extended_advertising_events;
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_le_read_maximum_advertising_data_length command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_maximum_advertising_data_length(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x3A | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_read_number_of_supported_advertising_sets command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_read_number_of_supported_advertising_sets(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x3B | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_remove_advertising_set command in buffer
+ * @param buffer for HCI Command of at least 4 bytes
+ * @param advertising_handle
+ * @return size of HCI Command
+ * @note: btstack_type 1
+ */
+static inline uint16_t hci_cmd_create_le_remove_advertising_set(uint8_t * buffer, uint8_t advertising_handle){
+    little_endian_store_16(buffer, 0, 0x3C | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertising_handle;
+    buffer[2] = 1;
+    return 4;
+}
+
+/**
+ * @brief Create hci_le_clear_advertising_sets command in buffer
+ * @param buffer for HCI Command of at least 3 bytes
+ * @return size of HCI Command
+ * @note: btstack_type 
+ */
+static inline uint16_t hci_cmd_create_le_clear_advertising_sets(uint8_t * buffer){
+    little_endian_store_16(buffer, 0, 0x3D | (OGF_LE_CONTROLLER << 10));
+    buffer[2] = 0;
+    return 3;
+}
+
+/**
+ * @brief Create hci_le_set_periodic_advertising_parameters command in buffer
+ * @param buffer for HCI Command of at least 10 bytes
+ * @param advertising_handle
+ * @param periodic_advertising_interval_min
+ * @param periodic_advertising_interval_max
+ * @param periodic_advertising_properties
+ * @return size of HCI Command
+ * @note: btstack_type 1222
+ */
+static inline uint16_t hci_cmd_create_le_set_periodic_advertising_parameters(uint8_t * buffer, uint8_t advertising_handle, uint16_t periodic_advertising_interval_min, uint16_t periodic_advertising_interval_max, uint16_t periodic_advertising_properties){
+    little_endian_store_16(buffer, 0, 0x3E | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = advertising_handle;
+    little_endian_store_16(buffer, 4, periodic_advertising_interval_min);
+    little_endian_store_16(buffer, 6, periodic_advertising_interval_max);
+    little_endian_store_16(buffer, 8, periodic_advertising_properties);
+    buffer[2] = 7;
+    return 10;
+}
+
+/**
+ * @brief Create hci_le_set_periodic_advertising_data command in buffer
+ * @param buffer for HCI Command of at least 261 bytes
+ * @param arg1
+ * @param arg2
+ * @param arg3_len
+ * @param arg3
+ * @return size of HCI Command
+ * @note: btstack_type 11J
+ */
+static inline uint16_t hci_cmd_create_le_set_periodic_advertising_data(uint8_t * buffer, uint8_t arg1, uint8_t arg2, uint8_t arg3_len, const uint8_t * arg3){
+    little_endian_store_16(buffer, 0, 0x3F | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = arg1;
+    buffer[4] = arg2;
+    uint16_t pos = 5;
+    buffer[pos++] = arg3_len;
+    memcpy(&buffer[pos], arg3, arg3_len);
+    pos += arg3_len;
+    buffer[2] = pos - 3;
+    return pos;
+}
+
+/**
+ * @brief Create hci_le_set_periodic_advertising_enable command in buffer
+ * @param buffer for HCI Command of at least 5 bytes
+ * @param enable
+ * @param advertising_handle
+ * @return size of HCI Command
+ * @note: btstack_type 11
+ */
+static inline uint16_t hci_cmd_create_le_set_periodic_advertising_enable(uint8_t * buffer, uint8_t enable, uint8_t advertising_handle){
+    little_endian_store_16(buffer, 0, 0x40 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = enable;
+    buffer[4] = advertising_handle;
+    buffer[2] = 2;
+    return 5;
+}
+
+/**
+ * @brief Create hci_le_set_extended_scan_parameters command in buffer
+ * @param buffer for HCI Command of at least 11 bytes
+ * @param own_address_type
+ * @param scanning_filter_policy
+ * @param scanning_phys
+ * @param scan_type
+ * @param scan_interval
+ * @param scan_window
+ * @return size of HCI Command
+ * @note: btstack_type 111122
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_scan_parameters(uint8_t * buffer, uint8_t own_address_type, uint8_t scanning_filter_policy, uint8_t scanning_phys, uint8_t scan_type, uint16_t scan_interval, uint16_t scan_window){
+    little_endian_store_16(buffer, 0, 0x41 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = own_address_type;
+    buffer[4] = scanning_filter_policy;
+    buffer[5] = scanning_phys;
+    buffer[6] = scan_type;
+    little_endian_store_16(buffer, 7, scan_interval);
+    little_endian_store_16(buffer, 9, scan_window);
+    buffer[2] = 8;
+    return 11;
+}
+
+/**
+ * @brief Create hci_le_set_extended_scan_enable command in buffer
+ * @param buffer for HCI Command of at least 9 bytes
+ * @param enable
+ * @param filter_duplicates
+ * @param duration
+ * @param period
+ * @return size of HCI Command
+ * @note: btstack_type 1122
+ */
+static inline uint16_t hci_cmd_create_le_set_extended_scan_enable(uint8_t * buffer, uint8_t enable, uint8_t filter_duplicates, uint16_t duration, uint16_t period){
+    little_endian_store_16(buffer, 0, 0x42 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = enable;
+    buffer[4] = filter_duplicates;
+    little_endian_store_16(buffer, 5, duration);
+    little_endian_store_16(buffer, 7, period);
+    buffer[2] = 6;
+    return 9;
+}
+
+/**
+ * @brief Create hci_le_extended_create_connection command in buffer
+ * @param buffer for HCI Command of at least 29 bytes
+ * @param initiator_filter_policy
+ * @param own_address_type
+ * @param peer_address_type
+ * @param peer_address
+ * @param initiating_phys
+ * @param scan_interval
+ * @param scan_window
+ * @param conn_interval_min
+ * @param conn_interval_max
+ * @param conn_latency
+ * @param supervision_timeout
+ * @param min_ce_length
+ * @param max_ce_length
+ * @return size of HCI Command
+ * @note: btstack_type 111B122222222
+ */
+static inline uint16_t hci_cmd_create_le_extended_create_connection(uint8_t * buffer, uint8_t initiator_filter_policy, uint8_t own_address_type, uint8_t peer_address_type, const bd_addr_t peer_address, uint8_t initiating_phys, uint16_t scan_interval, uint16_t scan_window, uint16_t conn_interval_min, uint16_t conn_interval_max, uint16_t conn_latency, uint16_t supervision_timeout, uint16_t min_ce_length, uint16_t max_ce_length){
+    little_endian_store_16(buffer, 0, 0x43 | (OGF_LE_CONTROLLER << 10));
+    buffer[3] = initiator_filter_policy;
+    buffer[4] = own_address_type;
+    buffer[5] = peer_address_type;
+    reverse_bd_addr(peer_address, &buffer[6]);
+    buffer[12] = initiating_phys;
+    little_endian_store_16(buffer, 13, scan_interval);
+    little_endian_store_16(buffer, 15, scan_window);
+    little_endian_store_16(buffer, 17, conn_interval_min);
+    little_endian_store_16(buffer, 19, conn_interval_max);
+    little_endian_store_16(buffer, 21, conn_latency);
+    little_endian_store_16(buffer, 23, supervision_timeout);
+    little_endian_store_16(buffer, 25, min_ce_length);
+    little_endian_store_16(buffer, 27, max_ce_length);
+    buffer[2] = 26;
+    return 29;
+}
+
+/**
+ * @brief Create hci_bcm_write_sco_pcm_int command in buffer
+ * @param buffer for HCI Command of at least 8 bytes
+ * @param sco_routing
+ * @param pcm_interface_rate
+ * @param frame_type
+ * @param sync_mode
+ * @param clock_mode
+ * @return size of HCI Command
+ * @note: btstack_type 11111
+ */
+static inline uint16_t hci_cmd_create_bcm_write_sco_pcm_int(uint8_t * buffer, uint8_t sco_routing, uint8_t pcm_interface_rate, uint8_t frame_type, uint8_t sync_mode, uint8_t clock_mode){
+    little_endian_store_16(buffer, 0, 0x1c | (0x3f << 10));
+    buffer[3] = sco_routing;
+    buffer[4] = pcm_interface_rate;
+    buffer[5] = frame_type;
+    buffer[6] = sync_mode;
+    buffer[7] = clock_mode;
+    buffer[2] = 5;
+    return 8;
+}
+
+
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __HCI_CMD_ENCODER_H
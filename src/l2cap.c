@@ -61,9 +61,6 @@
 // nr of buffered acl packets in outgoing queue to get max performance 
 #define NR_BUFFERED_ACL_PACKETS 3
 
-// used to cache l2cap rejects, echo, and informational requests
-#define NR_PENDING_SIGNALING_RESPONSES 3
-
 // nr of credits provided to remote if credits fall below watermark
 #define L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_WATERMARK 5
 #define L2CAP_LE_DATA_CHANNELS_AUTOMATIC_CREDITS_INCREMENT 5
@@ -136,9 +133,6 @@ static btstack_linked_list_t l2cap_le_services;
 // single list of channels for Classic Channels, LE Data Channels, Classic Connectionless, ATT, and SM
 static btstack_linked_list_t l2cap_channels;
 
-// used to cache l2cap rejects, echo, and informational requests
-static l2cap_signaling_response_t signaling_responses[NR_PENDING_SIGNALING_RESPONSES];
-static int signaling_responses_pending;
 static btstack_packet_callback_registration_t hci_event_callback_registration;
 
 #ifdef ENABLE_BLE
@@ -721,8 +715,6 @@ static void l2cap_ertm_handle_in_sequence_sdu(l2cap_channel_t * l2cap_channel, l
 #endif
 
 void l2cap_init(void){
-    signaling_responses_pending = 0;
-    
     l2cap_channels = NULL;
 
 #ifdef ENABLE_CLASSIC
@@ -1277,88 +1269,193 @@ static uint32_t l2cap_extended_features_mask(void){
 }
 #endif
 
-// MARK: L2CAP_RUN
-// process outstanding signaling tasks
-static void l2cap_run(void){
-    
-    // log_info("l2cap_run: entered");
+// MARK: Signaling Responses
 
-    // check pending signaling responses
-    while (signaling_responses_pending){
-        
-        hci_con_handle_t handle = signaling_responses[0].handle;
-        
-        if (!hci_can_send_acl_packet_now(handle)) break;
+// Classic signaling commands for responses can be packed into a single C-frame, LE C-frames contain a single command
+static int l2cap_signaling_response_is_le(const l2cap_signaling_response_t * response){
+#ifdef ENABLE_BLE
+    switch (response->code){
+        case LE_CREDIT_BASED_CONNECTION_REQUEST:
+        case COMMAND_REJECT_LE:
+            return 1;
+        default:
+            break;
+    }
+#else
+    UNUSED(response);
+#endif
+    return 0;
+}
 
-        uint8_t  sig_id        = signaling_responses[0].sig_id;
-        uint8_t  response_code = signaling_responses[0].code;
-        uint16_t result        = signaling_responses[0].data;  // CONNECTION_REQUEST, COMMAND_REJECT
 #ifdef ENABLE_CLASSIC
-        uint16_t info_type     = signaling_responses[0].data;  // INFORMATION_REQUEST
-        uint16_t source_cid    = signaling_responses[0].cid;   // CONNECTION_REQUEST
+// size of response command in C-frame
+static uint16_t l2cap_signaling_response_size(const l2cap_signaling_response_t * response){
+    switch (response->code){
+        case CONNECTION_REQUEST:
+            return 4 + 8;
+        case INFORMATION_REQUEST:
+            switch (response->data){
+                case L2CAP_INFO_TYPE_CONNECTIONLESS_MTU:
+                    return 4 + 4 + 2;
+                case L2CAP_INFO_TYPE_EXTENDED_FEATURES_SUPPORTED:
+                    return 4 + 4 + 4;
+                case L2CAP_INFO_TYPE_FIXED_CHANNELS_SUPPORTED:
+                    return 4 + 4 + 8;
+                default:
+                    return 4 + 4;
+            }
+        case COMMAND_REJECT:
+            return 4 + 2;
+        default:
+            return 4;
+    }
+}
+
+static uint16_t l2cap_signaling_response_store_classic(uint8_t * acl_buffer, hci_con_handle_t handle, int append, L2CAP_SIGNALING_COMMANDS cmd, int identifier, ...){
+    va_list argptr;
+    va_start(argptr, identifier);
+    uint16_t len;
+    if (append){
+        len = l2cap_append_signaling_classic(acl_buffer, cmd, identifier, argptr);
+    } else {
+        len = l2cap_create_signaling_classic(acl_buffer, handle, cmd, identifier, argptr);
+    }
+    va_end(argptr);
+    return len;
+}
 #endif
 
-        // remove first item before sending (to avoid sending response mutliple times)
-        signaling_responses_pending--;
-        int i;
-        for (i=0; i < signaling_responses_pending; i++){
-            memcpy(&signaling_responses[i], &signaling_responses[i+1], sizeof(l2cap_signaling_response_t));
-        }
+#ifdef ENABLE_BLE
+static uint16_t l2cap_signaling_response_store_le(uint8_t * acl_buffer, hci_con_handle_t handle, L2CAP_SIGNALING_COMMANDS cmd, int identifier, ...){
+    va_list argptr;
+    va_start(argptr, identifier);
+    uint16_t len = l2cap_create_signaling_le(acl_buffer, handle, cmd, identifier, argptr);
+    va_end(argptr);
+    return len;
+}
+#endif
 
-        switch (response_code){
+// store response in outgoing packet buffer, append to C-frame if len > 0. returns size of ACL packet
+static uint16_t l2cap_signaling_response_store(uint8_t * acl_buffer, hci_con_handle_t handle, uint16_t len, const l2cap_signaling_response_t * response){
+    uint8_t  sig_id        = response->sig_id;
+    uint16_t result        = response->data;  // CONNECTION_REQUEST, COMMAND_REJECT
 #ifdef ENABLE_CLASSIC
-            case CONNECTION_REQUEST:
-                l2cap_send_signaling_packet(handle, CONNECTION_RESPONSE, sig_id, source_cid, 0, result, 0);
-                // also disconnect if result is 0x0003 - security blocked
-                if (result == 0x0003){
-                    hci_disconnect_security_block(handle);
-                }
-                break;
-            case ECHO_REQUEST:
-                l2cap_send_signaling_packet(handle, ECHO_RESPONSE, sig_id, 0, NULL);
-                break;
-            case INFORMATION_REQUEST:
-                switch (info_type){
-                    case L2CAP_INFO_TYPE_CONNECTIONLESS_MTU: {
-                            uint16_t connectionless_mtu = hci_max_acl_data_packet_length();
-                            l2cap_send_signaling_packet(handle, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(connectionless_mtu), &connectionless_mtu);
-                        }
-                        break;
-                    case L2CAP_INFO_TYPE_EXTENDED_FEATURES_SUPPORTED: {
-                            uint32_t features = l2cap_extended_features_mask();
-                            l2cap_send_signaling_packet(handle, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(features), &features);
-                        }
-                        break;
-                    case L2CAP_INFO_TYPE_FIXED_CHANNELS_SUPPORTED: {
-                            uint8_t map[8];
-                            memset(map, 0, 8);
-                            map[0] = 0x06;  // L2CAP Signaling Channel (0x02) + Connectionless reception (0x04)
-                            l2cap_send_signaling_packet(handle, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(map), &map);
-                        }
-                        break;
-                    default:
-                        // all other types are not supported
-                        l2cap_send_signaling_packet(handle, INFORMATION_RESPONSE, sig_id, info_type, 1, 0, NULL);
-                        break;                        
-                }
-                break;
-            case COMMAND_REJECT:
-                l2cap_send_signaling_packet(handle, COMMAND_REJECT, sig_id, result, 0, NULL);
-                break;
+    int      append        = len > 0;
+    uint16_t info_type     = response->data;  // INFORMATION_REQUEST
+    uint16_t source_cid    = response->cid;   // CONNECTION_REQUEST
+#else
+    UNUSED(len);
+    UNUSED(result);
+    UNUSED(sig_id);
+    UNUSED(handle);
+    UNUSED(acl_buffer);
+#endif
+
+    switch (response->code){
+#ifdef ENABLE_CLASSIC
+        case CONNECTION_REQUEST:
+            return l2cap_signaling_response_store_classic(acl_buffer, handle, append, CONNECTION_RESPONSE, sig_id, source_cid, 0, result, 0);
+        case ECHO_REQUEST:
+            return l2cap_signaling_response_store_classic(acl_buffer, handle, append, ECHO_RESPONSE, sig_id, 0, NULL);
+        case INFORMATION_REQUEST:
+            switch (info_type){
+                case L2CAP_INFO_TYPE_CONNECTIONLESS_MTU: {
+                        uint16_t connectionless_mtu = hci_max_acl_data_packet_length();
+                        return l2cap_signaling_response_store_classic(acl_buffer, handle, append, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(connectionless_mtu), &connectionless_mtu);
+                    }
+                case L2CAP_INFO_TYPE_EXTENDED_FEATURES_SUPPORTED: {
+                        uint32_t features = l2cap_extended_features_mask();
+                        return l2cap_signaling_response_store_classic(acl_buffer, handle, append, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(features), &features);
+                    }
+                case L2CAP_INFO_TYPE_FIXED_CHANNELS_SUPPORTED: {
+                        uint8_t map[8];
+                        memset(map, 0, 8);
+                        map[0] = 0x06;  // L2CAP Signaling Channel (0x02) + Connectionless reception (0x04)
+                        return l2cap_signaling_response_store_classic(acl_buffer, handle, append, INFORMATION_RESPONSE, sig_id, info_type, 0, sizeof(map), &map);
+                    }
+                default:
+                    // all other types are not supported
+                    return l2cap_signaling_response_store_classic(acl_buffer, handle, append, INFORMATION_RESPONSE, sig_id, info_type, 1, 0, NULL);
+            }
+        case COMMAND_REJECT:
+            return l2cap_signaling_response_store_classic(acl_buffer, handle, append, COMMAND_REJECT, sig_id, result, 0, NULL);
 #endif
 #ifdef ENABLE_BLE
-            case LE_CREDIT_BASED_CONNECTION_REQUEST:
-                l2cap_send_le_signaling_packet(handle, LE_CREDIT_BASED_CONNECTION_RESPONSE, sig_id, 0, 0, 0, 0, result);
-                break;
-            case COMMAND_REJECT_LE:
-                l2cap_send_le_signaling_packet(handle, COMMAND_REJECT, sig_id, result, 0, NULL);
-                break;
+        case LE_CREDIT_BASED_CONNECTION_REQUEST:
+            return l2cap_signaling_response_store_le(acl_buffer, handle, LE_CREDIT_BASED_CONNECTION_RESPONSE, sig_id, 0, 0, 0, 0, result);
+        case COMMAND_REJECT_LE:
+            return l2cap_signaling_response_store_le(acl_buffer, handle, COMMAND_REJECT, sig_id, result, 0, NULL);
 #endif
-            default:
-                // should not happen
-                break;
+        default:
+            // should not happen
+            return len;
+    }
+}
+
+// send queued responses for each connection, multiple Classic responses are packed into a single C-frame
+static void l2cap_run_signaling_responses(void){
+    btstack_linked_list_iterator_t it;
+    hci_connections_get_iterator(&it);
+    while(btstack_linked_list_iterator_has_next(&it)){
+        hci_connection_t * connection = (hci_connection_t *) btstack_linked_list_iterator_next(&it);
+        l2cap_signaling_response_queue_t * queue = &connection->l2cap_signaling_responses;
+        if (queue->count == 0) continue;
+
+        hci_con_handle_t handle = connection->con_handle;
+        if (!hci_can_send_acl_packet_now(handle)) continue;
+
+        hci_reserve_packet_buffer();
+        uint8_t * acl_buffer = hci_get_outgoing_packet_buffer();
+        uint16_t len = 0;
+        int security_block = 0;
+        while (queue->count){
+            const l2cap_signaling_response_t * response = &queue->responses[queue->head];
+            if (len > 0){
+                if (l2cap_signaling_response_is_le(response)) break;
+#ifdef ENABLE_CLASSIC
+                // C-frame must not exceed minimal signaling MTU
+                if (little_endian_read_16(acl_buffer, 4) + l2cap_signaling_response_size(response) > L2CAP_MINIMAL_MTU) break;
+#endif
+            }
+            len = l2cap_signaling_response_store(acl_buffer, handle, len, response);
+#ifdef ENABLE_CLASSIC
+            // also disconnect if result is 0x0003 - security blocked
+            if (response->code == CONNECTION_REQUEST && response->data == 0x0003){
+                security_block = 1;
+            }
+#endif
+            int is_le = l2cap_signaling_response_is_le(response);
+            queue->head = (queue->head + 1) % L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE;
+            queue->count--;
+            if (is_le) break;
+        }
+
+        if (len == 0){
+            hci_release_packet_buffer();
+            continue;
+        }
+        hci_send_acl_packet_buffer(len);
+
+        if (security_block){
+            hci_disconnect_security_block(handle);
         }
     }
+}
+
+uint16_t l2cap_get_num_dropped_signaling_responses(hci_con_handle_t con_handle){
+    hci_connection_t * connection = hci_connection_for_handle(con_handle);
+    if (!connection) return 0;
+    return connection->l2cap_signaling_responses.num_dropped;
+}
+
+// MARK: L2CAP_RUN
+// process outstanding signaling tasks
+static void l2cap_run(void){
+    
+    // log_info("l2cap_run: entered");
+
+    // send pending signaling responses
+    l2cap_run_signaling_responses();
     
 #if defined(ENABLE_CLASSIC) || defined(ENABLE_BLE)
     btstack_linked_list_iterator_t it;    
@@ -2189,16 +2286,22 @@ static void l2cap_hci_event_handler(uint8_t packet_type, uint16_t cid, uint8_t *
 }
 
 static void l2cap_register_signaling_response(hci_con_handle_t handle, uint8_t code, uint8_t sig_id, uint16_t cid, uint16_t data){
-    // Vol 3, Part A, 4.3: "The DCID and SCID fields shall be ignored when the result field indi- cates the connection was refused."
-    if (signaling_responses_pending < NR_PENDING_SIGNALING_RESPONSES) {
-        signaling_responses[signaling_responses_pending].handle = handle;
-        signaling_responses[signaling_responses_pending].code = code;
-        signaling_responses[signaling_responses_pending].sig_id = sig_id;
-        signaling_responses[signaling_responses_pending].cid = cid;
-        signaling_responses[signaling_responses_pending].data = data;
-        signaling_responses_pending++;
-        l2cap_run();
+    hci_connection_t * connection = hci_connection_for_handle(handle);
+    if (!connection) return;
+    l2cap_signaling_response_queue_t * queue = &connection->l2cap_signaling_responses;
+    if (queue->count == L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE){
+        queue->num_dropped++;
+        log_error("l2cap_register_signaling_response: queue full for handle 0x%04x, %u responses dropped", handle, queue->num_dropped);
+        return;
     }
+    // Vol 3, Part A, 4.3: "The DCID and SCID fields shall be ignored when the result field indi- cates the connection was refused."
+    l2cap_signaling_response_t * response = &queue->responses[(queue->head + queue->count) % L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE];
+    response->code   = code;
+    response->sig_id = sig_id;
+    response->cid    = cid;
+    response->data   = data;
+    queue->count++;
+    l2cap_run();
 }
 
 #ifdef ENABLE_CLASSIC
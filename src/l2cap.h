@@ -388,15 +388,6 @@ typedef struct {
 } l2cap_service_t;
 
 
-typedef struct l2cap_signaling_response {
-    hci_con_handle_t handle;
-    uint8_t  sig_id;
-    uint8_t  code;
-    uint16_t cid;  // source cid for CONNECTION REQUEST
-    uint16_t data; // infoType for INFORMATION REQUEST, result for CONNECTION REQUEST and COMMAND UNKNOWN
-} l2cap_signaling_response_t;
-
-
 void l2cap_register_fixed_channel(btstack_packet_handler_t packet_handler, uint16_t channel_id);
 int  l2cap_can_send_fixed_channel_packet_now(hci_con_handle_t con_handle, uint16_t channel_id);
 void l2cap_request_can_send_fix_channel_now_event(hci_con_handle_t con_handle, uint16_t channel_id);
@@ -432,6 +423,13 @@ uint16_t l2cap_max_mtu(void);
  */
 uint16_t l2cap_max_le_mtu(void);
 
+/**
+ * @brief Get number of signaling responses (rejects, echo and information responses) dropped as queue was full, see L2CAP_SIGNALING_RESPONSE_QUEUE_SIZE
+ * @param con_handle
+ * @return number of dropped responses
+ */
+uint16_t l2cap_get_num_dropped_signaling_responses(hci_con_handle_t con_handle);
+
 /**
 * @brief Set the max MTU for LE connections, if not set l2cap_max_mtu() will be used.
 */
@@ -95,30 +95,27 @@ uint16_t l2cap_next_local_cid(void){
     return source_cid++;
 }
 
-static uint16_t l2cap_create_signaling_internal(uint8_t * acl_buffer, hci_con_handle_t handle, uint16_t cid, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr){
+// append signaling command at pos, returns pos after command or 0 for invalid command
+static uint16_t l2cap_append_signaling_command(uint8_t * acl_buffer, uint16_t pos, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr){
     
     const char *format = NULL;
     if (cmd > 0 && cmd <= num_l2cap_commands) {
         format = l2cap_signaling_commands_format[cmd-1];
     }
     if (!format){
-        log_error("l2cap_create_signaling_internal: invalid command id 0x%02x", cmd);
+        log_error("l2cap_append_signaling_command: invalid command id 0x%02x", cmd);
         return 0;
     }
 
-    int pb = hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+    uint16_t command_pos = pos;
+    // 0 - Code
+    acl_buffer[pos++] = cmd;
+    // 1 - id (!= 0 sequentially)
+    acl_buffer[pos++] = identifier;
+    // 2 - length, see below
+    pos += 2;
 
-    // 0 - Connection handle : PB=pb : BC=00 
-    little_endian_store_16(acl_buffer, 0, handle | (pb << 12) | (0 << 14));
-    // 6 - L2CAP channel = 1
-    little_endian_store_16(acl_buffer, 6, cid);
-    // 8 - Code
-    acl_buffer[8] = cmd;
-    // 9 - id (!= 0 sequentially)
-    acl_buffer[9] = identifier;
-    
-    // 12 - L2CAP signaling parameters
-    uint16_t pos = 12;
+    // 4 - L2CAP signaling parameters
     uint16_t word;
     uint8_t * ptr;
     while (*format) {
@@ -143,8 +140,13 @@ static uint16_t l2cap_create_signaling_internal(uint8_t * acl_buffer, hci_con_ha
         }
         format++;
     };
-    va_end(argptr);
-    
+
+    // 2 - L2CAP signaling parameter length
+    little_endian_store_16(acl_buffer, command_pos + 2, pos - command_pos - 4);
+    return pos;
+}
+
+static void l2cap_store_signaling_lengths(uint8_t * acl_buffer, uint16_t pos){
     // Fill in various length fields: it's the number of bytes following for ACL lenght and l2cap parameter length
     // - the l2cap payload length is counted after the following channel id (only payload) 
     
@@ -152,9 +154,21 @@ static uint16_t l2cap_create_signaling_internal(uint8_t * acl_buffer, hci_con_ha
     little_endian_store_16(acl_buffer, 2,  pos - 4);
     // 4 - L2CAP packet length
     little_endian_store_16(acl_buffer, 4,  pos - 6 - 2);
-    // 10 - L2CAP signaling parameter length
-    little_endian_store_16(acl_buffer, 10, pos - 12);
-    
+}
+
+static uint16_t l2cap_create_signaling_internal(uint8_t * acl_buffer, hci_con_handle_t handle, uint16_t cid, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr){
+
+    int pb = hci_non_flushable_packet_boundary_flag_supported() ? 0x00 : 0x02;
+
+    // 0 - Connection handle : PB=pb : BC=00 
+    little_endian_store_16(acl_buffer, 0, handle | (pb << 12) | (0 << 14));
+    // 6 - L2CAP channel = 1
+    little_endian_store_16(acl_buffer, 6, cid);
+    // 8 - L2CAP signaling command
+    uint16_t pos = l2cap_append_signaling_command(acl_buffer, 8, cmd, identifier, argptr);
+    if (!pos) return 0;
+
+    l2cap_store_signaling_lengths(acl_buffer, pos);
     return pos;
 }
 
@@ -162,6 +176,15 @@ uint16_t l2cap_create_signaling_classic(uint8_t * acl_buffer, hci_con_handle_t h
     return l2cap_create_signaling_internal(acl_buffer, handle, 1, cmd, identifier, argptr);
 }
 
+uint16_t l2cap_append_signaling_classic(uint8_t * acl_buffer, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr){
+    // C-frame created by l2cap_create_signaling_classic
+    uint16_t size = 8 + little_endian_read_16(acl_buffer, 4);
+    uint16_t pos  = l2cap_append_signaling_command(acl_buffer, size, cmd, identifier, argptr);
+    if (!pos) return size;
+    l2cap_store_signaling_lengths(acl_buffer, pos);
+    return pos;
+}
+
 #ifdef ENABLE_BLE
 uint16_t l2cap_create_signaling_le(uint8_t * acl_buffer, hci_con_handle_t handle, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr){
     return l2cap_create_signaling_internal(acl_buffer, handle, 5, cmd, identifier, argptr);
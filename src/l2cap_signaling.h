@@ -83,6 +83,8 @@ typedef enum {
 } l2cap_channel_mode_t;
 
 uint16_t l2cap_create_signaling_classic(uint8_t * acl_buffer,hci_con_handle_t handle, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr);
+// append command to C-frame created by l2cap_create_signaling_classic, returns new size of ACL packet
+uint16_t l2cap_append_signaling_classic(uint8_t * acl_buffer, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr);
 uint16_t l2cap_create_signaling_le(uint8_t * acl_buffer, hci_con_handle_t handle, L2CAP_SIGNALING_COMMANDS cmd, uint8_t identifier, va_list argptr);
 uint8_t  l2cap_next_sig_id(void);
 uint16_t l2cap_next_local_cid(void);
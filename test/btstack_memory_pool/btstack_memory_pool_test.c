@@ -0,0 +1,92 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+#include "btstack_memory_pool.h"
+
+#define NUM_BLOCKS 3
+
+typedef struct {
+    void * next;
+    uint32_t data;
+} block_t;
+
+static block_t storage[NUM_BLOCKS];
+
+TEST_GROUP(MemoryPool){
+    btstack_memory_pool_t pool;
+
+    void setup(void){
+        btstack_memory_pool_create(&pool, storage, NUM_BLOCKS, sizeof(block_t));
+    }
+};
+
+TEST(MemoryPool, EmptyStats){
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(0, stats.num_used);
+    CHECK_EQUAL(0, stats.max_used);
+    CHECK_EQUAL(0, stats.num_failed);
+}
+
+TEST(MemoryPool, GetAllBlocks){
+    void * blocks[NUM_BLOCKS];
+    int i;
+    for (i=0;i<NUM_BLOCKS;i++){
+        blocks[i] = btstack_memory_pool_get(&pool);
+        CHECK(blocks[i] != NULL);
+    }
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(NUM_BLOCKS, stats.num_used);
+    CHECK_EQUAL(NUM_BLOCKS, stats.max_used);
+    CHECK_EQUAL(1, stats.num_failed);
+}
+
+TEST(MemoryPool, HighWaterMark){
+    void * block_a = btstack_memory_pool_get(&pool);
+    void * block_b = btstack_memory_pool_get(&pool);
+    btstack_memory_pool_free(&pool, block_a);
+    btstack_memory_pool_free(&pool, block_b);
+    void * block_c = btstack_memory_pool_get(&pool);
+    CHECK(block_c != NULL);
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(1, stats.num_used);
+    CHECK_EQUAL(2, stats.max_used);
+    CHECK_EQUAL(0, stats.num_failed);
+}
+
+TEST(MemoryPool, DoubleFree){
+    void * block = btstack_memory_pool_get(&pool);
+    void * other = btstack_memory_pool_get(&pool);
+    btstack_memory_pool_free(&pool, block);
+    btstack_memory_pool_free(&pool, block);
+    btstack_memory_pool_stats_t stats;
+    btstack_memory_pool_get_stats(&pool, &stats);
+    CHECK_EQUAL(1, stats.num_used);
+    // block is only once in free list
+    POINTERS_EQUAL(block, btstack_memory_pool_get(&pool));
+    void * last = btstack_memory_pool_get(&pool);
+    CHECK(last != NULL);
+    CHECK(last != block);
+    CHECK(last != other);
+    POINTERS_EQUAL(NULL, btstack_memory_pool_get(&pool));
+}
+
+TEST(MemoryPool, TrackExternalAllocations){
+    btstack_memory_pool_stats_t stats = { 0, 0, 0 };
+    block_t block;
+    btstack_memory_pool_stats_track_get(&stats, &block);
+    btstack_memory_pool_stats_track_get(&stats, NULL);
+    CHECK_EQUAL(1, stats.num_used);
+    CHECK_EQUAL(1, stats.max_used);
+    CHECK_EQUAL(1, stats.num_failed);
+    btstack_memory_pool_stats_track_free(&stats, &block);
+    btstack_memory_pool_stats_track_free(&stats, NULL);
+    CHECK_EQUAL(0, stats.num_used);
+    CHECK_EQUAL(1, stats.max_used);
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -116,6 +116,41 @@ TEST(LE_DEVICE_DB, AddOTwoRemoveOneAddOne){
     CHECK_EQUAL_ARRAY(addr_cc, addr, 6);
 }
 
+TEST(LE_DEVICE_DB, LookupByAddress){
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    le_device_db_add(BD_ADDR_TYPE_LE_RANDOM, addr_bb, sm_key_bb);
+    CHECK_EQUAL(0, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, addr_aa));
+    CHECK_EQUAL(1, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_RANDOM, addr_bb));
+    CHECK_EQUAL(-1, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, addr_bb));
+    CHECK_EQUAL(-1, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, addr_cc));
+    le_device_db_remove(0);
+    CHECK_EQUAL(-1, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, addr_aa));
+}
+
+TEST(LE_DEVICE_DB, LookupByIrk){
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_bb, sm_key_bb);
+    CHECK_EQUAL(1, le_device_db_lookup_by_irk(sm_key_bb));
+    CHECK_EQUAL(-1, le_device_db_lookup_by_irk(sm_key_cc));
+}
+
+TEST(LE_DEVICE_DB, AddExistingUpdates){
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_cc);
+    CHECK_EQUAL(1, le_device_db_count());
+    CHECK_EQUAL(0, le_device_db_lookup_by_irk(sm_key_cc));
+    CHECK_EQUAL(-1, le_device_db_lookup_by_irk(sm_key_aa));
+}
+
+TEST(LE_DEVICE_DB, IndexRestoredFromTLV){
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_aa, sm_key_aa);
+    le_device_db_add(BD_ADDR_TYPE_LE_PUBLIC, addr_bb, sm_key_bb);
+    le_device_db_tlv_configure(btstack_tlv_impl, &btstack_tlv_context);
+    CHECK_EQUAL(2, le_device_db_count());
+    CHECK_EQUAL(1, le_device_db_lookup_by_address(BD_ADDR_TYPE_LE_PUBLIC, addr_bb));
+    CHECK_EQUAL(0, le_device_db_lookup_by_irk(sm_key_aa));
+}
+
 
 int main (int argc, const char * argv[]){
     hci_dump_open("tlv_le_test.pklg", HCI_DUMP_PACKETLOGGER);
@@ -26,6 +26,7 @@
 
 static uint16_t gatt_client_handle = 0x40;
 static int gatt_query_complete = 0;
+static int gatt_query_complete_status = -1;    // -1 = no query complete event
 
 typedef enum {
 	IDLE,
@@ -54,7 +55,8 @@ typedef enum {
     READ_LONG_CHARACTERISTIC_DESCRIPTOR,
     WRITE_LONG_CHARACTERISTIC_DESCRIPTOR,
     WRITE_RELIABLE_LONG_CHARACTERISTIC_VALUE,
-    WRITE_CHARACTERISTIC_VALUE_WITHOUT_RESPONSE
+    WRITE_CHARACTERISTIC_VALUE_WITHOUT_RESPONSE,
+    DISCOVER_DATABASE
 } current_test_t;
 
 current_test_t test = IDLE;
@@ -150,6 +152,7 @@ static void handle_ble_client_event(uint8_t packet_type, uint16_t channel, uint8
 	switch (packet[0]){
 		case GATT_EVENT_QUERY_COMPLETE:
 			status = packet[4];
+            gatt_query_complete_status = status;
             gatt_query_complete = 1;
             if (status){
                 gatt_query_complete = 0;
@@ -302,6 +305,7 @@ TEST_GROUP(GATTClient){
 
 	void reset_query_state(void){
 		gatt_query_complete = 0;
+		gatt_query_complete_status = -1;
 		result_counter = 0;
 		result_index = 0;
 	}
@@ -466,6 +470,91 @@ TEST(GATTClient, TestDiscoverCharacteristicDescriptor){
 	CHECK_EQUAL(0x2901, descriptors[2].uuid16);
 }
 
+TEST(GATTClient, TestDiscoverDatabase){
+	static gatt_client_database_service_t        database_services[10];
+	static gatt_client_database_characteristic_t database_characteristics[50];
+	static gatt_client_characteristic_descriptor_t database_descriptors[50];
+	gatt_client_database_t database;
+	gatt_client_database_init(&database, database_services, 10, database_characteristics, 50, database_descriptors, 50);
+
+	test = DISCOVER_DATABASE;
+	reset_query_state();
+	status = gatt_client_discover_database(handle_ble_client_event, gatt_client_handle, &database);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(0, result_counter);
+
+	// compare with service by service discovery
+	reset_query_state();
+	status = gatt_client_discover_primary_services(handle_ble_client_event, gatt_client_handle);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 1);
+	CHECK_EQUAL(result_index, database.num_services);
+
+	gatt_client_service_t primary_services[10];
+	memcpy(primary_services, services, sizeof(primary_services));
+	uint16_t num_services = result_index;
+	uint16_t num_descriptors = 0;
+	for (int i = 0; i < num_services; i++){
+		gatt_client_database_service_t * service = &database.services[i];
+		CHECK_EQUAL(primary_services[i].start_group_handle, service->service.start_group_handle);
+		CHECK_EQUAL(primary_services[i].end_group_handle,   service->service.end_group_handle);
+		CHECK_EQUAL(primary_services[i].uuid16, service->service.uuid16);
+		CHECK_EQUAL_ARRAY(primary_services[i].uuid128, service->service.uuid128, 16);
+
+		reset_query_state();
+		status = gatt_client_discover_characteristics_for_service(handle_ble_client_event, gatt_client_handle, &primary_services[i]);
+		CHECK_EQUAL(status, 0);
+		CHECK_EQUAL(gatt_query_complete, 1);
+		CHECK_EQUAL(result_index, service->num_characteristics);
+
+		gatt_client_characteristic_t service_characteristics[50];
+		memcpy(service_characteristics, characteristics, sizeof(service_characteristics));
+		for (int j = 0; j < service->num_characteristics; j++){
+			gatt_client_database_characteristic_t * characteristic = &database.characteristics[service->first_characteristic + j];
+			CHECK_EQUAL(service_characteristics[j].start_handle, characteristic->characteristic.start_handle);
+			CHECK_EQUAL(service_characteristics[j].value_handle, characteristic->characteristic.value_handle);
+			CHECK_EQUAL(service_characteristics[j].end_handle,   characteristic->characteristic.end_handle);
+			CHECK_EQUAL(service_characteristics[j].properties,   characteristic->characteristic.properties);
+			CHECK_EQUAL(service_characteristics[j].uuid16,       characteristic->characteristic.uuid16);
+			CHECK_EQUAL_ARRAY(service_characteristics[j].uuid128, characteristic->characteristic.uuid128, 16);
+
+			reset_query_state();
+			if (service_characteristics[j].value_handle < service_characteristics[j].end_handle){
+				status = gatt_client_discover_characteristic_descriptors(handle_ble_client_event, gatt_client_handle, &service_characteristics[j]);
+				CHECK_EQUAL(status, 0);
+				CHECK_EQUAL(gatt_query_complete, 1);
+			}
+			CHECK_EQUAL(result_index, characteristic->num_descriptors);
+			for (int k = 0; k < characteristic->num_descriptors; k++){
+				gatt_client_characteristic_descriptor_t * descriptor = &database.descriptors[characteristic->first_descriptor + k];
+				CHECK_EQUAL(descriptors[k].handle, descriptor->handle);
+				CHECK_EQUAL_ARRAY(descriptors[k].uuid128, descriptor->uuid128, 16);
+			}
+			num_descriptors += characteristic->num_descriptors;
+		}
+	}
+	CHECK(database.num_characteristics > 0);
+	CHECK(num_descriptors > 0);
+	CHECK_EQUAL(num_descriptors, database.num_descriptors);
+}
+
+TEST(GATTClient, TestDiscoverDatabaseInsufficientResources){
+	static gatt_client_database_service_t        database_services[2];
+	static gatt_client_database_characteristic_t database_characteristics[2];
+	static gatt_client_characteristic_descriptor_t database_descriptors[2];
+	gatt_client_database_t database;
+	gatt_client_database_init(&database, database_services, 2, database_characteristics, 2, database_descriptors, 2);
+
+	test = DISCOVER_DATABASE;
+	reset_query_state();
+	status = gatt_client_discover_database(handle_ble_client_event, gatt_client_handle, &database);
+	CHECK_EQUAL(status, 0);
+	CHECK_EQUAL(gatt_query_complete, 0);
+	CHECK_EQUAL(ATT_ERROR_INSUFFICIENT_RESOURCES, gatt_query_complete_status);
+	CHECK_EQUAL(2, database.num_services);
+}
+
 TEST(GATTClient, TestWriteClientCharacteristicConfiguration){
 	test = WRITE_CLIENT_CHARACTERISTIC_CONFIGURATION;
 	reset_query_state();
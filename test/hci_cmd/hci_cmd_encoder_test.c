@@ -0,0 +1,158 @@
+
+// *****************************************************************************
+//
+// HCI Command Encoder tests: compare typed encoders with hci_cmd_create_from_template
+//
+// *****************************************************************************
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btstack_config.h"
+
+#include "hci_cmd.h"
+#include "hci_cmd_encoder.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+static uint8_t template_buffer[300];
+static uint8_t encoder_buffer[300];
+static uint16_t template_size;
+
+static void create_from_template(const hci_cmd_t * cmd, ...){
+    memset(template_buffer, 0x55, sizeof(template_buffer));
+    va_list argptr;
+    va_start(argptr, cmd);
+    template_size = hci_cmd_create_from_template(template_buffer, cmd, argptr);
+    va_end(argptr);
+    // encoder must write the same bytes
+    memset(encoder_buffer, 0xaa, sizeof(encoder_buffer));
+}
+
+static void check_encoder(uint16_t encoder_size){
+    CHECK_EQUAL(template_size, encoder_size);
+    MEMCMP_EQUAL(template_buffer, encoder_buffer, template_size);
+}
+
+static bd_addr_t addr = { 0x00, 0x1b, 0xdc, 0x07, 0x32, 0xef };
+static uint8_t data[240];
+
+TEST_GROUP(HCICmdEncoder){
+    void setup(void){
+        int i;
+        for (i=0;i<(int)sizeof(data);i++){
+            data[i] = i;
+        }
+    }
+};
+
+TEST(HCICmdEncoder, NoParams){
+    create_from_template(&hci_reset);
+    check_encoder(hci_cmd_create_reset(encoder_buffer));
+}
+
+TEST(HCICmdEncoder, Inquiry){
+    create_from_template(&hci_inquiry, 0x9e8b33, 0x30, 0x00);
+    check_encoder(hci_cmd_create_inquiry(encoder_buffer, 0x9e8b33, 0x30, 0x00));
+}
+
+TEST(HCICmdEncoder, ClassOfDevice){
+    create_from_template(&hci_write_class_of_device, 0x2540);
+    check_encoder(hci_cmd_create_write_class_of_device(encoder_buffer, 0x2540));
+}
+
+TEST(HCICmdEncoder, LinkKeyRequestReply){
+    create_from_template(&hci_link_key_request_reply, addr, data);
+    check_encoder(hci_cmd_create_link_key_request_reply(encoder_buffer, addr, data));
+}
+
+TEST(HCICmdEncoder, EnhancedSetupSynchronousConnection){
+    create_from_template(&hci_enhanced_setup_synchronous_connection, 0x0b01, 8000, 8000, 0x05, 0x0000, 0x0000, 0x05, 0x0000, 0x0000, 60, 60,
+        32000, 32000, 0x04, 0x0000, 0x0000, 0x04, 0x0000, 0x0000, 16, 16, 0x02, 0x02, 0, 0, 0x01, 0x01, 0, 0, 0x000d, 0x0388, 0x02);
+    check_encoder(hci_cmd_create_enhanced_setup_synchronous_connection(encoder_buffer, 0x0b01, 8000, 8000, 0x05, 0x0000, 0x0000, 0x05, 0x0000, 0x0000, 60, 60,
+        32000, 32000, 0x04, 0x0000, 0x0000, 0x04, 0x0000, 0x0000, 16, 16, 0x02, 0x02, 0, 0, 0x01, 0x01, 0, 0, 0x000d, 0x0388, 0x02));
+}
+
+TEST(HCICmdEncoder, SetEventMask){
+    create_from_template(&hci_set_event_mask, 0xffffffff, 0x20001fff);
+    check_encoder(hci_cmd_create_set_event_mask(encoder_buffer, 0xffffffff, 0x20001fff));
+}
+
+TEST(HCICmdEncoder, WriteLocalName){
+    const char * name = "BTstack 00:00:00:00:00:00";
+    create_from_template(&hci_write_local_name, name);
+    check_encoder(hci_cmd_create_write_local_name(encoder_buffer, name));
+}
+
+TEST(HCICmdEncoder, WriteLocalNameTruncated){
+    char name[300];
+    memset(name, 'a', sizeof(name));
+    name[sizeof(name)-1] = 0;
+    create_from_template(&hci_write_local_name, name);
+    check_encoder(hci_cmd_create_write_local_name(encoder_buffer, name));
+}
+
+TEST(HCICmdEncoder, ExtendedInquiryResponse){
+    create_from_template(&hci_write_extended_inquiry_response, 0, data);
+    check_encoder(hci_cmd_create_write_extended_inquiry_response(encoder_buffer, 0, data));
+}
+
+TEST(HCICmdEncoder, SetAdvertisingData){
+    create_from_template(&hci_le_set_advertising_data, 31, data);
+    check_encoder(hci_cmd_create_le_set_advertising_data(encoder_buffer, 31, data));
+}
+
+TEST(HCICmdEncoder, StartEncryption){
+    create_from_template(&hci_le_start_encryption, 0x0040, 0x12345678, 0x9abcdef0, 0x1234, data);
+    check_encoder(hci_cmd_create_le_start_encryption(encoder_buffer, 0x0040, 0x12345678, 0x9abcdef0, 0x1234, data));
+}
+
+TEST(HCICmdEncoder, ConnectionUpdate){
+    create_from_template(&hci_le_connection_update, 0x0040, 6, 12, 4, 400, 0x0000, 0xffff);
+    check_encoder(hci_cmd_create_le_connection_update(encoder_buffer, 0x0040, 6, 12, 4, 400, 0x0000, 0xffff));
+}
+
+TEST(HCICmdEncoder, WhiteList){
+    create_from_template(&hci_le_add_device_to_white_list, 1, addr);
+    check_encoder(hci_cmd_create_le_add_device_to_white_list(encoder_buffer, 1, addr));
+    create_from_template(&hci_le_remove_device_from_white_list, 0, addr);
+    check_encoder(hci_cmd_create_le_remove_device_from_white_list(encoder_buffer, 0, addr));
+}
+
+TEST(HCICmdEncoder, ResolvingList){
+    create_from_template(&hci_le_add_device_to_resolving_list, 1, addr, &data[0], &data[16]);
+    check_encoder(hci_cmd_create_le_add_device_to_resolving_list(encoder_buffer, 1, addr, &data[0], &data[16]));
+    create_from_template(&hci_le_remove_device_from_resolving_list, 0, addr);
+    check_encoder(hci_cmd_create_le_remove_device_from_resolving_list(encoder_buffer, 0, addr));
+    create_from_template(&hci_le_set_address_resolution_enable, 1);
+    check_encoder(hci_cmd_create_le_set_address_resolution_enable(encoder_buffer, 1));
+}
+
+TEST(HCICmdEncoder, ConnectionParameterRequestNegativeReply){
+    create_from_template(&hci_le_remote_connection_parameter_request_negative_reply, 0x0040, 0x3b);
+    check_encoder(hci_cmd_create_le_remote_connection_parameter_request_negative_reply(encoder_buffer, 0x0040, 0x3b));
+}
+
+TEST(HCICmdEncoder, GenerateDHKey){
+    create_from_template(&hci_le_generate_dhkey, &data[0], &data[32]);
+    check_encoder(hci_cmd_create_le_generate_dhkey(encoder_buffer, &data[0], &data[32]));
+}
+
+TEST(HCICmdEncoder, ExtendedAdvertisingParameters){
+    create_from_template(&hci_le_set_extended_advertising_parameters, 1, 0x0013, 0x000800, 0x001000, 7, 1, 0, addr, 0, 0x7f, 1, 0, 1, 0, 0);
+    check_encoder(hci_cmd_create_le_set_extended_advertising_parameters(encoder_buffer, 1, 0x0013, 0x000800, 0x001000, 7, 1, 0, addr, 0, 0x7f, 1, 0, 1, 0, 0));
+}
+
+TEST(HCICmdEncoder, ExtendedAdvertisingData){
+    create_from_template(&hci_le_set_extended_advertising_data, 1, 3, 1, 200, data);
+    check_encoder(hci_cmd_create_le_set_extended_advertising_data(encoder_buffer, 1, 3, 1, 200, data));
+    create_from_template(&hci_le_set_periodic_advertising_data, 1, 3, 0, data);
+    check_encoder(hci_cmd_create_le_set_periodic_advertising_data(encoder_buffer, 1, 3, 0, data));
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -55,6 +55,7 @@
 #include "mock.h"
 
 static uint8_t sdp_rfcomm_channel_nr = 1;
+static const uint16_t sdp_query_id = 1;
 const char sdp_rfcomm_service_name[] = "BTstackMock";
 static uint16_t rfcomm_cid = 1;
 static bd_addr_t dev_addr;
@@ -223,7 +224,7 @@ static void sdp_query_complete_response(uint8_t status){
     event[0] = SDP_EVENT_QUERY_COMPLETE;
     event[1] = 1;
     event[2] = status;
-    (*registered_sdp_app_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    (*registered_sdp_app_callback)(HCI_EVENT_PACKET, sdp_query_id, event, sizeof(event));
 }
 
 static void sdp_client_query_rfcomm_service_response(uint8_t status){
@@ -234,7 +235,7 @@ static void sdp_client_query_rfcomm_service_response(uint8_t status){
     event[2] = sdp_rfcomm_channel_nr;
     memcpy(&event[3], sdp_rfcomm_service_name, sdp_service_name_len);
     event[3+sdp_service_name_len] = 0;
-    (*registered_sdp_app_callback)(HCI_EVENT_PACKET, 0, event, sizeof(event));
+    (*registered_sdp_app_callback)(HCI_EVENT_PACKET, sdp_query_id, event, sizeof(event));
 }
 
 uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid){
@@ -245,6 +246,16 @@ uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid(btstack_packet_handler
     return 0;
 }
 
+uint8_t sdp_client_query_rfcomm_channel_and_name_for_uuid_with_query_id(btstack_packet_handler_t callback, bd_addr_t remote, uint16_t uuid, uint16_t * out_query_id){
+    registered_sdp_app_callback = callback;
+    if (out_query_id){
+        *out_query_id = sdp_query_id;
+    }
+    sdp_client_query_rfcomm_service_response(0);
+    sdp_query_complete_response(0);
+    return 0;
+}
+
 
 uint8_t rfcomm_create_channel(btstack_packet_handler_t handler, bd_addr_t addr, uint8_t channel, uint16_t * out_cid){
 
@@ -0,0 +1,243 @@
+#include "CppUTest/TestHarness.h"
+#include "CppUTest/CommandLineTestRunner.h"
+
+#include <string.h>
+
+#include "btstack_defines.h"
+#include "btstack_util.h"
+#include "classic/bnep.h"
+#include "classic/pan_nap_bridge.h"
+
+#define MAX_SENT 10
+
+static const uint8_t address_broadcast[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+static const uint8_t address_a[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0a };
+static const uint8_t address_b[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0b };
+static const uint8_t address_c[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0e };
+static const uint8_t address_d[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x0f };
+static const uint8_t address_x[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x99 };
+
+// BNEP mock
+
+static uint16_t can_send_now_requested;     // bit per bnep cid
+static int      num_sent;
+static uint16_t sent_cid[MAX_SENT];
+static uint8_t  sent_dest[MAX_SENT][6];
+
+void bnep_request_can_send_now_event(uint16_t bnep_cid){
+    can_send_now_requested |= 1 << bnep_cid;
+}
+
+int bnep_send(uint16_t bnep_cid, uint8_t *packet, uint16_t len){
+    (void) len;
+    if (num_sent >= MAX_SENT) return 0;
+    sent_cid[num_sent] = bnep_cid;
+    memcpy(sent_dest[num_sent], packet, 6);
+    num_sent++;
+    return 0;
+}
+
+// network interface mock
+
+static int num_network_packets;
+static int num_network_packets_sent;
+
+static void network_process_packet(const uint8_t * packet, uint16_t size){
+    (void) packet;
+    (void) size;
+    num_network_packets++;
+}
+
+static void network_packet_sent(void){
+    num_network_packets_sent++;
+}
+
+// helper
+
+static void build_frame(uint8_t * frame, const uint8_t * dest, const uint8_t * source){
+    memset(frame, 0, 20);
+    memcpy(&frame[0], dest, 6);
+    memcpy(&frame[6], source, 6);
+    big_endian_store_16(frame, 12, 0x0800);
+}
+
+static void channel_opened(uint16_t bnep_cid){
+    uint8_t event[17];
+    memset(event, 0, sizeof(event));
+    event[0] = BNEP_EVENT_CHANNEL_OPENED;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 3, bnep_cid);
+    pan_nap_bridge_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void channel_closed(uint16_t bnep_cid){
+    uint8_t event[16];
+    memset(event, 0, sizeof(event));
+    event[0] = BNEP_EVENT_CHANNEL_CLOSED;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 2, bnep_cid);
+    pan_nap_bridge_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void can_send_now(uint16_t bnep_cid){
+    uint8_t event[4];
+    event[0] = BNEP_EVENT_CAN_SEND_NOW;
+    event[1] = sizeof(event) - 2;
+    little_endian_store_16(event, 2, bnep_cid);
+    can_send_now_requested &= ~(1 << bnep_cid);
+    pan_nap_bridge_packet_handler(HCI_EVENT_PACKET, 0, event, sizeof(event));
+}
+
+static void receive_frame(uint16_t bnep_cid, const uint8_t * dest, const uint8_t * source){
+    uint8_t frame[20];
+    build_frame(frame, dest, source);
+    pan_nap_bridge_packet_handler(BNEP_DATA_PACKET, bnep_cid, frame, sizeof(frame));
+}
+
+TEST_GROUP(PanNapBridge){
+    void setup(void){
+        can_send_now_requested = 0;
+        num_sent = 0;
+        num_network_packets = 0;
+        num_network_packets_sent = 0;
+        pan_nap_bridge_init(&network_process_packet, &network_packet_sent);
+        channel_opened(1);
+        channel_opened(2);
+        channel_opened(3);
+    }
+};
+
+TEST(PanNapBridge, LearnAndUnicastToOwner){
+    receive_frame(1, address_x, address_a);
+    // unknown unicast goes to network interface only
+    CHECK_EQUAL(1, num_network_packets);
+    CHECK_EQUAL(0, can_send_now_requested);
+
+    // address a learned, unicast only forwarded to channel 1
+    receive_frame(2, address_a, address_b);
+    CHECK_EQUAL(1, num_network_packets);
+    CHECK_EQUAL(1 << 1, can_send_now_requested);
+    can_send_now(1);
+    CHECK_EQUAL(1, num_sent);
+    CHECK_EQUAL(1, sent_cid[0]);
+    MEMCMP_EQUAL(address_a, sent_dest[0], 6);
+    CHECK_EQUAL(0, can_send_now_requested);
+
+    // address b learned on channel 2, unicast from network interface only goes there
+    uint8_t frame[20];
+    build_frame(frame, address_b, address_x);
+    pan_nap_bridge_network_send_packet(frame, sizeof(frame));
+    CHECK_EQUAL(1 << 2, can_send_now_requested);
+    CHECK_EQUAL(0, num_network_packets_sent);
+    can_send_now(2);
+    CHECK_EQUAL(2, num_sent);
+    CHECK_EQUAL(2, sent_cid[1]);
+    CHECK_EQUAL(1, num_network_packets_sent);
+}
+
+TEST(PanNapBridge, UnicastToSender){
+    receive_frame(1, address_x, address_a);
+    receive_frame(1, address_a, address_c);
+    CHECK_EQUAL(1, num_network_packets);
+    CHECK_EQUAL(0, can_send_now_requested);
+}
+
+TEST(PanNapBridge, FloodBroadcast){
+    receive_frame(1, address_broadcast, address_a);
+    CHECK_EQUAL(1, num_network_packets);
+    CHECK_EQUAL((1 << 2) | (1 << 3), can_send_now_requested);
+    can_send_now(2);
+    can_send_now(3);
+    CHECK_EQUAL(2, num_sent);
+    CHECK_EQUAL(2, sent_cid[0]);
+    CHECK_EQUAL(3, sent_cid[1]);
+    CHECK_EQUAL(0, can_send_now_requested);
+
+    // broadcast from network interface goes to all channels
+    uint8_t frame[20];
+    build_frame(frame, address_broadcast, address_x);
+    pan_nap_bridge_network_send_packet(frame, sizeof(frame));
+    CHECK_EQUAL((1 << 1) | (1 << 2) | (1 << 3), can_send_now_requested);
+    can_send_now(1);
+    can_send_now(2);
+    CHECK_EQUAL(0, num_network_packets_sent);
+    can_send_now(3);
+    CHECK_EQUAL(5, num_sent);
+    CHECK_EQUAL(1, num_network_packets_sent);
+}
+
+TEST(PanNapBridge, FramesSentInOrder){
+    receive_frame(1, address_broadcast, address_a);
+    receive_frame(1, address_broadcast, address_b);
+    // no frame buffer left
+    receive_frame(1, address_broadcast, address_c);
+    CHECK_EQUAL(1, pan_nap_bridge_get_num_dropped_frames());
+    can_send_now(2);
+    CHECK_EQUAL(1 << 2, can_send_now_requested & (1 << 2));
+    can_send_now(2);
+    CHECK_EQUAL(2, num_sent);
+    CHECK_EQUAL(2, sent_cid[0]);
+    CHECK_EQUAL(2, sent_cid[1]);
+    CHECK_EQUAL(0, can_send_now_requested & (1 << 2));
+}
+
+TEST(PanNapBridge, RemoveChannelWithPendingFrames){
+    // frame from network interface pending on all channels
+    uint8_t frame[20];
+    build_frame(frame, address_broadcast, address_x);
+    pan_nap_bridge_network_send_packet(frame, sizeof(frame));
+    // frame buffers pending on channels 2 and 3
+    receive_frame(1, address_broadcast, address_a);
+    receive_frame(1, address_broadcast, address_b);
+
+    channel_closed(2);
+    channel_closed(3);
+    CHECK_EQUAL(0, num_network_packets_sent);
+    can_send_now(2);
+    CHECK_EQUAL(0, num_sent);
+
+    // buffers have been released
+    receive_frame(1, address_broadcast, address_c);
+    CHECK_EQUAL(0, pan_nap_bridge_get_num_dropped_frames());
+
+    channel_closed(1);
+    CHECK_EQUAL(0, num_sent);
+    CHECK_EQUAL(1, num_network_packets_sent);
+}
+
+TEST(PanNapBridge, RemoveChannelKeepsOtherAddresses){
+    // fill MAC table, entries collide and are placed by linear probing
+    receive_frame(1, address_x, address_a);
+    receive_frame(2, address_x, address_b);
+    receive_frame(1, address_x, address_c);
+    receive_frame(2, address_x, address_d);
+
+    CHECK_EQUAL(4, num_network_packets);
+    channel_closed(1);
+
+    // addresses of channel 2 still found
+    const uint8_t * addresses_channel_2[] = { address_b, address_d };
+    int i;
+    for (i = 0; i < 2; i++){
+        uint8_t frame[20];
+        build_frame(frame, addresses_channel_2[i], address_x);
+        pan_nap_bridge_network_send_packet(frame, sizeof(frame));
+        CHECK_EQUAL(1 << 2, can_send_now_requested);
+        can_send_now(2);
+        CHECK_EQUAL(i + 1, num_sent);
+        CHECK_EQUAL(2, sent_cid[i]);
+        CHECK_EQUAL(i + 1, num_network_packets_sent);
+    }
+
+    // addresses of channel 1 removed
+    const uint8_t * addresses_channel_1[] = { address_a, address_c };
+    for (i = 0; i < 2; i++){
+        receive_frame(3, addresses_channel_1[i], address_x);
+        CHECK_EQUAL(4 + i + 1, num_network_packets);
+        CHECK_EQUAL(0, can_send_now_requested);
+    }
+}
+
+int main (int argc, const char * argv[]){
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
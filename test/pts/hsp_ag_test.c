@@ -75,6 +75,7 @@ static bd_addr_t pts_addr = {0x00,0x1A,0x7D,0xDA,0x71,0x0A};
 // static bd_addr_t pts_addr = {0x00,0x1b,0xDC,0x07,0x32,0xEF};
 
 static char hs_cmd_buffer[100];
+static hci_con_handle_t acl_handle = HCI_CON_HANDLE_INVALID;
 // prototypes
 static void show_usage(void);
 
@@ -109,39 +110,39 @@ static void stdin_process(char buffer){
             break;
         case 'a':
             printf("Establish audio connection\n");
-            hsp_ag_establish_audio_connection();
+            hsp_ag_establish_audio_connection(acl_handle);
             break;
         case 'd':
             printf("Releasing audio connection\n");
-            hsp_ag_disconnect();
+            hsp_ag_disconnect(acl_handle);
             break;
         case 'm':
             printf("Setting microphone gain 8\n");
-            hsp_ag_set_microphone_gain(8);
+            hsp_ag_set_microphone_gain(acl_handle, 8);
             break;
         case 'M':
             printf("Setting microphone gain 15\n");
-            hsp_ag_set_microphone_gain(15);
+            hsp_ag_set_microphone_gain(acl_handle, 15);
             break;
         case 'o':
             printf("Setting speaker gain 0\n");
-            hsp_ag_set_speaker_gain(0);
+            hsp_ag_set_speaker_gain(acl_handle, 0);
             break;
         case 's':
             printf("Setting speaker gain 8\n");
-            hsp_ag_set_speaker_gain(8);
+            hsp_ag_set_speaker_gain(acl_handle, 8);
             break;
         case 'S':
             printf("Setting speaker gain 15\n");
-            hsp_ag_set_speaker_gain(15);
+            hsp_ag_set_speaker_gain(acl_handle, 15);
             break;
         case 'r':
             printf("Start ringing\n");
-            hsp_ag_start_ringing();
+            hsp_ag_start_ringing(acl_handle);
             break;
         case 't':
             printf("Stop ringing\n");
-            hsp_ag_stop_ringing();
+            hsp_ag_stop_ringing(acl_handle);
             break;
         default:
             show_usage();
@@ -153,6 +154,11 @@ static void stdin_process(char buffer){
 // Audio Gateway routines 
 static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * event, uint16_t event_size){
     switch (event[2]) {
+        case HSP_SUBEVENT_RFCOMM_CONNECTION_COMPLETE:
+            if (hsp_subevent_rfcomm_connection_complete_get_status(event) == 0){
+                acl_handle = hsp_subevent_rfcomm_connection_complete_get_acl_handle(event);
+            }
+            break;
         case HSP_SUBEVENT_AUDIO_CONNECTION_COMPLETE:
             if (event[3] == 0){
                 printf("Audio connection established.\n\n");
@@ -175,8 +181,8 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t * even
             break;
         case HSP_SUBEVENT_HS_COMMAND:{
             memset(hs_cmd_buffer, 0, sizeof(hs_cmd_buffer));
-            int size = event[3] <= sizeof(hs_cmd_buffer)? event[3] : sizeof(hs_cmd_buffer); 
-            memcpy(hs_cmd_buffer, &event[4], size - 1);
+            int size = hsp_subevent_hs_command_get_value_length(event) <= sizeof(hs_cmd_buffer)? hsp_subevent_hs_command_get_value_length(event) : sizeof(hs_cmd_buffer); 
+            memcpy(hs_cmd_buffer, hsp_subevent_hs_command_get_value(event), size - 1);
             printf("Received custom command: \"%s\". \nExit code or call hsp_ag_send_result.\n", hs_cmd_buffer);
             break;
         }
@@ -0,0 +1,250 @@
+#!/usr/bin/env python
+# BlueKitchen GmbH (c) 2018
+
+# Create typed inline encoder for each HCI Command defined in src/hci_cmd.c
+# Output matches hci_cmd_create_from_template byte-for-byte
+
+import re
+import sys
+import os
+
+program_info = '''
+BTstack HCI Command Encoder Generator for BTstack
+Copyright 2018, BlueKitchen GmbH
+'''
+
+copyright = """/*
+ * Copyright (C) 2018 BlueKitchen GmbH
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor the names of
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ * 4. Any redistribution, use, or modification is done solely for
+ *    personal benefit and not for any commercial purpose or for
+ *    monetary gain.
+ *
+ * THIS SOFTWARE IS PROVIDED BY BLUEKITCHEN GMBH AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL MATTHIAS
+ * RINGWALD OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Please inquire about commercial licensing options at
+ * contact@bluekitchen-gmbh.com
+ *
+ */
+"""
+
+hfile_header_begin = """
+
+/*
+ *  hci_cmd_encoder.h
+ *
+ *  @brief Typed encoders for HCI Commands, same output as hci_cmd_create_from_template
+ *  @note  Don't edit - generated by tool/btstack_hci_cmd_encoder_generator.py
+ *
+ */
+
+#ifndef __HCI_CMD_ENCODER_H
+#define __HCI_CMD_ENCODER_H
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+#include "bluetooth.h"
+#include "btstack_util.h"
+#include <stdint.h>
+#include <string.h>
+
+/* API_START */
+
+"""
+
+hfile_header_end = """
+/* API_END */
+
+#if defined __cplusplus
+}
+#endif
+
+#endif // __HCI_CMD_ENCODER_H
+"""
+
+c_prototype = '''/**
+ * @brief Create {command_name} command in buffer
+ * @param buffer for HCI Command of at least {buffer_size} bytes
+{param_docs} * @return size of HCI Command
+ * @note: btstack_type {format}
+ */
+static inline uint16_t {fn_name}(uint8_t * buffer{params}){{
+{code}}}
+
+'''
+
+c_prototype_unsupported = '''/**
+ * @brief Create {command_name} command in buffer
+ * @note: btstack_type {format}
+ */
+// static inline uint16_t {fn_name}(uint8_t * buffer, ...){{
+//     not implemented yet
+// }}
+
+'''
+
+# fixed size of parameters
+param_sizes = { '1' : 1, '2' : 2, '3' : 3, '4' : 4, 'H' : 2, 'B' : 6, 'D' : 8, 'E' : 240, 'N' : 248, 'P' : 16, 'A' : 31, 'Q' : 32 }
+
+param_types = { '1' : 'uint8_t', '2' : 'uint16_t', '3' : 'uint32_t', '4' : 'uint32_t', 'H' : 'hci_con_handle_t', 'B' : 'const bd_addr_t',
+                'D' : 'const uint8_t *', 'E' : 'const uint8_t *', 'N' : 'const char *', 'P' : 'const uint8_t *', 'A' : 'const uint8_t *',
+                'Q' : 'const uint8_t *' }
+
+param_store = {
+    '1' : '    buffer[{offset}] = {name};\n',
+    '2' : '    little_endian_store_16(buffer, {offset}, {name});\n',
+    'H' : '    little_endian_store_16(buffer, {offset}, {name});\n',
+    '3' : '    buffer[{offset}] = {name};\n    buffer[{offset} + 1] = {name} >> 8;\n    buffer[{offset} + 2] = {name} >> 16;\n',
+    '4' : '    little_endian_store_32(buffer, {offset}, {name});\n',
+    'B' : '    reverse_bd_addr({name}, &buffer[{offset}]);\n',
+    'D' : '    memcpy(&buffer[{offset}], {name}, 8);\n',
+    'E' : '    memcpy(&buffer[{offset}], {name}, 240);\n',
+    'P' : '    memcpy(&buffer[{offset}], {name}, 16);\n',
+    'A' : '    memcpy(&buffer[{offset}], {name}, 31);\n',
+    'Q' : '    reverse_bytes({name}, &buffer[{offset}], 32);\n',
+    'N' : '''    {{
+        uint16_t {name}_len = strlen({name});
+        if ({name}_len > 248) {{
+            {name}_len = 248;
+        }}
+        memcpy(&buffer[{offset}], {name}, {name}_len);
+        memset(&buffer[{offset} + {name}_len], 0, 248 - {name}_len);
+    }}
+''',
+}
+
+# names used in generated functions and C/C++ keywords
+reserved_names = ['buffer', 'pos', 'int', 'char', 'default', 'case', 'switch', 'register',
+                  'class', 'delete', 'new', 'private', 'protected', 'public', 'template', 'this']
+
+def parse_commands(path):
+    commands = []
+    params = []
+    command_name = None
+    with open (path, 'rt') as fin:
+        for line in fin:
+            if re.match('\s*/\*\*', line):
+                params = []
+                continue
+
+            parts = re.match('.*@param\s*(\w+)', line)
+            if parts:
+                params.append(parts.groups()[0])
+                continue
+
+            declaration = re.match('const\s+hci_cmd_t\s+(\w+)[\s=]+', line)
+            if declaration:
+                command_name = declaration.groups()[0]
+                continue
+
+            definition = re.match('\s*OPCODE\(\s*(\w+)\s*,\s*(\w+)\s*\)\s*,\s*"(\w*)"', line)
+            if definition and command_name:
+                (ogf, ocf, format) = definition.groups()
+                commands.append((command_name, ogf, ocf, format, params))
+                params = []
+                command_name = None
+                continue
+    return commands
+
+def param_names_for_command(format, params):
+    if len(params) != len(format):
+        params = ['arg%u' % (i+1) for i in range(len(format))]
+    names = []
+    for name in params:
+        name = name.lower()
+        if name in reserved_names:
+            name = name + '_param'
+        if name in names:
+            name = name + '_%u' % (len(names) + 1)
+        names.append(name)
+    return names
+
+def fn_name_for_command(command_name):
+    if command_name.startswith('hci_'):
+        return 'hci_cmd_create_' + command_name[4:]
+    return 'hci_cmd_create_' + command_name
+
+def create_encoder(command_name, ogf, ocf, format, params):
+    fn_name = fn_name_for_command(command_name)
+    for f in format:
+        if f != 'J' and f not in param_sizes:
+            return c_prototype_unsupported.format(command_name=command_name, fn_name=fn_name, format=format)
+
+    names = param_names_for_command(format, params)
+    args = ''
+    param_docs = ''
+    code = '    little_endian_store_16(buffer, 0, {ocf} | ({ogf} << 10));\n'.format(ogf=ogf, ocf=ocf)
+    offset = 3
+    offset_is_number = True
+    buffer_size = 3
+    for f, name in zip(format, names):
+        if f == 'J':
+            args += ', uint8_t %s_len, const uint8_t * %s' % (name, name)
+            param_docs += ' * @param %s_len\n * @param %s\n' % (name, name)
+            if offset_is_number:
+                code += '    uint16_t pos = %u;\n' % offset
+                offset_is_number = False
+            code += '    buffer[pos++] = {name}_len;\n    memcpy(&buffer[pos], {name}, {name}_len);\n    pos += {name}_len;\n'.format(name=name)
+            buffer_size += 1 + 255
+            continue
+        args += ', %s %s' % (param_types[f], name)
+        param_docs += ' * @param %s\n' % name
+        if offset_is_number:
+            code += param_store[f].format(offset=offset, name=name)
+            offset += param_sizes[f]
+        else:
+            code += param_store[f].format(offset='pos', name=name)
+            code += '    pos += %u;\n' % param_sizes[f]
+        buffer_size += param_sizes[f]
+
+    if offset_is_number:
+        code += '    buffer[2] = %u;\n' % (offset - 3)
+        code += '    return %u;\n' % offset
+    else:
+        code += '    buffer[2] = pos - 3;\n'
+        code += '    return pos;\n'
+    return c_prototype.format(command_name=command_name, fn_name=fn_name, params=args, param_docs=param_docs,
+        buffer_size=buffer_size, code=code, format=format)
+
+def create_encoders(commands, gen_path):
+    with open(gen_path, 'wt') as fout:
+        fout.write(copyright)
+        fout.write(hfile_header_begin)
+        for (command_name, ogf, ocf, format, params) in commands:
+            fout.write(create_encoder(command_name, ogf, ocf, format, params))
+        fout.write(hfile_header_end)
+
+btstack_root = os.path.abspath(os.path.dirname(sys.argv[0]) + '/..')
+gen_path = btstack_root + '/src/hci_cmd_encoder.h'
+
+print(program_info)
+
+commands = parse_commands(btstack_root + '/src/hci_cmd.c')
+create_encoders(commands, gen_path)
+
+print('Done!')
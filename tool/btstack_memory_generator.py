@@ -55,6 +55,7 @@ extern "C" {
 #endif
 
 #include "btstack_config.h"
+#include "btstack_memory_pool.h"
     
 // Core
 #include "hci.h"
@@ -84,6 +85,12 @@ extern "C" {
  */
 void btstack_memory_init(void);
 
+/**
+ * @brief Log usage statistics of all memory pools: blocks in use, high-water mark and failed allocations.
+ * @note Use to size MAX_NR_* in btstack_config.h, see btstack_memory_*_get_stats for individual pools
+ */
+void btstack_memory_log_stats(void);
+
 /* API_END */
 """
 
@@ -107,13 +114,15 @@ cfile_header_begin = """
 
 #include "btstack_memory.h"
 #include "btstack_memory_pool.h"
+#include "btstack_debug.h"
 
 #include <stdlib.h>
 
 """
 
 header_template = """STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void);
-void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);"""
+void   btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME);
+void   btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats);"""
 
 code_template = """
 // MARK: STRUCT_TYPE
@@ -135,22 +144,37 @@ STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     btstack_memory_pool_free(&STRUCT_NAME_pool, STRUCT_NAME);
 }
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    btstack_memory_pool_get_stats(&STRUCT_NAME_pool, stats);
+}
 #else
+static btstack_memory_pool_stats_t STRUCT_NAME_stats;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
+    btstack_memory_pool_stats_track_get(&STRUCT_NAME_stats, NULL);
     return NULL;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
     // silence compiler warning about unused parameter in a portable way
     (void) STRUCT_NAME;
 };
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = STRUCT_NAME_stats;
+}
 #endif
 #elif defined(HAVE_MALLOC)
+static btstack_memory_pool_stats_t STRUCT_NAME_stats;
 STRUCT_NAME_t * btstack_memory_STRUCT_NAME_get(void){
-    return (STRUCT_NAME_t*) malloc(sizeof(STRUCT_TYPE));
+    STRUCT_NAME_t * STRUCT_NAME = (STRUCT_NAME_t*) malloc(sizeof(STRUCT_TYPE));
+    btstack_memory_pool_stats_track_get(&STRUCT_NAME_stats, STRUCT_NAME);
+    return STRUCT_NAME;
 }
 void btstack_memory_STRUCT_NAME_free(STRUCT_NAME_t *STRUCT_NAME){
+    btstack_memory_pool_stats_track_free(&STRUCT_NAME_stats, STRUCT_NAME);
     free(STRUCT_NAME);
 }
+void btstack_memory_STRUCT_NAME_get_stats(btstack_memory_pool_stats_t * stats){
+    *stats = STRUCT_NAME_stats;
+}
 #endif
 """
 
@@ -158,6 +182,9 @@ init_template = """#if POOL_COUNT > 0
     btstack_memory_pool_create(&STRUCT_NAME_pool, STRUCT_NAME_storage, POOL_COUNT, sizeof(STRUCT_TYPE));
 #endif"""
 
+log_stats_template = """    btstack_memory_STRUCT_NAME_get_stats(&stats);
+    log_info("STRUCT_NAME: used %u, max %u, failed %u", stats.num_used, stats.max_used, stats.num_failed);"""
+
 def writeln(f, data):
     f.write(data + "\n")
 
@@ -184,7 +211,7 @@ list_of_structs = [
     ["avrcp_connection"],
     ["avrcp_browsing_connection"]    
 ]
-list_of_le_structs = [["gatt_client", "whitelist_entry", "sm_lookup_entry"]]
+list_of_le_structs = [["gatt_client", "whitelist_entry", "sm_lookup_entry", "sm_setup_context"]]
 
 file_name = "../src/btstack_memory"
 
@@ -233,5 +260,19 @@ for struct_names in list_of_le_structs:
         writeln(f, replacePlaceholder(init_template, struct_name))
 writeln(f, "#endif")
 writeln(f, "}")
+
+writeln(f, "")
+writeln(f, "// stats")
+writeln(f, "void btstack_memory_log_stats(void){")
+writeln(f, "    btstack_memory_pool_stats_t stats;")
+for struct_names in list_of_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(log_stats_template, struct_name))
+writeln(f, "#ifdef ENABLE_BLE")
+for struct_names in list_of_le_structs:
+    for struct_name in struct_names:
+        writeln(f, replacePlaceholder(log_stats_template, struct_name))
+writeln(f, "#endif")
+writeln(f, "}")
 f.close();
     
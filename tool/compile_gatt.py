@@ -28,7 +28,10 @@ const uint8_t profile_data[] =
 '''
 
 usage = '''
-Usage: ./compile_gatt.py profile.gatt profile.h
+Usage: ./compile_gatt.py [--service-index-table] profile.gatt profile.h
+
+  --service-index-table  also create table with service index for each handle
+                         for use with att_server_set_service_index_table
 '''
 
 
@@ -113,6 +116,7 @@ current_service_start_handle = 0
 current_characteristic_uuid_string = ""
 defines_for_characteristics = []
 defines_for_services = []
+service_ranges = []
 
 handle = 1
 total_size = 0
@@ -300,6 +304,7 @@ def serviceDefinitionComplete(fout):
         defines_for_services.append('#define ATT_SERVICE_%s_START_HANDLE 0x%04x' % (current_service_uuid_string, current_service_start_handle))
         defines_for_services.append('#define ATT_SERVICE_%s_END_HANDLE 0x%04x' % (current_service_uuid_string, handle-1))
         services[current_service_uuid_string] = [current_service_start_handle, handle-1]
+        service_ranges.append([current_service_start_handle, handle-1])
 
 def dump_flags(fout, flags):
     global security_permsission
@@ -860,6 +865,34 @@ def listHandles(fout):
         fout.write(define)
         fout.write('\n')
 
+def listServiceIndexTable(fout):
+    if len(service_ranges) >= 0xff:
+        print('ERROR: too many services for service index table')
+        sys.exit(1)
+    service_index_for_handle = [0xff] * handle
+    for index, service_range in enumerate(service_ranges):
+        for service_handle in range(service_range[0], service_range[1] + 1):
+            service_index_for_handle[service_handle] = index
+    fout.write('\n')
+    fout.write('//\n')
+    fout.write('// service index for each attribute handle, 0xff = ATT_SERVICE_INDEX_NONE\n')
+    fout.write('// usage: static att_service_handler_t * handlers[ATT_SERVICE_INDEX_TABLE_NUM_SERVICES];\n')
+    fout.write('//        att_server_set_service_index_table(att_service_index_for_handle, sizeof(att_service_index_for_handle),\n')
+    fout.write('//                                           handlers, ATT_SERVICE_INDEX_TABLE_NUM_SERVICES);\n')
+    fout.write('//\n')
+    fout.write('#define ATT_SERVICE_INDEX_TABLE_NUM_SERVICES %u\n' % len(service_ranges))
+    fout.write('const uint8_t att_service_index_for_handle[] = {\n')
+    for line_start in range(0, len(service_index_for_handle), 16):
+        write_indent(fout)
+        for service_index in service_index_for_handle[line_start:line_start+16]:
+            write_8(fout, service_index)
+        fout.write('\n')
+    fout.write('};\n')
+
+service_index_table = '--service-index-table' in sys.argv
+if service_index_table:
+    sys.argv.remove('--service-index-table')
+
 if (len(sys.argv) < 3):
     print(usage)
     sys.exit(1)
@@ -874,6 +907,8 @@ try:
     fout = open (filename, 'w')
     parse(sys.argv[1], fin, filename, fout)
     listHandles(fout)    
+    if service_index_table:
+        listServiceIndexTable(fout)
     fout.close()
     print('Created %s' % filename)
 